@@ -92,6 +92,7 @@ void vtkSlicerBeamsModuleLogic::SetMRMLSceneInternal(vtkMRMLScene * newScene)
   events->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
   events->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
   events->InsertNextValue(vtkMRMLScene::EndImportEvent);
+  events->InsertNextValue(vtkMRMLScene::EndCloseEvent);
   this->SetAndObserveMRMLSceneEventsInternal(newScene, events.GetPointer());
 
   if (this->MLCPositionLogic)
@@ -166,6 +167,13 @@ void vtkSlicerBeamsModuleLogic::OnMRMLSceneEndImport()
   }
 }
 
+//---------------------------------------------------------------------------
+void vtkSlicerBeamsModuleLogic::OnMRMLSceneEndClose()
+{
+  // The shared MLC beam poly data templates belong to the beams of the closed scene
+  vtkMRMLRTBeamNode::ClearMLCPolyDataTemplates();
+}
+
 //---------------------------------------------------------------------------
 void vtkSlicerBeamsModuleLogic::UpdateTransformForBeam(vtkMRMLRTBeamNode* beamNode)
 {
@@ -71,6 +71,7 @@ protected:
 
   void OnMRMLSceneNodeAdded(vtkMRMLNode* node) override;
   void OnMRMLSceneEndImport() override;
+  void OnMRMLSceneEndClose() override;
 
   /// Handles events registered in the observer manager
   void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData) override;
@@ -79,6 +79,7 @@
 #include <vtkTransform.h>
 #include <vtkMatrix4x4.h>
 #include <vtkMath.h> // cross, dot vector operations
+#include <vtkSMPTools.h>
 
 // SlicerRtCommon includes
 #include <vtkSlicerRtCommon.h>
@@ -483,18 +484,62 @@ bool vtkSlicerMLCPositionLogic::CalculateMultiLeafCollimatorPosition( vtkMRMLTab
     leafPairEnd += 1;
   }
 
-  for ( int leafPairIndex = leafPairStart; leafPairIndex <= leafPairEnd; ++leafPairIndex)
+  const char* mlcName = mlcTableNode->GetName();
+  bool typeMLCY = !strncmp( "MLCY", mlcName, strlen("MLCY"));
+  bool typeMLCX = !strncmp( "MLCX", mlcName, strlen("MLCX"));
+  if (!typeMLCX && !typeMLCY)
+  {
+    vtkErrorMacro("CalculateMultiLeafCollimatorPosition: Unknown MLC type of table " << mlcName);
+    return false;
+  }
+
+  // Curve polygon in (leaf motion, leaf boundary) coordinates, shared by all leaf pairs
+  const auto controlPoints = curveNode->GetControlPoints();
+  std::vector< std::array< double, 2 > > curvePolygon;
+  curvePolygon.reserve(controlPoints->size());
+  for ( auto it = controlPoints->begin(); it != controlPoints->end(); ++it)
+  {
+    const double* position = (*it)->Position;
+    if (typeMLCX)
+    {
+      curvePolygon.push_back({ position[0], position[1] });
+    }
+    else
+    {
+      curvePolygon.push_back({ position[1], position[0] });
+    }
+  }
+
+  // Leaf pair boundaries of the range
+  int nofRangeLeafPairs = leafPairEnd - leafPairStart + 1;
+  std::vector<double> boundaries(nofRangeLeafPairs + 1);
+  for ( int i = 0; i <= nofRangeLeafPairs; ++i)
   {
-    double side1 = 0.0, side2 = 0.0;
-    size_t leafIndex = leafPairIndex;
+    boundaries[i] = mlcTable->GetValue( leafPairStart + i, 0).ToDouble();
+  }
 
-    if (mlcTable && FindLeafPairPositions( curveNode, mlcTableNode, leafIndex, side1, side2))
+  // Find positions of the leaf pairs in parallel
+  std::vector<double> sides1(nofRangeLeafPairs, 0.0), sides2(nofRangeLeafPairs, 0.0);
+  std::vector<char> found(nofRangeLeafPairs, 0);
+  vtkSMPTools::For( 0, nofRangeLeafPairs, [&](vtkIdType begin, vtkIdType end)
+  {
+    for ( vtkIdType i = begin; i < end; ++i)
+    {
+      found[i] = FindLeafPairPositions( curvePolygon, boundaries[i], boundaries[i + 1], 
+        sides1[i], sides2[i]) ? 1 : 0;
+    }
+  });
+
+  for ( int i = 0; i < nofRangeLeafPairs; ++i)
+  {
+    if (found[i])
     {
       // positions found
-      mlcTable->SetValue( leafIndex, 1, side1);
-      mlcTable->SetValue( leafIndex, 2, side2);
+      mlcTable->SetValue( leafPairStart + i, 1, sides1[i]);
+      mlcTable->SetValue( leafPairStart + i, 2, sides2[i]);
     }
   }
+  mlcTable->Modified();
 
   return true;
 }
@@ -626,119 +671,68 @@ void vtkSlicerMLCPositionLogic::FindLeafPairRangeIndexes(
 
 //---------------------------------------------------------------------------
 bool vtkSlicerMLCPositionLogic::FindLeafPairPositions( 
-  vtkMRMLMarkupsCurveNode* curveNode, vtkMRMLTableNode* mlcTableNode, 
-  size_t leafPairIndex, 
+  const std::vector< std::array< double, 2 > >& curvePolygon, 
+  double leafStart, double leafEnd, 
   double& side1, double& side2, 
-  int vtkNotUsed(strategy), 
-  double maxPositionDistance, 
-  double positionStep)
+  double maxPositionDistance)
 {
-  if (!mlcTableNode)
-  {
-    vtkErrorMacro("FindLeafPairPositions: MLC table node is invalid");
-    return false;
-  }
-
-  const char* mlcName = mlcTableNode->GetName();
-  bool typeMLCY = !strncmp( "MLCY", mlcName, strlen("MLCY"));
-  bool typeMLCX = !strncmp( "MLCX", mlcName, strlen("MLCX"));
-
-  vtkTable* mlcTable = mlcTableNode->GetTable();
-
-  double leafStart = mlcTable->GetValue( leafPairIndex, 0).ToDouble();
-  double leafEnd = mlcTable->GetValue( leafPairIndex + 1, 0).ToDouble();
-
-  vtkPolyData* curvePoly = curveNode->GetCurveWorld();
-  if (!curvePoly)
+  size_t nofPoints = curvePolygon.size();
+  if (nofPoints < 3)
   {
-    vtkErrorMacro("FindLeafPairPositions: Curve polydata is invalid");
     return false;
   }
 
-  // Build locator
-  vtkNew<vtkCellLocator> cellLocator;
-//  vtkNew<vtkModifiedBSPTree> cellLocator;
-  cellLocator->SetDataSet(curvePoly);
-  cellLocator->BuildLocator();
-
-  // intersection with side1
-  bool side1Flag = false;
-  double pStart[3] = { };
-  double pEnd[3] = { };
+  double bandBegin = std::min( leafStart, leafEnd);
+  double bandEnd = std::max( leafStart, leafEnd);
 
-  if (typeMLCX)
-  {
-   pStart[1] = leafStart;
-   pEnd[1] = leafEnd;
-  }
-  else if (typeMLCY)
+  // Clip every polygon edge to the leaf pair band, and take the extent of the clipped
+  // segments along the leaf motion direction
+  bool intersected = false;
+  double positionMin = VTK_DOUBLE_MAX;
+  double positionMax = VTK_DOUBLE_MIN;
+  for ( size_t i = 0; i < nofPoints; ++i)
   {
-   pStart[0] = leafStart;
-   pEnd[0] = leafEnd;
-  }
+    const std::array< double, 2 >& p0 = curvePolygon[i];
+    const std::array< double, 2 >& p1 = curvePolygon[(i + 1) % nofPoints];
 
-  int subId = -1;
-  double t = 0., xyz[3] = {}, pcoords[3] = {};
-  for ( double c = -1. * maxPositionDistance; c <= maxPositionDistance; c += positionStep)
-  {
-    if (typeMLCX)
+    double tMin = 0.0, tMax = 1.0;
+    double deltaBoundary = p1[1] - p0[1];
+    if (vtkSlicerRtCommon::AreEqualWithTolerance( deltaBoundary, 0.0))
     {
-      pStart[0] = c;
-      pEnd[0] = c;
-    }
-    else if (typeMLCY)
-    {
-      pStart[1] = c;
-      pEnd[1] = c;
-    }
-
-    if (cellLocator->IntersectWithLine( pStart, pEnd, 0.0001, t, xyz, pcoords, subId))
-    {
-      side1Flag = true;
-      // xyz values
-      if (typeMLCX)
+      // Edge is parallel to the leaves
+      if (p0[1] < bandBegin || p0[1] > bandEnd)
       {
-        side1 = xyz[0];
+        continue;
       }
-      else if (typeMLCY)
+    }
+    else
+    {
+      double tBegin = (bandBegin - p0[1]) / deltaBoundary;
+      double tEnd = (bandEnd - p0[1]) / deltaBoundary;
+      tMin = std::max( tMin, std::min( tBegin, tEnd));
+      tMax = std::min( tMax, std::max( tBegin, tEnd));
+      if (tMin > tMax)
       {
-        side1 = xyz[1];
+        continue;
       }
-      break;
     }
+
+    double deltaPosition = p1[0] - p0[0];
+    double position1 = p0[0] + tMin * deltaPosition;
+    double position2 = p0[0] + tMax * deltaPosition;
+    positionMin = std::min( positionMin, std::min( position1, position2));
+    positionMax = std::max( positionMax, std::max( position1, position2));
+    intersected = true;
   }
 
-  // intersection with side2
-  bool side2Flag = false;
-  for ( double c = maxPositionDistance; c >= -1. * maxPositionDistance; c -= positionStep)
+  if (!intersected || positionMax < -1. * maxPositionDistance || positionMin > maxPositionDistance)
   {
-    if (typeMLCX)
-    {
-      pStart[0] = c;
-      pEnd[0] = c;
-    }
-    else if (typeMLCY)
-    {
-      pStart[1] = c;
-      pEnd[1] = c;
-    }
-
-    if (cellLocator->IntersectWithLine( pStart, pEnd, 0.0001, t, xyz, pcoords, subId))
-    {
-      side2Flag = true;
-      // xyz values
-      if (typeMLCX)
-      {
-        side2 = xyz[0];
-      }
-      else if (typeMLCY)
-      {
-        side2 = xyz[1];
-      }
-      break;
-    }
+    return false;
   }
-  return (side1Flag && side2Flag);
+
+  side1 = std::max( positionMin, -1. * maxPositionDistance);
+  side2 = std::min( positionMax, maxPositionDistance);
+  return true;
 }
 
 //---------------------------------------------------------------------------
@@ -29,6 +29,10 @@
 // Slicer includes
 #include "vtkMRMLAbstractLogic.h"
 
+// STD includes
+#include <array>
+#include <vector>
+
 class vtkPolyData;
 class vtkMRMLMarkupsCurveNode;
 class vtkMRMLRTBeamNode;
@@ -147,20 +151,21 @@ private:
   void FindLeafPairRangeIndexes( vtkMRMLRTBeamNode* beamNode, vtkMRMLTableNode* mlcTableNode, 
     int& leafPairIndexFirst, int& leafPairIndexLast);
 
-  /// Find leaf pair position using convex hull curve data (first pass, fast and coarse)
-  /// @param convexHullCurveNode - convex hull curve
-  /// @param mlcTableNode is used only to get leaf pair boundary data
-  /// @param leafPairIndex - index of a leaf pair (starts from 0)
+  /// Find leaf pair position using convex hull curve data (first pass, fast and coarse).
+  /// The positions are the extent of the curve polygon within the band covered by the
+  /// leaf pair, computed analytically by clipping the polygon edges to the band.
+  /// Thread-safe, so that leaf pairs can be processed in parallel.
+  /// @param curvePolygon - points of the closed curve polygon as (leaf motion, leaf boundary)
+  ///   coordinates (x and y for MLCX, y and x for MLCY)
+  /// @param leafStart - leaf pair boundary begin
+  /// @param leafEnd - leaf pair boundary end
   /// @param side1 - leaf pair position on side 1
-  /// @param side2 - leaf pair position on side 1
-  /// @param strategy - position strategy (1 = out-of-field; 2 = in-field; 3 = cross-boundary; only out-of-field implemented)
+  /// @param side2 - leaf pair position on side 2
   /// @param maxPositionDistance - maximum position of the leaf pair
-  /// @param positionStep - position step of leaf pair
-  /// @return true if successfull, false otherwise
-  bool FindLeafPairPositions( vtkMRMLMarkupsCurveNode* convexHullCurveNode,
-    vtkMRMLTableNode* mlcTableNode, size_t leafPairIndex, 
-    double& side1, double& side2, int strategy = 1, 
-    double maxPositionDistance = 100., double positionStep = 0.01);
+  /// @return true if successfull, false if the curve does not cross the leaf pair band
+  static bool FindLeafPairPositions( const std::vector< std::array< double, 2 > >& curvePolygon,
+    double leafStart, double leafEnd, double& side1, double& side2,
+    double maxPositionDistance = 100.);
 
   /// Find leaf pair position using collision filter between leaf 
   /// rectangle projection and target polydata (second pass, slow and more precise)
@@ -44,7 +44,14 @@
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkTable.h>
 #include <vtkCellArray.h>
-#include <vtkAppendPolyData.h>
+#include <vtkDataArray.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <deque>
+#include <map>
+#include <mutex>
 
 //------------------------------------------------------------------------------
 const char* vtkMRMLRTBeamNode::NEW_BEAM_NODE_NAME_PREFIX = "NewBeam_";
@@ -55,6 +62,27 @@ static const char* MLC_BOUNDARY_POSITION_REFERENCE_ROLE = "MLCBoundaryAndPositio
 static const char* DRR_REFERENCE_ROLE = "DRRRef";
 static const char* CONTOUR_BEV_REFERENCE_ROLE = "contourBEVRef";
 
+//------------------------------------------------------------------------------
+namespace
+{
+/// Maximum number of shared MLC beam poly data templates
+const size_t MAXIMUM_NUMBER_OF_MLC_POLYDATA_TEMPLATES = 256;
+/// Beam poly data with MLC shared by all beam nodes, keyed by aperture, \sa GetMLCApertureKey
+std::map< std::vector<double>, vtkSmartPointer<vtkPolyData> > MLCPolyDataTemplates;
+/// Apertures of the shared templates in the order of creation, the oldest template is removed first
+std::deque< std::vector<double> > MLCPolyDataTemplateApertures;
+/// Mutex guarding the shared templates and their apertures
+std::mutex MLCPolyDataTemplatesMutex;
+
+//------------------------------------------------------------------------------
+/// MLC type is determined from the name of the MLC table node
+bool IsMLCX(vtkMRMLTableNode* mlcTableNode)
+{
+  const char* mlcName = mlcTableNode->GetName();
+  return (mlcName && !strncmp( "MLCX", mlcName, strlen("MLCX")));
+}
+}
+
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLRTBeamNode);
 
@@ -79,6 +107,9 @@ vtkMRMLRTBeamNode::vtkMRMLRTBeamNode()
   this->SourceToJawsDistanceX = 500.;
   this->SourceToJawsDistanceY = 500.;
   this->SourceToMultiLeafCollimatorDistance = 400.;
+
+  this->GeometryUpdatePending = false;
+  this->MLCBoundaryPositionCacheTime = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -420,6 +451,11 @@ bool vtkMRMLRTBeamNode::GetSourcePosition(double source[3])
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetX1Jaw(double x1Jaw)
 {
+  if (this->X1Jaw == x1Jaw)
+  {
+    return;
+  }
+
   this->X1Jaw = x1Jaw;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -428,6 +464,11 @@ void vtkMRMLRTBeamNode::SetX1Jaw(double x1Jaw)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetX2Jaw(double x2Jaw)
 {
+  if (this->X2Jaw == x2Jaw)
+  {
+    return;
+  }
+
   this->X2Jaw = x2Jaw;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -436,6 +477,11 @@ void vtkMRMLRTBeamNode::SetX2Jaw(double x2Jaw)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetY1Jaw(double y1Jaw)
 {
+  if (this->Y1Jaw == y1Jaw)
+  {
+    return;
+  }
+
   this->Y1Jaw = y1Jaw;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -444,6 +490,11 @@ void vtkMRMLRTBeamNode::SetY1Jaw(double y1Jaw)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetY2Jaw(double y2Jaw)
 {
+  if (this->Y2Jaw == y2Jaw)
+  {
+    return;
+  }
+
   this->Y2Jaw = y2Jaw;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -452,6 +503,11 @@ void vtkMRMLRTBeamNode::SetY2Jaw(double y2Jaw)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetSourceToJawsDistanceX(double distance)
 {
+  if (this->SourceToJawsDistanceX == distance)
+  {
+    return;
+  }
+
   this->SourceToJawsDistanceX = distance;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -460,6 +516,11 @@ void vtkMRMLRTBeamNode::SetSourceToJawsDistanceX(double distance)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetSourceToJawsDistanceY(double distance)
 {
+  if (this->SourceToJawsDistanceY == distance)
+  {
+    return;
+  }
+
   this->SourceToJawsDistanceY = distance;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -468,6 +529,11 @@ void vtkMRMLRTBeamNode::SetSourceToJawsDistanceY(double distance)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetSourceToMultiLeafCollimatorDistance(double distance)
 {
+  if (this->SourceToMultiLeafCollimatorDistance == distance)
+  {
+    return;
+  }
+
   this->SourceToMultiLeafCollimatorDistance = distance;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -476,6 +542,11 @@ void vtkMRMLRTBeamNode::SetSourceToMultiLeafCollimatorDistance(double distance)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetGantryAngle(double angle)
 {
+  if (this->GantryAngle == angle)
+  {
+    return;
+  }
+
   this->GantryAngle = angle;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamTransformModified);
@@ -484,6 +555,11 @@ void vtkMRMLRTBeamNode::SetGantryAngle(double angle)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetCollimatorAngle(double angle)
 {
+  if (this->CollimatorAngle == angle)
+  {
+    return;
+  }
+
   this->CollimatorAngle = angle;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamTransformModified);
@@ -492,6 +568,11 @@ void vtkMRMLRTBeamNode::SetCollimatorAngle(double angle)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetCouchAngle(double angle)
 {
+  if (this->CouchAngle == angle)
+  {
+    return;
+  }
+
   this->CouchAngle = angle;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamTransformModified);
@@ -500,6 +581,11 @@ void vtkMRMLRTBeamNode::SetCouchAngle(double angle)
 //----------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::SetSAD(double sad)
 {
+  if (this->SAD == sad)
+  {
+    return;
+  }
+
   this->SAD = sad;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -508,6 +594,14 @@ void vtkMRMLRTBeamNode::SetSAD(double sad)
 //---------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::UpdateGeometry()
 {
+  // Defer update if parameters are being set in a batch
+  if (this->GetDisableModifiedEvent())
+  {
+    this->GeometryUpdatePending = true;
+    return;
+  }
+  this->GeometryUpdatePending = false;
+
   // Make sure display node exists
   this->CreateDefaultDisplayNodes();
 
@@ -515,6 +609,29 @@ void vtkMRMLRTBeamNode::UpdateGeometry()
   this->CreateBeamPolyData();
 }
 
+//---------------------------------------------------------------------------
+int vtkMRMLRTBeamNode::InvokePendingModifiedEvent()
+{
+  // Pending custom events (such as BeamGeometryModified) are invoked here, which may
+  // already perform the geometry update through the observers
+  int modified = Superclass::InvokePendingModifiedEvent();
+
+  if (this->GeometryUpdatePending && !this->GetDisableModifiedEvent())
+  {
+    this->UpdateGeometry();
+  }
+
+  return modified;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLRTBeamNode::ClearMLCPolyDataTemplates()
+{
+  std::lock_guard<std::mutex> lock(MLCPolyDataTemplatesMutex);
+  MLCPolyDataTemplates.clear();
+  MLCPolyDataTemplateApertures.clear();
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=nullptr*/)
 {
@@ -528,213 +645,100 @@ void vtkMRMLRTBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=null
     return;
   }
 
-  vtkMRMLTableNode* mlcTableNode = this->GetMultiLeafCollimatorTableNode();
-
-  vtkIdType nofLeafPairs = 0;
-  if (mlcTableNode)
+  // Reuse the shared beam polydata if a beam with the same MLC aperture has already been created
+  std::vector<double> apertureKey;
+  if (this->GetMLCApertureKey(apertureKey))
   {
-    nofLeafPairs = mlcTableNode->GetNumberOfRows() - 1;
-    if (nofLeafPairs <= 0)
-    {
-      vtkWarningMacro("CreateBeamPolyData: Wrong number of leaf pairs in the MLC table node, " \
-        "beam model poly data will be created without MLC");
-      mlcTableNode = nullptr; // draw beam polydata without MLC
-      nofLeafPairs = 0;
-    }
-  }
-
-  // valid MLC node
-  if (nofLeafPairs > 0)
-  {
-    // MLC boundary and position data
-    if (mlcTableNode->GetNumberOfColumns() == 3)
-    {
-      vtkDebugMacro("CreateBeamPolyData: MLC table node is present, number of leaf pairs = " << nofLeafPairs);
-    }
-    else
+    std::lock_guard<std::mutex> lock(MLCPolyDataTemplatesMutex);
+    auto templateIt = MLCPolyDataTemplates.find(apertureKey);
+    if (templateIt != MLCPolyDataTemplates.end())
     {
-      vtkWarningMacro("CreateBeamPolyData: Wrong number of columns in the MLC table node, " \
-        "beam model poly data will be created without MLC");
-      mlcTableNode = nullptr; // draw beam polydata without MLC
+      beamModelPolyData->Initialize();
+      beamModelPolyData->ShallowCopy(templateIt->second);
+      vtkDebugMacro("CreateBeamPolyData: Beam \"" << this->GetName() << "\" with MLC data has been created from template");
+      return;
     }
   }
 
-  bool xOpened = !vtkSlicerRtCommon::AreEqualWithTolerance( this->X2Jaw, this->X1Jaw);
-  bool yOpened = !vtkSlicerRtCommon::AreEqualWithTolerance( this->Y2Jaw, this->Y1Jaw);
-
-  // Check that we have MLC with Jaws opening
-  bool polydataAppended = false;
-  if (mlcTableNode && xOpened && yOpened)
+  // Beam polydata with MLC, if MLC is present and jaws are opened
+  std::vector<MLCVisiblePointVector> sectionsPoints;
+  if (this->CreateMLCVisibleSectionsPoints(sectionsPoints))
   {
-    MLCBoundaryPositionVector mlc;
-
-    const char* mlcName = mlcTableNode->GetName();
-    bool typeMLCX = !strncmp( "MLCX", mlcName, strlen("MLCX")); // MLCX by default
-    bool typeMLCY = !strncmp( "MLCY", mlcName, strlen("MLCY"));
-    if (typeMLCY && !typeMLCX)
+    if (sectionsPoints.empty()) // no visible sections
     {
-      typeMLCX = false;
-    }
-
-    // copy MLC data for easier processing
-    for (vtkIdType leafPair = 0; leafPair < nofLeafPairs; leafPair++)
-    {
-      vtkTable* table = mlcTableNode->GetTable();
-      double boundBegin = table->GetValue( leafPair, 0).ToDouble();
-      double boundEnd = table->GetValue( leafPair + 1, 0).ToDouble();
-      double pos1 = table->GetValue( leafPair, 1).ToDouble();
-      double pos2 = table->GetValue( leafPair, 2).ToDouble();
-      
-      mlc.push_back({ boundBegin, boundEnd, pos1, pos2 });
+      vtkErrorMacro("CreateBeamPolyData: Unable to calculate MLC visible data");
+      return;
     }
 
-    auto firstLeafIterator = mlc.end();
-    auto lastLeafIterator = mlc.end();
-    double& jawBegin = this->Y1Jaw;
-    double& jawEnd = this->Y2Jaw;
-    if (typeMLCX) // MLCX
+    // Add all visible sections directly into the beam model poly data
+    vtkNew<vtkPoints> points;
+    vtkNew<vtkCellArray> cellArray;
+    for (const MLCVisiblePointVector& side12 : sectionsPoints)
     {
-      jawBegin = this->Y1Jaw;
-      jawEnd = this->Y2Jaw;
-    }
-    else // MLCY
-    {
-      jawBegin = this->X1Jaw;
-      jawEnd = this->X2Jaw;
-    }
+      // fill vtk points
+      vtkIdType sourceId = points->InsertNextPoint( 0, 0, this->SAD); // source
 
-    // find first and last opened leaves visible within jaws
-    // and fill sections vector for further processing
-    MLCSectionVector sections; // sections (first & last leaf iterator) of opened MLC
-    for (auto it = mlc.begin(); it != mlc.end(); ++it)
-    {
-      double& bound1 = (*it)[0]; // leaf pair boundary begin
-      double& bound2 = (*it)[1]; // leaf pair boundary end
-      double& pos1 = (*it)[2]; // leaf position "1"
-      double& pos2 = (*it)[3]; // leaf position "2"
-      // if leaf pair is outside the jaws, then it is closed
-      bool mlcOpened = (bound2 < jawBegin || bound1 > jawEnd) ? false : !vtkSlicerRtCommon::AreEqualWithTolerance( pos1, pos2);
-      bool withinJaw = false;
-      if (typeMLCX) // MLCX
-      {
-        withinJaw = ((pos1 < this->X1Jaw && pos2 >= this->X1Jaw && pos2 <= this->X2Jaw) || 
-          (pos1 >= this->X1Jaw && pos1 <= this->X2Jaw && pos2 > this->X2Jaw) || 
-          (pos1 <= this->X1Jaw && pos2 >= this->X2Jaw) || 
-          (pos1 >= this->X1Jaw && pos1 <= this->X2Jaw && 
-            pos2 >= this->X1Jaw && pos2 <= this->X2Jaw));
-      }
-      else // MLCY
+      // side "1" and "2" points vector
+      vtkIdType pointIds = 0;
+      for (const MLCVisiblePointVector::value_type& point : side12)
       {
-        withinJaw = ((pos1 < this->Y1Jaw && pos2 >= this->Y1Jaw && pos2 <= this->Y2Jaw) || 
-          (pos1 >= this->Y1Jaw && pos1 <= this->Y2Jaw && pos2 > this->Y2Jaw) || 
-          (pos1 <= this->Y1Jaw && pos2 >= this->Y2Jaw) || 
-          (pos1 >= this->Y1Jaw && pos1 <= this->Y2Jaw && 
-            pos2 >= this->Y1Jaw && pos2 <= this->Y2Jaw));
+        const double& x = point.first;
+        const double& y = point.second;
+        points->InsertNextPoint( 2. * x, 2. * y, -this->SAD);
+        pointIds++;
       }
 
-      if (withinJaw && mlcOpened && firstLeafIterator == mlc.end())
+      // fill cell array for side "1" and "2"
+      for (vtkIdType i = 1; i < pointIds; ++i)
       {
-        firstLeafIterator = it;
-      }
-      if (withinJaw && mlcOpened && firstLeafIterator != mlc.end())
-      {
-        lastLeafIterator = it;
-      }
-      // check if next leaf pair is not the last
-      if (it != mlc.end() - 1)
-      {
-        auto next_it = it + 1;
-        double& next_pos1 = (*next_it)[2]; // position "1" of the next leaf
-        double& next_pos2 = (*next_it)[3]; // position "2" of the next leaf
-        // if there is no open space between neighbors => start new section
-        if (mlcOpened && (next_pos1 > pos2 || next_pos2 < pos1))
-        {
-          mlcOpened = false;
-        }
+        cellArray->InsertNextCell(3);
+        cellArray->InsertCellPoint(sourceId);
+        cellArray->InsertCellPoint(sourceId + i);
+        cellArray->InsertCellPoint(sourceId + i + 1);
       }
-      if (firstLeafIterator != mlc.end() && lastLeafIterator != mlc.end() && !mlcOpened)
+
+      // fill cell connection between side "2" -> side "1"
+      cellArray->InsertNextCell(3);
+      cellArray->InsertCellPoint(sourceId);
+      cellArray->InsertCellPoint(sourceId + 1);
+      cellArray->InsertCellPoint(sourceId + pointIds);
+
+      // Add the cap to the bottom
+      cellArray->InsertNextCell(pointIds);
+      for (vtkIdType i = 1; i <= pointIds; i++)
       {
-        sections.push_back({ firstLeafIterator, lastLeafIterator});
-        firstLeafIterator = mlc.end();
-        lastLeafIterator = mlc.end();
+        cellArray->InsertCellPoint(sourceId + i);
       }
     }
 
-    if (!sections.size()) // no visible sections
-    {
-      vtkErrorMacro("CreateBeamPolyData: Unable to calculate MLC visible data");
-      return;
-    }
+    beamModelPolyData->Initialize();
+    beamModelPolyData->SetPoints(points);
+    beamModelPolyData->SetPolys(cellArray);
+    vtkDebugMacro("CreateBeamPolyData: Beam \"" << this->GetName() << "\" with MLC data has been created!");
 
-    // append one or more visible sections to beam model poly data
-    vtkNew<vtkAppendPolyData> append;
-    for (const MLCSectionVector::value_type& section : sections)
+    // Store the beam polydata as template for the beams with the same aperture.
+    // Beam polydata is always replaced and never modified in place, so the points and cells can be shared
+    if (!apertureKey.empty())
     {
-      if (section.first != mlc.end() && section.second != mlc.end())
+      std::lock_guard<std::mutex> lock(MLCPolyDataTemplatesMutex);
+      if (MLCPolyDataTemplates.count(apertureKey))
       {
-        vtkNew<vtkPolyData> beamPolyData;
-        vtkNew<vtkPoints> points;
-        vtkNew<vtkCellArray> cellArray;
-
-        MLCVisiblePointVector side12; // real points for side "1" and "2"
-        CreateMLCPointsFromSectionBorder( jawBegin, jawEnd, typeMLCX, section, side12);
-
-        // fill vtk points
-        points->InsertPoint( 0, 0, 0, this->SAD); // source
-
-        // side "1" and "2" points vector
-        vtkIdType pointIds = 0;
-        for (const MLCVisiblePointVector::value_type& point : side12)
-        {
-          const double& x = point.first;
-          const double& y = point.second;
-          points->InsertPoint( pointIds + 1, 2. * x, 2. * y, -this->SAD);
-          pointIds++;
-        }
-        side12.clear(); // doesn't need anymore
-
-        // fill cell array for side "1" and "2"
-        for (vtkIdType i = 1; i < pointIds; ++i)
-        {
-          cellArray->InsertNextCell(3);
-          cellArray->InsertCellPoint(0);
-          cellArray->InsertCellPoint(i);
-          cellArray->InsertCellPoint(i + 1);
-        }
-
-        // fill cell connection between side "2" -> side "1"
-        cellArray->InsertNextCell(3);
-        cellArray->InsertCellPoint(0);
-        cellArray->InsertCellPoint(1);
-        cellArray->InsertCellPoint(pointIds);
-
-        // Add the cap to the bottom
-        cellArray->InsertNextCell(pointIds);
-        for (vtkIdType i = 1; i <= pointIds; i++)
-        {
-          cellArray->InsertCellPoint(i);
-        }
-
-        beamPolyData->SetPoints(points);
-        beamPolyData->SetPolys(cellArray);
-
-        // append section to form final polydata
-        append->AddInputData(beamPolyData);
-        polydataAppended = true;
+        // Template has been stored by another thread meanwhile
+        return;
       }
+      if (MLCPolyDataTemplateApertures.size() >= MAXIMUM_NUMBER_OF_MLC_POLYDATA_TEMPLATES)
+      {
+        MLCPolyDataTemplates.erase(MLCPolyDataTemplateApertures.front());
+        MLCPolyDataTemplateApertures.pop_front();
+      }
+      vtkSmartPointer<vtkPolyData> polyDataTemplate = vtkSmartPointer<vtkPolyData>::New();
+      polyDataTemplate->ShallowCopy(beamModelPolyData);
+      MLCPolyDataTemplates[apertureKey] = polyDataTemplate;
+      MLCPolyDataTemplateApertures.push_back(apertureKey);
     }
-    if (polydataAppended)
-    {
-      append->Update();
-      beamModelPolyData->DeepCopy(append->GetOutput());
-    }
-  }
-  if (polydataAppended)
-  {
-    vtkDebugMacro("CreateBeamPolyData: Beam \"" << this->GetName() << "\" with MLC data has been created!");
     return;
   }
- 
+
   // Default beam polydata (no MLC)
   vtkNew<vtkPoints> points;
   vtkNew<vtkCellArray> cellArray;
@@ -776,6 +780,199 @@ void vtkMRMLRTBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=null
   beamModelPolyData->SetPolys(cellArray);
 }
 
+//---------------------------------------------------------------------------
+const vtkMRMLRTBeamNode::MLCBoundaryPositionVector& vtkMRMLRTBeamNode::GetMLCBoundaryPositionData(vtkMRMLTableNode* mlcTableNode)
+{
+  vtkTable* table = (mlcTableNode ? mlcTableNode->GetTable() : nullptr);
+  if (!table)
+  {
+    this->MLCBoundaryPositionCache.clear();
+    this->MLCBoundaryPositionCacheTable = nullptr;
+    return this->MLCBoundaryPositionCache;
+  }
+
+  // Return cached data if the table has not changed since it was parsed
+  // Note: Row data modified time includes the modified time of the columns
+  vtkMTimeType tableTime = std::max( std::max(mlcTableNode->GetMTime(), table->GetMTime()),
+    table->GetRowData()->GetMTime() );
+  if (this->MLCBoundaryPositionCacheTable == table && this->MLCBoundaryPositionCacheTime == tableTime)
+  {
+    return this->MLCBoundaryPositionCache;
+  }
+
+  this->MLCBoundaryPositionCache.clear();
+  this->MLCBoundaryPositionCacheTable = table;
+  this->MLCBoundaryPositionCacheTime = tableTime;
+
+  vtkIdType nofLeafPairs = table->GetNumberOfRows() - 1;
+  if (nofLeafPairs <= 0)
+  {
+    vtkWarningMacro("GetMLCBoundaryPositionData: Wrong number of leaf pairs in the MLC table node, " \
+      "beam model poly data will be created without MLC");
+    return this->MLCBoundaryPositionCache;
+  }
+  if (table->GetNumberOfColumns() != 3)
+  {
+    vtkWarningMacro("GetMLCBoundaryPositionData: Wrong number of columns in the MLC table node, " \
+      "beam model poly data will be created without MLC");
+    return this->MLCBoundaryPositionCache;
+  }
+  vtkDebugMacro("GetMLCBoundaryPositionData: MLC table node is present, number of leaf pairs = " << nofLeafPairs);
+
+  // copy MLC data for easier processing
+  // Numeric columns are accessed directly, variant access is only used for other (e.g. string) columns
+  vtkDataArray* boundaryArray = vtkDataArray::SafeDownCast(table->GetColumn(0));
+  vtkDataArray* pos1Array = vtkDataArray::SafeDownCast(table->GetColumn(1));
+  vtkDataArray* pos2Array = vtkDataArray::SafeDownCast(table->GetColumn(2));
+  bool numericColumns = (boundaryArray && pos1Array && pos2Array);
+
+  this->MLCBoundaryPositionCache.reserve(nofLeafPairs);
+  for (vtkIdType leafPair = 0; leafPair < nofLeafPairs; leafPair++)
+  {
+    if (numericColumns)
+    {
+      this->MLCBoundaryPositionCache.push_back({ boundaryArray->GetComponent( leafPair, 0), 
+        boundaryArray->GetComponent( leafPair + 1, 0), pos1Array->GetComponent( leafPair, 0), 
+        pos2Array->GetComponent( leafPair, 0) });
+    }
+    else
+    {
+      this->MLCBoundaryPositionCache.push_back({ table->GetValue( leafPair, 0).ToDouble(), 
+        table->GetValue( leafPair + 1, 0).ToDouble(), table->GetValue( leafPair, 1).ToDouble(), 
+        table->GetValue( leafPair, 2).ToDouble() });
+    }
+  }
+
+  return this->MLCBoundaryPositionCache;
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLRTBeamNode::GetMLCApertureKey(std::vector<double>& apertureKey)
+{
+  apertureKey.clear();
+
+  vtkMRMLTableNode* mlcTableNode = this->GetMultiLeafCollimatorTableNode();
+  if (!mlcTableNode)
+  {
+    return false;
+  }
+  const MLCBoundaryPositionVector& mlc = this->GetMLCBoundaryPositionData(mlcTableNode);
+  if (mlc.empty())
+  {
+    return false;
+  }
+
+  apertureKey = { this->SAD, this->X1Jaw, this->X2Jaw, this->Y1Jaw, this->Y2Jaw, IsMLCX(mlcTableNode) ? 1.0 : 0.0 };
+  apertureKey.reserve(apertureKey.size() + 4 * mlc.size());
+  for (const MLCBoundaryPositionVector::value_type& leafPair : mlc)
+  {
+    apertureKey.insert( apertureKey.end(), leafPair.begin(), leafPair.end());
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLRTBeamNode::CreateMLCVisibleSectionsPoints(std::vector<MLCVisiblePointVector>& sectionsPoints)
+{
+  sectionsPoints.clear();
+
+  vtkMRMLTableNode* mlcTableNode = this->GetMultiLeafCollimatorTableNode();
+  if (!mlcTableNode)
+  {
+    return false;
+  }
+
+  const MLCBoundaryPositionVector& mlc = this->GetMLCBoundaryPositionData(mlcTableNode);
+  if (mlc.empty())
+  {
+    return false; // draw beam polydata without MLC
+  }
+
+  bool xOpened = !vtkSlicerRtCommon::AreEqualWithTolerance( this->X2Jaw, this->X1Jaw);
+  bool yOpened = !vtkSlicerRtCommon::AreEqualWithTolerance( this->Y2Jaw, this->Y1Jaw);
+  if (!xOpened || !yOpened)
+  {
+    return false;
+  }
+
+  bool typeMLCX = IsMLCX(mlcTableNode);
+
+  auto firstLeafIterator = mlc.end();
+  auto lastLeafIterator = mlc.end();
+  double jawBegin = (typeMLCX) ? this->Y1Jaw : this->X1Jaw;
+  double jawEnd = (typeMLCX) ? this->Y2Jaw : this->X2Jaw;
+
+  // find first and last opened leaves visible within jaws
+  // and fill sections vector for further processing
+  MLCSectionVector sections; // sections (first & last leaf iterator) of opened MLC
+  for (auto it = mlc.begin(); it != mlc.end(); ++it)
+  {
+    const double& bound1 = (*it)[0]; // leaf pair boundary begin
+    const double& bound2 = (*it)[1]; // leaf pair boundary end
+    const double& pos1 = (*it)[2]; // leaf position "1"
+    const double& pos2 = (*it)[3]; // leaf position "2"
+    // if leaf pair is outside the jaws, then it is closed
+    bool mlcOpened = (bound2 < jawBegin || bound1 > jawEnd) ? false : !vtkSlicerRtCommon::AreEqualWithTolerance( pos1, pos2);
+    bool withinJaw = false;
+    if (typeMLCX) // MLCX
+    {
+      withinJaw = ((pos1 < this->X1Jaw && pos2 >= this->X1Jaw && pos2 <= this->X2Jaw) || 
+        (pos1 >= this->X1Jaw && pos1 <= this->X2Jaw && pos2 > this->X2Jaw) || 
+        (pos1 <= this->X1Jaw && pos2 >= this->X2Jaw) || 
+        (pos1 >= this->X1Jaw && pos1 <= this->X2Jaw && 
+          pos2 >= this->X1Jaw && pos2 <= this->X2Jaw));
+    }
+    else // MLCY
+    {
+      withinJaw = ((pos1 < this->Y1Jaw && pos2 >= this->Y1Jaw && pos2 <= this->Y2Jaw) || 
+        (pos1 >= this->Y1Jaw && pos1 <= this->Y2Jaw && pos2 > this->Y2Jaw) || 
+        (pos1 <= this->Y1Jaw && pos2 >= this->Y2Jaw) || 
+        (pos1 >= this->Y1Jaw && pos1 <= this->Y2Jaw && 
+          pos2 >= this->Y1Jaw && pos2 <= this->Y2Jaw));
+    }
+
+    if (withinJaw && mlcOpened && firstLeafIterator == mlc.end())
+    {
+      firstLeafIterator = it;
+    }
+    if (withinJaw && mlcOpened && firstLeafIterator != mlc.end())
+    {
+      lastLeafIterator = it;
+    }
+    // check if next leaf pair is not the last
+    if (it != mlc.end() - 1)
+    {
+      auto next_it = it + 1;
+      const double& next_pos1 = (*next_it)[2]; // position "1" of the next leaf
+      const double& next_pos2 = (*next_it)[3]; // position "2" of the next leaf
+      // if there is no open space between neighbors => start new section
+      if (mlcOpened && (next_pos1 > pos2 || next_pos2 < pos1))
+      {
+        mlcOpened = false;
+      }
+    }
+    if (firstLeafIterator != mlc.end() && lastLeafIterator != mlc.end() && !mlcOpened)
+    {
+      sections.push_back({ firstLeafIterator, lastLeafIterator});
+      firstLeafIterator = mlc.end();
+      lastLeafIterator = mlc.end();
+    }
+  }
+
+  // real points for side "1" and "2" of each visible section
+  for (const MLCSectionVector::value_type& section : sections)
+  {
+    if (section.first != mlc.end() && section.second != mlc.end())
+    {
+      MLCVisiblePointVector side12;
+      this->CreateMLCPointsFromSectionBorder( jawBegin, jawEnd, typeMLCX, section, side12);
+      sectionsPoints.push_back(side12);
+    }
+  }
+
+  return true;
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLRTBeamNode::RequestCloning()
 {
@@ -795,16 +992,16 @@ void vtkMRMLRTBeamNode::CreateMLCPointsFromSectionBorder( double jawBegin,
 {
   MLCVisiblePointVector side1, side2; // temporary vectors to save visible points
 
-  MLCBoundaryPositionVector::iterator firstLeafIterator = sectionBorder.first;
-  MLCBoundaryPositionVector::iterator lastLeafIterator = sectionBorder.second;
-  MLCBoundaryPositionVector::iterator firstLeafIteratorJaws = firstLeafIterator;
-  MLCBoundaryPositionVector::iterator lastLeafIteratorJaws = lastLeafIterator;
+  MLCBoundaryPositionVector::const_iterator firstLeafIterator = sectionBorder.first;
+  MLCBoundaryPositionVector::const_iterator lastLeafIterator = sectionBorder.second;
+  MLCBoundaryPositionVector::const_iterator firstLeafIteratorJaws = firstLeafIterator;
+  MLCBoundaryPositionVector::const_iterator lastLeafIteratorJaws = lastLeafIterator;
 
   // find first and last visible leaves using Jaws data
   for (auto it = firstLeafIterator; it <= lastLeafIterator; ++it)
   {
-    double& bound1 = (*it)[0]; // leaf begin boundary
-    double& bound2 = (*it)[1]; // leaf end boundary
+    const double& bound1 = (*it)[0]; // leaf begin boundary
+    const double& bound2 = (*it)[1]; // leaf end boundary
     if (bound1 <= jawBegin && bound2 > jawBegin)
     {
       firstLeafIteratorJaws = it;
@@ -829,10 +1026,10 @@ void vtkMRMLRTBeamNode::CreateMLCPointsFromSectionBorder( double jawBegin,
   // into side1 and side2 points vectors
   for (auto it = firstLeafIterator; it <= lastLeafIterator; ++it)
   {
-    double& bound1 = (*it)[0]; // leaf begin boundary
-    double& bound2 = (*it)[1]; // leaf end boundary
-    double& pos1 = (*it)[2]; // leaf position "1"
-    double& pos2 = (*it)[3]; // leaf position "2"
+    const double& bound1 = (*it)[0]; // leaf begin boundary
+    const double& bound2 = (*it)[1]; // leaf end boundary
+    const double& pos1 = (*it)[2]; // leaf position "1"
+    const double& pos2 = (*it)[3]; // leaf position "2"
     if (typeMLCX) // MLCX
     {
       side1.push_back({ std::max( pos1, this->X1Jaw), bound1});
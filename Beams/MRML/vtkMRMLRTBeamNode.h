@@ -28,7 +28,11 @@
 // MRML includes
 #include <vtkMRMLModelNode.h>
 
+// VTK includes
+#include <vtkWeakPointer.h>
+
 class vtkPolyData;
+class vtkTable;
 class vtkMRMLScene;
 class vtkMRMLTableNode;
 class vtkMRMLRTPlanNode;
@@ -96,9 +100,19 @@ public:
   /// This method is used only in vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadDynamicBeamSequence
   virtual vtkMRMLLinearTransformNode* CreateBeamTransformNode(vtkMRMLScene *externalScene);
 
-  /// Update beam poly data based on beam geometry parameters (jaws, MLC)
+  /// Update beam poly data based on beam geometry parameters (jaws, MLC).
+  /// If modified events are disabled (i.e. within a StartModify/EndModify block), then the update
+  /// is only flagged and performed once when the pending modified events are invoked. This way
+  /// setting many beam parameters in a batch rebuilds the beam model only once.
   void UpdateGeometry();
 
+  /// Invoke pending modified events, and perform deferred geometry update if any
+  int InvokePendingModifiedEvent() override;
+
+  /// Remove the shared beam poly data templates of the MLC apertures, \sa GetMLCApertureKey.
+  /// Called when the scene is closed, so that the templates do not outlive the beams they were built for
+  static void ClearMLCPolyDataTemplates();
+
   /// Invoke cloning requested event. External Beam Planning logic processes the event and
   /// clones the beam if exists
   void RequestCloning();
@@ -254,7 +268,7 @@ protected:
   /// Multi-leaf collimator boundary position parameters 
   typedef std::vector< std::array< double, 4 > > MLCBoundaryPositionVector;
   /// Start and stop border of multi-leaf collimator opened section
-  typedef std::vector< std::pair< MLCBoundaryPositionVector::iterator, MLCBoundaryPositionVector::iterator > > MLCSectionVector;
+  typedef std::vector< std::pair< MLCBoundaryPositionVector::const_iterator, MLCBoundaryPositionVector::const_iterator > > MLCSectionVector;
 
   /// \brief Create visible points of MLC enclosure (perimeter) 
   ///  in IEC BEAM LIMITING DEVICE coordinate axis (isocenter plane)
@@ -262,7 +276,40 @@ protected:
     bool mlcType, const MLCSectionVector::value_type& sectionBorder, 
     MLCVisiblePointVector& side12);
 
+  /// \brief Create visible points of all opened MLC sections within the jaws
+  ///  in IEC BEAM LIMITING DEVICE coordinate axis (isocenter plane).
+  /// Used by both photon and ion beams to build the beam model.
+  /// \param sectionsPoints Output enclosure points, one vector for each opened section
+  /// \return False if there is no valid MLC table or the jaws are closed (MLC is not to be drawn),
+  ///   true otherwise. If true and sectionsPoints is empty, then there is no visible MLC section
+  bool CreateMLCVisibleSectionsPoints(std::vector<MLCVisiblePointVector>& sectionsPoints);
+
+  /// Get MLC boundary and position data from the MLC table node.
+  /// The table is only parsed again if it has been replaced or modified since the last call,
+  /// so that repeated geometry updates (e.g. when setting jaws) do not re-read the leaf data.
+  /// \return Cached MLC data. Empty if the MLC table is missing or invalid
+  const MLCBoundaryPositionVector& GetMLCBoundaryPositionData(vtkMRMLTableNode* mlcTableNode);
+
+  /// Get the parameters that determine the beam poly data with MLC: SAD, jaw positions, MLC type and leaf data.
+  /// Beam poly data created with MLC is stored as a template shared by all beam nodes with the same aperture
+  /// (e.g. the control points of a dynamic beam, or the proxy beam node of a sequence when browsing back),
+  /// so that the MLC outline is only built once for each aperture. The templates are guarded by a mutex,
+  /// as beam geometry may be updated from the threads of the dose engines.
+  /// \return False if there is no valid MLC table, in which case the beam poly data is not shared
+  bool GetMLCApertureKey(std::vector<double>& apertureKey);
+
   static bool AreEqual( double v1, double v2);
+
+protected:
+  /// Flag indicating that geometry update has been requested while modified events were disabled
+  bool GeometryUpdatePending;
+
+  /// Cached MLC boundary and position data, \sa GetMLCBoundaryPositionData
+  MLCBoundaryPositionVector MLCBoundaryPositionCache;
+  /// Table the MLC data cache was created from
+  vtkWeakPointer<vtkTable> MLCBoundaryPositionCacheTable;
+  /// Modified time of the table when the MLC data cache was created
+  vtkMTimeType MLCBoundaryPositionCacheTime;
 };
 
 #endif // __vtkMRMLRTBeamNode_h
@@ -45,7 +45,6 @@
 #include <vtkDoubleArray.h>
 #include <vtkTable.h>
 #include <vtkCellArray.h>
-#include <vtkAppendPolyData.h>
 
 //------------------------------------------------------------------------------
 namespace
@@ -277,6 +276,11 @@ vtkMRMLLinearTransformNode* vtkMRMLRTIonBeamNode::CreateBeamTransformNode(vtkMRM
 //----------------------------------------------------------------------------
 void vtkMRMLRTIonBeamNode::SetVSAD( double xComponent, double yComponent)
 {
+  if (this->VSADx == xComponent && this->VSADy == yComponent)
+  {
+    return;
+  }
+
   this->VSADx = xComponent;
   this->VSADy = yComponent;
   this->Modified();
@@ -316,6 +320,11 @@ void vtkMRMLRTIonBeamNode::SetScanningSpotSize(const std::array< float, 2 >& siz
 //----------------------------------------------------------------------------
 void vtkMRMLRTIonBeamNode::SetIsocenterToJawsDistanceX(double distance)
 {
+  if (this->IsocenterToJawsDistanceX == distance)
+  {
+    return;
+  }
+
   this->IsocenterToJawsDistanceX = distance;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -324,6 +333,11 @@ void vtkMRMLRTIonBeamNode::SetIsocenterToJawsDistanceX(double distance)
 //----------------------------------------------------------------------------
 void vtkMRMLRTIonBeamNode::SetIsocenterToJawsDistanceY(double distance)
 {
+  if (this->IsocenterToJawsDistanceY == distance)
+  {
+    return;
+  }
+
   this->IsocenterToJawsDistanceY = distance;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -332,6 +346,11 @@ void vtkMRMLRTIonBeamNode::SetIsocenterToJawsDistanceY(double distance)
 //----------------------------------------------------------------------------
 void vtkMRMLRTIonBeamNode::SetIsocenterToRangeShifterDistance(double distance)
 {
+  if (this->IsocenterToRangeShifterDistance == distance)
+  {
+    return;
+  }
+
   this->IsocenterToRangeShifterDistance = distance;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -340,6 +359,11 @@ void vtkMRMLRTIonBeamNode::SetIsocenterToRangeShifterDistance(double distance)
 //----------------------------------------------------------------------------
 void vtkMRMLRTIonBeamNode::SetIsocenterToMultiLeafCollimatorDistance(double distance)
 {
+  if (this->IsocenterToMultiLeafCollimatorDistance == distance)
+  {
+    return;
+  }
+
   this->IsocenterToMultiLeafCollimatorDistance = distance;
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLRTBeamNode::BeamGeometryModified);
@@ -374,40 +398,6 @@ void vtkMRMLRTIonBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=n
       << "\"" << this->GetName() << "\"");
   }
 
-  vtkMRMLTableNode* mlcTableNode = this->GetMultiLeafCollimatorTableNode();
-
-  vtkIdType nofLeafPairs = 0;
-  if (mlcTableNode)
-  {
-    nofLeafPairs = mlcTableNode->GetNumberOfRows() - 1;
-    if (nofLeafPairs <= 0)
-    {
-      vtkWarningMacro("CreateBeamPolyData: Wrong number of leaf pairs in the MLC table node, " \
-        "beam model poly data will be created without MLC");
-      mlcTableNode = nullptr; // draw beam polydata without MLC
-      nofLeafPairs = 0;
-    }
-  }
-
-  // valid MLC node
-  if (nofLeafPairs > 0)
-  {
-    // MLC boundary and position data
-    if (mlcTableNode->GetNumberOfColumns() == 3)
-    {
-      vtkDebugMacro("CreateBeamPolyData: MLC table node is present, number of leaf pairs = " << nofLeafPairs);
-    }
-    else
-    {
-      vtkWarningMacro("CreateBeamPolyData: Wrong number of columns in the MLC table node, " \
-        "beam model poly data will be created without MLC");
-      mlcTableNode = nullptr; // draw beam polydata without MLC
-    }
-  }
-
-  bool xOpened = !vtkSlicerRtCommon::AreEqualWithTolerance( this->X2Jaw, this->X1Jaw);
-  bool yOpened = !vtkSlicerRtCommon::AreEqualWithTolerance( this->Y2Jaw, this->Y1Jaw);
-
   // Scanning spot beam
   if (scanSpotTableNode)
   {
@@ -503,198 +493,80 @@ void vtkMRMLRTIonBeamNode::CreateBeamPolyData(vtkPolyData* beamModelPolyData/*=n
     beamModelPolyData->SetPolys(cellArray);
     return;
   }
-  else if (mlcTableNode && xOpened && yOpened) // MLC with opened Jaws
-  {
-    bool polydataAppended = false;
-    MLCBoundaryPositionVector mlc;
 
-    const char* mlcName = mlcTableNode->GetName();
-    bool typeMLCX = !strncmp( "MLCX", mlcName, strlen("MLCX")); // MLCX by default
-    bool typeMLCY = !strncmp( "MLCY", mlcName, strlen("MLCY"));
-    if (typeMLCY && !typeMLCX)
+  // MLC with opened Jaws
+  std::vector<MLCVisiblePointVector> sectionsPoints;
+  if (this->CreateMLCVisibleSectionsPoints(sectionsPoints))
+  {
+    if (sectionsPoints.empty()) // no visible sections
     {
-      typeMLCX = false;
+      vtkErrorMacro("CreateBeamPolyData: Unable to calculate MLC visible data");
+      return;
     }
 
-    // copy MLC data for easier processing
-    for (vtkIdType leafPair = 0; leafPair < nofLeafPairs; leafPair++)
-    {
-      vtkTable* table = mlcTableNode->GetTable();
-      double boundBegin = table->GetValue( leafPair, 0).ToDouble();
-      double boundEnd = table->GetValue( leafPair + 1, 0).ToDouble();
-      double pos1 = table->GetValue( leafPair, 1).ToDouble();
-      double pos2 = table->GetValue( leafPair, 2).ToDouble();
-      
-      mlc.push_back({ boundBegin, boundEnd, pos1, pos2 });
-    }
+    double cy1 = (this->VSADy + this->IsocenterToMultiLeafCollimatorDistance) / this->VSADy;
+    double cx1 = (this->VSADx + this->IsocenterToMultiLeafCollimatorDistance) / this->VSADx;
+    double cy = (this->VSADy - this->IsocenterToMultiLeafCollimatorDistance) / this->VSADy;
+    double cx = (this->VSADx - this->IsocenterToMultiLeafCollimatorDistance) / this->VSADx;
 
-    auto firstLeafIterator = mlc.end();
-    auto lastLeafIterator = mlc.end();
-    double& jawBegin = this->Y1Jaw;
-    double& jawEnd = this->Y2Jaw;
-    if (typeMLCX) // MLCX
-    {
-      jawBegin = this->Y1Jaw;
-      jawEnd = this->Y2Jaw;
-    }
-    else // MLCY
+    // Add all visible sections directly into the beam model poly data
+    for (const MLCVisiblePointVector& side12 : sectionsPoints)
     {
-      jawBegin = this->X1Jaw;
-      jawEnd = this->X2Jaw;
-    }
-
-    // find first and last opened leaves visible within jaws
-    // and fill sections vector for further processing
-    MLCSectionVector sections; // sections (first & last leaf iterator) of opened MLC
-    for (auto it = mlc.begin(); it != mlc.end(); ++it)
-    {
-      double& bound1 = (*it)[0]; // leaf pair boundary begin
-      double& bound2 = (*it)[1]; // leaf pair boundary end
-      double& pos1 = (*it)[2]; // leaf position "1"
-      double& pos2 = (*it)[3]; // leaf position "2"
-      // if leaf pair is outside the jaws, then it is closed
-      bool mlcOpened = (bound2 < jawBegin || bound1 > jawEnd) ? false : !vtkSlicerRtCommon::AreEqualWithTolerance( pos1, pos2);
-      bool withinJaw = false;
-      if (typeMLCX) // MLCX
-      {
-        withinJaw = ((pos1 < this->X1Jaw && pos2 >= this->X1Jaw && pos2 <= this->X2Jaw) || 
-          (pos1 >= this->X1Jaw && pos1 <= this->X2Jaw && pos2 > this->X2Jaw) || 
-          (pos1 <= this->X1Jaw && pos2 >= this->X2Jaw) || 
-          (pos1 >= this->X1Jaw && pos1 <= this->X2Jaw && 
-            pos2 >= this->X1Jaw && pos2 <= this->X2Jaw));
-      }
-      else // MLCY
+      // side "1" and "2" points vector
+      vtkIdType firstId = points->GetNumberOfPoints();
+      // points on MLC side
+      vtkIdType nofPoints = side12.size();
+      for (const MLCVisiblePointVector::value_type& point : side12)
       {
-        withinJaw = ((pos1 < this->Y1Jaw && pos2 >= this->Y1Jaw && pos2 <= this->Y2Jaw) || 
-          (pos1 >= this->Y1Jaw && pos1 <= this->Y2Jaw && pos2 > this->Y2Jaw) || 
-          (pos1 <= this->Y1Jaw && pos2 >= this->Y2Jaw) || 
-          (pos1 >= this->Y1Jaw && pos1 <= this->Y2Jaw && 
-            pos2 >= this->Y1Jaw && pos2 <= this->Y2Jaw));
+        const double& x = point.first;
+        const double& y = point.second;
+        points->InsertNextPoint( x * cx, y * cy, this->IsocenterToMultiLeafCollimatorDistance);
       }
 
-      if (withinJaw && mlcOpened && firstLeafIterator == mlc.end())
+      // points on the opposite (from isocenter) side
+      for (const MLCVisiblePointVector::value_type& point : side12)
       {
-        firstLeafIterator = it;
+        const double& x = point.first;
+        const double& y = point.second;
+        points->InsertNextPoint( x * cx1, y * cy1, -this->IsocenterToMultiLeafCollimatorDistance);
       }
-      if (withinJaw && mlcOpened && firstLeafIterator != mlc.end())
-      {
-        lastLeafIterator = it;
-      }
-      // check if next leaf pair is not the last
-      if (it != mlc.end() - 1)
+
+      // fill cell array for side "1" and "2"
+      for (vtkIdType i = firstId; i < firstId + nofPoints - 1; ++i)
       {
-        auto next_it = it + 1;
-        double& next_pos1 = (*next_it)[2]; // position "1" of the next leaf
-        double& next_pos2 = (*next_it)[3]; // position "2" of the next leaf
-        // if there is no open space between neighbors => start new section
-        if (mlcOpened && (next_pos1 > pos2 || next_pos2 < pos1))
-        {
-          mlcOpened = false;
-        }
+        cellArray->InsertNextCell(4);
+        cellArray->InsertCellPoint(i);
+        cellArray->InsertCellPoint(i + 1);
+        cellArray->InsertCellPoint(i + nofPoints + 1);
+        cellArray->InsertCellPoint(i + nofPoints);
       }
-      if (firstLeafIterator != mlc.end() && lastLeafIterator != mlc.end() && !mlcOpened)
+
+      // fill cell connection between side "2" -> side "1"
+      cellArray->InsertNextCell(4);
+      cellArray->InsertCellPoint(firstId);
+      cellArray->InsertCellPoint(firstId + nofPoints);
+      cellArray->InsertCellPoint(firstId + 2 * nofPoints - 1);
+      cellArray->InsertCellPoint(firstId + nofPoints - 1);
+
+      // Add the cap to the bottom
+      cellArray->InsertNextCell(nofPoints);
+      for (vtkIdType i = firstId; i < firstId + nofPoints; i++)
       {
-        sections.push_back({ firstLeafIterator, lastLeafIterator});
-        firstLeafIterator = mlc.end();
-        lastLeafIterator = mlc.end();
+        cellArray->InsertCellPoint(i);
       }
-    }
 
-    if (!sections.size()) // no visible sections
-    {
-      vtkErrorMacro("CreateBeamPolyData: Unable to calculate MLC visible data");
-      return;
-    }
-
-    // append one or more visible sections to beam model poly data
-    vtkNew<vtkAppendPolyData> append;
-    for (const MLCSectionVector::value_type& section : sections)
-    {
-      if (section.first != mlc.end() && section.second != mlc.end())
+      // Add the cap to the top
+      cellArray->InsertNextCell(nofPoints);
+      for (vtkIdType i = firstId + nofPoints; i < firstId + 2 * nofPoints; i++)
       {
-        vtkNew<vtkPolyData> beamPolyData;
-        vtkNew<vtkPoints> points;
-        vtkNew<vtkCellArray> cellArray;
-
-        MLCVisiblePointVector side12; // real points for side "1" and "2"
-        CreateMLCPointsFromSectionBorder( jawBegin, jawEnd, typeMLCX, section, side12);
-
-        // fill vtk points
-        double cy1 = (this->VSADy + this->IsocenterToMultiLeafCollimatorDistance) / this->VSADy;
-        double cx1 = (this->VSADx + this->IsocenterToMultiLeafCollimatorDistance) / this->VSADx;
-        double cy = (this->VSADy - this->IsocenterToMultiLeafCollimatorDistance) / this->VSADy;
-        double cx = (this->VSADx - this->IsocenterToMultiLeafCollimatorDistance) / this->VSADx;
-
-        // side "1" and "2" points vector
-        vtkIdType pointIds = 0;
-        // points on MLC side
-        vtkIdType nofPoints = side12.size();
-        for (const MLCVisiblePointVector::value_type& point : side12)
-        {
-          const double& x = point.first;
-          const double& y = point.second;
-          double x_ = x * cx;
-          double y_ = y * cy;
-          points->InsertPoint( pointIds++, x_, y_, this->IsocenterToMultiLeafCollimatorDistance);
-        }
-
-        // points on the opposite (from isocenter) side
-        for (const MLCVisiblePointVector::value_type& point : side12)
-        {
-          const double& x = point.first;
-          const double& y = point.second;
-
-          double x_ = x * cx1;
-          double y_ = y * cy1;
-          points->InsertPoint( pointIds++, x_, y_, -this->IsocenterToMultiLeafCollimatorDistance);
-        }
-        side12.clear(); // doesn't need anymore
-
-        // fill cell array for side "1" and "2"
-        for (vtkIdType i = 0; i < nofPoints - 1; ++i)
-        {
-          cellArray->InsertNextCell(4);
-          cellArray->InsertCellPoint(i);
-          cellArray->InsertCellPoint(i + 1);
-          cellArray->InsertCellPoint(i + nofPoints + 1);
-          cellArray->InsertCellPoint(i + nofPoints);
-        }
-
-        // fill cell connection between side "2" -> side "1"
-        cellArray->InsertNextCell(4);
-        cellArray->InsertCellPoint(0);
-        cellArray->InsertCellPoint(nofPoints);
-        cellArray->InsertCellPoint(2 * nofPoints - 1);
-        cellArray->InsertCellPoint(nofPoints - 1);
-
-        // Add the cap to the bottom
-        cellArray->InsertNextCell(nofPoints);
-        for (vtkIdType i = 0; i < nofPoints; i++)
-        {
-          cellArray->InsertCellPoint(i);
-        }
-
-        // Add the cap to the top
-        cellArray->InsertNextCell(nofPoints);
-        for (vtkIdType i = nofPoints; i < 2 * nofPoints; i++)
-        {
-          cellArray->InsertCellPoint(i);
-        }
-
-        beamPolyData->SetPoints(points);
-        beamPolyData->SetPolys(cellArray);
-
-        // append section to form final polydata
-        append->AddInputData(beamPolyData);
-        polydataAppended = true;
+        cellArray->InsertCellPoint(i);
       }
     }
-    if (polydataAppended)
-    {
-      append->Update();
-      beamModelPolyData->DeepCopy(append->GetOutput());
-      return;
-    }
+
+    beamModelPolyData->Initialize();
+    beamModelPolyData->SetPoints(points);
+    beamModelPolyData->SetPolys(cellArray);
+    return;
   }
 
   // Default beam polydata (symmetric or asymmetric jaws, no ScanSpot, no MLC)
@@ -72,6 +72,8 @@ vtkMRMLRTPlanNode::vtkMRMLRTPlanNode()
   this->DoseGrid[2] = 0;
 
   this->IonPlanFlag = false;
+
+  this->CreatePerBeamDoseVolumes = true;
 }
 
 //----------------------------------------------------------------------------
@@ -95,6 +97,7 @@ void vtkMRMLRTPlanNode::WriteXML(ostream& of, int nIndent)
   vtkMRMLWriteXMLIntMacro(IsocenterSpecification, IsocenterSpecification);
   vtkMRMLWriteXMLVectorMacro(DoseGrid, DoseGrid, double, 3);
   vtkMRMLWriteXMLBooleanMacro(IonPlanFlag, IonPlanFlag);
+  vtkMRMLWriteXMLBooleanMacro(CreatePerBeamDoseVolumes, CreatePerBeamDoseVolumes);
   vtkMRMLWriteXMLEndMacro();
 }
 
@@ -112,6 +115,7 @@ void vtkMRMLRTPlanNode::ReadXMLAttributes(const char** atts)
   vtkMRMLReadXMLIntMacro(IsocenterSpecification, IsocenterSpecification);
   vtkMRMLReadXMLVectorMacro(DoseGrid, DoseGrid, double, 3);
   vtkMRMLReadXMLBooleanMacro(IonPlanFlag, IonPlanFlag);
+  vtkMRMLReadXMLBooleanMacro(CreatePerBeamDoseVolumes, CreatePerBeamDoseVolumes);
   vtkMRMLReadXMLEndMacro();
 }
 
@@ -137,6 +141,7 @@ void vtkMRMLRTPlanNode::Copy(vtkMRMLNode *anode)
   vtkMRMLCopyStringMacro(DoseEngineName);
   vtkMRMLCopyVectorMacro(DoseGrid, double, 3);
   vtkMRMLCopyBooleanMacro(IonPlanFlag);
+  vtkMRMLCopyBooleanMacro(CreatePerBeamDoseVolumes);
   vtkMRMLCopyEndMacro();
 
   // Copy beams
@@ -176,6 +181,7 @@ void vtkMRMLRTPlanNode::CopyContent(vtkMRMLNode *anode, bool deepCopy/*=true*/)
   vtkMRMLCopyStringMacro(DoseEngineName);
   vtkMRMLCopyVectorMacro(DoseGrid, double, 3);
   vtkMRMLCopyBooleanMacro(IonPlanFlag);
+  vtkMRMLCopyBooleanMacro(CreatePerBeamDoseVolumes);
   vtkMRMLCopyEndMacro();
 }
 
@@ -192,6 +198,7 @@ void vtkMRMLRTPlanNode::PrintSelf(ostream& os, vtkIndent indent)
   vtkMRMLPrintIntMacro(IsocenterSpecification);
   vtkMRMLPrintVectorMacro(DoseGrid, double, 3);
   vtkMRMLPrintBooleanMacro(IonPlanFlag);
+  vtkMRMLPrintBooleanMacro(CreatePerBeamDoseVolumes);
 
   // Beams
   std::vector<vtkMRMLRTBeamNode*> beams;
@@ -199,6 +199,13 @@ public:
   /// Set flag for ion plan
   vtkSetMacro( IonPlanFlag, bool);
 
+  /// Get flag whether a dose volume is created for each beam during plan dose calculation
+  vtkGetMacro(CreatePerBeamDoseVolumes, bool);
+  /// Set flag whether a dose volume is created for each beam during plan dose calculation.
+  /// If off and the dose engine supports it, the beam doses are added directly into the total dose
+  vtkSetMacro(CreatePerBeamDoseVolumes, bool);
+  vtkBooleanMacro(CreatePerBeamDoseVolumes, bool);
+
 protected:
   /// Create default plan POIs markups node
   vtkMRMLMarkupsFiducialNode* CreateMarkupsFiducialNode();
@@ -240,6 +247,9 @@ protected:
 
   /// Flag, indicates that a plan node is an ion plan node
   bool IonPlanFlag;
+
+  /// Flag, indicates that a dose volume is created for each beam during plan dose calculation (on by default)
+  bool CreatePerBeamDoseVolumes;
 };
 
 #endif // __vtkMRMLRTPlanNode_h
@@ -105,7 +105,6 @@ void qMRMLBeamParametersTabWidgetPrivate::init()
   QObject::connect( this->SliderWidget_CouchAngle, SIGNAL(valueChanged(double)), q, SLOT(couchAngleChanged(double)) );
 
   // Visualization page
-  QObject::connect( this->pushButton_UpdateDRR, SIGNAL(clicked()), q, SLOT(updateDRRClicked()) );
   QObject::connect( this->checkBox_BeamsEyeView, SIGNAL(clicked(bool)), q, SLOT(beamEyesViewClicked(bool)) );
   QObject::connect( this->checkBox_ContoursInBEW, SIGNAL(clicked(bool)), q, SLOT(contoursInBEWClicked(bool)) );
 
@@ -1115,19 +1114,3 @@ void qMRMLBeamParametersTabWidget::contoursInBEWClicked(bool checked)
   }
   qWarning() << Q_FUNC_INFO << ": Not implemented!";
 }
-
-//-----------------------------------------------------------------------------
-void qMRMLBeamParametersTabWidget::updateDRRClicked()
-{
-  Q_D(qMRMLBeamParametersTabWidget);
-
-  if (!d->BeamNode)
-  {
-    qCritical() << Q_FUNC_INFO << ": No current beam node!";
-    return;
-  }
-
-  //TODO: Fix DRR code (it is in EBP logic and it is commented out)
-  //d->logic()->UpdateDRR(beamNode->GetName());
-  qCritical() << Q_FUNC_INFO << ": Not implemented!";
-}
@@ -169,7 +169,6 @@ protected slots:
   void couchAngleChanged(double);
 
   // Visualization page
-  void updateDRRClicked();
   void beamEyesViewClicked(bool);
   void contoursInBEWClicked(bool);
 
@@ -31,6 +31,7 @@
 #include <vtkMatrix4x4.h>
 #include <vtkImageData.h>
 #include <vtkPointData.h>
+#include <vtkSMPTools.h>
 #include <vtkVersion.h>
 
 // DCMTK includes
@@ -57,6 +58,14 @@ public:
   /// Utility function to load referenced series information
   void LoadReferencedSeriesUIDs(DcmDataset*);
 
+  /// Utility function to get numeric values of an element (DS, FD, FL) without string conversion
+  /// \return Success flag, false if the element does not contain the requested number of values
+  bool GetFloat64Values(DcmItem* item, const DcmTagKey& tag, double* values, unsigned long numberOfValues);
+
+  /// Utility function to get the frame of reference transformation matrix of a matrix registration item
+  /// \return Success flag
+  bool GetFrameOfReferenceTransformationMatrix(DcmItem* item, vtkMatrix4x4* matrix);
+
 public:
   vtkSlicerDicomSroReader* External;
 
@@ -112,6 +121,33 @@ void vtkSlicerDicomSroReader::vtkInternal::LoadReferencedSeriesUIDs(DcmDataset*
   }
 }
 
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomSroReader::vtkInternal::GetFloat64Values(DcmItem* item, const DcmTagKey& tag, double* values, unsigned long numberOfValues)
+{
+  for (unsigned long valueIndex=0; valueIndex<numberOfValues; valueIndex++)
+  {
+    Float64 value = 0.0;
+    if (item->findAndGetFloat64(tag, value, valueIndex).bad())
+    {
+      return false;
+    }
+    values[valueIndex] = value;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomSroReader::vtkInternal::GetFrameOfReferenceTransformationMatrix(DcmItem* item, vtkMatrix4x4* matrix)
+{
+  double matrixElements[16] = { 0.0 };
+  if (!this->GetFloat64Values(item, DCM_FrameOfReferenceTransformationMatrix, matrixElements, 16))
+  {
+    return false;
+  }
+  matrix->DeepCopy(matrixElements);
+  return true;
+}
+
 
 //----------------------------------------------------------------------------
 // vtkSlicerDicomSroReader methods
@@ -427,15 +463,9 @@ void vtkSlicerDicomSroReader::LoadDeformableSpatialRegistration(DcmDataset* data
           {
             continue;
           }
-          const Float64* matrixData = new Float64[16];
-          unsigned long count = 0;
-          preDeformationMatrixRegistrationSequenceItem->findAndGetFloat64Array(DCM_FrameOfReferenceTransformationMatrix, matrixData, &count, OFTrue);
-
-          OFString matrixString;
-          for (unsigned long n=0; n<16; n++)
+          if (!this->Internal->GetFrameOfReferenceTransformationMatrix(preDeformationMatrixRegistrationSequenceItem, preDeformationMatrix))
           {
-            preDeformationMatrixRegistrationSequenceItem->findAndGetOFString(DCM_FrameOfReferenceTransformationMatrix, matrixString, n);
-            preDeformationMatrix->SetElement((int)(n/4), n%4, atof(matrixString.c_str()));
+            vtkWarningMacro("LoadDeformableSpatialRegistration: Invalid pre-deformation matrix in dataset");
           }
         } // numOfMatrixRegistrationSequenceItems
       } // if 
@@ -463,16 +493,10 @@ void vtkSlicerDicomSroReader::LoadDeformableSpatialRegistration(DcmDataset* data
           {
             continue;
           }
-          const Float64* matrixData = new Float64[16];
-          unsigned long count = 0;
-          postDeformationMatrixRegistrationSequenceItem->findAndGetFloat64Array(DCM_FrameOfReferenceTransformationMatrix, matrixData, &count, OFTrue);
-
           vtkSmartPointer<vtkMatrix4x4> postDeformationMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-          OFString  matrixString;
-          for (unsigned long n=0; n<16; n++)
+          if (!this->Internal->GetFrameOfReferenceTransformationMatrix(postDeformationMatrixRegistrationSequenceItem, postDeformationMatrix))
           {
-            postDeformationMatrixRegistrationSequenceItem->findAndGetOFString(DCM_FrameOfReferenceTransformationMatrix, matrixString, n);
-            postDeformationMatrix->SetElement((int)(n/4), n%4, atof(matrixString.c_str()));
+            vtkWarningMacro("LoadDeformableSpatialRegistration: Invalid post-deformation matrix in dataset");
           }
           this->PostDeformationRegistrationMatrix->DeepCopy(postDeformationMatrix);
         } // numOfMatrixRegistrationSequenceItems
@@ -500,47 +524,16 @@ void vtkSlicerDicomSroReader::LoadDeformableSpatialRegistration(DcmDataset* data
           }
 
           // Image orientation patient
-          double imageOrientationPatient[6];
-          OFString tmpGridOrientationX0;
-          OFString tmpGridOrientationX1;
-          OFString tmpGridOrientationX2;
-          OFString tmpGridOrientationY0;
-          OFString tmpGridOrientationY1;
-          OFString tmpGridOrientationY2;
-          if (deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_ImageOrientationPatient, tmpGridOrientationX0, 0).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_ImageOrientationPatient, tmpGridOrientationX1, 1).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_ImageOrientationPatient, tmpGridOrientationX2, 2).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_ImageOrientationPatient, tmpGridOrientationY0, 3).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_ImageOrientationPatient, tmpGridOrientationY1, 4).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_ImageOrientationPatient, tmpGridOrientationY2, 5).good())
-          {
-            imageOrientationPatient[0] = atof(tmpGridOrientationX0.c_str());
-            imageOrientationPatient[1] = atof(tmpGridOrientationX1.c_str());
-            imageOrientationPatient[2] = atof(tmpGridOrientationX2.c_str());
-            imageOrientationPatient[3] = atof(tmpGridOrientationY0.c_str());
-            imageOrientationPatient[4] = atof(tmpGridOrientationY1.c_str());
-            imageOrientationPatient[5] = atof(tmpGridOrientationY2.c_str());
-          }
-          else
+          double imageOrientationPatient[6] = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
+          if (!this->Internal->GetFloat64Values(deformableRegistrationGridSequenceItem, DCM_ImageOrientationPatient, imageOrientationPatient, 6))
           {
             vtkDebugMacro("LoadDeformableSpatialRegistration: Found an invalid sequence in dataset");
             break;
           }
 
           // Image position patient
-          double imagePositionPatient[3];
-          OFString tmpGridPositionX;
-          OFString tmpGridPositionY;
-          OFString tmpGridPositionZ;
-          if (deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_ImagePositionPatient, tmpGridPositionX, 0).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_ImagePositionPatient, tmpGridPositionY, 1).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_ImagePositionPatient, tmpGridPositionZ, 2).good())
-          {
-            imagePositionPatient[0] = atof(tmpGridPositionX.c_str());
-            imagePositionPatient[1] = atof(tmpGridPositionY.c_str());
-            imagePositionPatient[2] = atof(tmpGridPositionZ.c_str());
-          }
-          else
+          double imagePositionPatient[3] = { 0.0, 0.0, 0.0 };
+          if (!this->Internal->GetFloat64Values(deformableRegistrationGridSequenceItem, DCM_ImagePositionPatient, imagePositionPatient, 3))
           {
             vtkDebugMacro("LoadDeformableSpatialRegistration: Found an invalid sequence in dataset");
             break;
@@ -559,40 +552,20 @@ void vtkSlicerDicomSroReader::LoadDeformableSpatialRegistration(DcmDataset* data
           this->DeformableRegistrationGridOrientationMatrix->SetElement(1, 3, imagePositionPatient[1]);
           this->DeformableRegistrationGridOrientationMatrix->SetElement(2, 3, imagePositionPatient[2]);
 
-          unsigned int gridDimX, gridDimY, gridDimZ;
-          double gridSpacingX, gridSpacingY, gridSpacingZ;
-
           // Grid dimension
-          OFString tmpGridDimX;
-          OFString tmpGridDimY;
-          OFString tmpGridDimZ;
-          if (deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_GridDimensions, tmpGridDimX, 0).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_GridDimensions, tmpGridDimY, 1).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_GridDimensions, tmpGridDimZ, 2).good())
-          {
-            gridDimX = static_cast<int>(atoi(tmpGridDimX.c_str()));
-            gridDimY = static_cast<int>(atoi(tmpGridDimY.c_str()));
-            gridDimZ = static_cast<int>(atoi(tmpGridDimZ.c_str()));
-          }
-          else
+          Uint32 gridDimensions[3] = { 0, 0, 0 };
+          if (deformableRegistrationGridSequenceItem->findAndGetUint32(DCM_GridDimensions, gridDimensions[0], 0).bad() ||
+              deformableRegistrationGridSequenceItem->findAndGetUint32(DCM_GridDimensions, gridDimensions[1], 1).bad() ||
+              deformableRegistrationGridSequenceItem->findAndGetUint32(DCM_GridDimensions, gridDimensions[2], 2).bad() ||
+              gridDimensions[0] == 0 || gridDimensions[1] == 0 || gridDimensions[2] == 0)
           {
             vtkWarningMacro("LoadDeformableSpatialRegistration: Found an invalid sequence in dataset");
             break;
           }
 
           // Grid spacing
-          OFString tmpGridSpacingX;
-          OFString tmpGridSpacingY;
-          OFString tmpGridSpacingZ;
-          if (deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_GridResolution, tmpGridSpacingX, 0).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_GridResolution, tmpGridSpacingY, 1).good() &&
-              deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_GridResolution, tmpGridSpacingZ, 2).good())
-          {
-            gridSpacingX = atof(tmpGridSpacingX.c_str());
-            gridSpacingY = atof(tmpGridSpacingY.c_str());
-            gridSpacingZ = atof(tmpGridSpacingZ.c_str());
-          }
-          else
+          double gridSpacing[3] = { 1.0, 1.0, 1.0 };
+          if (!this->Internal->GetFloat64Values(deformableRegistrationGridSequenceItem, DCM_GridResolution, gridSpacing, 3))
           {
             vtkWarningMacro("LoadDeformableSpatialRegistration: Found an invalid sequence in dataset");
             break;
@@ -612,37 +585,37 @@ void vtkSlicerDicomSroReader::LoadDeformableSpatialRegistration(DcmDataset* data
           this->DeformableRegistrationGridOrientationMatrix->SetElement(2,3,0);
 
           // Grid vector
-          OFString tmpStrX;
-          OFString tmpStrY;
-          OFString tmpStrZ;
+          // The vector grid data (OF) is decoded by DCMTK in the byte order of the machine, so it is
+          // copied directly into the grid, converting the vectors from LPS to RAS
+          const Float32* vectorGridData = nullptr;
+          unsigned long vectorGridDataCount = 0;
+          vtkIdType numberOfGridPoints = (vtkIdType)gridDimensions[0] * gridDimensions[1] * gridDimensions[2];
+          if (deformableRegistrationGridSequenceItem->findAndGetFloat32Array(DCM_VectorGridData, vectorGridData, &vectorGridDataCount).bad()
+            || !vectorGridData || (vtkIdType)vectorGridDataCount < 3 * numberOfGridPoints)
+          {
+            vtkErrorMacro("LoadDeformableSpatialRegistration: Vector grid data is missing or has fewer values than the grid");
+            return;
+          }
+
           this->DeformableRegistrationGrid->SetOrigin(imagePositionPatient[0], imagePositionPatient[1], imagePositionPatient[2]);
-          this->DeformableRegistrationGrid->SetSpacing(gridSpacingX, gridSpacingY, gridSpacingZ);
-          this->DeformableRegistrationGrid->SetExtent(0,gridDimX-1,0,gridDimY-1,0,gridDimZ-1);
-          this->DeformableRegistrationGrid->AllocateScalars(VTK_DOUBLE, 3);
+          this->DeformableRegistrationGrid->SetSpacing(gridSpacing);
+          this->DeformableRegistrationGrid->SetExtent(0,gridDimensions[0]-1,0,gridDimensions[1]-1,0,gridDimensions[2]-1);
+          this->DeformableRegistrationGrid->AllocateScalars(VTK_FLOAT, 3);
 
-          unsigned int n = 0;
-          for (unsigned int k=0; k<gridDimZ; k++)
+          float* gridVectors = static_cast<float*>(this->DeformableRegistrationGrid->GetScalarPointer());
+          vtkSMPTools::For(0, numberOfGridPoints, [&](vtkIdType begin, vtkIdType end)
           {
-            for (unsigned int j=0; j<gridDimY; j++)
+            const Float32* inputVector = vectorGridData + 3*begin;
+            float* outputVector = gridVectors + 3*begin;
+            for (vtkIdType n=begin; n<end; n++)
             {
-              for (unsigned int i=0; i<gridDimX; i++)
-              {
-                n = i + j*gridDimX + k*gridDimX*gridDimY ;
-                if (deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_VectorGridData, tmpStrX, 3*n).good() &&
-                    deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_VectorGridData, tmpStrY, 3*n + 1).good() &&
-                    deformableRegistrationGridSequenceItem->findAndGetOFString(DCM_VectorGridData, tmpStrZ, 3*n + 2).good())
-                {
-                  this->DeformableRegistrationGrid->SetScalarComponentFromDouble(i,j,k,0,-atof(tmpStrX.c_str()));
-                  this->DeformableRegistrationGrid->SetScalarComponentFromDouble(i,j,k,1,-atof(tmpStrY.c_str()));
-                  this->DeformableRegistrationGrid->SetScalarComponentFromDouble(i,j,k,2,atof(tmpStrZ.c_str()));
-                }
-                else
-                {
-                  continue;
-                }
-              }
+              outputVector[0] = -inputVector[0];
+              outputVector[1] = -inputVector[1];
+              outputVector[2] = inputVector[2];
+              inputVector += 3;
+              outputVector += 3;
             }
-          }
+          });
         } // numOfMatrixRegistrationSequenceItems
       } // if 
 
@@ -0,0 +1,222 @@
+// DicomSroImportExport includes
+#include "vtkSlicerDicomSroReader.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>    /* make sure OS specific configuration is included first */
+#include <dcmtk/dcmdata/dctk.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+const Uint32 GRID_DIMENSIONS[3] = { 23, 17, 11 };
+const Float64 GRID_RESOLUTION[3] = { 2.5, 3.0, 4.0 };
+const double GRID_POSITION[3] = { -100.5, -80.25, 12.0 };
+const double PRE_DEFORMATION_TRANSLATION[3] = { 10.0, 20.0, 30.0 };
+const double POST_DEFORMATION_TRANSLATION[3] = { 5.0, -3.0, 2.0 };
+
+//-----------------------------------------------------------------------------
+std::string GetTranslationMatrixString(const double translation[3])
+{
+  std::ostringstream matrixStream;
+  matrixStream << "1\\0\\0\\" << translation[0] << "\\0\\1\\0\\" << translation[1] << "\\0\\0\\1\\" << translation[2] << "\\0\\0\\0\\1";
+  return matrixStream.str();
+}
+
+//-----------------------------------------------------------------------------
+/// Create deformable spatial registration object with a synthetic displacement field
+bool WriteDeformableSpatialRegistration(const std::string& filename, E_TransferSyntax transferSyntax, std::vector<Float32>& vectorGridData)
+{
+  DcmFileFormat fileFormat;
+  DcmDataset* dataset = fileFormat.getDataset();
+  dataset->putAndInsertString(DCM_SOPClassUID, UID_DeformableSpatialRegistrationStorage);
+  dataset->putAndInsertString(DCM_SOPInstanceUID, "1.2.826.0.1.3680043.2.1125.1.43");
+
+  DcmItem* registrationItem = nullptr;
+  dataset->findOrCreateSequenceItem(DCM_DeformableRegistrationSequence, registrationItem, -2);
+
+  DcmItem* preDeformationItem = nullptr;
+  registrationItem->findOrCreateSequenceItem(DCM_PreDeformationMatrixRegistrationSequence, preDeformationItem, -2);
+  preDeformationItem->putAndInsertString(DCM_FrameOfReferenceTransformationMatrixType, "RIGID");
+  preDeformationItem->putAndInsertString(DCM_FrameOfReferenceTransformationMatrix, GetTranslationMatrixString(PRE_DEFORMATION_TRANSLATION).c_str());
+
+  DcmItem* postDeformationItem = nullptr;
+  registrationItem->findOrCreateSequenceItem(DCM_PostDeformationMatrixRegistrationSequence, postDeformationItem, -2);
+  postDeformationItem->putAndInsertString(DCM_FrameOfReferenceTransformationMatrixType, "RIGID");
+  postDeformationItem->putAndInsertString(DCM_FrameOfReferenceTransformationMatrix, GetTranslationMatrixString(POST_DEFORMATION_TRANSLATION).c_str());
+
+  DcmItem* gridItem = nullptr;
+  registrationItem->findOrCreateSequenceItem(DCM_DeformableRegistrationGridSequence, gridItem, -2);
+  gridItem->putAndInsertString(DCM_ImageOrientationPatient, "1\\0\\0\\0\\1\\0");
+  std::ostringstream positionStream;
+  positionStream << GRID_POSITION[0] << "\\" << GRID_POSITION[1] << "\\" << GRID_POSITION[2];
+  gridItem->putAndInsertString(DCM_ImagePositionPatient, positionStream.str().c_str());
+  for (unsigned long axis = 0; axis < 3; ++axis)
+  {
+    gridItem->putAndInsertUint32(DCM_GridDimensions, GRID_DIMENSIONS[axis], axis);
+    gridItem->putAndInsertFloat64(DCM_GridResolution, GRID_RESOLUTION[axis], axis);
+  }
+
+  unsigned long numberOfGridPoints = GRID_DIMENSIONS[0] * GRID_DIMENSIONS[1] * GRID_DIMENSIONS[2];
+  vectorGridData.resize(3 * numberOfGridPoints);
+  for (unsigned long n = 0; n < vectorGridData.size(); ++n)
+  {
+    vectorGridData[n] = static_cast<Float32>(sin(0.37 * n) * 12.5 + (n % 3) * 0.001);
+  }
+  gridItem->putAndInsertFloat32Array(DCM_VectorGridData, vectorGridData.data(), vectorGridData.size());
+
+  return fileFormat.saveFile(filename.c_str(), transferSyntax).good();
+}
+
+//-----------------------------------------------------------------------------
+/// Get grid vector the way the reader used to, through string values
+bool GetGridVectorThroughStrings(DcmItem* gridItem, unsigned long n, double vector[3])
+{
+  for (int component = 0; component < 3; ++component)
+  {
+    OFString valueString;
+    if (gridItem->findAndGetOFString(DCM_VectorGridData, valueString, 3*n + component).bad())
+    {
+      return false;
+    }
+    vector[component] = atof(valueString.c_str());
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CheckDeformableSpatialRegistration(const std::string& filename, const std::vector<Float32>& vectorGridData)
+{
+  vtkNew<vtkSlicerDicomSroReader> reader;
+  reader->SetFileName(filename.c_str());
+  reader->Update();
+  if (!reader->GetLoadDeformableSpatialRegistrationSuccessful())
+  {
+    std::cerr << "Failed to load deformable spatial registration from " << filename << std::endl;
+    return false;
+  }
+
+  // Grid geometry
+  vtkImageData* grid = reader->GetDeformableRegistrationGrid();
+  int* dimensions = grid->GetDimensions();
+  double* spacing = grid->GetSpacing();
+  double* origin = grid->GetOrigin();
+  double expectedOrigin[3] = { -(GRID_POSITION[0] + PRE_DEFORMATION_TRANSLATION[0]),
+    -(GRID_POSITION[1] + PRE_DEFORMATION_TRANSLATION[1]), GRID_POSITION[2] + PRE_DEFORMATION_TRANSLATION[2] };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if ( dimensions[axis] != static_cast<int>(GRID_DIMENSIONS[axis]) || spacing[axis] != GRID_RESOLUTION[axis]
+      || fabs(origin[axis] - expectedOrigin[axis]) > 1e-6 )
+    {
+      std::cerr << "Grid geometry mismatch along axis " << axis << std::endl;
+      return false;
+    }
+  }
+  if (grid->GetNumberOfScalarComponents() != 3)
+  {
+    std::cerr << "Grid is not a vector field" << std::endl;
+    return false;
+  }
+
+  // Post-deformation matrix in RAS
+  vtkMatrix4x4* postDeformationMatrix = reader->GetPostDeformationRegistrationMatrix();
+  if ( postDeformationMatrix->GetElement(0,3) != -POST_DEFORMATION_TRANSLATION[0]
+    || postDeformationMatrix->GetElement(1,3) != -POST_DEFORMATION_TRANSLATION[1]
+    || postDeformationMatrix->GetElement(2,3) != POST_DEFORMATION_TRANSLATION[2] )
+  {
+    std::cerr << "Post-deformation matrix mismatch" << std::endl;
+    return false;
+  }
+
+  // Compare the vectors to the original data and to the values decoded through strings
+  DcmFileFormat fileFormat;
+  DcmItem* registrationItem = nullptr;
+  DcmItem* gridItem = nullptr;
+  if ( fileFormat.loadFile(filename.c_str()).bad()
+    || fileFormat.getDataset()->findAndGetSequenceItem(DCM_DeformableRegistrationSequence, registrationItem, 0).bad()
+    || registrationItem->findAndGetSequenceItem(DCM_DeformableRegistrationGridSequence, gridItem, 0).bad() )
+  {
+    std::cerr << "Failed to load grid item from " << filename << std::endl;
+    return false;
+  }
+  const double rasSigns[3] = { -1.0, -1.0, 1.0 };
+  unsigned long numberOfGridPoints = GRID_DIMENSIONS[0] * GRID_DIMENSIONS[1] * GRID_DIMENSIONS[2];
+  for (unsigned long n = 0; n < numberOfGridPoints; ++n)
+  {
+    double stringVector[3] = { 0.0, 0.0, 0.0 };
+    if (!GetGridVectorThroughStrings(gridItem, n, stringVector))
+    {
+      std::cerr << "Failed to get vector " << n << " through strings" << std::endl;
+      return false;
+    }
+    int i = n % GRID_DIMENSIONS[0];
+    int j = (n / GRID_DIMENSIONS[0]) % GRID_DIMENSIONS[1];
+    int k = n / (GRID_DIMENSIONS[0] * GRID_DIMENSIONS[1]);
+    for (int component = 0; component < 3; ++component)
+    {
+      double value = grid->GetScalarComponentAsDouble(i, j, k, component);
+      if ( value != rasSigns[component] * vectorGridData[3*n + component]
+        || fabs(value - rasSigns[component] * stringVector[component]) > 1e-5 * (1.0 + fabs(value)) )
+      {
+        std::cerr << "Grid vector mismatch at point " << n << " component " << component << ": " << value
+          << " (original " << rasSigns[component] * vectorGridData[3*n + component]
+          << ", through strings " << rasSigns[component] * stringVector[component] << ")" << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerDicomSroReaderTest1( int argc, char * argv[] )
+{
+  // TemporaryDirectory
+  std::string temporaryDirectory;
+  if (argc > 2 && STRCASECMP(argv[1], "-TemporaryDirectory") == 0)
+  {
+    temporaryDirectory = argv[2];
+    std::cout << "Temporary directory: " << temporaryDirectory << std::endl;
+  }
+  else
+  {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtksys::SystemTools::MakeDirectory(temporaryDirectory);
+
+  // Both byte orders, to verify that the vector grid data is decoded independently of the file byte order
+  const E_TransferSyntax transferSyntaxes[2] = { EXS_LittleEndianExplicit, EXS_BigEndianExplicit };
+  const char* transferSyntaxNames[2] = { "LittleEndian", "BigEndian" };
+  for (int syntaxIndex = 0; syntaxIndex < 2; ++syntaxIndex)
+  {
+    std::string filename = temporaryDirectory + "/DeformableSpatialRegistration_" + transferSyntaxNames[syntaxIndex] + ".dcm";
+    std::vector<Float32> vectorGridData;
+    if (!WriteDeformableSpatialRegistration(filename, transferSyntaxes[syntaxIndex], vectorGridData))
+    {
+      std::cerr << "Failed to write deformable spatial registration " << filename << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!CheckDeformableSpatialRegistration(filename, vectorGridData))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,908 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkGammaDoseComparisonFilter.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// Classification of the voxels of the reference dose
+enum VoxelState
+{
+  VoxelNotAnalyzed = 0,
+  VoxelUndecided,
+  VoxelPassed,
+  VoxelFailed
+};
+
+//----------------------------------------------------------------------------
+/// Reference and compare dose on the grid of the reference, and the gamma criteria
+struct GammaInput
+{
+  int Dimensions[3];
+  /// Voxel spacing divided by the distance tolerance
+  double NormalizedSpacing[3];
+  const float* Reference;
+  const float* Compare;
+  /// Mask, nullptr if all voxels are inside
+  const float* Mask;
+  /// Analysis threshold in Gy
+  float Threshold;
+  bool ThresholdOnReferenceOnly;
+  /// Squared inverse of the global dose tolerance in Gy
+  double InverseDoseToleranceSquared;
+  /// Dose tolerance fraction and minimum dose for local dose difference. Not used for global dose difference
+  double LocalDoseTolerance;
+  double LocalMinimumDose;
+  bool Local;
+  double MaximumGammaSquared;
+  /// Interpolate the compare dose along the edges between the voxels
+  bool InterpolatedSearch;
+
+  double GetInverseDoseToleranceSquared(double referenceValue) const
+  {
+    if (!this->Local)
+    {
+      return this->InverseDoseToleranceSquared;
+    }
+    double doseTolerance = this->LocalDoseTolerance * std::max(referenceValue, this->LocalMinimumDose);
+    return 1.0 / (doseTolerance * doseTolerance);
+  }
+
+  bool IsAnalyzed(vtkIdType index) const
+  {
+    if (this->Mask && this->Mask[index] == 0.0f)
+    {
+      return false;
+    }
+    return (this->Reference[index] >= this->Threshold || (!this->ThresholdOnReferenceOnly && this->Compare[index] >= this->Threshold));
+  }
+};
+
+//----------------------------------------------------------------------------
+/// Voxel offset within the search distance
+struct SearchOffset
+{
+  int Offset[3];
+  vtkIdType Increment;
+  /// Squared distance divided by the squared distance tolerance
+  double DistanceTerm;
+};
+
+//----------------------------------------------------------------------------
+/// Get search offsets within the distance where the distance term reaches the maximum gamma, nearest first
+void GetSearchOffsets(const GammaInput& input, const int searchRadius[3], std::vector<SearchOffset>& offsets)
+{
+  offsets.clear();
+  for (int k = -searchRadius[2]; k <= searchRadius[2]; ++k)
+  {
+    for (int j = -searchRadius[1]; j <= searchRadius[1]; ++j)
+    {
+      for (int i = -searchRadius[0]; i <= searchRadius[0]; ++i)
+      {
+        double x = i * input.NormalizedSpacing[0];
+        double y = j * input.NormalizedSpacing[1];
+        double z = k * input.NormalizedSpacing[2];
+        SearchOffset offset;
+        offset.DistanceTerm = x * x + y * y + z * z;
+        if (offset.DistanceTerm >= input.MaximumGammaSquared)
+        {
+          continue;
+        }
+        offset.Offset[0] = i;
+        offset.Offset[1] = j;
+        offset.Offset[2] = k;
+        offset.Increment = i + input.Dimensions[0] * (j + static_cast<vtkIdType>(input.Dimensions[1]) * k);
+        offsets.push_back(offset);
+      }
+    }
+  }
+  std::stable_sort(offsets.begin(), offsets.end(),
+    [](const SearchOffset& a, const SearchOffset& b) { return a.DistanceTerm < b.DistanceTerm; });
+}
+
+//----------------------------------------------------------------------------
+/// Squared gamma of a reference voxel. The compare voxels are searched nearest first, until the distance
+/// term alone is not less than the best value, which is initialized to an upper bound of the squared gamma
+double ComputeGammaSquared(const GammaInput& input, const std::vector<SearchOffset>& offsets,
+  int i, int j, int k, double upperBound)
+{
+  vtkIdType index = i + input.Dimensions[0] * (j + static_cast<vtkIdType>(input.Dimensions[1]) * k);
+  double referenceValue = input.Reference[index];
+  double inverseDoseToleranceSquared = input.GetInverseDoseToleranceSquared(referenceValue);
+  double best = upperBound;
+  for (const SearchOffset& offset : offsets)
+  {
+    if (offset.DistanceTerm >= best)
+    {
+      break;
+    }
+    if ( static_cast<unsigned int>(i + offset.Offset[0]) >= static_cast<unsigned int>(input.Dimensions[0])
+      || static_cast<unsigned int>(j + offset.Offset[1]) >= static_cast<unsigned int>(input.Dimensions[1])
+      || static_cast<unsigned int>(k + offset.Offset[2]) >= static_cast<unsigned int>(input.Dimensions[2]) )
+    {
+      continue;
+    }
+    double difference = input.Compare[index + offset.Increment] - referenceValue;
+    best = std::min(best, offset.DistanceTerm + difference * difference * inverseDoseToleranceSquared);
+  }
+  return best;
+}
+
+//----------------------------------------------------------------------------
+/// Minimum squared gamma on the edges from a compare voxel to its face neighbors, with the compare dose
+/// linearly interpolated along the edges. The squared gamma along an edge is a quadratic function of the
+/// position, so its minimum is computed directly. The compare voxel itself is included
+double ComputeInterpolatedGammaSquared(const GammaInput& input, const SearchOffset& offset, const int compareIjk[3],
+  vtkIdType compareIndex, double referenceValue, double inverseDoseToleranceSquared)
+{
+  const vtkIdType increments[3] = { 1, input.Dimensions[0], static_cast<vtkIdType>(input.Dimensions[0]) * input.Dimensions[1] };
+  double doseDifference = input.Compare[compareIndex] - referenceValue;
+  double constantTerm = offset.DistanceTerm + doseDifference * doseDifference * inverseDoseToleranceSquared;
+  double best = constantTerm;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    double edgeLength = input.NormalizedSpacing[axis];
+    double offsetAlongAxis = offset.Offset[axis] * edgeLength;
+    for (int direction = -1; direction <= 1; direction += 2)
+    {
+      if (static_cast<unsigned int>(compareIjk[axis] + direction) >= static_cast<unsigned int>(input.Dimensions[axis]))
+      {
+        continue;
+      }
+      double doseChange = input.Compare[compareIndex + direction * increments[axis]] - input.Compare[compareIndex];
+      // Squared gamma at position t in [0, 1] along the edge is quadraticTerm*t^2 + linearTerm*t + constantTerm
+      double quadraticTerm = edgeLength * edgeLength + doseChange * doseChange * inverseDoseToleranceSquared;
+      double linearTerm = 2.0 * (direction * edgeLength * offsetAlongAxis + doseDifference * doseChange * inverseDoseToleranceSquared);
+      double t = std::min(std::max(-linearTerm / (2.0 * quadraticTerm), 0.0), 1.0);
+      best = std::min(best, constantTerm + t * (linearTerm + t * quadraticTerm));
+    }
+  }
+  return best;
+}
+
+//----------------------------------------------------------------------------
+/// Squared gamma of a reference voxel, searched only until the interval of decision levels containing it
+/// is known. The decision levels are squared gamma values in ascending order, starting with zero. The intervals
+/// are [0, level 1], (level 1, level 2], ..., (last level, maximum]. The returned value is in the same interval
+/// as the squared gamma, and is an upper bound of it
+double ComputeGammaSquaredInterval(const GammaInput& input, const std::vector<SearchOffset>& offsets,
+  const std::vector<double>& decisionLevels, int i, int j, int k)
+{
+  vtkIdType index = i + input.Dimensions[0] * (j + static_cast<vtkIdType>(input.Dimensions[1]) * k);
+  double referenceValue = input.Reference[index];
+  double inverseDoseToleranceSquared = input.GetInverseDoseToleranceSquared(referenceValue);
+  double best = input.MaximumGammaSquared;
+  size_t interval = decisionLevels.size() - 1;
+  for (const SearchOffset& offset : offsets)
+  {
+    // Remaining compare voxels cannot bring the gamma below the lower bound of the current interval
+    if (interval == 0 || offset.DistanceTerm > decisionLevels[interval])
+    {
+      break;
+    }
+    if ( static_cast<unsigned int>(i + offset.Offset[0]) >= static_cast<unsigned int>(input.Dimensions[0])
+      || static_cast<unsigned int>(j + offset.Offset[1]) >= static_cast<unsigned int>(input.Dimensions[1])
+      || static_cast<unsigned int>(k + offset.Offset[2]) >= static_cast<unsigned int>(input.Dimensions[2]) )
+    {
+      continue;
+    }
+    double gammaSquared = 0.0;
+    if (input.InterpolatedSearch)
+    {
+      int compareIjk[3] = { i + offset.Offset[0], j + offset.Offset[1], k + offset.Offset[2] };
+      gammaSquared = ComputeInterpolatedGammaSquared(input, offset, compareIjk, index + offset.Increment,
+        referenceValue, inverseDoseToleranceSquared);
+    }
+    else
+    {
+      double difference = input.Compare[index + offset.Increment] - referenceValue;
+      gammaSquared = offset.DistanceTerm + difference * difference * inverseDoseToleranceSquared;
+    }
+    if (gammaSquared < best)
+    {
+      best = gammaSquared;
+      while (interval > 0 && decisionLevels[interval] >= best)
+      {
+        --interval;
+      }
+    }
+  }
+  return best;
+}
+
+//----------------------------------------------------------------------------
+/// Voxel counts and gamma histogram
+struct PassRateAccumulator
+{
+  vtkIdType NumberOfAnalyzedVoxels{0};
+  vtkIdType NumberOfPassingVoxels{0};
+  std::vector<vtkIdType> HistogramBinCounts;
+};
+
+//----------------------------------------------------------------------------
+/// Accumulates the pass/fail counts and the gamma histogram of the rows of the reference in parallel,
+/// without storing the gamma of the voxels
+class PassRateFunctor
+{
+public:
+  PassRateFunctor(const GammaInput& input, const std::vector<SearchOffset>& offsets, int numberOfHistogramBins, double maximumGamma)
+    : Input(input)
+    , Offsets(offsets)
+  {
+    // Histogram bin boundaries and the pass/fail boundary decide the intervals the search needs to resolve
+    this->DecisionLevels.push_back(0.0);
+    for (int bin = 1; bin < numberOfHistogramBins; ++bin)
+    {
+      double binBoundary = bin * maximumGamma / numberOfHistogramBins;
+      this->HistogramBoundaries.push_back(binBoundary * binBoundary);
+      this->DecisionLevels.push_back(binBoundary * binBoundary);
+    }
+    if (input.MaximumGammaSquared > 1.0)
+    {
+      this->DecisionLevels.push_back(1.0);
+    }
+    std::sort(this->DecisionLevels.begin(), this->DecisionLevels.end());
+    this->DecisionLevels.erase(std::unique(this->DecisionLevels.begin(), this->DecisionLevels.end()), this->DecisionLevels.end());
+    this->NumberOfHistogramBins = std::max(numberOfHistogramBins, 0);
+  }
+
+  void Initialize()
+  {
+    PassRateAccumulator& accumulator = this->LocalAccumulator.Local();
+    accumulator = PassRateAccumulator();
+    accumulator.HistogramBinCounts.resize(this->NumberOfHistogramBins, 0);
+  }
+
+  void operator()(vtkIdType beginRow, vtkIdType endRow)
+  {
+    PassRateAccumulator& accumulator = this->LocalAccumulator.Local();
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+    {
+      int j = static_cast<int>(row % this->Input.Dimensions[1]);
+      int k = static_cast<int>(row / this->Input.Dimensions[1]);
+      vtkIdType index = row * this->Input.Dimensions[0];
+      for (int i = 0; i < this->Input.Dimensions[0]; ++i, ++index)
+      {
+        if (!this->Input.IsAnalyzed(index))
+        {
+          continue;
+        }
+        double gammaSquared = ComputeGammaSquaredInterval(this->Input, this->Offsets, this->DecisionLevels, i, j, k);
+        ++accumulator.NumberOfAnalyzedVoxels;
+        if (gammaSquared <= 1.0)
+        {
+          ++accumulator.NumberOfPassingVoxels;
+        }
+        if (this->NumberOfHistogramBins > 0)
+        {
+          size_t bin = std::lower_bound(this->HistogramBoundaries.begin(), this->HistogramBoundaries.end(), gammaSquared)
+            - this->HistogramBoundaries.begin();
+          ++accumulator.HistogramBinCounts[bin];
+        }
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    this->Result = PassRateAccumulator();
+    this->Result.HistogramBinCounts.resize(this->NumberOfHistogramBins, 0);
+    for (vtkSMPThreadLocal<PassRateAccumulator>::iterator localIt = this->LocalAccumulator.begin();
+      localIt != this->LocalAccumulator.end(); ++localIt)
+    {
+      this->Result.NumberOfAnalyzedVoxels += (*localIt).NumberOfAnalyzedVoxels;
+      this->Result.NumberOfPassingVoxels += (*localIt).NumberOfPassingVoxels;
+      for (int bin = 0; bin < this->NumberOfHistogramBins; ++bin)
+      {
+        this->Result.HistogramBinCounts[bin] += (*localIt).HistogramBinCounts[bin];
+      }
+    }
+  }
+
+  PassRateAccumulator Result;
+
+private:
+  const GammaInput& Input;
+  const std::vector<SearchOffset>& Offsets;
+  int NumberOfHistogramBins;
+  /// Squared gamma of the boundaries between histogram bins
+  std::vector<double> HistogramBoundaries;
+  /// Squared gamma of the histogram bin boundaries and of the pass/fail boundary
+  std::vector<double> DecisionLevels;
+  vtkSMPThreadLocal<PassRateAccumulator> LocalAccumulator;
+};
+
+//----------------------------------------------------------------------------
+/// Minimum and maximum compare dose in blocks of voxels
+struct DoseBlockLevel
+{
+  int BlockSize;
+  int Dimensions[3];
+  std::vector<float> Minimum;
+  std::vector<float> Maximum;
+};
+
+//----------------------------------------------------------------------------
+/// Compute a level from the next finer level by merging 2x2x2 blocks
+void ComputeDoseBlockLevel(const float* finerMinimum, const float* finerMaximum, const int finerDimensions[3],
+  int blockSize, DoseBlockLevel& level)
+{
+  level.BlockSize = blockSize;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    level.Dimensions[axis] = (finerDimensions[axis] + 1) / 2;
+  }
+  vtkIdType numberOfBlocks = static_cast<vtkIdType>(level.Dimensions[0]) * level.Dimensions[1] * level.Dimensions[2];
+  level.Minimum.resize(numberOfBlocks);
+  level.Maximum.resize(numberOfBlocks);
+  vtkSMPTools::For(0, level.Dimensions[2], [&](vtkIdType beginK, vtkIdType endK)
+  {
+    for (vtkIdType k = beginK; k < endK; ++k)
+    {
+      for (int j = 0; j < level.Dimensions[1]; ++j)
+      {
+        for (int i = 0; i < level.Dimensions[0]; ++i)
+        {
+          float minimum = VTK_FLOAT_MAX;
+          float maximum = -VTK_FLOAT_MAX;
+          for (int finerK = 2 * static_cast<int>(k); finerK < std::min(2 * static_cast<int>(k) + 2, finerDimensions[2]); ++finerK)
+          {
+            for (int finerJ = 2 * j; finerJ < std::min(2 * j + 2, finerDimensions[1]); ++finerJ)
+            {
+              for (int finerI = 2 * i; finerI < std::min(2 * i + 2, finerDimensions[0]); ++finerI)
+              {
+                vtkIdType finerIndex = finerI + finerDimensions[0] * (finerJ + static_cast<vtkIdType>(finerDimensions[1]) * finerK);
+                minimum = std::min(minimum, finerMinimum[finerIndex]);
+                maximum = std::max(maximum, finerMaximum[finerIndex]);
+              }
+            }
+          }
+          vtkIdType index = i + level.Dimensions[0] * (j + static_cast<vtkIdType>(level.Dimensions[1]) * k);
+          level.Minimum[index] = minimum;
+          level.Maximum[index] = maximum;
+        }
+      }
+    }
+  });
+}
+
+//----------------------------------------------------------------------------
+/// Distance from a voxel index to a block of voxels along an axis, in voxels
+inline int GetDistanceToBlock(int index, int blockIndex, int blockSize)
+{
+  int first = blockIndex * blockSize;
+  int last = first + blockSize - 1;
+  return (index < first ? first - index : (index > last ? index - last : 0));
+}
+
+//----------------------------------------------------------------------------
+/// Lower bound of the squared gamma of a reference voxel, from the compare dose range of the blocks within
+/// the search radius. Every compare voxel in a block is at least as far as the nearest point of the block,
+/// and its dose is within the range of the block. The bound is limited to an upper bound of the squared gamma
+double ComputeGammaSquaredLowerBound(const GammaInput& input, const DoseBlockLevel& level, const int searchRadius[3],
+  int i, int j, int k, double upperBound)
+{
+  vtkIdType index = i + input.Dimensions[0] * (j + static_cast<vtkIdType>(input.Dimensions[1]) * k);
+  double referenceValue = input.Reference[index];
+  double inverseDoseToleranceSquared = input.GetInverseDoseToleranceSquared(referenceValue);
+  int voxelIndex[3] = { i, j, k };
+  int blockRange[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    blockRange[2*axis] = std::max(voxelIndex[axis] - searchRadius[axis], 0) / level.BlockSize;
+    blockRange[2*axis+1] = std::min(voxelIndex[axis] + searchRadius[axis], input.Dimensions[axis] - 1) / level.BlockSize;
+  }
+
+  double best = upperBound;
+  for (int blockK = blockRange[4]; blockK <= blockRange[5]; ++blockK)
+  {
+    double z = GetDistanceToBlock(k, blockK, level.BlockSize) * input.NormalizedSpacing[2];
+    double distanceTermZ = z * z;
+    if (distanceTermZ >= best)
+    {
+      continue;
+    }
+    for (int blockJ = blockRange[2]; blockJ <= blockRange[3]; ++blockJ)
+    {
+      double y = GetDistanceToBlock(j, blockJ, level.BlockSize) * input.NormalizedSpacing[1];
+      double distanceTermYZ = distanceTermZ + y * y;
+      if (distanceTermYZ >= best)
+      {
+        continue;
+      }
+      for (int blockI = blockRange[0]; blockI <= blockRange[1]; ++blockI)
+      {
+        double x = GetDistanceToBlock(i, blockI, level.BlockSize) * input.NormalizedSpacing[0];
+        double distanceTerm = distanceTermYZ + x * x;
+        if (distanceTerm >= best)
+        {
+          continue;
+        }
+        vtkIdType blockIndex = blockI + level.Dimensions[0] * (blockJ + static_cast<vtkIdType>(level.Dimensions[1]) * blockK);
+        double difference = std::max(std::max(level.Minimum[blockIndex] - referenceValue, referenceValue - level.Maximum[blockIndex]), 0.0);
+        best = std::min(best, distanceTerm + difference * difference * inverseDoseToleranceSquared);
+      }
+    }
+  }
+  return best;
+}
+
+//----------------------------------------------------------------------------
+/// Get the scalars of an image on an extent as float. Voxels outside of the image extent are zero.
+/// The image must be on the grid the extent refers to. Float images covering exactly the extent are used
+/// in place, other images are copied to the buffer
+/// \return Pointer to the scalars
+const float* GetScalarsOnExtent(vtkOrientedImageData* image, const int extent[6], std::vector<float>& values)
+{
+  int* imageExtent = image->GetExtent();
+  if ( image->GetScalarType() == VTK_FLOAT && image->GetNumberOfScalarComponents() == 1
+    && std::equal(extent, extent + 6, imageExtent) )
+  {
+    return static_cast<const float*>(image->GetScalarPointer());
+  }
+
+  int dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+  values.assign(static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2], 0.0f);
+  vtkDataArray* scalars = image->GetPointData()->GetScalars();
+  int imageDimensions[3] = { 0, 0, 0 };
+  image->GetDimensions(imageDimensions);
+  int commonExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    commonExtent[2*axis] = std::max(extent[2*axis], imageExtent[2*axis]);
+    commonExtent[2*axis+1] = std::min(extent[2*axis+1], imageExtent[2*axis+1]);
+  }
+  if (commonExtent[0] > commonExtent[1] || commonExtent[2] > commonExtent[3] || commonExtent[4] > commonExtent[5])
+  {
+    return values.data();
+  }
+  vtkSMPTools::For(commonExtent[4], commonExtent[5] + 1, [&](vtkIdType beginK, vtkIdType endK)
+  {
+    for (vtkIdType k = beginK; k < endK; ++k)
+    {
+      for (int j = commonExtent[2]; j <= commonExtent[3]; ++j)
+      {
+        vtkIdType imageIndex = (commonExtent[0] - imageExtent[0])
+          + imageDimensions[0] * ((j - imageExtent[2]) + static_cast<vtkIdType>(imageDimensions[1]) * (k - imageExtent[4]));
+        vtkIdType index = (commonExtent[0] - extent[0])
+          + dimensions[0] * ((j - extent[2]) + static_cast<vtkIdType>(dimensions[1]) * (k - extent[4]));
+        for (int i = commonExtent[0]; i <= commonExtent[1]; ++i, ++imageIndex, ++index)
+        {
+          values[index] = static_cast<float>(scalars->GetComponent(imageIndex, 0));
+        }
+      }
+    }
+  });
+  return values.data();
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkGammaDoseComparisonFilter);
+
+//----------------------------------------------------------------------------
+vtkGammaDoseComparisonFilter::vtkGammaDoseComparisonFilter()
+  : DistanceToleranceMm(3.0)
+  , DoseDifferenceTolerance(0.03)
+  , ReferenceDoseGy(0.0)
+  , AnalysisThreshold(0.1)
+  , MaximumGamma(2.0)
+  , LocalDoseDifference(false)
+  , ThresholdOnReferenceOnly(false)
+  , Algorithm(AlgorithmExhaustive)
+  , NumberOfResolutionLevels(2)
+  , PassRateOnly(false)
+  , InterpolatedSearch(false)
+  , NumberOfHistogramBins(0)
+  , PassFraction(0.0)
+  , NumberOfAnalyzedVoxels(0)
+  , NumberOfPassingVoxels(0)
+  , ReferenceDoseUsedGy(0.0)
+{
+  this->OutputGammaImage = vtkSmartPointer<vtkOrientedImageData>::New();
+}
+
+//----------------------------------------------------------------------------
+vtkGammaDoseComparisonFilter::~vtkGammaDoseComparisonFilter() = default;
+
+//----------------------------------------------------------------------------
+void vtkGammaDoseComparisonFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "DistanceToleranceMm: " << this->DistanceToleranceMm << "\n";
+  os << indent << "DoseDifferenceTolerance: " << this->DoseDifferenceTolerance << "\n";
+  os << indent << "ReferenceDoseGy: " << this->ReferenceDoseGy << "\n";
+  os << indent << "AnalysisThreshold: " << this->AnalysisThreshold << "\n";
+  os << indent << "MaximumGamma: " << this->MaximumGamma << "\n";
+  os << indent << "LocalDoseDifference: " << (this->LocalDoseDifference ? "true" : "false") << "\n";
+  os << indent << "ThresholdOnReferenceOnly: " << (this->ThresholdOnReferenceOnly ? "true" : "false") << "\n";
+  os << indent << "Algorithm: " << (this->Algorithm == AlgorithmMultiresolution ? "Multiresolution" : "Exhaustive") << "\n";
+  os << indent << "NumberOfResolutionLevels: " << this->NumberOfResolutionLevels << "\n";
+  os << indent << "PassRateOnly: " << (this->PassRateOnly ? "true" : "false") << "\n";
+  os << indent << "InterpolatedSearch: " << (this->InterpolatedSearch ? "true" : "false") << "\n";
+  os << indent << "NumberOfHistogramBins: " << this->NumberOfHistogramBins << "\n";
+  os << indent << "PassFraction: " << this->PassFraction << "\n";
+  os << indent << "NumberOfAnalyzedVoxels: " << this->NumberOfAnalyzedVoxels << "\n";
+  os << indent << "NumberOfPassingVoxels: " << this->NumberOfPassingVoxels << "\n";
+  os << indent << "ReferenceDoseUsedGy: " << this->ReferenceDoseUsedGy << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkGammaDoseComparisonFilter::SetInputReferenceDose(vtkOrientedImageData* dose)
+{
+  this->InputReferenceDose = dose;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkGammaDoseComparisonFilter::GetInputReferenceDose()
+{
+  return this->InputReferenceDose;
+}
+
+//----------------------------------------------------------------------------
+void vtkGammaDoseComparisonFilter::SetInputCompareDose(vtkOrientedImageData* dose)
+{
+  this->InputCompareDose = dose;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkGammaDoseComparisonFilter::GetInputCompareDose()
+{
+  return this->InputCompareDose;
+}
+
+//----------------------------------------------------------------------------
+void vtkGammaDoseComparisonFilter::SetInputMask(vtkOrientedImageData* mask)
+{
+  this->InputMask = mask;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkGammaDoseComparisonFilter::GetInputMask()
+{
+  return this->InputMask;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkGammaDoseComparisonFilter::GetOutputGammaImage()
+{
+  return this->OutputGammaImage;
+}
+
+//----------------------------------------------------------------------------
+double vtkGammaDoseComparisonFilter::GetLevelEvaluatedFraction(int level)
+{
+  if (level < 0 || level >= static_cast<int>(this->LevelEvaluatedFractions.size()))
+  {
+    vtkErrorMacro("GetLevelEvaluatedFraction: Invalid level " << level);
+    return 0.0;
+  }
+  return this->LevelEvaluatedFractions[level];
+}
+
+//----------------------------------------------------------------------------
+double vtkGammaDoseComparisonFilter::GetLevelTime(int level)
+{
+  if (level < 0 || level >= static_cast<int>(this->LevelTimes.size()))
+  {
+    vtkErrorMacro("GetLevelTime: Invalid level " << level);
+    return 0.0;
+  }
+  return this->LevelTimes[level];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkGammaDoseComparisonFilter::GetHistogramBinCount(int bin)
+{
+  if (bin < 0 || bin >= static_cast<int>(this->HistogramBinCounts.size()))
+  {
+    vtkErrorMacro("GetHistogramBinCount: Invalid histogram bin " << bin);
+    return 0;
+  }
+  return this->HistogramBinCounts[bin];
+}
+
+//----------------------------------------------------------------------------
+bool vtkGammaDoseComparisonFilter::Update()
+{
+  this->PassFraction = 0.0;
+  this->NumberOfAnalyzedVoxels = 0;
+  this->NumberOfPassingVoxels = 0;
+  this->ReferenceDoseUsedGy = 0.0;
+  this->LevelEvaluatedFractions.clear();
+  this->LevelTimes.clear();
+  this->HistogramBinCounts.clear();
+
+  vtkOrientedImageData* referenceDose = this->InputReferenceDose;
+  if ( !referenceDose || !referenceDose->GetPointData()->GetScalars() || referenceDose->IsEmpty()
+    || !this->InputCompareDose || !this->InputCompareDose->GetPointData()->GetScalars() )
+  {
+    vtkErrorMacro("Update: Invalid input dose volumes");
+    return false;
+  }
+  if (this->DistanceToleranceMm <= 0.0 || this->DoseDifferenceTolerance <= 0.0 || this->MaximumGamma <= 0.0)
+  {
+    vtkErrorMacro("Update: Invalid gamma criteria");
+    return false;
+  }
+  if (this->NumberOfHistogramBins < 0)
+  {
+    vtkErrorMacro("Update: Invalid number of histogram bins " << this->NumberOfHistogramBins);
+    return false;
+  }
+  if (this->InterpolatedSearch && !this->PassRateOnly)
+  {
+    vtkErrorMacro("Update: Interpolated search is only supported in pass rate only mode");
+    return false;
+  }
+  if ( this->Algorithm == AlgorithmMultiresolution && !this->PassRateOnly
+    && (this->NumberOfResolutionLevels < 1 || this->NumberOfResolutionLevels > 8) )
+  {
+    vtkErrorMacro("Update: Invalid number of resolution levels " << this->NumberOfResolutionLevels);
+    return false;
+  }
+
+  // Bring compare dose and mask to the geometry of the reference
+  vtkSmartPointer<vtkOrientedImageData> compareDose = this->InputCompareDose;
+  if (!vtkOrientedImageDataResample::DoGeometriesMatch(referenceDose, compareDose))
+  {
+    compareDose = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+      this->InputCompareDose, referenceDose, compareDose, true))
+    {
+      vtkErrorMacro("Update: Failed to resample compare dose to the geometry of the reference dose");
+      return false;
+    }
+  }
+  vtkSmartPointer<vtkOrientedImageData> mask = this->InputMask;
+  if (mask && mask->GetPointData()->GetScalars() && !vtkOrientedImageDataResample::DoGeometriesMatch(referenceDose, mask))
+  {
+    mask = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+      this->InputMask, referenceDose, mask, false))
+    {
+      vtkErrorMacro("Update: Failed to resample mask to the geometry of the reference dose");
+      return false;
+    }
+  }
+
+  int* extent = referenceDose->GetExtent();
+  std::vector<float> referenceBuffer;
+  const float* referenceValues = GetScalarsOnExtent(referenceDose, extent, referenceBuffer);
+  std::vector<float> compareBuffer;
+  const float* compareValues = GetScalarsOnExtent(compareDose, extent, compareBuffer);
+  std::vector<float> maskBuffer;
+  const float* maskValues = nullptr;
+  if (mask && mask->GetPointData()->GetScalars())
+  {
+    maskValues = GetScalarsOnExtent(mask, extent, maskBuffer);
+  }
+
+  GammaInput input;
+  referenceDose->GetDimensions(input.Dimensions);
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(input.Dimensions[0]) * input.Dimensions[1] * input.Dimensions[2];
+
+  // Dose tolerance and analysis threshold are relative to the prescription or the maximum dose
+  this->ReferenceDoseUsedGy = this->ReferenceDoseGy;
+  if (this->ReferenceDoseUsedGy <= 0.0)
+  {
+    this->ReferenceDoseUsedGy = *std::max_element(referenceValues, referenceValues + numberOfVoxels);
+  }
+  if (this->ReferenceDoseUsedGy <= 0.0)
+  {
+    vtkErrorMacro("Update: Reference dose is zero");
+    return false;
+  }
+
+  double* spacing = referenceDose->GetSpacing();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    input.NormalizedSpacing[axis] = spacing[axis] / this->DistanceToleranceMm;
+  }
+  input.Reference = referenceValues;
+  input.Compare = compareValues;
+  input.Mask = maskValues;
+  input.Threshold = static_cast<float>(this->AnalysisThreshold * this->ReferenceDoseUsedGy);
+  input.ThresholdOnReferenceOnly = this->ThresholdOnReferenceOnly;
+  double doseTolerance = this->DoseDifferenceTolerance * this->ReferenceDoseUsedGy;
+  input.InverseDoseToleranceSquared = 1.0 / (doseTolerance * doseTolerance);
+  input.LocalDoseTolerance = this->DoseDifferenceTolerance;
+  input.LocalMinimumDose = 1e-3 * this->ReferenceDoseUsedGy;
+  input.Local = this->LocalDoseDifference;
+  input.MaximumGammaSquared = this->MaximumGamma * this->MaximumGamma;
+  input.InterpolatedSearch = this->InterpolatedSearch;
+
+  // The search covers every voxel closer than the distance where the distance term reaches the maximum gamma
+  int searchRadius[3] = { 0, 0, 0 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    searchRadius[axis] = static_cast<int>(floor(this->MaximumGamma / input.NormalizedSpacing[axis]));
+  }
+  std::vector<SearchOffset> offsets;
+  GetSearchOffsets(input, searchRadius, offsets);
+
+  vtkNew<vtkTimerLog> timer;
+  if (this->PassRateOnly)
+  {
+    // Release the gamma image of a previous update
+    this->OutputGammaImage->Initialize();
+
+    double checkpointStart = timer->GetUniversalTime();
+    PassRateFunctor passRateFunctor(input, offsets, this->NumberOfHistogramBins, this->MaximumGamma);
+    vtkSMPTools::For(0, static_cast<vtkIdType>(input.Dimensions[1]) * input.Dimensions[2], passRateFunctor);
+    this->NumberOfAnalyzedVoxels = passRateFunctor.Result.NumberOfAnalyzedVoxels;
+    this->NumberOfPassingVoxels = passRateFunctor.Result.NumberOfPassingVoxels;
+    this->HistogramBinCounts = passRateFunctor.Result.HistogramBinCounts;
+    this->PassFraction = (this->NumberOfAnalyzedVoxels > 0
+      ? static_cast<double>(this->NumberOfPassingVoxels) / this->NumberOfAnalyzedVoxels : 0.0);
+    this->LevelEvaluatedFractions.push_back(this->NumberOfAnalyzedVoxels > 0 ? 1.0 : 0.0);
+    this->LevelTimes.push_back(timer->GetUniversalTime() - checkpointStart);
+    return true;
+  }
+
+  // Voxels above the threshold and inside the mask are analyzed
+  std::vector<unsigned char> voxelStates(numberOfVoxels, VoxelNotAnalyzed);
+  std::vector<vtkIdType> undecidedVoxels;
+  for (vtkIdType index = 0; index < numberOfVoxels; ++index)
+  {
+    if (input.IsAnalyzed(index))
+    {
+      voxelStates[index] = VoxelUndecided;
+      undecidedVoxels.push_back(index);
+    }
+  }
+  this->NumberOfAnalyzedVoxels = static_cast<vtkIdType>(undecidedVoxels.size());
+
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  referenceDose->GetImageToWorldMatrix(imageToWorldMatrix);
+  this->OutputGammaImage->SetExtent(extent);
+  this->OutputGammaImage->AllocateScalars(VTK_FLOAT, 1);
+  this->OutputGammaImage->SetImageToWorldMatrix(imageToWorldMatrix);
+  float* gammaPtr = static_cast<float*>(this->OutputGammaImage->GetScalarPointer());
+  std::fill(gammaPtr, gammaPtr + numberOfVoxels, 0.0f);
+
+  auto getVoxelIndex = [&input](vtkIdType index, int& i, int& j, int& k)
+  {
+    i = static_cast<int>(index % input.Dimensions[0]);
+    j = static_cast<int>((index / input.Dimensions[0]) % input.Dimensions[1]);
+    k = static_cast<int>(index / (static_cast<vtkIdType>(input.Dimensions[0]) * input.Dimensions[1]));
+  };
+  auto setGammaSquared = [&](vtkIdType index, double gammaSquared)
+  {
+    gammaPtr[index] = static_cast<float>(sqrt(gammaSquared));
+    voxelStates[index] = (gammaSquared <= 1.0 ? VoxelPassed : VoxelFailed);
+  };
+  // Keep only the undecided voxels in the list
+  auto removeDecidedVoxels = [&]()
+  {
+    undecidedVoxels.erase(std::remove_if(undecidedVoxels.begin(), undecidedVoxels.end(),
+      [&voxelStates](vtkIdType index) { return voxelStates[index] != VoxelUndecided; }), undecidedVoxels.end());
+  };
+  double numberOfAnalyzedVoxels = std::max(this->NumberOfAnalyzedVoxels, static_cast<vtkIdType>(1));
+
+  if (this->Algorithm == AlgorithmMultiresolution)
+  {
+    this->LevelEvaluatedFractions.resize(this->NumberOfResolutionLevels + 1, 0.0);
+    this->LevelTimes.resize(this->NumberOfResolutionLevels + 1, 0.0);
+
+    // Pyramid of the compare dose range is part of the time of the coarsest level
+    double checkpointStart = timer->GetUniversalTime();
+    std::vector<DoseBlockLevel> levels(this->NumberOfResolutionLevels + 1);
+    ComputeDoseBlockLevel(input.Compare, input.Compare, input.Dimensions, 2, levels[1]);
+    for (int level = 2; level <= this->NumberOfResolutionLevels; ++level)
+    {
+      ComputeDoseBlockLevel(levels[level-1].Minimum.data(), levels[level-1].Maximum.data(), levels[level-1].Dimensions,
+        1 << level, levels[level]);
+    }
+
+    // At the coarsest level, voxels pass if the compare dose at the same position is within the dose tolerance,
+    // and the gamma of these is found among the voxels within the distance tolerance. Other voxels fail if the
+    // lower bound of their gamma is above one
+    this->LevelEvaluatedFractions[this->NumberOfResolutionLevels] = undecidedVoxels.size() / numberOfAnalyzedVoxels;
+    const DoseBlockLevel& coarsestLevel = levels[this->NumberOfResolutionLevels];
+    vtkSMPTools::For(0, static_cast<vtkIdType>(undecidedVoxels.size()), [&](vtkIdType begin, vtkIdType end)
+    {
+      for (vtkIdType voxel = begin; voxel < end; ++voxel)
+      {
+        vtkIdType index = undecidedVoxels[voxel];
+        int i = 0, j = 0, k = 0;
+        getVoxelIndex(index, i, j, k);
+        double difference = input.Compare[index] - input.Reference[index];
+        double selfGammaSquared = difference * difference * input.GetInverseDoseToleranceSquared(input.Reference[index]);
+        if (selfGammaSquared <= 1.0)
+        {
+          setGammaSquared(index, ComputeGammaSquared(input, offsets, i, j, k, selfGammaSquared));
+          continue;
+        }
+        double lowerBound = ComputeGammaSquaredLowerBound(input, coarsestLevel, searchRadius, i, j, k, input.MaximumGammaSquared);
+        if (lowerBound > 1.0)
+        {
+          setGammaSquared(index, lowerBound);
+        }
+      }
+    });
+    removeDecidedVoxels();
+    this->LevelTimes[this->NumberOfResolutionLevels] = timer->GetUniversalTime() - checkpointStart;
+
+    // Refine the bound of the undecided voxels at the finer levels
+    for (int levelIndex = this->NumberOfResolutionLevels - 1; levelIndex >= 1; --levelIndex)
+    {
+      checkpointStart = timer->GetUniversalTime();
+      this->LevelEvaluatedFractions[levelIndex] = undecidedVoxels.size() / numberOfAnalyzedVoxels;
+      const DoseBlockLevel& level = levels[levelIndex];
+      vtkSMPTools::For(0, static_cast<vtkIdType>(undecidedVoxels.size()), [&](vtkIdType begin, vtkIdType end)
+      {
+        for (vtkIdType voxel = begin; voxel < end; ++voxel)
+        {
+          vtkIdType index = undecidedVoxels[voxel];
+          int i = 0, j = 0, k = 0;
+          getVoxelIndex(index, i, j, k);
+          double lowerBound = ComputeGammaSquaredLowerBound(input, level, searchRadius, i, j, k, input.MaximumGammaSquared);
+          if (lowerBound > 1.0)
+          {
+            setGammaSquared(index, lowerBound);
+          }
+        }
+      });
+      removeDecidedVoxels();
+      this->LevelTimes[levelIndex] = timer->GetUniversalTime() - checkpointStart;
+    }
+  }
+
+  // Search the remaining voxels at full resolution
+  double checkpointStart = timer->GetUniversalTime();
+  this->LevelEvaluatedFractions.resize(std::max(this->LevelEvaluatedFractions.size(), static_cast<size_t>(1)));
+  this->LevelTimes.resize(this->LevelEvaluatedFractions.size());
+  this->LevelEvaluatedFractions[0] = undecidedVoxels.size() / numberOfAnalyzedVoxels;
+  vtkSMPTools::For(0, static_cast<vtkIdType>(undecidedVoxels.size()), [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType voxel = begin; voxel < end; ++voxel)
+    {
+      vtkIdType index = undecidedVoxels[voxel];
+      int i = 0, j = 0, k = 0;
+      getVoxelIndex(index, i, j, k);
+      setGammaSquared(index, ComputeGammaSquared(input, offsets, i, j, k, input.MaximumGammaSquared));
+    }
+  });
+  this->LevelTimes[0] = timer->GetUniversalTime() - checkpointStart;
+
+  this->NumberOfPassingVoxels = std::count(voxelStates.begin(), voxelStates.end(), static_cast<unsigned char>(VoxelPassed));
+  this->PassFraction = (this->NumberOfAnalyzedVoxels > 0
+    ? static_cast<double>(this->NumberOfPassingVoxels) / this->NumberOfAnalyzedVoxels : 0.0);
+
+  this->OutputGammaImage->Modified();
+  return true;
+}
@@ -0,0 +1,239 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkGammaDoseComparisonFilter_h
+#define __vtkGammaDoseComparisonFilter_h
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "vtkSlicerDoseComparisonModuleLogicExport.h"
+
+// STD includes
+#include <vector>
+
+class vtkOrientedImageData;
+
+/// \ingroup SlicerRt_QtModules_DoseComparison
+/// \brief Compute gamma dose comparison of a compare dose against a reference dose.
+///
+/// Gamma of a reference voxel is the minimum over the compare voxels of
+///   sqrt( (distance / DTA)^2 + (dose difference / dose tolerance)^2 )
+/// clamped to the maximum gamma. The compare voxels are searched on the grid of the reference
+/// (nearest neighbor search, as plastimatch without interpolated search), within the distance at
+/// which gamma reaches the maximum, nearest first. The dose tolerance is a fraction of the reference
+/// dose (global), or of the reference voxel dose (local). Only voxels above the analysis threshold
+/// and inside the mask are analyzed, gamma is zero elsewhere.
+///
+/// The multiresolution algorithm builds a pyramid of the minimum and maximum compare dose in blocks
+/// of 2^level voxels. Starting at the coarsest level, a lower bound of gamma is computed for each voxel
+/// from the blocks within the distance tolerance, and the voxels with a bound above one fail without
+/// further search. Voxels whose gamma at zero distance is not above one pass. Only the voxels whose
+/// bound straddles one are refined at the finer levels and searched at full resolution. The pass/fail
+/// map and the pass fraction are the same as with the exhaustive search. Gamma is exact for the passing
+/// and refined voxels, and is the lower bound for the voxels that fail at a coarse level.
+///
+/// In pass rate only mode the gamma image is not computed. The reference voxels are processed row by row,
+/// and the search of a voxel stops as soon as its pass/fail result (and histogram bin) is known, which for
+/// a failing voxel means the tolerance ellipsoid is searched, and for a passing voxel that a compare voxel
+/// with gamma not above one is found. Only the counts and the histogram are accumulated. In this mode the
+/// search can also be interpolated (geometric gamma, as plastimatch with interpolated search): the compare
+/// dose is linearly interpolated along the edges between each searched voxel and its face neighbors, and
+/// gamma is the minimum over these edges. As the distance along a grid edge is not smaller than at the
+/// nearer end, the search still stops at the same distance.
+///
+/// If the compare dose or the mask has a different geometry than the reference dose, it is resampled
+/// to the geometry of the reference (linear interpolation for the dose, nearest neighbor for the mask).
+/// Voxels are processed in parallel.
+///
+/// Similarly to the segment comparison filters, this class is not a VTK pipeline filter.
+class VTK_SLICER_DOSECOMPARISON_LOGIC_EXPORT vtkGammaDoseComparisonFilter : public vtkObject
+{
+public:
+  enum
+  {
+    /// Search every analyzed voxel up to the maximum gamma
+    AlgorithmExhaustive = 0,
+    /// Decide pass/fail from a pyramid of the compare dose and search only the undecided voxels
+    AlgorithmMultiresolution
+  };
+
+public:
+  static vtkGammaDoseComparisonFilter *New();
+  vtkTypeMacro(vtkGammaDoseComparisonFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set reference dose
+  void SetInputReferenceDose(vtkOrientedImageData* dose);
+  /// Get reference dose
+  vtkOrientedImageData* GetInputReferenceDose();
+
+  /// Set compare dose
+  void SetInputCompareDose(vtkOrientedImageData* dose);
+  /// Get compare dose
+  vtkOrientedImageData* GetInputCompareDose();
+
+  /// Set mask labelmap (optional). Only voxels with nonzero mask value are analyzed
+  void SetInputMask(vtkOrientedImageData* mask);
+  /// Get mask labelmap
+  vtkOrientedImageData* GetInputMask();
+
+  /// Get/Set distance to agreement (DTA) tolerance in mm. 3 by default
+  vtkGetMacro(DistanceToleranceMm, double);
+  vtkSetMacro(DistanceToleranceMm, double);
+
+  /// Get/Set dose difference tolerance as a fraction of the reference dose (global), or of the reference
+  /// voxel dose (local). 0.03 by default
+  vtkGetMacro(DoseDifferenceTolerance, double);
+  vtkSetMacro(DoseDifferenceTolerance, double);
+
+  /// Get/Set reference dose (prescription dose) in Gy. The maximum of the reference dose is used if
+  /// not positive. 0 by default
+  vtkGetMacro(ReferenceDoseGy, double);
+  vtkSetMacro(ReferenceDoseGy, double);
+
+  /// Get/Set analysis threshold as a fraction of the reference dose. 0.1 by default
+  vtkGetMacro(AnalysisThreshold, double);
+  vtkSetMacro(AnalysisThreshold, double);
+
+  /// Get/Set maximum gamma. Gamma is clamped to this value, which limits the search distance. 2 by default
+  vtkGetMacro(MaximumGamma, double);
+  vtkSetMacro(MaximumGamma, double);
+
+  /// Get/Set local dose difference flag. Global dose difference is used by default
+  vtkGetMacro(LocalDoseDifference, bool);
+  vtkSetMacro(LocalDoseDifference, bool);
+  vtkBooleanMacro(LocalDoseDifference, bool);
+
+  /// Get/Set flag determining whether the analysis threshold is applied to the reference dose only.
+  /// By default voxels are analyzed if either dose is above the threshold
+  vtkGetMacro(ThresholdOnReferenceOnly, bool);
+  vtkSetMacro(ThresholdOnReferenceOnly, bool);
+  vtkBooleanMacro(ThresholdOnReferenceOnly, bool);
+
+  /// Get/Set algorithm. Exhaustive search by default
+  vtkGetMacro(Algorithm, int);
+  vtkSetMacro(Algorithm, int);
+
+  /// Get/Set number of coarse levels of the multiresolution algorithm. Blocks of the coarsest
+  /// level contain 2^NumberOfResolutionLevels voxels along each axis. 2 by default
+  vtkGetMacro(NumberOfResolutionLevels, int);
+  vtkSetMacro(NumberOfResolutionLevels, int);
+
+  /// Get/Set pass rate only flag. If enabled, only the pass fraction, the voxel counts and the histogram
+  /// are computed, the gamma image is not allocated and the algorithm is ignored. Off by default
+  vtkGetMacro(PassRateOnly, bool);
+  vtkSetMacro(PassRateOnly, bool);
+  vtkBooleanMacro(PassRateOnly, bool);
+
+  /// Get/Set interpolated search flag. If enabled, the compare dose is linearly interpolated between the voxels
+  /// (geometric gamma). Only supported in pass rate only mode. Off (nearest neighbor search) by default
+  vtkGetMacro(InterpolatedSearch, bool);
+  vtkSetMacro(InterpolatedSearch, bool);
+  vtkBooleanMacro(InterpolatedSearch, bool);
+
+  /// Get/Set number of bins of the gamma histogram computed in pass rate only mode. The bins divide the
+  /// range from zero to the maximum gamma uniformly, and contain their upper bound. 0 (no histogram) by default
+  vtkGetMacro(NumberOfHistogramBins, int);
+  vtkSetMacro(NumberOfHistogramBins, int);
+
+  /// Compute gamma
+  /// \return Success flag
+  bool Update();
+
+  /// Get gamma image. It has the geometry of the reference dose
+  vtkOrientedImageData* GetOutputGammaImage();
+
+  /// Get fraction of the analyzed voxels that pass (gamma not above one)
+  double GetPassFraction() { return this->PassFraction; };
+  /// Get number of analyzed voxels
+  vtkIdType GetNumberOfAnalyzedVoxels() { return this->NumberOfAnalyzedVoxels; };
+  /// Get number of passing voxels
+  vtkIdType GetNumberOfPassingVoxels() { return this->NumberOfPassingVoxels; };
+  /// Get reference dose the tolerance and the threshold are relative to, in Gy
+  double GetReferenceDoseUsedGy() { return this->ReferenceDoseUsedGy; };
+
+  /// Get number of evaluated resolution levels. Level 0 is the full resolution search,
+  /// level L uses blocks of 2^L voxels
+  int GetNumberOfEvaluatedLevels() { return static_cast<int>(this->LevelEvaluatedFractions.size()); };
+  /// Get fraction of the analyzed voxels that were evaluated at a resolution level
+  double GetLevelEvaluatedFraction(int level);
+  /// Get time spent at a resolution level in seconds
+  double GetLevelTime(int level);
+
+  /// Get number of analyzed voxels in a bin of the gamma histogram. Only computed in pass rate only mode
+  vtkIdType GetHistogramBinCount(int bin);
+
+protected:
+  vtkGammaDoseComparisonFilter();
+  ~vtkGammaDoseComparisonFilter() override;
+
+protected:
+  /// Reference dose
+  vtkSmartPointer<vtkOrientedImageData> InputReferenceDose;
+  /// Compare dose
+  vtkSmartPointer<vtkOrientedImageData> InputCompareDose;
+  /// Mask labelmap
+  vtkSmartPointer<vtkOrientedImageData> InputMask;
+  /// Gamma image
+  vtkSmartPointer<vtkOrientedImageData> OutputGammaImage;
+
+  /// Distance to agreement tolerance in mm
+  double DistanceToleranceMm;
+  /// Dose difference tolerance (fraction)
+  double DoseDifferenceTolerance;
+  /// Reference dose in Gy, maximum dose if not positive
+  double ReferenceDoseGy;
+  /// Analysis threshold (fraction)
+  double AnalysisThreshold;
+  /// Maximum gamma
+  double MaximumGamma;
+  /// Local dose difference flag
+  bool LocalDoseDifference;
+  /// Threshold on reference only flag
+  bool ThresholdOnReferenceOnly;
+  /// Algorithm
+  int Algorithm;
+  /// Number of coarse levels of the multiresolution algorithm
+  int NumberOfResolutionLevels;
+  /// Pass rate only flag
+  bool PassRateOnly;
+  /// Interpolated search flag
+  bool InterpolatedSearch;
+  /// Number of gamma histogram bins
+  int NumberOfHistogramBins;
+
+  /// Pass fraction
+  double PassFraction;
+  /// Number of analyzed voxels
+  vtkIdType NumberOfAnalyzedVoxels;
+  /// Number of passing voxels
+  vtkIdType NumberOfPassingVoxels;
+  /// Reference dose used
+  double ReferenceDoseUsedGy;
+  /// Fraction of the analyzed voxels evaluated at each resolution level
+  std::vector<double> LevelEvaluatedFractions;
+  /// Time spent at each resolution level
+  std::vector<double> LevelTimes;
+  /// Number of analyzed voxels in each gamma histogram bin
+  std::vector<vtkIdType> HistogramBinCounts;
+
+private:
+  vtkGammaDoseComparisonFilter(const vtkGammaDoseComparisonFilter&) = delete;
+  void operator=(const vtkGammaDoseComparisonFilter&) = delete;
+};
+
+#endif
@@ -58,6 +58,10 @@ vtkMRMLDoseComparisonNode::vtkMRMLDoseComparisonNode()
   this->ResultsValid = false;
   this->ReportString = nullptr;
   this->LocalDoseDifference = false;
+  this->GammaAlgorithm = GammaAlgorithmPlastimatch;
+  this->PassRateOnly = false;
+  this->NumberOfGammaHistogramBins = 0;
+  this->PlanarShiftSearchRangeMm = 0.0;
 
   this->HideFromEditors = false;
 }
@@ -84,6 +88,10 @@ void vtkMRMLDoseComparisonNode::WriteXML(ostream& of, int nIndent)
   of << " UseGeometricGammaCalculation=\"" << (this->UseGeometricGammaCalculation ? "true" : "false") << "\"";
   of << " LocalDoseDifference=\"" << (this->LocalDoseDifference ? "true" : "false") << "\"";
   of << " DoseThresholdOnReferenceOnly=\"" << (this->DoseThresholdOnReferenceOnly ? "true" : "false") << "\"";
+  of << " GammaAlgorithm=\"" << this->GammaAlgorithm << "\"";
+  of << " PassRateOnly=\"" << (this->PassRateOnly ? "true" : "false") << "\"";
+  of << " NumberOfGammaHistogramBins=\"" << this->NumberOfGammaHistogramBins << "\"";
+  of << " PlanarShiftSearchRangeMm=\"" << this->PlanarShiftSearchRangeMm << "\"";
   of << " PassFractionPercent=\"" << this->PassFractionPercent << "\"";
   of << " ResultsValid=\"" << (this->ResultsValid ? "true" : "false") << "\"";
   of << " ReportString=\"" << (this->ReportString ? this->ReportString : "") << "\"";
@@ -143,6 +151,22 @@ void vtkMRMLDoseComparisonNode::ReadXMLAttributes(const char** atts)
       {
       this->DoseThresholdOnReferenceOnly = (strcmp(attValue,"true") ? false : true);
       }
+    else if (!strcmp(attName, "GammaAlgorithm"))
+      {
+      this->GammaAlgorithm = vtkVariant(attValue).ToInt();
+      }
+    else if (!strcmp(attName, "PassRateOnly"))
+      {
+      this->PassRateOnly = (strcmp(attValue,"true") ? false : true);
+      }
+    else if (!strcmp(attName, "NumberOfGammaHistogramBins"))
+      {
+      this->NumberOfGammaHistogramBins = vtkVariant(attValue).ToInt();
+      }
+    else if (!strcmp(attName, "PlanarShiftSearchRangeMm"))
+      {
+      this->PlanarShiftSearchRangeMm = vtkVariant(attValue).ToDouble();
+      }
     else if (!strcmp(attName, "PassFractionPercent"))
       {
       this->PassFractionPercent = vtkVariant(attValue).ToDouble();
@@ -177,6 +201,10 @@ void vtkMRMLDoseComparisonNode::Copy(vtkMRMLNode *anode)
   this->UseGeometricGammaCalculation = node->UseGeometricGammaCalculation;
   this->LocalDoseDifference = node->LocalDoseDifference;
   this->DoseThresholdOnReferenceOnly = node->DoseThresholdOnReferenceOnly;
+  this->GammaAlgorithm = node->GammaAlgorithm;
+  this->PassRateOnly = node->PassRateOnly;
+  this->NumberOfGammaHistogramBins = node->NumberOfGammaHistogramBins;
+  this->PlanarShiftSearchRangeMm = node->PlanarShiftSearchRangeMm;
   this->ResultsValid = node->ResultsValid;
   this->ReportString = node->ReportString;
 
@@ -199,6 +227,10 @@ void vtkMRMLDoseComparisonNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "UseGeometricGammaCalculation:   " << (this->UseGeometricGammaCalculation ? "true" : "false") << "\n";
   os << indent << "LocalDoseDifference:   " << (this->LocalDoseDifference ? "true" : "false") << "\n";
   os << indent << "DoseThresholdOnReferenceOnly:   " << (this->DoseThresholdOnReferenceOnly ? "true" : "false") << "\n";
+  os << indent << "GammaAlgorithm:   " << this->GammaAlgorithm << "\n";
+  os << indent << "PassRateOnly:   " << (this->PassRateOnly ? "true" : "false") << "\n";
+  os << indent << "NumberOfGammaHistogramBins:   " << this->NumberOfGammaHistogramBins << "\n";
+  os << indent << "PlanarShiftSearchRangeMm:   " << this->PlanarShiftSearchRangeMm << "\n";
   os << indent << "PassFractionPercent:   " << this->PassFractionPercent << "\n";
   os << indent << "ResultsValid:   " << (this->ResultsValid ? "true" : "false") << "\n";
   os << indent << "ReportString:   " << (this->ReportString ? this->ReportString : "") << "\n";
@@ -37,6 +37,17 @@ class vtkMRMLSegmentationNode;
 /// \ingroup SlicerRt_QtModules_DoseComparison
 class VTK_SLICER_DOSECOMPARISON_LOGIC_EXPORT vtkMRMLDoseComparisonNode : public vtkMRMLNode
 {
+public:
+  enum
+  {
+    /// Gamma computed by plastimatch
+    GammaAlgorithmPlastimatch = 0,
+    /// Coarse-to-fine gamma search, see \sa vtkGammaDoseComparisonFilter
+    GammaAlgorithmMultiresolution,
+    /// 2D gamma of planar dose images with interpolated search, see \sa vtkPlanarGammaDoseComparisonFilter
+    GammaAlgorithmPlanar
+  };
+
 public:
   static vtkMRMLDoseComparisonNode *New();
   vtkTypeMacro(vtkMRMLDoseComparisonNode,vtkMRMLNode);
@@ -136,6 +147,28 @@ public:
   /// Set local dose difference flag
   vtkBooleanMacro(LocalDoseDifference, bool);
 
+  /// Get gamma algorithm
+  vtkGetMacro(GammaAlgorithm, int);
+  /// Set gamma algorithm
+  vtkSetMacro(GammaAlgorithm, int);
+
+  /// Get pass rate only flag
+  vtkGetMacro(PassRateOnly, bool);
+  /// Set pass rate only flag
+  vtkSetMacro(PassRateOnly, bool);
+  /// Set pass rate only flag
+  vtkBooleanMacro(PassRateOnly, bool);
+
+  /// Get number of gamma histogram bins in pass rate only mode
+  vtkGetMacro(NumberOfGammaHistogramBins, int);
+  /// Set number of gamma histogram bins in pass rate only mode
+  vtkSetMacro(NumberOfGammaHistogramBins, int);
+
+  /// Get shift search range of planar gamma in mm
+  vtkGetMacro(PlanarShiftSearchRangeMm, double);
+  /// Set shift search range of planar gamma in mm
+  vtkSetMacro(PlanarShiftSearchRangeMm, double);
+
   /// Get valid flag
   vtkGetMacro(ResultsValid, bool);
   /// Set valid flag
@@ -200,6 +233,27 @@ protected:
   /// Default value is false, meaning that both images will be used
   bool DoseThresholdOnReferenceOnly;
 
+  /// Algorithm computing the gamma. Plastimatch by default.
+  /// The multiresolution algorithm only evaluates the voxels whose pass/fail result cannot be decided from
+  /// a coarse resolution dose, and uses nearest neighbor search regardless of \sa UseGeometricGammaCalculation.
+  /// The planar algorithm requires single slice dose volumes, such as RT images, and does not support a mask
+  int GammaAlgorithm;
+
+  /// Flag determining whether only the pass rate and summary statistics are computed. If enabled, the gamma
+  /// volume is not created. The search of each voxel stops as soon as its pass/fail result and histogram bin are known,
+  /// regardless of \sa GammaAlgorithm, except for the planar algorithm, which is used as is. The compare dose is
+  /// interpolated between the voxels if \sa UseGeometricGammaCalculation is enabled, similarly to plastimatch.
+  /// Default value is false
+  bool PassRateOnly;
+
+  /// Number of bins of the gamma histogram added to the report in pass rate only mode.
+  /// The bins divide the range from zero to the maximum gamma uniformly. Default value is 0 (no histogram)
+  int NumberOfGammaHistogramBins;
+
+  /// Maximum shift of the compare dose along each axis of the plane in mm, searched by the planar algorithm to
+  /// compensate the setup error of a measured image. Default value is 0 (no shift search)
+  double PlanarShiftSearchRangeMm;
+
   /// Percentage of voxels that passed (output)
   double PassFractionPercent;
 
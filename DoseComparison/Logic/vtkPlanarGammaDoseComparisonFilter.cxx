@@ -0,0 +1,649 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkPlanarGammaDoseComparisonFilter.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+/// Maximum number of compare dose samples per pixel along an axis
+const int MAXIMUM_NUMBER_OF_SAMPLES_PER_PIXEL = 16;
+/// Maximum number of pixels the dose difference of a shift is computed on
+const size_t MAXIMUM_NUMBER_OF_SHIFT_SEARCH_PIXELS = 65536;
+/// Distance in compare pixels a sample may be outside the compare image, to tolerate round-off on the border
+const double COMPARE_BORDER_TOLERANCE = 1e-3;
+
+//----------------------------------------------------------------------------
+/// Reference and compare dose on their own pixels, and the gamma criteria
+struct PlanarGammaInput
+{
+  int Dimensions[2];
+  const float* Reference;
+  const float* Compare;
+  int CompareDimensions[2];
+  /// Position of reference pixel (i, j) in compare pixel coordinates is CompareOrigin + i*ColumnStep + j*RowStep.
+  /// The reference pixels are projected onto the compare plane along its normal
+  double CompareOrigin[2];
+  double ColumnStep[2];
+  double RowStep[2];
+  /// Analysis threshold in Gy
+  float Threshold;
+  bool ThresholdOnReferenceOnly;
+  /// Squared inverse of the global dose tolerance in Gy
+  double InverseDoseToleranceSquared;
+  /// Dose tolerance fraction and minimum dose for local dose difference. Not used for global dose difference
+  double LocalDoseTolerance;
+  double LocalMinimumDose;
+  bool Local;
+  double MaximumGammaSquared;
+
+  double GetInverseDoseToleranceSquared(double referenceValue) const
+  {
+    if (!this->Local)
+    {
+      return this->InverseDoseToleranceSquared;
+    }
+    double doseTolerance = this->LocalDoseTolerance * std::max(referenceValue, this->LocalMinimumDose);
+    return 1.0 / (doseTolerance * doseTolerance);
+  }
+};
+
+//----------------------------------------------------------------------------
+/// Compare dose sample at a sub-pixel offset from a reference pixel
+struct SampleOffset
+{
+  /// Offset of the sample from the position of the reference pixel, in compare pixel coordinates
+  double CompareOffset[2];
+  /// Squared distance divided by the squared distance tolerance
+  double DistanceTerm;
+};
+
+//----------------------------------------------------------------------------
+/// Get the offset of a sample from its position in samples along the reference axes, a sample being a fraction
+/// of a reference pixel
+SampleOffset GetSampleOffset(const PlanarGammaInput& input, int u, int v, int samplesPerPixel)
+{
+  SampleOffset offset;
+  double column = static_cast<double>(u) / samplesPerPixel;
+  double row = static_cast<double>(v) / samplesPerPixel;
+  for (int axis = 0; axis < 2; ++axis)
+  {
+    offset.CompareOffset[axis] = column * input.ColumnStep[axis] + row * input.RowStep[axis];
+  }
+  offset.DistanceTerm = 0.0;
+  return offset;
+}
+
+//----------------------------------------------------------------------------
+/// Interpolate the compare dose bilinearly between its pixels at a sample offset from a reference pixel
+/// \return False if the sample is outside the compare dose
+inline bool SampleCompareDose(const PlanarGammaInput& input, int i, int j, const SampleOffset& offset, double& value)
+{
+  double x = input.CompareOrigin[0] + i * input.ColumnStep[0] + j * input.RowStep[0] + offset.CompareOffset[0];
+  double y = input.CompareOrigin[1] + i * input.ColumnStep[1] + j * input.RowStep[1] + offset.CompareOffset[1];
+  if ( x < -COMPARE_BORDER_TOLERANCE || x > input.CompareDimensions[0] - 1 + COMPARE_BORDER_TOLERANCE
+    || y < -COMPARE_BORDER_TOLERANCE || y > input.CompareDimensions[1] - 1 + COMPARE_BORDER_TOLERANCE )
+  {
+    return false;
+  }
+  x = std::min(std::max(x, 0.0), input.CompareDimensions[0] - 1.0);
+  y = std::min(std::max(y, 0.0), input.CompareDimensions[1] - 1.0);
+  int x0 = static_cast<int>(x);
+  int y0 = static_cast<int>(y);
+  int x1 = std::min(x0 + 1, input.CompareDimensions[0] - 1);
+  int y1 = std::min(y0 + 1, input.CompareDimensions[1] - 1);
+  double fractionX = x - x0;
+  double fractionY = y - y0;
+  const float* row0 = input.Compare + static_cast<vtkIdType>(y0) * input.CompareDimensions[0];
+  const float* row1 = input.Compare + static_cast<vtkIdType>(y1) * input.CompareDimensions[0];
+  double value0 = row0[x0] + fractionX * (row0[x1] - row0[x0]);
+  double value1 = row1[x0] + fractionX * (row1[x1] - row1[x0]);
+  value = value0 + fractionY * (value1 - value0);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Get the samples within the distance where the distance term reaches the maximum gamma, nearest first.
+/// The compare dose is sampled with a shift given in samples, which does not contribute to the distance
+void GetSampleOffsets(const PlanarGammaInput& input, const double normalizedSampleSpacing[2], int samplesPerPixel,
+  const int shift[2], std::vector<SampleOffset>& offsets)
+{
+  offsets.clear();
+  double maximumGamma = sqrt(input.MaximumGammaSquared);
+  int searchRadius[2] = { 0, 0 };
+  for (int axis = 0; axis < 2; ++axis)
+  {
+    searchRadius[axis] = static_cast<int>(floor(maximumGamma / normalizedSampleSpacing[axis]));
+  }
+  for (int v = -searchRadius[1]; v <= searchRadius[1]; ++v)
+  {
+    for (int u = -searchRadius[0]; u <= searchRadius[0]; ++u)
+    {
+      double x = u * normalizedSampleSpacing[0];
+      double y = v * normalizedSampleSpacing[1];
+      double distanceTerm = x * x + y * y;
+      if (distanceTerm >= input.MaximumGammaSquared)
+      {
+        continue;
+      }
+      SampleOffset offset = GetSampleOffset(input, u + shift[0], v + shift[1], samplesPerPixel);
+      offset.DistanceTerm = distanceTerm;
+      offsets.push_back(offset);
+    }
+  }
+  std::stable_sort(offsets.begin(), offsets.end(),
+    [](const SampleOffset& a, const SampleOffset& b) { return a.DistanceTerm < b.DistanceTerm; });
+}
+
+//----------------------------------------------------------------------------
+/// Analyzed and passing pixel counts
+struct PlanarGammaAccumulator
+{
+  vtkIdType NumberOfAnalyzedPixels{0};
+  vtkIdType NumberOfPassingPixels{0};
+};
+
+//----------------------------------------------------------------------------
+/// Computes the gamma of the rows of the reference in parallel, and counts the analyzed and passing pixels
+class PlanarGammaFunctor
+{
+public:
+  PlanarGammaFunctor(const PlanarGammaInput& input, const std::vector<SampleOffset>& offsets, float* gamma)
+    : Input(input)
+    , Offsets(offsets)
+    , Gamma(gamma)
+  {
+  }
+
+  void Initialize()
+  {
+    this->LocalAccumulator.Local() = PlanarGammaAccumulator();
+  }
+
+  void operator()(vtkIdType beginRow, vtkIdType endRow)
+  {
+    PlanarGammaAccumulator& accumulator = this->LocalAccumulator.Local();
+    // The nearest sample is the compare dose at the position of the reference pixel
+    const SampleOffset& pixelOffset = this->Offsets.front();
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+    {
+      int j = static_cast<int>(row);
+      vtkIdType index = row * this->Input.Dimensions[0];
+      for (int i = 0; i < this->Input.Dimensions[0]; ++i, ++index)
+      {
+        double referenceValue = this->Input.Reference[index];
+        double compareValue = 0.0;
+        SampleCompareDose(this->Input, i, j, pixelOffset, compareValue);
+        if ( referenceValue < this->Input.Threshold
+          && (this->Input.ThresholdOnReferenceOnly || compareValue < this->Input.Threshold) )
+        {
+          this->Gamma[index] = 0.0f;
+          continue;
+        }
+
+        double inverseDoseToleranceSquared = this->Input.GetInverseDoseToleranceSquared(referenceValue);
+        double best = this->Input.MaximumGammaSquared;
+        for (const SampleOffset& offset : this->Offsets)
+        {
+          if (offset.DistanceTerm >= best)
+          {
+            break;
+          }
+          double value = 0.0;
+          if (!SampleCompareDose(this->Input, i, j, offset, value))
+          {
+            continue;
+          }
+          double difference = value - referenceValue;
+          best = std::min(best, offset.DistanceTerm + difference * difference * inverseDoseToleranceSquared);
+        }
+        this->Gamma[index] = static_cast<float>(sqrt(best));
+        ++accumulator.NumberOfAnalyzedPixels;
+        if (best <= 1.0)
+        {
+          ++accumulator.NumberOfPassingPixels;
+        }
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    this->Result = PlanarGammaAccumulator();
+    for (vtkSMPThreadLocal<PlanarGammaAccumulator>::iterator localIt = this->LocalAccumulator.begin();
+      localIt != this->LocalAccumulator.end(); ++localIt)
+    {
+      this->Result.NumberOfAnalyzedPixels += (*localIt).NumberOfAnalyzedPixels;
+      this->Result.NumberOfPassingPixels += (*localIt).NumberOfPassingPixels;
+    }
+  }
+
+  PlanarGammaAccumulator Result;
+
+private:
+  const PlanarGammaInput& Input;
+  const std::vector<SampleOffset>& Offsets;
+  float* Gamma;
+  vtkSMPThreadLocal<PlanarGammaAccumulator> LocalAccumulator;
+};
+
+//----------------------------------------------------------------------------
+/// Mean squared difference between the compare dose sampled at an offset and the reference dose of a set of pixels
+/// \return False if less than half of the pixels can be sampled
+bool ComputeMeanSquaredDifference(const PlanarGammaInput& input, const std::vector<vtkIdType>& pixels,
+  const SampleOffset& offset, double& meanSquaredDifference)
+{
+  double sum = 0.0;
+  size_t numberOfSamples = 0;
+  for (vtkIdType index : pixels)
+  {
+    int i = static_cast<int>(index % input.Dimensions[0]);
+    int j = static_cast<int>(index / input.Dimensions[0]);
+    double value = 0.0;
+    if (!SampleCompareDose(input, i, j, offset, value))
+    {
+      continue;
+    }
+    double difference = value - input.Reference[index];
+    sum += difference * difference;
+    ++numberOfSamples;
+  }
+  if (numberOfSamples == 0 || 2 * numberOfSamples < pixels.size())
+  {
+    return false;
+  }
+  meanSquaredDifference = sum / numberOfSamples;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Set the shift to the candidate with the smallest mean squared difference. Candidate shifts are pairs of
+/// positions in samples. The shift is not changed if none of the candidates can be evaluated
+void FindBestShift(const PlanarGammaInput& input, const std::vector<vtkIdType>& pixels, int samplesPerPixel,
+  const std::vector<int>& candidateShifts, int shift[2])
+{
+  vtkIdType numberOfCandidates = static_cast<vtkIdType>(candidateShifts.size() / 2);
+  if (numberOfCandidates == 0)
+  {
+    return;
+  }
+  std::vector<double> meanSquaredDifferences(numberOfCandidates, VTK_DOUBLE_MAX);
+  vtkSMPTools::For(0, numberOfCandidates, [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType candidate = begin; candidate < end; ++candidate)
+    {
+      SampleOffset offset = GetSampleOffset(input, candidateShifts[2*candidate], candidateShifts[2*candidate+1], samplesPerPixel);
+      double meanSquaredDifference = 0.0;
+      if (ComputeMeanSquaredDifference(input, pixels, offset, meanSquaredDifference))
+      {
+        meanSquaredDifferences[candidate] = meanSquaredDifference;
+      }
+    }
+  });
+  size_t bestCandidate = std::min_element(meanSquaredDifferences.begin(), meanSquaredDifferences.end()) - meanSquaredDifferences.begin();
+  if (meanSquaredDifferences[bestCandidate] == VTK_DOUBLE_MAX)
+  {
+    return;
+  }
+  shift[0] = candidateShifts[2*bestCandidate];
+  shift[1] = candidateShifts[2*bestCandidate+1];
+}
+
+//----------------------------------------------------------------------------
+/// Find the shift of the compare dose in samples within the search range that minimizes the mean squared dose
+/// difference of the reference pixels above the threshold. Whole pixel shifts are searched first, then the
+/// samples around the best one
+void FindShift(const PlanarGammaInput& input, int samplesPerPixel, const int searchRange[2], int shift[2])
+{
+  shift[0] = 0;
+  shift[1] = 0;
+
+  // Pixels above the threshold, thinned out evenly to limit the cost of evaluating a shift
+  std::vector<vtkIdType> pixels;
+  vtkIdType numberOfPixels = static_cast<vtkIdType>(input.Dimensions[0]) * input.Dimensions[1];
+  for (vtkIdType index = 0; index < numberOfPixels; ++index)
+  {
+    if (input.Reference[index] >= input.Threshold)
+    {
+      pixels.push_back(index);
+    }
+  }
+  size_t stride = (pixels.size() + MAXIMUM_NUMBER_OF_SHIFT_SEARCH_PIXELS - 1) / MAXIMUM_NUMBER_OF_SHIFT_SEARCH_PIXELS;
+  if (stride > 1)
+  {
+    size_t numberOfSelectedPixels = 0;
+    for (size_t pixel = 0; pixel < pixels.size(); pixel += stride)
+    {
+      pixels[numberOfSelectedPixels++] = pixels[pixel];
+    }
+    pixels.resize(numberOfSelectedPixels);
+  }
+  if (pixels.empty())
+  {
+    return;
+  }
+
+  std::vector<int> candidateShifts;
+  int pixelSearchRange[2] = { searchRange[0] / samplesPerPixel, searchRange[1] / samplesPerPixel };
+  for (int v = -pixelSearchRange[1]; v <= pixelSearchRange[1]; ++v)
+  {
+    for (int u = -pixelSearchRange[0]; u <= pixelSearchRange[0]; ++u)
+    {
+      candidateShifts.push_back(u * samplesPerPixel);
+      candidateShifts.push_back(v * samplesPerPixel);
+    }
+  }
+  FindBestShift(input, pixels, samplesPerPixel, candidateShifts, shift);
+
+  candidateShifts.clear();
+  int pixelShift[2] = { shift[0], shift[1] };
+  for (int v = std::max(pixelShift[1] - samplesPerPixel + 1, -searchRange[1]);
+    v <= std::min(pixelShift[1] + samplesPerPixel - 1, searchRange[1]); ++v)
+  {
+    for (int u = std::max(pixelShift[0] - samplesPerPixel + 1, -searchRange[0]);
+      u <= std::min(pixelShift[0] + samplesPerPixel - 1, searchRange[0]); ++u)
+    {
+      candidateShifts.push_back(u);
+      candidateShifts.push_back(v);
+    }
+  }
+  FindBestShift(input, pixels, samplesPerPixel, candidateShifts, shift);
+}
+
+//----------------------------------------------------------------------------
+/// Get the in-plane axes of a planar image, in ascending order. The normal of the image is the last axis
+/// along which it has a single pixel
+/// \return False if the image is not planar
+bool GetPlanarAxes(vtkOrientedImageData* image, int axes[2])
+{
+  int dimensions[3] = { 0, 0, 0 };
+  image->GetDimensions(dimensions);
+  int normalAxis = -1;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (dimensions[axis] == 1)
+    {
+      normalAxis = axis;
+    }
+  }
+  if (normalAxis < 0)
+  {
+    return false;
+  }
+  int inPlaneAxis = 0;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (axis != normalAxis)
+    {
+      axes[inPlaneAxis++] = axis;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Get the scalars of an image as float. Single component float images are used in place, other images are
+/// copied to the buffer
+/// \return Pointer to the scalars
+const float* GetScalarsAsFloat(vtkOrientedImageData* image, std::vector<float>& values)
+{
+  if (image->GetScalarType() == VTK_FLOAT && image->GetNumberOfScalarComponents() == 1)
+  {
+    return static_cast<const float*>(image->GetScalarPointer());
+  }
+  vtkDataArray* scalars = image->GetPointData()->GetScalars();
+  values.resize(scalars->GetNumberOfTuples());
+  for (vtkIdType index = 0; index < scalars->GetNumberOfTuples(); ++index)
+  {
+    values[index] = static_cast<float>(scalars->GetComponent(index, 0));
+  }
+  return values.data();
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkPlanarGammaDoseComparisonFilter);
+
+//----------------------------------------------------------------------------
+vtkPlanarGammaDoseComparisonFilter::vtkPlanarGammaDoseComparisonFilter()
+  : DistanceToleranceMm(3.0)
+  , DoseDifferenceTolerance(0.03)
+  , ReferenceDoseGy(0.0)
+  , AnalysisThreshold(0.1)
+  , MaximumGamma(2.0)
+  , LocalDoseDifference(false)
+  , ThresholdOnReferenceOnly(false)
+  , SearchStepFraction(0.1)
+  , ShiftSearchRangeMm(0.0)
+  , PassFraction(0.0)
+  , NumberOfAnalyzedPixels(0)
+  , NumberOfPassingPixels(0)
+  , ReferenceDoseUsedGy(0.0)
+  , NumberOfSamplesPerPixel(0)
+{
+  this->ShiftMm[0] = 0.0;
+  this->ShiftMm[1] = 0.0;
+  this->OutputGammaImage = vtkSmartPointer<vtkOrientedImageData>::New();
+}
+
+//----------------------------------------------------------------------------
+vtkPlanarGammaDoseComparisonFilter::~vtkPlanarGammaDoseComparisonFilter() = default;
+
+//----------------------------------------------------------------------------
+void vtkPlanarGammaDoseComparisonFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "DistanceToleranceMm: " << this->DistanceToleranceMm << "\n";
+  os << indent << "DoseDifferenceTolerance: " << this->DoseDifferenceTolerance << "\n";
+  os << indent << "ReferenceDoseGy: " << this->ReferenceDoseGy << "\n";
+  os << indent << "AnalysisThreshold: " << this->AnalysisThreshold << "\n";
+  os << indent << "MaximumGamma: " << this->MaximumGamma << "\n";
+  os << indent << "LocalDoseDifference: " << (this->LocalDoseDifference ? "true" : "false") << "\n";
+  os << indent << "ThresholdOnReferenceOnly: " << (this->ThresholdOnReferenceOnly ? "true" : "false") << "\n";
+  os << indent << "SearchStepFraction: " << this->SearchStepFraction << "\n";
+  os << indent << "ShiftSearchRangeMm: " << this->ShiftSearchRangeMm << "\n";
+  os << indent << "PassFraction: " << this->PassFraction << "\n";
+  os << indent << "NumberOfAnalyzedPixels: " << this->NumberOfAnalyzedPixels << "\n";
+  os << indent << "NumberOfPassingPixels: " << this->NumberOfPassingPixels << "\n";
+  os << indent << "ReferenceDoseUsedGy: " << this->ReferenceDoseUsedGy << "\n";
+  os << indent << "NumberOfSamplesPerPixel: " << this->NumberOfSamplesPerPixel << "\n";
+  os << indent << "ShiftMm: " << this->ShiftMm[0] << ", " << this->ShiftMm[1] << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarGammaDoseComparisonFilter::SetInputReferenceDose(vtkOrientedImageData* dose)
+{
+  this->InputReferenceDose = dose;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkPlanarGammaDoseComparisonFilter::GetInputReferenceDose()
+{
+  return this->InputReferenceDose;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarGammaDoseComparisonFilter::SetInputCompareDose(vtkOrientedImageData* dose)
+{
+  this->InputCompareDose = dose;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkPlanarGammaDoseComparisonFilter::GetInputCompareDose()
+{
+  return this->InputCompareDose;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkPlanarGammaDoseComparisonFilter::GetOutputGammaImage()
+{
+  return this->OutputGammaImage;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlanarGammaDoseComparisonFilter::Update()
+{
+  this->PassFraction = 0.0;
+  this->NumberOfAnalyzedPixels = 0;
+  this->NumberOfPassingPixels = 0;
+  this->ReferenceDoseUsedGy = 0.0;
+  this->NumberOfSamplesPerPixel = 0;
+  this->ShiftMm[0] = 0.0;
+  this->ShiftMm[1] = 0.0;
+
+  vtkOrientedImageData* referenceDose = this->InputReferenceDose;
+  vtkOrientedImageData* compareDose = this->InputCompareDose;
+  if ( !referenceDose || !referenceDose->GetPointData()->GetScalars() || referenceDose->IsEmpty()
+    || !compareDose || !compareDose->GetPointData()->GetScalars() || compareDose->IsEmpty() )
+  {
+    vtkErrorMacro("Update: Invalid input dose images");
+    return false;
+  }
+  if (this->DistanceToleranceMm <= 0.0 || this->DoseDifferenceTolerance <= 0.0 || this->MaximumGamma <= 0.0)
+  {
+    vtkErrorMacro("Update: Invalid gamma criteria");
+    return false;
+  }
+  if (this->SearchStepFraction <= 0.0 || this->ShiftSearchRangeMm < 0.0)
+  {
+    vtkErrorMacro("Update: Invalid search step fraction " << this->SearchStepFraction
+      << " or shift search range " << this->ShiftSearchRangeMm);
+    return false;
+  }
+  int referenceAxes[2] = { 0, 1 };
+  int compareAxes[2] = { 0, 1 };
+  if (!GetPlanarAxes(referenceDose, referenceAxes) || !GetPlanarAxes(compareDose, compareAxes))
+  {
+    vtkErrorMacro("Update: Input dose images are not planar");
+    return false;
+  }
+
+  std::vector<float> referenceBuffer;
+  const float* referenceValues = GetScalarsAsFloat(referenceDose, referenceBuffer);
+  std::vector<float> compareBuffer;
+  const float* compareValues = GetScalarsAsFloat(compareDose, compareBuffer);
+
+  int referenceDimensions[3] = { 0, 0, 0 };
+  referenceDose->GetDimensions(referenceDimensions);
+  int compareDimensions[3] = { 0, 0, 0 };
+  compareDose->GetDimensions(compareDimensions);
+  PlanarGammaInput input;
+  input.Dimensions[0] = referenceDimensions[referenceAxes[0]];
+  input.Dimensions[1] = referenceDimensions[referenceAxes[1]];
+  input.CompareDimensions[0] = compareDimensions[compareAxes[0]];
+  input.CompareDimensions[1] = compareDimensions[compareAxes[1]];
+
+  // The compare dose is sampled on its own pixels: the reference pixel positions are mapped to the compare image,
+  // dropping the component along its normal
+  vtkNew<vtkMatrix4x4> referenceToWorldMatrix;
+  referenceDose->GetImageToWorldMatrix(referenceToWorldMatrix);
+  vtkNew<vtkMatrix4x4> worldToCompareMatrix;
+  compareDose->GetWorldToImageMatrix(worldToCompareMatrix);
+  vtkNew<vtkMatrix4x4> referenceToCompareMatrix;
+  vtkMatrix4x4::Multiply4x4(worldToCompareMatrix, referenceToWorldMatrix, referenceToCompareMatrix);
+  int* referenceExtent = referenceDose->GetExtent();
+  int* compareExtent = compareDose->GetExtent();
+  double referenceOrigin[4] = { static_cast<double>(referenceExtent[0]), static_cast<double>(referenceExtent[2]),
+    static_cast<double>(referenceExtent[4]), 1.0 };
+  double compareOrigin[4] = { 0.0, 0.0, 0.0, 1.0 };
+  referenceToCompareMatrix->MultiplyPoint(referenceOrigin, compareOrigin);
+  for (int axis = 0; axis < 2; ++axis)
+  {
+    input.CompareOrigin[axis] = compareOrigin[compareAxes[axis]] - compareExtent[2*compareAxes[axis]];
+    input.ColumnStep[axis] = referenceToCompareMatrix->GetElement(compareAxes[axis], referenceAxes[0]);
+    input.RowStep[axis] = referenceToCompareMatrix->GetElement(compareAxes[axis], referenceAxes[1]);
+  }
+  input.Compare = compareValues;
+  vtkIdType numberOfPixels = static_cast<vtkIdType>(input.Dimensions[0]) * input.Dimensions[1];
+
+  // Dose tolerance and analysis threshold are relative to the prescription or the maximum dose
+  this->ReferenceDoseUsedGy = this->ReferenceDoseGy;
+  if (this->ReferenceDoseUsedGy <= 0.0)
+  {
+    this->ReferenceDoseUsedGy = *std::max_element(referenceValues, referenceValues + numberOfPixels);
+  }
+  if (this->ReferenceDoseUsedGy <= 0.0)
+  {
+    vtkErrorMacro("Update: Reference dose is zero");
+    return false;
+  }
+
+  input.Reference = referenceValues;
+  input.Threshold = static_cast<float>(this->AnalysisThreshold * this->ReferenceDoseUsedGy);
+  input.ThresholdOnReferenceOnly = this->ThresholdOnReferenceOnly;
+  double doseTolerance = this->DoseDifferenceTolerance * this->ReferenceDoseUsedGy;
+  input.InverseDoseToleranceSquared = 1.0 / (doseTolerance * doseTolerance);
+  input.LocalDoseTolerance = this->DoseDifferenceTolerance;
+  input.LocalMinimumDose = 1e-3 * this->ReferenceDoseUsedGy;
+  input.Local = this->LocalDoseDifference;
+  input.MaximumGammaSquared = this->MaximumGamma * this->MaximumGamma;
+
+  // Samples are spaced evenly within the pixels, at most the search step apart
+  double* spacing = referenceDose->GetSpacing();
+  double pixelSpacing[2] = { spacing[referenceAxes[0]], spacing[referenceAxes[1]] };
+  double maximumSampleSpacing = this->SearchStepFraction * this->DistanceToleranceMm;
+  this->NumberOfSamplesPerPixel = static_cast<int>(ceil(std::max(pixelSpacing[0], pixelSpacing[1]) / maximumSampleSpacing - 1e-6));
+  this->NumberOfSamplesPerPixel = std::min(std::max(this->NumberOfSamplesPerPixel, 1), MAXIMUM_NUMBER_OF_SAMPLES_PER_PIXEL);
+  double sampleSpacing[2] = { pixelSpacing[0] / this->NumberOfSamplesPerPixel, pixelSpacing[1] / this->NumberOfSamplesPerPixel };
+
+  int shift[2] = { 0, 0 };
+  if (this->ShiftSearchRangeMm > 0.0)
+  {
+    int searchRange[2] = { static_cast<int>(floor(this->ShiftSearchRangeMm / sampleSpacing[0] + 1e-6)),
+      static_cast<int>(floor(this->ShiftSearchRangeMm / sampleSpacing[1] + 1e-6)) };
+    FindShift(input, this->NumberOfSamplesPerPixel, searchRange, shift);
+    this->ShiftMm[0] = shift[0] * sampleSpacing[0];
+    this->ShiftMm[1] = shift[1] * sampleSpacing[1];
+  }
+
+  double normalizedSampleSpacing[2] = { sampleSpacing[0] / this->DistanceToleranceMm, sampleSpacing[1] / this->DistanceToleranceMm };
+  std::vector<SampleOffset> offsets;
+  GetSampleOffsets(input, normalizedSampleSpacing, this->NumberOfSamplesPerPixel, shift, offsets);
+
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  referenceDose->GetImageToWorldMatrix(imageToWorldMatrix);
+  this->OutputGammaImage->SetExtent(referenceDose->GetExtent());
+  this->OutputGammaImage->AllocateScalars(VTK_FLOAT, 1);
+  this->OutputGammaImage->SetImageToWorldMatrix(imageToWorldMatrix);
+  float* gammaPtr = static_cast<float*>(this->OutputGammaImage->GetScalarPointer());
+
+  PlanarGammaFunctor gammaFunctor(input, offsets, gammaPtr);
+  vtkSMPTools::For(0, input.Dimensions[1], gammaFunctor);
+  this->NumberOfAnalyzedPixels = gammaFunctor.Result.NumberOfAnalyzedPixels;
+  this->NumberOfPassingPixels = gammaFunctor.Result.NumberOfPassingPixels;
+  this->PassFraction = (this->NumberOfAnalyzedPixels > 0
+    ? static_cast<double>(this->NumberOfPassingPixels) / this->NumberOfAnalyzedPixels : 0.0);
+
+  this->OutputGammaImage->Modified();
+  return true;
+}
@@ -0,0 +1,178 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkPlanarGammaDoseComparisonFilter_h
+#define __vtkPlanarGammaDoseComparisonFilter_h
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "vtkSlicerDoseComparisonModuleLogicExport.h"
+
+class vtkOrientedImageData;
+
+/// \ingroup SlicerRt_QtModules_DoseComparison
+/// \brief Compute 2D gamma dose comparison of planar dose images, such as a predicted and a measured
+///   portal dose image, or a film and a dose plane.
+///
+/// Both images have a single pixel along one axis. The compare dose is sampled on its own pixels by bilinear
+/// interpolation in its plane, after projecting the reference positions onto it, so the two images may have
+/// different pixel sizes and do not need to be at the same position along their normal.
+///
+/// Gamma of a reference pixel is the minimum over the compare dose samples of
+///   sqrt( (distance / DTA)^2 + (dose difference / dose tolerance)^2 )
+/// clamped to the maximum gamma. The samples are on a grid finer than the reference pixels, with a step not
+/// larger than the search step fraction of the DTA, each interpolated from the compare pixels around it, and
+/// are searched nearest first. The dose tolerance and the analysis threshold are the same as in
+/// \sa vtkGammaDoseComparisonFilter.
+///
+/// If the shift search range is set, the compare dose is first shifted in the plane of the reference to minimize
+/// the mean squared dose difference of the pixels above the threshold, which compensates the setup error of a
+/// measured image. The shift is searched on whole pixels, then refined on the sample grid, and gamma is computed
+/// with the compare dose shifted. The rows of the reference are processed in parallel.
+///
+/// Similarly to the segment comparison filters, this class is not a VTK pipeline filter.
+class VTK_SLICER_DOSECOMPARISON_LOGIC_EXPORT vtkPlanarGammaDoseComparisonFilter : public vtkObject
+{
+public:
+  static vtkPlanarGammaDoseComparisonFilter *New();
+  vtkTypeMacro(vtkPlanarGammaDoseComparisonFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set reference dose image
+  void SetInputReferenceDose(vtkOrientedImageData* dose);
+  /// Get reference dose image
+  vtkOrientedImageData* GetInputReferenceDose();
+
+  /// Set compare dose image
+  void SetInputCompareDose(vtkOrientedImageData* dose);
+  /// Get compare dose image
+  vtkOrientedImageData* GetInputCompareDose();
+
+  /// Get/Set distance to agreement (DTA) tolerance in mm. 3 by default
+  vtkGetMacro(DistanceToleranceMm, double);
+  vtkSetMacro(DistanceToleranceMm, double);
+
+  /// Get/Set dose difference tolerance as a fraction of the reference dose (global), or of the reference
+  /// pixel dose (local). 0.03 by default
+  vtkGetMacro(DoseDifferenceTolerance, double);
+  vtkSetMacro(DoseDifferenceTolerance, double);
+
+  /// Get/Set reference dose (prescription dose) in Gy. The maximum of the reference dose is used if
+  /// not positive. 0 by default
+  vtkGetMacro(ReferenceDoseGy, double);
+  vtkSetMacro(ReferenceDoseGy, double);
+
+  /// Get/Set analysis threshold as a fraction of the reference dose. 0.1 by default
+  vtkGetMacro(AnalysisThreshold, double);
+  vtkSetMacro(AnalysisThreshold, double);
+
+  /// Get/Set maximum gamma. Gamma is clamped to this value, which limits the search distance. 2 by default
+  vtkGetMacro(MaximumGamma, double);
+  vtkSetMacro(MaximumGamma, double);
+
+  /// Get/Set local dose difference flag. Global dose difference is used by default
+  vtkGetMacro(LocalDoseDifference, bool);
+  vtkSetMacro(LocalDoseDifference, bool);
+  vtkBooleanMacro(LocalDoseDifference, bool);
+
+  /// Get/Set flag determining whether the analysis threshold is applied to the reference dose only.
+  /// By default pixels are analyzed if either dose is above the threshold
+  vtkGetMacro(ThresholdOnReferenceOnly, bool);
+  vtkSetMacro(ThresholdOnReferenceOnly, bool);
+  vtkBooleanMacro(ThresholdOnReferenceOnly, bool);
+
+  /// Get/Set maximum step of the interpolated compare dose samples as a fraction of the DTA.
+  /// 0.1 by default, as recommended by Wendling et al 2007
+  vtkGetMacro(SearchStepFraction, double);
+  vtkSetMacro(SearchStepFraction, double);
+
+  /// Get/Set maximum shift of the compare dose along each axis of the plane, in mm.
+  /// 0 (no shift search) by default
+  vtkGetMacro(ShiftSearchRangeMm, double);
+  vtkSetMacro(ShiftSearchRangeMm, double);
+
+  /// Compute gamma
+  /// \return Success flag
+  bool Update();
+
+  /// Get gamma image. It has the geometry of the reference dose
+  vtkOrientedImageData* GetOutputGammaImage();
+
+  /// Get fraction of the analyzed pixels that pass (gamma not above one)
+  double GetPassFraction() { return this->PassFraction; };
+  /// Get number of analyzed pixels
+  vtkIdType GetNumberOfAnalyzedPixels() { return this->NumberOfAnalyzedPixels; };
+  /// Get number of passing pixels
+  vtkIdType GetNumberOfPassingPixels() { return this->NumberOfPassingPixels; };
+  /// Get reference dose the tolerance and the threshold are relative to, in Gy
+  double GetReferenceDoseUsedGy() { return this->ReferenceDoseUsedGy; };
+  /// Get number of interpolated compare dose samples per pixel along each axis
+  int GetNumberOfSamplesPerPixel() { return this->NumberOfSamplesPerPixel; };
+  /// Get shift of the compare dose found by the shift search, in mm along the first and second in-plane axes of the
+  /// reference. The compare dose is sampled at the reference pixel position plus the shift. Zero without shift search
+  vtkGetVector2Macro(ShiftMm, double);
+
+protected:
+  vtkPlanarGammaDoseComparisonFilter();
+  ~vtkPlanarGammaDoseComparisonFilter() override;
+
+protected:
+  /// Reference dose
+  vtkSmartPointer<vtkOrientedImageData> InputReferenceDose;
+  /// Compare dose
+  vtkSmartPointer<vtkOrientedImageData> InputCompareDose;
+  /// Gamma image
+  vtkSmartPointer<vtkOrientedImageData> OutputGammaImage;
+
+  /// Distance to agreement tolerance in mm
+  double DistanceToleranceMm;
+  /// Dose difference tolerance (fraction)
+  double DoseDifferenceTolerance;
+  /// Reference dose in Gy, maximum dose if not positive
+  double ReferenceDoseGy;
+  /// Analysis threshold (fraction)
+  double AnalysisThreshold;
+  /// Maximum gamma
+  double MaximumGamma;
+  /// Local dose difference flag
+  bool LocalDoseDifference;
+  /// Threshold on reference only flag
+  bool ThresholdOnReferenceOnly;
+  /// Maximum sample step as a fraction of the DTA
+  double SearchStepFraction;
+  /// Shift search range in mm
+  double ShiftSearchRangeMm;
+
+  /// Pass fraction
+  double PassFraction;
+  /// Number of analyzed pixels
+  vtkIdType NumberOfAnalyzedPixels;
+  /// Number of passing pixels
+  vtkIdType NumberOfPassingPixels;
+  /// Reference dose used
+  double ReferenceDoseUsedGy;
+  /// Number of samples per pixel along each axis
+  int NumberOfSamplesPerPixel;
+  /// Shift of the compare dose in mm
+  double ShiftMm[2];
+
+private:
+  vtkPlanarGammaDoseComparisonFilter(const vtkPlanarGammaDoseComparisonFilter&) = delete;
+  void operator=(const vtkPlanarGammaDoseComparisonFilter&) = delete;
+};
+
+#endif
@@ -21,6 +21,8 @@
 // DoseComparison includes
 #include "vtkSlicerDoseComparisonModuleLogic.h"
 #include "vtkMRMLDoseComparisonNode.h"
+#include "vtkGammaDoseComparisonFilter.h"
+#include "vtkPlanarGammaDoseComparisonFilter.h"
 
 // SlicerRT includes
 #include "vtkSlicerRtCommon.h"
@@ -51,6 +53,7 @@
 #include <vtkSlicerSubjectHierarchyModuleLogic.h>
 
 // VTK includes
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkTimerLog.h>
 #include <vtkLookupTable.h>
@@ -58,6 +61,10 @@
 #include <vtkObjectFactory.h>
 #include "vtksys/SystemTools.hxx"
 
+// STD includes
+#include <algorithm>
+#include <sstream>
+
 // SlicerBase includes
 #include "vtkSlicerApplicationLogic.h"
 
@@ -199,106 +206,72 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
 
   parameterNode->ResultsValidOff();
 
-  double checkpointConvertStart = timer->GetUniversalTime();
-  vtkMRMLScalarVolumeNode* referenceDoseVolumeNode = parameterNode->GetReferenceDoseVolumeNode();
-  Plm_image::Pointer referenceDose = PlmCommon::ConvertVolumeNodeToPlmImage(referenceDoseVolumeNode);
-  Plm_image::Pointer compareDose = PlmCommon::ConvertVolumeNodeToPlmImage(parameterNode->GetCompareDoseVolumeNode());
-
-  Plm_image::Pointer maskVolume;
-  vtkMRMLSegmentationNode* maskSegmentationNode = parameterNode->GetMaskSegmentationNode();
-  const char* maskSegmentID = parameterNode->GetMaskSegmentID();
-  if (maskSegmentationNode && maskSegmentID)
+  // Gamma volume is not needed if only the pass rate is computed
+  vtkMRMLScalarVolumeNode* gammaVolumeNode = parameterNode->GetGammaVolumeNode();
+  if (gammaVolumeNode == nullptr && !parameterNode->GetPassRateOnly())
   {
-    // Extract a labelmap for the dose comparison to use it as a mask
-    vtkSegmentation* maskSegmentation = maskSegmentationNode->GetSegmentation();
-    vtkSegment* maskSegment = maskSegmentation->GetSegment(maskSegmentID);
-    if (!maskSegment)
-    {
-      std::string errorMessage("Failed to get mask segment");
-      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
-      return errorMessage;
-    }
-
-    // Temporarily duplicate selected segments to contain binary labelmap of a different geometry (tied to dose volume)
-    vtkSmartPointer<vtkSegmentation> segmentationCopy = vtkSmartPointer<vtkSegmentation>::New();
-    segmentationCopy->SetMasterRepresentationName(maskSegmentation->GetMasterRepresentationName());
-    segmentationCopy->CopyConversionParameters(maskSegmentation);
-    segmentationCopy->CopySegmentFromSegmentation(maskSegmentation, maskSegmentID);
-    if (!segmentationCopy->CreateRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
-    {
-      std::string errorMessage("Failed to create binary labelmap representation for mask segment");
-      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
-      return errorMessage;
-    }
-    // Get segment binary labelmap
-#if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
-    vtkNew<vtkOrientedImageData>  maskSegmentLabelmap;
-    maskSegmentationNode->GetBinaryLabelmapRepresentation(maskSegmentID, maskSegmentLabelmap);
-#else
-    vtkOrientedImageData* maskSegmentLabelmap = vtkOrientedImageData::SafeDownCast( segmentationCopy->GetSegment(maskSegmentID)->GetRepresentation(
-      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) );
-#endif
+    std::string errorMessage("Invalid gamma volume node in parameter set node");
+    vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
+    return errorMessage;
+  }
 
-    // Apply parent transformation nodes if necessary
-    if ( maskSegmentationNode->GetParentTransformNode()
-      && (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(maskSegmentationNode, maskSegmentLabelmap)) )
+  // Extract a labelmap for the dose comparison to use it as a mask
+  vtkSmartPointer<vtkOrientedImageData> maskSegmentLabelmap;
+  bool planarGamma = (parameterNode->GetGammaAlgorithm() == vtkMRMLDoseComparisonNode::GammaAlgorithmPlanar);
+  if (parameterNode->GetMaskSegmentationNode() && parameterNode->GetMaskSegmentID())
+  {
+    if (planarGamma)
     {
-      std::string errorMessage("Failed to apply parent transform on mask segment");
+      std::string errorMessage("Mask is not supported by planar gamma");
       vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
       return errorMessage;
     }
-
-    // Convert mask to Plm image
-    maskVolume = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(maskSegmentLabelmap);
-    if (!maskVolume)
+    maskSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    std::string errorMessage = this->GetMaskSegmentLabelmap(parameterNode, maskSegmentLabelmap);
+    if (!errorMessage.empty())
     {
-      std::string errorMessage("Failed to convert mask segment labelmap into Plm_image");
-      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
       return errorMessage;
     }
   }
 
   // Compute gamma dose volume
   double checkpointGammaStart = timer->GetUniversalTime();
-  Gamma_dose_comparison gamma;
-  gamma.set_reference_image(referenceDose->itk_float());
-  gamma.set_compare_image(compareDose->itk_float());
-  if (maskSegmentationNode && maskSegmentID)
+  std::string errorMessage;
+  if (planarGamma)
   {
-    gamma.set_mask_image(maskVolume->itk_uchar());
+    // Planar gamma of single slice images is also used in pass rate only mode, only its gamma image is discarded
+    errorMessage = this->ComputeGammaUsingPlanarGammaFilter(parameterNode,
+      parameterNode->GetPassRateOnly() ? nullptr : gammaVolumeNode);
   }
-  gamma.set_spatial_tolerance(parameterNode->GetDtaDistanceToleranceMm());
-  gamma.set_dose_difference_tolerance(parameterNode->GetDoseDifferenceTolerancePercent() / 100.0);
-  gamma.set_resample_nn(false); // Note: This used to be driven by the interpolation checkbox
-  gamma.set_interp_search(parameterNode->GetUseGeometricGammaCalculation());
-  gamma.set_local_gamma(parameterNode->GetLocalDoseDifference());
-  if (!parameterNode->GetUseMaximumDose())
+  else if (parameterNode->GetPassRateOnly())
   {
-    gamma.set_reference_dose(parameterNode->GetReferenceDoseGy());
+    // Early exit search of the gamma filter, interpolated if geometric gamma calculation is enabled
+    errorMessage = this->ComputeGammaUsingGammaFilter(parameterNode, maskSegmentLabelmap, nullptr);
   }
-  gamma.set_analysis_threshold(parameterNode->GetAnalysisThresholdPercent() / 100.0 );
-  gamma.set_gamma_max(parameterNode->GetMaximumGamma());
-  gamma.set_ref_only_threshold(parameterNode->GetDoseThresholdOnReferenceOnly());
-  gamma.set_progress_callback(&GammaProgressCallback);
-
-  gamma.run();
-
-  itk::Image<float, 3>::Pointer gammaVolumeItk = gamma.get_gamma_image_itk();
-  parameterNode->SetPassFractionPercent( gamma.get_pass_fraction() * 100.0 );
-  parameterNode->SetReportString(gamma.get_report_string().c_str());
-
-  // Convert output to VTK
-  double checkpointVtkConvertStart = timer->GetUniversalTime();
-
-  vtkMRMLScalarVolumeNode* gammaVolumeNode = parameterNode->GetGammaVolumeNode();
-  if (gammaVolumeNode == nullptr)
+  else if (parameterNode->GetGammaAlgorithm() == vtkMRMLDoseComparisonNode::GammaAlgorithmMultiresolution)
+  {
+    errorMessage = this->ComputeGammaUsingGammaFilter(parameterNode, maskSegmentLabelmap, gammaVolumeNode);
+  }
+  else
+  {
+    errorMessage = this->ComputeGammaUsingPlastimatch(parameterNode, maskSegmentLabelmap, gammaVolumeNode);
+  }
+  if (!errorMessage.empty())
   {
-    std::string errorMessage("Invalid gamma volume node in parameter set node");
-    vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
     return errorMessage;
   }
 
-  vtkSlicerRtCommon::ConvertItkImageToVolumeNode<float>(gammaVolumeItk, gammaVolumeNode, VTK_FLOAT);
+  if (parameterNode->GetPassRateOnly())
+  {
+    parameterNode->ResultsValidOn();
+    if (this->LogSpeedMeasurements)
+    {
+      std::cout << "Total gamma pass rate computation time: " << timer->GetUniversalTime()-checkpointStart << " s" << std::endl;
+    }
+    return "";
+  }
+
+  double checkpointOutputStart = timer->GetUniversalTime();
   gammaVolumeNode->SetAttribute(vtkSlicerDoseComparisonModuleLogic::DOSECOMPARISON_GAMMA_VOLUME_IDENTIFIER_ATTRIBUTE_NAME, "1");
 
   // Set default colormap to red
@@ -371,10 +344,311 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
   {
     double checkpointEnd = timer->GetUniversalTime();
     std::cout << "Total gamma computation time: " << checkpointEnd-checkpointStart << " s" << std::endl
-              << "\tApplying transforms: " << checkpointConvertStart-checkpointStart << " s" << std::endl
-              << "\tConverting from VTK to ITK: " << checkpointGammaStart-checkpointConvertStart << " s" << std::endl
-              << "\tGamma computation: " << checkpointVtkConvertStart-checkpointGammaStart << " s" << std::endl
-              << "\tConverting back from ITK to VTK: " << checkpointEnd-checkpointVtkConvertStart << " s" << std::endl;
+              << "\tExtracting mask labelmap: " << checkpointGammaStart-checkpointStart << " s" << std::endl
+              << "\tGamma computation: " << checkpointOutputStart-checkpointGammaStart << " s" << std::endl
+              << "\tSetting up gamma volume: " << checkpointEnd-checkpointOutputStart << " s" << std::endl;
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseComparisonModuleLogic::GetMaskSegmentLabelmap(vtkMRMLDoseComparisonNode* parameterNode, vtkOrientedImageData* maskSegmentLabelmap)
+{
+  vtkMRMLSegmentationNode* maskSegmentationNode = parameterNode->GetMaskSegmentationNode();
+  const char* maskSegmentID = parameterNode->GetMaskSegmentID();
+  if (!maskSegmentationNode || !maskSegmentID || !maskSegmentLabelmap)
+  {
+    std::string errorMessage("Invalid mask segment");
+    vtkErrorMacro("GetMaskSegmentLabelmap: " << errorMessage);
+    return errorMessage;
+  }
+
+  vtkSegmentation* maskSegmentation = maskSegmentationNode->GetSegmentation();
+  vtkSegment* maskSegment = maskSegmentation->GetSegment(maskSegmentID);
+  if (!maskSegment)
+  {
+    std::string errorMessage("Failed to get mask segment");
+    vtkErrorMacro("GetMaskSegmentLabelmap: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Temporarily duplicate selected segments to contain binary labelmap of a different geometry (tied to dose volume)
+  vtkSmartPointer<vtkSegmentation> segmentationCopy = vtkSmartPointer<vtkSegmentation>::New();
+  segmentationCopy->SetMasterRepresentationName(maskSegmentation->GetMasterRepresentationName());
+  segmentationCopy->CopyConversionParameters(maskSegmentation);
+  segmentationCopy->CopySegmentFromSegmentation(maskSegmentation, maskSegmentID);
+  if (!segmentationCopy->CreateRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+  {
+    std::string errorMessage("Failed to create binary labelmap representation for mask segment");
+    vtkErrorMacro("GetMaskSegmentLabelmap: " << errorMessage);
+    return errorMessage;
+  }
+  // Get segment binary labelmap
+#if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
+  maskSegmentationNode->GetBinaryLabelmapRepresentation(maskSegmentID, maskSegmentLabelmap);
+#else
+  maskSegmentLabelmap->DeepCopy( vtkOrientedImageData::SafeDownCast( segmentationCopy->GetSegment(maskSegmentID)->GetRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) ) );
+#endif
+
+  // Apply parent transformation nodes if necessary
+  if ( maskSegmentationNode->GetParentTransformNode()
+    && (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(maskSegmentationNode, maskSegmentLabelmap)) )
+  {
+    std::string errorMessage("Failed to apply parent transform on mask segment");
+    vtkErrorMacro("GetMaskSegmentLabelmap: " << errorMessage);
+    return errorMessage;
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaUsingPlastimatch(vtkMRMLDoseComparisonNode* parameterNode,
+  vtkOrientedImageData* maskSegmentLabelmap, vtkMRMLScalarVolumeNode* gammaVolumeNode)
+{
+  Plm_image::Pointer referenceDose = PlmCommon::ConvertVolumeNodeToPlmImage(parameterNode->GetReferenceDoseVolumeNode());
+  Plm_image::Pointer compareDose = PlmCommon::ConvertVolumeNodeToPlmImage(parameterNode->GetCompareDoseVolumeNode());
+
+  Plm_image::Pointer maskVolume;
+  if (maskSegmentLabelmap)
+  {
+    // Convert mask to Plm image
+    maskVolume = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(maskSegmentLabelmap);
+    if (!maskVolume)
+    {
+      std::string errorMessage("Failed to convert mask segment labelmap into Plm_image");
+      vtkErrorMacro("ComputeGammaUsingPlastimatch: " << errorMessage);
+      return errorMessage;
+    }
+  }
+
+  Gamma_dose_comparison gamma;
+  gamma.set_reference_image(referenceDose->itk_float());
+  gamma.set_compare_image(compareDose->itk_float());
+  if (maskVolume)
+  {
+    gamma.set_mask_image(maskVolume->itk_uchar());
+  }
+  gamma.set_spatial_tolerance(parameterNode->GetDtaDistanceToleranceMm());
+  gamma.set_dose_difference_tolerance(parameterNode->GetDoseDifferenceTolerancePercent() / 100.0);
+  gamma.set_resample_nn(false); // Note: This used to be driven by the interpolation checkbox
+  gamma.set_interp_search(parameterNode->GetUseGeometricGammaCalculation());
+  gamma.set_local_gamma(parameterNode->GetLocalDoseDifference());
+  if (!parameterNode->GetUseMaximumDose())
+  {
+    gamma.set_reference_dose(parameterNode->GetReferenceDoseGy());
+  }
+  gamma.set_analysis_threshold(parameterNode->GetAnalysisThresholdPercent() / 100.0 );
+  gamma.set_gamma_max(parameterNode->GetMaximumGamma());
+  gamma.set_ref_only_threshold(parameterNode->GetDoseThresholdOnReferenceOnly());
+  gamma.set_progress_callback(&GammaProgressCallback);
+
+  gamma.run();
+
+  parameterNode->SetPassFractionPercent( gamma.get_pass_fraction() * 100.0 );
+  parameterNode->SetReportString(gamma.get_report_string().c_str());
+
+  // Convert output to VTK
+  itk::Image<float, 3>::Pointer gammaVolumeItk = gamma.get_gamma_image_itk();
+  vtkSlicerRtCommon::ConvertItkImageToVolumeNode<float>(gammaVolumeItk, gammaVolumeNode, VTK_FLOAT);
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseComparisonModuleLogic::GetDoseImageInWorld(vtkMRMLScalarVolumeNode* doseVolumeNode, vtkOrientedImageData* doseImage)
+{
+  if (!doseVolumeNode || !doseVolumeNode->GetImageData() || !doseImage)
+  {
+    std::string errorMessage("Invalid dose volume");
+    vtkErrorMacro("GetDoseImageInWorld: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Volumes under a non-linear transform are resampled to world coordinates
+  vtkMRMLTransformNode* transformNode = doseVolumeNode->GetParentTransformNode();
+  if (transformNode && !transformNode->IsTransformToWorldLinear())
+  {
+    vtkSmartPointer<vtkOrientedImageData> transformedDoseImage = vtkSmartPointer<vtkOrientedImageData>::Take(
+      vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(doseVolumeNode) );
+    if (!transformedDoseImage)
+    {
+      std::string errorMessage("Failed to get dose volume in world coordinates");
+      vtkErrorMacro("GetDoseImageInWorld: " << errorMessage);
+      return errorMessage;
+    }
+    doseImage->ShallowCopy(transformedDoseImage);
+    return "";
+  }
+
+  // The voxels are referenced, only the geometry is set to world coordinates
+  vtkNew<vtkMatrix4x4> ijkToRasMatrix;
+  doseVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+  vtkNew<vtkMatrix4x4> ijkToWorldMatrix;
+  ijkToWorldMatrix->DeepCopy(ijkToRasMatrix);
+  if (transformNode)
+  {
+    vtkNew<vtkMatrix4x4> rasToWorldMatrix;
+    transformNode->GetMatrixTransformToWorld(rasToWorldMatrix);
+    vtkMatrix4x4::Multiply4x4(rasToWorldMatrix, ijkToRasMatrix, ijkToWorldMatrix);
+  }
+  doseImage->vtkImageData::ShallowCopy(doseVolumeNode->GetImageData());
+  doseImage->SetGeometryFromImageToWorldMatrix(ijkToWorldMatrix);
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaUsingGammaFilter(vtkMRMLDoseComparisonNode* parameterNode,
+  vtkOrientedImageData* maskSegmentLabelmap, vtkMRMLScalarVolumeNode* gammaVolumeNode)
+{
+  // Dose volumes in world coordinates. The voxels of the dose volumes are used in place
+  vtkNew<vtkOrientedImageData> referenceDose;
+  std::string errorMessage = this->GetDoseImageInWorld(parameterNode->GetReferenceDoseVolumeNode(), referenceDose);
+  if (!errorMessage.empty())
+  {
+    return errorMessage;
+  }
+  vtkNew<vtkOrientedImageData> compareDose;
+  errorMessage = this->GetDoseImageInWorld(parameterNode->GetCompareDoseVolumeNode(), compareDose);
+  if (!errorMessage.empty())
+  {
+    return errorMessage;
+  }
+
+  vtkNew<vtkGammaDoseComparisonFilter> gammaFilter;
+  gammaFilter->SetInputReferenceDose(referenceDose);
+  gammaFilter->SetInputCompareDose(compareDose);
+  gammaFilter->SetInputMask(maskSegmentLabelmap);
+  gammaFilter->SetDistanceToleranceMm(parameterNode->GetDtaDistanceToleranceMm());
+  gammaFilter->SetDoseDifferenceTolerance(parameterNode->GetDoseDifferenceTolerancePercent() / 100.0);
+  gammaFilter->SetReferenceDoseGy(parameterNode->GetUseMaximumDose() ? 0.0 : parameterNode->GetReferenceDoseGy());
+  gammaFilter->SetAnalysisThreshold(parameterNode->GetAnalysisThresholdPercent() / 100.0);
+  gammaFilter->SetMaximumGamma(parameterNode->GetMaximumGamma());
+  gammaFilter->SetLocalDoseDifference(parameterNode->GetLocalDoseDifference());
+  gammaFilter->SetThresholdOnReferenceOnly(parameterNode->GetDoseThresholdOnReferenceOnly());
+  gammaFilter->SetAlgorithm(vtkGammaDoseComparisonFilter::AlgorithmMultiresolution);
+  gammaFilter->SetPassRateOnly(gammaVolumeNode == nullptr);
+  gammaFilter->SetInterpolatedSearch(gammaVolumeNode == nullptr && parameterNode->GetUseGeometricGammaCalculation());
+  gammaFilter->SetNumberOfHistogramBins(std::max(parameterNode->GetNumberOfGammaHistogramBins(), 0));
+  if (!gammaFilter->Update())
+  {
+    errorMessage = "Failed to compute gamma";
+    vtkErrorMacro("ComputeGammaUsingGammaFilter: " << errorMessage);
+    return errorMessage;
+  }
+  this->GammaProgressUpdated(1.0);
+
+  parameterNode->SetPassFractionPercent( gammaFilter->GetPassFraction() * 100.0 );
+
+  // Report the parameters, the result, and how many voxels needed refinement at each level
+  std::ostringstream reportStream;
+  reportStream << (gammaFilter->GetPassRateOnly() ? "Gamma pass rate" : "Multiresolution gamma")
+    << (gammaFilter->GetInterpolatedSearch() ? " (interpolated search)" : " (nearest neighbor search)") << std::endl
+    << "DTA: " << gammaFilter->GetDistanceToleranceMm() << " mm" << std::endl
+    << "Dose difference tolerance: " << parameterNode->GetDoseDifferenceTolerancePercent() << " %"
+    << (gammaFilter->GetLocalDoseDifference() ? " (local)" : "") << std::endl
+    << "Reference dose: " << gammaFilter->GetReferenceDoseUsedGy() << " Gy" << std::endl
+    << "Analysis threshold: " << parameterNode->GetAnalysisThresholdPercent() << " %" << std::endl
+    << "Maximum gamma: " << gammaFilter->GetMaximumGamma() << std::endl
+    << "Number of analyzed voxels: " << gammaFilter->GetNumberOfAnalyzedVoxels() << std::endl
+    << "Number of passing voxels: " << gammaFilter->GetNumberOfPassingVoxels() << std::endl
+    << "Pass rate: " << gammaFilter->GetPassFraction() * 100.0 << " %" << std::endl;
+  if (gammaFilter->GetPassRateOnly())
+  {
+    double binWidth = gammaFilter->GetMaximumGamma() / std::max(gammaFilter->GetNumberOfHistogramBins(), 1);
+    for (int bin = 0; bin < gammaFilter->GetNumberOfHistogramBins(); ++bin)
+    {
+      reportStream << "Gamma " << (bin == 0 ? "[" : "(") << bin * binWidth << ", " << (bin + 1) * binWidth << "]: "
+        << gammaFilter->GetHistogramBinCount(bin) << " voxels" << std::endl;
+    }
+    reportStream << "Computation time: " << gammaFilter->GetLevelTime(0) << " s" << std::endl;
+    parameterNode->SetReportString(reportStream.str().c_str());
+    return "";
+  }
+  for (int level = gammaFilter->GetNumberOfEvaluatedLevels() - 1; level >= 0; --level)
+  {
+    reportStream << "Level " << level << " (" << (1 << level) << " voxel blocks): "
+      << gammaFilter->GetLevelEvaluatedFraction(level) * 100.0 << " % of voxels evaluated in "
+      << gammaFilter->GetLevelTime(level) << " s" << std::endl;
+  }
+  parameterNode->SetReportString(reportStream.str().c_str());
+
+  if (!vtkSlicerSegmentationsModuleLogic::CopyOrientedImageDataToVolumeNode(gammaFilter->GetOutputGammaImage(), gammaVolumeNode))
+  {
+    errorMessage = "Failed to set gamma image to gamma volume node";
+    vtkErrorMacro("ComputeGammaUsingGammaFilter: " << errorMessage);
+    return errorMessage;
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaUsingPlanarGammaFilter(vtkMRMLDoseComparisonNode* parameterNode,
+  vtkMRMLScalarVolumeNode* gammaVolumeNode)
+{
+  // Dose images in world coordinates
+  vtkSmartPointer<vtkOrientedImageData> referenceDose = vtkSmartPointer<vtkOrientedImageData>::Take(
+    vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(parameterNode->GetReferenceDoseVolumeNode()) );
+  vtkSmartPointer<vtkOrientedImageData> compareDose = vtkSmartPointer<vtkOrientedImageData>::Take(
+    vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(parameterNode->GetCompareDoseVolumeNode()) );
+  if (!referenceDose || !compareDose)
+  {
+    std::string errorMessage("Failed to get dose volumes in world coordinates");
+    vtkErrorMacro("ComputeGammaUsingPlanarGammaFilter: " << errorMessage);
+    return errorMessage;
+  }
+
+  vtkNew<vtkPlanarGammaDoseComparisonFilter> gammaFilter;
+  gammaFilter->SetInputReferenceDose(referenceDose);
+  gammaFilter->SetInputCompareDose(compareDose);
+  gammaFilter->SetDistanceToleranceMm(parameterNode->GetDtaDistanceToleranceMm());
+  gammaFilter->SetDoseDifferenceTolerance(parameterNode->GetDoseDifferenceTolerancePercent() / 100.0);
+  gammaFilter->SetReferenceDoseGy(parameterNode->GetUseMaximumDose() ? 0.0 : parameterNode->GetReferenceDoseGy());
+  gammaFilter->SetAnalysisThreshold(parameterNode->GetAnalysisThresholdPercent() / 100.0);
+  gammaFilter->SetMaximumGamma(parameterNode->GetMaximumGamma());
+  gammaFilter->SetLocalDoseDifference(parameterNode->GetLocalDoseDifference());
+  gammaFilter->SetThresholdOnReferenceOnly(parameterNode->GetDoseThresholdOnReferenceOnly());
+  gammaFilter->SetShiftSearchRangeMm(std::max(parameterNode->GetPlanarShiftSearchRangeMm(), 0.0));
+  if (!gammaFilter->Update())
+  {
+    std::string errorMessage("Failed to compute planar gamma. The dose volumes need to be single slice images");
+    vtkErrorMacro("ComputeGammaUsingPlanarGammaFilter: " << errorMessage);
+    return errorMessage;
+  }
+  this->GammaProgressUpdated(1.0);
+
+  parameterNode->SetPassFractionPercent( gammaFilter->GetPassFraction() * 100.0 );
+
+  std::ostringstream reportStream;
+  reportStream << "Planar gamma (interpolated search, " << gammaFilter->GetNumberOfSamplesPerPixel() << " samples per pixel)" << std::endl
+    << "DTA: " << gammaFilter->GetDistanceToleranceMm() << " mm" << std::endl
+    << "Dose difference tolerance: " << parameterNode->GetDoseDifferenceTolerancePercent() << " %"
+    << (gammaFilter->GetLocalDoseDifference() ? " (local)" : "") << std::endl
+    << "Reference dose: " << gammaFilter->GetReferenceDoseUsedGy() << " Gy" << std::endl
+    << "Analysis threshold: " << parameterNode->GetAnalysisThresholdPercent() << " %" << std::endl
+    << "Maximum gamma: " << gammaFilter->GetMaximumGamma() << std::endl;
+  if (gammaFilter->GetShiftSearchRangeMm() > 0.0)
+  {
+    reportStream << "Compare dose shift: " << gammaFilter->GetShiftMm()[0] << ", " << gammaFilter->GetShiftMm()[1]
+      << " mm (searched within " << gammaFilter->GetShiftSearchRangeMm() << " mm)" << std::endl;
+  }
+  reportStream << "Number of analyzed pixels: " << gammaFilter->GetNumberOfAnalyzedPixels() << std::endl
+    << "Number of passing pixels: " << gammaFilter->GetNumberOfPassingPixels() << std::endl
+    << "Pass rate: " << gammaFilter->GetPassFraction() * 100.0 << " %" << std::endl;
+  parameterNode->SetReportString(reportStream.str().c_str());
+  if (!gammaVolumeNode)
+  {
+    return "";
+  }
+
+  if (!vtkSlicerSegmentationsModuleLogic::CopyOrientedImageDataToVolumeNode(gammaFilter->GetOutputGammaImage(), gammaVolumeNode))
+  {
+    std::string errorMessage("Failed to set gamma image to gamma volume node");
+    vtkErrorMacro("ComputeGammaUsingPlanarGammaFilter: " << errorMessage);
+    return errorMessage;
   }
 
   return "";
@@ -33,6 +33,8 @@
 #include "vtkSlicerDoseComparisonModuleLogicExport.h"
 
 class vtkMRMLDoseComparisonNode;
+class vtkMRMLScalarVolumeNode;
+class vtkOrientedImageData;
 
 /// \ingroup SlicerRt_QtModules_DoseComparison
 class VTK_SLICER_DOSECOMPARISON_LOGIC_EXPORT vtkSlicerDoseComparisonModuleLogic :
@@ -66,6 +68,38 @@ protected:
   /// Loads default gamma color table from the supplied color table file
   void LoadDefaultGammaColorTable();
 
+  /// Get binary labelmap of the mask segment in world coordinates
+  /// \return Error message, empty string if no error
+  std::string GetMaskSegmentLabelmap(vtkMRMLDoseComparisonNode* parameterNode, vtkOrientedImageData* maskSegmentLabelmap);
+
+  /// Get dose volume in world coordinates. The image references the voxels of the volume, which are only
+  /// copied (resampled) if the volume is under a non-linear transform
+  /// \return Error message, empty string if no error
+  std::string GetDoseImageInWorld(vtkMRMLScalarVolumeNode* doseVolumeNode, vtkOrientedImageData* doseImage);
+
+  /// Compute gamma with plastimatch and set it to the gamma volume node
+  /// \param maskSegmentLabelmap Mask labelmap, nullptr if there is no mask
+  /// \return Error message, empty string if no error
+  std::string ComputeGammaUsingPlastimatch(vtkMRMLDoseComparisonNode* parameterNode,
+    vtkOrientedImageData* maskSegmentLabelmap, vtkMRMLScalarVolumeNode* gammaVolumeNode);
+
+  /// Compute gamma with the coarse-to-fine search of \sa vtkGammaDoseComparisonFilter and set it to the gamma volume node.
+  /// The report string contains the fraction of voxels evaluated and the time spent at each resolution level.
+  /// If there is no gamma volume node, only the pass rate and the gamma histogram are computed, with interpolated
+  /// search if geometric gamma calculation is enabled
+  /// \param maskSegmentLabelmap Mask labelmap, nullptr if there is no mask
+  /// \param gammaVolumeNode Output gamma volume, nullptr to compute the pass rate only
+  /// \return Error message, empty string if no error
+  std::string ComputeGammaUsingGammaFilter(vtkMRMLDoseComparisonNode* parameterNode,
+    vtkOrientedImageData* maskSegmentLabelmap, vtkMRMLScalarVolumeNode* gammaVolumeNode);
+
+  /// Compute 2D gamma of single slice dose volumes with \sa vtkPlanarGammaDoseComparisonFilter and set it to the
+  /// gamma volume node. The report string contains the shift found by the shift search
+  /// \param gammaVolumeNode Output gamma volume, nullptr to compute the pass rate only
+  /// \return Error message, empty string if no error
+  std::string ComputeGammaUsingPlanarGammaFilter(vtkMRMLDoseComparisonNode* parameterNode,
+    vtkMRMLScalarVolumeNode* gammaVolumeNode);
+
 public:
   vtkGetMacro(LogSpeedMeasurements, bool);
   vtkSetMacro(LogSpeedMeasurements, bool);
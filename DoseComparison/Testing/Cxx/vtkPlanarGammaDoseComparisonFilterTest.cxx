@@ -0,0 +1,260 @@
+// DoseComparison includes
+#include "vtkPlanarGammaDoseComparisonFilter.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+/// Portal image of 1024x1024 pixels of 0.4mm, with the center of pixel (512,512) at the origin
+const int IMAGE_DIMENSION = 1024;
+const double PIXEL_SPACING = 0.4;
+const double IMAGE_ORIGIN = -204.8;
+const int CENTER_PIXEL = 512;
+
+/// Gaussian dose field centered at the origin
+const double FIELD_SIGMA = 40.0;
+const double FIELD_MAXIMUM_DOSE = 2.0;
+
+/// Gamma criteria 3%/3mm, global
+const double DTA = 3.0;
+const double DOSE_TOLERANCE = 0.03;
+const double MAXIMUM_GAMMA = 2.0;
+
+//-----------------------------------------------------------------------------
+/// Create planar image of a Gaussian dose field, scaled by a factor and shifted in the plane
+vtkSmartPointer<vtkOrientedImageData> CreateGaussianField(double scale, double shiftX, double shiftY,
+  int dimension=IMAGE_DIMENSION, double spacing=PIXEL_SPACING, double planePosition=0.0)
+{
+  vtkSmartPointer<vtkOrientedImageData> image = vtkSmartPointer<vtkOrientedImageData>::New();
+  image->SetDimensions(dimension, dimension, 1);
+  image->SetSpacing(spacing, spacing, 1.0);
+  image->SetOrigin(IMAGE_ORIGIN, IMAGE_ORIGIN, planePosition);
+  image->AllocateScalars(VTK_FLOAT, 1);
+  float* dosePtr = static_cast<float*>(image->GetScalarPointer());
+  for (int j = 0; j < dimension; ++j)
+  {
+    double y = IMAGE_ORIGIN + j * spacing - shiftY;
+    for (int i = 0; i < dimension; ++i)
+    {
+      double x = IMAGE_ORIGIN + i * spacing - shiftX;
+      dosePtr[i + j * dimension] = static_cast<float>(
+        scale * FIELD_MAXIMUM_DOSE * exp(-(x * x + y * y) / (2.0 * FIELD_SIGMA * FIELD_SIGMA)) );
+    }
+  }
+  return image;
+}
+
+//-----------------------------------------------------------------------------
+/// Gamma of a point of the Gaussian field compared to the field scaled by a factor. The compare dose depends
+/// only on the distance from the center, and the nearest point of a given distance from the center is on the
+/// line through the center, so gamma is the minimum along this line, found by dense sampling
+double GetScaledFieldGamma(double radius, double scale)
+{
+  double referenceDose = FIELD_MAXIMUM_DOSE * exp(-radius * radius / (2.0 * FIELD_SIGMA * FIELD_SIGMA));
+  double doseTolerance = DOSE_TOLERANCE * FIELD_MAXIMUM_DOSE;
+  double best = MAXIMUM_GAMMA * MAXIMUM_GAMMA;
+  for (double position = radius - MAXIMUM_GAMMA * DTA; position <= radius + MAXIMUM_GAMMA * DTA; position += 0.001)
+  {
+    double compareDose = scale * FIELD_MAXIMUM_DOSE * exp(-position * position / (2.0 * FIELD_SIGMA * FIELD_SIGMA));
+    double distance = (position - radius) / DTA;
+    double doseDifference = (compareDose - referenceDose) / doseTolerance;
+    best = std::min(best, distance * distance + doseDifference * doseDifference);
+  }
+  return sqrt(best);
+}
+
+//-----------------------------------------------------------------------------
+/// Set up gamma filter with the criteria of the test
+void SetUpGammaFilter(vtkPlanarGammaDoseComparisonFilter* gammaFilter, vtkOrientedImageData* referenceDose, vtkOrientedImageData* compareDose)
+{
+  gammaFilter->SetInputReferenceDose(referenceDose);
+  gammaFilter->SetInputCompareDose(compareDose);
+  gammaFilter->SetDistanceToleranceMm(DTA);
+  gammaFilter->SetDoseDifferenceTolerance(DOSE_TOLERANCE);
+  gammaFilter->SetMaximumGamma(MAXIMUM_GAMMA);
+}
+
+//-----------------------------------------------------------------------------
+/// Maximum of the gamma image
+double GetMaximumGamma(vtkPlanarGammaDoseComparisonFilter* gammaFilter)
+{
+  vtkOrientedImageData* gammaImage = gammaFilter->GetOutputGammaImage();
+  const float* gammaPtr = static_cast<float*>(gammaImage->GetScalarPointer());
+  int dimensions[3] = { 0, 0, 0 };
+  gammaImage->GetDimensions(dimensions);
+  return *std::max_element(gammaPtr, gammaPtr + dimensions[0] * dimensions[1] * dimensions[2]);
+}
+
+//-----------------------------------------------------------------------------
+/// Identical images pass everywhere with zero gamma
+bool TestIdenticalFields()
+{
+  vtkSmartPointer<vtkOrientedImageData> referenceDose = CreateGaussianField(1.0, 0.0, 0.0);
+  vtkSmartPointer<vtkOrientedImageData> compareDose = CreateGaussianField(1.0, 0.0, 0.0);
+  vtkNew<vtkPlanarGammaDoseComparisonFilter> gammaFilter;
+  SetUpGammaFilter(gammaFilter, referenceDose, compareDose);
+  if (!gammaFilter->Update())
+  {
+    std::cerr << "Failed to compute gamma of identical fields" << std::endl;
+    return false;
+  }
+  if ( gammaFilter->GetNumberOfAnalyzedPixels() == 0 || gammaFilter->GetPassFraction() != 1.0
+    || GetMaximumGamma(gammaFilter) > 1e-6 )
+  {
+    std::cerr << "Identical fields have pass fraction " << gammaFilter->GetPassFraction()
+      << " and maximum gamma " << GetMaximumGamma(gammaFilter) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Gamma of a field with 5% higher dose matches the value found on the radial line
+bool TestScaledField()
+{
+  const double scale = 1.05;
+  vtkSmartPointer<vtkOrientedImageData> referenceDose = CreateGaussianField(1.0, 0.0, 0.0);
+  vtkSmartPointer<vtkOrientedImageData> compareDose = CreateGaussianField(scale, 0.0, 0.0);
+  vtkNew<vtkPlanarGammaDoseComparisonFilter> gammaFilter;
+  SetUpGammaFilter(gammaFilter, referenceDose, compareDose);
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  if (!gammaFilter->Update())
+  {
+    std::cerr << "Failed to compute gamma of scaled field" << std::endl;
+    return false;
+  }
+  timer->StopTimer();
+  std::cout << "Gamma of " << IMAGE_DIMENSION << "x" << IMAGE_DIMENSION << " pixels computed in "
+    << timer->GetElapsedTime() << "s" << std::endl;
+
+  const float* gammaPtr = static_cast<float*>(gammaFilter->GetOutputGammaImage()->GetScalarPointer());
+  const int pixelOffsets[5] = { 0, 25, 50, 100, 150 };
+  for (int pixelOffset : pixelOffsets)
+  {
+    int i = CENTER_PIXEL + pixelOffset;
+    double gamma = gammaPtr[i + CENTER_PIXEL * IMAGE_DIMENSION];
+    double expectedGamma = GetScaledFieldGamma(pixelOffset * PIXEL_SPACING, scale);
+    if (fabs(gamma - expectedGamma) > 0.01)
+    {
+      std::cerr << "Gamma " << gamma << " at " << pixelOffset * PIXEL_SPACING << "mm from the center differs from the expected "
+        << expectedGamma << std::endl;
+      return false;
+    }
+  }
+  if (gammaFilter->GetPassFraction() <= 0.0 || gammaFilter->GetPassFraction() >= 1.0)
+  {
+    std::cerr << "Scaled field has pass fraction " << gammaFilter->GetPassFraction() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Gamma of a shifted field is not above the shift divided by the DTA, and the shift search finds the shift
+bool TestShiftedField()
+{
+  const double shift[2] = { 1.0, -0.7 };
+  vtkSmartPointer<vtkOrientedImageData> referenceDose = CreateGaussianField(1.0, 0.0, 0.0);
+  vtkSmartPointer<vtkOrientedImageData> compareDose = CreateGaussianField(1.0, shift[0], shift[1]);
+  vtkNew<vtkPlanarGammaDoseComparisonFilter> gammaFilter;
+  SetUpGammaFilter(gammaFilter, referenceDose, compareDose);
+  if (!gammaFilter->Update())
+  {
+    std::cerr << "Failed to compute gamma of shifted field" << std::endl;
+    return false;
+  }
+  double shiftGamma = sqrt(shift[0] * shift[0] + shift[1] * shift[1]) / DTA;
+  if (gammaFilter->GetPassFraction() != 1.0 || GetMaximumGamma(gammaFilter) > shiftGamma + 0.01)
+  {
+    std::cerr << "Shifted field has pass fraction " << gammaFilter->GetPassFraction()
+      << " and maximum gamma " << GetMaximumGamma(gammaFilter) << " instead of at most " << shiftGamma << std::endl;
+    return false;
+  }
+
+  gammaFilter->SetShiftSearchRangeMm(3.0);
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  if (!gammaFilter->Update())
+  {
+    std::cerr << "Failed to compute gamma of shifted field with shift search" << std::endl;
+    return false;
+  }
+  timer->StopTimer();
+  std::cout << "Gamma of " << IMAGE_DIMENSION << "x" << IMAGE_DIMENSION << " pixels with shift search computed in "
+    << timer->GetElapsedTime() << "s" << std::endl;
+
+  double sampleSpacing = PIXEL_SPACING / gammaFilter->GetNumberOfSamplesPerPixel();
+  double* foundShift = gammaFilter->GetShiftMm();
+  if (fabs(foundShift[0] - shift[0]) > sampleSpacing || fabs(foundShift[1] - shift[1]) > sampleSpacing)
+  {
+    std::cerr << "Found shift (" << foundShift[0] << ", " << foundShift[1] << ") instead of ("
+      << shift[0] << ", " << shift[1] << ")" << std::endl;
+    return false;
+  }
+  if (GetMaximumGamma(gammaFilter) > sampleSpacing / DTA)
+  {
+    std::cerr << "Maximum gamma " << GetMaximumGamma(gammaFilter) << " after shift search" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Compare image with larger pixels in a parallel plane is sampled on its own pixels
+bool TestResampledField()
+{
+  vtkSmartPointer<vtkOrientedImageData> referenceDose = CreateGaussianField(1.0, 0.0, 0.0);
+  vtkSmartPointer<vtkOrientedImageData> compareDose = CreateGaussianField(1.0, 0.0, 0.0,
+    IMAGE_DIMENSION / 2, PIXEL_SPACING * 2.0, 100.0);
+  vtkNew<vtkPlanarGammaDoseComparisonFilter> gammaFilter;
+  SetUpGammaFilter(gammaFilter, referenceDose, compareDose);
+  if (!gammaFilter->Update())
+  {
+    std::cerr << "Failed to compute gamma of resampled field" << std::endl;
+    return false;
+  }
+  if (gammaFilter->GetPassFraction() != 1.0 || GetMaximumGamma(gammaFilter) > 0.01)
+  {
+    std::cerr << "Resampled field has pass fraction " << gammaFilter->GetPassFraction()
+      << " and maximum gamma " << GetMaximumGamma(gammaFilter) << std::endl;
+    return false;
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlanarGammaDoseComparisonFilterTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  if (!TestIdenticalFields())
+  {
+    return EXIT_FAILURE;
+  }
+  if (!TestScaledField())
+  {
+    return EXIT_FAILURE;
+  }
+  if (!TestShiftedField())
+  {
+    return EXIT_FAILURE;
+  }
+  if (!TestResampledField())
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
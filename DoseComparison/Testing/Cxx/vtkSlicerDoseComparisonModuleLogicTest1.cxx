@@ -36,6 +36,8 @@
 #include <vtkImageData.h>
 #include <vtkMatrix4x4.h>
 #include <vtkImageMathematics.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
 
 // ITK includes
 #include "itkFactoryRegistration.h"
@@ -43,6 +45,40 @@
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <cmath>
+#include <string>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+/// Create single slice dose volume with a Gaussian field of 1 mm pixels, shifted along the columns
+vtkMRMLScalarVolumeNode* CreatePlanarDoseVolumeNode(vtkMRMLScene* scene, const char* name, double shiftMm)
+{
+  const int size = 64;
+  const double sigmaMm = 12.0;
+  vtkSmartPointer<vtkImageData> doseImage = vtkSmartPointer<vtkImageData>::New();
+  doseImage->SetDimensions(size, size, 1);
+  doseImage->AllocateScalars(VTK_FLOAT, 1);
+  float* doseValues = static_cast<float*>(doseImage->GetScalarPointer());
+  for (int j = 0; j < size; ++j)
+  {
+    for (int i = 0; i < size; ++i)
+    {
+      double x = i - size / 2 - shiftMm;
+      double y = j - size / 2;
+      doseValues[j * size + i] = static_cast<float>(2.0 * exp(-(x * x + y * y) / (2.0 * sigmaMm * sigmaMm)));
+    }
+  }
+
+  vtkSmartPointer<vtkMRMLScalarVolumeNode> doseVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+  doseVolumeNode->SetName(name);
+  doseVolumeNode->SetAndObserveImageData(doseImage);
+  scene->AddNode(doseVolumeNode);
+  return doseVolumeNode;
+}
+}
+
 //-----------------------------------------------------------------------------
 int vtkSlicerDoseComparisonModuleLogicTest1( int argc, char * argv[] )
 {
@@ -183,5 +219,159 @@ int vtkSlicerDoseComparisonModuleLogicTest1( int argc, char * argv[] )
     return EXIT_FAILURE;
   }
 
+  // Compute gamma with the multiresolution search into a new volume. It uses nearest neighbor search as the baseline,
+  // so the pass/fail map and the pass rate must agree with it. Gamma of the failing voxels is only a lower bound
+  double plastimatchPassFractionPercent = paramNode->GetPassFractionPercent();
+  vtkSmartPointer<vtkMRMLScalarVolumeNode> multiresolutionGammaVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+  multiresolutionGammaVolumeNode->SetName("OutputGammaMultiresolution");
+  mrmlScene->AddNode(multiresolutionGammaVolumeNode);
+  paramNode->SetAndObserveGammaVolumeNode(multiresolutionGammaVolumeNode);
+  paramNode->SetGammaAlgorithm(vtkMRMLDoseComparisonNode::GammaAlgorithmMultiresolution);
+
+  std::string errorMessage = doseComparisonLogic->ComputeGammaDoseDifference(paramNode);
+  if (!errorMessage.empty() || !multiresolutionGammaVolumeNode->GetImageData())
+  {
+    errorStream << "ERROR: Failed to compute multiresolution gamma: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  outputStream << paramNode->GetReportString();
+
+  const double passFractionTolerancePercent = 0.01;
+  if (fabs(paramNode->GetPassFractionPercent() - plastimatchPassFractionPercent) > passFractionTolerancePercent)
+  {
+    errorStream << "ERROR: Multiresolution gamma pass rate " << paramNode->GetPassFractionPercent()
+      << "% differs from plastimatch pass rate " << plastimatchPassFractionPercent << "%" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkDataArray* multiresolutionGammaArray = multiresolutionGammaVolumeNode->GetImageData()->GetPointData()->GetScalars();
+  vtkDataArray* baselineGammaArray = baselineGammaVolumeNode->GetImageData()->GetPointData()->GetScalars();
+  if (multiresolutionGammaArray->GetNumberOfTuples() != baselineGammaArray->GetNumberOfTuples())
+  {
+    errorStream << "ERROR: Multiresolution gamma volume has different dimensions than the baseline" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkIdType numberOfPassFailMismatches = 0;
+  for (vtkIdType index = 0; index < baselineGammaArray->GetNumberOfTuples(); ++index)
+  {
+    if ((multiresolutionGammaArray->GetTuple1(index) <= 1.0) != (baselineGammaArray->GetTuple1(index) <= 1.0))
+    {
+      ++numberOfPassFailMismatches;
+    }
+  }
+  outputStream << "Number of voxels with different pass/fail result than the baseline: " << numberOfPassFailMismatches << std::endl;
+  if (numberOfPassFailMismatches > 1e-4 * baselineGammaArray->GetNumberOfTuples())
+  {
+    errorStream << "ERROR: Multiresolution gamma pass/fail map differs from the baseline" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Compute the pass rate only, without gamma volume. The early exit search decides the same pass/fail result
+  // for each voxel as the full search, so the pass rate must be the same as the one computed with gamma volume
+  double fullVolumePassFractionPercent = paramNode->GetPassFractionPercent();
+  paramNode->SetAndObserveGammaVolumeNode(nullptr);
+  paramNode->PassRateOnlyOn();
+  paramNode->SetNumberOfGammaHistogramBins(10);
+  errorMessage = doseComparisonLogic->ComputeGammaDoseDifference(paramNode);
+  if (!errorMessage.empty() || !paramNode->GetResultsValid())
+  {
+    errorStream << "ERROR: Failed to compute gamma pass rate: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  outputStream << paramNode->GetReportString();
+  if (paramNode->GetPassFractionPercent() != fullVolumePassFractionPercent)
+  {
+    errorStream << "ERROR: Gamma pass rate " << paramNode->GetPassFractionPercent()
+      << "% differs from the pass rate computed with gamma volume " << fullVolumePassFractionPercent << "%" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Compute the geometric gamma pass rate with plastimatch (interpolated search) into a new volume
+  vtkSmartPointer<vtkMRMLScalarVolumeNode> geometricGammaVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+  geometricGammaVolumeNode->SetName("OutputGammaGeometric");
+  mrmlScene->AddNode(geometricGammaVolumeNode);
+  paramNode->SetAndObserveGammaVolumeNode(geometricGammaVolumeNode);
+  paramNode->PassRateOnlyOff();
+  paramNode->SetGammaAlgorithm(vtkMRMLDoseComparisonNode::GammaAlgorithmPlastimatch);
+  paramNode->UseGeometricGammaCalculationOn();
+  errorMessage = doseComparisonLogic->ComputeGammaDoseDifference(paramNode);
+  if (!errorMessage.empty() || !paramNode->GetResultsValid())
+  {
+    errorStream << "ERROR: Failed to compute geometric gamma with plastimatch: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  double plastimatchGeometricPassFractionPercent = paramNode->GetPassFractionPercent();
+
+  // Compute the geometric gamma pass rate only. The compare dose is interpolated along the voxel edges, which
+  // is close to the interpolated search of plastimatch. Interpolation can only decrease gamma, so the pass rate
+  // cannot be lower than the one of the nearest neighbor search
+  paramNode->SetAndObserveGammaVolumeNode(nullptr);
+  paramNode->PassRateOnlyOn();
+  errorMessage = doseComparisonLogic->ComputeGammaDoseDifference(paramNode);
+  if (!errorMessage.empty() || !paramNode->GetResultsValid())
+  {
+    errorStream << "ERROR: Failed to compute geometric gamma pass rate: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  outputStream << paramNode->GetReportString();
+  if (paramNode->GetPassFractionPercent() < fullVolumePassFractionPercent)
+  {
+    errorStream << "ERROR: Geometric gamma pass rate " << paramNode->GetPassFractionPercent()
+      << "% is lower than the nearest neighbor pass rate " << fullVolumePassFractionPercent << "%" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const double geometricPassFractionTolerancePercent = 0.5;
+  if (fabs(paramNode->GetPassFractionPercent() - plastimatchGeometricPassFractionPercent) > geometricPassFractionTolerancePercent)
+  {
+    errorStream << "ERROR: Geometric gamma pass rate " << paramNode->GetPassFractionPercent()
+      << "% differs from plastimatch geometric gamma pass rate " << plastimatchGeometricPassFractionPercent << "%" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Compute planar gamma of single slice dose images. The compare dose is shifted within the DTA
+  vtkSmartPointer<vtkMRMLScalarVolumeNode> planarGammaVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+  planarGammaVolumeNode->SetName("OutputGammaPlanar");
+  mrmlScene->AddNode(planarGammaVolumeNode);
+  paramNode->SetAndObserveReferenceDoseVolumeNode(CreatePlanarDoseVolumeNode(mrmlScene, "PlanarReferenceDose", 0.0));
+  paramNode->SetAndObserveCompareDoseVolumeNode(CreatePlanarDoseVolumeNode(mrmlScene, "PlanarCompareDose", 1.0));
+  paramNode->SetAndObserveGammaVolumeNode(planarGammaVolumeNode);
+  paramNode->PassRateOnlyOff();
+  paramNode->SetGammaAlgorithm(vtkMRMLDoseComparisonNode::GammaAlgorithmPlanar);
+  errorMessage = doseComparisonLogic->ComputeGammaDoseDifference(paramNode);
+  if (!errorMessage.empty() || !paramNode->GetResultsValid())
+  {
+    errorStream << "ERROR: Failed to compute planar gamma: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  outputStream << paramNode->GetReportString();
+  vtkImageData* planarGammaImage = planarGammaVolumeNode->GetImageData();
+  if (!planarGammaImage || planarGammaImage->GetDimensions()[0] != 64
+    || planarGammaImage->GetDimensions()[1] != 64 || planarGammaImage->GetDimensions()[2] != 1)
+  {
+    errorStream << "ERROR: Invalid planar gamma image" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (paramNode->GetPassFractionPercent() != 100.0)
+  {
+    errorStream << "ERROR: Planar gamma pass rate " << paramNode->GetPassFractionPercent()
+      << "% of a shift within the DTA is not 100%" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Pass rate only mode computes the same planar gamma without the gamma volume
+  paramNode->SetAndObserveGammaVolumeNode(nullptr);
+  paramNode->PassRateOnlyOn();
+  errorMessage = doseComparisonLogic->ComputeGammaDoseDifference(paramNode);
+  if (!errorMessage.empty() || !paramNode->GetResultsValid() || paramNode->GetPassFractionPercent() != 100.0)
+  {
+    errorStream << "ERROR: Failed to compute planar gamma pass rate only: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (paramNode->GetReportString() == nullptr || std::string(paramNode->GetReportString()).find("Planar gamma") != 0)
+  {
+    errorStream << "ERROR: Pass rate only mode did not use the planar gamma algorithm" << std::endl;
+    return EXIT_FAILURE;
+  }
+
   return EXIT_SUCCESS;
 }
@@ -27,17 +27,146 @@
 #include "vtkMRMLDoseVolumeHistogramNode.h"
 
 // VTK includes
+#include <vtkCollection.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
 #include <vtkImageData.h>
-#include <vtkImageAccumulate.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
 #include <vtkTable.h>
 #include <vtkVersion.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerDoseVolumeHistogramComparisonLogic);
 
+namespace
+{
+  /// DVH curve as (dose, volume) points
+  typedef std::vector< std::pair<double,double> > DvhPoints;
+
+  /// Input of a DVH comparison: the points of the baseline DVH (the one with less bins) are evaluated against
+  /// the points of the current DVH, which are sorted by dose so that only the dose-to-agreement window is searched
+  struct DvhComparisonInput
+  {
+    DvhPoints BaselinePoints;
+    DvhPoints CurrentPointsSortedByDose;
+    double TotalVolumeCCs{0.0};
+  };
+
+  //----------------------------------------------------------------------------
+  void GetDvhPoints(vtkTable* dvhTable, DvhPoints& points)
+  {
+    vtkIdType numberOfPoints = dvhTable->GetNumberOfRows();
+    points.resize(numberOfPoints);
+    for (vtkIdType index = 0; index < numberOfPoints; ++index)
+    {
+      points[index].first = dvhTable->GetValue(index, 0).ToDouble();
+      points[index].second = dvhTable->GetValue(index, 1).ToDouble();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /// Read the DVH tables of a comparison. Called from the main thread only, as it accesses the MRML nodes
+  bool GetDvhComparisonInput(vtkMRMLTableNode* dvh1TableNode, vtkMRMLTableNode* dvh2TableNode, DvhComparisonInput& input)
+  {
+    vtkTable* dvh1Table = dvh1TableNode->GetTable();
+    vtkTable* dvh2Table = dvh2TableNode->GetTable();
+    if (!dvh1Table || !dvh2Table || dvh1Table->GetNumberOfColumns() < 2 || dvh2Table->GetNumberOfColumns() < 2)
+    {
+      vtkErrorWithObjectMacro(dvh1TableNode, "GetDvhComparisonInput: Invalid DVH table!");
+      return false;
+    }
+
+    // The table with the smallest number of rows is the baseline, the total volume is read from the other
+    vtkMRMLTableNode* baselineTableNode = dvh2TableNode;
+    vtkMRMLTableNode* currentTableNode = dvh1TableNode;
+    if (dvh1Table->GetNumberOfRows() < dvh2Table->GetNumberOfRows())
+    {
+      baselineTableNode = dvh1TableNode;
+      currentTableNode = dvh2TableNode;
+    }
+
+    std::ostringstream attributeNameStream;
+    attributeNameStream << vtkMRMLDoseVolumeHistogramNode::DVH_ATTRIBUTE_PREFIX << vtkSlicerDoseVolumeHistogramModuleLogic::DVH_METRIC_TOTAL_VOLUME_CC;
+    const char* totalVolumeChar = currentTableNode->GetAttribute(attributeNameStream.str().c_str());
+    input.TotalVolumeCCs = (totalVolumeChar ? vtkVariant(totalVolumeChar).ToDouble() : 0.0);
+    if (input.TotalVolumeCCs <= 0.0)
+    {
+      vtkErrorWithObjectMacro(dvh1TableNode, "GetDvhComparisonInput: Invalid volume for structure!");
+      return false;
+    }
+
+    GetDvhPoints(baselineTableNode->GetTable(), input.BaselinePoints);
+    GetDvhPoints(currentTableNode->GetTable(), input.CurrentPointsSortedByDose);
+    std::sort(input.CurrentPointsSortedByDose.begin(), input.CurrentPointsSortedByDose.end());
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Get percent of baseline points for which there is a current point with gamma <= 1.
+  /// Gamma of a baseline point with dose di and volume vi and a current point with dose dr and volume vr is (Ebert2010):
+  ///   [ ( (100*(vr-vi)) / (volumeDifferenceCriterion * totalVolume) )^2 + ( (100*(dr-di)) / (doseToAgreementCriterion * maxDose) )^2 ] ^ 1/2
+  /// Gamma is never smaller than its dose term, so only the current points within the dose-to-agreement of the baseline
+  /// point are visited, starting from the nearest dose found by binary search, and the search stops at the first
+  /// agreeing point. Complexity is O(N log M) for N baseline and M current points (plus the size of the windows).
+  double GetAgreementAcceptancePercentage(const DvhComparisonInput& input, double doseMax,
+                                          double volumeDifferenceCriterion, double doseToAgreementCriterion)
+  {
+    const DvhPoints& currentPoints = input.CurrentPointsSortedByDose;
+    if (input.BaselinePoints.empty())
+    {
+      return 0.0;
+    }
+
+    const double volumeTolerance = volumeDifferenceCriterion * input.TotalVolumeCCs;
+    const double doseTolerance = doseToAgreementCriterion * doseMax;
+    int numberOfAcceptedAgreements = 0;
+    for (const std::pair<double,double>& baselinePoint : input.BaselinePoints)
+    {
+      double di = baselinePoint.first;
+      double vi = baselinePoint.second;
+
+      // Same expression as the exhaustive search over all current points, so that the result is identical
+      bool outsideWindow = false;
+      auto agrees = [&](const std::pair<double,double>& currentPoint)
+      {
+        double doseTerm = ( 100.0*(currentPoint.first-di) ) / doseTolerance;
+        outsideWindow = (fabs(doseTerm) > 1.0);
+        return !outsideWindow
+          && sqrt( pow( ( 100.0*(currentPoint.second-vi) ) / volumeTolerance, 2) + pow(doseTerm, 2) ) <= 1.0;
+      };
+
+      DvhPoints::const_iterator nearestIt = std::lower_bound(
+        currentPoints.begin(), currentPoints.end(), std::make_pair(di, -VTK_DOUBLE_MAX) );
+      bool accepted = false;
+      for (DvhPoints::const_iterator it = nearestIt; it != currentPoints.end() && !accepted && !outsideWindow; ++it)
+      {
+        accepted = agrees(*it);
+      }
+      outsideWindow = false;
+      for (DvhPoints::const_iterator it = nearestIt; it != currentPoints.begin() && !accepted && !outsideWindow; )
+      {
+        --it;
+        accepted = agrees(*it);
+      }
+
+      if (accepted)
+      {
+        numberOfAcceptedAgreements++;
+      }
+    }
+
+    return 100.0 * (double)numberOfAcceptedAgreements / (double)input.BaselinePoints.size();
+  }
+}
+
 //-----------------------------------------------------------------------------
 vtkSlicerDoseVolumeHistogramComparisonLogic::vtkSlicerDoseVolumeHistogramComparisonLogic() = default;
 
@@ -55,134 +184,104 @@ double vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTables(vtkMRMLTabl
     return 0.0;
   }
 
-  vtkTable* dvh1Table = dvh1TableNode->GetTable();
-  unsigned int dvh1Size = dvh1Table->GetNumberOfRows();
-
-  vtkTable* dvh2Table = dvh2TableNode->GetTable();
-  unsigned int dvh2Size = dvh2Table->GetNumberOfRows();
-
-  vtkTable* baselineDoubleArray = nullptr;
-  unsigned int baselineSize = 0;
-
-  vtkTable* currentDoubleArray = nullptr;
-  //unsigned int currentSize = 0; //This variable might be used for sanity checks later
-
-  // Determine total volume from the attribute of the current double array node
-  std::ostringstream attributeNameStream;
-  attributeNameStream << vtkMRMLDoseVolumeHistogramNode::DVH_ATTRIBUTE_PREFIX << vtkSlicerDoseVolumeHistogramModuleLogic::DVH_METRIC_TOTAL_VOLUME_CC;
-  const char* totalVolumeChar;
-
-  // The vtkDoubleArray with the smallest number of tuples is the baseline
-  if (dvh1Size < dvh2Size)
+  // Determine maximum dose
+  if (doseVolumeNode)
   {
-    baselineDoubleArray = dvh1Table;
-    baselineSize = dvh1Size;
-
-    currentDoubleArray = dvh2Table;
-    //currentSize = dvh2Size;
-  
-    totalVolumeChar = dvh2TableNode->GetAttribute(attributeNameStream.str().c_str());
+    vtkDebugWithObjectMacro(dvh1TableNode, "vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTables: Getting maximum dose from the given dose volume");
+    doseMax = vtkSlicerDoseVolumeHistogramComparisonLogic::GetMaximumDose(doseVolumeNode);
   }
-  else
+  if (doseMax <= 0.0)
   {
-    baselineDoubleArray = dvh2Table;
-    baselineSize = dvh2Size;
-
-    currentDoubleArray = dvh1Table;
-    //currentSize = dvh1Size;
+    vtkErrorWithObjectMacro(dvh1TableNode, "vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTables: Invalid maximum dose!");
+    return 0.0;
+  }
 
-    totalVolumeChar = dvh1TableNode->GetAttribute(attributeNameStream.str().c_str());
+  // Compare the current DVH to the baseline
+  DvhComparisonInput input;
+  if (!GetDvhComparisonInput(dvh1TableNode, dvh2TableNode, input))
+  {
+    return 0.0;
   }
+  return GetAgreementAcceptancePercentage(input, doseMax, volumeDifferenceCriterion, doseToAgreementCriterion);
+}
 
-  // Read the total volume from the current node attribute
-  double totalVolumeCCs = 0;
-  if (totalVolumeChar != nullptr)
+//-----------------------------------------------------------------------------
+bool vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTableCollections(vtkCollection* dvh1TableNodes, vtkCollection* dvh2TableNodes,
+                                                                               vtkMRMLScalarVolumeNode* doseVolumeNode,
+                                                                               double volumeDifferenceCriterion, double doseToAgreementCriterion,
+                                                                               vtkDoubleArray* agreementAcceptancePercentages, double doseMax/*=0.0*/ )
+{
+  if (!dvh1TableNodes || !dvh2TableNodes || !agreementAcceptancePercentages)
   {
-    totalVolumeCCs = vtkVariant(totalVolumeChar).ToDouble();
+    vtkGenericWarningMacro("vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTableCollections: Invalid inputs!");
+    return false;
   }
-  
-  if (totalVolumeCCs == 0)
+  int numberOfPairs = dvh1TableNodes->GetNumberOfItems();
+  if (dvh2TableNodes->GetNumberOfItems() != numberOfPairs)
   {
-    vtkErrorWithObjectMacro(dvh1TableNode, "vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTables: Invalid volume for structure!");
+    vtkGenericWarningMacro("vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTableCollections: Number of DVH tables do not match ("
+      << numberOfPairs << "<>" << dvh2TableNodes->GetNumberOfItems() << ")");
+    return false;
   }
 
-  // Determine maximum dose
+  agreementAcceptancePercentages->SetNumberOfComponents(1);
+  agreementAcceptancePercentages->SetNumberOfTuples(numberOfPairs);
+  agreementAcceptancePercentages->FillValue(0.0);
+
+  // Determine maximum dose once for all pairs
   if (doseVolumeNode)
   {
-    vtkDebugWithObjectMacro(dvh1TableNode, "vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTables: Calculating maximum dose from the given dose volume");
-    vtkNew<vtkImageAccumulate> doseStat;
-    doseStat->SetInputData(doseVolumeNode->GetImageData());
-    doseStat->Update();
-    doseMax = doseStat->GetMax()[0];
+    doseMax = vtkSlicerDoseVolumeHistogramComparisonLogic::GetMaximumDose(doseVolumeNode);
   }
-
-  // Compare the current DVH to the baseline and determine mean and maximum difference
-  double agreementAcceptancePercentage = 0.0;
-  int numberOfAcceptedAgreements = 0;
-
-  for (unsigned int baselineIndex=0; baselineIndex < baselineSize; ++baselineIndex)
+  if (doseMax <= 0.0)
   {
-    // Compute the agreement for the current baseline bin
-    double agreement = vtkSlicerDoseVolumeHistogramComparisonLogic::GetAgreementForDvhPlotPoint(
-      currentDoubleArray, baselineDoubleArray, baselineIndex, totalVolumeCCs, doseMax, volumeDifferenceCriterion, doseToAgreementCriterion );
+    vtkGenericWarningMacro("vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTableCollections: Invalid maximum dose!");
+    return false;
+  }
 
-    if (agreement == -1.0)
+  // Read the tables on this thread, then compare the pairs in parallel
+  std::vector<DvhComparisonInput> inputs(numberOfPairs);
+  std::vector<char> validInputs(numberOfPairs, 0);
+  for (int pairIndex = 0; pairIndex < numberOfPairs; ++pairIndex)
+  {
+    vtkMRMLTableNode* dvh1TableNode = vtkMRMLTableNode::SafeDownCast(dvh1TableNodes->GetItemAsObject(pairIndex));
+    vtkMRMLTableNode* dvh2TableNode = vtkMRMLTableNode::SafeDownCast(dvh2TableNodes->GetItemAsObject(pairIndex));
+    if (!dvh1TableNode || !dvh2TableNode)
     {
-      vtkErrorWithObjectMacro(dvh1TableNode, "vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTables: Invalid agreement, skipped!");
-      continue;
+      vtkGenericWarningMacro("vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTableCollections: Invalid DVH table node at index " << pairIndex);
+      return false;
     }
-    if (agreement <= 1.0)
+    validInputs[pairIndex] = GetDvhComparisonInput(dvh1TableNode, dvh2TableNode, inputs[pairIndex]);
+  }
+
+  double* percentages = agreementAcceptancePercentages->GetPointer(0);
+  vtkSMPTools::For(0, numberOfPairs, [&](vtkIdType beginPair, vtkIdType endPair)
+  {
+    for (vtkIdType pairIndex = beginPair; pairIndex < endPair; ++pairIndex)
     {
-      numberOfAcceptedAgreements++;
+      if (validInputs[pairIndex])
+      {
+        percentages[pairIndex] = GetAgreementAcceptancePercentage(
+          inputs[pairIndex], doseMax, volumeDifferenceCriterion, doseToAgreementCriterion );
+      }
     }
-  }
-  
-  agreementAcceptancePercentage = 100.0 * (double)numberOfAcceptedAgreements / (double)baselineSize;
+  });
+  agreementAcceptancePercentages->Modified();
 
-  return agreementAcceptancePercentage;
+  return true;
 }
 
 //-----------------------------------------------------------------------------
-double vtkSlicerDoseVolumeHistogramComparisonLogic::GetAgreementForDvhPlotPoint( vtkTable* referenceDvhPlot, vtkTable* compareDvhPlot,
-                                                                                 unsigned int compareIndex, double totalVolumeCCs, double doseMax,
-                                                                                 double volumeDifferenceCriterion, double doseToAgreementCriterion )
+double vtkSlicerDoseVolumeHistogramComparisonLogic::GetMaximumDose(vtkMRMLScalarVolumeNode* doseVolumeNode)
 {
-  // Formula is (based on the article Ebert2010):
-  //   gamma(i) = min{ Gamma[(di, vi), (dr, vr)] } for all {r=1..P}, where
-  //   compareIndexth DVH point has dose di and volume vi
-  //   P is the number of bins in the reference DVH, each rth bin having absolute dose dr and volume vr
-  //   Gamma[(di, vi), (dr, vr)] = [ ( (100*(vr-vi)) / (volumeDifferenceCriterion * totalVolume) )^2 + ( (100*(dr-di)) / (doseToAgreementCriterion * maxDose) )^2 ] ^ 1/2
-  //   volumeDifferenceCriterion is the volume-difference criterion (% of the total structure volume, totalVolume)
-  //   doseToAgreementCriterion is the dose-to-agreement criterion (% of the maximum dose, maxDose)
-  // A value of gamma(i) < 1 indicates agreement for the DVH bin compareIndex
-
-  unsigned int compareSize = compareDvhPlot->GetNumberOfRows();
-  if (compareIndex >= compareSize)
+  vtkImageData* doseImageData = (doseVolumeNode ? doseVolumeNode->GetImageData() : nullptr);
+  vtkDataArray* doseScalars = (doseImageData ? doseImageData->GetPointData()->GetScalars() : nullptr);
+  if (!doseScalars || doseScalars->GetNumberOfTuples() == 0)
   {
-    vtkGenericWarningMacro("Invalid bin index for compare plot! (" << compareIndex << ">=" << compareSize << ")");
-    return -1.0;
-  }
-
-  double gamma = VTK_DOUBLE_MAX;
-
-  // Get the dose and volume values from the current bin in the 'compare' double array.
-  double di = compareDvhPlot->GetValue(compareIndex, 0).ToDouble();
-  double vi = compareDvhPlot->GetValue(compareIndex, 1).ToDouble();
-
-  for (int referenceIndex = 0; referenceIndex != referenceDvhPlot->GetNumberOfRows(); ++referenceIndex)
-  {
-    // Get the dose and volume values from the current bin in the 'reference' double array.
-    double dr = referenceDvhPlot->GetValue(referenceIndex, 0).ToDouble();
-    double vr = referenceDvhPlot->GetValue(referenceIndex, 1).ToDouble();
-
-    double currentGamma = sqrt(   pow( ( 100.0*(vr-vi) ) / ( volumeDifferenceCriterion * totalVolumeCCs ),2)
-                                + pow( ( 100.0*(dr-di) ) / ( doseToAgreementCriterion * doseMax ),2) );
-
-    if (currentGamma < gamma)
-    {
-      gamma = currentGamma;     
-    }
+    vtkGenericWarningMacro("vtkSlicerDoseVolumeHistogramComparisonLogic::GetMaximumDose: Invalid dose volume!");
+    return 0.0;
   }
 
-  return gamma;
+  // The range is cached by the data array until the dose is modified
+  return doseScalars->GetRange(0)[1];
 }
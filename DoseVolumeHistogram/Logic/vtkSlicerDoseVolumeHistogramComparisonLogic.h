@@ -31,6 +31,9 @@
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLTableNode.h>
 
+class vtkCollection;
+class vtkDoubleArray;
+
 class VTK_SLICER_DOSEVOLUMEHISTOGRAM_LOGIC_EXPORT  vtkSlicerDoseVolumeHistogramComparisonLogic : public vtkObject
 {
 
@@ -44,18 +47,17 @@ public:
   static double CompareDvhTables( vtkMRMLTableNode* dvh1TableNode, vtkMRMLTableNode* dvh2TableNode, vtkMRMLScalarVolumeNode* doseVolumeNode, 
                                   double volumeDifferenceCriterion, double doseToAgreementCriterion, double doseMax=0.0 );
 
-protected:
-  // Formula is (based on the article Ebert2010):
-  //   gamma(i) = min{ Gamma[(di, vi), (dr, vr)] } for all {r=1..P}, where
-  //   compareIndexth Dvh point has dose di and volume vi
-  //   P is the number of bins in the reference Dvh, each rth bin having absolute dose dr and volume vr
-  //   Gamma[(di, vi), (dr, vr)] = [ ( (100*(vr-vi)) / (volumeDifferenceCriterion * totalVolume) )^2 + ( (100*(dr-di)) / (doseToAgreementCriterion * maxDose) )^2 ] ^ 1/2
-  //   volumeDifferenceCriterion is the volume-difference criterion (% of the total structure volume, totalVolume)
-  //   doseToAgreementCriterion is the dose-to-agreement criterion (% of the maximum dose, maxDose)
-  // A return value of < 1 indicates agreement for the Dvh bin
-  static double GetAgreementForDvhPlotPoint( vtkTable* referenceDvhPlot, vtkTable* compareDvhPlot,
-                                             unsigned int compareIndex, double totalVolumeCCs, double doseMax,
-                                             double volumeDifferenceCriterion, double doseToAgreementCriterion );
+  // Compare pairs of DVH tables in one call, the ith table in the first collection to the ith table in the second.
+  // The maximum dose is determined once for all pairs, and the pairs are compared in parallel.
+  // The percent of agreeing bins for each pair is returned in agreementAcceptancePercentages.
+  // Returns false if the collections contain different number of tables or a non-table item.
+  static bool CompareDvhTableCollections( vtkCollection* dvh1TableNodes, vtkCollection* dvh2TableNodes, vtkMRMLScalarVolumeNode* doseVolumeNode,
+                                          double volumeDifferenceCriterion, double doseToAgreementCriterion,
+                                          vtkDoubleArray* agreementAcceptancePercentages, double doseMax=0.0 );
+
+  // Get maximum dose in a dose volume. Uses the cached scalar range of the volume, so it is only
+  // recalculated if the dose has changed. Returns 0 if the volume is invalid.
+  static double GetMaximumDose(vtkMRMLScalarVolumeNode* doseVolumeNode);
 
 protected:
   vtkSlicerDoseVolumeHistogramComparisonLogic();
@@ -47,6 +47,7 @@
 #include <vtkMRMLVolumeArchetypeStorageNode.h>
 
 // VTK includes
+#include <vtkDoubleArray.h>
 #include <vtkImageData.h>
 #include <vtkImageAccumulate.h>
 #include <vtkLookupTable.h>
@@ -60,6 +61,10 @@
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <utility>
+#include <vector>
+
 std::string csvSeparatorCharacter(",");
 
 //-----------------------------------------------------------------------------
@@ -69,6 +74,9 @@ int CompareCsvDvhTables(std::string dvhMetricsCsvFileName, std::string baselineC
 
 int CompareCsvDvhMetrics(std::string dvhMetricsCsvFileName, std::string baselineDvhMetricCsvFileName, double metricDifferenceThreshold);
 
+double GetExhaustiveAgreementAcceptancePercentage(vtkMRMLTableNode* currentTableNode, vtkMRMLTableNode* baselineTableNode,
+                                                  double maxDose, double volumeDifferenceCriterion, double doseToAgreementCriterion);
+
 //-----------------------------------------------------------------------------
 int vtkSlicerDoseVolumeHistogramModuleLogicTest1( int argc, char * argv[] )
 {
@@ -604,6 +612,15 @@ int CompareCsvDvhTables(std::string dvhCsvFileName, std::string baselineCsvFileN
     return 1;
   }
 
+  // Compare all the structures in one call, the results must be the same as for the individual comparisons
+  vtkNew<vtkDoubleArray> acceptedBinsRatios;
+  if (!vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTableCollections(
+    currentDvh, baselineDvh, nullptr, volumeDifferenceCriterion, doseToAgreementCriterion, acceptedBinsRatios, maxDose ))
+  {
+    std::cerr << "ERROR: Failed to compare the DVH table collections" << std::endl;
+    return 1;
+  }
+
   for (int structureIndex=0; structureIndex < currentDvh->GetNumberOfItems(); structureIndex++)
   {
     vtkMRMLTableNode* currentStructure = vtkMRMLTableNode::SafeDownCast(currentDvh->GetItemAsObject(structureIndex));
@@ -612,6 +629,22 @@ int CompareCsvDvhTables(std::string dvhCsvFileName, std::string baselineCsvFileN
     // Calculate the agreement percentage for the current structure.
     double acceptedBinsRatio = vtkSlicerDoseVolumeHistogramComparisonLogic::CompareDvhTables(
       currentStructure, baselineStructure, nullptr, volumeDifferenceCriterion, doseToAgreementCriterion, maxDose );
+    if (acceptedBinsRatio != acceptedBinsRatios->GetValue(structureIndex))
+    {
+      std::cerr << "ERROR: Batch DVH comparison result differs for structure " << structureIndex << " ("
+        << acceptedBinsRatios->GetValue(structureIndex) << "<>" << acceptedBinsRatio << ")" << std::endl;
+      return 1;
+    }
+
+    // The dose-window search of the logic must give the same result as the exhaustive search
+    double exhaustiveAcceptedBinsRatio = GetExhaustiveAgreementAcceptancePercentage(
+      currentStructure, baselineStructure, maxDose, volumeDifferenceCriterion, doseToAgreementCriterion );
+    if (acceptedBinsRatio != exhaustiveAcceptedBinsRatio)
+    {
+      std::cerr << "ERROR: DVH comparison result differs from the exhaustive search for structure " << structureIndex << " ("
+        << acceptedBinsRatio << "<>" << exhaustiveAcceptedBinsRatio << ")" << std::endl;
+      return 1;
+    }
 
     int numberOfBinsPerStructure = baselineStructure->GetTable()->GetNumberOfRows();
     totalNumberOfBins += numberOfBinsPerStructure;
@@ -686,6 +719,47 @@ double GetAgreementForDvhPlotPoint(std::vector<std::pair<double,double> >& refer
   return gamma;
 }
 
+//-----------------------------------------------------------------------------
+double GetExhaustiveAgreementAcceptancePercentage(vtkMRMLTableNode* currentTableNode, vtkMRMLTableNode* baselineTableNode,
+                                                  double maxDose, double volumeDifferenceCriterion, double doseToAgreementCriterion)
+{
+  // The table with the smallest number of rows is the baseline, the total volume is read from the other (same as in the logic)
+  if (currentTableNode->GetTable()->GetNumberOfRows() < baselineTableNode->GetTable()->GetNumberOfRows())
+  {
+    std::swap(currentTableNode, baselineTableNode);
+  }
+  std::ostringstream volumeAttributeNameStream;
+  volumeAttributeNameStream << vtkMRMLDoseVolumeHistogramNode::DVH_ATTRIBUTE_PREFIX << vtkSlicerDoseVolumeHistogramModuleLogic::DVH_METRIC_TOTAL_VOLUME_CC;
+  const char* totalVolumeChar = currentTableNode->GetAttribute(volumeAttributeNameStream.str().c_str());
+  double totalVolume = (totalVolumeChar ? vtkVariant(totalVolumeChar).ToDouble() : 0.0);
+
+  std::vector<std::pair<double,double> > dvhPlots[2];
+  vtkTable* dvhTables[2] = { currentTableNode->GetTable(), baselineTableNode->GetTable() };
+  for (int tableIndex = 0; tableIndex < 2; ++tableIndex)
+  {
+    for (vtkIdType rowIndex = 0; rowIndex < dvhTables[tableIndex]->GetNumberOfRows(); ++rowIndex)
+    {
+      dvhPlots[tableIndex].push_back( std::make_pair( dvhTables[tableIndex]->GetValue(rowIndex, 0).ToDouble(),
+        dvhTables[tableIndex]->GetValue(rowIndex, 1).ToDouble() ) );
+    }
+  }
+  if (dvhPlots[1].empty())
+  {
+    return 0.0;
+  }
+
+  int numberOfAcceptedAgreements = 0;
+  for (unsigned int baselineIndex = 0; baselineIndex < dvhPlots[1].size(); ++baselineIndex)
+  {
+    if (GetAgreementForDvhPlotPoint(dvhPlots[0], dvhPlots[1], baselineIndex, totalVolume, maxDose,
+      volumeDifferenceCriterion, doseToAgreementCriterion) <= 1.0)
+    {
+      ++numberOfAcceptedAgreements;
+    }
+  }
+  return 100.0 * (double)numberOfAcceptedAgreements / (double)dvhPlots[1].size();
+}
+
 //-----------------------------------------------------------------------------
 int CompareCsvDvhMetrics(std::string dvhMetricsCsvFileName, std::string baselineDvhMetricCsvFileName, double metricDifferenceThreshold)
 {
@@ -24,8 +24,8 @@
 // VTK includes
 #include <vtkImageData.h>
 #include <vtkMatrix4x4.h>
-#include <vtkImageShiftScale.h>
 #include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
 #include "vtksys/SystemTools.hxx"
 
 // MRML includes
@@ -44,6 +44,219 @@
 #include <algorithm>
 #include <cctype>
 #include <functional>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+//----------------------------------------------------------------------------
+namespace
+{
+  /// Size of the chunks of text that are decoded in parallel
+  const std::ptrdiff_t DECODE_CHUNK_SIZE_BYTES = 1 << 20;
+
+  /// Powers of ten that are exactly representable as double
+  const double EXACT_POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+  //----------------------------------------------------------------------------
+  inline bool IsWhitespace(char character)
+  {
+    return character == ' ' || character == '\n' || character == '\r' || character == '\t'
+      || character == '\f' || character == '\v';
+  }
+
+  //----------------------------------------------------------------------------
+  inline bool IsDigit(char character)
+  {
+    return character >= '0' && character <= '9';
+  }
+
+  //----------------------------------------------------------------------------
+  /// Parse the next whitespace separated number in the text, independently of the locale and
+  /// without allocating memory. Fortran style exponents (1.0D-03) are also accepted.
+  /// \param position Position in the text, moved past the parsed number
+  /// \param end End of the text
+  /// \param value Output parsed value
+  /// \return Success flag, false if there is no number or the next item is not a valid number
+  bool ParseNumber(const char*& position, const char* end, double& value)
+  {
+    const char* current = position;
+    while (current < end && IsWhitespace(*current))
+    {
+      ++current;
+    }
+
+    bool negative = false;
+    if (current < end && (*current == '-' || *current == '+'))
+    {
+      negative = (*current == '-');
+      ++current;
+    }
+
+    // Digits beyond the precision of the mantissa only change the exponent
+    const uint64_t maximumMantissaBeforeDigit = 100000000000000000ULL;
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    for (; current < end && IsDigit(*current); ++current)
+    {
+      hasDigits = true;
+      if (mantissa < maximumMantissaBeforeDigit)
+      {
+        mantissa = mantissa * 10 + (*current - '0');
+      }
+      else
+      {
+        ++exponent;
+      }
+    }
+    if (current < end && *current == '.')
+    {
+      for (++current; current < end && IsDigit(*current); ++current)
+      {
+        hasDigits = true;
+        if (mantissa < maximumMantissaBeforeDigit)
+        {
+          mantissa = mantissa * 10 + (*current - '0');
+          --exponent;
+        }
+      }
+    }
+    if (!hasDigits)
+    {
+      return false;
+    }
+
+    if ( current < end
+      && (*current == 'e' || *current == 'E' || *current == 'd' || *current == 'D') )
+    {
+      ++current;
+      bool negativeExponent = false;
+      if (current < end && (*current == '-' || *current == '+'))
+      {
+        negativeExponent = (*current == '-');
+        ++current;
+      }
+      if (current >= end || !IsDigit(*current))
+      {
+        return false;
+      }
+      int exponentValue = 0;
+      for (; current < end && IsDigit(*current); ++current)
+      {
+        if (exponentValue < 10000)
+        {
+          exponentValue = exponentValue * 10 + (*current - '0');
+        }
+      }
+      exponent += (negativeExponent ? -exponentValue : exponentValue);
+    }
+
+    // The number must be followed by whitespace or the end of the text
+    if (current < end && !IsWhitespace(*current))
+    {
+      return false;
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (mantissa != 0 && exponent != 0)
+    {
+      if (exponent >= -22 && exponent <= 22)
+      {
+        result = (exponent < 0 ? result / EXACT_POWERS_OF_TEN[-exponent] : result * EXACT_POWERS_OF_TEN[exponent]);
+      }
+      else
+      {
+        result *= std::pow(10.0, exponent);
+      }
+    }
+    value = (negative ? -result : result);
+    position = current;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Decode the whitespace separated numbers of a text into consecutive blocks of float values.
+  /// The text is split into chunks at whitespace, and the numbers are counted in each chunk so that
+  /// the chunks can be decoded in parallel directly into their place in the output blocks.
+  /// \param blocks Output arrays for each block. Values of blocks that are nullptr are skipped
+  /// \param blockScales Scaling factor applied to the values of each block
+  /// \param numberOfValuesPerBlock Number of values in each block. Values after the last block are ignored
+  /// \return Number of values in the text, or -1 if the text contains an item that is not a valid number
+  vtkIdType DecodeNumberBlocks(const char* begin, const char* end,
+    const std::vector<float*>& blocks, const std::vector<double>& blockScales, vtkIdType numberOfValuesPerBlock)
+  {
+    vtkIdType numberOfChunks = std::max<vtkIdType>(1, (end - begin) / DECODE_CHUNK_SIZE_BYTES);
+    std::vector<const char*> chunkStarts(numberOfChunks + 1, end);
+    chunkStarts[0] = begin;
+    for (vtkIdType chunkIndex = 1; chunkIndex < numberOfChunks; ++chunkIndex)
+    {
+      const char* chunkStart = std::max(chunkStarts[chunkIndex - 1], begin + (end - begin) * chunkIndex / numberOfChunks);
+      while (chunkStart < end && !IsWhitespace(*chunkStart))
+      {
+        ++chunkStart;
+      }
+      chunkStarts[chunkIndex] = chunkStart;
+    }
+
+    // Count the numbers in each chunk, to get the index of the first value of each chunk
+    std::vector<vtkIdType> chunkFirstValueIndices(numberOfChunks + 1, 0);
+    vtkSMPTools::For(0, numberOfChunks, [&](vtkIdType beginChunk, vtkIdType endChunk)
+    {
+      for (vtkIdType chunkIndex = beginChunk; chunkIndex < endChunk; ++chunkIndex)
+      {
+        vtkIdType numberOfValuesInChunk = 0;
+        bool previousIsWhitespace = true;
+        for (const char* current = chunkStarts[chunkIndex]; current < chunkStarts[chunkIndex + 1]; ++current)
+        {
+          bool currentIsWhitespace = IsWhitespace(*current);
+          if (previousIsWhitespace && !currentIsWhitespace)
+          {
+            ++numberOfValuesInChunk;
+          }
+          previousIsWhitespace = currentIsWhitespace;
+        }
+        chunkFirstValueIndices[chunkIndex + 1] = numberOfValuesInChunk;
+      }
+    });
+    for (vtkIdType chunkIndex = 0; chunkIndex < numberOfChunks; ++chunkIndex)
+    {
+      chunkFirstValueIndices[chunkIndex + 1] += chunkFirstValueIndices[chunkIndex];
+    }
+
+    // Decode the chunks
+    std::atomic<bool> valid(true);
+    vtkIdType numberOfBlocks = static_cast<vtkIdType>(blocks.size());
+    vtkSMPTools::For(0, numberOfChunks, [&](vtkIdType beginChunk, vtkIdType endChunk)
+    {
+      for (vtkIdType chunkIndex = beginChunk; chunkIndex < endChunk && valid; ++chunkIndex)
+      {
+        const char* current = chunkStarts[chunkIndex];
+        const char* chunkEnd = chunkStarts[chunkIndex + 1];
+        for (vtkIdType valueIndex = chunkFirstValueIndices[chunkIndex]; valueIndex < chunkFirstValueIndices[chunkIndex + 1]; ++valueIndex)
+        {
+          double value = 0.0;
+          if (!ParseNumber(current, chunkEnd, value))
+          {
+            valid = false;
+            break;
+          }
+          vtkIdType blockIndex = valueIndex / numberOfValuesPerBlock;
+          if (blockIndex < numberOfBlocks && blocks[blockIndex])
+          {
+            blocks[blockIndex][valueIndex % numberOfValuesPerBlock] = static_cast<float>(value * blockScales[blockIndex]);
+          }
+        }
+      }
+    });
+
+    return (valid ? chunkFirstValueIndices[numberOfChunks] : -1);
+  }
+}
+
+//----------------------------------------------------------------------------
+const std::string vtkSlicerDosxyzNrc3dDoseFileReaderLogic::RELATIVE_ERROR_VOLUME_NAME_POSTFIX = "_RelativeError";
+const std::string vtkSlicerDosxyzNrc3dDoseFileReaderLogic::RELATIVE_ERROR_VOLUME_REFERENCE_ROLE = "relativeErrorVolumeRef";
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerDosxyzNrc3dDoseFileReaderLogic);
@@ -71,141 +284,155 @@ void vtkSlicerDosxyzNrc3dDoseFileReaderLogic::PrintSelf(ostream& os, vtkIndent i
 }
 
 //----------------------------------------------------------------------------
-vtkMRMLScalarVolumeNode* vtkSlicerDosxyzNrc3dDoseFileReaderLogic::LoadDosxyzNrc3dDoseFile(char* filename, float intensityScalingFactor/*=1e+18*/)
+bool vtkSlicerDosxyzNrc3dDoseFileReaderLogic::ReadDosxyzNrc3dDoseFile(const char* filename,
+  vtkImageData* doseImageData, vtkImageData* relativeErrorImageData/*=nullptr*/, float intensityScalingFactor/*=1e+18*/)
 {
-  ifstream readFileStream(filename); 
+  if (!filename || !doseImageData)
+  {
+    vtkErrorMacro("ReadDosxyzNrc3dDoseFile: Invalid input arguments");
+    return false;
+  }
+
+  // Read the whole file into memory, so that it can be parsed without stream extraction
+  ifstream readFileStream(filename, std::ios::binary);
   if (!readFileStream)
   {
-    vtkErrorMacro("LoadDosxyzNrc3dDoseFile: The specified file could not be opened.");
-    return nullptr;
+    vtkErrorMacro("ReadDosxyzNrc3dDoseFile: The specified file could not be opened.");
+    return false;
   }
+  readFileStream.seekg(0, std::ios::end);
+  std::streamoff fileSize = readFileStream.tellg();
+  readFileStream.seekg(0, std::ios::beg);
+  std::vector<char> fileContents(fileSize > 0 ? static_cast<size_t>(fileSize) : 0);
+  readFileStream.read(fileContents.data(), fileContents.size());
+  if (fileSize < 0 || readFileStream.gcount() != fileSize)
+  {
+    vtkErrorMacro("ReadDosxyzNrc3dDoseFile: Failed to read the specified file.");
+    return false;
+  }
+  readFileStream.close();
 
   if (intensityScalingFactor == 0)
   {
-    vtkWarningMacro("LoadDosxyzNrc3dDoseFile: Invalid scaling factor of 0 found, setting default value of 1e+18");
+    vtkWarningMacro("ReadDosxyzNrc3dDoseFile: Invalid scaling factor of 0 found, setting default value of 1e+18");
     intensityScalingFactor = 1e+18;
   }
 
-  int size[3] = { 0, 0, 0 };
+  const char* position = fileContents.data();
+  const char* end = position + fileContents.size();
 
   // Read in block 1 (number of voxels in x, y, z directions)
-  readFileStream >> size[0] >> size[1] >> size[2];
-
+  int size[3] = { 0, 0, 0 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    double numberOfVoxels = 0.0;
+    if (ParseNumber(position, end, numberOfVoxels) && numberOfVoxels == std::floor(numberOfVoxels) && numberOfVoxels < VTK_INT_MAX)
+    {
+      size[axis] = static_cast<int>(numberOfVoxels);
+    }
+  }
   if (size[0] <= 0 || size[1] <= 0 || size[2] <= 0)
   {
-    vtkErrorMacro("LoadDosxyzNrc3dDoseFile: Number of voxels in X, Y, or Z direction must be greater than zero." << "numVoxelsX " << size[0] << ", numVoxelsY " << size[1] << ", numVoxelsZ " << size[2]);
-    return nullptr;
+    vtkErrorMacro("ReadDosxyzNrc3dDoseFile: Number of voxels in X, Y, or Z direction must be greater than zero." << "numVoxelsX " << size[0] << ", numVoxelsY " << size[1] << ", numVoxelsZ " << size[2]);
+    return false;
   }
 
-  std::vector<double> voxelBoundariesX(size[0] + 1); 
-  std::vector<double> voxelBoundariesY(size[1] + 1);
-  std::vector<double> voxelBoundariesZ(size[2] + 1);
-  double spacingX = 0;
-  double spacingY = 0;
-  double spacingZ = 0;
-
-  int counter = 0;
-  double initialVoxelSpacing = 0;
-  double currentVoxelSpacing = 0;
-
-  // Read in block 2 (voxel boundaries, cm, in x direction)
-  while (!readFileStream.eof() && counter < size[0] + 1)
+  // Read in blocks 2, 3 and 4 (voxel boundaries, cm, in x, y and z direction)
+  const char* axisNames[3] = { "X", "Y", "Z" };
+  double spacing[3] = { 0.0, 0.0, 0.0 };
+  double origin[3] = { 0.0, 0.0, 0.0 };
+  for (int axis = 0; axis < 3; ++axis)
   {
-    readFileStream >> voxelBoundariesX[counter];
-    voxelBoundariesX[counter] = voxelBoundariesX[counter] * 10.0; // convert from cm to mm
-    if (counter == 1)
+    std::vector<double> voxelBoundaries(size[axis] + 1, 0.0);
+    for (int counter = 0; counter < size[axis] + 1; ++counter)
     {
-      initialVoxelSpacing = fabs(voxelBoundariesX[counter] - voxelBoundariesX[counter - 1]);
-      spacingX = initialVoxelSpacing;
-    }
-    else if (counter > 1)
-    {
-      currentVoxelSpacing = abs(voxelBoundariesX[counter] - voxelBoundariesX[counter - 1]);
-      if (AreEqualWithTolerance(initialVoxelSpacing, currentVoxelSpacing) == false)
+      if (!ParseNumber(position, end, voxelBoundaries[counter]))
+      {
+        vtkErrorMacro("ReadDosxyzNrc3dDoseFile: Failed to read voxel boundaries in " << axisNames[axis] << " direction.");
+        return false;
+      }
+      voxelBoundaries[counter] = voxelBoundaries[counter] * 10.0; // convert from cm to mm
+      if (counter == 1)
       {
-        vtkWarningMacro("LoadDosxyzNrc3dDoseFile: Voxels have uneven spacing in X direction.");
+        spacing[axis] = fabs(voxelBoundaries[counter] - voxelBoundaries[counter - 1]);
+      }
+      else if (counter > 1)
+      {
+        double currentVoxelSpacing = fabs(voxelBoundaries[counter] - voxelBoundaries[counter - 1]);
+        if (AreEqualWithTolerance(spacing[axis], currentVoxelSpacing) == false)
+        {
+          vtkWarningMacro("ReadDosxyzNrc3dDoseFile: Voxels have uneven spacing in " << axisNames[axis] << " direction.");
+        }
       }
     }
-    counter += 1;
+    origin[axis] = voxelBoundaries[0];
   }
 
-  // Read in block 3 (voxel boundaries, cm, in y direction)
-  counter = 0;
-  while (!readFileStream.eof() && counter < size[1] + 1)
+  // Read in block 5 (dose array values) and block 6 (relative errors)
+  doseImageData->SetExtent(0, size[0] - 1, 0, size[1] - 1, 0, size[2] - 1);
+  doseImageData->SetSpacing(spacing);
+  doseImageData->SetOrigin(origin);
+  doseImageData->AllocateScalars(VTK_FLOAT, 1);
+  std::vector<float*> blocks(2, nullptr);
+  blocks[0] = static_cast<float*>(doseImageData->GetScalarPointer());
+  if (relativeErrorImageData)
   {
-    readFileStream >> voxelBoundariesY[counter];
-    voxelBoundariesY[counter] = voxelBoundariesY[counter] * 10.0; // convert from cm to mm
-    if (counter == 1)
-    {
-      initialVoxelSpacing = fabs(voxelBoundariesY[counter] - voxelBoundariesY[counter - 1]);
-      spacingY = initialVoxelSpacing;
-    }
-    else if (counter > 1)
-    {
-      currentVoxelSpacing = abs(voxelBoundariesY[counter] - voxelBoundariesY[counter - 1]);
-      if (AreEqualWithTolerance(initialVoxelSpacing, currentVoxelSpacing) == false)
-      {
-        vtkWarningMacro("LoadDosxyzNrc3dDoseFile: Voxels have uneven spacing in Y direction.");
-      }
-    }
-    counter += 1;
+    relativeErrorImageData->SetExtent(0, size[0] - 1, 0, size[1] - 1, 0, size[2] - 1);
+    relativeErrorImageData->SetSpacing(spacing);
+    relativeErrorImageData->SetOrigin(origin);
+    relativeErrorImageData->AllocateScalars(VTK_FLOAT, 1);
+    blocks[1] = static_cast<float*>(relativeErrorImageData->GetScalarPointer());
   }
+  std::vector<double> blockScales = { static_cast<double>(intensityScalingFactor), 1.0 };
+  vtkIdType numberOfVoxels = doseImageData->GetNumberOfPoints();
 
-  // Read in block 4 (voxel boundaries, cm, in z direction)
-  counter = 0;
-  while (!readFileStream.eof() && counter < size[2] + 1)
+  vtkIdType numberOfValues = DecodeNumberBlocks(position, end, blocks, blockScales, numberOfVoxels);
+  if (numberOfValues < 0)
   {
-    readFileStream >> voxelBoundariesZ[counter];
-    voxelBoundariesZ[counter] = voxelBoundariesZ[counter] * 10.0; // convert from cm to mm
-    if (counter == 1)
-    {
-      initialVoxelSpacing = fabs(voxelBoundariesZ[counter] - voxelBoundariesZ[counter - 1]);
-      spacingZ = initialVoxelSpacing;
-    }
-    else if (counter > 1)
-    {
-      currentVoxelSpacing = abs(voxelBoundariesZ[counter] - voxelBoundariesZ[counter - 1]);
-      if (AreEqualWithTolerance(initialVoxelSpacing, currentVoxelSpacing) == false)
-      {
-        vtkWarningMacro("LoadDosxyzNrc3dDoseFile: Voxels have uneven spacing in Z direction.");
-      }
-    }
-    counter += 1;
+    vtkErrorMacro("ReadDosxyzNrc3dDoseFile: Invalid number found in the dose or relative error values.");
+    return false;
+  }
+  if (numberOfValues < numberOfVoxels)
+  {
+    vtkErrorMacro("ReadDosxyzNrc3dDoseFile: The end of file was reached earlier than specified.");
+    return false;
+  }
+  if (relativeErrorImageData && numberOfValues < 2 * numberOfVoxels)
+  {
+    vtkWarningMacro("ReadDosxyzNrc3dDoseFile: The file does not contain relative errors for all voxels.");
+    relativeErrorImageData->Initialize();
   }
 
-  // Read in block 5 (dose array values)
-  vtkSmartPointer<vtkImageData> floatDosxyzNrc3dDoseVolumeData = vtkSmartPointer<vtkImageData>::New();
-  floatDosxyzNrc3dDoseVolumeData->SetExtent(0, size[0] - 1, 0, size[1] - 1, 0, size[2] - 1);
-  floatDosxyzNrc3dDoseVolumeData->AllocateScalars(VTK_FLOAT, 1); 
+  return true;
+}
 
-  float* floatPtr = (float*)floatDosxyzNrc3dDoseVolumeData->GetScalarPointer();
-  float currentValue = 0.0;
-  for (long z = 0; z < size[2]; z++)
+//----------------------------------------------------------------------------
+vtkMRMLScalarVolumeNode* vtkSlicerDosxyzNrc3dDoseFileReaderLogic::LoadDosxyzNrc3dDoseFile(char* filename, float intensityScalingFactor/*=1e+18*/)
+{
+  vtkSmartPointer<vtkImageData> floatDosxyzNrc3dDoseVolumeData = vtkSmartPointer<vtkImageData>::New();
+  vtkSmartPointer<vtkImageData> floatDosxyzNrc3dRelativeErrorVolumeData = vtkSmartPointer<vtkImageData>::New();
+  if (!this->ReadDosxyzNrc3dDoseFile(filename, floatDosxyzNrc3dDoseVolumeData, floatDosxyzNrc3dRelativeErrorVolumeData, intensityScalingFactor))
   {
-    for (long y = 0; y < size[1]; y++)
-    {
-      for (long x = 0; x < size[0]; x++)
-      {
-        if (readFileStream.eof())
-        {
-          vtkErrorMacro("LoadDosxyzNrc3dDoseFile: The end of file was reached earlier than specified.");
-        }
-        readFileStream >> currentValue;
-        currentValue = currentValue * intensityScalingFactor;
-        (*floatPtr) = currentValue;
-        ++floatPtr;
-      }
-    }
+    vtkErrorMacro("LoadDosxyzNrc3dDoseFile: Failed to read file " << (filename ? filename : "(null)"));
+    return nullptr;
   }
 
+  // Geometry is stored in the volume node
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  double origin[3] = { 0.0, 0.0, 0.0 };
+  floatDosxyzNrc3dDoseVolumeData->GetSpacing(spacing);
+  floatDosxyzNrc3dDoseVolumeData->GetOrigin(origin);
+  floatDosxyzNrc3dDoseVolumeData->SetSpacing(1.0, 1.0, 1.0);
+  floatDosxyzNrc3dDoseVolumeData->SetOrigin(0.0, 0.0, 0.0);
+
   // Create volume node for dose values
   vtkSmartPointer<vtkMRMLScalarVolumeNode> dosxyzNrc3dDoseVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
   dosxyzNrc3dDoseVolumeNode->SetScene(this->GetMRMLScene());
   dosxyzNrc3dDoseVolumeNode->SetName(vtksys::SystemTools::GetFilenameWithoutExtension(filename).c_str());
-  dosxyzNrc3dDoseVolumeNode->SetSpacing(spacingX, spacingY, spacingZ);
-  dosxyzNrc3dDoseVolumeNode->SetOrigin( voxelBoundariesX[0] * (-1.0), // LPS to RAS conversion
-                                        voxelBoundariesY[0] * (-1.0), // LPS to RAS conversion
-                                        voxelBoundariesZ[0] );
+  dosxyzNrc3dDoseVolumeNode->SetSpacing(spacing);
+  dosxyzNrc3dDoseVolumeNode->SetOrigin( origin[0] * (-1.0), // LPS to RAS conversion
+                                        origin[1] * (-1.0), // LPS to RAS conversion
+                                        origin[2] );
   // LPS to RAS conversion
   vtkSmartPointer<vtkMatrix4x4> lpsToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
   lpsToRasMatrix->SetElement(0, 0, -1);
@@ -238,9 +465,27 @@ vtkMRMLScalarVolumeNode* vtkSlicerDosxyzNrc3dDoseFileReaderLogic::LoadDosxyzNrc3
   dosxyzNrc3dDoseVolumeDisplayNode->SetAndObserveColorNodeID("vtkMRMLColorTableNodeGrey");
   dosxyzNrc3dDoseVolumeNode->SetAndObserveDisplayNodeID(dosxyzNrc3dDoseVolumeDisplayNode->GetID());
 
-  //todo: read in block 6 (relative errors) of .3ddose file in another volume node
-
-  readFileStream.close();
+  // Create volume node for relative errors (block 6) in the same geometry as the dose, if present in the file
+  if (floatDosxyzNrc3dRelativeErrorVolumeData->GetNumberOfPoints() > 0)
+  {
+    floatDosxyzNrc3dRelativeErrorVolumeData->SetSpacing(1.0, 1.0, 1.0);
+    floatDosxyzNrc3dRelativeErrorVolumeData->SetOrigin(0.0, 0.0, 0.0);
+
+    vtkSmartPointer<vtkMRMLScalarVolumeNode> relativeErrorVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+    relativeErrorVolumeNode->SetScene(this->GetMRMLScene());
+    std::string relativeErrorVolumeNodeName = std::string(dosxyzNrc3dDoseVolumeNode->GetName()) + RELATIVE_ERROR_VOLUME_NAME_POSTFIX;
+    relativeErrorVolumeNode->SetName(relativeErrorVolumeNodeName.c_str());
+    relativeErrorVolumeNode->CopyOrientation(dosxyzNrc3dDoseVolumeNode);
+    this->GetMRMLScene()->AddNode(relativeErrorVolumeNode);
+    relativeErrorVolumeNode->SetAndObserveImageData(floatDosxyzNrc3dRelativeErrorVolumeData);
+
+    vtkSmartPointer<vtkMRMLScalarVolumeDisplayNode> relativeErrorVolumeDisplayNode = vtkSmartPointer<vtkMRMLScalarVolumeDisplayNode>::New();
+    this->GetMRMLScene()->AddNode(relativeErrorVolumeDisplayNode);
+    relativeErrorVolumeDisplayNode->SetAndObserveColorNodeID("vtkMRMLColorTableNodeGrey");
+    relativeErrorVolumeNode->SetAndObserveDisplayNodeID(relativeErrorVolumeDisplayNode->GetID());
+
+    dosxyzNrc3dDoseVolumeNode->SetNodeReferenceID(RELATIVE_ERROR_VOLUME_REFERENCE_ROLE.c_str(), relativeErrorVolumeNode->GetID());
+  }
 
   return dosxyzNrc3dDoseVolumeNode.GetPointer();
 }
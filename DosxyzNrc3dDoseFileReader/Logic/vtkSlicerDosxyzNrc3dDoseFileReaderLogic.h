@@ -27,11 +27,13 @@
 #include "vtkSlicerModuleLogic.h"
 
 // STD includes
+#include <string>
 #include <vector>
 
 // DosxyzNrc3dDoseFileReader includes
 #include "vtkSlicerDosxyzNrc3dDoseFileReaderLogicExport.h"
 
+class vtkImageData;
 class vtkMRMLScalarVolumeNode;
 class vtkMRMLScalarVolumeDisplayNode;
 class vtkMRMLVolumeHeaderlessStorageNode;
@@ -46,10 +48,27 @@ public:
   vtkTypeMacro(vtkSlicerDosxyzNrc3dDoseFileReaderLogic, vtkSlicerModuleLogic);
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
-  /// Load DosxyzNrc3dDose volume from file
+  /// Name postfix of the volume node created for the relative errors of the dose
+  static const std::string RELATIVE_ERROR_VOLUME_NAME_POSTFIX;
+  /// Reference role from the dose volume node to the relative error volume node
+  static const std::string RELATIVE_ERROR_VOLUME_REFERENCE_ROLE;
+
+  /// Load DosxyzNrc3dDose volume from file. The relative errors, if present in the file, are loaded
+  /// into another volume node, referenced from the dose volume node with role RELATIVE_ERROR_VOLUME_REFERENCE_ROLE
   /// \param filename Path and filename of the DosxyzNrc3dDose file
   vtkMRMLScalarVolumeNode* LoadDosxyzNrc3dDoseFile(char* filename, float intensityScalingFactor=1e+18);
 
+  /// Read the dose and relative error values of a DosxyzNrc3dDose file into image data.
+  /// The image data get the voxel spacing and the origin (in LPS) of the dose grid.
+  /// The file is read into memory at once, and the values are decoded in parallel.
+  /// \param filename Path and filename of the DosxyzNrc3dDose file
+  /// \param doseImageData Output image data for the dose values, multiplied by the intensity scaling factor
+  /// \param relativeErrorImageData Output image data for the relative errors. Not read if nullptr.
+  ///   Emptied if the file does not contain the relative errors
+  /// \return Success flag
+  bool ReadDosxyzNrc3dDoseFile(const char* filename, vtkImageData* doseImageData,
+    vtkImageData* relativeErrorImageData=nullptr, float intensityScalingFactor=1e+18);
+
   /// Determine if two numbers are equal within a small tolerance (0.001)
   static bool AreEqualWithTolerance(double a, double b);
 
@@ -0,0 +1,233 @@
+// DosxyzNrc3dDoseFileReader includes
+#include "vtkSlicerDosxyzNrc3dDoseFileReaderLogic.h"
+
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+namespace
+{
+const int SIZE[3] = { 90, 80, 70 };
+const double VOXEL_BOUNDARY_START_CM[3] = { -10.0, -8.0, -5.0 };
+const double VOXEL_SIZE_CM[3] = { 0.25, 0.2, 0.3 };
+const double INTENSITY_SCALING_FACTOR = 1e+18;
+
+//-----------------------------------------------------------------------------
+double GetDose(int i, int j, int k)
+{
+  return (1.0 + i + 3.0 * j + 7.0 * k) * 1.2345e-19;
+}
+
+//-----------------------------------------------------------------------------
+double GetRelativeError(int i, int j, int k)
+{
+  return ((i + j + k) % 100) / 1000.0;
+}
+
+//-----------------------------------------------------------------------------
+/// Write synthetic .3ddose file. Voxel values are written five per line, as by DOSXYZnrc.
+/// \param numberOfValuesToWrite Number of dose and error values written, all if negative
+bool WriteSynthetic3dDoseFile(const std::string& filename, vtkIdType numberOfValuesToWrite = -1)
+{
+  std::ofstream file(filename.c_str());
+  if (!file)
+  {
+    return false;
+  }
+  file << SIZE[0] << " " << SIZE[1] << " " << SIZE[2] << std::endl;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    for (int boundaryIndex = 0; boundaryIndex <= SIZE[axis]; ++boundaryIndex)
+    {
+      file << " " << std::setprecision(6) << VOXEL_BOUNDARY_START_CM[axis] + boundaryIndex * VOXEL_SIZE_CM[axis];
+    }
+    file << std::endl;
+  }
+
+  file << std::scientific << std::setprecision(6);
+  vtkIdType numberOfVoxels = (vtkIdType)SIZE[0] * SIZE[1] * SIZE[2];
+  vtkIdType valueIndex = 0;
+  for (int block = 0; block < 2; ++block)
+  {
+    for (int k = 0; k < SIZE[2]; ++k)
+    {
+      for (int j = 0; j < SIZE[1]; ++j)
+      {
+        for (int i = 0; i < SIZE[0]; ++i)
+        {
+          if (numberOfValuesToWrite >= 0 && valueIndex >= numberOfValuesToWrite)
+          {
+            return true;
+          }
+          file << " " << (block == 0 ? GetDose(i, j, k) : GetRelativeError(i, j, k));
+          ++valueIndex;
+          if (valueIndex % 5 == 0 || valueIndex % numberOfVoxels == 0)
+          {
+            file << "\n";
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool AreEqualRelative(double a, double b)
+{
+  return fabs(a - b) <= 1e-5 * std::max(fabs(a), fabs(b)) + 1e-12;
+}
+
+//-----------------------------------------------------------------------------
+bool CheckImageData(vtkImageData* imageData, bool isDose)
+{
+  int* dimensions = imageData->GetDimensions();
+  if (dimensions[0] != SIZE[0] || dimensions[1] != SIZE[1] || dimensions[2] != SIZE[2])
+  {
+    std::cerr << "Image data dimensions (" << dimensions[0] << ", " << dimensions[1] << ", " << dimensions[2] << ") do not match the file" << std::endl;
+    return false;
+  }
+  if (imageData->GetScalarType() != VTK_FLOAT)
+  {
+    std::cerr << "Image data scalar type is not float" << std::endl;
+    return false;
+  }
+  float* valuePtr = static_cast<float*>(imageData->GetScalarPointer());
+  for (int k = 0; k < SIZE[2]; ++k)
+  {
+    for (int j = 0; j < SIZE[1]; ++j)
+    {
+      for (int i = 0; i < SIZE[0]; ++i)
+      {
+        double expectedValue = (isDose ? GetDose(i, j, k) * INTENSITY_SCALING_FACTOR : GetRelativeError(i, j, k));
+        if (!AreEqualRelative(*valuePtr, expectedValue))
+        {
+          std::cerr << (isDose ? "Dose" : "Relative error") << " mismatch at (" << i << ", " << j << ", " << k << "): "
+            << *valuePtr << " != " << expectedValue << std::endl;
+          return false;
+        }
+        ++valuePtr;
+      }
+    }
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerDosxyzNrc3dDoseFileReaderLogicTest1( int argc, char * argv[] )
+{
+  // TemporaryDirectory
+  std::string temporaryDirectory;
+  if (argc > 2 && STRCASECMP(argv[1], "-TemporaryDirectory") == 0)
+  {
+    temporaryDirectory = argv[2];
+    std::cout << "Temporary directory: " << temporaryDirectory << std::endl;
+  }
+  else
+  {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtksys::SystemTools::MakeDirectory(temporaryDirectory);
+
+  std::string filename = temporaryDirectory + "/SyntheticDose.3ddose";
+  if (!WriteSynthetic3dDoseFile(filename))
+  {
+    std::cerr << "Failed to write synthetic file " << filename << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkSlicerDosxyzNrc3dDoseFileReaderLogic> logic;
+
+  // Read dose and relative errors, and report throughput
+  vtkNew<vtkImageData> doseImageData;
+  vtkNew<vtkImageData> relativeErrorImageData;
+  double startTime = vtkTimerLog::GetUniversalTime();
+  if (!logic->ReadDosxyzNrc3dDoseFile(filename.c_str(), doseImageData, relativeErrorImageData, INTENSITY_SCALING_FACTOR))
+  {
+    std::cerr << "Failed to read synthetic file " << filename << std::endl;
+    return EXIT_FAILURE;
+  }
+  double elapsedTimeSec = std::max(vtkTimerLog::GetUniversalTime() - startTime, 1e-6);
+  double fileSizeMB = vtksys::SystemTools::FileLength(filename) / (1024.0 * 1024.0);
+  std::cout << "Read " << fileSizeMB << " MB, " << 2 * doseImageData->GetNumberOfPoints() << " values in "
+    << elapsedTimeSec << " s: " << fileSizeMB / elapsedTimeSec << " MB/s" << std::endl;
+
+  if (!CheckImageData(doseImageData, true) || !CheckImageData(relativeErrorImageData, false))
+  {
+    return EXIT_FAILURE;
+  }
+  double* spacing = doseImageData->GetSpacing();
+  double* origin = doseImageData->GetOrigin();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if ( !AreEqualRelative(spacing[axis], VOXEL_SIZE_CM[axis] * 10.0)
+      || !AreEqualRelative(origin[axis], VOXEL_BOUNDARY_START_CM[axis] * 10.0) )
+    {
+      std::cerr << "Geometry mismatch along axis " << axis << ": spacing " << spacing[axis] << ", origin " << origin[axis] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Load into scene
+  vtkNew<vtkMRMLScene> mrmlScene;
+  logic->SetMRMLScene(mrmlScene);
+  vtkMRMLScalarVolumeNode* doseVolumeNode = logic->LoadDosxyzNrc3dDoseFile(const_cast<char*>(filename.c_str()), INTENSITY_SCALING_FACTOR);
+  if (!doseVolumeNode || !CheckImageData(doseVolumeNode->GetImageData(), true))
+  {
+    std::cerr << "Failed to load dose volume" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkMRMLScalarVolumeNode* relativeErrorVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(doseVolumeNode->GetNodeReference(
+    vtkSlicerDosxyzNrc3dDoseFileReaderLogic::RELATIVE_ERROR_VOLUME_REFERENCE_ROLE.c_str()));
+  if (!relativeErrorVolumeNode || !CheckImageData(relativeErrorVolumeNode->GetImageData(), false))
+  {
+    std::cerr << "Failed to load relative error volume" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!AreEqualRelative(relativeErrorVolumeNode->GetSpacing()[2], doseVolumeNode->GetSpacing()[2])
+    || !AreEqualRelative(relativeErrorVolumeNode->GetOrigin()[0], doseVolumeNode->GetOrigin()[0]))
+  {
+    std::cerr << "Relative error volume geometry does not match the dose volume" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // File without relative errors: dose is read, relative error image data is emptied
+  vtkIdType numberOfVoxels = (vtkIdType)SIZE[0] * SIZE[1] * SIZE[2];
+  std::string doseOnlyFilename = temporaryDirectory + "/SyntheticDoseWithoutErrors.3ddose";
+  WriteSynthetic3dDoseFile(doseOnlyFilename, numberOfVoxels);
+  if ( !logic->ReadDosxyzNrc3dDoseFile(doseOnlyFilename.c_str(), doseImageData, relativeErrorImageData, INTENSITY_SCALING_FACTOR)
+    || !CheckImageData(doseImageData, true) || relativeErrorImageData->GetNumberOfPoints() > 0 )
+  {
+    std::cerr << "Failed to read file without relative errors" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Truncated dose block
+  std::string truncatedFilename = temporaryDirectory + "/SyntheticDoseTruncated.3ddose";
+  WriteSynthetic3dDoseFile(truncatedFilename, numberOfVoxels / 2);
+  if (logic->ReadDosxyzNrc3dDoseFile(truncatedFilename.c_str(), doseImageData, nullptr, INTENSITY_SCALING_FACTOR))
+  {
+    std::cerr << "Truncated file is read successfully" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -111,7 +111,14 @@ bool qSlicerDosxyzNrc3dDoseFileReaderPlugin::load(const IOProperties& properties
   {
     return false;
   }
-  this->setLoadedNodes( QStringList(QString(node->GetID())) ); 
+  QStringList loadedNodeIDs(QString(node->GetID()));
+  vtkMRMLNode* relativeErrorVolumeNode = node->GetNodeReference(
+    vtkSlicerDosxyzNrc3dDoseFileReaderLogic::RELATIVE_ERROR_VOLUME_REFERENCE_ROLE.c_str());
+  if (relativeErrorVolumeNode)
+  {
+    loadedNodeIDs << QString(relativeErrorVolumeNode->GetID());
+  }
+  this->setLoadedNodes(loadedNodeIDs);
 
   return true;
 }
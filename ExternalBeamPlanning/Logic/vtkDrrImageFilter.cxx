@@ -0,0 +1,420 @@
+/*==============================================================================
+
+  Copyright (c) Radiation Medicine Program, University Health Network,
+  Princess Margaret Hospital, Toronto, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkDrrImageFilter.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// Ray direction components smaller than this (in voxels) are considered parallel to the voxel planes
+const double PARALLEL_TOLERANCE = 1e-12;
+
+//----------------------------------------------------------------------------
+/// Convert CT voxels in HU to linear attenuation coefficients
+template <class T>
+void ConvertHuToAttenuation(vtkImageData* ctImage, T*, float* attenuation, double waterAttenuationCoefficient)
+{
+  const T* huPtr = static_cast<T*>(ctImage->GetScalarPointer());
+  int numberOfComponents = ctImage->GetNumberOfScalarComponents();
+  vtkSMPTools::For(0, ctImage->GetNumberOfPoints(), [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType voxelIndex = begin; voxelIndex < end; ++voxelIndex)
+    {
+      double mu = waterAttenuationCoefficient * (1.0 + static_cast<double>(huPtr[voxelIndex * numberOfComponents]) / 1000.0);
+      attenuation[voxelIndex] = static_cast<float>(mu > 0.0 ? mu : 0.0);
+    }
+  });
+}
+
+//----------------------------------------------------------------------------
+/// Traverse voxels along rays using the incremental Siddon-Jacobs algorithm.
+/// Rays are given in continuous voxel coordinates relative to the first voxel, where voxel
+/// boundaries are at half-integer positions.
+class SiddonRayCaster
+{
+public:
+  SiddonRayCaster(const float* attenuation, const int dimensions[3], double maximumLineIntegral)
+    : Attenuation(attenuation)
+    , MaximumLineIntegral(maximumLineIntegral)
+  {
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      this->Dimensions[axis] = dimensions[axis];
+    }
+    this->Increments[0] = 1;
+    this->Increments[1] = dimensions[0];
+    this->Increments[2] = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+  }
+
+  /// Compute the line integral of the attenuation coefficient along a ray
+  /// \param source Start point of the ray in voxel coordinates
+  /// \param target End point of the ray in voxel coordinates
+  /// \param rayLengthMm Physical length of the ray from source to target
+  double CastRay(const double source[3], const double target[3], double rayLengthMm) const
+  {
+    // Parametric range of the ray within the volume
+    double direction[3] = { target[0] - source[0], target[1] - source[1], target[2] - source[2] };
+    double alphaMin = 0.0;
+    double alphaMax = 1.0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      double lowerBoundary = -0.5;
+      double upperBoundary = this->Dimensions[axis] - 0.5;
+      if (fabs(direction[axis]) < PARALLEL_TOLERANCE)
+      {
+        if (source[axis] < lowerBoundary || source[axis] > upperBoundary)
+        {
+          return 0.0;
+        }
+        continue;
+      }
+      double alphaLower = (lowerBoundary - source[axis]) / direction[axis];
+      double alphaUpper = (upperBoundary - source[axis]) / direction[axis];
+      alphaMin = std::max(alphaMin, std::min(alphaLower, alphaUpper));
+      alphaMax = std::min(alphaMax, std::max(alphaLower, alphaUpper));
+    }
+    if (alphaMin >= alphaMax)
+    {
+      return 0.0;
+    }
+
+    // First voxel, and the parametric positions of the next voxel boundary crossings along each axis
+    int index[3] = { 0, 0, 0 };
+    int step[3] = { 0, 0, 0 };
+    double alphaNext[3] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, VTK_DOUBLE_MAX };
+    double alphaStep[3] = { 0.0, 0.0, 0.0 };
+    vtkIdType offset = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      double entryPosition = source[axis] + alphaMin * direction[axis];
+      index[axis] = std::min(std::max(static_cast<int>(floor(entryPosition + 0.5)), 0), this->Dimensions[axis] - 1);
+      offset += index[axis] * this->Increments[axis];
+      if (fabs(direction[axis]) < PARALLEL_TOLERANCE)
+      {
+        continue;
+      }
+      step[axis] = (direction[axis] > 0.0 ? 1 : -1);
+      alphaNext[axis] = (index[axis] + 0.5 * step[axis] - source[axis]) / direction[axis];
+      alphaStep[axis] = 1.0 / fabs(direction[axis]);
+    }
+
+    // Accumulate attenuation times intersection length voxel by voxel. The integral is computed
+    // in parametric units and scaled by the ray length at the end.
+    double terminationSum = (this->MaximumLineIntegral > 0.0 ? this->MaximumLineIntegral / rayLengthMm : VTK_DOUBLE_MAX);
+    double alpha = alphaMin;
+    double sum = 0.0;
+    while (true)
+    {
+      int axis = ( alphaNext[0] < alphaNext[1] ? (alphaNext[0] < alphaNext[2] ? 0 : 2)
+        : (alphaNext[1] < alphaNext[2] ? 1 : 2) );
+      if (alphaNext[axis] >= alphaMax)
+      {
+        sum += this->Attenuation[offset] * (alphaMax - alpha);
+        break;
+      }
+      sum += this->Attenuation[offset] * (alphaNext[axis] - alpha);
+      if (sum >= terminationSum)
+      {
+        break;
+      }
+      alpha = alphaNext[axis];
+      index[axis] += step[axis];
+      if (index[axis] < 0 || index[axis] >= this->Dimensions[axis])
+      {
+        break;
+      }
+      offset += step[axis] * this->Increments[axis];
+      alphaNext[axis] += alphaStep[axis];
+    }
+    return sum * rayLengthMm;
+  }
+
+protected:
+  const float* Attenuation;
+  int Dimensions[3];
+  vtkIdType Increments[3];
+  double MaximumLineIntegral;
+};
+
+//----------------------------------------------------------------------------
+/// Get pixel positions along a detector axis where rays are cast: every Nth and the last one
+std::vector<int> GetSamplePositions(int numberOfPixels, int subsamplingFactor)
+{
+  std::vector<int> samplePositions;
+  for (int position = 0; position < numberOfPixels; position += subsamplingFactor)
+  {
+    samplePositions.push_back(position);
+  }
+  if (samplePositions.back() != numberOfPixels - 1)
+  {
+    samplePositions.push_back(numberOfPixels - 1);
+  }
+  return samplePositions;
+}
+
+//----------------------------------------------------------------------------
+/// Get interval of sample positions containing a pixel, and the interpolation weight of its end
+void GetSampleInterval(const std::vector<int>& samplePositions, int subsamplingFactor, int pixel, int& sampleIndex, double& weight)
+{
+  int numberOfSamples = static_cast<int>(samplePositions.size());
+  sampleIndex = std::min(pixel / subsamplingFactor, std::max(numberOfSamples - 2, 0));
+  if (sampleIndex + 1 >= numberOfSamples)
+  {
+    weight = 0.0;
+    return;
+  }
+  weight = static_cast<double>(pixel - samplePositions[sampleIndex])
+    / (samplePositions[sampleIndex + 1] - samplePositions[sampleIndex]);
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkDrrImageFilter);
+
+//----------------------------------------------------------------------------
+vtkDrrImageFilter::vtkDrrImageFilter()
+{
+  this->BeamToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  this->OutputImage = vtkSmartPointer<vtkOrientedImageData>::New();
+
+  this->AttenuationImageSourceScalars = nullptr;
+  this->AttenuationImageSourceMTime = 0;
+  this->AttenuationImageWaterAttenuationCoefficient = 0.0;
+
+  this->SourceToIsocenterDistance = 1000.0;
+  this->SourceToDetectorDistance = 1500.0;
+  this->DetectorSize[0] = 512;
+  this->DetectorSize[1] = 512;
+  this->DetectorSpacing[0] = 0.8;
+  this->DetectorSpacing[1] = 0.8;
+  this->WaterAttenuationCoefficient = 0.02;
+  this->MaximumLineIntegral = 0.0;
+  this->RaySubsamplingFactor = 1;
+}
+
+//----------------------------------------------------------------------------
+vtkDrrImageFilter::~vtkDrrImageFilter() = default;
+
+//----------------------------------------------------------------------------
+void vtkDrrImageFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "SourceToIsocenterDistance: " << this->SourceToIsocenterDistance << "\n";
+  os << indent << "SourceToDetectorDistance: " << this->SourceToDetectorDistance << "\n";
+  os << indent << "DetectorSize: " << this->DetectorSize[0] << ", " << this->DetectorSize[1] << "\n";
+  os << indent << "DetectorSpacing: " << this->DetectorSpacing[0] << ", " << this->DetectorSpacing[1] << "\n";
+  os << indent << "WaterAttenuationCoefficient: " << this->WaterAttenuationCoefficient << "\n";
+  os << indent << "MaximumLineIntegral: " << this->MaximumLineIntegral << "\n";
+  os << indent << "RaySubsamplingFactor: " << this->RaySubsamplingFactor << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkDrrImageFilter::SetInputVolume(vtkOrientedImageData* volume)
+{
+  this->InputVolume = volume;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkDrrImageFilter::GetInputVolume()
+{
+  return this->InputVolume;
+}
+
+//----------------------------------------------------------------------------
+void vtkDrrImageFilter::SetBeamToWorldMatrix(vtkMatrix4x4* beamToWorldMatrix)
+{
+  if (!beamToWorldMatrix)
+  {
+    this->BeamToWorldMatrix->Identity();
+    return;
+  }
+  this->BeamToWorldMatrix->DeepCopy(beamToWorldMatrix);
+}
+
+//----------------------------------------------------------------------------
+vtkMatrix4x4* vtkDrrImageFilter::GetBeamToWorldMatrix()
+{
+  return this->BeamToWorldMatrix;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkDrrImageFilter::GetOutputImage()
+{
+  return this->OutputImage;
+}
+
+//----------------------------------------------------------------------------
+void vtkDrrImageFilter::UpdateAttenuationImage()
+{
+  vtkDataArray* ctScalars = this->InputVolume->GetPointData()->GetScalars();
+  if ( this->AttenuationImage && ctScalars == this->AttenuationImageSourceScalars
+    && ctScalars->GetMTime() == this->AttenuationImageSourceMTime
+    && this->WaterAttenuationCoefficient == this->AttenuationImageWaterAttenuationCoefficient
+    && this->AttenuationImage->GetNumberOfPoints() == this->InputVolume->GetNumberOfPoints() )
+  {
+    return;
+  }
+
+  this->AttenuationImage = vtkSmartPointer<vtkImageData>::New();
+  this->AttenuationImage->SetDimensions(this->InputVolume->GetDimensions());
+  this->AttenuationImage->AllocateScalars(VTK_FLOAT, 1);
+  float* attenuation = static_cast<float*>(this->AttenuationImage->GetScalarPointer());
+  switch (this->InputVolume->GetScalarType())
+  {
+    vtkTemplateMacro(ConvertHuToAttenuation(this->InputVolume.GetPointer(), static_cast<VTK_TT*>(nullptr), attenuation, this->WaterAttenuationCoefficient));
+  }
+
+  this->AttenuationImageSourceScalars = ctScalars;
+  this->AttenuationImageSourceMTime = ctScalars->GetMTime();
+  this->AttenuationImageWaterAttenuationCoefficient = this->WaterAttenuationCoefficient;
+}
+
+//----------------------------------------------------------------------------
+bool vtkDrrImageFilter::Update()
+{
+  if (!this->InputVolume || !this->InputVolume->GetPointData()->GetScalars() || this->InputVolume->IsEmpty())
+  {
+    vtkErrorMacro("Update: Invalid input volume");
+    return false;
+  }
+  if (this->DetectorSize[0] < 1 || this->DetectorSize[1] < 1 || this->DetectorSpacing[0] <= 0.0 || this->DetectorSpacing[1] <= 0.0)
+  {
+    vtkErrorMacro("Update: Invalid detector size or spacing");
+    return false;
+  }
+  if (this->SourceToDetectorDistance <= 0.0)
+  {
+    vtkErrorMacro("Update: Invalid source to detector distance " << this->SourceToDetectorDistance);
+    return false;
+  }
+
+  this->UpdateAttenuationImage();
+
+  // Detector pixel to world transform. Pixel centers are symmetric around the beam axis
+  vtkNew<vtkMatrix4x4> detectorToBeamMatrix;
+  detectorToBeamMatrix->SetElement(0, 0, this->DetectorSpacing[0]);
+  detectorToBeamMatrix->SetElement(1, 1, this->DetectorSpacing[1]);
+  detectorToBeamMatrix->SetElement(0, 3, -0.5 * (this->DetectorSize[0] - 1) * this->DetectorSpacing[0]);
+  detectorToBeamMatrix->SetElement(1, 3, -0.5 * (this->DetectorSize[1] - 1) * this->DetectorSpacing[1]);
+  detectorToBeamMatrix->SetElement(2, 3, this->SourceToIsocenterDistance - this->SourceToDetectorDistance);
+  vtkNew<vtkMatrix4x4> detectorToWorldMatrix;
+  vtkMatrix4x4::Multiply4x4(this->BeamToWorldMatrix, detectorToBeamMatrix, detectorToWorldMatrix);
+
+  // World to voxel coordinates relative to the first voxel of the CT
+  vtkNew<vtkMatrix4x4> worldToIjkMatrix;
+  this->InputVolume->GetWorldToImageMatrix(worldToIjkMatrix);
+  int* extent = this->InputVolume->GetExtent();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    worldToIjkMatrix->SetElement(axis, 3, worldToIjkMatrix->GetElement(axis, 3) - extent[2*axis]);
+  }
+  vtkNew<vtkMatrix4x4> detectorToIjkMatrix;
+  vtkMatrix4x4::Multiply4x4(worldToIjkMatrix, detectorToWorldMatrix, detectorToIjkMatrix);
+
+  double sourceBeam[4] = { 0.0, 0.0, this->SourceToIsocenterDistance, 1.0 };
+  double sourceWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
+  this->BeamToWorldMatrix->MultiplyPoint(sourceBeam, sourceWorld);
+  double sourceIjk[4] = { 0.0, 0.0, 0.0, 1.0 };
+  worldToIjkMatrix->MultiplyPoint(sourceWorld, sourceIjk);
+
+  // Allocate output in the detector plane
+  this->OutputImage->SetExtent(0, this->DetectorSize[0] - 1, 0, this->DetectorSize[1] - 1, 0, 0);
+  this->OutputImage->AllocateScalars(VTK_FLOAT, 1);
+  this->OutputImage->SetImageToWorldMatrix(detectorToWorldMatrix);
+  float* outputPtr = static_cast<float*>(this->OutputImage->GetScalarPointer());
+
+  // Cast rays to the sampled pixels, detector rows in parallel
+  int subsamplingFactor = std::max(this->RaySubsamplingFactor, 1);
+  std::vector<int> sampleColumns = GetSamplePositions(this->DetectorSize[0], subsamplingFactor);
+  std::vector<int> sampleRows = GetSamplePositions(this->DetectorSize[1], subsamplingFactor);
+  vtkIdType numberOfSampleColumns = static_cast<vtkIdType>(sampleColumns.size());
+  std::vector<float> samples;
+  float* samplePtr = outputPtr;
+  if (subsamplingFactor > 1)
+  {
+    samples.resize(numberOfSampleColumns * sampleRows.size());
+    samplePtr = samples.data();
+  }
+
+  SiddonRayCaster rayCaster(static_cast<const float*>(this->AttenuationImage->GetScalarPointer()),
+    this->InputVolume->GetDimensions(), this->MaximumLineIntegral);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(sampleRows.size()), [&](vtkIdType beginRow, vtkIdType endRow)
+  {
+    for (vtkIdType rowIndex = beginRow; rowIndex < endRow; ++rowIndex)
+    {
+      for (vtkIdType columnIndex = 0; columnIndex < numberOfSampleColumns; ++columnIndex)
+      {
+        double pixel[4] = { static_cast<double>(sampleColumns[columnIndex]), static_cast<double>(sampleRows[rowIndex]), 0.0, 1.0 };
+        double pixelWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
+        detectorToWorldMatrix->MultiplyPoint(pixel, pixelWorld);
+        double pixelIjk[4] = { 0.0, 0.0, 0.0, 1.0 };
+        detectorToIjkMatrix->MultiplyPoint(pixel, pixelIjk);
+        double rayLengthMm = sqrt(vtkMath::Distance2BetweenPoints(sourceWorld, pixelWorld));
+        samplePtr[rowIndex * numberOfSampleColumns + columnIndex] = static_cast<float>(
+          rayCaster.CastRay(sourceIjk, pixelIjk, rayLengthMm) );
+      }
+    }
+  });
+
+  // Interpolate the pixels between the rays
+  if (subsamplingFactor > 1)
+  {
+    int numberOfColumns = this->DetectorSize[0];
+    vtkSMPTools::For(0, this->DetectorSize[1], [&](vtkIdType beginRow, vtkIdType endRow)
+    {
+      for (vtkIdType row = beginRow; row < endRow; ++row)
+      {
+        int sampleRowIndex = 0;
+        double rowWeight = 0.0;
+        GetSampleInterval(sampleRows, subsamplingFactor, row, sampleRowIndex, rowWeight);
+        const float* sampleRow0 = samplePtr + sampleRowIndex * numberOfSampleColumns;
+        const float* sampleRow1 = (rowWeight > 0.0 ? sampleRow0 + numberOfSampleColumns : sampleRow0);
+        float* outputRowPtr = outputPtr + row * numberOfColumns;
+        for (int column = 0; column < numberOfColumns; ++column)
+        {
+          int sampleColumnIndex = 0;
+          double columnWeight = 0.0;
+          GetSampleInterval(sampleColumns, subsamplingFactor, column, sampleColumnIndex, columnWeight);
+          int nextSampleColumnIndex = (columnWeight > 0.0 ? sampleColumnIndex + 1 : sampleColumnIndex);
+          double value0 = (1.0 - columnWeight) * sampleRow0[sampleColumnIndex] + columnWeight * sampleRow0[nextSampleColumnIndex];
+          double value1 = (1.0 - columnWeight) * sampleRow1[sampleColumnIndex] + columnWeight * sampleRow1[nextSampleColumnIndex];
+          outputRowPtr[column] = static_cast<float>((1.0 - rowWeight) * value0 + rowWeight * value1);
+        }
+      }
+    });
+  }
+
+  this->OutputImage->Modified();
+  return true;
+}
@@ -0,0 +1,150 @@
+/*==============================================================================
+
+  Copyright (c) Radiation Medicine Program, University Health Network,
+  Princess Margaret Hospital, Toronto, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkDrrImageFilter_h
+#define __vtkDrrImageFilter_h
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "vtkSlicerExternalBeamPlanningModuleLogicExport.h"
+
+class vtkDataArray;
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkOrientedImageData;
+
+/// \ingroup SlicerRt_QtModules_ExternalBeamPlanning
+/// \brief Compute digitally reconstructed radiograph (DRR) of a CT volume for a beam geometry.
+///
+/// Rays are cast from the source to the center of each pixel of a detector plane perpendicular
+/// to the beam axis, and the line integral of the linear attenuation coefficient is accumulated
+/// along them. The CT volume is first converted from HU to attenuation coefficients relative to
+/// water, then the voxels intersected by each ray are traversed exactly using the incremental
+/// Siddon-Jacobs algorithm, in the voxel coordinate system of the volume so that oriented volumes
+/// need no resampling. Detector rows are computed in parallel.
+///
+/// The beam geometry is given in the beam coordinate system of the IEC hierarchy (the parent
+/// transform of the beam node): isocenter is at the origin, the source is at (0, 0, SAD), and the
+/// detector is centered on the beam axis at distance SID from the source, with its rows and columns
+/// along the X and Y axes.
+///
+/// Similarly to the segment morphology filters, this class is not a VTK pipeline filter.
+class VTK_SLICER_EXTERNALBEAMPLANNING_MODULE_LOGIC_EXPORT vtkDrrImageFilter : public vtkObject
+{
+public:
+  static vtkDrrImageFilter *New();
+  vtkTypeMacro(vtkDrrImageFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set CT volume in HU. The volume is referenced, not copied.
+  void SetInputVolume(vtkOrientedImageData* volume);
+  /// Get CT volume
+  vtkOrientedImageData* GetInputVolume();
+
+  /// Set transform from beam coordinate system to world. Identity by default
+  void SetBeamToWorldMatrix(vtkMatrix4x4* beamToWorldMatrix);
+  /// Get transform from beam coordinate system to world
+  vtkMatrix4x4* GetBeamToWorldMatrix();
+
+  /// Get/Set source to isocenter distance (SAD) in mm. 1000 by default
+  vtkGetMacro(SourceToIsocenterDistance, double);
+  vtkSetMacro(SourceToIsocenterDistance, double);
+
+  /// Get/Set source to detector distance (SID) in mm. 1500 by default
+  vtkGetMacro(SourceToDetectorDistance, double);
+  vtkSetMacro(SourceToDetectorDistance, double);
+
+  /// Get/Set number of detector pixels along the beam X and Y axes. 512x512 by default
+  vtkGetVector2Macro(DetectorSize, int);
+  vtkSetVector2Macro(DetectorSize, int);
+
+  /// Get/Set detector pixel spacing in mm in the detector plane. 0.8x0.8 by default
+  vtkGetVector2Macro(DetectorSpacing, double);
+  vtkSetVector2Macro(DetectorSpacing, double);
+
+  /// Get/Set linear attenuation coefficient of water in 1/mm. Voxels of the CT are converted
+  /// to attenuation coefficients as mu_water * (1 + HU/1000), negative values clamped to zero.
+  /// 0.02 by default (approximately 60 keV)
+  vtkGetMacro(WaterAttenuationCoefficient, double);
+  vtkSetMacro(WaterAttenuationCoefficient, double);
+
+  /// Get/Set line integral of the attenuation coefficient above which ray traversal is stopped,
+  /// as transmission is negligible. Pixels of terminated rays get approximately this value.
+  /// Early termination is disabled if zero or negative (default)
+  vtkGetMacro(MaximumLineIntegral, double);
+  vtkSetMacro(MaximumLineIntegral, double);
+
+  /// Get/Set ray subsampling factor. If larger than one then rays are cast only to every Nth pixel
+  /// of the detector rows and columns (and the last ones), and the other pixels are interpolated
+  /// bilinearly. 1 by default (one ray per pixel)
+  vtkGetMacro(RaySubsamplingFactor, int);
+  vtkSetMacro(RaySubsamplingFactor, int);
+
+  /// Compute the DRR
+  /// \return Success flag
+  bool Update();
+
+  /// Get DRR image. Its pixel values are the line integrals of the attenuation coefficient, and its
+  /// geometry places it in the detector plane in world coordinates, seen from the source (i.e. its
+  /// IJK axes are the X, Y and Z axes of the beam)
+  vtkOrientedImageData* GetOutputImage();
+
+protected:
+  /// Convert the CT volume to attenuation coefficients, unless the cached conversion is up to date
+  void UpdateAttenuationImage();
+
+protected:
+  vtkDrrImageFilter();
+  ~vtkDrrImageFilter() override;
+
+protected:
+  /// CT volume in HU
+  vtkSmartPointer<vtkOrientedImageData> InputVolume;
+  /// Transform from beam coordinate system to world
+  vtkSmartPointer<vtkMatrix4x4> BeamToWorldMatrix;
+  /// DRR image
+  vtkSmartPointer<vtkOrientedImageData> OutputImage;
+
+  /// Attenuation coefficients on the voxels of the CT volume
+  vtkSmartPointer<vtkImageData> AttenuationImage;
+  /// Scalars the attenuation image was computed from, and their modified time and water attenuation
+  /// coefficient at the time of the conversion. Used to avoid converting the CT for every DRR
+  vtkDataArray* AttenuationImageSourceScalars;
+  vtkMTimeType AttenuationImageSourceMTime;
+  double AttenuationImageWaterAttenuationCoefficient;
+
+  /// Source to isocenter distance in mm
+  double SourceToIsocenterDistance;
+  /// Source to detector distance in mm
+  double SourceToDetectorDistance;
+  /// Number of detector pixels
+  int DetectorSize[2];
+  /// Detector pixel spacing in mm
+  double DetectorSpacing[2];
+  /// Linear attenuation coefficient of water in 1/mm
+  double WaterAttenuationCoefficient;
+  /// Line integral above which rays are terminated. Disabled if not positive
+  double MaximumLineIntegral;
+  /// Ray subsampling factor
+  int RaySubsamplingFactor;
+
+private:
+  vtkDrrImageFilter(const vtkDrrImageFilter&) = delete;
+  void operator=(const vtkDrrImageFilter&) = delete;
+};
+
+#endif
@@ -0,0 +1,444 @@
+/*==============================================================================
+
+  Copyright (c) Radiation Medicine Program, University Health Network,
+  Princess Margaret Hospital, Toronto, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkPhotonPencilBeamDoseFilter.h"
+
+// ExternalBeamPlanning includes
+#include "vtkWaterEquivalentDepthFilter.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// Number of standard deviations beyond which the lateral Gaussians are neglected
+const double KERNEL_CUTOFF_SIGMAS = 5.0;
+
+//----------------------------------------------------------------------------
+/// Lateral kernel: primary and scatter Gaussians with widths linear in the radiological depth
+struct LateralKernel
+{
+  double Sigma[2];
+  double SigmaDepthCoefficient[2];
+  double Weight[2];
+
+  double GetSigma(int component, double depth) const
+  {
+    return std::max(this->Sigma[component] + this->SigmaDepthCoefficient[component] * depth, 1e-3);
+  }
+};
+
+//----------------------------------------------------------------------------
+/// Aperture convolved with the lateral kernel, tabulated in the isocenter plane at regular radiological depths
+struct LateralTable
+{
+  /// Number of samples along the beam X and Y axes and number of depths
+  int Dimensions[3];
+  /// Position of the first sample in the isocenter plane (the first depth is zero)
+  double Origin[2];
+  /// Sample spacing in the isocenter plane and depth spacing
+  double Spacing[3];
+  /// Convolved aperture, X fastest
+  std::vector<float> Values;
+};
+
+//----------------------------------------------------------------------------
+/// Fraction of a Gaussian centered at a position that is between two bounds
+inline double GetGaussianFraction(double lower, double upper, double position, double sigma)
+{
+  double scale = 1.0 / (sqrt(2.0) * sigma);
+  return 0.5 * (erf((upper - position) * scale) - erf((lower - position) * scale));
+}
+
+//----------------------------------------------------------------------------
+/// Tabulate the aperture convolved with the lateral kernel. The convolution of a rectangle with a Gaussian is
+/// separable, so the profiles of each rectangle along X and Y are computed first, and then summed up on the grid
+void ComputeLateralTable(const std::vector< std::array<double, 4> >& rectangles, const LateralKernel& kernel,
+  double maximumDepth, double spacing, double depthSpacing, LateralTable& table)
+{
+  int numberOfDepths = std::max(static_cast<int>(ceil(maximumDepth / depthSpacing)) + 1, 2);
+  double cutoff = KERNEL_CUTOFF_SIGMAS * std::max(kernel.GetSigma(0, (numberOfDepths - 1) * depthSpacing),
+    kernel.GetSigma(1, (numberOfDepths - 1) * depthSpacing));
+  double bounds[4] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  for (const std::array<double, 4>& rectangle : rectangles)
+  {
+    bounds[0] = std::min(bounds[0], rectangle[0] - cutoff);
+    bounds[1] = std::max(bounds[1], rectangle[1] + cutoff);
+    bounds[2] = std::min(bounds[2], rectangle[2] - cutoff);
+    bounds[3] = std::max(bounds[3], rectangle[3] + cutoff);
+  }
+  for (int axis = 0; axis < 2; ++axis)
+  {
+    table.Dimensions[axis] = static_cast<int>(ceil((bounds[2*axis+1] - bounds[2*axis]) / spacing)) + 1;
+    table.Origin[axis] = bounds[2*axis];
+    table.Spacing[axis] = spacing;
+  }
+  table.Dimensions[2] = numberOfDepths;
+  table.Spacing[2] = depthSpacing;
+
+  // Profiles of the rectangles for each depth and kernel component
+  int numberOfRectangles = static_cast<int>(rectangles.size());
+  std::vector< std::vector<double> > profilesX(numberOfDepths * 2);
+  std::vector< std::vector<double> > profilesY(numberOfDepths * 2);
+  vtkSMPTools::For(0, numberOfDepths * 2, [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType profileIndex = begin; profileIndex < end; ++profileIndex)
+    {
+      int depthIndex = static_cast<int>(profileIndex / 2);
+      int component = static_cast<int>(profileIndex % 2);
+      double sigma = kernel.GetSigma(component, depthIndex * depthSpacing);
+      std::vector<double>& profileX = profilesX[profileIndex];
+      std::vector<double>& profileY = profilesY[profileIndex];
+      profileX.resize(static_cast<size_t>(numberOfRectangles) * table.Dimensions[0]);
+      profileY.resize(static_cast<size_t>(numberOfRectangles) * table.Dimensions[1]);
+      for (int rectangleIndex = 0; rectangleIndex < numberOfRectangles; ++rectangleIndex)
+      {
+        const std::array<double, 4>& rectangle = rectangles[rectangleIndex];
+        for (int i = 0; i < table.Dimensions[0]; ++i)
+        {
+          profileX[rectangleIndex * table.Dimensions[0] + i] =
+            GetGaussianFraction(rectangle[0], rectangle[1], table.Origin[0] + i * spacing, sigma);
+        }
+        for (int j = 0; j < table.Dimensions[1]; ++j)
+        {
+          profileY[rectangleIndex * table.Dimensions[1] + j] =
+            GetGaussianFraction(rectangle[2], rectangle[3], table.Origin[1] + j * spacing, sigma);
+        }
+      }
+    }
+  });
+
+  table.Values.assign(static_cast<size_t>(table.Dimensions[0]) * table.Dimensions[1] * numberOfDepths, 0.0f);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(table.Dimensions[1]) * numberOfDepths, [&](vtkIdType beginRow, vtkIdType endRow)
+  {
+    std::vector<double> rowValues(table.Dimensions[0]);
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+    {
+      int j = static_cast<int>(row % table.Dimensions[1]);
+      int depthIndex = static_cast<int>(row / table.Dimensions[1]);
+      std::fill(rowValues.begin(), rowValues.end(), 0.0);
+      for (int component = 0; component < 2; ++component)
+      {
+        const std::vector<double>& profileX = profilesX[depthIndex * 2 + component];
+        const std::vector<double>& profileY = profilesY[depthIndex * 2 + component];
+        for (int rectangleIndex = 0; rectangleIndex < numberOfRectangles; ++rectangleIndex)
+        {
+          // Rows far from the rectangle get no contribution from it
+          double weightY = kernel.Weight[component] * profileY[rectangleIndex * table.Dimensions[1] + j];
+          if (weightY < 1e-9)
+          {
+            continue;
+          }
+          const double* profileXPtr = &profileX[rectangleIndex * table.Dimensions[0]];
+          for (int i = 0; i < table.Dimensions[0]; ++i)
+          {
+            rowValues[i] += weightY * profileXPtr[i];
+          }
+        }
+      }
+      std::copy(rowValues.begin(), rowValues.end(), table.Values.begin() + row * table.Dimensions[0]);
+    }
+  });
+}
+
+//----------------------------------------------------------------------------
+/// Interpolate convolved aperture linearly. Zero outside of the table in the isocenter plane,
+/// and clamped to the first and last depth
+inline double InterpolateLateralTable(const LateralTable& table, double u, double v, double depth)
+{
+  double position[3] = { (u - table.Origin[0]) / table.Spacing[0], (v - table.Origin[1]) / table.Spacing[1],
+    std::min(std::max(depth / table.Spacing[2], 0.0), table.Dimensions[2] - 1.0) };
+  int index[3] = { 0, 0, 0 };
+  double weight[3] = { 0.0, 0.0, 0.0 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (position[axis] < 0.0 || position[axis] > table.Dimensions[axis] - 1.0)
+    {
+      return 0.0;
+    }
+    index[axis] = std::min(static_cast<int>(position[axis]), table.Dimensions[axis] - 2);
+    weight[axis] = position[axis] - index[axis];
+  }
+  vtkIdType increments[3] = { 1, table.Dimensions[0], static_cast<vtkIdType>(table.Dimensions[0]) * table.Dimensions[1] };
+  const float* ptr = table.Values.data() + index[0] + index[1] * increments[1] + index[2] * increments[2];
+  double value00 = ptr[0] + weight[0] * (ptr[1] - ptr[0]);
+  double value10 = ptr[increments[1]] + weight[0] * (ptr[increments[1] + 1] - ptr[increments[1]]);
+  ptr += increments[2];
+  double value01 = ptr[0] + weight[0] * (ptr[1] - ptr[0]);
+  double value11 = ptr[increments[1]] + weight[0] * (ptr[increments[1] + 1] - ptr[increments[1]]);
+  double value0 = value00 + weight[1] * (value10 - value00);
+  double value1 = value01 + weight[1] * (value11 - value01);
+  return value0 + weight[2] * (value1 - value0);
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkPhotonPencilBeamDoseFilter);
+
+//----------------------------------------------------------------------------
+vtkPhotonPencilBeamDoseFilter::vtkPhotonPencilBeamDoseFilter()
+{
+  this->BeamToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  this->WaterEquivalentDepthFilter = vtkSmartPointer<vtkWaterEquivalentDepthFilter>::New();
+  this->OutputImage = vtkSmartPointer<vtkOrientedImageData>::New();
+
+  this->SourceToIsocenterDistance = 1000.0;
+  this->ReferenceDose = 1.0;
+  this->AttenuationCoefficient = 0.0028;
+  this->BuildUpLength = 4.0;
+  this->SurfaceDoseFraction = 0.4;
+  this->MinimumRelativeStoppingPower = 0.05;
+  this->PrimarySigma = 3.0;
+  this->PrimarySigmaDepthCoefficient = 0.01;
+  this->ScatterSigma = 15.0;
+  this->ScatterSigmaDepthCoefficient = 0.1;
+  this->ScatterWeight = 0.08;
+  this->LateralTableSpacing = 1.0;
+  this->LateralTableDepthSpacing = 10.0;
+}
+
+//----------------------------------------------------------------------------
+vtkPhotonPencilBeamDoseFilter::~vtkPhotonPencilBeamDoseFilter() = default;
+
+//----------------------------------------------------------------------------
+void vtkPhotonPencilBeamDoseFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "SourceToIsocenterDistance: " << this->SourceToIsocenterDistance << "\n";
+  os << indent << "NumberOfApertureRectangles: " << this->ApertureRectangles.size() << "\n";
+  os << indent << "ReferenceDose: " << this->ReferenceDose << "\n";
+  os << indent << "AttenuationCoefficient: " << this->AttenuationCoefficient << "\n";
+  os << indent << "BuildUpLength: " << this->BuildUpLength << "\n";
+  os << indent << "SurfaceDoseFraction: " << this->SurfaceDoseFraction << "\n";
+  os << indent << "MinimumRelativeStoppingPower: " << this->MinimumRelativeStoppingPower << "\n";
+  os << indent << "PrimarySigma: " << this->PrimarySigma << "\n";
+  os << indent << "PrimarySigmaDepthCoefficient: " << this->PrimarySigmaDepthCoefficient << "\n";
+  os << indent << "ScatterSigma: " << this->ScatterSigma << "\n";
+  os << indent << "ScatterSigmaDepthCoefficient: " << this->ScatterSigmaDepthCoefficient << "\n";
+  os << indent << "ScatterWeight: " << this->ScatterWeight << "\n";
+  os << indent << "LateralTableSpacing: " << this->LateralTableSpacing << "\n";
+  os << indent << "LateralTableDepthSpacing: " << this->LateralTableDepthSpacing << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkPhotonPencilBeamDoseFilter::SetInputVolume(vtkOrientedImageData* volume)
+{
+  this->InputVolume = volume;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkPhotonPencilBeamDoseFilter::GetInputVolume()
+{
+  return this->InputVolume;
+}
+
+//----------------------------------------------------------------------------
+void vtkPhotonPencilBeamDoseFilter::SetBeamToWorldMatrix(vtkMatrix4x4* beamToWorldMatrix)
+{
+  if (!beamToWorldMatrix)
+  {
+    this->BeamToWorldMatrix->Identity();
+    return;
+  }
+  this->BeamToWorldMatrix->DeepCopy(beamToWorldMatrix);
+}
+
+//----------------------------------------------------------------------------
+vtkMatrix4x4* vtkPhotonPencilBeamDoseFilter::GetBeamToWorldMatrix()
+{
+  return this->BeamToWorldMatrix;
+}
+
+//----------------------------------------------------------------------------
+void vtkPhotonPencilBeamDoseFilter::RemoveAllApertureRectangles()
+{
+  this->ApertureRectangles.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkPhotonPencilBeamDoseFilter::AddApertureRectangle(double x1, double x2, double y1, double y2)
+{
+  if (x2 <= x1 || y2 <= y1)
+  {
+    // Closed rectangles do not contribute to the dose
+    return;
+  }
+  this->ApertureRectangles.push_back({ x1, x2, y1, y2 });
+}
+
+//----------------------------------------------------------------------------
+int vtkPhotonPencilBeamDoseFilter::GetNumberOfApertureRectangles()
+{
+  return static_cast<int>(this->ApertureRectangles.size());
+}
+
+//----------------------------------------------------------------------------
+vtkWaterEquivalentDepthFilter* vtkPhotonPencilBeamDoseFilter::GetWaterEquivalentDepthFilter()
+{
+  return this->WaterEquivalentDepthFilter;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkPhotonPencilBeamDoseFilter::GetOutputImage()
+{
+  return this->OutputImage;
+}
+
+//----------------------------------------------------------------------------
+double vtkPhotonPencilBeamDoseFilter::GetDepthDose(double depth)
+{
+  // Build-up and attenuation, not normalized
+  double buildUpDeficit = 1.0 - this->SurfaceDoseFraction;
+  auto getDepthDose = [&](double d)
+  {
+    return exp(-this->AttenuationCoefficient * d) * (1.0 - buildUpDeficit * exp(-d / this->BuildUpLength));
+  };
+
+  // Depth of maximum dose, where the derivative of the curve is zero
+  double maximumDepth = 0.0;
+  if (this->AttenuationCoefficient > 0.0 && buildUpDeficit > 0.0)
+  {
+    double ratio = buildUpDeficit * (this->AttenuationCoefficient + 1.0 / this->BuildUpLength) / this->AttenuationCoefficient;
+    maximumDepth = (ratio > 1.0 ? this->BuildUpLength * log(ratio) : 0.0);
+  }
+  return getDepthDose(std::max(depth, 0.0)) / getDepthDose(maximumDepth);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPhotonPencilBeamDoseFilter::Update()
+{
+  if (!this->InputVolume || !this->InputVolume->GetPointData()->GetScalars() || this->InputVolume->IsEmpty())
+  {
+    vtkErrorMacro("Update: Invalid input volume");
+    return false;
+  }
+  if (this->ApertureRectangles.empty())
+  {
+    vtkErrorMacro("Update: Beam aperture is closed");
+    return false;
+  }
+  if ( this->BuildUpLength <= 0.0 || this->PrimarySigma <= 0.0 || this->ScatterSigma <= 0.0
+    || this->ScatterWeight < 0.0 || this->ScatterWeight > 1.0 || this->LateralTableSpacing <= 0.0 || this->LateralTableDepthSpacing <= 0.0 )
+  {
+    vtkErrorMacro("Update: Invalid kernel parameters");
+    return false;
+  }
+
+  // Radiological depth of the voxels
+  this->WaterEquivalentDepthFilter->SetInputVolume(this->InputVolume);
+  this->WaterEquivalentDepthFilter->SetBeamToWorldMatrix(this->BeamToWorldMatrix);
+  this->WaterEquivalentDepthFilter->SetSourceToIsocenterDistance(this->SourceToIsocenterDistance);
+  if (!this->WaterEquivalentDepthFilter->Update())
+  {
+    vtkErrorMacro("Update: Failed to compute radiological depth");
+    return false;
+  }
+  vtkOrientedImageData* depthImage = this->WaterEquivalentDepthFilter->GetOutputImage();
+  double depthRange[2] = { 0.0, 0.0 };
+  depthImage->GetPointData()->GetScalars()->GetRange(depthRange);
+
+  LateralKernel kernel;
+  kernel.Sigma[0] = this->PrimarySigma;
+  kernel.Sigma[1] = this->ScatterSigma;
+  kernel.SigmaDepthCoefficient[0] = this->PrimarySigmaDepthCoefficient;
+  kernel.SigmaDepthCoefficient[1] = this->ScatterSigmaDepthCoefficient;
+  kernel.Weight[0] = 1.0 - this->ScatterWeight;
+  kernel.Weight[1] = this->ScatterWeight;
+  LateralTable lateralTable;
+  ComputeLateralTable(this->ApertureRectangles, kernel, depthRange[1], this->LateralTableSpacing, this->LateralTableDepthSpacing, lateralTable);
+
+  // Tabulate the depth dose too, as it is smooth and evaluating it involves exponentials
+  const double depthDoseSpacing = 0.1;
+  std::vector<double> depthDoseTable(static_cast<size_t>(ceil(depthRange[1] / depthDoseSpacing)) + 2);
+  for (size_t index = 0; index < depthDoseTable.size(); ++index)
+  {
+    depthDoseTable[index] = this->GetDepthDose(index * depthDoseSpacing);
+  }
+
+  // Transform from voxel coordinates relative to the first voxel of the CT to beam coordinates
+  vtkNew<vtkMatrix4x4> ijkToWorldMatrix;
+  this->InputVolume->GetImageToWorldMatrix(ijkToWorldMatrix);
+  int* extent = this->InputVolume->GetExtent();
+  vtkNew<vtkMatrix4x4> extentOffsetMatrix;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    extentOffsetMatrix->SetElement(axis, 3, extent[2*axis]);
+  }
+  vtkNew<vtkMatrix4x4> worldToBeamMatrix;
+  vtkMatrix4x4::Invert(this->BeamToWorldMatrix, worldToBeamMatrix);
+  vtkNew<vtkMatrix4x4> ijkToBeamMatrix;
+  vtkMatrix4x4::Multiply4x4(worldToBeamMatrix, ijkToWorldMatrix, ijkToBeamMatrix);
+  vtkMatrix4x4::Multiply4x4(ijkToBeamMatrix, extentOffsetMatrix, ijkToBeamMatrix);
+  const double (*ijkToBeam)[4] = ijkToBeamMatrix->Element;
+
+  this->OutputImage->SetExtent(extent);
+  this->OutputImage->AllocateScalars(VTK_FLOAT, 1);
+  this->OutputImage->SetImageToWorldMatrix(ijkToWorldMatrix);
+  float* dosePtr = static_cast<float*>(this->OutputImage->GetScalarPointer());
+  const float* depthPtr = static_cast<const float*>(depthImage->GetScalarPointer());
+  const float* rspPtr = static_cast<const float*>(this->WaterEquivalentDepthFilter->GetRelativeStoppingPowerImage()->GetScalarPointer());
+  double minimumRsp = this->MinimumRelativeStoppingPower;
+  int* dimensions = this->InputVolume->GetDimensions();
+  double sad = this->SourceToIsocenterDistance;
+  double referenceDose = this->ReferenceDose;
+  vtkIdType numberOfRows = static_cast<vtkIdType>(dimensions[1]) * dimensions[2];
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType beginRow, vtkIdType endRow)
+  {
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+    {
+      double j = static_cast<double>(row % dimensions[1]);
+      double k = static_cast<double>(row / dimensions[1]);
+      vtkIdType offset = row * dimensions[0];
+      for (int i = 0; i < dimensions[0]; ++i)
+      {
+        double x = ijkToBeam[0][0] * i + ijkToBeam[0][1] * j + ijkToBeam[0][2] * k + ijkToBeam[0][3];
+        double y = ijkToBeam[1][0] * i + ijkToBeam[1][1] * j + ijkToBeam[1][2] * k + ijkToBeam[1][3];
+        double z = ijkToBeam[2][0] * i + ijkToBeam[2][1] * j + ijkToBeam[2][2] * k + ijkToBeam[2][3];
+        double axialDistance = sad - z;
+        if (axialDistance <= 0.0 || rspPtr[offset + i] < minimumRsp)
+        {
+          dosePtr[offset + i] = 0.0f;
+          continue;
+        }
+        double magnification = sad / axialDistance;
+        double depth = depthPtr[offset + i];
+        double lateral = InterpolateLateralTable(lateralTable, x * magnification, y * magnification, depth);
+        double depthDosePosition = depth / depthDoseSpacing;
+        size_t depthDoseIndex = std::min(static_cast<size_t>(depthDosePosition), depthDoseTable.size() - 2);
+        double depthDoseWeight = std::min(depthDosePosition - depthDoseIndex, 1.0);
+        double depthDose = depthDoseTable[depthDoseIndex] + depthDoseWeight * (depthDoseTable[depthDoseIndex + 1] - depthDoseTable[depthDoseIndex]);
+        dosePtr[offset + i] = static_cast<float>(referenceDose * depthDose * magnification * magnification * lateral);
+      }
+    }
+  });
+
+  this->OutputImage->Modified();
+  return true;
+}
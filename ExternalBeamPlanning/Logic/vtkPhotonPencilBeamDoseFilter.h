@@ -0,0 +1,194 @@
+/*==============================================================================
+
+  Copyright (c) Radiation Medicine Program, University Health Network,
+  Princess Margaret Hospital, Toronto, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkPhotonPencilBeamDoseFilter_h
+#define __vtkPhotonPencilBeamDoseFilter_h
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "vtkSlicerExternalBeamPlanningModuleLogicExport.h"
+
+// STD includes
+#include <array>
+#include <vector>
+
+class vtkMatrix4x4;
+class vtkOrientedImageData;
+class vtkWaterEquivalentDepthFilter;
+
+/// \ingroup SlicerRt_QtModules_ExternalBeamPlanning
+/// \brief Compute photon dose of a beam on a CT volume with an analytic pencil beam kernel.
+///
+/// The dose of a voxel is the product of
+/// - a depth dose curve in the radiological depth of the voxel, with exponential build-up and
+///   attenuation, normalized to one at its maximum,
+/// - the inverse square of the distance from the source along the beam axis, relative to SAD,
+/// - the aperture (jaws and MLC opening) convolved with a lateral double Gaussian kernel of a primary
+///   and a scatter component, whose widths grow linearly with the radiological depth.
+/// The reference dose is therefore delivered at the depth of maximum dose on the axis of a broad field,
+/// at the isocenter distance. Voxels of air (relative stopping power below a threshold) get no dose.
+///
+/// Radiological depth is computed by \sa vtkWaterEquivalentDepthFilter, so the HU lookup table of that
+/// filter can be set to the relative electron density calibration of the scanner. The convolved aperture
+/// is tabulated in the isocenter plane at a few depths before the voxels are computed, so the voxel loop
+/// (run in parallel) only interpolates. The output has the geometry of the CT.
+///
+/// The beam geometry is given in the beam coordinate system of the IEC hierarchy (the parent transform
+/// of the beam node): isocenter is at the origin, the source is at (0, 0, SAD), and the aperture is
+/// given in the isocenter plane, as the jaw and leaf positions of the beam node.
+///
+/// Similarly to the segment morphology filters, this class is not a VTK pipeline filter.
+class VTK_SLICER_EXTERNALBEAMPLANNING_MODULE_LOGIC_EXPORT vtkPhotonPencilBeamDoseFilter : public vtkObject
+{
+public:
+  static vtkPhotonPencilBeamDoseFilter *New();
+  vtkTypeMacro(vtkPhotonPencilBeamDoseFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set CT volume in HU. The volume is referenced, not copied.
+  void SetInputVolume(vtkOrientedImageData* volume);
+  /// Get CT volume
+  vtkOrientedImageData* GetInputVolume();
+
+  /// Set transform from beam coordinate system to world. Identity by default
+  void SetBeamToWorldMatrix(vtkMatrix4x4* beamToWorldMatrix);
+  /// Get transform from beam coordinate system to world
+  vtkMatrix4x4* GetBeamToWorldMatrix();
+
+  /// Get/Set source to isocenter distance (SAD) in mm. 1000 by default
+  vtkGetMacro(SourceToIsocenterDistance, double);
+  vtkSetMacro(SourceToIsocenterDistance, double);
+
+  /// Remove all rectangles from the aperture
+  void RemoveAllApertureRectangles();
+  /// Add open rectangle to the aperture, in the isocenter plane along the beam X and Y axes (mm).
+  /// Rectangles must not overlap, e.g. one for the jaws, or one for each open leaf pair within the jaws
+  void AddApertureRectangle(double x1, double x2, double y1, double y2);
+  /// Get number of rectangles of the aperture
+  int GetNumberOfApertureRectangles();
+
+  /// Get/Set dose at the depth of maximum dose on the axis of a broad field at isocenter distance (Gy).
+  /// 1 by default
+  vtkGetMacro(ReferenceDose, double);
+  vtkSetMacro(ReferenceDose, double);
+
+  /// Get/Set effective attenuation coefficient of the depth dose curve beyond the build-up region (1/mm).
+  /// 0.0028 by default, which approximates the depth dose of a 10x10cm 6MV field
+  vtkGetMacro(AttenuationCoefficient, double);
+  vtkSetMacro(AttenuationCoefficient, double);
+
+  /// Get/Set characteristic length of the build-up region (mm). 4 by default
+  vtkGetMacro(BuildUpLength, double);
+  vtkSetMacro(BuildUpLength, double);
+
+  /// Get/Set dose at the surface relative to the extrapolated attenuation curve. 0.4 by default
+  vtkGetMacro(SurfaceDoseFraction, double);
+  vtkSetMacro(SurfaceDoseFraction, double);
+
+  /// Get/Set relative stopping power below which voxels get no dose. The depth dose curve is dose to water,
+  /// so without this the air in front of the patient would get the surface dose. 0.05 by default, which is
+  /// above air and below lung
+  vtkGetMacro(MinimumRelativeStoppingPower, double);
+  vtkSetMacro(MinimumRelativeStoppingPower, double);
+
+  /// Get/Set standard deviation of the primary lateral Gaussian at the surface and its increase per mm of
+  /// radiological depth, in the isocenter plane. 3mm and 0.01 by default
+  vtkGetMacro(PrimarySigma, double);
+  vtkSetMacro(PrimarySigma, double);
+  vtkGetMacro(PrimarySigmaDepthCoefficient, double);
+  vtkSetMacro(PrimarySigmaDepthCoefficient, double);
+
+  /// Get/Set standard deviation of the scatter lateral Gaussian at the surface and its increase per mm of
+  /// radiological depth, in the isocenter plane. 15mm and 0.1 by default
+  vtkGetMacro(ScatterSigma, double);
+  vtkSetMacro(ScatterSigma, double);
+  vtkGetMacro(ScatterSigmaDepthCoefficient, double);
+  vtkSetMacro(ScatterSigmaDepthCoefficient, double);
+
+  /// Get/Set weight of the scatter Gaussian in the lateral kernel (the primary has one minus this weight).
+  /// 0.08 by default
+  vtkGetMacro(ScatterWeight, double);
+  vtkSetMacro(ScatterWeight, double);
+
+  /// Get/Set spacing of the table of the convolved aperture in the isocenter plane in mm. 1 by default
+  vtkGetMacro(LateralTableSpacing, double);
+  vtkSetMacro(LateralTableSpacing, double);
+
+  /// Get/Set spacing of the radiological depths at which the convolved aperture is tabulated in mm.
+  /// 10 by default
+  vtkGetMacro(LateralTableDepthSpacing, double);
+  vtkSetMacro(LateralTableDepthSpacing, double);
+
+  /// Get filter computing the radiological depth. Its HU lookup table and ray sampling can be changed
+  vtkWaterEquivalentDepthFilter* GetWaterEquivalentDepthFilter();
+
+  /// Get depth dose at a radiological depth, normalized to one at its maximum
+  double GetDepthDose(double depth);
+
+  /// Compute the dose
+  /// \return Success flag
+  bool Update();
+
+  /// Get dose image in Gy. It has the same geometry as the input volume
+  vtkOrientedImageData* GetOutputImage();
+
+protected:
+  vtkPhotonPencilBeamDoseFilter();
+  ~vtkPhotonPencilBeamDoseFilter() override;
+
+protected:
+  /// CT volume in HU
+  vtkSmartPointer<vtkOrientedImageData> InputVolume;
+  /// Transform from beam coordinate system to world
+  vtkSmartPointer<vtkMatrix4x4> BeamToWorldMatrix;
+  /// Radiological depth filter
+  vtkSmartPointer<vtkWaterEquivalentDepthFilter> WaterEquivalentDepthFilter;
+  /// Dose image
+  vtkSmartPointer<vtkOrientedImageData> OutputImage;
+
+  /// Open rectangles of the aperture in the isocenter plane (x1, x2, y1, y2)
+  std::vector< std::array<double, 4> > ApertureRectangles;
+
+  /// Source to isocenter distance in mm
+  double SourceToIsocenterDistance;
+  /// Reference dose in Gy
+  double ReferenceDose;
+  /// Effective attenuation coefficient in 1/mm
+  double AttenuationCoefficient;
+  /// Build-up length in mm
+  double BuildUpLength;
+  /// Relative surface dose
+  double SurfaceDoseFraction;
+  /// Relative stopping power below which there is no dose
+  double MinimumRelativeStoppingPower;
+  /// Primary lateral Gaussian parameters
+  double PrimarySigma;
+  double PrimarySigmaDepthCoefficient;
+  /// Scatter lateral Gaussian parameters
+  double ScatterSigma;
+  double ScatterSigmaDepthCoefficient;
+  double ScatterWeight;
+  /// Sampling of the convolved aperture table
+  double LateralTableSpacing;
+  double LateralTableDepthSpacing;
+
+private:
+  vtkPhotonPencilBeamDoseFilter(const vtkPhotonPencilBeamDoseFilter&) = delete;
+  void operator=(const vtkPhotonPencilBeamDoseFilter&) = delete;
+};
+
+#endif
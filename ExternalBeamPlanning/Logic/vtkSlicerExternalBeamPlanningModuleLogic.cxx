@@ -27,51 +27,28 @@
 #include "vtkSlicerBeamsModuleLogic.h"
 #include "vtkSlicerIECTransformLogic.h"
 
+// ExternalBeamPlanning includes
+#include "vtkDrrImageFilter.h"
+#include "vtkWaterEquivalentDepthFilter.h"
+
 // MRML includes
-//#include <vtkMRMLMarkupsFiducialNode.h> //TODO: Includes commented out due to obsolete methods, see below
-//#include <vtkMRMLLinearTransformNode.h>
 #include <vtkMRMLScalarVolumeNode.h>
-//#include <vtkMRMLScalarVolumeDisplayNode.h>
-//#include <vtkMRMLDoubleArrayNode.h>
-//#include <vtkMRMLSliceLogic.h>
-//#include <vtkMRMLSliceNode.h>
-//#include <vtkMRMLSliceCompositeNode.h>
 #include <vtkMRMLSubjectHierarchyNode.h>
+#include <vtkMRMLTransformNode.h>
 
 // Slicer includes
 #include <vtkSlicerCLIModuleLogic.h>
 #include <vtkSlicerSubjectHierarchyModuleLogic.h>
 
 // VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
-//#include <vtkConeSource.h>
-//#include <vtkPoints.h>
-//#include <vtkCellArray.h>
-//#include <vtkDoubleArray.h>
-//#include <vtkPolyData.h>
-//#include <vtkObjectFactory.h>
-//#include <vtkRenderer.h>
-//#include <vtkRenderWindow.h>
-//#include <vtkCamera.h>
-//#include <vtkColorTransferFunction.h>
-//#include <vtkImageData.h>
-//#include <vtkImageCast.h>
-//#include <vtkPiecewiseFunction.h>
-//#include <vtkProperty.h>
-//#include <vtkActor.h>
-//#include <vtkVolumeProperty.h>
-//#include <vtkVolumeRayCastMapper.h>
-//#include <vtkGPUVolumeRayCastMapper.h>
-//#include <vtkVolumeRayCastCompositeFunction.h>
-//#include <vtkVolumeTextureMapper2D.h>
-//#include <vtkWindowToImageFilter.h>
-//#include <vtkImageShiftScale.h>
-//#include <vtkImageExtractComponents.h>
-//#include <vtkTransform.h>
-//#include <vtkPolyDataMapper.h>
-//#include <vtkImageGradientMagnitude.h>
-//#include <vtkImageMathematics.h>
+
+//----------------------------------------------------------------------------
+static const char* DRR_VOLUME_NODE_NAME_POSTFIX = "_DRR";
+static const char* WED_VOLUME_NODE_NAME_POSTFIX = "_WED";
 
 //----------------------------------------------------------------------------
 vtkCxxSetObjectMacro(vtkSlicerExternalBeamPlanningModuleLogic, BeamsLogic, vtkSlicerBeamsModuleLogic);
@@ -98,10 +75,12 @@ vtkStandardNewMacro(vtkSlicerExternalBeamPlanningModuleLogic);
 //----------------------------------------------------------------------------
 vtkSlicerExternalBeamPlanningModuleLogic::vtkSlicerExternalBeamPlanningModuleLogic()
 {
-  this->DRRImageSize[0] = 256;
-  this->DRRImageSize[1] = 256;
+  this->DRRImageSize[0] = 512;
+  this->DRRImageSize[1] = 512;
 
   this->BeamsLogic = nullptr;
+  this->DRRImageFilter = vtkDrrImageFilter::New();
+  this->WEDFilter = vtkWaterEquivalentDepthFilter::New();
 
   this->Internal = new vtkInternal;
 }
@@ -110,6 +89,8 @@ vtkSlicerExternalBeamPlanningModuleLogic::vtkSlicerExternalBeamPlanningModuleLog
 vtkSlicerExternalBeamPlanningModuleLogic::~vtkSlicerExternalBeamPlanningModuleLogic()
 {
   this->SetBeamsLogic(nullptr);
+  this->DRRImageFilter->Delete();
+  this->WEDFilter->Delete();
 
   delete this->Internal;
 }
@@ -118,6 +99,8 @@ vtkSlicerExternalBeamPlanningModuleLogic::~vtkSlicerExternalBeamPlanningModuleLo
 void vtkSlicerExternalBeamPlanningModuleLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "DRRImageSize: " << this->DRRImageSize[0] << ", " << this->DRRImageSize[1] << "\n";
 }
 
 //-----------------------------------------------------------------------------
@@ -337,22 +320,237 @@ vtkMRMLRTBeamNode* vtkSlicerExternalBeamPlanningModuleLogic::CloneBeamInPlan(vtk
   return beamCloneNode;
 }
 
+//---------------------------------------------------------------------------
+vtkDrrImageFilter* vtkSlicerExternalBeamPlanningModuleLogic::GetDRRImageFilter()
+{
+  return this->DRRImageFilter;
+}
 
 //---------------------------------------------------------------------------
+bool vtkSlicerExternalBeamPlanningModuleLogic::UpdateDRR(vtkMRMLRTPlanNode* planNode, char* beamName)
+{
+  if ( !this->GetMRMLScene() || !planNode )
+  {
+    vtkErrorMacro("UpdateDRR: Invalid MRML scene or RT plan node");
+    return false;
+  }
+
+  vtkMRMLScalarVolumeNode* referenceVolumeNode = planNode->GetReferenceVolumeNode();
+  if (!referenceVolumeNode || !referenceVolumeNode->GetImageData())
+  {
+    vtkErrorMacro("UpdateDRR: Failed to access reference volume node");
+    return false;
+  }
+
+  // Get beam node by name
+  vtkMRMLRTBeamNode* beamNode = (beamName ? planNode->GetBeamByName(beamName) : nullptr);
+  if (!beamNode)
+  {
+    vtkErrorMacro("UpdateDRR: Unable to access beam node with name " << (beamName?beamName:"nullptr"));
+    return false;
+  }
+
+  // Reference volume in world coordinates. The voxels are not copied, so that the attenuation
+  // volume cached in the DRR filter is reused for subsequent beams and beam geometry changes
+  vtkNew<vtkOrientedImageData> referenceImage;
+  if (!this->GetVolumeImageInWorld(referenceVolumeNode, referenceImage))
+  {
+    vtkErrorMacro("UpdateDRR: Failed to get image of reference volume " << referenceVolumeNode->GetName());
+    return false;
+  }
+
+  vtkNew<vtkMatrix4x4> beamToWorldMatrix;
+  this->GetBeamToWorldMatrix(beamNode, beamToWorldMatrix);
+
+  this->DRRImageFilter->SetInputVolume(referenceImage);
+  this->DRRImageFilter->SetBeamToWorldMatrix(beamToWorldMatrix);
+  this->DRRImageFilter->SetSourceToIsocenterDistance(beamNode->GetSAD());
+  this->DRRImageFilter->SetDetectorSize(this->DRRImageSize);
+  if (!this->DRRImageFilter->Update())
+  {
+    vtkErrorMacro("UpdateDRR: Failed to compute DRR for beam " << beamNode->GetName());
+    return false;
+  }
+  vtkOrientedImageData* drrImage = this->DRRImageFilter->GetOutputImage();
+
+  // Create DRR volume node if missing, and place it under the beam in subject hierarchy
+  vtkMRMLScalarVolumeNode* drrVolumeNode = beamNode->GetDRRVolumeNode();
+  if (!drrVolumeNode)
+  {
+    vtkSmartPointer<vtkMRMLScalarVolumeNode> newDrrVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+    std::string drrVolumeNodeName = std::string(beamNode->GetName()) + std::string(DRR_VOLUME_NODE_NAME_POSTFIX);
+    newDrrVolumeNode->SetName(this->GetMRMLScene()->GenerateUniqueName(drrVolumeNodeName).c_str());
+    this->GetMRMLScene()->AddNode(newDrrVolumeNode);
+    newDrrVolumeNode->CreateDefaultDisplayNodes();
+    beamNode->SetAndObserveDRRVolumeNode(newDrrVolumeNode);
+    drrVolumeNode = newDrrVolumeNode;
+
+    vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(this->GetMRMLScene());
+    if (shNode)
+    {
+      shNode->SetItemParent(shNode->GetItemByDataNode(drrVolumeNode), shNode->GetItemByDataNode(beamNode));
+    }
+  }
+
+  // The DRR geometry is in world coordinates, stored in the IJK to RAS matrix of the volume
+  vtkNew<vtkMatrix4x4> drrIjkToWorldMatrix;
+  drrImage->GetImageToWorldMatrix(drrIjkToWorldMatrix);
+  vtkSmartPointer<vtkImageData> drrImageData = vtkSmartPointer<vtkImageData>::New();
+  drrImageData->DeepCopy(drrImage);
+  drrImageData->SetOrigin(0.0, 0.0, 0.0);
+  drrImageData->SetSpacing(1.0, 1.0, 1.0);
+  drrVolumeNode->SetAndObserveTransformNodeID(nullptr);
+  drrVolumeNode->SetIJKToRASMatrix(drrIjkToWorldMatrix);
+  drrVolumeNode->SetAndObserveImageData(drrImageData);
+
+  return true;
+}
+
 //---------------------------------------------------------------------------
-//
-// Obsolete methods
-//
+vtkWaterEquivalentDepthFilter* vtkSlicerExternalBeamPlanningModuleLogic::GetWEDFilter()
+{
+  return this->WEDFilter;
+}
+
 //---------------------------------------------------------------------------
+vtkMRMLScalarVolumeNode* vtkSlicerExternalBeamPlanningModuleLogic::ComputeWED(
+  vtkMRMLRTBeamNode* beamNode, vtkMRMLScalarVolumeNode* wedVolumeNode/*=nullptr*/)
+{
+  if ( !this->GetMRMLScene() || !beamNode )
+  {
+    vtkErrorMacro("ComputeWED: Invalid MRML scene or beam node");
+    return nullptr;
+  }
+  vtkMRMLRTPlanNode* planNode = beamNode->GetParentPlanNode();
+  vtkMRMLScalarVolumeNode* referenceVolumeNode = (planNode ? planNode->GetReferenceVolumeNode() : nullptr);
+  if (!referenceVolumeNode)
+  {
+    vtkErrorMacro("ComputeWED: Failed to access reference volume node of beam " << beamNode->GetName());
+    return nullptr;
+  }
+
+  // Reference volume in world coordinates. The voxels are not copied, so that the stopping power
+  // volume and ray grids cached in the WED filter are reused for subsequent beam geometry changes
+  vtkNew<vtkOrientedImageData> referenceImage;
+  if (!this->GetVolumeImageInWorld(referenceVolumeNode, referenceImage))
+  {
+    vtkErrorMacro("ComputeWED: Failed to get image of reference volume " << referenceVolumeNode->GetName());
+    return nullptr;
+  }
+
+  vtkNew<vtkMatrix4x4> beamToWorldMatrix;
+  this->GetBeamToWorldMatrix(beamNode, beamToWorldMatrix);
+
+  // Keep the ray grids of all beams of the plan cached, so that switching between beams does not
+  // evict the geometry of another beam
+  if (this->WEDFilter->GetMaximumNumberOfCachedRayGrids() < planNode->GetNumberOfBeams())
+  {
+    this->WEDFilter->SetMaximumNumberOfCachedRayGrids(planNode->GetNumberOfBeams());
+  }
+
+  this->WEDFilter->SetInputVolume(referenceImage);
+  this->WEDFilter->SetBeamToWorldMatrix(beamToWorldMatrix);
+  this->WEDFilter->SetSourceToIsocenterDistance(beamNode->GetSAD());
+  if (!this->WEDFilter->Update())
+  {
+    vtkErrorMacro("ComputeWED: Failed to compute WED for beam " << beamNode->GetName());
+    return nullptr;
+  }
+
+  // Use the WED volume under the beam in subject hierarchy if not given, and create it if missing
+  std::string wedVolumeNodeName = std::string(beamNode->GetName()) + std::string(WED_VOLUME_NODE_NAME_POSTFIX);
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(this->GetMRMLScene());
+  if (!wedVolumeNode && shNode)
+  {
+    std::vector<vtkIdType> beamChildItemIDs;
+    shNode->GetItemChildren(shNode->GetItemByDataNode(beamNode), beamChildItemIDs);
+    for (vtkIdType childItemID : beamChildItemIDs)
+    {
+      vtkMRMLScalarVolumeNode* childVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(shNode->GetItemDataNode(childItemID));
+      if (childVolumeNode && childVolumeNode->GetName() && wedVolumeNodeName == childVolumeNode->GetName())
+      {
+        wedVolumeNode = childVolumeNode;
+        break;
+      }
+    }
+  }
+  if (!wedVolumeNode)
+  {
+    vtkSmartPointer<vtkMRMLScalarVolumeNode> newWedVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+    newWedVolumeNode->SetName(this->GetMRMLScene()->GenerateUniqueName(wedVolumeNodeName).c_str());
+    this->GetMRMLScene()->AddNode(newWedVolumeNode);
+    newWedVolumeNode->CreateDefaultDisplayNodes();
+    wedVolumeNode = newWedVolumeNode;
+    if (shNode)
+    {
+      shNode->SetItemParent(shNode->GetItemByDataNode(wedVolumeNode), shNode->GetItemByDataNode(beamNode));
+    }
+  }
+
+  // The WED volume has the geometry of the reference volume, including its parent transform
+  vtkNew<vtkMatrix4x4> referenceIjkToRasMatrix;
+  referenceVolumeNode->GetIJKToRASMatrix(referenceIjkToRasMatrix);
+  vtkSmartPointer<vtkImageData> wedImageData = vtkSmartPointer<vtkImageData>::New();
+  wedImageData->DeepCopy(this->WEDFilter->GetOutputImage());
+  wedImageData->SetOrigin(0.0, 0.0, 0.0);
+  wedImageData->SetSpacing(1.0, 1.0, 1.0);
+  wedVolumeNode->SetAndObserveTransformNodeID(referenceVolumeNode->GetTransformNodeID());
+  wedVolumeNode->SetIJKToRASMatrix(referenceIjkToRasMatrix);
+  wedVolumeNode->SetAndObserveImageData(wedImageData);
+
+  return wedVolumeNode;
+}
+
 //---------------------------------------------------------------------------
+bool vtkSlicerExternalBeamPlanningModuleLogic::GetVolumeImageInWorld(vtkMRMLScalarVolumeNode* volumeNode, vtkOrientedImageData* image)
+{
+  if (!volumeNode || !volumeNode->GetImageData() || !image)
+  {
+    vtkErrorMacro("GetVolumeImageInWorld: Invalid volume node or output image");
+    return false;
+  }
+
+  vtkNew<vtkMatrix4x4> ijkToRasMatrix;
+  volumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+  vtkNew<vtkMatrix4x4> ijkToWorldMatrix;
+  ijkToWorldMatrix->DeepCopy(ijkToRasMatrix);
+  vtkMRMLTransformNode* transformNode = volumeNode->GetParentTransformNode();
+  if (transformNode)
+  {
+    if (!transformNode->IsTransformToWorldLinear())
+    {
+      vtkErrorMacro("GetVolumeImageInWorld: Non-linear transform of volume " << volumeNode->GetName() << " is not supported");
+      return false;
+    }
+    vtkNew<vtkMatrix4x4> rasToWorldMatrix;
+    transformNode->GetMatrixTransformToWorld(rasToWorldMatrix);
+    vtkMatrix4x4::Multiply4x4(rasToWorldMatrix, ijkToRasMatrix, ijkToWorldMatrix);
+  }
+  image->vtkImageData::ShallowCopy(volumeNode->GetImageData());
+  image->SetGeometryFromImageToWorldMatrix(ijkToWorldMatrix);
+  return true;
+}
 
 //---------------------------------------------------------------------------
-void vtkSlicerExternalBeamPlanningModuleLogic::ComputeWED()
+void vtkSlicerExternalBeamPlanningModuleLogic::GetBeamToWorldMatrix(vtkMRMLRTBeamNode* beamNode, vtkMatrix4x4* beamToWorldMatrix)
 {
-  //TODO: Needs implementation
-  vtkErrorMacro("ComputeWED: Not implemented");
+  beamToWorldMatrix->Identity();
+  vtkMRMLTransformNode* beamTransformNode = (beamNode ? beamNode->GetParentTransformNode() : nullptr);
+  if (beamTransformNode)
+  {
+    beamTransformNode->GetMatrixTransformToWorld(beamToWorldMatrix);
+  }
 }
 
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//
+// Obsolete methods
+//
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
 //----------------------------------------------------------------------------
 void vtkSlicerExternalBeamPlanningModuleLogic::SetMatlabDoseCalculationModuleLogic(vtkSlicerCLIModuleLogic* logic)
 {
@@ -406,326 +604,3 @@ std::string vtkSlicerExternalBeamPlanningModuleLogic::ComputeDoseByMatlab(vtkMRM
 
   return "Matlab dose engine unavailable";
 }
-
-//---------------------------------------------------------------------------
-void vtkSlicerExternalBeamPlanningModuleLogic::UpdateDRR(vtkMRMLRTPlanNode* planNode, char* beamName)
-{
-  if ( !this->GetMRMLScene() || !planNode )
-  {
-    vtkErrorMacro("RemoveBeam: Invalid MRML scene or RT plan node");
-    return;
-  }
-
-  (void)(beamName); // unused
-#if defined (commentout)
-  vtkMRMLScalarVolumeNode* referenceVolumeNode = planNode->GetReferenceVolumeNode();
-  if (!referenceVolumeNode)
-  {
-    vtkErrorMacro("UpdateDRR: Failed to access reference volume node");
-    return;
-  }
-
-  // Get beam node by name
-  vtkMRMLRTBeamNode* beamNode = planNode->GetBeamByName(beamName);
-  if (!beamNode)
-  {
-    vtkErrorMacro("UpdateDRR: Unable to access beam node with name " << (beamName?beamName:"nullptr"));
-    return;
-  }
-
-  vtkMRMLMarkupsFiducialNode* isocenterMarkupsNode = beamNode->GetIsocenterFiducialNode();
-  // vtkMRMLDoubleArrayNode* MLCPositionDoubleArrayNode = beamNode->GetMLCPositionDoubleArrayNode();
-  if (!isocenterMarkupsNode) // || !MLCPositionDoubleArrayNode)
-  {
-    vtkErrorMacro("UpdateDRR: Inputs are not initialized");
-    return;
-  }
-
-  // Cast image data to uchar for faster rendering (this is for CT data only now)
-  vtkSmartPointer<vtkImageShiftScale> cast = vtkSmartPointer<vtkImageShiftScale>::New();
-  cast->SetInputData(referenceVolumeNode->GetImageData());
-  cast->SetOutputScalarTypeToUnsignedChar();
-  cast->SetShift(1000);
-  cast->SetScale(255./2000.);
-  cast->SetClampOverflow(1);
-  cast->Update();
-
-  // Create the renderer, render window 
-  vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
-  vtkSmartPointer<vtkRenderWindow> renWin = vtkSmartPointer<vtkRenderWindow>::New();
-  renWin->SetOffScreenRendering(1);
-  renWin->AddRenderer(renderer);
-
-  // Create our volume and mapper
-  // Currently use cpu ray casting as gpu ray casting and texturemapping 3d are not working on my computer
-  vtkSmartPointer<vtkVolume> volume = vtkSmartPointer<vtkVolume>::New();
-  vtkSmartPointer<vtkVolumeRayCastMapper> mapper = vtkSmartPointer<vtkVolumeRayCastMapper>::New();
-  vtkSmartPointer<vtkVolumeRayCastCompositeFunction> compositeFunction = vtkSmartPointer<vtkVolumeRayCastCompositeFunction>::New();
-  mapper->SetVolumeRayCastFunction(compositeFunction);
-  //vtkSmartPointer<vtkVolumeTextureMapper3D> mapper = vtkSmartPointer<vtkVolumeTextureMapper3D>::New();
-  //vtkSmartPointer<vtkVolumeTextureMapper2D> mapper = vtkSmartPointer<vtkVolumeTextureMapper2D>::New();
-  //vtkSmartPointer<vtkGPUVolumeRayCastMapper> mapper = vtkSmartPointer<vtkGPUVolumeRayCastMapper>::New();
-  mapper->SetInputData( cast->GetOutput() );
-  mapper->SetBlendModeToComposite();
-  volume->SetMapper( mapper );
-
-  // Create our transfer function
-  vtkSmartPointer<vtkColorTransferFunction> colorFun = vtkSmartPointer<vtkColorTransferFunction>::New();
-  vtkSmartPointer<vtkPiecewiseFunction> opacityFun = vtkSmartPointer<vtkPiecewiseFunction>::New();
-
-  // Create the property and attach the transfer functions
-  vtkSmartPointer<vtkVolumeProperty> volumeProperty = vtkSmartPointer<vtkVolumeProperty>::New();
-  volumeProperty->SetColor( colorFun );
-  volumeProperty->SetScalarOpacity( opacityFun );
-  volumeProperty->SetInterpolationTypeToLinear();
-
-  colorFun->AddRGBPoint( 0, 0, 0, 0);
-  colorFun->AddRGBPoint( 128, 0, 0, 0);
-  colorFun->AddRGBPoint( 255, 1, 1, 1);
-
-  opacityFun->AddPoint(0, 0 );
-  opacityFun->AddPoint(128, 0 );
-  opacityFun->AddPoint(255, 0.2);
-
-  volumeProperty->ShadeOff();
-  volumeProperty->SetScalarOpacityUnitDistance(0.8919);
-
-  // connect up the volume to the property and the mapper
-  volume->SetProperty( volumeProperty );
-
-  vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
-  transform->Identity();
-  transform->RotateY(beamNode->GetGantryAngle());
-  transform->RotateX(90);
-
-  vtkSmartPointer<vtkTransform> transform2 = vtkSmartPointer<vtkTransform>::New();
-  transform2->Identity();
-  double isoCenterPosition[3] = {0.0,0.0,0.0};
-  isocenterMarkupsNode->GetNthFiducialPosition(0,isoCenterPosition);
-  transform2->Translate(-isoCenterPosition[0], -isoCenterPosition[1], -isoCenterPosition[2]);
-
-  vtkSmartPointer<vtkTransform> transform3 = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkMatrix4x4> IJK2RASMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  referenceVolumeNode->GetIJKToRASMatrix(IJK2RASMatrix);
-  transform3->SetMatrix(IJK2RASMatrix);
-
-  transform->PreMultiply();
-  transform->Concatenate(transform2);
-  transform->Concatenate(transform3);
-  volume->SetUserTransform( transform );
-
-  // The usual rendering stuff.
-  vtkSmartPointer<vtkCamera> camera = vtkSmartPointer<vtkCamera>::New();
-  // fixed camera parameters for now
-  camera->SetPosition(0, 0, 1000);
-  camera->SetFocalPoint(0, 0, 0);
-  camera->SetViewAngle(14.68);
-  camera->SetClippingRange(100, 2000);
-  camera->ParallelProjectionOff();
-
-  // Add the volume to the scene
-  renderer->AddVolume( volume );
-  renderer->SetActiveCamera(camera);
-
-  renWin->SetSize(this->DRRImageSize[0], this->DRRImageSize[1]);
-  renWin->Render();
-
-  // Capture and convert to 2D image
-  vtkSmartPointer<vtkWindowToImageFilter> windowToImage = vtkSmartPointer<vtkWindowToImageFilter>::New();
-  windowToImage->SetInput( renWin );
-
-  vtkSmartPointer<vtkImageExtractComponents> extract = vtkSmartPointer<vtkImageExtractComponents>::New();
-  extract->SetInputConnection( windowToImage->GetOutputPort() );
-  extract->SetComponents(0);
-  extract->Update();
-
-  // Add the drr image to mrml scene
-  vtkSmartPointer<vtkMRMLScalarVolumeNode> drrImageNode = beamNode->GetDRRVolumeNode();
-  if (!drrImageNode)
-  {
-    drrImageNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
-    drrImageNode = vtkMRMLScalarVolumeNode::SafeDownCast(this->GetMRMLScene()->AddNode(drrImageNode));
-    std::string DRRImageNodeName = std::string(beamName) + std::string("_DRRImage");
-    DRRImageNodeName = this->GetMRMLScene()->GenerateUniqueName(DRRImageNodeName);
-    drrImageNode->SetName(DRRImageNodeName.c_str());
-    beamNode->SetAndObserveDRRVolumeNode(drrImageNode);
-  }
-  drrImageNode->SetAndObserveImageData(extract->GetOutput());
-  drrImageNode->SetOrigin(-128,-128,0);
-  drrImageNode->SetSelectable(1);
-
-  vtkSmartPointer<vtkMRMLSliceLogic> sliceLogic = this->GetApplicationLogic()->GetSliceLogicByLayoutName("Slice4");
-  if (!sliceLogic)
-  {
-    vtkErrorMacro("UpdateDRR: Invalid sliceLogic for DRR viewer");
-    return;
-  }
-
-  // Transforms to place the DRR image aligned with the beam geometry
-  vtkSmartPointer<vtkTransform> transformDRR = vtkSmartPointer<vtkTransform>::New();
-  transformDRR->Identity();
-  transformDRR->RotateZ(beamNode->GetGantryAngle());
-  transformDRR->RotateX(-90);
-
-  vtkSmartPointer<vtkTransform> transformDRR2 = vtkSmartPointer<vtkTransform>::New();
-  transformDRR2->Identity();
-  transformDRR2->Translate(isoCenterPosition[0], isoCenterPosition[1], isoCenterPosition[2]);
-
-  transformDRR->PostMultiply();
-  transformDRR->Concatenate(transformDRR2->GetMatrix());
-
-  vtkSmartPointer<vtkMRMLLinearTransformNode> drrImageTransformNode = vtkMRMLLinearTransformNode::SafeDownCast(
-    this->GetMRMLScene()->GetNodeByID(drrImageNode->GetTransformNodeID()));
-  if (!drrImageTransformNode)
-  {
-    drrImageTransformNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::New();
-    drrImageTransformNode = vtkMRMLLinearTransformNode::SafeDownCast(this->GetMRMLScene()->AddNode(drrImageTransformNode));
-    std::string DRRImageTransformNodeName = std::string(beamName) + std::string("_DRRImage_Transform");
-    DRRImageTransformNodeName = this->GetMRMLScene()->GenerateUniqueName(DRRImageTransformNodeName);
-    drrImageTransformNode->SetName(DRRImageTransformNodeName.c_str());
-    drrImageNode->SetAndObserveTransformNodeID(drrImageTransformNode->GetID());
-  }
-  drrImageTransformNode->SetAndObserveMatrixTransformToParent(transformDRR->GetMatrix());
-
-  // 
-  vtkSmartPointer<vtkMRMLSliceNode> sliceNode = sliceLogic->GetSliceNode();
-  vtkSmartPointer<vtkMRMLSliceCompositeNode> compositeSliceNode = sliceLogic->GetSliceCompositeNode();
-  compositeSliceNode->SetBackgroundVolumeID(drrImageNode->GetID());
-
-  // Compute DVH and get result nodes
-  vtkSmartPointer<vtkImageData> mergedImageData = vtkSmartPointer<vtkImageData>::New();
-  unsigned int numberOfContours = 0;
-
-  vtkSmartPointer<vtkSegmentation> selectedSegmentation = planNode->GetTargetSegmentationNode()->GetSegmentation();
-  std::vector< std::string > segmentIDs;
-  selectedSegmentation->GetSegmentIDs(segmentIDs);
-  for (std::vector< std::string >::const_iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
-  {
-    vtkSegment* segment = selectedSegmentation->GetSegment(*segmentIdIt);
-
-    numberOfContours++;
-    // Create the translucent contour object in BEV 
-    // Create the renderer, render window 
-    vtkSmartPointer<vtkRenderer> renderer2 = vtkSmartPointer<vtkRenderer>::New();
-    vtkSmartPointer<vtkRenderWindow> renWin2 = vtkSmartPointer<vtkRenderWindow>::New();
-    renWin2->SetOffScreenRendering(1);
-    renWin2->AddRenderer(renderer2);
-
-    // Now we'll look at it. //TODO: This comment is meaningless
-    vtkSmartPointer<vtkPolyDataMapper> contourPolyDataMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-    vtkSmartPointer<vtkPolyData> polydata = vtkPolyData::SafeDownCast(segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName()));
-    contourPolyDataMapper->SetInputData(polydata);
-    //contourPolyDataMapper->SetScalarRange(0,255);
-    vtkSmartPointer<vtkActor> contourPolyDataActor = vtkSmartPointer<vtkActor>::New();
-    contourPolyDataActor->SetMapper(contourPolyDataMapper);
-    contourPolyDataActor->GetProperty()->LightingOff();
-    contourPolyDataActor->GetProperty()->SetColor(1.0,1.0,1.0);
-
-    vtkSmartPointer<vtkTransform> transformContourBEV = vtkSmartPointer<vtkTransform>::New();
-    transformContourBEV->Identity();
-    transformContourBEV->RotateY(beamNode->GetGantryAngle());
-    transformContourBEV->RotateX(90);
-
-    vtkSmartPointer<vtkTransform> transformContourBEV2 = vtkSmartPointer<vtkTransform>::New();
-    transformContourBEV2->Identity();
-    transformContourBEV2->Translate(-isoCenterPosition[0], -isoCenterPosition[1], -isoCenterPosition[2]);
-
-    transformContourBEV->PreMultiply();
-    transformContourBEV->Concatenate(transformContourBEV2);
-    contourPolyDataActor->SetUserTransform( transformContourBEV );
-
-    // The usual rendering stuff.
-    vtkSmartPointer<vtkCamera> camera2 = vtkSmartPointer<vtkCamera>::New();
-    // fixed camera parameters for now
-    camera2->SetPosition(0, 0, 1000);
-    camera2->SetFocalPoint(0, 0, 0);
-    camera2->SetViewAngle(14.68);
-    camera2->SetClippingRange(100, 2000);
-    camera2->ParallelProjectionOff();
-
-    // Add the volume to the scene
-    renderer2->AddActor(contourPolyDataActor);
-    renderer2->SetActiveCamera(camera2);
-
-    renWin2->SetSize(this->DRRImageSize[0], this->DRRImageSize[1]);
-    renWin2->Render();
-
-    // Capture and convert to 2D image
-    vtkSmartPointer<vtkWindowToImageFilter> windowToImage2 = vtkSmartPointer<vtkWindowToImageFilter>::New();
-    windowToImage2->SetInput( renWin2 );
-
-    vtkSmartPointer<vtkImageExtractComponents> extract2 = vtkSmartPointer<vtkImageExtractComponents>::New();
-    extract2->SetInputConnection( windowToImage2->GetOutputPort() );
-    extract2->SetComponents(0);
-    extract2->Update();
-
-    // Investigate when contour technique to use (gradient )
-    vtkSmartPointer<vtkImageGradientMagnitude> magnitude = vtkSmartPointer<vtkImageGradientMagnitude>::New();
-    magnitude->SetInputConnection( extract2->GetOutputPort() );
-    magnitude->SetDimensionality(2);
-    magnitude->Update();
-
-    if (numberOfContours > 1)
-    {
-      vtkSmartPointer<vtkImageMathematics> addFilter = vtkSmartPointer<vtkImageMathematics>::New(); 
-      addFilter->SetInput1Data(mergedImageData);
-      addFilter->SetInput2Data(magnitude->GetOutput());
-      addFilter->SetOperationToAdd();
-      addFilter->Update();
-      mergedImageData->DeepCopy(addFilter->GetOutput());
-    }
-    else
-    {
-      mergedImageData->DeepCopy(magnitude->GetOutput());
-    }
-  }
-
-  // Add the contour BEV image to mrml scene
-  vtkSmartPointer<vtkMRMLScalarVolumeNode> contourBEVImageNode = beamNode->GetContourBEVVolumeNode();
-  if (!contourBEVImageNode)
-  {
-    contourBEVImageNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
-    contourBEVImageNode = vtkMRMLScalarVolumeNode::SafeDownCast(this->GetMRMLScene()->AddNode(contourBEVImageNode));
-    std::string contourBEVImageNodeName = std::string(beamName) + std::string("_ContourBEVImage");
-    contourBEVImageNodeName = this->GetMRMLScene()->GenerateUniqueName(contourBEVImageNodeName);
-    contourBEVImageNode->SetName(contourBEVImageNodeName.c_str());
-  }
-  beamNode->SetAndObserveContourBEVVolumeNode(contourBEVImageNode);
-
-  vtkSmartPointer<vtkMRMLScalarVolumeDisplayNode> volumeDisplayNode = vtkMRMLScalarVolumeDisplayNode::SafeDownCast(contourBEVImageNode->GetDisplayNode());
-  if (!volumeDisplayNode)
-  {
-    // Set default colormap to the loaded one if found or generated, or to rainbow otherwise
-    volumeDisplayNode = vtkSmartPointer<vtkMRMLScalarVolumeDisplayNode>::New();
-    this->GetMRMLScene()->AddNode(volumeDisplayNode);
-  }
-  volumeDisplayNode->SetAndObserveColorNodeID("vtkMRMLColorTableNodeGreen");
-  volumeDisplayNode->SetScalarRange(0,255);
-  volumeDisplayNode->AutoWindowLevelOff();
-  volumeDisplayNode->SetWindow(64);
-  volumeDisplayNode->SetLevel(128);
-
-  contourBEVImageNode->SetAndObserveDisplayNodeID(volumeDisplayNode->GetID());
-  contourBEVImageNode->SetAndObserveImageData(mergedImageData);
-  contourBEVImageNode->SetOrigin(-128,-128,0);
-  contourBEVImageNode->SetSelectable(1);
-
-  contourBEVImageNode->SetAndObserveTransformNodeID(drrImageTransformNode->GetID());
-
-  compositeSliceNode->SetForegroundVolumeID(contourBEVImageNode->GetID());
-  compositeSliceNode->SetForegroundOpacity(0.3);
-
-  // Transform ???
-  vtkSmartPointer<vtkTransform> transformSlice = vtkSmartPointer<vtkTransform>::New();
-  transformSlice->Identity();
-  transformSlice->RotateZ(beamNode->GetGantryAngle());
-  transformSlice->RotateX(-90);
-  transformSlice->Update();
-
-  sliceNode->SetSliceToRAS(transformSlice->GetMatrix());
-  sliceNode->UpdateMatrices();
-
-  sliceLogic->FitSliceToAll();
-
-#endif
-}
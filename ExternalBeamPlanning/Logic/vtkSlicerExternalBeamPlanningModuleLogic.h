@@ -39,11 +39,15 @@
 
 #include "vtkSlicerExternalBeamPlanningModuleLogicExport.h"
 
+class vtkDrrImageFilter;
+class vtkMatrix4x4;
 class vtkMRMLRTPlanNode;
 class vtkMRMLRTBeamNode;
+class vtkMRMLScalarVolumeNode;
 class vtkSlicerCLIModuleLogic;
 class vtkSlicerBeamsModuleLogic;
 class vtkSlicerDoseAccumulationModuleLogic;
+class vtkWaterEquivalentDepthFilter;
 
 /// \ingroup SlicerRt_QtModules_ExternalBeamPlanning
 class VTK_SLICER_EXTERNALBEAMPLANNING_MODULE_LOGIC_EXPORT vtkSlicerExternalBeamPlanningModuleLogic :
@@ -66,15 +70,36 @@ public:
   /// \return The new beam node that has been copied and added to the plan
   vtkMRMLRTBeamNode* CloneBeamInPlan(vtkMRMLRTBeamNode* copiedBeamNode, vtkMRMLRTPlanNode* planNode=nullptr);
 
+  /// Compute digitally reconstructed radiograph (DRR) of the plan reference volume for a beam
+  /// and store it in the DRR volume of the beam, which is created if missing.
+  /// The DRR lies in the detector plane of the beam, see \sa vtkDrrImageFilter. Parameters
+  /// other than the image size can be set on the filter returned by \sa GetDRRImageFilter
+  /// \return Success flag
+  bool UpdateDRR(vtkMRMLRTPlanNode* planNode, char* beamName);
+
+  /// Get filter used to compute DRRs. The converted CT volume is cached in the filter, so
+  /// subsequent DRRs of the same reference volume are faster
+  vtkDrrImageFilter* GetDRRImageFilter();
+
+  /// Get/Set size of the DRR images in pixels. 512x512 by default
+  vtkGetVector2Macro(DRRImageSize, int);
+  vtkSetVector2Macro(DRRImageSize, int);
+
+  /// Compute water equivalent depth (WED) of each voxel of the plan reference volume for a beam.
+  /// The WED volume has the geometry of the reference volume, see \sa vtkWaterEquivalentDepthFilter.
+  /// Parameters such as the HU to stopping power lookup table can be set on the filter returned
+  /// by \sa GetWEDFilter
+  /// \param wedVolumeNode Output volume. If omitted then the WED volume of the beam is used (created if missing)
+  /// \return The WED volume node, nullptr on failure
+  vtkMRMLScalarVolumeNode* ComputeWED(vtkMRMLRTBeamNode* beamNode, vtkMRMLScalarVolumeNode* wedVolumeNode=nullptr);
+
+  /// Get filter used to compute WED volumes. The ray grids of recently evaluated beam geometries are
+  /// cached in the filter, so returning to a previous gantry or couch angle is faster. The cache
+  /// is enlarged by \sa ComputeWED to hold at least one ray grid per beam of the plan
+  vtkWaterEquivalentDepthFilter* GetWEDFilter();
+
 //TODO: Obsolete functions
 public:
-  /// TODO Fix
-  /// TODO Move to separate logic
-  void UpdateDRR(vtkMRMLRTPlanNode* planNode, char* beamName);
-
-  /// TODO
-  void ComputeWED();
-
   /// TODO
   void SetMatlabDoseCalculationModuleLogic(vtkSlicerCLIModuleLogic* logic);
   vtkSlicerCLIModuleLogic* GetMatlabDoseCalculationModuleLogic();
@@ -100,8 +125,16 @@ protected:
   /// Handles events registered in the observer manager
   void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData) override;
 
+  /// Get image of a volume node in world coordinates (i.e. with its linear parent transform applied to
+  /// the geometry). The voxels are not copied, so that filters caching the converted voxels can reuse them
+  /// \return Success flag. False if the volume is invalid or its transform is not linear
+  bool GetVolumeImageInWorld(vtkMRMLScalarVolumeNode* volumeNode, vtkOrientedImageData* image);
+
+  /// Get transform from the beam coordinate system of the IEC hierarchy to world
+  void GetBeamToWorldMatrix(vtkMRMLRTBeamNode* beamNode, vtkMatrix4x4* beamToWorldMatrix);
+
 protected:
-  /// TODO:
+  /// Size of the DRR images in pixels
   int DRRImageSize[2];
 
 private:
@@ -114,6 +147,12 @@ private:
 
   /// Beams module logic instance
   vtkSlicerBeamsModuleLogic* BeamsLogic;
+
+  /// Filter computing the DRRs
+  vtkDrrImageFilter* DRRImageFilter;
+
+  /// Filter computing the water equivalent depth volumes
+  vtkWaterEquivalentDepthFilter* WEDFilter;
 };
 
 #endif
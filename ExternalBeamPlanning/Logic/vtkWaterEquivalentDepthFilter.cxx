@@ -0,0 +1,609 @@
+/*==============================================================================
+
+  Copyright (c) Radiation Medicine Program, University Health Network,
+  Princess Margaret Hospital, Toronto, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkWaterEquivalentDepthFilter.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <utility>
+#include <vector>
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// Maximum number of entries of the HU to RSP table evaluated from the lookup function
+const int MAXIMUM_TABLE_SIZE = 65536;
+
+//----------------------------------------------------------------------------
+/// Minimum distance of the volume from the source along the beam axis in mm
+const double MINIMUM_SOURCE_DISTANCE = 1e-3;
+
+//----------------------------------------------------------------------------
+/// Computes the range of the first component of CT voxels in parallel. Unlike vtkDataArray::GetRange,
+/// it does not update the range cache of the array, so the CT can be shared by filters running in
+/// parallel threads. NaN values are ignored
+template <class T>
+class HuRangeFunctor
+{
+public:
+  HuRangeFunctor(vtkImageData* ctImage)
+    : HuPtr(static_cast<const T*>(ctImage->GetScalarPointer()))
+    , NumberOfComponents(ctImage->GetNumberOfScalarComponents())
+  {
+  }
+
+  void Initialize()
+  {
+    this->LocalRange.Local() = std::make_pair(VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX);
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    std::pair<double, double>& range = this->LocalRange.Local();
+    for (vtkIdType voxelIndex = begin; voxelIndex < end; ++voxelIndex)
+    {
+      double value = static_cast<double>(this->HuPtr[voxelIndex * this->NumberOfComponents]);
+      if (value < range.first)
+      {
+        range.first = value;
+      }
+      if (value > range.second)
+      {
+        range.second = value;
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    this->Range[0] = VTK_DOUBLE_MAX;
+    this->Range[1] = -VTK_DOUBLE_MAX;
+    for (typename vtkSMPThreadLocal<std::pair<double, double> >::iterator localIt = this->LocalRange.begin();
+      localIt != this->LocalRange.end(); ++localIt)
+    {
+      this->Range[0] = std::min(this->Range[0], localIt->first);
+      this->Range[1] = std::max(this->Range[1], localIt->second);
+    }
+    if (this->Range[0] > this->Range[1])
+    {
+      // No valid voxels
+      this->Range[0] = 0.0;
+      this->Range[1] = 0.0;
+    }
+  }
+
+  /// Range of the voxel values, available after executing the functor
+  double Range[2];
+
+private:
+  const T* HuPtr;
+  int NumberOfComponents;
+  vtkSMPThreadLocal<std::pair<double, double> > LocalRange;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void GetHuRange(vtkImageData* ctImage, T*, double huRange[2])
+{
+  HuRangeFunctor<T> functor(ctImage);
+  vtkSMPTools::For(0, ctImage->GetNumberOfPoints(), functor);
+  huRange[0] = functor.Range[0];
+  huRange[1] = functor.Range[1];
+}
+
+//----------------------------------------------------------------------------
+/// Convert CT voxels in HU to relative stopping power using a table evaluated at regular HU steps
+template <class T>
+void ConvertHuToRelativeStoppingPower(vtkImageData* ctImage, T*, float* rsp,
+  const std::vector<double>& table, double tableMinimumHu, double tableStepHu)
+{
+  const T* huPtr = static_cast<T*>(ctImage->GetScalarPointer());
+  int numberOfComponents = ctImage->GetNumberOfScalarComponents();
+  int lastIndex = static_cast<int>(table.size()) - 1;
+  vtkSMPTools::For(0, ctImage->GetNumberOfPoints(), [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType voxelIndex = begin; voxelIndex < end; ++voxelIndex)
+    {
+      double position = (static_cast<double>(huPtr[voxelIndex * numberOfComponents]) - tableMinimumHu) / tableStepHu;
+      position = std::min(std::max(position, 0.0), static_cast<double>(lastIndex));
+      int index = std::min(static_cast<int>(position), std::max(lastIndex - 1, 0));
+      double weight = (lastIndex > 0 ? position - index : 0.0);
+      rsp[voxelIndex] = static_cast<float>( (1.0 - weight) * table[index] + weight * table[std::min(index + 1, lastIndex)] );
+    }
+  });
+}
+
+//----------------------------------------------------------------------------
+/// Get interpolation position along an axis of a grid: lower node index and weight of the upper node.
+/// The position is clamped to the grid
+inline void GetInterpolationPosition(double position, int numberOfNodes, int& index, double& weight)
+{
+  if (numberOfNodes < 2)
+  {
+    index = 0;
+    weight = 0.0;
+    return;
+  }
+  position = std::min(std::max(position, 0.0), numberOfNodes - 1.0);
+  index = std::min(static_cast<int>(position), numberOfNodes - 2);
+  weight = position - index;
+}
+
+//----------------------------------------------------------------------------
+/// Trilinear interpolation on a grid of float values with X fastest
+inline double InterpolateTrilinear(const float* values, const int dimensions[3], const double position[3])
+{
+  int index[3] = { 0, 0, 0 };
+  double weight[3] = { 0.0, 0.0, 0.0 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    GetInterpolationPosition(position[axis], dimensions[axis], index[axis], weight[axis]);
+  }
+  vtkIdType increments[3] = { 1, dimensions[0], static_cast<vtkIdType>(dimensions[0]) * dimensions[1] };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (dimensions[axis] < 2)
+    {
+      increments[axis] = 0;
+    }
+  }
+  const float* ptr = values + index[0] * increments[0] + index[1] * increments[1] + index[2] * increments[2];
+  double value00 = ptr[0] + weight[0] * (ptr[increments[0]] - ptr[0]);
+  double value10 = ptr[increments[1]] + weight[0] * (ptr[increments[1] + increments[0]] - ptr[increments[1]]);
+  ptr += increments[2];
+  double value01 = ptr[0] + weight[0] * (ptr[increments[0]] - ptr[0]);
+  double value11 = ptr[increments[1]] + weight[0] * (ptr[increments[1] + increments[0]] - ptr[increments[1]]);
+  double value0 = value00 + weight[1] * (value10 - value00);
+  double value1 = value01 + weight[1] * (value11 - value01);
+  return value0 + weight[2] * (value1 - value0);
+}
+
+//----------------------------------------------------------------------------
+/// Sample relative stopping power in continuous voxel coordinates. The volume extends to half
+/// a voxel beyond the outer voxel centers, and the stopping power is zero outside of it
+inline double SampleRelativeStoppingPower(const float* rsp, const int dimensions[3], const double ijk[3])
+{
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (ijk[axis] < -0.5 || ijk[axis] > dimensions[axis] - 0.5)
+    {
+      return 0.0;
+    }
+  }
+  return InterpolateTrilinear(rsp, dimensions, ijk);
+}
+
+//----------------------------------------------------------------------------
+/// Transform point with the upper 3x4 part of a matrix
+inline void TransformPoint(const double matrix[4][4], const double point[3], double output[3])
+{
+  for (int row = 0; row < 3; ++row)
+  {
+    output[row] = matrix[row][0] * point[0] + matrix[row][1] * point[1] + matrix[row][2] * point[2] + matrix[row][3];
+  }
+}
+
+//----------------------------------------------------------------------------
+/// Cumulative water equivalent path length along rays cast from the source through a regular grid in
+/// the isocenter plane, sampled at regular distances from the source
+struct RayGrid
+{
+  /// Transform from CT voxel coordinates to beam coordinates and the grid parameters. Identifies the
+  /// geometry the grid was computed for
+  std::vector<double> GeometryKey;
+
+  /// Number of rays along the beam X and Y axes and number of samples along the rays
+  int Dimensions[3];
+  /// Position of the first ray in the isocenter plane and distance of the first sample from the source
+  double Origin[3];
+  /// Ray spacing in the isocenter plane and sampling step along the rays
+  double Spacing[3];
+  /// Water equivalent path length from the source to the samples, ray by ray
+  std::vector<float> Depths;
+};
+
+//----------------------------------------------------------------------------
+/// Cast rays through the volume and accumulate the water equivalent path length
+/// \param ijkToBeam Transform from continuous voxel coordinates (relative to the first voxel) to beam coordinates
+/// \return Success flag. False if the source is not outside the volume in front of it
+bool ComputeRayGrid(const float* rsp, const int dimensions[3], const double ijkToBeam[4][4], const double beamToIjk[4][4],
+  double sourceToIsocenterDistance, const double raySpacing[2], double raySamplingStep, RayGrid& rayGrid)
+{
+  // Extent of the volume in the isocenter plane and in distance from the source
+  double bounds[4] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  double minimumDistance = VTK_DOUBLE_MAX;
+  double maximumDistance = 0.0;
+  for (int corner = 0; corner < 8; ++corner)
+  {
+    double cornerIjk[3] = { (corner & 1 ? dimensions[0] - 0.5 : -0.5), (corner & 2 ? dimensions[1] - 0.5 : -0.5),
+      (corner & 4 ? dimensions[2] - 0.5 : -0.5) };
+    double cornerBeam[3] = { 0.0, 0.0, 0.0 };
+    TransformPoint(ijkToBeam, cornerIjk, cornerBeam);
+    double axialDistance = sourceToIsocenterDistance - cornerBeam[2];
+    if (axialDistance < MINIMUM_SOURCE_DISTANCE)
+    {
+      return false;
+    }
+    for (int axis = 0; axis < 2; ++axis)
+    {
+      double projection = cornerBeam[axis] * sourceToIsocenterDistance / axialDistance;
+      bounds[2*axis] = std::min(bounds[2*axis], projection);
+      bounds[2*axis+1] = std::max(bounds[2*axis+1], projection);
+    }
+    // Axial distance is a lower bound of the distance of the points of the (convex) volume
+    minimumDistance = std::min(minimumDistance, axialDistance);
+    maximumDistance = std::max(maximumDistance,
+      sqrt(cornerBeam[0] * cornerBeam[0] + cornerBeam[1] * cornerBeam[1] + axialDistance * axialDistance));
+  }
+
+  for (int axis = 0; axis < 2; ++axis)
+  {
+    rayGrid.Dimensions[axis] = static_cast<int>(ceil((bounds[2*axis+1] - bounds[2*axis]) / raySpacing[axis])) + 1;
+    rayGrid.Origin[axis] = bounds[2*axis];
+    rayGrid.Spacing[axis] = raySpacing[axis];
+  }
+  rayGrid.Dimensions[2] = static_cast<int>(ceil((maximumDistance - minimumDistance) / raySamplingStep)) + 1;
+  rayGrid.Origin[2] = minimumDistance;
+  rayGrid.Spacing[2] = raySamplingStep;
+  int numberOfSamples = rayGrid.Dimensions[2];
+  rayGrid.Depths.resize(static_cast<size_t>(rayGrid.Dimensions[0]) * rayGrid.Dimensions[1] * numberOfSamples);
+
+  double sourceBeam[3] = { 0.0, 0.0, sourceToIsocenterDistance };
+  double sourceIjk[3] = { 0.0, 0.0, 0.0 };
+  TransformPoint(beamToIjk, sourceBeam, sourceIjk);
+
+  // Rays are stored with the samples along the ray fastest, so that each ray is contiguous
+  vtkSMPTools::For(0, static_cast<vtkIdType>(rayGrid.Dimensions[0]) * rayGrid.Dimensions[1], [&](vtkIdType beginRay, vtkIdType endRay)
+  {
+    for (vtkIdType rayIndex = beginRay; rayIndex < endRay; ++rayIndex)
+    {
+      double u = rayGrid.Origin[0] + (rayIndex % rayGrid.Dimensions[0]) * rayGrid.Spacing[0];
+      double v = rayGrid.Origin[1] + (rayIndex / rayGrid.Dimensions[0]) * rayGrid.Spacing[1];
+      double rayLength = sqrt(u * u + v * v + sourceToIsocenterDistance * sourceToIsocenterDistance);
+      double directionBeam[3] = { u / rayLength, v / rayLength, -sourceToIsocenterDistance / rayLength };
+      double directionIjk[3] = { 0.0, 0.0, 0.0 };
+      for (int row = 0; row < 3; ++row)
+      {
+        directionIjk[row] = beamToIjk[row][0] * directionBeam[0] + beamToIjk[row][1] * directionBeam[1] + beamToIjk[row][2] * directionBeam[2];
+      }
+
+      // Distances of the entry and exit points of the ray, so that the steps crossing the boundary
+      // of the volume are integrated only along their part within the volume
+      double entryDistance = 0.0;
+      double exitDistance = VTK_DOUBLE_MAX;
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        if (fabs(directionIjk[axis]) < 1e-12)
+        {
+          if (sourceIjk[axis] < -0.5 || sourceIjk[axis] > dimensions[axis] - 0.5)
+          {
+            exitDistance = -VTK_DOUBLE_MAX;
+          }
+          continue;
+        }
+        double distance0 = (-0.5 - sourceIjk[axis]) / directionIjk[axis];
+        double distance1 = (dimensions[axis] - 0.5 - sourceIjk[axis]) / directionIjk[axis];
+        entryDistance = std::max(entryDistance, std::min(distance0, distance1));
+        exitDistance = std::min(exitDistance, std::max(distance0, distance1));
+      }
+
+      // Midpoint rule on the steps clipped to the volume
+      float* depthPtr = &rayGrid.Depths[rayIndex * numberOfSamples];
+      double depth = 0.0;
+      depthPtr[0] = 0.0f;
+      for (int sampleIndex = 1; sampleIndex < numberOfSamples; ++sampleIndex)
+      {
+        double stepStart = std::max(rayGrid.Origin[2] + (sampleIndex - 1) * raySamplingStep, entryDistance);
+        double stepEnd = std::min(rayGrid.Origin[2] + sampleIndex * raySamplingStep, exitDistance);
+        if (stepEnd > stepStart)
+        {
+          double distance = 0.5 * (stepStart + stepEnd);
+          double sampleIjk[3] = { sourceIjk[0] + distance * directionIjk[0], sourceIjk[1] + distance * directionIjk[1],
+            sourceIjk[2] + distance * directionIjk[2] };
+          depth += SampleRelativeStoppingPower(rsp, dimensions, sampleIjk) * (stepEnd - stepStart);
+        }
+        depthPtr[sampleIndex] = static_cast<float>(depth);
+      }
+    }
+  });
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Interpolate the water equivalent depth of each voxel center from the ray grid
+void InterpolateVoxelDepths(const RayGrid& rayGrid, const int dimensions[3], const double ijkToBeam[4][4],
+  double sourceToIsocenterDistance, float* output)
+{
+  // Depths are stored with the samples along the rays fastest
+  const int gridDimensions[3] = { rayGrid.Dimensions[2], rayGrid.Dimensions[0], rayGrid.Dimensions[1] };
+  vtkIdType numberOfRows = static_cast<vtkIdType>(dimensions[1]) * dimensions[2];
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType beginRow, vtkIdType endRow)
+  {
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+    {
+      double rowIjk[3] = { 0.0, static_cast<double>(row % dimensions[1]), static_cast<double>(row / dimensions[1]) };
+      double rowBeam[3] = { 0.0, 0.0, 0.0 };
+      TransformPoint(ijkToBeam, rowIjk, rowBeam);
+      float* outputPtr = output + row * dimensions[0];
+      for (int i = 0; i < dimensions[0]; ++i)
+      {
+        double voxelBeam[3] = { rowBeam[0] + i * ijkToBeam[0][0], rowBeam[1] + i * ijkToBeam[1][0], rowBeam[2] + i * ijkToBeam[2][0] };
+        double axialDistance = sourceToIsocenterDistance - voxelBeam[2];
+        double distance = sqrt(voxelBeam[0] * voxelBeam[0] + voxelBeam[1] * voxelBeam[1] + axialDistance * axialDistance);
+        double gridPosition[3] = { (distance - rayGrid.Origin[2]) / rayGrid.Spacing[2],
+          (voxelBeam[0] * sourceToIsocenterDistance / axialDistance - rayGrid.Origin[0]) / rayGrid.Spacing[0],
+          (voxelBeam[1] * sourceToIsocenterDistance / axialDistance - rayGrid.Origin[1]) / rayGrid.Spacing[1] };
+        outputPtr[i] = static_cast<float>(InterpolateTrilinear(rayGrid.Depths.data(), gridDimensions, gridPosition));
+      }
+    }
+  });
+}
+}
+
+//----------------------------------------------------------------------------
+class vtkWaterEquivalentDepthFilter::vtkInternal
+{
+public:
+  /// Ray grids, most recently used first
+  std::list<RayGrid> RayGridCache;
+};
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkWaterEquivalentDepthFilter);
+
+//----------------------------------------------------------------------------
+vtkWaterEquivalentDepthFilter::vtkWaterEquivalentDepthFilter()
+{
+  this->BeamToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  this->OutputImage = vtkSmartPointer<vtkOrientedImageData>::New();
+
+  this->HUToRelativeStoppingPowerFunction = vtkSmartPointer<vtkPiecewiseFunction>::New();
+  this->HUToRelativeStoppingPowerFunction->AddPoint(-1000.0, 0.001);
+  this->HUToRelativeStoppingPowerFunction->AddPoint(0.0, 1.0);
+  this->HUToRelativeStoppingPowerFunction->AddPoint(3000.0, 2.6);
+
+  this->RelativeStoppingPowerImageSourceScalars = nullptr;
+  this->RelativeStoppingPowerImageSourceMTime = 0;
+  this->RelativeStoppingPowerImageFunctionMTime = 0;
+
+  this->SourceToIsocenterDistance = 1000.0;
+  this->RaySpacing[0] = 2.0;
+  this->RaySpacing[1] = 2.0;
+  this->RaySamplingStep = 1.0;
+  this->MaximumNumberOfCachedRayGrids = 3;
+
+  this->Internal = new vtkInternal();
+}
+
+//----------------------------------------------------------------------------
+vtkWaterEquivalentDepthFilter::~vtkWaterEquivalentDepthFilter()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkWaterEquivalentDepthFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "SourceToIsocenterDistance: " << this->SourceToIsocenterDistance << "\n";
+  os << indent << "RaySpacing: " << this->RaySpacing[0] << ", " << this->RaySpacing[1] << "\n";
+  os << indent << "RaySamplingStep: " << this->RaySamplingStep << "\n";
+  os << indent << "MaximumNumberOfCachedRayGrids: " << this->MaximumNumberOfCachedRayGrids << "\n";
+  os << indent << "NumberOfCachedRayGrids: " << this->Internal->RayGridCache.size() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkWaterEquivalentDepthFilter::SetInputVolume(vtkOrientedImageData* volume)
+{
+  this->InputVolume = volume;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkWaterEquivalentDepthFilter::GetInputVolume()
+{
+  return this->InputVolume;
+}
+
+//----------------------------------------------------------------------------
+void vtkWaterEquivalentDepthFilter::SetBeamToWorldMatrix(vtkMatrix4x4* beamToWorldMatrix)
+{
+  if (!beamToWorldMatrix)
+  {
+    this->BeamToWorldMatrix->Identity();
+    return;
+  }
+  this->BeamToWorldMatrix->DeepCopy(beamToWorldMatrix);
+}
+
+//----------------------------------------------------------------------------
+vtkMatrix4x4* vtkWaterEquivalentDepthFilter::GetBeamToWorldMatrix()
+{
+  return this->BeamToWorldMatrix;
+}
+
+//----------------------------------------------------------------------------
+vtkPiecewiseFunction* vtkWaterEquivalentDepthFilter::GetHUToRelativeStoppingPowerFunction()
+{
+  return this->HUToRelativeStoppingPowerFunction;
+}
+
+//----------------------------------------------------------------------------
+int vtkWaterEquivalentDepthFilter::GetNumberOfCachedRayGrids()
+{
+  return static_cast<int>(this->Internal->RayGridCache.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkWaterEquivalentDepthFilter::ClearRayGridCache()
+{
+  this->Internal->RayGridCache.clear();
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkWaterEquivalentDepthFilter::GetOutputImage()
+{
+  return this->OutputImage;
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkWaterEquivalentDepthFilter::GetRelativeStoppingPowerImage()
+{
+  return this->RelativeStoppingPowerImage;
+}
+
+//----------------------------------------------------------------------------
+void vtkWaterEquivalentDepthFilter::UpdateRelativeStoppingPowerImage()
+{
+  vtkDataArray* ctScalars = this->InputVolume->GetPointData()->GetScalars();
+  if ( this->RelativeStoppingPowerImage && ctScalars == this->RelativeStoppingPowerImageSourceScalars
+    && ctScalars->GetMTime() == this->RelativeStoppingPowerImageSourceMTime
+    && this->HUToRelativeStoppingPowerFunction->GetMTime() == this->RelativeStoppingPowerImageFunctionMTime
+    && this->RelativeStoppingPowerImage->GetNumberOfPoints() == this->InputVolume->GetNumberOfPoints() )
+  {
+    return;
+  }
+
+  // Evaluate the lookup function at (at most) every HU in the range of the CT. The range is not
+  // taken from the scalar array, as its range cache is not thread safe and the CT may be shared
+  double huRange[2] = { 0.0, 0.0 };
+  switch (this->InputVolume->GetScalarType())
+  {
+    vtkTemplateMacro(GetHuRange(this->InputVolume.GetPointer(), static_cast<VTK_TT*>(nullptr), huRange));
+  }
+  int tableSize = std::min(static_cast<int>(ceil(huRange[1] - huRange[0])) + 1, MAXIMUM_TABLE_SIZE);
+  double tableStepHu = (tableSize > 1 ? (huRange[1] - huRange[0]) / (tableSize - 1) : 1.0);
+  std::vector<double> table(tableSize, 0.0);
+  if (tableSize > 1)
+  {
+    this->HUToRelativeStoppingPowerFunction->GetTable(huRange[0], huRange[1], tableSize, table.data());
+  }
+  else
+  {
+    table[0] = this->HUToRelativeStoppingPowerFunction->GetValue(huRange[0]);
+  }
+
+  this->RelativeStoppingPowerImage = vtkSmartPointer<vtkImageData>::New();
+  this->RelativeStoppingPowerImage->SetDimensions(this->InputVolume->GetDimensions());
+  this->RelativeStoppingPowerImage->AllocateScalars(VTK_FLOAT, 1);
+  float* rsp = static_cast<float*>(this->RelativeStoppingPowerImage->GetScalarPointer());
+  switch (this->InputVolume->GetScalarType())
+  {
+    vtkTemplateMacro(ConvertHuToRelativeStoppingPower(this->InputVolume.GetPointer(), static_cast<VTK_TT*>(nullptr),
+      rsp, table, huRange[0], tableStepHu));
+  }
+
+  this->RelativeStoppingPowerImageSourceScalars = ctScalars;
+  this->RelativeStoppingPowerImageSourceMTime = ctScalars->GetMTime();
+  this->RelativeStoppingPowerImageFunctionMTime = this->HUToRelativeStoppingPowerFunction->GetMTime();
+
+  // Depths along the rays are not valid any more
+  this->ClearRayGridCache();
+}
+
+//----------------------------------------------------------------------------
+bool vtkWaterEquivalentDepthFilter::Update()
+{
+  if (!this->InputVolume || !this->InputVolume->GetPointData()->GetScalars() || this->InputVolume->IsEmpty())
+  {
+    vtkErrorMacro("Update: Invalid input volume");
+    return false;
+  }
+  if (this->RaySpacing[0] <= 0.0 || this->RaySpacing[1] <= 0.0 || this->RaySamplingStep <= 0.0)
+  {
+    vtkErrorMacro("Update: Invalid ray spacing or sampling step");
+    return false;
+  }
+
+  this->UpdateRelativeStoppingPowerImage();
+
+  // Transform between voxel coordinates relative to the first voxel of the CT and beam coordinates
+  vtkNew<vtkMatrix4x4> ijkToWorldMatrix;
+  this->InputVolume->GetImageToWorldMatrix(ijkToWorldMatrix);
+  int* extent = this->InputVolume->GetExtent();
+  vtkNew<vtkMatrix4x4> extentOffsetMatrix;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    extentOffsetMatrix->SetElement(axis, 3, extent[2*axis]);
+  }
+  vtkNew<vtkMatrix4x4> worldToBeamMatrix;
+  vtkMatrix4x4::Invert(this->BeamToWorldMatrix, worldToBeamMatrix);
+  vtkNew<vtkMatrix4x4> ijkToBeamMatrix;
+  vtkMatrix4x4::Multiply4x4(worldToBeamMatrix, ijkToWorldMatrix, ijkToBeamMatrix);
+  vtkMatrix4x4::Multiply4x4(ijkToBeamMatrix, extentOffsetMatrix, ijkToBeamMatrix);
+  vtkNew<vtkMatrix4x4> beamToIjkMatrix;
+  vtkMatrix4x4::Invert(ijkToBeamMatrix, beamToIjkMatrix);
+
+  // Find ray grid of the geometry in the cache, or compute it
+  std::vector<double> geometryKey(&ijkToBeamMatrix->Element[0][0], &ijkToBeamMatrix->Element[0][0] + 16);
+  geometryKey.push_back(this->SourceToIsocenterDistance);
+  geometryKey.push_back(this->RaySpacing[0]);
+  geometryKey.push_back(this->RaySpacing[1]);
+  geometryKey.push_back(this->RaySamplingStep);
+  std::list<RayGrid>& rayGridCache = this->Internal->RayGridCache;
+  std::list<RayGrid>::iterator rayGridIt = rayGridCache.begin();
+  while (rayGridIt != rayGridCache.end() && rayGridIt->GeometryKey != geometryKey)
+  {
+    ++rayGridIt;
+  }
+  int* dimensions = this->InputVolume->GetDimensions();
+  if (rayGridIt != rayGridCache.end())
+  {
+    rayGridCache.splice(rayGridCache.begin(), rayGridCache, rayGridIt);
+  }
+  else
+  {
+    RayGrid rayGrid;
+    rayGrid.GeometryKey = geometryKey;
+    if (!ComputeRayGrid(static_cast<const float*>(this->RelativeStoppingPowerImage->GetScalarPointer()), dimensions,
+      ijkToBeamMatrix->Element, beamToIjkMatrix->Element, this->SourceToIsocenterDistance, this->RaySpacing,
+      this->RaySamplingStep, rayGrid))
+    {
+      vtkErrorMacro("Update: Beam source must be outside the volume and in front of it");
+      return false;
+    }
+    rayGridCache.push_front(std::move(rayGrid));
+    while (static_cast<int>(rayGridCache.size()) > std::max(this->MaximumNumberOfCachedRayGrids, 1))
+    {
+      rayGridCache.pop_back();
+    }
+  }
+
+  // Interpolate depth of the voxels
+  this->OutputImage->SetExtent(extent);
+  this->OutputImage->AllocateScalars(VTK_FLOAT, 1);
+  this->OutputImage->SetImageToWorldMatrix(ijkToWorldMatrix);
+  InterpolateVoxelDepths(rayGridCache.front(), dimensions, ijkToBeamMatrix->Element, this->SourceToIsocenterDistance,
+    static_cast<float*>(this->OutputImage->GetScalarPointer()));
+
+  this->OutputImage->Modified();
+  return true;
+}
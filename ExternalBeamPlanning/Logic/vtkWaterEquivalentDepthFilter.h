@@ -0,0 +1,151 @@
+/*==============================================================================
+
+  Copyright (c) Radiation Medicine Program, University Health Network,
+  Princess Margaret Hospital, Toronto, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkWaterEquivalentDepthFilter_h
+#define __vtkWaterEquivalentDepthFilter_h
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "vtkSlicerExternalBeamPlanningModuleLogicExport.h"
+
+class vtkDataArray;
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkOrientedImageData;
+class vtkPiecewiseFunction;
+
+/// \ingroup SlicerRt_QtModules_ExternalBeamPlanning
+/// \brief Compute water equivalent depth (radiological depth) of each voxel of a CT volume for a beam.
+///
+/// The CT is converted from HU to relative stopping power (RSP) using a configurable piecewise linear
+/// lookup table. Rays are then cast from the source through a regular grid in the isocenter plane of
+/// the beam's eye view, and the water equivalent path length is accumulated along them at regular
+/// steps. Each step is clipped to the bounds of the volume and integrated with the midpoint rule, so the
+/// depth starts from zero exactly at the entrance surface and the step crossing it is not lost. The depth
+/// of each voxel is interpolated from the ray grid at the position of the voxel center, so the output has
+/// the geometry of the CT. Rays and voxels are processed in parallel.
+///
+/// The beam geometry is given in the beam coordinate system of the IEC hierarchy (the parent transform
+/// of the beam node): isocenter is at the origin and the source is at (0, 0, SAD).
+///
+/// Ray grids are cached per beam geometry relative to the CT (i.e. gantry, collimator and couch angles
+/// and isocenter), so returning to a geometry that was evaluated recently, for example when comparing
+/// couch angles, only needs the voxel interpolation step. The RSP volume is also cached, and the ray
+/// grids are discarded when it changes.
+///
+/// Similarly to the segment morphology filters, this class is not a VTK pipeline filter.
+class VTK_SLICER_EXTERNALBEAMPLANNING_MODULE_LOGIC_EXPORT vtkWaterEquivalentDepthFilter : public vtkObject
+{
+public:
+  static vtkWaterEquivalentDepthFilter *New();
+  vtkTypeMacro(vtkWaterEquivalentDepthFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set CT volume in HU. The volume is referenced, not copied.
+  void SetInputVolume(vtkOrientedImageData* volume);
+  /// Get CT volume
+  vtkOrientedImageData* GetInputVolume();
+
+  /// Set transform from beam coordinate system to world. Identity by default
+  void SetBeamToWorldMatrix(vtkMatrix4x4* beamToWorldMatrix);
+  /// Get transform from beam coordinate system to world
+  vtkMatrix4x4* GetBeamToWorldMatrix();
+
+  /// Get/Set source to isocenter distance (SAD) in mm. 1000 by default
+  vtkGetMacro(SourceToIsocenterDistance, double);
+  vtkSetMacro(SourceToIsocenterDistance, double);
+
+  /// Get lookup table from HU to relative stopping power. It can be modified to use the calibration
+  /// of the scanner. The default is an approximate bilinear calibration through air, water and
+  /// cortical bone: (-1000, 0.001), (0, 1.0), (3000, 2.6)
+  vtkPiecewiseFunction* GetHUToRelativeStoppingPowerFunction();
+
+  /// Get/Set spacing of the rays in the isocenter plane in mm. 2x2 by default
+  vtkGetVector2Macro(RaySpacing, double);
+  vtkSetVector2Macro(RaySpacing, double);
+
+  /// Get/Set sampling step along the rays in mm. 1 by default
+  vtkGetMacro(RaySamplingStep, double);
+  vtkSetMacro(RaySamplingStep, double);
+
+  /// Get/Set maximum number of ray grids kept in the cache. A ray grid stores one float per ray and
+  /// sampling step (about 160MB for a 500mm CT with the default spacing). 3 by default.
+  /// Set it to at least the number of beams of a plan to keep all of its geometries cached
+  vtkGetMacro(MaximumNumberOfCachedRayGrids, int);
+  vtkSetMacro(MaximumNumberOfCachedRayGrids, int);
+
+  /// Get number of ray grids currently in the cache
+  int GetNumberOfCachedRayGrids();
+  /// Remove all ray grids from the cache
+  void ClearRayGridCache();
+
+  /// Compute the water equivalent depth
+  /// \return Success flag
+  bool Update();
+
+  /// Get water equivalent depth image in mm. It has the same geometry as the input volume
+  vtkOrientedImageData* GetOutputImage();
+
+  /// Get relative stopping power of the voxels of the input volume used by the last \sa Update.
+  /// It has the dimensions of the input volume, but no geometry. nullptr before the first update
+  vtkImageData* GetRelativeStoppingPowerImage();
+
+protected:
+  /// Convert the CT volume to relative stopping power, unless the cached conversion is up to date.
+  /// Clears the ray grid cache if the conversion is recomputed
+  void UpdateRelativeStoppingPowerImage();
+
+protected:
+  vtkWaterEquivalentDepthFilter();
+  ~vtkWaterEquivalentDepthFilter() override;
+
+protected:
+  /// CT volume in HU
+  vtkSmartPointer<vtkOrientedImageData> InputVolume;
+  /// Transform from beam coordinate system to world
+  vtkSmartPointer<vtkMatrix4x4> BeamToWorldMatrix;
+  /// Lookup table from HU to relative stopping power
+  vtkSmartPointer<vtkPiecewiseFunction> HUToRelativeStoppingPowerFunction;
+  /// Water equivalent depth image
+  vtkSmartPointer<vtkOrientedImageData> OutputImage;
+
+  /// Relative stopping power on the voxels of the CT volume
+  vtkSmartPointer<vtkImageData> RelativeStoppingPowerImage;
+  /// Scalars the RSP image was computed from, and the modified times of the scalars and the lookup
+  /// table at the time of the conversion. Used to avoid converting the CT for every evaluation
+  vtkDataArray* RelativeStoppingPowerImageSourceScalars;
+  vtkMTimeType RelativeStoppingPowerImageSourceMTime;
+  vtkMTimeType RelativeStoppingPowerImageFunctionMTime;
+
+  /// Source to isocenter distance in mm
+  double SourceToIsocenterDistance;
+  /// Spacing of the rays in the isocenter plane in mm
+  double RaySpacing[2];
+  /// Sampling step along the rays in mm
+  double RaySamplingStep;
+  /// Maximum number of cached ray grids
+  int MaximumNumberOfCachedRayGrids;
+
+private:
+  vtkWaterEquivalentDepthFilter(const vtkWaterEquivalentDepthFilter&) = delete;
+  void operator=(const vtkWaterEquivalentDepthFilter&) = delete;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,352 @@
+// ExternalBeamPlanning includes
+#include "vtkDrrImageFilter.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace
+{
+const double WATER_ATTENUATION_COEFFICIENT = 0.02;
+const double SAD = 1000.0;
+const double SID = 1500.0;
+const double CYLINDER_RADIUS = 60.0;
+
+//-----------------------------------------------------------------------------
+/// Create CT volume of short type with HU values defined in world coordinates
+vtkSmartPointer<vtkOrientedImageData> CreateVolume(const int dimensions[3], vtkMatrix4x4* ijkToWorldMatrix,
+  std::function<short(const double[3])> getHu)
+{
+  vtkSmartPointer<vtkOrientedImageData> volume = vtkSmartPointer<vtkOrientedImageData>::New();
+  volume->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  volume->SetGeometryFromImageToWorldMatrix(ijkToWorldMatrix);
+  volume->AllocateScalars(VTK_SHORT, 1);
+  short* huPtr = static_cast<short*>(volume->GetScalarPointer());
+  for (int k = 0; k < dimensions[2]; ++k)
+  {
+    for (int j = 0; j < dimensions[1]; ++j)
+    {
+      for (int i = 0; i < dimensions[0]; ++i)
+      {
+        double ijk[4] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k), 1.0 };
+        double world[4] = { 0.0, 0.0, 0.0, 1.0 };
+        ijkToWorldMatrix->MultiplyPoint(ijk, world);
+        *(huPtr++) = getHu(world);
+      }
+    }
+  }
+  return volume;
+}
+
+//-----------------------------------------------------------------------------
+/// Get world positions of the source and the center of a DRR pixel
+void GetRay(vtkDrrImageFilter* drrFilter, int i, int j, double sourceWorld[3], double pixelWorld[3])
+{
+  double sourceBeam[4] = { 0.0, 0.0, drrFilter->GetSourceToIsocenterDistance(), 1.0 };
+  double source[4] = { 0.0, 0.0, 0.0, 1.0 };
+  drrFilter->GetBeamToWorldMatrix()->MultiplyPoint(sourceBeam, source);
+  vtkNew<vtkMatrix4x4> pixelToWorldMatrix;
+  drrFilter->GetOutputImage()->GetImageToWorldMatrix(pixelToWorldMatrix);
+  double pixelIjk[4] = { static_cast<double>(i), static_cast<double>(j), 0.0, 1.0 };
+  double pixel[4] = { 0.0, 0.0, 0.0, 1.0 };
+  pixelToWorldMatrix->MultiplyPoint(pixelIjk, pixel);
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    sourceWorld[axis] = source[axis];
+    pixelWorld[axis] = pixel[axis];
+  }
+}
+
+//-----------------------------------------------------------------------------
+/// Check that the DRR is in the detector plane: the central pixel is on the beam axis at SID from the source
+bool CheckDetectorGeometry(vtkDrrImageFilter* drrFilter)
+{
+  int* detectorSize = drrFilter->GetDetectorSize();
+  double sourceWorld[3] = { 0.0, 0.0, 0.0 };
+  double pixelWorld[3] = { 0.0, 0.0, 0.0 };
+  GetRay(drrFilter, (detectorSize[0] - 1) / 2, (detectorSize[1] - 1) / 2, sourceWorld, pixelWorld);
+  double centerBeam[4] = { (detectorSize[0] % 2 ? 0.0 : -0.5 * drrFilter->GetDetectorSpacing()[0]),
+    (detectorSize[1] % 2 ? 0.0 : -0.5 * drrFilter->GetDetectorSpacing()[1]), SAD - SID, 1.0 };
+  double centerWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
+  drrFilter->GetBeamToWorldMatrix()->MultiplyPoint(centerBeam, centerWorld);
+  if (sqrt(vtkMath::Distance2BetweenPoints(pixelWorld, centerWorld)) > 1e-6)
+  {
+    std::cerr << "Central DRR pixel (" << pixelWorld[0] << ", " << pixelWorld[1] << ", " << pixelWorld[2]
+      << ") is not at the expected detector position (" << centerWorld[0] << ", " << centerWorld[1] << ", " << centerWorld[2] << ")" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Water box: every ray integral is the attenuation of water times the exact intersection length of the
+/// ray with the box, regardless of the voxelization
+bool TestWaterBox()
+{
+  // Oriented volume with anisotropic spacing and flipped axes
+  const int dimensions[3] = { 50, 40, 30 };
+  vtkNew<vtkMatrix4x4> ijkToWorldMatrix;
+  ijkToWorldMatrix->SetElement(0, 0, 0.0);
+  ijkToWorldMatrix->SetElement(1, 0, -1.2);
+  ijkToWorldMatrix->SetElement(0, 1, 2.0);
+  ijkToWorldMatrix->SetElement(1, 1, 0.0);
+  ijkToWorldMatrix->SetElement(2, 2, -3.0);
+  ijkToWorldMatrix->SetElement(0, 3, -40.0);
+  ijkToWorldMatrix->SetElement(1, 3, 25.0);
+  ijkToWorldMatrix->SetElement(2, 3, 40.0);
+  vtkSmartPointer<vtkOrientedImageData> volume = CreateVolume(dimensions, ijkToWorldMatrix, [](const double*) { return 0; });
+
+  // Oblique beam
+  vtkNew<vtkMatrix4x4> beamToWorldMatrix;
+  double angleRad = vtkMath::RadiansFromDegrees(30.0);
+  beamToWorldMatrix->SetElement(0, 0, cos(angleRad));
+  beamToWorldMatrix->SetElement(0, 2, sin(angleRad));
+  beamToWorldMatrix->SetElement(2, 0, -sin(angleRad));
+  beamToWorldMatrix->SetElement(2, 2, cos(angleRad));
+  beamToWorldMatrix->SetElement(0, 3, 5.0);
+
+  vtkNew<vtkDrrImageFilter> drrFilter;
+  drrFilter->SetInputVolume(volume);
+  drrFilter->SetBeamToWorldMatrix(beamToWorldMatrix);
+  drrFilter->SetSourceToIsocenterDistance(SAD);
+  drrFilter->SetSourceToDetectorDistance(SID);
+  drrFilter->SetDetectorSize(101, 80);
+  drrFilter->SetDetectorSpacing(2.0, 2.5);
+  drrFilter->SetWaterAttenuationCoefficient(WATER_ATTENUATION_COEFFICIENT);
+  if (!drrFilter->Update() || !CheckDetectorGeometry(drrFilter))
+  {
+    std::cerr << "Failed to compute DRR of water box" << std::endl;
+    return false;
+  }
+
+  // Intersection of the rays with the box in the voxel coordinate system
+  vtkNew<vtkMatrix4x4> worldToIjkMatrix;
+  vtkMatrix4x4::Invert(ijkToWorldMatrix, worldToIjkMatrix);
+  vtkOrientedImageData* drrImage = drrFilter->GetOutputImage();
+  int numberOfIntersectingRays = 0;
+  for (int j = 0; j < 80; ++j)
+  {
+    for (int i = 0; i < 101; ++i)
+    {
+      double sourceWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
+      double pixelWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
+      GetRay(drrFilter, i, j, sourceWorld, pixelWorld);
+      double sourceIjk[4] = { 0.0, 0.0, 0.0, 1.0 };
+      double pixelIjk[4] = { 0.0, 0.0, 0.0, 1.0 };
+      worldToIjkMatrix->MultiplyPoint(sourceWorld, sourceIjk);
+      worldToIjkMatrix->MultiplyPoint(pixelWorld, pixelIjk);
+      double alphaMin = 0.0;
+      double alphaMax = 1.0;
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        double direction = pixelIjk[axis] - sourceIjk[axis];
+        double alpha0 = (-0.5 - sourceIjk[axis]) / direction;
+        double alpha1 = (dimensions[axis] - 0.5 - sourceIjk[axis]) / direction;
+        alphaMin = std::max(alphaMin, std::min(alpha0, alpha1));
+        alphaMax = std::min(alphaMax, std::max(alpha0, alpha1));
+      }
+      double expectedValue = 0.0;
+      if (alphaMax > alphaMin)
+      {
+        expectedValue = WATER_ATTENUATION_COEFFICIENT * (alphaMax - alphaMin) * sqrt(vtkMath::Distance2BetweenPoints(sourceWorld, pixelWorld));
+        ++numberOfIntersectingRays;
+      }
+      double value = drrImage->GetScalarComponentAsDouble(i, j, 0, 0);
+      if (fabs(value - expectedValue) > 1e-5 * (1.0 + expectedValue))
+      {
+        std::cerr << "Water box DRR mismatch at (" << i << ", " << j << "): " << value << " != " << expectedValue << std::endl;
+        return false;
+      }
+    }
+  }
+  if (numberOfIntersectingRays == 0 || numberOfIntersectingRays == 101 * 80)
+  {
+    std::cerr << "Water box DRR does not contain both intersecting and missing rays" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Analytic line integral of a water cylinder along the world Z axis
+double GetCylinderLineIntegral(const double sourceWorld[3], const double pixelWorld[3])
+{
+  double direction[2] = { pixelWorld[0] - sourceWorld[0], pixelWorld[1] - sourceWorld[1] };
+  double a = direction[0] * direction[0] + direction[1] * direction[1];
+  double b = 2.0 * (sourceWorld[0] * direction[0] + sourceWorld[1] * direction[1]);
+  double c = sourceWorld[0] * sourceWorld[0] + sourceWorld[1] * sourceWorld[1] - CYLINDER_RADIUS * CYLINDER_RADIUS;
+  double discriminant = b * b - 4.0 * a * c;
+  if (discriminant <= 0.0)
+  {
+    return 0.0;
+  }
+  return WATER_ATTENUATION_COEFFICIENT * sqrt(discriminant) / a * sqrt(vtkMath::Distance2BetweenPoints(sourceWorld, pixelWorld));
+}
+
+//-----------------------------------------------------------------------------
+/// Water cylinder in air: compare to the analytic line integrals, and check subsampling and early termination
+bool TestCylinder()
+{
+  const int dimensions[3] = { 160, 160, 80 };
+  vtkNew<vtkMatrix4x4> ijkToWorldMatrix;
+  ijkToWorldMatrix->SetElement(2, 2, 2.5);
+  ijkToWorldMatrix->SetElement(0, 3, -79.5);
+  ijkToWorldMatrix->SetElement(1, 3, -79.5);
+  ijkToWorldMatrix->SetElement(2, 3, -98.75);
+  vtkSmartPointer<vtkOrientedImageData> volume = CreateVolume(dimensions, ijkToWorldMatrix, [](const double* world)
+    { return (world[0] * world[0] + world[1] * world[1] < CYLINDER_RADIUS * CYLINDER_RADIUS ? 0 : -1000); });
+
+  // Source posterior, beam Y axis along the cylinder axis
+  vtkNew<vtkMatrix4x4> beamToWorldMatrix;
+  beamToWorldMatrix->SetElement(1, 1, 0.0);
+  beamToWorldMatrix->SetElement(2, 1, 1.0);
+  beamToWorldMatrix->SetElement(1, 2, -1.0);
+  beamToWorldMatrix->SetElement(2, 2, 0.0);
+
+  vtkNew<vtkDrrImageFilter> drrFilter;
+  drrFilter->SetInputVolume(volume);
+  drrFilter->SetBeamToWorldMatrix(beamToWorldMatrix);
+  drrFilter->SetSourceToIsocenterDistance(SAD);
+  drrFilter->SetSourceToDetectorDistance(SID);
+  drrFilter->SetDetectorSize(256, 256);
+  drrFilter->SetDetectorSpacing(1.0, 1.0);
+  drrFilter->SetWaterAttenuationCoefficient(WATER_ATTENUATION_COEFFICIENT);
+  if (!drrFilter->Update() || !CheckDetectorGeometry(drrFilter))
+  {
+    std::cerr << "Failed to compute DRR of cylinder" << std::endl;
+    return false;
+  }
+  vtkSmartPointer<vtkOrientedImageData> fullDrrImage = vtkSmartPointer<vtkOrientedImageData>::New();
+  fullDrrImage->DeepCopy(drrFilter->GetOutputImage());
+
+  // Compare rows whose rays stay within the volume along the cylinder axis
+  double maximumExpectedValue = 0.0;
+  double sumError = 0.0;
+  int numberOfCheckedPixels = 0;
+  for (int j = 28; j < 228; ++j)
+  {
+    for (int i = 0; i < 256; ++i)
+    {
+      double sourceWorld[3] = { 0.0, 0.0, 0.0 };
+      double pixelWorld[3] = { 0.0, 0.0, 0.0 };
+      GetRay(drrFilter, i, j, sourceWorld, pixelWorld);
+      double expectedValue = GetCylinderLineIntegral(sourceWorld, pixelWorld);
+      double value = fullDrrImage->GetScalarComponentAsDouble(i, j, 0, 0);
+      maximumExpectedValue = std::max(maximumExpectedValue, expectedValue);
+      sumError += fabs(value - expectedValue);
+      ++numberOfCheckedPixels;
+
+      // Rays missing the cylinder by more than a voxel only cross air
+      double distanceFromAxisAtIsocenter = fabs(pixelWorld[0]) * SAD / SID;
+      if (distanceFromAxisAtIsocenter > CYLINDER_RADIUS + 2.0 && value != 0.0)
+      {
+        std::cerr << "Cylinder DRR is nonzero outside the cylinder at (" << i << ", " << j << "): " << value << std::endl;
+        return false;
+      }
+      // Rays through the center of the cylinder
+      if (i == 127 && fabs(value - expectedValue) > 0.005 * expectedValue)
+      {
+        std::cerr << "Cylinder DRR mismatch at the center (" << i << ", " << j << "): " << value << " != " << expectedValue << std::endl;
+        return false;
+      }
+    }
+  }
+  double meanError = sumError / numberOfCheckedPixels;
+  std::cout << "Cylinder DRR mean absolute error: " << meanError << " (maximum line integral " << maximumExpectedValue << ")" << std::endl;
+  if (meanError > 0.01 * maximumExpectedValue)
+  {
+    std::cerr << "Cylinder DRR mean error " << meanError << " is too large" << std::endl;
+    return false;
+  }
+
+  // Subsampling: ray cast pixels are identical, the others are close to the full resolution DRR
+  const int subsamplingFactor = 4;
+  drrFilter->SetRaySubsamplingFactor(subsamplingFactor);
+  drrFilter->Update();
+  vtkOrientedImageData* subsampledDrrImage = drrFilter->GetOutputImage();
+  sumError = 0.0;
+  for (int j = 0; j < 256; ++j)
+  {
+    for (int i = 0; i < 256; ++i)
+    {
+      double fullValue = fullDrrImage->GetScalarComponentAsDouble(i, j, 0, 0);
+      double subsampledValue = subsampledDrrImage->GetScalarComponentAsDouble(i, j, 0, 0);
+      if ( (i % subsamplingFactor == 0 || i == 255) && (j % subsamplingFactor == 0 || j == 255)
+        && subsampledValue != fullValue )
+      {
+        std::cerr << "Subsampled DRR differs at ray cast pixel (" << i << ", " << j << ")" << std::endl;
+        return false;
+      }
+      sumError += fabs(subsampledValue - fullValue);
+    }
+  }
+  meanError = sumError / (256 * 256);
+  std::cout << "Subsampled DRR mean absolute difference: " << meanError << std::endl;
+  if (meanError > 0.01 * maximumExpectedValue)
+  {
+    std::cerr << "Subsampled DRR mean difference " << meanError << " is too large" << std::endl;
+    return false;
+  }
+  drrFilter->SetRaySubsamplingFactor(1);
+
+  // Early termination: values are limited to the maximum plus the contribution of one voxel,
+  // and rays below the maximum are not affected
+  double maximumLineIntegral = 0.5 * maximumExpectedValue;
+  double maximumVoxelContribution = WATER_ATTENUATION_COEFFICIENT * sqrt(1.0 + 1.0 + 2.5 * 2.5);
+  drrFilter->SetMaximumLineIntegral(maximumLineIntegral);
+  drrFilter->Update();
+  vtkOrientedImageData* terminatedDrrImage = drrFilter->GetOutputImage();
+  for (int j = 0; j < 256; ++j)
+  {
+    for (int i = 0; i < 256; ++i)
+    {
+      double fullValue = fullDrrImage->GetScalarComponentAsDouble(i, j, 0, 0);
+      double terminatedValue = terminatedDrrImage->GetScalarComponentAsDouble(i, j, 0, 0);
+      if ( terminatedValue > maximumLineIntegral + maximumVoxelContribution
+        || (fullValue < maximumLineIntegral && terminatedValue != fullValue) )
+      {
+        std::cerr << "Invalid early terminated DRR value at (" << i << ", " << j << "): " << terminatedValue
+          << " (without termination " << fullValue << ")" << std::endl;
+        return false;
+      }
+    }
+  }
+  drrFilter->SetMaximumLineIntegral(0.0);
+
+  // Clinical detector size, reusing the attenuation volume
+  drrFilter->SetDetectorSize(512, 512);
+  drrFilter->SetDetectorSpacing(0.5, 0.5);
+  double startTime = vtkTimerLog::GetUniversalTime();
+  drrFilter->Update();
+  std::cout << "512x512 DRR computed in " << vtkTimerLog::GetUniversalTime() - startTime << " s" << std::endl;
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkDrrImageFilterTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  if (!TestWaterBox())
+  {
+    return EXIT_FAILURE;
+  }
+  if (!TestCylinder())
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,313 @@
+// ExternalBeamPlanning includes
+#include "vtkPhotonPencilBeamDoseFilter.h"
+#include "vtkWaterEquivalentDepthFilter.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+const double SAD = 1000.0;
+const double REFERENCE_DOSE = 2.0;
+const double FIELD_HALF_SIZE = 50.0;
+
+/// Water phantom of 300mm cube on a 2.5mm grid, with its top surface at Z=100mm (SSD 900mm for a beam from +Z)
+const int PHANTOM_DIMENSION = 120;
+const double PHANTOM_SPACING = 2.5;
+const double PHANTOM_ORIGIN[3] = { -148.75, -148.75, -198.75 };
+const double PHANTOM_SURFACE = 100.0;
+
+/// Bone slab of the heterogeneous phantom
+const double SLAB_Z_RANGE[2] = { 50.0, 70.0 };
+const short SLAB_HU = 1000;
+const double SLAB_RSP = 2.0;
+
+/// Surface of the water in the phantom with air above it
+const double AIR_PHANTOM_SURFACE = 40.0;
+const short AIR_HU = -1000;
+
+//-----------------------------------------------------------------------------
+/// Create water phantom, optionally with a bone slab
+vtkSmartPointer<vtkOrientedImageData> CreatePhantom(bool withSlab)
+{
+  vtkSmartPointer<vtkOrientedImageData> volume = vtkSmartPointer<vtkOrientedImageData>::New();
+  volume->SetDimensions(PHANTOM_DIMENSION, PHANTOM_DIMENSION, PHANTOM_DIMENSION);
+  volume->SetSpacing(PHANTOM_SPACING, PHANTOM_SPACING, PHANTOM_SPACING);
+  volume->SetOrigin(PHANTOM_ORIGIN[0], PHANTOM_ORIGIN[1], PHANTOM_ORIGIN[2]);
+  volume->AllocateScalars(VTK_SHORT, 1);
+  short* huPtr = static_cast<short*>(volume->GetScalarPointer());
+  const int sliceSize = PHANTOM_DIMENSION * PHANTOM_DIMENSION;
+  for (int k = 0; k < PHANTOM_DIMENSION; ++k)
+  {
+    double z = PHANTOM_ORIGIN[2] + k * PHANTOM_SPACING;
+    bool inSlab = (withSlab && z > SLAB_Z_RANGE[0] && z < SLAB_Z_RANGE[1]);
+    std::fill(huPtr + k * sliceSize, huPtr + (k + 1) * sliceSize, inSlab ? SLAB_HU : 0);
+  }
+  return volume;
+}
+
+//-----------------------------------------------------------------------------
+/// Set up dose filter for a beam with open jaws and a stopping power lookup table matching the phantom
+void SetUpDoseFilter(vtkPhotonPencilBeamDoseFilter* doseFilter, vtkOrientedImageData* ctImage)
+{
+  doseFilter->SetInputVolume(ctImage);
+  doseFilter->SetSourceToIsocenterDistance(SAD);
+  doseFilter->SetReferenceDose(REFERENCE_DOSE);
+  doseFilter->RemoveAllApertureRectangles();
+  doseFilter->AddApertureRectangle(-FIELD_HALF_SIZE, FIELD_HALF_SIZE, -FIELD_HALF_SIZE, FIELD_HALF_SIZE);
+  vtkPiecewiseFunction* huToDensityFunction = doseFilter->GetWaterEquivalentDepthFilter()->GetHUToRelativeStoppingPowerFunction();
+  huToDensityFunction->RemoveAllPoints();
+  huToDensityFunction->AddPoint(-1000.0, 0.0);
+  huToDensityFunction->AddPoint(0.0, 1.0);
+  huToDensityFunction->AddPoint(1000.0, SLAB_RSP);
+}
+
+//-----------------------------------------------------------------------------
+/// Reference dose of a point of the beam from +Z: the kernel evaluated analytically
+double GetReferenceDose(vtkPhotonPencilBeamDoseFilter* doseFilter, const double point[3], double radiologicalDepth)
+{
+  double magnification = SAD / (SAD - point[2]);
+  double u = point[0] * magnification;
+  double v = point[1] * magnification;
+  double lateral = 0.0;
+  double sigmas[2] = { doseFilter->GetPrimarySigma() + doseFilter->GetPrimarySigmaDepthCoefficient() * radiologicalDepth,
+    doseFilter->GetScatterSigma() + doseFilter->GetScatterSigmaDepthCoefficient() * radiologicalDepth };
+  double weights[2] = { 1.0 - doseFilter->GetScatterWeight(), doseFilter->GetScatterWeight() };
+  for (int component = 0; component < 2; ++component)
+  {
+    double scale = 1.0 / (sqrt(2.0) * sigmas[component]);
+    lateral += weights[component] * 0.25
+      * (erf((FIELD_HALF_SIZE - u) * scale) - erf((-FIELD_HALF_SIZE - u) * scale))
+      * (erf((FIELD_HALF_SIZE - v) * scale) - erf((-FIELD_HALF_SIZE - v) * scale));
+  }
+  return REFERENCE_DOSE * doseFilter->GetDepthDose(radiologicalDepth) * magnification * magnification * lateral;
+}
+
+//-----------------------------------------------------------------------------
+double GetDose(vtkPhotonPencilBeamDoseFilter* doseFilter, int i, int j, int k)
+{
+  return static_cast<float*>(doseFilter->GetOutputImage()->GetScalarPointer(i, j, k))[0];
+}
+
+//-----------------------------------------------------------------------------
+/// Central axis depth dose and lateral profile in water
+bool TestWaterPhantom()
+{
+  vtkSmartPointer<vtkOrientedImageData> ctImage = CreatePhantom(false);
+  vtkNew<vtkPhotonPencilBeamDoseFilter> doseFilter;
+  SetUpDoseFilter(doseFilter, ctImage);
+  if (!doseFilter->Update())
+  {
+    std::cerr << "Failed to compute dose in water phantom" << std::endl;
+    return false;
+  }
+
+  // Depth dose on the voxel column next to the beam axis, beyond the build-up region
+  const int axisIndex = PHANTOM_DIMENSION / 2 - 1;
+  for (int k = 0; k < PHANTOM_DIMENSION; ++k)
+  {
+    double point[3] = { PHANTOM_ORIGIN[0] + axisIndex * PHANTOM_SPACING, PHANTOM_ORIGIN[1] + axisIndex * PHANTOM_SPACING,
+      PHANTOM_ORIGIN[2] + k * PHANTOM_SPACING };
+    double depth = PHANTOM_SURFACE - point[2];
+    if (depth < 20.0)
+    {
+      continue;
+    }
+    double referenceDose = GetReferenceDose(doseFilter, point, depth);
+    double dose = GetDose(doseFilter, axisIndex, axisIndex, k);
+    if (fabs(dose - referenceDose) > 0.01 * referenceDose)
+    {
+      std::cerr << "Depth dose " << dose << " at depth " << depth << "mm differs from the reference " << referenceDose << std::endl;
+      return false;
+    }
+  }
+
+  // Lateral profile at isocenter depth: the 50% point is at the projected field edge
+  const int profileK = static_cast<int>((0.0 - PHANTOM_ORIGIN[2]) / PHANTOM_SPACING + 0.5);
+  double profileZ = PHANTOM_ORIGIN[2] + profileK * PHANTOM_SPACING;
+  double halfDose = 0.5 * GetDose(doseFilter, axisIndex, axisIndex, profileK);
+  double halfDosePosition = -1.0;
+  for (int i = axisIndex; i < PHANTOM_DIMENSION - 1; ++i)
+  {
+    double dose0 = GetDose(doseFilter, i, axisIndex, profileK);
+    double dose1 = GetDose(doseFilter, i + 1, axisIndex, profileK);
+    if (dose0 >= halfDose && dose1 < halfDose)
+    {
+      halfDosePosition = PHANTOM_ORIGIN[0] + (i + (dose0 - halfDose) / (dose0 - dose1)) * PHANTOM_SPACING;
+      break;
+    }
+  }
+  double expectedHalfDosePosition = FIELD_HALF_SIZE * (SAD - profileZ) / SAD;
+  if (fabs(halfDosePosition - expectedHalfDosePosition) > 1.0)
+  {
+    std::cerr << "Field edge at " << halfDosePosition << "mm instead of " << expectedHalfDosePosition << "mm" << std::endl;
+    return false;
+  }
+
+  // Blocking half of the field with the MLC removes the dose under the blocked leaves
+  doseFilter->RemoveAllApertureRectangles();
+  doseFilter->AddApertureRectangle(-FIELD_HALF_SIZE, FIELD_HALF_SIZE, -FIELD_HALF_SIZE, 0.0);
+  doseFilter->AddApertureRectangle(-FIELD_HALF_SIZE, 0.0, 0.0, FIELD_HALF_SIZE);
+  if (!doseFilter->Update())
+  {
+    std::cerr << "Failed to compute dose with MLC" << std::endl;
+    return false;
+  }
+  int openIndex[2] = { static_cast<int>((25.0 - PHANTOM_ORIGIN[0]) / PHANTOM_SPACING), static_cast<int>((-25.0 - PHANTOM_ORIGIN[1]) / PHANTOM_SPACING) };
+  int blockedIndex[2] = { openIndex[0], static_cast<int>((25.0 - PHANTOM_ORIGIN[1]) / PHANTOM_SPACING) };
+  double openDose = GetDose(doseFilter, openIndex[0], openIndex[1], profileK);
+  double blockedDose = GetDose(doseFilter, blockedIndex[0], blockedIndex[1], profileK);
+  if (blockedDose > 0.1 * openDose)
+  {
+    std::cerr << "Dose under blocked leaves " << blockedDose << " is not much lower than in the open field " << openDose << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Depth dose below a bone slab is shifted by the additional radiological depth of the slab
+bool TestHeterogeneousPhantom()
+{
+  vtkSmartPointer<vtkOrientedImageData> ctImage = CreatePhantom(true);
+  vtkNew<vtkPhotonPencilBeamDoseFilter> doseFilter;
+  SetUpDoseFilter(doseFilter, ctImage);
+  if (!doseFilter->Update())
+  {
+    std::cerr << "Failed to compute dose in heterogeneous phantom" << std::endl;
+    return false;
+  }
+
+  const int axisIndex = PHANTOM_DIMENSION / 2 - 1;
+  double slabDepthExcess = (SLAB_RSP - 1.0) * (SLAB_Z_RANGE[1] - SLAB_Z_RANGE[0]);
+  for (int k = 0; k < PHANTOM_DIMENSION; ++k)
+  {
+    double point[3] = { PHANTOM_ORIGIN[0] + axisIndex * PHANTOM_SPACING, PHANTOM_ORIGIN[1] + axisIndex * PHANTOM_SPACING,
+      PHANTOM_ORIGIN[2] + k * PHANTOM_SPACING };
+    if (point[2] > SLAB_Z_RANGE[0] - PHANTOM_SPACING)
+    {
+      continue;
+    }
+    double radiologicalDepth = PHANTOM_SURFACE - point[2] + slabDepthExcess;
+    double referenceDose = GetReferenceDose(doseFilter, point, radiologicalDepth);
+    double dose = GetDose(doseFilter, axisIndex, axisIndex, k);
+    if (fabs(dose - referenceDose) > 0.01 * referenceDose)
+    {
+      std::cerr << "Dose " << dose << " below bone slab at radiological depth " << radiologicalDepth
+        << "mm differs from the reference " << referenceDose << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Air in front of the patient gets no dose, and the depth dose starts at the water surface
+bool TestAirAbovePhantom()
+{
+  vtkSmartPointer<vtkOrientedImageData> ctImage = CreatePhantom(false);
+  short* huPtr = static_cast<short*>(ctImage->GetScalarPointer());
+  const int sliceSize = PHANTOM_DIMENSION * PHANTOM_DIMENSION;
+  for (int k = 0; k < PHANTOM_DIMENSION; ++k)
+  {
+    if (PHANTOM_ORIGIN[2] + k * PHANTOM_SPACING > AIR_PHANTOM_SURFACE)
+    {
+      std::fill(huPtr + k * sliceSize, huPtr + (k + 1) * sliceSize, AIR_HU);
+    }
+  }
+  vtkNew<vtkPhotonPencilBeamDoseFilter> doseFilter;
+  SetUpDoseFilter(doseFilter, ctImage);
+  if (!doseFilter->Update())
+  {
+    std::cerr << "Failed to compute dose in phantom with air" << std::endl;
+    return false;
+  }
+
+  const int axisIndex = PHANTOM_DIMENSION / 2 - 1;
+  for (int k = 0; k < PHANTOM_DIMENSION; ++k)
+  {
+    double point[3] = { PHANTOM_ORIGIN[0] + axisIndex * PHANTOM_SPACING, PHANTOM_ORIGIN[1] + axisIndex * PHANTOM_SPACING,
+      PHANTOM_ORIGIN[2] + k * PHANTOM_SPACING };
+    double dose = GetDose(doseFilter, axisIndex, axisIndex, k);
+    if (point[2] > AIR_PHANTOM_SURFACE)
+    {
+      if (dose != 0.0)
+      {
+        std::cerr << "Dose " << dose << " in air at Z=" << point[2] << "mm is not zero" << std::endl;
+        return false;
+      }
+      continue;
+    }
+    double depth = AIR_PHANTOM_SURFACE - point[2];
+    if (depth < 20.0)
+    {
+      continue;
+    }
+    double referenceDose = GetReferenceDose(doseFilter, point, depth);
+    if (fabs(dose - referenceDose) > 0.01 * referenceDose)
+    {
+      std::cerr << "Dose " << dose << " below air at depth " << depth << "mm differs from the reference " << referenceDose << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Time a five field plan on the 2.5mm grid
+void TimeFiveFieldPlan()
+{
+  vtkSmartPointer<vtkOrientedImageData> ctImage = CreatePhantom(true);
+  vtkNew<vtkPhotonPencilBeamDoseFilter> doseFilter;
+  SetUpDoseFilter(doseFilter, ctImage);
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int beamIndex = 0; beamIndex < 5; ++beamIndex)
+  {
+    double angleRad = vtkMath::RadiansFromDegrees(72.0 * beamIndex);
+    vtkNew<vtkMatrix4x4> beamToWorldMatrix;
+    beamToWorldMatrix->SetElement(0, 0, cos(angleRad));
+    beamToWorldMatrix->SetElement(0, 2, sin(angleRad));
+    beamToWorldMatrix->SetElement(2, 0, -sin(angleRad));
+    beamToWorldMatrix->SetElement(2, 2, cos(angleRad));
+    doseFilter->SetBeamToWorldMatrix(beamToWorldMatrix);
+    doseFilter->Update();
+  }
+  timer->StopTimer();
+  std::cout << "Five field plan on " << PHANTOM_DIMENSION << "^3 voxels computed in " << timer->GetElapsedTime() << "s" << std::endl;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkPhotonPencilBeamDoseFilterTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  if (!TestWaterPhantom())
+  {
+    return EXIT_FAILURE;
+  }
+  if (!TestHeterogeneousPhantom())
+  {
+    return EXIT_FAILURE;
+  }
+  if (!TestAirAbovePhantom())
+  {
+    return EXIT_FAILURE;
+  }
+  TimeFiveFieldPlan();
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,277 @@
+// ExternalBeamPlanning includes
+#include "vtkWaterEquivalentDepthFilter.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+const double SAD = 1000.0;
+
+/// Slabs of the phantom along the world Z axis: lower boundaries in mm, HU and expected relative stopping power
+const int NUMBER_OF_SLABS = 3;
+const double SLAB_LOWER_BOUNDARIES[NUMBER_OF_SLABS] = { -VTK_DOUBLE_MAX, -20.0, 10.0 };
+const short SLAB_HU[NUMBER_OF_SLABS] = { 0, 1000, -700 };
+const double SLAB_RSP[NUMBER_OF_SLABS] = { 1.0, 2.0, 0.3 };
+
+//-----------------------------------------------------------------------------
+/// Create slab phantom: water, bone and lung slabs stacked along the world Z axis
+vtkSmartPointer<vtkOrientedImageData> CreateSlabPhantom()
+{
+  vtkSmartPointer<vtkOrientedImageData> volume = vtkSmartPointer<vtkOrientedImageData>::New();
+  volume->SetDimensions(60, 50, 70);
+  volume->SetSpacing(2.0, 2.5, 1.5);
+  volume->SetOrigin(-59.0, -61.0, -52.0);
+  volume->AllocateScalars(VTK_SHORT, 1);
+  short* huPtr = static_cast<short*>(volume->GetScalarPointer());
+  int* dimensions = volume->GetDimensions();
+  for (int k = 0; k < dimensions[2]; ++k)
+  {
+    double z = volume->GetOrigin()[2] + k * volume->GetSpacing()[2];
+    int slab = NUMBER_OF_SLABS - 1;
+    while (z < SLAB_LOWER_BOUNDARIES[slab])
+    {
+      --slab;
+    }
+    std::fill(huPtr, huPtr + dimensions[0] * dimensions[1], SLAB_HU[slab]);
+    huPtr += dimensions[0] * dimensions[1];
+  }
+  return volume;
+}
+
+//-----------------------------------------------------------------------------
+/// Beam rotated about the world Y axis and shifted off the center of the phantom
+void GetBeamToWorldMatrix(double angleDeg, vtkMatrix4x4* beamToWorldMatrix)
+{
+  double angleRad = vtkMath::RadiansFromDegrees(angleDeg);
+  beamToWorldMatrix->Identity();
+  beamToWorldMatrix->SetElement(0, 0, cos(angleRad));
+  beamToWorldMatrix->SetElement(0, 2, sin(angleRad));
+  beamToWorldMatrix->SetElement(2, 0, -sin(angleRad));
+  beamToWorldMatrix->SetElement(2, 2, cos(angleRad));
+  beamToWorldMatrix->SetElement(0, 3, 5.0);
+  beamToWorldMatrix->SetElement(1, 3, -3.0);
+  beamToWorldMatrix->SetElement(2, 3, 2.0);
+}
+
+//-----------------------------------------------------------------------------
+/// Expected water equivalent depth: the stopping power of the slabs weighted by the exact length of the
+/// ray from the source to the point within the slabs and the bounds of the phantom
+double GetExpectedDepth(const double source[3], const double point[3], const double bounds[6])
+{
+  double direction[3] = { point[0] - source[0], point[1] - source[1], point[2] - source[2] };
+  double length = vtkMath::Norm(direction);
+
+  // Parametric range of the segment within the phantom
+  double range[2] = { 0.0, 1.0 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (direction[axis] == 0.0)
+    {
+      continue;
+    }
+    double t0 = (bounds[2*axis] - source[axis]) / direction[axis];
+    double t1 = (bounds[2*axis+1] - source[axis]) / direction[axis];
+    range[0] = std::max(range[0], std::min(t0, t1));
+    range[1] = std::min(range[1], std::max(t0, t1));
+  }
+
+  double depth = 0.0;
+  for (int slab = 0; slab < NUMBER_OF_SLABS; ++slab)
+  {
+    double upperBoundary = (slab < NUMBER_OF_SLABS - 1 ? SLAB_LOWER_BOUNDARIES[slab + 1] : VTK_DOUBLE_MAX);
+    double t0 = (std::max(SLAB_LOWER_BOUNDARIES[slab], -1e6) - source[2]) / direction[2];
+    double t1 = (std::min(upperBoundary, 1e6) - source[2]) / direction[2];
+    double overlap = std::min(range[1], std::max(t0, t1)) - std::max(range[0], std::min(t0, t1));
+    depth += SLAB_RSP[slab] * length * std::max(overlap, 0.0);
+  }
+  return depth;
+}
+
+//-----------------------------------------------------------------------------
+/// Compare water equivalent depth of the voxels with the exact depth. Voxels near the slab boundaries or
+/// the lateral faces of the phantom are excluded from the maximum error, as there the depth changes
+/// abruptly between neighboring rays
+bool CheckDepths(vtkWaterEquivalentDepthFilter* wedFilter)
+{
+  vtkOrientedImageData* wedImage = wedFilter->GetOutputImage();
+  vtkOrientedImageData* ctImage = wedFilter->GetInputVolume();
+  if (wedImage->GetScalarType() != VTK_FLOAT || !std::equal(ctImage->GetExtent(), ctImage->GetExtent() + 6, wedImage->GetExtent()))
+  {
+    std::cerr << "WED image does not have the geometry of the CT" << std::endl;
+    return false;
+  }
+
+  double sourceBeam[4] = { 0.0, 0.0, SAD, 1.0 };
+  double source[4] = { 0.0, 0.0, 0.0, 1.0 };
+  wedFilter->GetBeamToWorldMatrix()->MultiplyPoint(sourceBeam, source);
+  double bounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  int* dimensions = ctImage->GetDimensions();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    bounds[2*axis] = ctImage->GetOrigin()[axis] - 0.5 * ctImage->GetSpacing()[axis];
+    bounds[2*axis+1] = ctImage->GetOrigin()[axis] + (dimensions[axis] - 0.5) * ctImage->GetSpacing()[axis];
+  }
+
+  const double maximumErrorTolerance = 1.0;
+  const double meanErrorTolerance = 0.5;
+  double sumError = 0.0;
+  float* wedPtr = static_cast<float*>(wedImage->GetScalarPointer());
+  for (int k = 0; k < dimensions[2]; ++k)
+  {
+    for (int j = 0; j < dimensions[1]; ++j)
+    {
+      for (int i = 0; i < dimensions[0]; ++i)
+      {
+        double point[3] = { ctImage->GetOrigin()[0] + i * ctImage->GetSpacing()[0],
+          ctImage->GetOrigin()[1] + j * ctImage->GetSpacing()[1], ctImage->GetOrigin()[2] + k * ctImage->GetSpacing()[2] };
+        double error = fabs(*(wedPtr++) - GetExpectedDepth(source, point, bounds));
+        sumError += error;
+
+        bool nearSlabBoundary = (fabs(point[2] - SLAB_LOWER_BOUNDARIES[1]) < 4.0 || fabs(point[2] - SLAB_LOWER_BOUNDARIES[2]) < 4.0);
+        bool nearLateralFace = (fabs(point[0]) > 25.0 || fabs(point[1]) > 25.0);
+        if (!nearSlabBoundary && !nearLateralFace && error > maximumErrorTolerance)
+        {
+          std::cerr << "WED error " << error << "mm at voxel (" << i << ", " << j << ", " << k << ") exceeds tolerance "
+            << maximumErrorTolerance << "mm" << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  double meanError = sumError / wedImage->GetNumberOfPoints();
+  if (meanError > meanErrorTolerance)
+  {
+    std::cerr << "Mean WED error " << meanError << "mm exceeds tolerance " << meanErrorTolerance << "mm" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Compare water equivalent depth of the voxels of the top layer of the phantom, where the beam perpendicular
+/// to the slabs enters, with the exact depth. The tolerance is well below the loss of half a ray sampling step
+/// in the entrance slab, so integrating the step crossing the entrance surface only partially is detected
+bool CheckEntranceDepths(vtkWaterEquivalentDepthFilter* wedFilter)
+{
+  vtkOrientedImageData* wedImage = wedFilter->GetOutputImage();
+  vtkOrientedImageData* ctImage = wedFilter->GetInputVolume();
+
+  double sourceBeam[4] = { 0.0, 0.0, SAD, 1.0 };
+  double source[4] = { 0.0, 0.0, 0.0, 1.0 };
+  wedFilter->GetBeamToWorldMatrix()->MultiplyPoint(sourceBeam, source);
+  double bounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  int* dimensions = ctImage->GetDimensions();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    bounds[2*axis] = ctImage->GetOrigin()[axis] - 0.5 * ctImage->GetSpacing()[axis];
+    bounds[2*axis+1] = ctImage->GetOrigin()[axis] + (dimensions[axis] - 0.5) * ctImage->GetSpacing()[axis];
+  }
+
+  const double entranceErrorTolerance = 0.2 * wedFilter->GetRaySamplingStep() * SLAB_RSP[NUMBER_OF_SLABS - 1];
+  int k = dimensions[2] - 1;
+  float* wedPtr = static_cast<float*>(wedImage->GetScalarPointer(0, 0, k));
+  for (int j = 0; j < dimensions[1]; ++j)
+  {
+    for (int i = 0; i < dimensions[0]; ++i)
+    {
+      double point[3] = { ctImage->GetOrigin()[0] + i * ctImage->GetSpacing()[0],
+        ctImage->GetOrigin()[1] + j * ctImage->GetSpacing()[1], ctImage->GetOrigin()[2] + k * ctImage->GetSpacing()[2] };
+      double expectedDepth = GetExpectedDepth(source, point, bounds);
+      double error = fabs(wedPtr[i + j * dimensions[0]] - expectedDepth);
+      bool nearLateralFace = (fabs(point[0]) > 25.0 || fabs(point[1]) > 25.0);
+      if (!nearLateralFace && error > entranceErrorTolerance)
+      {
+        std::cerr << "Entrance WED " << wedPtr[i + j * dimensions[0]] << "mm at voxel (" << i << ", " << j << ", " << k
+          << ") differs from the exact " << expectedDepth << "mm by more than " << entranceErrorTolerance << "mm" << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkWaterEquivalentDepthFilterTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  vtkSmartPointer<vtkOrientedImageData> ctImage = CreateSlabPhantom();
+
+  vtkNew<vtkWaterEquivalentDepthFilter> wedFilter;
+  wedFilter->SetInputVolume(ctImage);
+  wedFilter->SetSourceToIsocenterDistance(SAD);
+  vtkPiecewiseFunction* huToRspFunction = wedFilter->GetHUToRelativeStoppingPowerFunction();
+  huToRspFunction->RemoveAllPoints();
+  huToRspFunction->AddPoint(-1000.0, 0.0);
+  huToRspFunction->AddPoint(0.0, 1.0);
+  huToRspFunction->AddPoint(1000.0, 2.0);
+
+  // Beam perpendicular to the slabs
+  vtkNew<vtkMatrix4x4> beamToWorldMatrix;
+  GetBeamToWorldMatrix(0.0, beamToWorldMatrix);
+  wedFilter->SetBeamToWorldMatrix(beamToWorldMatrix);
+  if (!wedFilter->Update() || !CheckDepths(wedFilter))
+  {
+    std::cerr << "Incorrect WED for beam perpendicular to the slabs" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!CheckEntranceDepths(wedFilter))
+  {
+    std::cerr << "Incorrect WED at the entrance surface" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::vector<float> perpendicularDepths(static_cast<float*>(wedFilter->GetOutputImage()->GetScalarPointer()),
+    static_cast<float*>(wedFilter->GetOutputImage()->GetScalarPointer()) + ctImage->GetNumberOfPoints());
+
+  // Oblique beam, e.g. after rotating the couch
+  GetBeamToWorldMatrix(20.0, beamToWorldMatrix);
+  wedFilter->SetBeamToWorldMatrix(beamToWorldMatrix);
+  if (!wedFilter->Update() || !CheckDepths(wedFilter))
+  {
+    std::cerr << "Incorrect WED for oblique beam" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (wedFilter->GetNumberOfCachedRayGrids() != 2)
+  {
+    std::cerr << "Expected 2 cached ray grids, found " << wedFilter->GetNumberOfCachedRayGrids() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Returning to the previous geometry uses the cached ray grid
+  GetBeamToWorldMatrix(0.0, beamToWorldMatrix);
+  wedFilter->SetBeamToWorldMatrix(beamToWorldMatrix);
+  if (!wedFilter->Update() || wedFilter->GetNumberOfCachedRayGrids() != 2)
+  {
+    std::cerr << "Ray grid of revisited beam geometry is not reused from the cache" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (memcmp(perpendicularDepths.data(), wedFilter->GetOutputImage()->GetScalarPointer(), perpendicularDepths.size() * sizeof(float)))
+  {
+    std::cerr << "WED computed from the cached ray grid differs from the original" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Changing the stopping power lookup table invalidates the cache
+  huToRspFunction->AddPoint(2000.0, 2.5);
+  if (!wedFilter->Update() || wedFilter->GetNumberOfCachedRayGrids() != 1)
+  {
+    std::cerr << "Ray grid cache is not cleared when the stopping power lookup table changes" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
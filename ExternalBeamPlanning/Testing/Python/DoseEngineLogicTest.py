@@ -0,0 +1,150 @@
+import unittest
+import vtk, slicer
+import logging
+import numpy
+
+class DoseEngineLogicTest(unittest.TestCase):
+  def setUp(self):
+    """ Do whatever is needed to reset the state - typically a scene clear will be enough.
+    """
+    slicer.mrmlScene.Clear(0)
+
+  #------------------------------------------------------------------------------
+  def runTest(self):
+    """Run as few or as many tests as needed here.
+    """
+    self.setUp()
+    self.test_DoseEngineLogic_ParallelBeams()
+
+  #------------------------------------------------------------------------------
+  def test_DoseEngineLogic_ParallelBeams(self):
+    # Check for modules
+    self.assertIsNotNone( slicer.modules.beams )
+    self.assertIsNotNone( slicer.modules.externalbeamplanning )
+
+    self.TestSection_00_SetupPlan()
+    self.TestSection_01_CompareParallelAndSequentialBeams()
+    self.TestSection_02_AccumulateDoseWithoutBeamVolumes()
+
+    logging.info('Test finished')
+
+  #------------------------------------------------------------------------------
+  def TestSection_00_SetupPlan(self):
+    self.mockDoseEngineName = 'Mock random'
+    self.numberOfBeams = 4
+
+    # Water cube reference volume of 50x50x50 voxels of 2mm centered at the origin
+    referenceImageData = vtk.vtkImageData()
+    referenceImageData.SetDimensions(50, 50, 50)
+    referenceImageData.AllocateScalars(vtk.VTK_SHORT, 1)
+    referenceImageData.GetPointData().GetScalars().Fill(0)
+    referenceVolumeNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLScalarVolumeNode', 'TestReference')
+    referenceVolumeNode.SetSpacing(2.0, 2.0, 2.0)
+    referenceVolumeNode.SetOrigin(-49.0, -49.0, -49.0)
+    referenceVolumeNode.SetAndObserveImageData(referenceImageData)
+
+    # Add reference volume under a patient and study
+    shNode = slicer.vtkMRMLSubjectHierarchyNode.GetSubjectHierarchyNode(slicer.mrmlScene)
+    patientItemID = shNode.CreateSubjectItem(shNode.GetSceneItemID(), "TestPatient")
+    studyItemID = shNode.CreateStudyItem(patientItemID, "TestStudy")
+    shNode.CreateItem(studyItemID, referenceVolumeNode)
+
+    self.engineLogic = slicer.qSlicerDoseEngineLogic()
+    self.engineLogic.setMRMLScene(slicer.mrmlScene)
+
+    self.totalDoseVolumeNode = slicer.mrmlScene.AddNewNodeByClass('vtkMRMLScalarVolumeNode', 'TotalDose')
+
+    self.planNode = slicer.vtkMRMLRTPlanNode()
+    self.planNode.SetName('TestMockPlan')
+    slicer.mrmlScene.AddNode(self.planNode)
+    self.planNode.SetAndObserveReferenceVolumeNode(referenceVolumeNode)
+    self.planNode.SetAndObserveOutputTotalDoseVolumeNode(self.totalDoseVolumeNode)
+    self.planNode.SetIsocenterSpecification(slicer.vtkMRMLRTPlanNode.ArbitraryPoint)
+    self.assertTrue( self.planNode.SetIsocenterPosition([0.0, 0.0, 0.0]) )
+    self.planNode.SetRxDose(2.0)
+    self.planNode.SetDoseEngineName(self.mockDoseEngineName)
+
+    engineHandler = slicer.qSlicerDoseEnginePluginHandler()
+    self.mockEngine = engineHandler.instance().doseEngineByName(self.mockDoseEngineName)
+    self.assertIsNotNone(self.mockEngine)
+
+    # Beams from different directions with different field sizes and weights
+    self.beamNodes = []
+    for beamIndex in range(self.numberOfBeams):
+      beamNode = self.engineLogic.createBeamInPlan(self.planNode)
+      halfFieldSize = 10.0 + 5.0 * beamIndex
+      beamNode.SetX1Jaw(-halfFieldSize)
+      beamNode.SetX2Jaw(halfFieldSize)
+      beamNode.SetY1Jaw(-halfFieldSize)
+      beamNode.SetY2Jaw(halfFieldSize)
+      beamNode.SetGantryAngle(beamIndex * 360.0 / self.numberOfBeams)
+      beamNode.SetBeamWeight(1.0 + 0.5 * beamIndex)
+      self.mockEngine.setParameter(beamNode, 'NoiseRange', 10.0)
+      self.beamNodes.append(beamNode)
+
+  #------------------------------------------------------------------------------
+  def getBeamDoseArrays(self):
+    beamDoseArrays = []
+    for beamNode in self.beamNodes:
+      beamDoseVolumeNode = self.mockEngine.getResultDoseForBeam(beamNode)
+      self.assertIsNotNone(beamDoseVolumeNode)
+      beamDoseArrays.append(slicer.util.arrayFromVolume(beamDoseVolumeNode).copy())
+    return beamDoseArrays
+
+  #------------------------------------------------------------------------------
+  def TestSection_01_CompareParallelAndSequentialBeams(self):
+    logging.info('Test section 1: Compare beams calculated in parallel and one after the other')
+
+    self.planNode.SetCreatePerBeamDoseVolumes(True)
+    self.engineLogic.setMaximumNumberOfParallelBeams(1)
+    errorMessage = self.engineLogic.calculateDose(self.planNode)
+    self.assertEqual(errorMessage, "")
+    self.sequentialBeamDoseArrays = self.getBeamDoseArrays()
+    sequentialTotalDoseArray = slicer.util.arrayFromVolume(self.totalDoseVolumeNode).copy()
+
+    self.engineLogic.setMaximumNumberOfParallelBeams(self.numberOfBeams)
+    errorMessage = self.engineLogic.calculateDose(self.planNode)
+    self.assertEqual(errorMessage, "")
+    parallelBeamDoseArrays = self.getBeamDoseArrays()
+    parallelTotalDoseArray = slicer.util.arrayFromVolume(self.totalDoseVolumeNode).copy()
+
+    # Noise of the mock engine is seeded by the beam, so the doses are identical
+    for beamIndex in range(self.numberOfBeams):
+      self.assertGreater(self.sequentialBeamDoseArrays[beamIndex].max(), 0.0)
+      self.assertTrue( (parallelBeamDoseArrays[beamIndex] == self.sequentialBeamDoseArrays[beamIndex]).all() )
+    self.assertGreater(sequentialTotalDoseArray.max(), 0.0)
+    self.assertTrue( (parallelTotalDoseArray == sequentialTotalDoseArray).all() )
+
+  #------------------------------------------------------------------------------
+  def TestSection_02_AccumulateDoseWithoutBeamVolumes(self):
+    logging.info('Test section 2: Accumulate beam doses directly into the total dose')
+
+    # Weighted sum of the beam doses calculated one after the other
+    expectedTotalDoseArray = numpy.zeros(self.sequentialBeamDoseArrays[0].shape)
+    for beamIndex in range(self.numberOfBeams):
+      expectedTotalDoseArray += self.beamNodes[beamIndex].GetBeamWeight() * self.sequentialBeamDoseArrays[beamIndex]
+
+    self.planNode.SetCreatePerBeamDoseVolumes(False)
+    self.engineLogic.setMaximumNumberOfParallelBeams(1)
+    errorMessage = self.engineLogic.calculateDose(self.planNode)
+    self.assertEqual(errorMessage, "")
+    for beamNode in self.beamNodes:
+      self.assertIsNone(self.mockEngine.getResultDoseForBeam(beamNode))
+    sequentialTotalDoseArray = slicer.util.arrayFromVolume(self.totalDoseVolumeNode).copy()
+    self.assertTrue( numpy.allclose(sequentialTotalDoseArray, expectedTotalDoseArray, rtol=1e-5, atol=1e-5) )
+
+    # Parallel accumulation sums the beams in a different order, but the same way every time
+    self.engineLogic.setMaximumNumberOfParallelBeams(self.numberOfBeams)
+    errorMessage = self.engineLogic.calculateDose(self.planNode)
+    self.assertEqual(errorMessage, "")
+    parallelTotalDoseArray = slicer.util.arrayFromVolume(self.totalDoseVolumeNode).copy()
+    self.assertTrue( numpy.allclose(parallelTotalDoseArray, expectedTotalDoseArray, rtol=1e-5, atol=1e-5) )
+    errorMessage = self.engineLogic.calculateDose(self.planNode)
+    self.assertEqual(errorMessage, "")
+    self.assertTrue( (slicer.util.arrayFromVolume(self.totalDoseVolumeNode) == parallelTotalDoseArray).all() )
+
+    # Beam doses created on demand are calculated again, and are the same as the contribution of the beams
+    for beamIndex in range(self.numberOfBeams):
+      beamDoseVolumeNode = self.engineLogic.getOrCreateResultDoseForBeam(self.beamNodes[beamIndex])
+      self.assertIsNotNone(beamDoseVolumeNode)
+      self.assertTrue( (slicer.util.arrayFromVolume(beamDoseVolumeNode) == self.sequentialBeamDoseArrays[beamIndex]).all() )
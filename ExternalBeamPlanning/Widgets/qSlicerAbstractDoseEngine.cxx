@@ -30,6 +30,9 @@ Ontario with funds provided by the Ontario Ministry of Health and Long-Term Care
 #include "vtkSlicerRtCommon.h"
 #include "vtkSlicerIsodoseModuleLogic.h"
 
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
 // MRML includes
 #include <vtkMRMLScene.h>
 #include <vtkMRMLScalarVolumeNode.h>
@@ -37,9 +40,15 @@ Ontario with funds provided by the Ontario Ministry of Health and Long-Term Care
 #include <vtkMRMLSubjectHierarchyNode.h>
 #include <vtkMRMLSubjectHierarchyConstants.h>
 #include <vtkMRMLColorTableNode.h>
+#include <vtkMRMLTransformNode.h>
 
 // VTK includes
 #include <vtkSmartPointer.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
 
 // SlicerQt includes
 #include "qSlicerApplication.h"
@@ -56,6 +65,9 @@ Ontario with funds provided by the Ontario Ministry of Health and Long-Term Care
 #include <QCheckBox>
 #include <QComboBox>
 
+// STD includes
+#include <memory>
+
 //----------------------------------------------------------------------------
 double qSlicerAbstractDoseEngine::DEFAULT_DOSE_VOLUME_WINDOW_LEVEL_MAXIMUM = 16.0;
 
@@ -118,8 +130,170 @@ void qSlicerAbstractDoseEngine::setName(QString name)
   qCritical() << Q_FUNC_INFO << ": Cannot set dose engine name by method, only in constructor";
 }
 
+//----------------------------------------------------------------------------
+bool qSlicerAbstractDoseEngine::isThreadSafe()const
+{
+  return false;
+}
+
+//----------------------------------------------------------------------------
+bool qSlicerAbstractDoseEngine::canAccumulateDose()const
+{
+  return false;
+}
+
+//----------------------------------------------------------------------------
+QString qSlicerAbstractDoseEngine::accumulateDoseUsingEngine(
+  vtkMRMLRTBeamNode* beamNode, vtkImageData* accumulatedDoseImageData, double beamWeight)
+{
+  Q_UNUSED(beamNode);
+  Q_UNUSED(accumulatedDoseImageData);
+  Q_UNUSED(beamWeight);
+  QString errorMessage = QString("Dose engine %1 does not support dose accumulation").arg(this->name());
+  qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+  return errorMessage;
+}
+
+//----------------------------------------------------------------------------
+qSlicerAbstractDoseEngine::BeamDoseInput* qSlicerAbstractDoseEngine::createBeamDoseInput(
+  vtkMRMLRTBeamNode* beamNode, QString& errorMessage)
+{
+  Q_UNUSED(beamNode);
+  errorMessage = QString("Dose engine %1 does not support concurrent beam calculation").arg(this->name());
+  qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------
+QString qSlicerAbstractDoseEngine::addBeamDoseFromInput(
+  const BeamDoseInput* input, vtkImageData* doseImageData, double beamWeight)const
+{
+  Q_UNUSED(input);
+  Q_UNUSED(doseImageData);
+  Q_UNUSED(beamWeight);
+  QString errorMessage = QString("Dose engine %1 does not support concurrent beam calculation").arg(this->name());
+  qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+  return errorMessage;
+}
+
+//----------------------------------------------------------------------------
+QString qSlicerAbstractDoseEngine::calculateDoseFromBeamDoseInput(vtkMRMLRTBeamNode* beamNode, vtkMRMLScalarVolumeNode* resultDoseVolumeNode)
+{
+  vtkMRMLRTPlanNode* parentPlanNode = (beamNode ? beamNode->GetParentPlanNode() : nullptr);
+  vtkMRMLScalarVolumeNode* referenceVolumeNode = (parentPlanNode ? parentPlanNode->GetReferenceVolumeNode() : nullptr);
+  if (!referenceVolumeNode || !resultDoseVolumeNode)
+  {
+    QString errorMessage("Invalid beam node, reference volume, or result dose volume node");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+
+  QString errorMessage;
+  std::unique_ptr<BeamDoseInput> input(this->createBeamDoseInput(beamNode, errorMessage));
+  if (!input)
+  {
+    return errorMessage;
+  }
+  vtkSmartPointer<vtkImageData> doseImageData = vtkSmartPointer<vtkImageData>::Take(
+    qSlicerAbstractDoseEngine::createDoseImageData(referenceVolumeNode) );
+  if (!doseImageData)
+  {
+    errorMessage = QString("Unable to access reference volume");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+  errorMessage = this->addBeamDoseFromInput(input.get(), doseImageData, 1.0);
+  if (!errorMessage.isEmpty())
+  {
+    return errorMessage;
+  }
+
+  resultDoseVolumeNode->SetAndObserveImageData(doseImageData);
+  resultDoseVolumeNode->CopyOrientation(referenceVolumeNode);
+  return QString();
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* qSlicerAbstractDoseEngine::createReferenceImageForBeamDoseInput(vtkMRMLRTBeamNode* beamNode, QString& errorMessage)
+{
+  vtkMRMLRTPlanNode* parentPlanNode = (beamNode ? beamNode->GetParentPlanNode() : nullptr);
+  vtkMRMLScalarVolumeNode* referenceVolumeNode = (parentPlanNode ? parentPlanNode->GetReferenceVolumeNode() : nullptr);
+  if (!referenceVolumeNode || !referenceVolumeNode->GetImageData())
+  {
+    errorMessage = QString("Unable to access reference volume");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return nullptr;
+  }
+
+  // Voxel to world transform of the reference volume, including its parent transform
+  vtkNew<vtkMatrix4x4> referenceImageToWorldMatrix;
+  referenceVolumeNode->GetIJKToRASMatrix(referenceImageToWorldMatrix);
+  vtkMRMLTransformNode* referenceTransformNode = referenceVolumeNode->GetParentTransformNode();
+  if (referenceTransformNode)
+  {
+    if (!referenceTransformNode->IsTransformToWorldLinear())
+    {
+      errorMessage = QString("Reference volume %1 has a non-linear transform").arg(referenceVolumeNode->GetName());
+      qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+      return nullptr;
+    }
+    vtkNew<vtkMatrix4x4> referenceToWorldMatrix;
+    referenceTransformNode->GetMatrixTransformToWorld(referenceToWorldMatrix);
+    vtkMatrix4x4::Multiply4x4(referenceToWorldMatrix, referenceImageToWorldMatrix, referenceImageToWorldMatrix);
+  }
+
+  vtkOrientedImageData* referenceImage = vtkOrientedImageData::New();
+  referenceImage->ShallowCopy(referenceVolumeNode->GetImageData());
+  referenceImage->SetImageToWorldMatrix(referenceImageToWorldMatrix);
+  return referenceImage;
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* qSlicerAbstractDoseEngine::createDoseImageData(vtkMRMLScalarVolumeNode* referenceVolumeNode)
+{
+  vtkImageData* referenceImageData = (referenceVolumeNode ? referenceVolumeNode->GetImageData() : nullptr);
+  if (!referenceImageData)
+  {
+    return nullptr;
+  }
+  vtkImageData* doseImageData = vtkImageData::New();
+  doseImageData->SetExtent(referenceImageData->GetExtent());
+  doseImageData->SetSpacing(referenceImageData->GetSpacing());
+  doseImageData->SetOrigin(referenceImageData->GetOrigin());
+  doseImageData->AllocateScalars(VTK_FLOAT, 1);
+  doseImageData->GetPointData()->GetScalars()->Fill(0.0);
+  return doseImageData;
+}
+
 //----------------------------------------------------------------------------
 QString qSlicerAbstractDoseEngine::calculateDose(vtkMRMLRTBeamNode* beamNode)
+{
+  QString errorMessage = this->prepareDoseCalculation(beamNode);
+  if (!errorMessage.isEmpty())
+  {
+    return errorMessage;
+  }
+
+  // Create output dose volume for beam
+  vtkSmartPointer<vtkMRMLScalarVolumeNode> resultDoseVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+  beamNode->GetScene()->AddNode(resultDoseVolumeNode);
+  // Give default name for result node (engine can give it a more meaningful name)
+  std::string resultDoseNodeName = std::string(beamNode->GetName()) + "_Dose";
+  resultDoseVolumeNode->SetName(resultDoseNodeName.c_str());
+
+  // Calculate dose
+  errorMessage = this->calculateDoseUsingEngine(beamNode, resultDoseVolumeNode);
+  if (errorMessage.isEmpty())
+  {
+    // Add result dose volume to beam
+    this->addResultDose(resultDoseVolumeNode, beamNode);
+  }
+
+  return errorMessage;
+}
+
+//----------------------------------------------------------------------------
+QString qSlicerAbstractDoseEngine::prepareDoseCalculation(vtkMRMLRTBeamNode* beamNode)
 {
   if (!beamNode)
   {
@@ -171,22 +345,7 @@ QString qSlicerAbstractDoseEngine::calculateDose(vtkMRMLRTBeamNode* beamNode)
   // Remove past intermediate results for beam before calculating dose again
   this->removeIntermediateResults(beamNode);
 
-  // Create output dose volume for beam
-  vtkSmartPointer<vtkMRMLScalarVolumeNode> resultDoseVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
-  beamNode->GetScene()->AddNode(resultDoseVolumeNode);
-  // Give default name for result node (engine can give it a more meaningful name)
-  std::string resultDoseNodeName = std::string(beamNode->GetName()) + "_Dose";
-  resultDoseVolumeNode->SetName(resultDoseNodeName.c_str());
-
-  // Calculate dose
-  QString errorMessage = this->calculateDoseUsingEngine(beamNode, resultDoseVolumeNode);
-  if (errorMessage.isEmpty())
-  {
-    // Add result dose volume to beam
-    this->addResultDose(resultDoseVolumeNode, beamNode);
-  }
-
-  return errorMessage;
+  return QString();
 }
 
 //---------------------------------------------------------------------------
@@ -249,13 +408,7 @@ void qSlicerAbstractDoseEngine::addResultDose(vtkMRMLScalarVolumeNode* resultDos
   // Remove already existing referenced dose volume if any
   if (replace)
   {
-    std::vector<const char*> referencedDoseNodeIds;
-    beamNode->GetNodeReferenceIDs(RESULT_DOSE_REFERENCE_ROLE, referencedDoseNodeIds);
-    for (std::vector<const char*>::iterator refIt=referencedDoseNodeIds.begin(); refIt != referencedDoseNodeIds.end(); ++refIt)
-    {
-      vtkMRMLNode* node = scene->GetNodeByID(*refIt);
-      scene->RemoveNode(node);
-    }
+    this->removeResultDose(beamNode);
   }
 
   // Add reference in beam to result dose for later access
@@ -339,6 +492,36 @@ vtkMRMLScalarVolumeNode* qSlicerAbstractDoseEngine::getResultDoseForBeam(vtkMRML
     beamNode->GetNthNodeReference(RESULT_DOSE_REFERENCE_ROLE, beamNode->GetNumberOfNodeReferences(RESULT_DOSE_REFERENCE_ROLE)-1) );
 }
 
+//---------------------------------------------------------------------------
+void qSlicerAbstractDoseEngine::removeResultDose(vtkMRMLRTBeamNode* beamNode)
+{
+  if (!beamNode || !beamNode->GetScene())
+  {
+    qCritical() << Q_FUNC_INFO << ": Invalid beam node";
+    return;
+  }
+  vtkMRMLScene* scene = beamNode->GetScene();
+
+  // Copy IDs, as removing the nodes also removes the references
+  std::vector<std::string> referencedDoseNodeIds;
+  for (int i=0; i<beamNode->GetNumberOfNodeReferences(RESULT_DOSE_REFERENCE_ROLE); ++i)
+  {
+    const char* referencedDoseNodeId = beamNode->GetNthNodeReferenceID(RESULT_DOSE_REFERENCE_ROLE, i);
+    if (referencedDoseNodeId)
+    {
+      referencedDoseNodeIds.push_back(referencedDoseNodeId);
+    }
+  }
+  for (std::vector<std::string>::iterator idIt=referencedDoseNodeIds.begin(); idIt != referencedDoseNodeIds.end(); ++idIt)
+  {
+    vtkMRMLNode* node = scene->GetNodeByID(*idIt);
+    if (node)
+    {
+      scene->RemoveNode(node);
+    }
+  }
+}
+
 //---------------------------------------------------------------------------
 void qSlicerAbstractDoseEngine::removeIntermediateResults(vtkMRMLRTBeamNode* beamNode)
 {
@@ -31,6 +31,8 @@ class qSlicerAbstractDoseEnginePrivate;
 class vtkMRMLScalarVolumeNode;
 class vtkMRMLRTBeamNode;
 class vtkMRMLNode;
+class vtkImageData;
+class vtkOrientedImageData;
 class qMRMLBeamParametersTabWidget;
 
 /// \ingroup SlicerRt_QtModules_ExternalBeamPlanning
@@ -75,6 +77,29 @@ public:
   /// Remove intermediate nodes created by the dose engine for a certain beam
   Q_INVOKABLE void removeIntermediateResults(vtkMRMLRTBeamNode* beamNode);
 
+  /// Remove per-beam result dose volumes referenced by the beam
+  Q_INVOKABLE void removeResultDose(vtkMRMLRTBeamNode* beamNode);
+
+  /// Input of the dose calculation of a beam, collected from the MRML nodes on the main thread by
+  /// \sa createBeamDoseInput. Thread-safe engines subclass it to store everything their calculation
+  /// needs, so that \sa addBeamDoseFromInput does not access any MRML node.
+  class BeamDoseInput
+  {
+  public:
+    virtual ~BeamDoseInput() = default;
+  };
+
+  /// Return true if the engine implements \sa createBeamDoseInput and \sa addBeamDoseFromInput,
+  /// in which case several beams are calculated at the same time from worker threads, each from
+  /// the input collected on the main thread. False by default, in which case beams are calculated
+  /// one after the other using \sa calculateDoseUsingEngine.
+  virtual bool isThreadSafe()const;
+
+  /// Return true if the engine implements \sa accumulateDoseUsingEngine, i.e. it can add the
+  /// dose of a beam directly into the plan total dose buffer without creating a per-beam volume.
+  /// False by default.
+  virtual bool canAccumulateDose()const;
+
 // API functions to implement in the subclass
 protected:
   /// Calculate dose for a single beam. Called by \sa CalculateDose that performs actions generic
@@ -88,6 +113,53 @@ protected:
     vtkMRMLRTBeamNode* beamNode,
     vtkMRMLScalarVolumeNode* resultDoseVolumeNode ) = 0;
 
+  /// Calculate dose for a single beam and add it weighted to the plan total dose buffer.
+  /// Optional, only called if \sa canAccumulateDose returns true.
+  ///
+  /// \param beamNode Beam for which the dose is calculated
+  /// \param accumulatedDoseImageData Float image with the same extent as the image data of the
+  ///   plan reference volume (geometry is given by the reference volume node). Contains the dose
+  ///   of the beams calculated so far
+  /// \param beamWeight Weight of the beam dose to add
+  /// \return Error message. Empty string on success
+  virtual QString accumulateDoseUsingEngine(
+    vtkMRMLRTBeamNode* beamNode,
+    vtkImageData* accumulatedDoseImageData,
+    double beamWeight );
+
+  /// Collect the input of the dose calculation of a beam from the beam, its plan, and the reference
+  /// volume. Called on the main thread. Needs to be implemented if \sa isThreadSafe returns true.
+  /// \param beamNode Beam for which the dose is calculated
+  /// \param errorMessage Error message on failure
+  /// \return New beam dose input owned by the caller, nullptr on failure
+  virtual BeamDoseInput* createBeamDoseInput(vtkMRMLRTBeamNode* beamNode, QString& errorMessage);
+
+  /// Add the weighted dose of a beam to a dose image. Called from worker threads, so it must only use
+  /// the given input and must not access MRML nodes or change the engine. Needs to be implemented
+  /// if \sa isThreadSafe returns true.
+  /// \param input Beam dose input created by \sa createBeamDoseInput
+  /// \param doseImageData Float image with the same extent as the image data of the plan reference volume
+  /// \param beamWeight Weight of the beam dose to add
+  /// \return Error message. Empty string on success
+  virtual QString addBeamDoseFromInput(const BeamDoseInput* input, vtkImageData* doseImageData, double beamWeight)const;
+
+  /// Calculate the dose of a beam into the result dose volume through \sa createBeamDoseInput and
+  /// \sa addBeamDoseFromInput on the calling thread. Thread-safe engines can implement
+  /// \sa calculateDoseUsingEngine and \sa accumulateDoseUsingEngine using this method, so that
+  /// sequential and parallel calculations give the same result.
+  QString calculateDoseFromBeamDoseInput(vtkMRMLRTBeamNode* beamNode, vtkMRMLScalarVolumeNode* resultDoseVolumeNode);
+
+  /// Create the image of the plan reference volume in world coordinates for a beam dose input.
+  /// The voxels are shared with the reference volume and not copied, so the image is only to be read.
+  /// \return New image owned by the caller, nullptr if the reference volume is missing or has a
+  ///   non-linear transform
+  static vtkOrientedImageData* createReferenceImageForBeamDoseInput(vtkMRMLRTBeamNode* beamNode, QString& errorMessage);
+
+  /// Create float dose image filled with zeros with the same extent, spacing, and origin as the
+  /// image data of the reference volume of a plan
+  /// \return New image owned by the caller, nullptr if the reference volume is missing
+  static vtkImageData* createDoseImageData(vtkMRMLScalarVolumeNode* referenceVolumeNode);
+
   /// Define engine-specific beam parameters.
   /// This is the method that needs to be implemented in each engine.
   virtual void defineBeamParameters() = 0;
@@ -214,6 +286,11 @@ public:
 
 // Private helper functions
 private:
+  /// Validate beam and plan, set up subject hierarchy, and remove intermediate results of
+  /// previous calculation. Must be called on the main thread before \sa calculateDoseUsingEngine
+  /// \return Error message. Empty string on success
+  QString prepareDoseCalculation(vtkMRMLRTBeamNode* beamNode);
+
   /// Add engine name prefix to the parameter name.
   /// This prefixed parameter name will be the attribute name for the beam parameter in the beam nodes.
   QString assembleEngineParameterName(QString parameterName);
@@ -30,6 +30,7 @@
 #include "vtkMRMLRTPlanNode.h"
 
 // SlicerRT includes
+#include "vtkSlicerRtCommon.h"
 #include "vtkMRMLDoseAccumulationNode.h"
 #include "vtkSlicerDoseAccumulationModuleLogic.h"
 #include "vtkSlicerIsodoseModuleLogic.h"
@@ -50,9 +51,41 @@
 
 // VTK includes
 #include <vtkSmartPointer.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
 
 // Qt includes
 #include <QDebug>
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+// STD includes
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+/// Task running a function in the dose calculation worker pool
+class DoseCalculationTask : public QRunnable
+{
+public:
+  DoseCalculationTask(std::function<void()> function)
+    : Function(function)
+  {
+  }
+  void run() override
+  {
+    this->Function();
+  }
+private:
+  std::function<void()> Function;
+};
+}
 
 //-----------------------------------------------------------------------------
 /// \ingroup Slicer_QtModules_SubjectHierarchy
@@ -65,6 +98,9 @@ public:
   qSlicerDoseEngineLogicPrivate(qSlicerDoseEngineLogic& object);
   ~qSlicerDoseEngineLogicPrivate();
   void loadApplicationSettings();
+public:
+  /// Maximum number of beams calculated at the same time. 0 means number of processor cores
+  int MaximumNumberOfParallelBeams;
 };
 
 //-----------------------------------------------------------------------------
@@ -73,6 +109,7 @@ public:
 //-----------------------------------------------------------------------------
 qSlicerDoseEngineLogicPrivate::qSlicerDoseEngineLogicPrivate(qSlicerDoseEngineLogic& object)
   : q_ptr(&object)
+  , MaximumNumberOfParallelBeams(0)
 {
 }
 
@@ -92,12 +129,27 @@ void qSlicerDoseEngineLogicPrivate::loadApplicationSettings()
 //----------------------------------------------------------------------------
 qSlicerDoseEngineLogic::qSlicerDoseEngineLogic(QObject* parent)
   : QObject(parent)
+  , d_ptr( new qSlicerDoseEngineLogicPrivate(*this) )
 {
 }
 
 //----------------------------------------------------------------------------
 qSlicerDoseEngineLogic::~qSlicerDoseEngineLogic() = default;
 
+//-----------------------------------------------------------------------------
+void qSlicerDoseEngineLogic::setMaximumNumberOfParallelBeams(int maximumNumberOfParallelBeams)
+{
+  Q_D(qSlicerDoseEngineLogic);
+  d->MaximumNumberOfParallelBeams = std::max(0, maximumNumberOfParallelBeams);
+}
+
+//-----------------------------------------------------------------------------
+int qSlicerDoseEngineLogic::maximumNumberOfParallelBeams()const
+{
+  Q_D(const qSlicerDoseEngineLogic);
+  return d->MaximumNumberOfParallelBeams;
+}
+
 //-----------------------------------------------------------------------------
 void qSlicerDoseEngineLogic::setMRMLScene(vtkMRMLScene* scene)
 {
@@ -187,6 +239,8 @@ void qSlicerDoseEngineLogic::applyDoseEngineInPlan(vtkObject* nodeObject)
 //---------------------------------------------------------------------------
 QString qSlicerDoseEngineLogic::calculateDose(vtkMRMLRTPlanNode* planNode)
 {
+  Q_D(qSlicerDoseEngineLogic);
+
   QString errorMessage("");
   if (!planNode || !planNode->GetScene())
   {
@@ -212,7 +266,40 @@ QString qSlicerDoseEngineLogic::calculateDose(vtkMRMLRTPlanNode* planNode)
   int currentBeamIndex = 0;
   double progress = 0.0;
 
-  for (std::vector<vtkMRMLRTBeamNode*>::iterator beamIt = beams.begin(); beamIt != beams.end(); ++beamIt, ++currentBeamIndex)
+  // Calculate beams concurrently if the engine allows it
+  int numberOfThreads = (d->MaximumNumberOfParallelBeams > 0 ? d->MaximumNumberOfParallelBeams : QThread::idealThreadCount());
+  numberOfThreads = std::max(1, std::min(numberOfThreads, numberOfBeams));
+
+  // Add beam doses directly to the total dose if per-beam volumes are not needed
+  if (!planNode->GetCreatePerBeamDoseVolumes() && selectedEngine->canAccumulateDose())
+  {
+    errorMessage = this->calculateAccumulatedDoseUsingEngine(planNode, selectedEngine, beams, numberOfThreads);
+    if (!errorMessage.isEmpty())
+    {
+      qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+      return errorMessage;
+    }
+    this->setupTotalDoseVolume(planNode);
+
+    progress = 1.0;
+    emit progressUpdated(progress);
+
+    return QString();
+  }
+
+  if (selectedEngine->isThreadSafe() && numberOfThreads > 1)
+  {
+    errorMessage = this->calculateDoseInParallel(selectedEngine, beams, numberOfThreads);
+    if (!errorMessage.isEmpty())
+    {
+      qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+      return errorMessage;
+    }
+    // All beams have been calculated, skip sequential loop
+    currentBeamIndex = numberOfBeams;
+  }
+
+  for (std::vector<vtkMRMLRTBeamNode*>::iterator beamIt = beams.begin() + currentBeamIndex; beamIt != beams.end(); ++beamIt, ++currentBeamIndex)
   {
     vtkMRMLRTBeamNode* beamNode = (*beamIt);
     if (beamNode)
@@ -253,6 +340,120 @@ QString qSlicerDoseEngineLogic::calculateDose(vtkMRMLRTPlanNode* planNode)
   return QString();
 }
 
+//---------------------------------------------------------------------------
+QString qSlicerDoseEngineLogic::calculateDoseInParallel(
+  qSlicerAbstractDoseEngine* engine, const std::vector<vtkMRMLRTBeamNode*>& beams, int numberOfThreads)
+{
+  if (!engine)
+  {
+    QString errorMessage("Invalid dose engine");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+  int numberOfBeams = beams.size();
+
+  // Prepare beams, collect the calculation inputs from the MRML nodes, and allocate the dose images
+  // on the main thread, so that the workers do not access any MRML node
+  std::vector<std::unique_ptr<qSlicerAbstractDoseEngine::BeamDoseInput> > inputs(numberOfBeams);
+  std::vector<vtkSmartPointer<vtkImageData> > doseImages(numberOfBeams);
+  for (int beamIndex=0; beamIndex<numberOfBeams; ++beamIndex)
+  {
+    vtkMRMLRTBeamNode* beamNode = beams[beamIndex];
+    vtkMRMLRTPlanNode* planNode = (beamNode ? beamNode->GetParentPlanNode() : nullptr);
+    if (!planNode)
+    {
+      QString errorMessage("Invalid beam!");
+      qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+      return errorMessage;
+    }
+    QString errorMessage = engine->prepareDoseCalculation(beamNode);
+    if (!errorMessage.isEmpty())
+    {
+      return errorMessage;
+    }
+    inputs[beamIndex].reset(engine->createBeamDoseInput(beamNode, errorMessage));
+    if (!inputs[beamIndex])
+    {
+      return errorMessage;
+    }
+    doseImages[beamIndex] = vtkSmartPointer<vtkImageData>::Take(
+      qSlicerAbstractDoseEngine::createDoseImageData(planNode->GetReferenceVolumeNode()) );
+    if (!doseImages[beamIndex])
+    {
+      errorMessage = QString("Unable to access reference volume");
+      qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+      return errorMessage;
+    }
+  }
+
+  // Run engine-specific calculations in a bounded worker pool
+  std::vector<QString> errorMessages(numberOfBeams);
+  QAtomicInt numberOfCompletedBeams(0);
+  QThreadPool threadPool;
+  threadPool.setMaxThreadCount(numberOfThreads);
+  for (int beamIndex=0; beamIndex<numberOfBeams; ++beamIndex)
+  {
+    const qSlicerAbstractDoseEngine::BeamDoseInput* input = inputs[beamIndex].get();
+    vtkImageData* doseImageData = doseImages[beamIndex];
+    QString* beamErrorMessage = &errorMessages[beamIndex];
+    threadPool.start(new DoseCalculationTask([engine, input, doseImageData, beamErrorMessage, &numberOfCompletedBeams]()
+    {
+      *beamErrorMessage = engine->addBeamDoseFromInput(input, doseImageData, 1.0);
+      numberOfCompletedBeams.fetchAndAddOrdered(1);
+    }));
+  }
+
+  this->waitForDoseCalculationTasks(threadPool, numberOfCompletedBeams, numberOfBeams);
+
+  // Add result doses of the successfully calculated beams to the scene on the main thread in beam order,
+  // and report each failed beam
+  QStringList failedBeamMessages;
+  for (int beamIndex=0; beamIndex<numberOfBeams; ++beamIndex)
+  {
+    vtkMRMLRTBeamNode* beamNode = beams[beamIndex];
+    if (!errorMessages[beamIndex].isEmpty())
+    {
+      failedBeamMessages << QString("%1: %2").arg(beamNode->GetName()).arg(errorMessages[beamIndex]);
+      continue;
+    }
+
+    vtkSmartPointer<vtkMRMLScalarVolumeNode> resultDoseVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+    std::string resultDoseNodeName = std::string(beamNode->GetName()) + "_Dose";
+    resultDoseVolumeNode->SetName(resultDoseNodeName.c_str());
+    resultDoseVolumeNode->SetAndObserveImageData(doseImages[beamIndex]);
+    resultDoseVolumeNode->CopyOrientation(beamNode->GetParentPlanNode()->GetReferenceVolumeNode());
+    beamNode->GetScene()->AddNode(resultDoseVolumeNode);
+    engine->addResultDose(resultDoseVolumeNode, beamNode);
+  }
+  if (!failedBeamMessages.isEmpty())
+  {
+    QString errorMessage = QString("Dose calculation failed for %1 of %2 beams. %3")
+      .arg(failedBeamMessages.size()).arg(numberOfBeams).arg(failedBeamMessages.join("; "));
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+
+  return QString();
+}
+
+//---------------------------------------------------------------------------
+void qSlicerDoseEngineLogic::waitForDoseCalculationTasks(QThreadPool& threadPool, const QAtomicInt& numberOfCompletedBeams, int numberOfBeams)
+{
+  // Report aggregated progress while the workers are running
+  int lastReportedNumberOfCompletedBeams = -1;
+  bool finished = false;
+  while (!finished)
+  {
+    finished = threadPool.waitForDone(100);
+    int currentNumberOfCompletedBeams = numberOfCompletedBeams.loadAcquire();
+    if (currentNumberOfCompletedBeams != lastReportedNumberOfCompletedBeams)
+    {
+      lastReportedNumberOfCompletedBeams = currentNumberOfCompletedBeams;
+      emit progressUpdated((double)currentNumberOfCompletedBeams / (numberOfBeams+1));
+    }
+  }
+}
+
 //---------------------------------------------------------------------------
 QString qSlicerDoseEngineLogic::createAccumulatedDose(vtkMRMLRTPlanNode* planNode)
 {
@@ -340,6 +541,23 @@ QString qSlicerDoseEngineLogic::createAccumulatedDose(vtkMRMLRTPlanNode* planNod
     return QString(errorMessage.c_str());
   }
 
+  this->setupTotalDoseVolume(planNode);
+
+  return QString();
+}
+
+//---------------------------------------------------------------------------
+void qSlicerDoseEngineLogic::setupTotalDoseVolume(vtkMRMLRTPlanNode* planNode)
+{
+  vtkMRMLScalarVolumeNode* referenceVolumeNode = (planNode ? planNode->GetReferenceVolumeNode() : nullptr);
+  vtkMRMLScalarVolumeNode* totalDoseVolumeNode = (planNode ? planNode->GetOutputTotalDoseVolumeNode() : nullptr);
+  vtkMRMLSubjectHierarchyNode* shNode = (planNode ? vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(planNode->GetScene()) : nullptr);
+  if (!referenceVolumeNode || !totalDoseVolumeNode || !shNode)
+  {
+    qCritical() << Q_FUNC_INFO << ": Invalid plan, reference volume, output dose volume, or subject hierarchy";
+    return;
+  }
+
   // Add total dose volume to subject hierarchy under the study of the reference volume
   vtkIdType referenceVolumeShItemID = shNode->GetItemByDataNode(referenceVolumeNode);
   if (referenceVolumeShItemID)
@@ -402,11 +620,194 @@ QString qSlicerDoseEngineLogic::createAccumulatedDose(vtkMRMLRTPlanNode* planNod
         compositeNode->SetForegroundOpacity(0.5);
       }
     }
-  } 
+  }
+}
+
+//---------------------------------------------------------------------------
+QString qSlicerDoseEngineLogic::calculateAccumulatedDoseUsingEngine(
+  vtkMRMLRTPlanNode* planNode, qSlicerAbstractDoseEngine* engine, const std::vector<vtkMRMLRTBeamNode*>& beams, int numberOfThreads)
+{
+  vtkMRMLScalarVolumeNode* referenceVolumeNode = planNode->GetReferenceVolumeNode();
+  if (!referenceVolumeNode || !referenceVolumeNode->GetImageData())
+  {
+    QString errorMessage("Unable to access reference volume");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+  vtkMRMLScalarVolumeNode* totalDoseVolumeNode = planNode->GetOutputTotalDoseVolumeNode();
+  if (!totalDoseVolumeNode)
+  {
+    QString errorMessage("Unable to access output dose volume");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+
+  // Plan-level accumulation buffer on the reference grid
+  vtkSmartPointer<vtkImageData> accumulatedDoseImageData = vtkSmartPointer<vtkImageData>::Take(
+    qSlicerAbstractDoseEngine::createDoseImageData(referenceVolumeNode) );
+
+  int numberOfBeams = beams.size();
+  for (int beamIndex=0; beamIndex<numberOfBeams; ++beamIndex)
+  {
+    vtkMRMLRTBeamNode* beamNode = beams[beamIndex];
+    if (!beamNode)
+    {
+      QString errorMessage("Invalid beam!");
+      qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+      return errorMessage;
+    }
+    QString errorMessage = engine->prepareDoseCalculation(beamNode);
+    if (!errorMessage.isEmpty())
+    {
+      return errorMessage;
+    }
+    // Per-beam doses of a previous calculation would not be consistent with the new total
+    engine->removeResultDose(beamNode);
+  }
+
+  if (engine->isThreadSafe() && numberOfThreads > 1)
+  {
+    QString errorMessage = this->accumulateDoseInParallel(engine, beams, accumulatedDoseImageData, numberOfThreads);
+    if (!errorMessage.isEmpty())
+    {
+      return errorMessage;
+    }
+  }
+  else
+  {
+    for (int beamIndex=0; beamIndex<numberOfBeams; ++beamIndex)
+    {
+      emit progressUpdated((double)beamIndex / (numberOfBeams+1));
+      vtkMRMLRTBeamNode* beamNode = beams[beamIndex];
+      QString errorMessage = engine->accumulateDoseUsingEngine(beamNode, accumulatedDoseImageData, beamNode->GetBeamWeight());
+      if (!errorMessage.isEmpty())
+      {
+        return errorMessage;
+      }
+    }
+  }
+  emit progressUpdated((double)numberOfBeams / (numberOfBeams+1));
+
+  totalDoseVolumeNode->CopyOrientation(referenceVolumeNode);
+  totalDoseVolumeNode->SetAndObserveImageData(accumulatedDoseImageData);
+  totalDoseVolumeNode->SetAttribute(vtkSlicerRtCommon::DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
+
+  return QString();
+}
+
+//---------------------------------------------------------------------------
+QString qSlicerDoseEngineLogic::accumulateDoseInParallel(qSlicerAbstractDoseEngine* engine,
+  const std::vector<vtkMRMLRTBeamNode*>& beams, vtkImageData* accumulatedDoseImageData, int numberOfThreads)
+{
+  int numberOfBeams = beams.size();
+  vtkMRMLScalarVolumeNode* referenceVolumeNode = beams[0]->GetParentPlanNode()->GetReferenceVolumeNode();
+
+  // Collect the calculation inputs and the beam weights from the MRML nodes on the main thread
+  std::vector<std::unique_ptr<qSlicerAbstractDoseEngine::BeamDoseInput> > inputs(numberOfBeams);
+  std::vector<double> beamWeights(numberOfBeams);
+  for (int beamIndex=0; beamIndex<numberOfBeams; ++beamIndex)
+  {
+    QString errorMessage;
+    inputs[beamIndex].reset(engine->createBeamDoseInput(beams[beamIndex], errorMessage));
+    if (!inputs[beamIndex])
+    {
+      return errorMessage;
+    }
+    beamWeights[beamIndex] = beams[beamIndex]->GetBeamWeight();
+  }
+
+  // Each worker adds a fixed subset of the beams (every numberOfThreads-th beam) into its own buffer,
+  // and the buffers are summed in order, so the total does not depend on which beam finishes first.
+  // Only one buffer per worker is allocated, not one per beam
+  std::vector<vtkSmartPointer<vtkImageData> > workerDoseImages(numberOfThreads);
+  std::vector<QString> errorMessages(numberOfBeams);
+  QAtomicInt numberOfCompletedBeams(0);
+  QThreadPool threadPool;
+  threadPool.setMaxThreadCount(numberOfThreads);
+  for (int workerIndex=0; workerIndex<numberOfThreads; ++workerIndex)
+  {
+    workerDoseImages[workerIndex] = vtkSmartPointer<vtkImageData>::Take(
+      qSlicerAbstractDoseEngine::createDoseImageData(referenceVolumeNode) );
+    vtkImageData* workerDoseImageData = workerDoseImages[workerIndex];
+    threadPool.start(new DoseCalculationTask(
+      [engine, &inputs, &beamWeights, &errorMessages, &numberOfCompletedBeams, workerDoseImageData, workerIndex, numberOfThreads, numberOfBeams]()
+    {
+      for (int beamIndex=workerIndex; beamIndex<numberOfBeams; beamIndex+=numberOfThreads)
+      {
+        errorMessages[beamIndex] = engine->addBeamDoseFromInput(inputs[beamIndex].get(), workerDoseImageData, beamWeights[beamIndex]);
+        numberOfCompletedBeams.fetchAndAddOrdered(1);
+      }
+    }));
+  }
+
+  this->waitForDoseCalculationTasks(threadPool, numberOfCompletedBeams, numberOfBeams);
+
+  // The total would be incomplete if any of the beams failed
+  QStringList failedBeamMessages;
+  for (int beamIndex=0; beamIndex<numberOfBeams; ++beamIndex)
+  {
+    if (!errorMessages[beamIndex].isEmpty())
+    {
+      failedBeamMessages << QString("%1: %2").arg(beams[beamIndex]->GetName()).arg(errorMessages[beamIndex]);
+    }
+  }
+  if (!failedBeamMessages.isEmpty())
+  {
+    QString errorMessage = QString("Dose calculation failed for %1 of %2 beams. %3")
+      .arg(failedBeamMessages.size()).arg(numberOfBeams).arg(failedBeamMessages.join("; "));
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+
+  float* accumulatedDosePtr = static_cast<float*>(accumulatedDoseImageData->GetScalarPointer());
+  vtkIdType numberOfPoints = accumulatedDoseImageData->GetNumberOfPoints();
+  for (int workerIndex=0; workerIndex<numberOfThreads; ++workerIndex)
+  {
+    const float* workerDosePtr = static_cast<float*>(workerDoseImages[workerIndex]->GetScalarPointer());
+    for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+      accumulatedDosePtr[i] += workerDosePtr[i];
+    }
+  }
 
   return QString();
 }
 
+//---------------------------------------------------------------------------
+vtkMRMLScalarVolumeNode* qSlicerDoseEngineLogic::getOrCreateResultDoseForBeam(vtkMRMLRTBeamNode* beamNode)
+{
+  vtkMRMLRTPlanNode* planNode = (beamNode ? beamNode->GetParentPlanNode() : nullptr);
+  if (!planNode)
+  {
+    qCritical() << Q_FUNC_INFO << ": Invalid beam node or parent plan";
+    return nullptr;
+  }
+  qSlicerAbstractDoseEngine* selectedEngine =
+    qSlicerDoseEnginePluginHandler::instance()->doseEngineByName(planNode->GetDoseEngineName());
+  if (!selectedEngine)
+  {
+    qCritical() << Q_FUNC_INFO << ": Unable to access dose engine with name " << (planNode->GetDoseEngineName() ? planNode->GetDoseEngineName() : "nullptr");
+    return nullptr;
+  }
+
+  vtkMRMLScalarVolumeNode* resultDoseVolumeNode = selectedEngine->getResultDoseForBeam(beamNode);
+  if (resultDoseVolumeNode)
+  {
+    return resultDoseVolumeNode;
+  }
+
+  // Materialize per-beam dose by calculating the beam again. Engines compute the same dose for a beam whether
+  // it is calculated alone or accumulated (the noise of the mock engine is seeded by the beam), so the result
+  // is the unweighted contribution of the beam to the total dose
+  QString errorMessage = selectedEngine->calculateDose(beamNode);
+  if (!errorMessage.isEmpty())
+  {
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return nullptr;
+  }
+  return selectedEngine->getResultDoseForBeam(beamNode);
+}
+
 //---------------------------------------------------------------------------
 void qSlicerDoseEngineLogic::removeIntermediateResults(vtkMRMLRTPlanNode* planNode)
 {
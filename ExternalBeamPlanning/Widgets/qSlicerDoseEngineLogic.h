@@ -31,12 +31,20 @@
 #include <ctkVTKObject.h>
 
 // Qt includes
+#include <QAtomicInt>
 #include <QObject>
 
+// STD includes
+#include <vector>
+
 class vtkMRMLScene;
 class vtkMRMLRTPlanNode;
 class vtkMRMLRTBeamNode;
+class vtkMRMLScalarVolumeNode;
 class qSlicerDoseEngineLogicPrivate;
+class qSlicerAbstractDoseEngine;
+class vtkImageData;
+class QThreadPool;
 
 /// \ingroup SlicerRt_QtModules_ExternalBeamPlanning
 /// \brief Abstract dose calculation algorithm that can be used in the
@@ -58,9 +66,29 @@ public:
   /// Set the current MRML scene to the widget
   Q_INVOKABLE virtual void setMRMLScene(vtkMRMLScene* scene);
 
-  /// Calculate dose for a plan
+  /// Calculate dose for a plan.
+  /// If the dose engine of the plan is thread-safe (\sa qSlicerAbstractDoseEngine::isThreadSafe)
+  /// then the beams are calculated concurrently, otherwise one after the other.
+  /// If per-beam dose volumes are turned off in the plan (\sa vtkMRMLRTPlanNode::CreatePerBeamDoseVolumes)
+  /// and the dose engine supports it (\sa qSlicerAbstractDoseEngine::canAccumulateDose), the beam doses are
+  /// added directly into the total dose of the plan, so that only one dose volume is kept in memory and no
+  /// separate accumulation step is needed. Per-beam doses can then be created on demand using
+  /// \sa getOrCreateResultDoseForBeam
   Q_INVOKABLE QString calculateDose(vtkMRMLRTPlanNode* planNode);
 
+  /// Set maximum number of beams that are calculated at the same time by thread-safe dose engines.
+  /// 0 (default) means the number of processor cores, 1 disables parallel calculation.
+  Q_INVOKABLE void setMaximumNumberOfParallelBeams(int maximumNumberOfParallelBeams);
+  /// Get maximum number of beams that are calculated at the same time
+  Q_INVOKABLE int maximumNumberOfParallelBeams()const;
+
+  /// Get per-beam dose volume for a beam. If it has not been created (e.g. because the plan dose
+  /// was accumulated directly), then the dose of the beam is calculated again. Dose engines give the
+  /// same dose for a beam whether it is calculated alone or accumulated, so the beam weight times the
+  /// created dose is the contribution of the beam to the accumulated total dose
+  /// \return Per-beam dose volume, nullptr on failure
+  Q_INVOKABLE vtkMRMLScalarVolumeNode* getOrCreateResultDoseForBeam(vtkMRMLRTBeamNode* beamNode);
+
   /// Accumulate per-beam dose volumes for each beam under given plan. The accumulated
   /// total dose is
   Q_INVOKABLE QString createAccumulatedDose(vtkMRMLRTPlanNode* planNode);
@@ -92,7 +120,39 @@ protected slots:
   void onSceneImportEnded(vtkObject* sceneObject);
 
 protected:
-  QScopedPointer<qSlicerDoseEngineLogic> d_ptr;
+  /// Calculate dose for the given beams using a bounded pool of worker threads.
+  /// The input of each beam is collected on the main thread (\sa qSlicerAbstractDoseEngine::createBeamDoseInput),
+  /// and only the calculation from this input runs in the workers. All MRML node access (preparation and
+  /// adding the result doses) is done on the main thread.
+  /// If some beams fail, the result doses of the other beams are still added, and the error message lists
+  /// each failed beam.
+  /// \param numberOfThreads Number of worker threads, at most the number of beams
+  /// \return Error message. Empty string on success
+  QString calculateDoseInParallel(qSlicerAbstractDoseEngine* engine, const std::vector<vtkMRMLRTBeamNode*>& beams, int numberOfThreads);
+
+  /// Calculate the total dose of a plan by adding the dose of each beam into a single float
+  /// buffer on the reference volume grid, without creating per-beam dose volumes.
+  /// Thread-safe engines add the beams concurrently, see \sa accumulateDoseInParallel
+  /// \param numberOfThreads Number of worker threads, at most the number of beams
+  /// \return Error message. Empty string on success
+  QString calculateAccumulatedDoseUsingEngine(vtkMRMLRTPlanNode* planNode, qSlicerAbstractDoseEngine* engine,
+    const std::vector<vtkMRMLRTBeamNode*>& beams, int numberOfThreads);
+
+  /// Add the weighted dose of the given prepared beams to the accumulated dose using a bounded pool of worker
+  /// threads. The inputs of the beams are collected on the main thread. Each worker adds its beams into its own
+  /// buffer, and the buffers are summed in a fixed order, so the result is the same for the same number of threads
+  /// \return Error message. Empty string on success
+  QString accumulateDoseInParallel(qSlicerAbstractDoseEngine* engine, const std::vector<vtkMRMLRTBeamNode*>& beams,
+    vtkImageData* accumulatedDoseImageData, int numberOfThreads);
+
+  /// Wait for the dose calculation tasks to finish while reporting the progress of the completed beams
+  void waitForDoseCalculationTasks(QThreadPool& threadPool, const QAtomicInt& numberOfCompletedBeams, int numberOfBeams);
+
+  /// Set up subject hierarchy, display, and view selection for the total dose volume of a plan
+  void setupTotalDoseVolume(vtkMRMLRTPlanNode* planNode);
+
+protected:
+  QScopedPointer<qSlicerDoseEngineLogicPrivate> d_ptr;
 
 private:
   Q_DECLARE_PRIVATE(qSlicerDoseEngineLogic);
@@ -37,6 +37,10 @@
 #include <vtkSmartPointer.h>
 #include <vtkImageData.h>
 #include <vtkPolyData.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
 
 // Slicer includes
 #include <vtkSlicerVersionConfigure.h>
@@ -44,6 +48,10 @@
 // Qt includes
 #include <QDebug>
 
+// STD includes
+#include <memory>
+#include <random>
+
 //----------------------------------------------------------------------------
 qSlicerMockDoseEngine::qSlicerMockDoseEngine(QObject* parent)
   : qSlicerAbstractDoseEngine(parent)
@@ -54,6 +62,19 @@ qSlicerMockDoseEngine::qSlicerMockDoseEngine(QObject* parent)
 //----------------------------------------------------------------------------
 qSlicerMockDoseEngine::~qSlicerMockDoseEngine() = default;
 
+//---------------------------------------------------------------------------
+bool qSlicerMockDoseEngine::isThreadSafe()const
+{
+  // The beam is converted to a labelmap and the noise is added from the input collected on the main thread
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool qSlicerMockDoseEngine::canAccumulateDose()const
+{
+  return true;
+}
+
 //---------------------------------------------------------------------------
 void qSlicerMockDoseEngine::defineBeamParameters()
 {
@@ -66,29 +87,109 @@ void qSlicerMockDoseEngine::defineBeamParameters()
 //---------------------------------------------------------------------------
 QString qSlicerMockDoseEngine::calculateDoseUsingEngine(vtkMRMLRTBeamNode* beamNode, vtkMRMLScalarVolumeNode* resultDoseVolumeNode)
 {
-  if (!beamNode)
+  if (!beamNode || !resultDoseVolumeNode)
+  {
+    QString errorMessage("Invalid beam node or result dose volume node");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+
+  QString errorMessage = this->calculateDoseFromBeamDoseInput(beamNode, resultDoseVolumeNode);
+  if (!errorMessage.isEmpty())
+  {
+    return errorMessage;
+  }
+
+  std::string randomDoseNodeName = std::string(beamNode->GetName()) + "_MockDose";
+  resultDoseVolumeNode->SetName(randomDoseNodeName.c_str());
+
+  return QString();
+}
+
+//---------------------------------------------------------------------------
+QString qSlicerMockDoseEngine::accumulateDoseUsingEngine(vtkMRMLRTBeamNode* beamNode, vtkImageData* accumulatedDoseImageData, double beamWeight)
+{
+  if (!beamNode || !accumulatedDoseImageData)
   {
-    QString errorMessage("Invalid beam node");
+    QString errorMessage("Invalid beam node or accumulated dose image");
     qCritical() << Q_FUNC_INFO << ": " << errorMessage;
     return errorMessage;
   }
-  vtkMRMLRTPlanNode* parentPlanNode = beamNode->GetParentPlanNode();
-  vtkMRMLScalarVolumeNode* referenceVolumeNode = parentPlanNode->GetReferenceVolumeNode();
-  if (!parentPlanNode || !referenceVolumeNode || !resultDoseVolumeNode)
+
+  QString errorMessage;
+  std::unique_ptr<BeamDoseInput> input(this->createBeamDoseInput(beamNode, errorMessage));
+  if (!input)
+  {
+    return errorMessage;
+  }
+  return this->addBeamDoseFromInput(input.get(), accumulatedDoseImageData, beamWeight);
+}
+
+//---------------------------------------------------------------------------
+qSlicerAbstractDoseEngine::BeamDoseInput* qSlicerMockDoseEngine::createBeamDoseInput(vtkMRMLRTBeamNode* beamNode, QString& errorMessage)
+{
+  vtkMRMLRTPlanNode* parentPlanNode = (beamNode ? beamNode->GetParentPlanNode() : nullptr);
+  if (!parentPlanNode)
+  {
+    errorMessage = QString("Invalid beam node or parent plan");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return nullptr;
+  }
+
+  // Beam labelmap geometry is the reference volume geometry
+  vtkSmartPointer<vtkOrientedImageData> referenceImage = vtkSmartPointer<vtkOrientedImageData>::Take(
+    qSlicerAbstractDoseEngine::createReferenceImageForBeamDoseInput(beamNode, errorMessage) );
+  if (!referenceImage)
+  {
+    return nullptr;
+  }
+  vtkNew<vtkMatrix4x4> referenceImageToWorldMatrix;
+  referenceImage->GetImageToWorldMatrix(referenceImageToWorldMatrix);
+
+  MockBeamDoseInput* input = new MockBeamDoseInput();
+  input->BeamLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  input->BeamLabelmap->SetExtent(referenceImage->GetExtent());
+  input->BeamLabelmap->SetImageToWorldMatrix(referenceImageToWorldMatrix);
+
+  // Beam model in world coordinates
+  vtkSmartPointer<vtkSegment> beamSegment = vtkSmartPointer<vtkSegment>::Take(
+    vtkSlicerSegmentationsModuleLogic::CreateSegmentFromModelNode(beamNode) );
+  input->BeamPolyData = (beamSegment ? vtkPolyData::SafeDownCast(
+    beamSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()) ) : nullptr);
+  if (!input->BeamPolyData)
+  {
+    errorMessage = QString("Unable to get model of beam %1").arg(beamNode->GetName());
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    delete input;
+    return nullptr;
+  }
+
+  input->RxDose = parentPlanNode->GetRxDose();
+  input->NoiseRange = this->doubleParameter(beamNode, "NoiseRange");
+  input->RandomSeed = (beamNode->GetID() ? beamNode->GetID() : beamNode->GetName());
+  return input;
+}
+
+//---------------------------------------------------------------------------
+QString qSlicerMockDoseEngine::addBeamDoseFromInput(const BeamDoseInput* input, vtkImageData* doseImageData, double beamWeight)const
+{
+  const MockBeamDoseInput* mockInput = dynamic_cast<const MockBeamDoseInput*>(input);
+  if (!mockInput || !doseImageData)
   {
-    QString errorMessage("Unable to access reference volume");
+    QString errorMessage("Invalid mock beam dose input or dose image");
     qCritical() << Q_FUNC_INFO << ": " << errorMessage;
     return errorMessage;
   }
 
+  // Convert the beam model to labelmap on the reference volume grid
   vtkSmartPointer<vtkClosedSurfaceToBinaryLabelmapConversionRule> converter =
     vtkSmartPointer<vtkClosedSurfaceToBinaryLabelmapConversionRule>::New();
   converter->SetUseOutputImageDataGeometry(true);
-  vtkSmartPointer<vtkSegment> beamSegment = vtkSmartPointer<vtkSegment>::Take(
-    vtkSlicerSegmentationsModuleLogic::CreateSegmentFromModelNode(beamNode) );
-  vtkPolyData* beamPolyData = vtkPolyData::SafeDownCast(beamSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()));
-  vtkSmartPointer<vtkOrientedImageData> beamImageData = vtkSmartPointer<vtkOrientedImageData>::Take(
-    vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(referenceVolumeNode) );
+  vtkPolyData* beamPolyData = mockInput->BeamPolyData;
+  vtkSmartPointer<vtkSegment> beamSegment = vtkSmartPointer<vtkSegment>::New();
+  beamSegment->AddRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(), beamPolyData);
+  vtkSmartPointer<vtkOrientedImageData> beamImageData = vtkSmartPointer<vtkOrientedImageData>::New();
+  beamImageData->ShallowCopy(mockInput->BeamLabelmap);
   beamSegment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), beamImageData);
 #if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
   converter->Convert(beamSegment);
@@ -104,44 +205,34 @@ QString qSlicerMockDoseEngine::calculateDoseUsingEngine(vtkMRMLRTBeamNode* beamN
     return errorMessage;
   }
 
-  // Create dose image
-  vtkSmartPointer<vtkImageData> protonDoseImageData = vtkSmartPointer<vtkImageData>::New();
-  protonDoseImageData->SetExtent(referenceVolumeNode->GetImageData()->GetExtent());
-  protonDoseImageData->SetSpacing(referenceVolumeNode->GetImageData()->GetSpacing());
-  protonDoseImageData->SetOrigin(referenceVolumeNode->GetImageData()->GetOrigin());
-  protonDoseImageData->AllocateScalars(VTK_FLOAT, 1);
-  if ( beamImageData->GetNumberOfPoints() != protonDoseImageData->GetNumberOfPoints()
-    || beamImageData->GetScalarType() != VTK_UNSIGNED_CHAR )
+  if ( beamImageData->GetNumberOfPoints() != doseImageData->GetNumberOfPoints()
+    || beamImageData->GetScalarType() != VTK_UNSIGNED_CHAR
+    || doseImageData->GetScalarType() != VTK_FLOAT )
   {
     QString errorMessage("Geometrical discrepancy between beam and dose");
     qCritical() << Q_FUNC_INFO << ": " << errorMessage;
     return errorMessage;
   }
 
-  // Paint voxels touched by beam prescription+noise, all others zero
-  float noiseRange = (float)this->doubleParameter(beamNode, "NoiseRange");
-  double rxDose = parentPlanNode->GetRxDose();
+  // Add prescription+noise to voxels touched by beam, leave all others unchanged.
+  // The noise is seeded by the beam, so the dose of a beam is the same whether it is calculated
+  // alone, with the other beams concurrently, or directly into the plan total dose
+  std::seed_seq randomSeed(mockInput->RandomSeed.begin(), mockInput->RandomSeed.end());
+  std::mt19937 randomGenerator(randomSeed);
+  std::uniform_real_distribution<float> randomDistribution(0.0f, 1.0f);
+  float noiseRange = (float)mockInput->NoiseRange;
+  double rxDose = mockInput->RxDose;
   unsigned char* beamPtr = (unsigned char*)beamImageData->GetScalarPointer();
-  float* floatPtr = (float*)protonDoseImageData->GetScalarPointer();
-  for (long i=0; i<protonDoseImageData->GetNumberOfPoints(); ++i)
+  float* floatPtr = (float*)doseImageData->GetScalarPointer();
+  for (long i=0; i<doseImageData->GetNumberOfPoints(); ++i)
   {
     if ((*beamPtr) > 0)
     {
-      (*floatPtr) = rxDose + (float)((float)rand()/RAND_MAX)*rxDose * noiseRange/100.0 - noiseRange/200.0;
-    }
-    else
-    {
-      (*floatPtr) = 0;
+      (*floatPtr) += beamWeight * (rxDose + randomDistribution(randomGenerator)*rxDose * noiseRange/100.0 - noiseRange/200.0);
     }
     ++floatPtr;
     ++beamPtr;
   }
 
-  resultDoseVolumeNode->SetAndObserveImageData(protonDoseImageData);
-  resultDoseVolumeNode->CopyOrientation(referenceVolumeNode);
-
-  std::string randomDoseNodeName = std::string(beamNode->GetName()) + "_MockDose";
-  resultDoseVolumeNode->SetName(randomDoseNodeName.c_str());
-
   return QString();
 }
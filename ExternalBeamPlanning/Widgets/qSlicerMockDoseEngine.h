@@ -26,6 +26,16 @@
 // ExternalBeamPlanning includes
 #include "qSlicerAbstractDoseEngine.h"
 
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <string>
+
 /// \ingroup SlicerRt_QtModules_ExternalBeamPlanning
 /// \class qSlicerMockDoseEngine
 /// \brief Mock dose calculation algorithm. Simply fills the beam apertures with prescription dose adding some noise.
@@ -52,6 +62,38 @@ public:
   /// Define engine-specific beam parameters
   void defineBeamParameters();
 
+  /// Mock engine calculates beams concurrently from the beam model and the parameters collected on the main thread
+  bool isThreadSafe()const override;
+
+  /// Mock engine can add beam dose directly to the plan total dose
+  bool canAccumulateDose()const override;
+
+  /// Add weighted mock dose of a beam to the plan total dose
+  Q_INVOKABLE QString accumulateDoseUsingEngine(vtkMRMLRTBeamNode* beamNode, vtkImageData* accumulatedDoseImageData, double beamWeight);
+
+protected:
+  /// Input of the mock dose calculation of a beam
+  class MockBeamDoseInput : public BeamDoseInput
+  {
+  public:
+    /// Beam model in world coordinates
+    vtkSmartPointer<vtkPolyData> BeamPolyData;
+    /// Empty labelmap with the geometry of the reference volume
+    vtkSmartPointer<vtkOrientedImageData> BeamLabelmap;
+    /// Prescription dose of the plan
+    double RxDose{0.0};
+    /// Noise range parameter of the beam (% of Rx)
+    double NoiseRange{0.0};
+    /// Seed of the noise, given by the beam
+    std::string RandomSeed;
+  };
+
+  /// Collect beam model, reference geometry, and noise parameters of a beam
+  BeamDoseInput* createBeamDoseInput(vtkMRMLRTBeamNode* beamNode, QString& errorMessage) override;
+
+  /// Add weighted mock dose of a beam to a float image on the reference volume grid
+  QString addBeamDoseFromInput(const BeamDoseInput* input, vtkImageData* doseImageData, double beamWeight)const override;
+
 private:
   Q_DISABLE_COPY(qSlicerMockDoseEngine);
 };
@@ -0,0 +1,277 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Dose engines includes
+#include "qSlicerPhotonPencilBeamDoseEngine.h"
+
+// ExternalBeamPlanning includes
+#include "vtkPhotonPencilBeamDoseFilter.h"
+
+// Beams includes
+#include "vtkMRMLRTPlanNode.h"
+#include "vtkMRMLRTBeamNode.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLTableNode.h>
+#include <vtkMRMLTransformNode.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTable.h>
+
+// Qt includes
+#include <QDebug>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+//----------------------------------------------------------------------------
+qSlicerPhotonPencilBeamDoseEngine::qSlicerPhotonPencilBeamDoseEngine(QObject* parent)
+  : qSlicerAbstractDoseEngine(parent)
+{
+  this->m_Name = QString("Photon pencil beam");
+}
+
+//----------------------------------------------------------------------------
+qSlicerPhotonPencilBeamDoseEngine::~qSlicerPhotonPencilBeamDoseEngine() = default;
+
+//---------------------------------------------------------------------------
+bool qSlicerPhotonPencilBeamDoseEngine::isThreadSafe()const
+{
+  // Beam inputs are collected on the main thread, and each calculation uses its own dose filter
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool qSlicerPhotonPencilBeamDoseEngine::canAccumulateDose()const
+{
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void qSlicerPhotonPencilBeamDoseEngine::defineBeamParameters()
+{
+  this->addBeamParameterSpinBox(
+    "Pencil beam", "AttenuationCoefficient", "Attenuation coefficient (1/mm):",
+    "Effective attenuation coefficient of the depth dose beyond the build-up region",
+    0.0, 0.1, 0.0028, 0.0001, 4 );
+  this->addBeamParameterSpinBox(
+    "Pencil beam", "PrimarySigma", "Primary sigma (mm):",
+    "Standard deviation of the primary lateral Gaussian at the surface, in the isocenter plane. Defines the penumbra",
+    0.1, 20.0, 3.0, 0.1, 1 );
+  this->addBeamParameterSpinBox(
+    "Pencil beam", "ScatterSigma", "Scatter sigma (mm):",
+    "Standard deviation of the scatter lateral Gaussian at the surface, in the isocenter plane",
+    1.0, 100.0, 15.0, 1.0, 1 );
+  this->addBeamParameterSpinBox(
+    "Pencil beam", "ScatterWeight", "Scatter weight:",
+    "Weight of the scatter Gaussian in the lateral kernel",
+    0.0, 1.0, 0.08, 0.01, 2 );
+}
+
+//---------------------------------------------------------------------------
+QString qSlicerPhotonPencilBeamDoseEngine::calculateDoseUsingEngine(vtkMRMLRTBeamNode* beamNode, vtkMRMLScalarVolumeNode* resultDoseVolumeNode)
+{
+  if (!beamNode || !resultDoseVolumeNode)
+  {
+    QString errorMessage("Invalid beam node or result dose volume node");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+
+  QString errorMessage = this->calculateDoseFromBeamDoseInput(beamNode, resultDoseVolumeNode);
+  if (!errorMessage.isEmpty())
+  {
+    return errorMessage;
+  }
+
+  std::string doseNodeName = std::string(beamNode->GetName()) + "_PencilBeamDose";
+  resultDoseVolumeNode->SetName(doseNodeName.c_str());
+
+  return QString();
+}
+
+//---------------------------------------------------------------------------
+QString qSlicerPhotonPencilBeamDoseEngine::accumulateDoseUsingEngine(vtkMRMLRTBeamNode* beamNode, vtkImageData* accumulatedDoseImageData, double beamWeight)
+{
+  if (!beamNode || !accumulatedDoseImageData)
+  {
+    QString errorMessage("Invalid beam node or accumulated dose image");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+
+  QString errorMessage;
+  std::unique_ptr<BeamDoseInput> input(this->createBeamDoseInput(beamNode, errorMessage));
+  if (!input)
+  {
+    return errorMessage;
+  }
+  return this->addBeamDoseFromInput(input.get(), accumulatedDoseImageData, beamWeight);
+}
+
+//---------------------------------------------------------------------------
+qSlicerAbstractDoseEngine::BeamDoseInput* qSlicerPhotonPencilBeamDoseEngine::createBeamDoseInput(vtkMRMLRTBeamNode* beamNode, QString& errorMessage)
+{
+  vtkMRMLRTPlanNode* parentPlanNode = (beamNode ? beamNode->GetParentPlanNode() : nullptr);
+  if (!parentPlanNode)
+  {
+    errorMessage = QString("Invalid beam node or parent plan");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return nullptr;
+  }
+
+  // Reference volume in world coordinates
+  vtkSmartPointer<vtkOrientedImageData> referenceImage = vtkSmartPointer<vtkOrientedImageData>::Take(
+    qSlicerAbstractDoseEngine::createReferenceImageForBeamDoseInput(beamNode, errorMessage) );
+  if (!referenceImage)
+  {
+    return nullptr;
+  }
+
+  std::unique_ptr<PencilBeamDoseInput> input(new PencilBeamDoseInput());
+  input->ReferenceImage = referenceImage;
+
+  // Beam geometry from the IEC transform hierarchy
+  input->BeamToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  vtkMRMLTransformNode* beamTransformNode = beamNode->GetParentTransformNode();
+  if (beamTransformNode)
+  {
+    beamTransformNode->GetMatrixTransformToWorld(input->BeamToWorldMatrix);
+  }
+
+  input->SAD = beamNode->GetSAD();
+  input->RxDose = parentPlanNode->GetRxDose();
+  input->AttenuationCoefficient = this->doubleParameter(beamNode, "AttenuationCoefficient");
+  input->PrimarySigma = this->doubleParameter(beamNode, "PrimarySigma");
+  input->ScatterSigma = this->doubleParameter(beamNode, "ScatterSigma");
+  input->ScatterWeight = this->doubleParameter(beamNode, "ScatterWeight");
+  this->setAperture(beamNode, input.get());
+  if (input->ApertureRectangles.empty())
+  {
+    errorMessage = QString("Aperture of beam %1 is closed").arg(beamNode->GetName());
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return nullptr;
+  }
+
+  return input.release();
+}
+
+//---------------------------------------------------------------------------
+QString qSlicerPhotonPencilBeamDoseEngine::addBeamDoseFromInput(const BeamDoseInput* input, vtkImageData* doseImageData, double beamWeight)const
+{
+  const PencilBeamDoseInput* pencilBeamInput = dynamic_cast<const PencilBeamDoseInput*>(input);
+  if (!pencilBeamInput || !doseImageData || doseImageData->GetScalarType() != VTK_FLOAT)
+  {
+    QString errorMessage("Invalid pencil beam dose input or dose image");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+
+  // Dose filter per calculation, so that beams can be calculated concurrently
+  vtkNew<vtkPhotonPencilBeamDoseFilter> doseFilter;
+  doseFilter->SetInputVolume(pencilBeamInput->ReferenceImage);
+  doseFilter->SetBeamToWorldMatrix(pencilBeamInput->BeamToWorldMatrix);
+  doseFilter->SetSourceToIsocenterDistance(pencilBeamInput->SAD);
+  doseFilter->SetReferenceDose(pencilBeamInput->RxDose);
+  doseFilter->SetAttenuationCoefficient(pencilBeamInput->AttenuationCoefficient);
+  doseFilter->SetPrimarySigma(pencilBeamInput->PrimarySigma);
+  doseFilter->SetScatterSigma(pencilBeamInput->ScatterSigma);
+  doseFilter->SetScatterWeight(pencilBeamInput->ScatterWeight);
+  for (const std::array<double, 4>& rectangle : pencilBeamInput->ApertureRectangles)
+  {
+    doseFilter->AddApertureRectangle(rectangle[0], rectangle[1], rectangle[2], rectangle[3]);
+  }
+  if (!doseFilter->Update())
+  {
+    QString errorMessage("Failed to calculate pencil beam dose");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+
+  vtkOrientedImageData* doseImage = doseFilter->GetOutputImage();
+  if (doseImage->GetNumberOfPoints() != doseImageData->GetNumberOfPoints())
+  {
+    QString errorMessage("Geometrical discrepancy between beam dose and dose image");
+    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+    return errorMessage;
+  }
+
+  const float* beamDosePtr = static_cast<float*>(doseImage->GetScalarPointer());
+  float* dosePtr = static_cast<float*>(doseImageData->GetScalarPointer());
+  for (vtkIdType i = 0; i < doseImageData->GetNumberOfPoints(); ++i)
+  {
+    dosePtr[i] += static_cast<float>(beamWeight * beamDosePtr[i]);
+  }
+
+  return QString();
+}
+
+//---------------------------------------------------------------------------
+void qSlicerPhotonPencilBeamDoseEngine::setAperture(vtkMRMLRTBeamNode* beamNode, PencilBeamDoseInput* input)
+{
+  input->ApertureRectangles.clear();
+  double x1Jaw = beamNode->GetX1Jaw();
+  double x2Jaw = beamNode->GetX2Jaw();
+  double y1Jaw = beamNode->GetY1Jaw();
+  double y2Jaw = beamNode->GetY2Jaw();
+
+  // Table with the leaf pair boundaries and the positions of the leaves, as used for the beam model
+  vtkMRMLTableNode* mlcTableNode = beamNode->GetMultiLeafCollimatorTableNode();
+  vtkTable* mlcTable = (mlcTableNode ? mlcTableNode->GetTable() : nullptr);
+  if (!mlcTable || mlcTable->GetNumberOfRows() < 2 || mlcTable->GetNumberOfColumns() != 3)
+  {
+    if (x2Jaw > x1Jaw && y2Jaw > y1Jaw)
+    {
+      input->ApertureRectangles.push_back({ x1Jaw, x2Jaw, y1Jaw, y2Jaw });
+    }
+    return;
+  }
+
+  // Leaves move along X (MLCX) by default, along Y if the table is named MLCY.
+  // Closed rectangles do not contribute to the dose, so they are left out
+  const char* mlcName = mlcTableNode->GetName();
+  bool typeMLCY = (mlcName && !strncmp("MLCY", mlcName, strlen("MLCY")));
+  for (vtkIdType leafPair = 0; leafPair < mlcTable->GetNumberOfRows() - 1; ++leafPair)
+  {
+    double boundary1 = mlcTable->GetValue(leafPair, 0).ToDouble();
+    double boundary2 = mlcTable->GetValue(leafPair + 1, 0).ToDouble();
+    double position1 = mlcTable->GetValue(leafPair, 1).ToDouble();
+    double position2 = mlcTable->GetValue(leafPair, 2).ToDouble();
+    std::array<double, 4> rectangle;
+    if (typeMLCY)
+    {
+      rectangle = { std::max(boundary1, x1Jaw), std::min(boundary2, x2Jaw), std::max(position1, y1Jaw), std::min(position2, y2Jaw) };
+    }
+    else
+    {
+      rectangle = { std::max(position1, x1Jaw), std::min(position2, x2Jaw), std::max(boundary1, y1Jaw), std::min(boundary2, y2Jaw) };
+    }
+    if (rectangle[1] > rectangle[0] && rectangle[3] > rectangle[2])
+    {
+      input->ApertureRectangles.push_back(rectangle);
+    }
+  }
+}
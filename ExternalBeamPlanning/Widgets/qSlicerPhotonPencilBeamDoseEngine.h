@@ -0,0 +1,107 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __qSlicerPhotonPencilBeamDoseEngine_h
+#define __qSlicerPhotonPencilBeamDoseEngine_h
+
+#include "qSlicerExternalBeamPlanningModuleWidgetsExport.h"
+
+// ExternalBeamPlanning includes
+#include "qSlicerAbstractDoseEngine.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <array>
+#include <vector>
+
+/// \ingroup SlicerRt_QtModules_ExternalBeamPlanning
+/// \class qSlicerPhotonPencilBeamDoseEngine
+/// \brief Photon dose calculation with an analytic pencil beam kernel (depth dose and lateral double Gaussian
+///        in radiological depth), see \sa vtkPhotonPencilBeamDoseFilter. The aperture is given by the jaws and
+///        the MLC of the beam. Fast enough for interactive plan iteration, but not for final dose calculation.
+class Q_SLICER_MODULE_EXTERNALBEAMPLANNING_WIDGETS_EXPORT qSlicerPhotonPencilBeamDoseEngine : public qSlicerAbstractDoseEngine
+{
+  Q_OBJECT
+
+public:
+  typedef qSlicerAbstractDoseEngine Superclass;
+  /// Constructor
+  explicit qSlicerPhotonPencilBeamDoseEngine(QObject* parent=nullptr);
+  /// Destructor
+  ~qSlicerPhotonPencilBeamDoseEngine() override;
+
+public:
+  /// Calculate dose for a single beam. Called by \sa CalculateDose that performs actions generic
+  /// to any dose engine before and after calculation.
+  /// \param beamNode Beam for which the dose is calculated. Each beam has a parent plan from which the
+  ///   plan-specific parameters are got
+  /// \param resultDoseVolumeNode Output volume node for the result dose. It is created by \sa CalculateDose
+  Q_INVOKABLE QString calculateDoseUsingEngine(vtkMRMLRTBeamNode* beamNode, vtkMRMLScalarVolumeNode* resultDoseVolumeNode);
+
+  /// Define engine-specific beam parameters
+  void defineBeamParameters();
+
+  /// Pencil beam engine calculates beams concurrently from the geometry and the parameters collected on the main thread
+  bool isThreadSafe()const override;
+
+  /// Pencil beam engine can add beam dose directly to the plan total dose
+  bool canAccumulateDose()const override;
+
+  /// Add weighted pencil beam dose of a beam to the plan total dose
+  Q_INVOKABLE QString accumulateDoseUsingEngine(vtkMRMLRTBeamNode* beamNode, vtkImageData* accumulatedDoseImageData, double beamWeight);
+
+protected:
+  /// Input of the pencil beam dose calculation of a beam
+  class PencilBeamDoseInput : public BeamDoseInput
+  {
+  public:
+    /// Reference volume in world coordinates, sharing the voxels of the reference volume
+    vtkSmartPointer<vtkOrientedImageData> ReferenceImage;
+    /// Beam to world transform from the IEC transform hierarchy
+    vtkSmartPointer<vtkMatrix4x4> BeamToWorldMatrix;
+    /// Source to isocenter distance of the beam
+    double SAD{0.0};
+    /// Prescription dose of the plan
+    double RxDose{0.0};
+    /// Engine parameters of the beam
+    double AttenuationCoefficient{0.0};
+    double PrimarySigma{0.0};
+    double ScatterSigma{0.0};
+    double ScatterWeight{0.0};
+    /// Open rectangles (x1, x2, y1, y2) of the jaws and the MLC leaf pairs in the isocenter plane
+    std::vector<std::array<double, 4> > ApertureRectangles;
+  };
+
+  /// Collect reference image, beam geometry, aperture, and kernel parameters of a beam
+  BeamDoseInput* createBeamDoseInput(vtkMRMLRTBeamNode* beamNode, QString& errorMessage) override;
+
+  /// Compute pencil beam dose of a beam on the reference volume grid and add it weighted to a float image
+  QString addBeamDoseFromInput(const BeamDoseInput* input, vtkImageData* doseImageData, double beamWeight)const override;
+
+  /// Collect the open rectangles of the jaws and the MLC leaf pairs of the beam
+  void setAperture(vtkMRMLRTBeamNode* beamNode, PencilBeamDoseInput* input);
+
+private:
+  Q_DISABLE_COPY(qSlicerPhotonPencilBeamDoseEngine);
+};
+
+#endif
@@ -34,6 +34,7 @@
 // Widgets includes
 #include "qSlicerDoseEnginePluginHandler.h"
 #include "qSlicerMockDoseEngine.h"
+#include "qSlicerPhotonPencilBeamDoseEngine.h"
 
 // SlicerRT includes
 #include "vtkSlicerBeamsModuleLogic.h"
@@ -139,6 +140,7 @@ void qSlicerExternalBeamPlanningModule::setup()
 
   // Register dose engines
   qSlicerDoseEnginePluginHandler::instance()->registerDoseEngine(new qSlicerMockDoseEngine());
+  qSlicerDoseEnginePluginHandler::instance()->registerDoseEngine(new qSlicerPhotonPencilBeamDoseEngine());
 
   // Python engines
   // (otherwise it would be the responsibility of the module that embeds the dose engine)
@@ -245,6 +245,7 @@ void qSlicerExternalBeamPlanningModuleWidget::setup()
   connect( d->MRMLNodeComboBox_DoseVolume, SIGNAL(currentNodeChanged(vtkMRMLNode*)), this, SLOT(doseVolumeNodeChanged(vtkMRMLNode*)) );
   connect( d->MRMLNodeComboBox_DoseROI, SIGNAL(currentNodeChanged(vtkMRMLNode*)), this, SLOT(doseROINodeChanged(vtkMRMLNode*)) );
   connect( d->lineEdit_DoseGridSpacing, SIGNAL(textChanged(const QString&)), this, SLOT(doseGridSpacingChanged(const QString&)) );
+  connect( d->checkBox_CreatePerBeamDoseVolumes, SIGNAL(stateChanged(int)), this, SLOT(createPerBeamDoseVolumesCheckboxStateChanged(int)) );
 
   // Beams section
   //connect( d->BeamsTableView, SIGNAL(selectionChanged(QItemSelection,QItemSelection)), this, SLOT(beamSelectionChanged(QItemSelection,QItemSelection) ) );
@@ -254,6 +255,7 @@ void qSlicerExternalBeamPlanningModuleWidget::setup()
   // Calculation buttons
   connect( d->pushButton_CalculateDose, SIGNAL(clicked()), this, SLOT(calculateDoseClicked()) );
   connect( d->pushButton_CalculateWED, SIGNAL(clicked()), this, SLOT(calculateWEDClicked()) );
+  connect( d->pushButton_UpdateDRR, SIGNAL(clicked()), this, SLOT(updateDRRClicked()) );
   connect( d->pushButton_ClearDose, SIGNAL(clicked()), this, SLOT(clearDoseClicked()) );
 
   // Connect to progress event
@@ -324,6 +326,9 @@ void qSlicerExternalBeamPlanningModuleWidget::updateWidgetFromMRML()
   // Set prescription
   d->doubleSpinBox_RxDose->setValue(planNode->GetRxDose());
 
+  // Output section
+  d->checkBox_CreatePerBeamDoseVolumes->setChecked(planNode->GetCreatePerBeamDoseVolumes());
+
   return;
 }
 
@@ -628,6 +633,23 @@ void qSlicerExternalBeamPlanningModuleWidget::doseGridSpacingChanged(const QStri
   // TODO: to be implemented
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerExternalBeamPlanningModuleWidget::createPerBeamDoseVolumesCheckboxStateChanged(int state)
+{
+  Q_D(qSlicerExternalBeamPlanningModuleWidget);
+
+  vtkMRMLRTPlanNode* planNode = vtkMRMLRTPlanNode::SafeDownCast(d->MRMLNodeComboBox_RtPlan->currentNode());
+  if (!planNode)
+  {
+    qCritical() << Q_FUNC_INFO << ": Invalid RT plan node";
+    return;
+  }
+
+  planNode->DisableModifiedEventOn();
+  planNode->SetCreatePerBeamDoseVolumes(state > 0);
+  planNode->DisableModifiedEventOff();
+}
+
 //-----------------------------------------------------------------------------
 void qSlicerExternalBeamPlanningModuleWidget::targetSegmentChanged(const QString& segment)
 {
@@ -1083,36 +1105,99 @@ void qSlicerExternalBeamPlanningModuleWidget::calculateWEDClicked()
     return;
   }
 
-  /// GCS FIX TODO *** Implementation needs work ***
+  vtkMRMLRTPlanNode* planNode = vtkMRMLRTPlanNode::SafeDownCast(d->MRMLNodeComboBox_RtPlan->currentNode());
+  if (!planNode || !planNode->GetReferenceVolumeNode())
+  {
+    d->label_CalculateDoseStatus->setText("No plan or reference image");
+    return;
+  }
+  std::vector<vtkMRMLRTBeamNode*> beams;
+  planNode->GetBeams(beams);
+  if (beams.empty())
+  {
+    d->label_CalculateDoseStatus->setText("No beams in plan");
+    return;
+  }
+
+  QTime time;
+  time.start();
+  QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
+
+  // WED volumes are created under the beams. The ray grids of the beam geometries are cached in the
+  // logic, so recomputing after changing the geometry back and forth is faster
+  bool success = true;
+  for (vtkMRMLRTBeamNode* beamNode : beams)
+  {
+    if (!d->logic()->ComputeWED(beamNode))
+    {
+      qCritical() << Q_FUNC_INFO << ": Failed to compute WED for beam " << beamNode->GetName();
+      success = false;
+    }
+  }
+
+  if (success)
+  {
+    d->label_CalculateDoseStatus->setText(QString("WED calculated successfully in %1 s").arg(time.elapsed()/1000.0));
+  }
+  else
+  {
+    d->label_CalculateDoseStatus->setText("ERROR: WED calculation failed for one or more beams");
+  }
+  QApplication::restoreOverrideCursor();
+}
 
-#if defined (commentout)
-  vtkMRMLExternalBeamPlanningNode* paramNode = d->logic()->GetExternalBeamPlanningNode();
-  if (!paramNode)
+//-----------------------------------------------------------------------------
+void qSlicerExternalBeamPlanningModuleWidget::updateDRRClicked()
+{
+  Q_D(qSlicerExternalBeamPlanningModuleWidget);
+
+  d->label_CalculateDoseStatus->setText("Starting DRR calculation...");
+
+  if (!this->mrmlScene())
   {
+    qCritical() << Q_FUNC_INFO << ": Invalid scene";
     return;
   }
 
-  // Make sure inputs were specified - only CT needed
-  vtkMRMLScalarVolumeNode* referenceVolume = planNode->GetReferenceVolumeNode();
-  if (!referenceVolume)
+  vtkMRMLRTPlanNode* planNode = vtkMRMLRTPlanNode::SafeDownCast(d->MRMLNodeComboBox_RtPlan->currentNode());
+  if (!planNode || !planNode->GetReferenceVolumeNode())
   {
-    d->label_CalculateDoseStatus->setText("No reference image");
+    d->label_CalculateDoseStatus->setText("No plan or reference image");
+    return;
+  }
+  std::vector<vtkMRMLRTBeamNode*> beams;
+  planNode->GetBeams(beams);
+  if (beams.empty())
+  {
+    d->label_CalculateDoseStatus->setText("No beams in plan");
     return;
   }
 
+  QTime time;
+  time.start();
   QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
 
-  // Copy pertinent variable values from GUI to logic
-  // Is this the right place for this?
-  d->logic()->GetExternalBeamPlanningNode()->SetGantryAngle(d->SliderWidget_GantryAngle->value());
-
-  // OK, we're good to go (well, not really, but let's pretend). 
-  // Do the actual computation in the logic object
-  d->logic()->ComputeWED();
+  // DRR volumes are created under the beams. The attenuation volume converted from the reference
+  // volume is cached in the logic, so only the first beam pays for the conversion
+  bool success = true;
+  for (vtkMRMLRTBeamNode* beamNode : beams)
+  {
+    if (!d->logic()->UpdateDRR(planNode, beamNode->GetName()))
+    {
+      qCritical() << Q_FUNC_INFO << ": Failed to compute DRR for beam " << beamNode->GetName();
+      success = false;
+    }
+  }
 
-  d->label_CalculateDoseStatus->setText("WED calculation done.");
+  if (success)
+  {
+    d->label_CalculateDoseStatus->setText(QString("DRR calculated successfully in %1 s").arg(time.elapsed()/1000.0));
+  }
+  else
+  {
+    d->label_CalculateDoseStatus->setText("ERROR: DRR calculation failed for one or more beams");
+  }
   QApplication::restoreOverrideCursor();
-#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -86,10 +86,12 @@ protected slots:
   void doseVolumeNodeChanged(vtkMRMLNode*);
   void doseROINodeChanged(vtkMRMLNode*);
   void doseGridSpacingChanged(const QString &);
+  void createPerBeamDoseVolumesCheckboxStateChanged(int state);
   
   // Calculation buttons
   void calculateDoseClicked();
   void calculateWEDClicked();
+  void updateDRRClicked();
   void clearDoseClicked();
 
   // Beams section
@@ -50,6 +50,12 @@ vtkMRMLIsodoseNode::vtkMRMLIsodoseNode()
   this->ShowScalarBar = false;
   this->ShowScalarBar2D = false;
   this->ShowDoseVolumesOnly = true;
+  this->UseRegionOfInterest = false;
+  for (int i=0; i<6; ++i)
+  {
+    this->RegionOfInterestBounds[i] = 0.0;
+  }
+  this->GenerateSliceIsolines = false;
 
   this->HideFromEditors = false;
 }
@@ -69,6 +75,9 @@ void vtkMRMLIsodoseNode::WriteXML(ostream& of, int nIndent)
   vtkMRMLWriteXMLBooleanMacro(ShowScalarBar, ShowScalarBar);
   vtkMRMLWriteXMLBooleanMacro(ShowScalarBar2D, ShowScalarBar2D);
   vtkMRMLWriteXMLBooleanMacro(ShowDoseVolumesOnly, ShowDoseVolumesOnly);
+  vtkMRMLWriteXMLBooleanMacro(UseRegionOfInterest, UseRegionOfInterest);
+  vtkMRMLWriteXMLVectorMacro(RegionOfInterestBounds, RegionOfInterestBounds, double, 6);
+  vtkMRMLWriteXMLBooleanMacro(GenerateSliceIsolines, GenerateSliceIsolines);
   vtkMRMLWriteXMLEndMacro(); 
 }
 
@@ -84,6 +93,9 @@ void vtkMRMLIsodoseNode::ReadXMLAttributes(const char** atts)
   vtkMRMLReadXMLBooleanMacro(ShowScalarBar, ShowScalarBar);
   vtkMRMLReadXMLBooleanMacro(ShowScalarBar2D, ShowScalarBar2D);
   vtkMRMLReadXMLBooleanMacro(ShowDoseVolumesOnly, ShowDoseVolumesOnly);
+  vtkMRMLReadXMLBooleanMacro(UseRegionOfInterest, UseRegionOfInterest);
+  vtkMRMLReadXMLVectorMacro(RegionOfInterestBounds, RegionOfInterestBounds, double, 6);
+  vtkMRMLReadXMLBooleanMacro(GenerateSliceIsolines, GenerateSliceIsolines);
   vtkMRMLReadXMLEndMacro();
 
   this->EndModify(disabledModify);
@@ -104,6 +116,9 @@ void vtkMRMLIsodoseNode::Copy(vtkMRMLNode *anode)
   vtkMRMLCopyBooleanMacro(ShowScalarBar);
   vtkMRMLCopyBooleanMacro(ShowScalarBar2D);
   vtkMRMLCopyBooleanMacro(ShowDoseVolumesOnly);
+  vtkMRMLCopyBooleanMacro(UseRegionOfInterest);
+  vtkMRMLCopyVectorMacro(RegionOfInterestBounds, double, 6);
+  vtkMRMLCopyBooleanMacro(GenerateSliceIsolines);
   vtkMRMLCopyEndMacro();
 
   this->EndModify(disabledModify);
@@ -120,6 +135,9 @@ void vtkMRMLIsodoseNode::PrintSelf(ostream& os, vtkIndent indent)
   vtkMRMLPrintBooleanMacro(ShowScalarBar);
   vtkMRMLPrintBooleanMacro(ShowScalarBar2D);
   vtkMRMLPrintBooleanMacro(ShowDoseVolumesOnly);
+  vtkMRMLPrintBooleanMacro(UseRegionOfInterest);
+  vtkMRMLPrintVectorMacro(RegionOfInterestBounds, double, 6);
+  vtkMRMLPrintBooleanMacro(GenerateSliceIsolines);
   vtkMRMLPrintEndMacro();
 }
 
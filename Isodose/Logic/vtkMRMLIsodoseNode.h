@@ -94,6 +94,22 @@ public:
   vtkSetMacro(ShowDoseVolumesOnly, bool);
   vtkBooleanMacro(ShowDoseVolumesOnly, bool);
 
+  /// Get/Set flag whether isodose surfaces are only generated within \sa RegionOfInterestBounds
+  vtkGetMacro(UseRegionOfInterest, bool);
+  vtkSetMacro(UseRegionOfInterest, bool);
+  vtkBooleanMacro(UseRegionOfInterest, bool);
+
+  /// Get/Set region of interest box (xmin, xmax, ymin, ymax, zmin, zmax) in the RAS
+  /// coordinate system of the dose volume. Only used if \sa UseRegionOfInterest is on
+  vtkGetVector6Macro(RegionOfInterestBounds, double);
+  vtkSetVector6Macro(RegionOfInterestBounds, double);
+
+  /// Get/Set flag whether isodose lines are contoured directly on the slice views from a
+  /// multi-resolution dose pyramid instead of being shown as the cross-section of the isodose surfaces
+  vtkGetMacro(GenerateSliceIsolines, bool);
+  vtkSetMacro(GenerateSliceIsolines, bool);
+  vtkBooleanMacro(GenerateSliceIsolines, bool);
+
 protected:
   vtkMRMLIsodoseNode();
   ~vtkMRMLIsodoseNode();
@@ -115,6 +131,15 @@ protected:
 
   /// State of Show dose volumes only checkbox
   bool ShowDoseVolumesOnly;
+
+  /// Flag whether isodose generation is restricted to the region of interest
+  bool UseRegionOfInterest;
+
+  /// Region of interest box in dose volume RAS coordinates
+  double RegionOfInterestBounds[6];
+
+  /// Flag whether isodose lines are generated on the slice planes
+  bool GenerateSliceIsolines;
 };
 
 #endif
@@ -37,6 +37,7 @@
 #include <vtkMRMLModelNode.h>
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLScene.h>
+#include <vtkMRMLSliceNode.h>
 #include <vtkMRMLTransformNode.h>
 #include <vtkMRMLScalarVolumeDisplayNode.h>
 
@@ -44,23 +45,42 @@
 #include <vtkMRMLColorLogic.h>
 
 // VTK includes
+#include <vtkCellArray.h>
 #include <vtkColorTransferFunction.h>
+#include <vtkDataArray.h>
 #include <vtkDecimatePro.h>
+#include <vtkFlyingEdges2D.h>
+#include <vtkFlyingEdges3D.h>
+#include <vtkFloatArray.h>
 #include <vtkGeneralTransform.h>
 #include <vtkImageChangeInformation.h>
+#include <vtkIdList.h>
+#include <vtkImageClip.h>
 #include <vtkImageData.h>
-#include <vtkImageMarchingCubes.h>
 #include <vtkImageReslice.h>
+#include <vtkImageShrink3D.h>
+#include <vtkLinearExtrusionFilter.h>
 #include <vtkLookupTable.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataNormals.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
+#include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
-#include <vtkTriangleFilter.h>
+#include <vtkWeakPointer.h>
 #include <vtkWindowedSincPolyDataFilter.h>
 #include "vtksys/SystemTools.hxx"
 
+// STD includes
+#include <algorithm>
+#include <array>
+#include <map>
+
 //----------------------------------------------------------------------------
 const char* DEFAULT_ISODOSE_COLOR_TABLE_FILE_NAME = "Isodose_ColorTable.ctbl";
 const char* DEFAULT_ISODOSE_COLOR_TABLE_NODE_NAME = "Isodose_ColorTable_Default";
@@ -68,15 +88,514 @@ const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_MODEL_NODE_NAME_PREFIX =
 const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_PARAMETER_SET_BASE_NAME_PREFIX = "IsodoseParameterSet_";
 const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_ROOT_HIERARCHY_NAME_POSTFIX = "_IsodoseSurfaces";
 const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_COLOR_TABLE_NODE_NAME_POSTFIX = "_IsodoseColorTable";
+const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_SLICE_ISOLINES_MODEL_NODE_NAME_POSTFIX = "_IsodoseLines";
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// Size of the bricks (in cells along each axis) for which the dose range is indexed
+const int ISODOSE_BRICK_SIZE = 8;
+
+//----------------------------------------------------------------------------
+/// Maximum number of levels in the dose pyramid used for slice isolines (including full resolution)
+const unsigned int ISODOSE_PYRAMID_MAXIMUM_NUMBER_OF_LEVELS = 5;
+
+/// An axis of a dose pyramid level is only downsampled further if it has at least this many voxels
+const int ISODOSE_PYRAMID_MINIMUM_DIMENSION = 16;
+
+/// Name of the point scalar array of slice isolines containing the index of the isodose color
+const char* ISODOSE_LEVEL_INDEX_ARRAY_NAME = "IsodoseLevelIndex";
+
+//----------------------------------------------------------------------------
+/// Scalar range of each brick of an image. Each brick also contains the first voxel layer
+/// of the next brick, so that every marching cell is entirely within one brick.
+struct BrickScalarRangeIndex
+{
+  int Extent[6];
+  int BrickDimensions[3];
+  std::vector<double> Minimum;
+  std::vector<double> Maximum;
+};
+
+//----------------------------------------------------------------------------
+template<class T>
+void ComputeBrickScalarRanges(const T* scalars, int numberOfComponents, BrickScalarRangeIndex& index)
+{
+  const int* extent = index.Extent;
+  const int* brickDimensions = index.BrickDimensions;
+  vtkIdType dimensionX = extent[1] - extent[0] + 1;
+  vtkIdType dimensionY = extent[3] - extent[2] + 1;
+
+  vtkSMPTools::For(0, brickDimensions[2], [&](vtkIdType brickZBegin, vtkIdType brickZEnd)
+  {
+    for (vtkIdType brickZ = brickZBegin; brickZ < brickZEnd; ++brickZ)
+    {
+      int kBegin = extent[4] + brickZ * ISODOSE_BRICK_SIZE;
+      int kEnd = std::min(kBegin + ISODOSE_BRICK_SIZE, extent[5]);
+      for (int brickY = 0; brickY < brickDimensions[1]; ++brickY)
+      {
+        int jBegin = extent[2] + brickY * ISODOSE_BRICK_SIZE;
+        int jEnd = std::min(jBegin + ISODOSE_BRICK_SIZE, extent[3]);
+        for (int brickX = 0; brickX < brickDimensions[0]; ++brickX)
+        {
+          int iBegin = extent[0] + brickX * ISODOSE_BRICK_SIZE;
+          int iEnd = std::min(iBegin + ISODOSE_BRICK_SIZE, extent[1]);
+
+          double minimum = VTK_DOUBLE_MAX;
+          double maximum = VTK_DOUBLE_MIN;
+          for (int k = kBegin; k <= kEnd; ++k)
+          {
+            for (int j = jBegin; j <= jEnd; ++j)
+            {
+              const T* voxelPtr = scalars + (((k - extent[4]) * dimensionY + (j - extent[2])) * dimensionX + (iBegin - extent[0])) * numberOfComponents;
+              for (int i = iBegin; i <= iEnd; ++i, voxelPtr += numberOfComponents)
+              {
+                double value = static_cast<double>(*voxelPtr);
+                minimum = std::min(minimum, value);
+                maximum = std::max(maximum, value);
+              }
+            }
+          }
+          vtkIdType brickIndex = (brickZ * brickDimensions[1] + brickY) * brickDimensions[0] + brickX;
+          index.Minimum[brickIndex] = minimum;
+          index.Maximum[brickIndex] = maximum;
+        }
+      }
+    }
+  });
+}
+
+//----------------------------------------------------------------------------
+/// Compute scalar range of each brick of the image in one threaded pass
+void ComputeBrickScalarRangeIndex(vtkImageData* image, BrickScalarRangeIndex& index)
+{
+  image->GetExtent(index.Extent);
+  vtkIdType numberOfBricks = 1;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    int numberOfCells = index.Extent[2*axis+1] - index.Extent[2*axis];
+    index.BrickDimensions[axis] = std::max(1, (numberOfCells + ISODOSE_BRICK_SIZE - 1) / ISODOSE_BRICK_SIZE);
+    numberOfBricks *= index.BrickDimensions[axis];
+  }
+  index.Minimum.assign(numberOfBricks, 0.0);
+  index.Maximum.assign(numberOfBricks, 0.0);
+
+  void* scalars = image->GetScalarPointer();
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+  switch (image->GetScalarType())
+  {
+    vtkTemplateMacro(ComputeBrickScalarRanges(static_cast<const VTK_TT*>(scalars), numberOfComponents, index));
+  }
+}
+
+//----------------------------------------------------------------------------
+/// Get the voxel extent covering all bricks whose scalar range contains the contour value
+/// \return False if no brick can contain the isosurface
+bool GetContourValueExtent(const BrickScalarRangeIndex& index, double value, int valueExtent[6])
+{
+  int brickRange[6] = { VTK_INT_MAX, -1, VTK_INT_MAX, -1, VTK_INT_MAX, -1 };
+  vtkIdType brickIndex = 0;
+  for (int brickZ = 0; brickZ < index.BrickDimensions[2]; ++brickZ)
+  {
+    for (int brickY = 0; brickY < index.BrickDimensions[1]; ++brickY)
+    {
+      for (int brickX = 0; brickX < index.BrickDimensions[0]; ++brickX, ++brickIndex)
+      {
+        if (index.Minimum[brickIndex] > value || index.Maximum[brickIndex] < value)
+        {
+          continue;
+        }
+        brickRange[0] = std::min(brickRange[0], brickX);
+        brickRange[1] = std::max(brickRange[1], brickX);
+        brickRange[2] = std::min(brickRange[2], brickY);
+        brickRange[3] = std::max(brickRange[3], brickY);
+        brickRange[4] = std::min(brickRange[4], brickZ);
+        brickRange[5] = std::max(brickRange[5], brickZ);
+      }
+    }
+  }
+  if (brickRange[1] < 0)
+  {
+    return false;
+  }
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    valueExtent[2*axis] = index.Extent[2*axis] + brickRange[2*axis] * ISODOSE_BRICK_SIZE;
+    valueExtent[2*axis+1] = std::min(index.Extent[2*axis] + (brickRange[2*axis+1] + 1) * ISODOSE_BRICK_SIZE, index.Extent[2*axis+1]);
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Intersect extents. \return False if the intersection is empty
+bool IntersectExtents(const int extent1[6], const int extent2[6], int intersection[6])
+{
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    intersection[2*axis] = std::max(extent1[2*axis], extent2[2*axis]);
+    intersection[2*axis+1] = std::min(extent1[2*axis+1], extent2[2*axis+1]);
+    if (intersection[2*axis] > intersection[2*axis+1])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType GetNumberOfVoxelsInExtent(const int extent[6])
+{
+  return static_cast<vtkIdType>(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+}
+
+//----------------------------------------------------------------------------
+/// Contour image within the given extent for multiple values in one threaded filter execution.
+/// The point scalars of the output are the contour values.
+vtkSmartPointer<vtkPolyData> ContourImageExtent(vtkImageData* image, const int extent[6], const std::vector<double>& contourValues)
+{
+  vtkSmartPointer<vtkImageData> contourInput = image;
+  int* imageExtent = image->GetExtent();
+  if ( extent[0] != imageExtent[0] || extent[1] != imageExtent[1] || extent[2] != imageExtent[2]
+    || extent[3] != imageExtent[3] || extent[4] != imageExtent[4] || extent[5] != imageExtent[5] )
+  {
+    vtkSmartPointer<vtkImageClip> clip = vtkSmartPointer<vtkImageClip>::New();
+    clip->SetInputData(image);
+    clip->SetOutputWholeExtent(const_cast<int*>(extent));
+    clip->ClipDataOn();
+    clip->Update();
+    contourInput = clip->GetOutput();
+  }
+
+  vtkSmartPointer<vtkFlyingEdges3D> flyingEdges = vtkSmartPointer<vtkFlyingEdges3D>::New();
+  flyingEdges->SetInputData(contourInput);
+  flyingEdges->SetNumberOfContours(contourValues.size());
+  for (unsigned int valueIndex = 0; valueIndex < contourValues.size(); ++valueIndex)
+  {
+    flyingEdges->SetValue(valueIndex, contourValues[valueIndex]);
+  }
+  flyingEdges->ComputeScalarsOn();
+  flyingEdges->ComputeGradientsOff();
+  flyingEdges->ComputeNormalsOff();
+  flyingEdges->InterpolateAttributesOff();
+  flyingEdges->Update();
+  return flyingEdges->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+/// Get index of the contour value closest to the given value
+int GetContourValueIndex(const std::vector<double>& contourValues, double value)
+{
+  std::vector<double>::const_iterator valueIt = std::lower_bound(contourValues.begin(), contourValues.end(), value);
+  if (valueIt == contourValues.end())
+  {
+    return static_cast<int>(contourValues.size()) - 1;
+  }
+  int index = static_cast<int>(valueIt - contourValues.begin());
+  if (index > 0 && value - contourValues[index-1] < (*valueIt) - value)
+  {
+    --index;
+  }
+  return index;
+}
+
+//----------------------------------------------------------------------------
+/// Split multi-valued contour filter output into one poly data per contour value.
+/// Each point of the contour output lies on exactly one isosurface and its scalar is the
+/// contour value, so each polygon is assigned based on its points.
+void SplitContoursByValue(vtkPolyData* contours, const std::vector<double>& contourValues,
+  std::vector<vtkSmartPointer<vtkPolyData> >& contourPolyDatas)
+{
+  int numberOfValues = contourValues.size();
+  contourPolyDatas.clear();
+  contourPolyDatas.resize(numberOfValues);
+
+  vtkPoints* points = contours->GetPoints();
+  vtkDataArray* scalars = contours->GetPointData()->GetScalars();
+  if (!points || !scalars || numberOfValues == 0)
+  {
+    return;
+  }
+
+  std::vector<vtkSmartPointer<vtkPoints> > valuePoints(numberOfValues);
+  std::vector<vtkSmartPointer<vtkCellArray> > valuePolys(numberOfValues);
+  for (int valueIndex=0; valueIndex<numberOfValues; ++valueIndex)
+  {
+    valuePoints[valueIndex] = vtkSmartPointer<vtkPoints>::New();
+    valuePoints[valueIndex]->SetDataType(points->GetDataType());
+    valuePolys[valueIndex] = vtkSmartPointer<vtkCellArray>::New();
+  }
+
+  // Distribute points and renumber them within their isosurface
+  vtkIdType numberOfPoints = contours->GetNumberOfPoints();
+  std::vector<int> pointValueIndices(numberOfPoints, 0);
+  std::vector<vtkIdType> valuePointIds(numberOfPoints, 0);
+  for (vtkIdType pointId=0; pointId<numberOfPoints; ++pointId)
+  {
+    int valueIndex = GetContourValueIndex(contourValues, scalars->GetTuple1(pointId));
+    pointValueIndices[pointId] = valueIndex;
+    valuePointIds[pointId] = valuePoints[valueIndex]->InsertNextPoint(points->GetPoint(pointId));
+  }
+
+  // Distribute polygons
+  vtkSmartPointer<vtkIdList> cellPointIds = vtkSmartPointer<vtkIdList>::New();
+  vtkCellArray* polys = contours->GetPolys();
+  polys->InitTraversal();
+  while (polys->GetNextCell(cellPointIds))
+  {
+    vtkIdType numberOfCellPoints = cellPointIds->GetNumberOfIds();
+    if (numberOfCellPoints == 0)
+    {
+      continue;
+    }
+    int valueIndex = pointValueIndices[cellPointIds->GetId(0)];
+    vtkCellArray* valuePolyArray = valuePolys[valueIndex];
+    valuePolyArray->InsertNextCell(numberOfCellPoints);
+    for (vtkIdType i=0; i<numberOfCellPoints; ++i)
+    {
+      valuePolyArray->InsertCellPoint(valuePointIds[cellPointIds->GetId(i)]);
+    }
+  }
+
+  for (int valueIndex=0; valueIndex<numberOfValues; ++valueIndex)
+  {
+    if (valuePolys[valueIndex]->GetNumberOfCells() == 0)
+    {
+      continue;
+    }
+    contourPolyDatas[valueIndex] = vtkSmartPointer<vtkPolyData>::New();
+    contourPolyDatas[valueIndex]->SetPoints(valuePoints[valueIndex]);
+    contourPolyDatas[valueIndex]->SetPolys(valuePolys[valueIndex]);
+  }
+}
+
+//----------------------------------------------------------------------------
+/// Decimate, smooth, and compute normals for an isosurface in IJK space, then transform it to RAS.
+/// Only uses its own filter instances, so it can be called for several isosurfaces concurrently.
+vtkSmartPointer<vtkPolyData> PostProcessIsosurface(vtkPolyData* isoPolyData, vtkMatrix4x4* ijkToRasMatrix)
+{
+  vtkSmartPointer<vtkDecimatePro> decimate = vtkSmartPointer<vtkDecimatePro>::New();
+  decimate->SetInputData(isoPolyData);
+  decimate->SetTargetReduction(0.6);
+  decimate->SetFeatureAngle(60);
+  decimate->SplittingOff();
+  decimate->PreserveTopologyOn();
+  decimate->SetMaximumError(1);
+  decimate->Update();
+
+  vtkSmartPointer<vtkWindowedSincPolyDataFilter> smootherSinc = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
+  smootherSinc->SetPassBand(0.1);
+  smootherSinc->SetInputData(decimate->GetOutput() );
+  smootherSinc->SetNumberOfIterations(2);
+  smootherSinc->FeatureEdgeSmoothingOff();
+  smootherSinc->BoundarySmoothingOff();
+  smootherSinc->Update();
+
+  vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
+  normals->SetInputData(smootherSinc->GetOutput());
+  normals->ComputePointNormalsOn();
+  normals->SetFeatureAngle(60);
+  normals->Update();
+
+  vtkSmartPointer<vtkTransform> inputIJKToRASTransform = vtkSmartPointer<vtkTransform>::New();
+  inputIJKToRASTransform->Identity();
+  inputIJKToRASTransform->SetMatrix(ijkToRasMatrix);
+
+  vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+  transformPolyData->SetInputData(normals->GetOutput());
+  transformPolyData->SetTransform(inputIJKToRASTransform);
+  transformPolyData->Update();
+
+  return transformPolyData->GetOutput();
+}
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerIsodoseModuleLogic::vtkInternal
+{
+public:
+  /// Dose image and its downsampled versions, each level having half the resolution of the previous one
+  struct DosePyramid
+  {
+    vtkWeakPointer<vtkImageData> ImageData;
+    vtkMTimeType ImageDataMTime{0};
+    std::vector<vtkSmartPointer<vtkImageData> > Levels;
+  };
+
+  /// Get pyramid of a dose volume. The pyramid is (re)built if the dose image changed since last call
+  DosePyramid& GetDosePyramid(vtkMRMLScalarVolumeNode* doseVolumeNode);
+
+  /// Slice plane, view size, and visibility of a slice view
+  struct SliceViewState
+  {
+    double XYToRAS[16];
+    int Dimensions[3];
+    bool Visible;
+  };
+
+  /// Store the state of a slice view
+  /// \return True if the slice plane, the view size, or the visibility changed since the last call
+  bool UpdateSliceViewState(vtkMRMLSliceNode* sliceNode);
+
+  /// Parameters of an isodose node the slice isolines are generated from
+  struct IsolineParameters
+  {
+    bool GenerateSliceIsolines{false};
+    std::string DoseVolumeNodeID;
+    std::string ColorTableNodeID;
+    vtkMTimeType ColorTableMTime{0};
+
+    bool operator==(const IsolineParameters& other) const
+    {
+      return GenerateSliceIsolines == other.GenerateSliceIsolines && DoseVolumeNodeID == other.DoseVolumeNodeID
+        && ColorTableNodeID == other.ColorTableNodeID && ColorTableMTime == other.ColorTableMTime;
+    }
+  };
+
+  /// Get the parameters of an isodose node the slice isolines are generated from
+  static IsolineParameters GetIsolineParameters(vtkMRMLIsodoseNode* parameterNode);
+
+  /// Show or hide the slice isolines of an isodose parameter node without generating them again
+  void SetSliceIsolinesVisibility(vtkMRMLIsodoseNode* parameterNode, bool visible);
+
+public:
+  /// Dose pyramids by dose volume node ID
+  std::map<std::string, DosePyramid> DosePyramids;
+
+  /// Slice isoline model nodes by isodose parameter node ID and slice node ID
+  std::map<std::pair<std::string, std::string>, vtkWeakPointer<vtkMRMLModelNode> > SliceIsolineModelNodes;
+
+  /// Slice view states the isolines were last updated for, by slice node ID
+  std::map<std::string, SliceViewState> SliceViewStates;
+
+  /// Parameters the slice isolines were last generated from, by isodose parameter node ID
+  std::map<std::string, IsolineParameters> SliceIsolineParameters;
+};
+
+//----------------------------------------------------------------------------
+bool vtkSlicerIsodoseModuleLogic::vtkInternal::UpdateSliceViewState(vtkMRMLSliceNode* sliceNode)
+{
+  SliceViewState state;
+  vtkMatrix4x4* xyToRasMatrix = sliceNode->GetXYToRAS();
+  for (int element = 0; element < 16; ++element)
+  {
+    state.XYToRAS[element] = xyToRasMatrix->GetElement(element / 4, element % 4);
+  }
+  sliceNode->GetDimensions(state.Dimensions);
+  state.Visible = sliceNode->IsViewVisibleInLayout();
+
+  std::map<std::string, SliceViewState>::iterator stateIt = this->SliceViewStates.find(sliceNode->GetID());
+  if ( stateIt != this->SliceViewStates.end() && stateIt->second.Visible == state.Visible
+    && std::equal(state.XYToRAS, state.XYToRAS + 16, stateIt->second.XYToRAS)
+    && std::equal(state.Dimensions, state.Dimensions + 3, stateIt->second.Dimensions) )
+  {
+    return false;
+  }
+  this->SliceViewStates[sliceNode->GetID()] = state;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerIsodoseModuleLogic::vtkInternal::IsolineParameters vtkSlicerIsodoseModuleLogic::vtkInternal::GetIsolineParameters(
+  vtkMRMLIsodoseNode* parameterNode)
+{
+  IsolineParameters parameters;
+  parameters.GenerateSliceIsolines = parameterNode->GetGenerateSliceIsolines();
+  vtkMRMLScalarVolumeNode* doseVolumeNode = parameterNode->GetDoseVolumeNode();
+  if (doseVolumeNode && doseVolumeNode->GetID())
+  {
+    parameters.DoseVolumeNodeID = doseVolumeNode->GetID();
+  }
+  vtkMRMLColorTableNode* colorTableNode = parameterNode->GetColorTableNode();
+  if (colorTableNode && colorTableNode->GetID())
+  {
+    parameters.ColorTableNodeID = colorTableNode->GetID();
+    parameters.ColorTableMTime = colorTableNode->GetMTime();
+  }
+  return parameters;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::vtkInternal::SetSliceIsolinesVisibility(vtkMRMLIsodoseNode* parameterNode, bool visible)
+{
+  for (std::pair<const std::pair<std::string, std::string>, vtkWeakPointer<vtkMRMLModelNode> >& modelNodeEntry : this->SliceIsolineModelNodes)
+  {
+    vtkMRMLModelNode* modelNode = modelNodeEntry.second;
+    if (modelNodeEntry.first.first == parameterNode->GetID() && modelNode && modelNode->GetDisplayNode())
+    {
+      modelNode->GetDisplayNode()->SetVisibility(visible);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerIsodoseModuleLogic::vtkInternal::DosePyramid& vtkSlicerIsodoseModuleLogic::vtkInternal::GetDosePyramid(
+  vtkMRMLScalarVolumeNode* doseVolumeNode)
+{
+  vtkImageData* imageData = doseVolumeNode->GetImageData();
+  DosePyramid& pyramid = this->DosePyramids[doseVolumeNode->GetID()];
+  if (!pyramid.Levels.empty() && pyramid.ImageData == imageData && pyramid.ImageDataMTime == imageData->GetMTime())
+  {
+    return pyramid;
+  }
+
+  pyramid.ImageData = imageData;
+  pyramid.ImageDataMTime = imageData->GetMTime();
+  pyramid.Levels.clear();
+  pyramid.Levels.push_back(imageData);
+  while (pyramid.Levels.size() < ISODOSE_PYRAMID_MAXIMUM_NUMBER_OF_LEVELS)
+  {
+    vtkImageData* previousLevel = pyramid.Levels.back();
+    int dimensions[3] = { 0, 0, 0 };
+    previousLevel->GetDimensions(dimensions);
+    int shrinkFactors[3] = { 1, 1, 1 };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      if (dimensions[axis] >= ISODOSE_PYRAMID_MINIMUM_DIMENSION)
+      {
+        shrinkFactors[axis] = 2;
+      }
+    }
+    if (shrinkFactors[0] == 1 && shrinkFactors[1] == 1 && shrinkFactors[2] == 1)
+    {
+      break;
+    }
+
+    vtkNew<vtkImageShrink3D> shrink;
+    shrink->SetInputData(previousLevel);
+    shrink->SetShrinkFactors(shrinkFactors);
+    shrink->AveragingOn();
+    shrink->Update();
+
+    // The shrink filter places each output voxel on the first of the averaged input voxels,
+    // move it to their center so that the levels are aligned
+    vtkSmartPointer<vtkImageData> level = vtkSmartPointer<vtkImageData>::New();
+    level->ShallowCopy(shrink->GetOutput());
+    double* previousSpacing = previousLevel->GetSpacing();
+    double* levelOrigin = level->GetOrigin();
+    level->SetOrigin(
+      levelOrigin[0] + 0.5 * (shrinkFactors[0] - 1) * previousSpacing[0],
+      levelOrigin[1] + 0.5 * (shrinkFactors[1] - 1) * previousSpacing[1],
+      levelOrigin[2] + 0.5 * (shrinkFactors[2] - 1) * previousSpacing[2] );
+    pyramid.Levels.push_back(level);
+  }
+
+  return pyramid;
+}
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerIsodoseModuleLogic);
 
 //----------------------------------------------------------------------------
-vtkSlicerIsodoseModuleLogic::vtkSlicerIsodoseModuleLogic() = default;
+vtkSlicerIsodoseModuleLogic::vtkSlicerIsodoseModuleLogic()
+{
+  this->Internal = new vtkInternal;
+}
 
 //----------------------------------------------------------------------------
-vtkSlicerIsodoseModuleLogic::~vtkSlicerIsodoseModuleLogic() = default;
+vtkSlicerIsodoseModuleLogic::~vtkSlicerIsodoseModuleLogic()
+{
+  delete this->Internal;
+}
 
 //----------------------------------------------------------------------------
 void vtkSlicerIsodoseModuleLogic::PrintSelf(ostream& os, vtkIndent indent)
@@ -135,6 +654,24 @@ void vtkSlicerIsodoseModuleLogic::UpdateFromMRMLScene()
     return;
   }
 
+  // Observe slice nodes to update slice isolines, and isodose nodes to turn them on and off
+  std::vector<vtkMRMLNode*> sliceAndIsodoseNodes;
+  this->GetMRMLScene()->GetNodesByClass("vtkMRMLSliceNode", sliceAndIsodoseNodes);
+  std::vector<vtkMRMLNode*> isodoseNodes;
+  this->GetMRMLScene()->GetNodesByClass("vtkMRMLIsodoseNode", isodoseNodes);
+  sliceAndIsodoseNodes.insert(sliceAndIsodoseNodes.end(), isodoseNodes.begin(), isodoseNodes.end());
+  for (vtkMRMLNode* node : sliceAndIsodoseNodes)
+  {
+    if (!vtkIsObservedMRMLNodeEventMacro(node, vtkCommand::ModifiedEvent))
+    {
+      vtkObserveMRMLNodeMacro(node);
+    }
+  }
+  for (vtkMRMLNode* node : isodoseNodes)
+  {
+    this->UpdateSliceIsolines(vtkMRMLIsodoseNode::SafeDownCast(node));
+  }
+
   this->Modified();
 }
 
@@ -147,6 +684,11 @@ void vtkSlicerIsodoseModuleLogic::OnMRMLSceneEndClose()
     return;
   }
 
+  this->ClearDosePyramidCache();
+  this->Internal->SliceIsolineModelNodes.clear();
+  this->Internal->SliceViewStates.clear();
+  this->Internal->SliceIsolineParameters.clear();
+
   this->Modified();
 }
 
@@ -159,6 +701,13 @@ void vtkSlicerIsodoseModuleLogic::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
     return;
   }
 
+  // Observe slice nodes to update slice isolines, and isodose nodes to turn them on and off
+  if ( (node->IsA("vtkMRMLSliceNode") || node->IsA("vtkMRMLIsodoseNode"))
+    && !vtkIsObservedMRMLNodeEventMacro(node, vtkCommand::ModifiedEvent) )
+  {
+    vtkObserveMRMLNodeMacro(node);
+  }
+
   // if the scene is still updating, jump out
   if (this->GetMRMLScene()->IsBatchProcessing())
   {
@@ -180,6 +729,27 @@ void vtkSlicerIsodoseModuleLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
     return;
   }
 
+  if (node->IsA("vtkMRMLSliceNode") || node->IsA("vtkMRMLIsodoseNode"))
+  {
+    vtkUnObserveMRMLNodeMacro(node);
+  }
+  if (node->IsA("vtkMRMLIsodoseNode"))
+  {
+    this->RemoveSliceIsolines(vtkMRMLIsodoseNode::SafeDownCast(node));
+    if (node->GetID())
+    {
+      this->Internal->SliceIsolineParameters.erase(node->GetID());
+    }
+  }
+  else if (node->IsA("vtkMRMLSliceNode") && node->GetID())
+  {
+    this->Internal->SliceViewStates.erase(node->GetID());
+  }
+  else if (node->IsA("vtkMRMLScalarVolumeNode") && node->GetID())
+  {
+    this->Internal->DosePyramids.erase(node->GetID());
+  }
+
   // if the scene is still updating, jump out
   if (this->GetMRMLScene()->IsBatchProcessing())
   {
@@ -192,6 +762,60 @@ void vtkSlicerIsodoseModuleLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
   }
 }
 
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+  this->Superclass::ProcessMRMLNodesEvents(caller, event, callData);
+
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene)
+  {
+    vtkErrorMacro("ProcessMRMLNodesEvents: Invalid MRML scene");
+    return;
+  }
+  if (scene->IsBatchProcessing() || event != vtkCommand::ModifiedEvent)
+  {
+    return;
+  }
+
+  vtkMRMLSliceNode* sliceNode = vtkMRMLSliceNode::SafeDownCast(caller);
+  vtkMRMLIsodoseNode* isodoseNode = vtkMRMLIsodoseNode::SafeDownCast(caller);
+  if (sliceNode)
+  {
+    // Slice nodes are modified for many reasons (e.g. interaction or display settings). Isolines are only
+    // updated if the slice plane, the view size, or the visibility of the view changed, and the view is shown
+    if (!this->Internal->UpdateSliceViewState(sliceNode) || !sliceNode->IsViewVisibleInLayout())
+    {
+      return;
+    }
+    std::vector<vtkMRMLNode*> isodoseNodes;
+    scene->GetNodesByClass("vtkMRMLIsodoseNode", isodoseNodes);
+    for (vtkMRMLNode* node : isodoseNodes)
+    {
+      vtkMRMLIsodoseNode* parameterNode = vtkMRMLIsodoseNode::SafeDownCast(node);
+      if ( parameterNode->GetGenerateSliceIsolines() && parameterNode->GetColorTableNode()
+        && parameterNode->GetDoseVolumeNode() && parameterNode->GetDoseVolumeNode()->GetImageData() )
+      {
+        this->UpdateSliceIsolines(parameterNode, sliceNode);
+      }
+    }
+  }
+  else if (isodoseNode)
+  {
+    // Contour again only if the parameters the isolines are generated from changed, otherwise
+    // only their visibility may have changed
+    std::map<std::string, vtkInternal::IsolineParameters>::iterator parametersIt =
+      this->Internal->SliceIsolineParameters.find(isodoseNode->GetID());
+    if ( parametersIt != this->Internal->SliceIsolineParameters.end()
+      && parametersIt->second == vtkInternal::GetIsolineParameters(isodoseNode) )
+    {
+      this->Internal->SetSliceIsolinesVisibility(isodoseNode, isodoseNode->GetShowIsodoseLines());
+      return;
+    }
+    this->UpdateSliceIsolines(isodoseNode);
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkIdType vtkSlicerIsodoseModuleLogic::GetIsodoseFolderItemID(vtkMRMLNode* node)
 {
@@ -536,7 +1160,7 @@ void vtkSlicerIsodoseModuleLogic::CreateIsodoseSurfaces(vtkMRMLIsodoseNode* para
   }
 
   // Progress
-  int progressStepCount = colorTableNode->GetNumberOfColors() + 1 /* reslice step */;
+  int progressStepCount = colorTableNode->GetNumberOfColors() + 2 /* reslice and contouring steps */;
   int currentProgressStep = 0;
 
   // Reslice dose volume
@@ -561,81 +1185,206 @@ void vtkSlicerIsodoseModuleLogic::CreateIsodoseSurfaces(vtkMRMLIsodoseNode* para
   outputIJK2IJKResliceTransform->Concatenate(inputRAS2IJKMatrix);
   outputIJK2IJKResliceTransform->Inverse();
 
-  int dimensions[3] = {0, 0, 0};
-  doseVolumeNode->GetImageData()->GetDimensions(dimensions);
-  vtkSmartPointer<vtkImageReslice> reslice = vtkSmartPointer<vtkImageReslice>::New();
-  reslice->SetInputData(doseVolumeNode->GetImageData());
-  reslice->SetOutputOrigin(0, 0, 0);
-  reslice->SetOutputSpacing(1, 1, 1);
-  reslice->SetOutputExtent(0, dimensions[0]-1, 0, dimensions[1]-1, 0, dimensions[2]-1);
-  reslice->SetResliceTransform(outputIJK2IJKResliceTransform);
-  reslice->Update();
-  vtkSmartPointer<vtkImageData> reslicedDoseVolumeImage = reslice->GetOutput(); 
+  // Reslicing is only needed if the dose volume is transformed. Otherwise the IJK image is used directly
+  vtkImageData* doseImageData = doseVolumeNode->GetImageData();
+  int* doseImageExtent = doseImageData->GetExtent();
+  double* doseImageOrigin = doseImageData->GetOrigin();
+  double* doseImageSpacing = doseImageData->GetSpacing();
+  bool identityGeometry = ( doseImageExtent[0] == 0 && doseImageExtent[2] == 0 && doseImageExtent[4] == 0
+    && doseImageOrigin[0] == 0.0 && doseImageOrigin[1] == 0.0 && doseImageOrigin[2] == 0.0
+    && doseImageSpacing[0] == 1.0 && doseImageSpacing[1] == 1.0 && doseImageSpacing[2] == 1.0 );
+  vtkMatrix4x4* outputIJK2IJKResliceMatrix = outputIJK2IJKResliceTransform->GetMatrix();
+  for (int row = 0; row < 4 && identityGeometry; ++row)
+  {
+    for (int column = 0; column < 4; ++column)
+    {
+      if (fabs(outputIJK2IJKResliceMatrix->GetElement(row, column) - (row == column ? 1.0 : 0.0)) > 1e-6)
+      {
+        identityGeometry = false;
+        break;
+      }
+    }
+  }
+
+  vtkSmartPointer<vtkImageData> reslicedDoseVolumeImage;
+  if (identityGeometry)
+  {
+    reslicedDoseVolumeImage = doseImageData;
+  }
+  else
+  {
+    int dimensions[3] = {0, 0, 0};
+    doseImageData->GetDimensions(dimensions);
+    vtkSmartPointer<vtkImageReslice> reslice = vtkSmartPointer<vtkImageReslice>::New();
+    reslice->SetInputData(doseImageData);
+    reslice->SetOutputOrigin(0, 0, 0);
+    reslice->SetOutputSpacing(1, 1, 1);
+    reslice->SetOutputExtent(0, dimensions[0]-1, 0, dimensions[1]-1, 0, dimensions[2]-1);
+    reslice->SetResliceTransform(outputIJK2IJKResliceTransform);
+    reslice->Update();
+    reslicedDoseVolumeImage = reslice->GetOutput();
+  }
 
   // Report progress
   ++currentProgressStep;
   double progress = (double)(currentProgressStep) / (double)progressStepCount;
   this->InvokeEvent(vtkSlicerRtCommon::ProgressUpdated, (void*)&progress);
 
-  // Create isodose surfaces
-  for (int i = 0; i < colorTableNode->GetNumberOfColors(); i++)
+  // Collect isodose levels. Levels that appear multiple times in the color table are contoured once
+  int numberOfIsoLevels = colorTableNode->GetNumberOfColors();
+  std::vector<double> contourValues;
+  for (int i = 0; i < numberOfIsoLevels; i++)
+  {
+    contourValues.push_back(vtkVariant(colorTableNode->GetColorName(i)).ToDouble());
+  }
+  std::sort(contourValues.begin(), contourValues.end());
+  contourValues.erase(std::unique(contourValues.begin(), contourValues.end()), contourValues.end());
+  int numberOfContourValues = contourValues.size();
+
+  // Restrict contouring to the region of interest if requested
+  int contourExtent[6] = {0, -1, 0, -1, 0, -1};
+  reslicedDoseVolumeImage->GetExtent(contourExtent);
+  bool contourExtentValid = (reslicedDoseVolumeImage->GetNumberOfPoints() > 0);
+  if (contourExtentValid && parameterNode->GetUseRegionOfInterest())
+  {
+    double* roiBounds = parameterNode->GetRegionOfInterestBounds();
+    double roiIjkBounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+    for (int corner = 0; corner < 8; ++corner)
+    {
+      double cornerRas[4] = { roiBounds[corner & 1], roiBounds[2 + ((corner >> 1) & 1)], roiBounds[4 + ((corner >> 2) & 1)], 1.0 };
+      double cornerIjk[4] = { 0.0, 0.0, 0.0, 1.0 };
+      inputRAS2IJKMatrix->MultiplyPoint(cornerRas, cornerIjk);
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        roiIjkBounds[2*axis] = std::min(roiIjkBounds[2*axis], cornerIjk[axis]);
+        roiIjkBounds[2*axis+1] = std::max(roiIjkBounds[2*axis+1], cornerIjk[axis]);
+      }
+    }
+    int roiExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      roiExtent[2*axis] = static_cast<int>(floor(roiIjkBounds[2*axis]));
+      roiExtent[2*axis+1] = static_cast<int>(ceil(roiIjkBounds[2*axis+1]));
+    }
+    int imageExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    reslicedDoseVolumeImage->GetExtent(imageExtent);
+    contourExtentValid = IntersectExtents(imageExtent, roiExtent, contourExtent);
+  }
+
+  // Index dose range of the bricks of the volume, and determine the region each isosurface can
+  // be in. High levels typically occupy a small fraction of the volume, so contouring them only
+  // within their own region is much faster than contouring them in the whole volume.
+  BrickScalarRangeIndex brickIndex;
+  std::vector<bool> contourValueActive(numberOfContourValues, false);
+  std::vector<std::array<int, 6> > contourValueExtents(numberOfContourValues);
+  int activeExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+  if (contourExtentValid)
+  {
+    ComputeBrickScalarRangeIndex(reslicedDoseVolumeImage, brickIndex);
+    for (int valueIndex = 0; valueIndex < numberOfContourValues; ++valueIndex)
+    {
+      int valueExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      if ( GetContourValueExtent(brickIndex, contourValues[valueIndex], valueExtent)
+        && IntersectExtents(valueExtent, contourExtent, contourValueExtents[valueIndex].data()) )
+      {
+        contourValueActive[valueIndex] = true;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          activeExtent[2*axis] = std::min(activeExtent[2*axis], contourValueExtents[valueIndex][2*axis]);
+          activeExtent[2*axis+1] = std::max(activeExtent[2*axis+1], contourValueExtents[valueIndex][2*axis+1]);
+        }
+      }
+    }
+  }
+
+  // Levels whose region is much smaller than the region of all levels are contoured separately,
+  // the others together in one threaded contouring pass. The point scalars of the contour output
+  // are the contour values, which identify the isosurface each triangle belongs to
+  std::vector<vtkSmartPointer<vtkPolyData> > contourPolyDatas(numberOfContourValues);
+  std::vector<double> sharedContourValues;
+  std::vector<int> sharedContourValueIndices;
+  for (int valueIndex = 0; valueIndex < numberOfContourValues; ++valueIndex)
+  {
+    if (!contourValueActive[valueIndex])
+    {
+      continue;
+    }
+    if (GetNumberOfVoxelsInExtent(contourValueExtents[valueIndex].data()) * 2 < GetNumberOfVoxelsInExtent(activeExtent))
+    {
+      std::vector<double> separateContourValue(1, contourValues[valueIndex]);
+      std::vector<vtkSmartPointer<vtkPolyData> > separateContourPolyData;
+      SplitContoursByValue(ContourImageExtent(reslicedDoseVolumeImage, contourValueExtents[valueIndex].data(), separateContourValue),
+        separateContourValue, separateContourPolyData);
+      contourPolyDatas[valueIndex] = separateContourPolyData[0];
+    }
+    else
+    {
+      sharedContourValues.push_back(contourValues[valueIndex]);
+      sharedContourValueIndices.push_back(valueIndex);
+    }
+  }
+  if (!sharedContourValues.empty())
+  {
+    std::vector<vtkSmartPointer<vtkPolyData> > sharedContourPolyDatas;
+    SplitContoursByValue(ContourImageExtent(reslicedDoseVolumeImage, activeExtent, sharedContourValues),
+      sharedContourValues, sharedContourPolyDatas);
+    for (unsigned int sharedIndex = 0; sharedIndex < sharedContourValues.size(); ++sharedIndex)
+    {
+      contourPolyDatas[sharedContourValueIndices[sharedIndex]] = sharedContourPolyDatas[sharedIndex];
+    }
+  }
+
+  // Post-process isosurfaces in parallel, one level per task. The filters of each level run
+  // single-threaded, so that their own SMP loops are not nested in the level loop
+  std::vector<vtkSmartPointer<vtkPolyData> > isodosePolyDatas(numberOfContourValues);
+  vtkSMPTools::Config levelLoopConfig;
+  levelLoopConfig.NestedParallelism = false;
+  vtkSMPTools::LocalScope(levelLoopConfig, [&]()
+  {
+    vtkSMPTools::For(0, numberOfContourValues, [&](vtkIdType begin, vtkIdType end)
+    {
+      for (vtkIdType valueIndex = begin; valueIndex < end; ++valueIndex)
+      {
+        if (contourPolyDatas[valueIndex] && contourPolyDatas[valueIndex]->GetNumberOfPoints() >= 1)
+        {
+          isodosePolyDatas[valueIndex] = PostProcessIsosurface(contourPolyDatas[valueIndex], inputIJK2RASMatrix);
+        }
+      }
+    });
+  });
+  contourPolyDatas.clear();
+
+  // Report progress
+  ++currentProgressStep;
+  progress = (double)(currentProgressStep) / (double)progressStepCount;
+  this->InvokeEvent(vtkSlicerRtCommon::ProgressUpdated, (void*)&progress);
+
+  // Create isodose model nodes
+  std::vector<bool> isodosePolyDataUsed(numberOfContourValues, false);
+  for (int i = 0; i < numberOfIsoLevels; i++)
   {
     double val[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
     const char* strIsoLevel = colorTableNode->GetColorName(i);
     double isoLevel = vtkVariant(strIsoLevel).ToDouble();
     colorTableNode->GetColor(i, val);
 
-    vtkSmartPointer<vtkImageMarchingCubes> marchingCubes = vtkSmartPointer<vtkImageMarchingCubes>::New();
-    marchingCubes->SetInputData(reslicedDoseVolumeImage);
-    marchingCubes->SetNumberOfContours(1); 
-    marchingCubes->SetValue(0, isoLevel);
-    marchingCubes->ComputeScalarsOff();
-    marchingCubes->ComputeGradientsOff();
-    marchingCubes->ComputeNormalsOff();
-    marchingCubes->Update();
-
-    vtkSmartPointer<vtkPolyData> isoPolyData= marchingCubes->GetOutput();
-    if (isoPolyData->GetNumberOfPoints() >= 1)
-    {
-      vtkSmartPointer<vtkTriangleFilter> triangleFilter = vtkSmartPointer<vtkTriangleFilter>::New();
-      triangleFilter->SetInputData(marchingCubes->GetOutput());
-      triangleFilter->Update();
-
-      vtkSmartPointer<vtkDecimatePro> decimate = vtkSmartPointer<vtkDecimatePro>::New();
-      decimate->SetInputData(triangleFilter->GetOutput());
-      decimate->SetTargetReduction(0.6);
-      decimate->SetFeatureAngle(60);
-      decimate->SplittingOff();
-      decimate->PreserveTopologyOn();
-      decimate->SetMaximumError(1);
-      decimate->Update();
-
-      vtkSmartPointer<vtkWindowedSincPolyDataFilter> smootherSinc = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
-      smootherSinc->SetPassBand(0.1);
-      smootherSinc->SetInputData(decimate->GetOutput() );
-      smootherSinc->SetNumberOfIterations(2);
-      smootherSinc->FeatureEdgeSmoothingOff();
-      smootherSinc->BoundarySmoothingOff();
-      smootherSinc->Update();
-
-      vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
-      normals->SetInputData(smootherSinc->GetOutput());
-      normals->ComputePointNormalsOn();
-      normals->SetFeatureAngle(60);
-      normals->Update();
-
-      vtkSmartPointer<vtkTransform> inputIJKToRASTransform = vtkSmartPointer<vtkTransform>::New();
-      inputIJKToRASTransform->Identity();
-      inputIJKToRASTransform->SetMatrix(inputIJK2RASMatrix);
-
-      vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-      transformPolyData->SetInputData(normals->GetOutput());
-      transformPolyData->SetTransform(inputIJKToRASTransform);
-      transformPolyData->Update();
-  
+    int valueIndex = GetContourValueIndex(contourValues, isoLevel);
+    vtkSmartPointer<vtkPolyData> isoPolyData = isodosePolyDatas[valueIndex];
+    if (isoPolyData && isodosePolyDataUsed[valueIndex])
+    {
+      // Same level used by multiple colors, each model needs its own poly data
+      vtkSmartPointer<vtkPolyData> isoPolyDataCopy = vtkSmartPointer<vtkPolyData>::New();
+      isoPolyDataCopy->DeepCopy(isoPolyData);
+      isoPolyData = isoPolyDataCopy;
+    }
+    isodosePolyDataUsed[valueIndex] = true;
+
+    if (isoPolyData)
+    {
       vtkSmartPointer<vtkMRMLModelDisplayNode> displayNode = vtkSmartPointer<vtkMRMLModelDisplayNode>::New();
       displayNode = vtkMRMLModelDisplayNode::SafeDownCast(scene->AddNode(displayNode));
-      displayNode->Visibility2DOn();  
+      // Cross-sections of the surfaces are not shown if isolines are generated directly on the slices
+      displayNode->SetVisibility2D(!parameterNode->GetGenerateSliceIsolines());
       displayNode->VisibilityOn(); 
       displayNode->SetColor(val[0], val[1], val[2]);
       displayNode->SetOpacity(val[3]);
@@ -654,7 +1403,7 @@ void vtkSlicerIsodoseModuleLogic::CreateIsodoseSurfaces(vtkMRMLIsodoseNode* para
       isodoseModelNode->SetAttribute(vtkSlicerRtCommon::DICOMRTIMPORT_ISODOSE_MODEL_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1"); // The attribute above distinguishes isodoses from regular models
       scene->AddNode(isodoseModelNode);
       isodoseModelNode->SetAndObserveDisplayNodeID(displayNode->GetID());
-      isodoseModelNode->SetAndObservePolyData(transformPolyData->GetOutput());
+      isodoseModelNode->SetAndObservePolyData(isoPolyData);
       shNode->RequestOwnerPluginSearch(isodoseModelNode); //TODO: Why is this needed?
 
       // Put the new node in the isodose folder
@@ -761,3 +1510,257 @@ void vtkSlicerIsodoseModuleLogic::UpdateDoseColorTableFromIsodose(vtkMRMLIsodose
   doseVolumeDisplayNode->SetLowerThreshold(0.5 * doseUnitValue);
   doseVolumeDisplayNode->SetApplyThreshold(1);
 }
+
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::UpdateSliceIsolines(vtkMRMLIsodoseNode* parameterNode, vtkMRMLSliceNode* sliceNode)
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene || !parameterNode || !sliceNode)
+  {
+    vtkErrorMacro("UpdateSliceIsolines: Invalid scene, parameter set node, or slice node");
+    return;
+  }
+  vtkMRMLScalarVolumeNode* doseVolumeNode = parameterNode->GetDoseVolumeNode();
+  if (!doseVolumeNode || !doseVolumeNode->GetImageData())
+  {
+    vtkErrorMacro("UpdateSliceIsolines: Invalid dose volume");
+    return;
+  }
+  vtkMRMLColorTableNode* colorTableNode = parameterNode->GetColorTableNode();
+  if (!colorTableNode)
+  {
+    vtkErrorMacro("UpdateSliceIsolines: Failed to get isodose color table node for dose volume " << doseVolumeNode->GetName());
+    return;
+  }
+
+  // Collect isodose levels, and the first color of each level
+  int numberOfIsoLevels = colorTableNode->GetNumberOfColors();
+  std::vector<double> contourValues;
+  for (int i = 0; i < numberOfIsoLevels; i++)
+  {
+    contourValues.push_back(vtkVariant(colorTableNode->GetColorName(i)).ToDouble());
+  }
+  std::sort(contourValues.begin(), contourValues.end());
+  contourValues.erase(std::unique(contourValues.begin(), contourValues.end()), contourValues.end());
+  std::vector<int> contourValueColorIndices(contourValues.size(), -1);
+  for (int i = numberOfIsoLevels - 1; i >= 0; i--)
+  {
+    contourValueColorIndices[GetContourValueIndex(contourValues, vtkVariant(colorTableNode->GetColorName(i)).ToDouble())] = i;
+  }
+
+  // Select the coarsest pyramid level that still has at least the resolution of the slice view
+  vtkInternal::DosePyramid& pyramid = this->Internal->GetDosePyramid(doseVolumeNode);
+  double* doseSpacing = doseVolumeNode->GetSpacing();
+  double* baseImageSpacing = pyramid.Levels[0]->GetSpacing();
+  int* sliceDimensions = sliceNode->GetDimensions();
+  double* fieldOfView = sliceNode->GetFieldOfView();
+  double pixelSize = std::min( fieldOfView[0] / std::max(sliceDimensions[0], 1),
+    fieldOfView[1] / std::max(sliceDimensions[1], 1) );
+  unsigned int levelIndex = 0;
+  double levelVoxelSize = std::min(doseSpacing[0], std::min(doseSpacing[1], doseSpacing[2]));
+  for (unsigned int currentLevelIndex = 1; currentLevelIndex < pyramid.Levels.size(); ++currentLevelIndex)
+  {
+    double* levelSpacing = pyramid.Levels[currentLevelIndex]->GetSpacing();
+    double currentLevelVoxelSize = VTK_DOUBLE_MAX;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      currentLevelVoxelSize = std::min(currentLevelVoxelSize, doseSpacing[axis] * levelSpacing[axis] / baseImageSpacing[axis]);
+    }
+    if (currentLevelVoxelSize > pixelSize)
+    {
+      break;
+    }
+    levelIndex = currentLevelIndex;
+    levelVoxelSize = currentLevelVoxelSize;
+  }
+  vtkImageData* levelImageData = pyramid.Levels[levelIndex];
+
+  // Transform from slice XY (pixel) coordinates to dose image coordinates
+  vtkNew<vtkMatrix4x4> ijkToImageMatrix;
+  double* baseImageOrigin = pyramid.Levels[0]->GetOrigin();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    ijkToImageMatrix->SetElement(axis, axis, baseImageSpacing[axis]);
+    ijkToImageMatrix->SetElement(axis, 3, baseImageOrigin[axis]);
+  }
+  vtkNew<vtkMatrix4x4> rasToIjkMatrix;
+  doseVolumeNode->GetRASToIJKMatrix(rasToIjkMatrix);
+  vtkNew<vtkMatrix4x4> worldToRasMatrix;
+  if (doseVolumeNode->GetParentTransformNode())
+  {
+    doseVolumeNode->GetParentTransformNode()->GetMatrixTransformFromWorld(worldToRasMatrix);
+  }
+  vtkNew<vtkMatrix4x4> xyToImageMatrix;
+  vtkMatrix4x4::Multiply4x4(worldToRasMatrix, sliceNode->GetXYToRAS(), xyToImageMatrix);
+  vtkMatrix4x4::Multiply4x4(rasToIjkMatrix, xyToImageMatrix, xyToImageMatrix);
+  vtkMatrix4x4::Multiply4x4(ijkToImageMatrix, xyToImageMatrix, xyToImageMatrix);
+
+  // Sample the dose on the slice plane at the voxel size of the pyramid level, but at most at the pixel size
+  double sampleSpacing = std::max(1.0, levelVoxelSize / pixelSize);
+  int sampleDimensions[2] = {
+    static_cast<int>(floor((sliceDimensions[0] - 1) / sampleSpacing)) + 1,
+    static_cast<int>(floor((sliceDimensions[1] - 1) / sampleSpacing)) + 1 };
+
+  vtkNew<vtkImageReslice> reslice;
+  reslice->SetInputData(levelImageData);
+  reslice->SetResliceAxes(xyToImageMatrix);
+  reslice->SetInterpolationModeToLinear();
+  reslice->SetOutputOrigin(0.0, 0.0, 0.0);
+  reslice->SetOutputSpacing(sampleSpacing, sampleSpacing, 1.0);
+  reslice->SetOutputExtent(0, sampleDimensions[0] - 1, 0, sampleDimensions[1] - 1, 0, 0);
+
+  // Contour all levels at once. The point scalars of the output are the contour values
+  vtkNew<vtkFlyingEdges2D> contour;
+  contour->SetInputConnection(reslice->GetOutputPort());
+  for (unsigned int valueIndex = 0; valueIndex < contourValues.size(); ++valueIndex)
+  {
+    contour->SetValue(valueIndex, contourValues[valueIndex]);
+  }
+  contour->ComputeScalarsOn();
+  contour->Update();
+
+  // Replace contour values by isodose color indices for coloring the lines using the isodose color table
+  vtkSmartPointer<vtkPolyData> isolinesPolyData = vtkSmartPointer<vtkPolyData>::New();
+  isolinesPolyData->ShallowCopy(contour->GetOutput());
+  vtkDataArray* contourScalars = isolinesPolyData->GetPointData()->GetScalars();
+  vtkNew<vtkFloatArray> levelIndexArray;
+  levelIndexArray->SetName(ISODOSE_LEVEL_INDEX_ARRAY_NAME);
+  levelIndexArray->SetNumberOfTuples(contourScalars ? isolinesPolyData->GetNumberOfPoints() : 0);
+  for (vtkIdType pointId = 0; pointId < levelIndexArray->GetNumberOfTuples(); ++pointId)
+  {
+    levelIndexArray->SetValue(pointId,
+      contourValueColorIndices[GetContourValueIndex(contourValues, contourScalars->GetTuple1(pointId))] );
+  }
+  isolinesPolyData->GetPointData()->Initialize();
+  isolinesPolyData->GetPointData()->SetScalars(levelIndexArray);
+
+  // Extrude the lines to a ribbon one slice thick centered on the slice plane, so that the slice
+  // intersection shown in the slice view is exactly the isolines
+  vtkNew<vtkLinearExtrusionFilter> extrusion;
+  extrusion->SetInputData(isolinesPolyData);
+  extrusion->SetExtrusionTypeToVectorExtrusion();
+  extrusion->SetVector(0.0, 0.0, 1.0);
+  extrusion->SetScaleFactor(1.0);
+  extrusion->CappingOff();
+
+  vtkNew<vtkTransform> xyToRasTransform;
+  xyToRasTransform->SetMatrix(sliceNode->GetXYToRAS());
+  xyToRasTransform->Translate(0.0, 0.0, -0.5);
+  vtkNew<vtkTransformPolyDataFilter> transformPolyData;
+  transformPolyData->SetInputConnection(extrusion->GetOutputPort());
+  transformPolyData->SetTransform(xyToRasTransform);
+  transformPolyData->Update();
+
+  // Get or create the model node showing the isolines in the slice view
+  std::pair<std::string, std::string> modelNodeKey(parameterNode->GetID(), sliceNode->GetID());
+  vtkMRMLModelNode* isolinesModelNode = this->Internal->SliceIsolineModelNodes[modelNodeKey];
+  if (!isolinesModelNode || isolinesModelNode->GetScene() != scene)
+  {
+    vtkSmartPointer<vtkMRMLModelDisplayNode> displayNode = vtkSmartPointer<vtkMRMLModelDisplayNode>::New();
+    displayNode->SetSaveWithScene(false);
+    displayNode->SetVisibility3D(false);
+    displayNode->Visibility2DOn();
+    displayNode->SetSliceIntersectionThickness(2);
+    displayNode->AddViewNodeID(sliceNode->GetID());
+    displayNode->SetActiveScalarName(ISODOSE_LEVEL_INDEX_ARRAY_NAME);
+    displayNode->SetScalarRangeFlag(vtkMRMLDisplayNode::UseManualScalarRange);
+    displayNode->ScalarVisibilityOn();
+    scene->AddNode(displayNode);
+
+    vtkSmartPointer<vtkMRMLModelNode> modelNode = vtkSmartPointer<vtkMRMLModelNode>::New();
+    std::string modelNodeName = std::string(doseVolumeNode->GetName()) + "_" + (sliceNode->GetName() ? sliceNode->GetName() : "")
+      + vtkSlicerIsodoseModuleLogic::ISODOSE_SLICE_ISOLINES_MODEL_NODE_NAME_POSTFIX;
+    modelNode->SetName(modelNodeName.c_str());
+    modelNode->SetSaveWithScene(false);
+    modelNode->SetHideFromEditors(1);
+    modelNode->SetSelectable(0);
+    scene->AddNode(modelNode);
+    modelNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+
+    this->Internal->SliceIsolineModelNodes[modelNodeKey] = modelNode;
+    isolinesModelNode = modelNode;
+  }
+
+  vtkMRMLDisplayNode* isolinesDisplayNode = isolinesModelNode->GetDisplayNode();
+  if (isolinesDisplayNode)
+  {
+    int wasModifying = isolinesDisplayNode->StartModify();
+    isolinesDisplayNode->SetAndObserveColorNodeID(colorTableNode->GetID());
+    // Each index maps to its own color table entry with this range
+    isolinesDisplayNode->SetScalarRange(-0.5, numberOfIsoLevels - 0.5);
+    isolinesDisplayNode->SetVisibility(parameterNode->GetShowIsodoseLines());
+    isolinesDisplayNode->EndModify(wasModifying);
+  }
+  isolinesModelNode->SetAndObservePolyData(transformPolyData->GetOutput());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::UpdateSliceIsolines(vtkMRMLIsodoseNode* parameterNode)
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene || !parameterNode || !parameterNode->GetID())
+  {
+    vtkErrorMacro("UpdateSliceIsolines: Invalid scene or parameter set node");
+    return;
+  }
+  this->Internal->SliceIsolineParameters[parameterNode->GetID()] = vtkInternal::GetIsolineParameters(parameterNode);
+
+  if ( !parameterNode->GetGenerateSliceIsolines() || !parameterNode->GetColorTableNode()
+    || !parameterNode->GetDoseVolumeNode() || !parameterNode->GetDoseVolumeNode()->GetImageData() )
+  {
+    this->RemoveSliceIsolines(parameterNode);
+    return;
+  }
+
+  // Views not shown in the layout are updated when they are shown. The isolines of the other isodose nodes
+  // are already up to date with the current slice views, so their state is stored
+  std::vector<vtkMRMLNode*> sliceNodes;
+  scene->GetNodesByClass("vtkMRMLSliceNode", sliceNodes);
+  for (vtkMRMLNode* node : sliceNodes)
+  {
+    vtkMRMLSliceNode* sliceNode = vtkMRMLSliceNode::SafeDownCast(node);
+    this->Internal->UpdateSliceViewState(sliceNode);
+    if (sliceNode->IsViewVisibleInLayout())
+    {
+      this->UpdateSliceIsolines(parameterNode, sliceNode);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::RemoveSliceIsolines(vtkMRMLIsodoseNode* parameterNode)
+{
+  if (!parameterNode || !parameterNode->GetID())
+  {
+    vtkErrorMacro("RemoveSliceIsolines: Invalid parameter set node");
+    return;
+  }
+
+  std::map<std::pair<std::string, std::string>, vtkWeakPointer<vtkMRMLModelNode> >::iterator modelNodeIt =
+    this->Internal->SliceIsolineModelNodes.begin();
+  while (modelNodeIt != this->Internal->SliceIsolineModelNodes.end())
+  {
+    if (modelNodeIt->first.first != parameterNode->GetID())
+    {
+      ++modelNodeIt;
+      continue;
+    }
+    vtkMRMLModelNode* modelNode = modelNodeIt->second;
+    if (modelNode && modelNode->GetScene())
+    {
+      vtkMRMLScene* scene = modelNode->GetScene();
+      if (modelNode->GetDisplayNode())
+      {
+        scene->RemoveNode(modelNode->GetDisplayNode());
+      }
+      scene->RemoveNode(modelNode);
+    }
+    modelNodeIt = this->Internal->SliceIsolineModelNodes.erase(modelNodeIt);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerIsodoseModuleLogic::ClearDosePyramidCache()
+{
+  this->Internal->DosePyramids.clear();
+}
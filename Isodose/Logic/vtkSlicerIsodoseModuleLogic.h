@@ -38,6 +38,7 @@ class vtkMRMLColorTableNode;
 class vtkMRMLIsodoseNode;
 class vtkMRMLModelHierarchyNode;
 class vtkMRMLScalarVolumeNode;
+class vtkMRMLSliceNode;
 
 /// \ingroup SlicerRt_QtModules_Isodose
 class VTK_SLICER_ISODOSE_LOGIC_EXPORT vtkSlicerIsodoseModuleLogic : public vtkSlicerModuleLogic
@@ -48,6 +49,7 @@ public:
   static const std::string ISODOSE_PARAMETER_SET_BASE_NAME_PREFIX;
   static const std::string ISODOSE_ROOT_HIERARCHY_NAME_POSTFIX;
   static const std::string ISODOSE_COLOR_TABLE_NODE_NAME_POSTFIX;
+  static const std::string ISODOSE_SLICE_ISOLINES_MODEL_NODE_NAME_POSTFIX;
 
 public:
   static vtkSlicerIsodoseModuleLogic *New();
@@ -71,6 +73,24 @@ public:
   /// Update dose volume color table from isodose levels
   void UpdateDoseColorTableFromIsodose(vtkMRMLIsodoseNode* parameterNode);
 
+  /// Contour the dose volume directly on the plane of a slice view, and show the isodose lines
+  /// in that view only. The dose is sampled from the level of a cached multi-resolution pyramid
+  /// that matches the pixel size of the view, so that updating while scrolling is fast.
+  /// Called automatically if \sa vtkMRMLIsodoseNode::GenerateSliceIsolines is on and the slice plane, the view size,
+  /// or the visibility of a view shown in the layout changes
+  void UpdateSliceIsolines(vtkMRMLIsodoseNode* parameterNode, vtkMRMLSliceNode* sliceNode);
+
+  /// Update slice isolines in all slice views shown in the layout, or remove them if slice isoline generation is off.
+  /// Called automatically if the dose volume, the color table, or the slice isoline generation flag of the isodose
+  /// node changes. Other changes of the isodose node only update the visibility of the isolines
+  void UpdateSliceIsolines(vtkMRMLIsodoseNode* parameterNode);
+
+  /// Remove slice isoline models of an isodose parameter node from the scene
+  void RemoveSliceIsolines(vtkMRMLIsodoseNode* parameterNode);
+
+  /// Clear cached dose pyramids. Pyramids are also rebuilt automatically if the dose changes
+  void ClearDosePyramidCache();
+
 public:
   /// Creates default isodose color table. Gets and returns if already exists
   static vtkMRMLColorTableNode* GetDefaultIsodoseColorTable(vtkMRMLScene* scene);
@@ -94,6 +114,9 @@ protected:
   void OnMRMLSceneNodeRemoved(vtkMRMLNode* node) override;
   void OnMRMLSceneEndClose() override;
 
+  /// Handles slice node changes (to update slice isolines) and isodose parameter node changes
+  void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData) override;
+
 protected:
   vtkSlicerIsodoseModuleLogic();
   ~vtkSlicerIsodoseModuleLogic() override;
@@ -101,6 +124,9 @@ protected:
 private:
   vtkSlicerIsodoseModuleLogic(const vtkSlicerIsodoseModuleLogic&) = delete;
   void operator=(const vtkSlicerIsodoseModuleLogic&) = delete;
+
+  class vtkInternal;
+  vtkInternal* Internal;
 };
 
 #endif
@@ -0,0 +1,186 @@
+// Isodose includes
+#include "vtkSlicerIsodoseModuleLogic.h"
+#include "vtkMRMLIsodoseNode.h"
+
+// MRML includes
+#include <vtkMRMLColorTableNode.h>
+#include <vtkMRMLDisplayNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSliceNode.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <cmath>
+#include <string>
+
+namespace
+{
+/// Dose volume of 41x41x5 voxels of 1mm centered at the origin, with dose increasing by 1Gy/mm from 0 at R=-20mm
+const int DOSE_DIMENSIONS[3] = { 41, 41, 5 };
+const double DOSE_ORIGIN[3] = { -20.0, -20.0, -2.0 };
+
+/// Isodose levels in Gy, the isolines are at R = level - 20mm
+const int NUMBER_OF_LEVELS = 3;
+const double ISODOSE_LEVELS[NUMBER_OF_LEVELS] = { 10.0, 20.0, 30.0 };
+
+const double TOLERANCE = 1e-3;
+
+//-----------------------------------------------------------------------------
+/// Check that each isoline point is on the known position of its level, within the ribbon of the slice plane
+bool CheckIsolines(vtkMRMLModelNode* isolinesModelNode, double sliceOffset)
+{
+  vtkPolyData* isolines = (isolinesModelNode ? isolinesModelNode->GetPolyData() : nullptr);
+  if (!isolines || isolines->GetNumberOfPoints() == 0)
+  {
+    std::cerr << "No slice isolines at slice offset " << sliceOffset << std::endl;
+    return false;
+  }
+  vtkDataArray* levelIndices = isolines->GetPointData()->GetScalars();
+  if (!levelIndices)
+  {
+    std::cerr << "Slice isolines have no level indices" << std::endl;
+    return false;
+  }
+  bool levelFound[NUMBER_OF_LEVELS] = { false, false, false };
+  for (vtkIdType pointId = 0; pointId < isolines->GetNumberOfPoints(); ++pointId)
+  {
+    double point[3] = { 0.0, 0.0, 0.0 };
+    isolines->GetPoint(pointId, point);
+    int levelIndex = static_cast<int>(levelIndices->GetTuple1(pointId));
+    if (levelIndex < 0 || levelIndex >= NUMBER_OF_LEVELS)
+    {
+      std::cerr << "Invalid level index " << levelIndex << std::endl;
+      return false;
+    }
+    levelFound[levelIndex] = true;
+    double expectedR = ISODOSE_LEVELS[levelIndex] + DOSE_ORIGIN[0];
+    if (fabs(point[0] - expectedR) > TOLERANCE || fabs(point[2] - sliceOffset) > 0.5 + TOLERANCE)
+    {
+      std::cerr << "Isoline point (" << point[0] << ", " << point[1] << ", " << point[2] << ") of level "
+        << ISODOSE_LEVELS[levelIndex] << " is not on the plane R=" << expectedR << " at slice offset " << sliceOffset << std::endl;
+      return false;
+    }
+  }
+  for (int levelIndex = 0; levelIndex < NUMBER_OF_LEVELS; ++levelIndex)
+  {
+    if (!levelFound[levelIndex])
+    {
+      std::cerr << "No isoline for level " << ISODOSE_LEVELS[levelIndex] << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerIsodoseSliceIsolinesTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkSlicerIsodoseModuleLogic> isodoseLogic;
+  isodoseLogic->SetMRMLScene(mrmlScene);
+
+  // Dose plane known analytically: dose depends only on R
+  vtkNew<vtkImageData> doseImageData;
+  doseImageData->SetDimensions(DOSE_DIMENSIONS[0], DOSE_DIMENSIONS[1], DOSE_DIMENSIONS[2]);
+  doseImageData->AllocateScalars(VTK_FLOAT, 1);
+  float* dosePtr = static_cast<float*>(doseImageData->GetScalarPointer());
+  for (int k = 0; k < DOSE_DIMENSIONS[2]; ++k)
+  {
+    for (int j = 0; j < DOSE_DIMENSIONS[1]; ++j)
+    {
+      for (int i = 0; i < DOSE_DIMENSIONS[0]; ++i)
+      {
+        *(dosePtr++) = static_cast<float>(i);
+      }
+    }
+  }
+  vtkNew<vtkMRMLScalarVolumeNode> doseVolumeNode;
+  doseVolumeNode->SetName("Dose");
+  doseVolumeNode->SetOrigin(DOSE_ORIGIN[0], DOSE_ORIGIN[1], DOSE_ORIGIN[2]);
+  doseVolumeNode->SetAndObserveImageData(doseImageData);
+  mrmlScene->AddNode(doseVolumeNode);
+
+  vtkNew<vtkMRMLColorTableNode> colorTableNode;
+  colorTableNode->SetTypeToUser();
+  colorTableNode->SetNumberOfColors(NUMBER_OF_LEVELS);
+  for (int levelIndex = 0; levelIndex < NUMBER_OF_LEVELS; ++levelIndex)
+  {
+    colorTableNode->SetColor(levelIndex, std::to_string(static_cast<int>(ISODOSE_LEVELS[levelIndex])).c_str(), 1.0, 0.0, 0.0, 1.0);
+  }
+  mrmlScene->AddNode(colorTableNode);
+
+  // Axial slice view shown in the layout within the dose volume, with pixels smaller than the dose voxels
+  vtkNew<vtkMRMLSliceNode> sliceNode;
+  sliceNode->SetName("Red");
+  sliceNode->SetLayoutName("Red");
+  sliceNode->SetOrientationToAxial();
+  sliceNode->SetDimensions(200, 200, 1);
+  sliceNode->SetFieldOfView(30.0, 30.0, 1.0);
+  sliceNode->SetMappedInLayout(1);
+  mrmlScene->AddNode(sliceNode);
+
+  vtkNew<vtkMRMLIsodoseNode> parameterNode;
+  mrmlScene->AddNode(parameterNode);
+  parameterNode->SetAndObserveDoseVolumeNode(doseVolumeNode);
+  parameterNode->SetAndObserveColorTableNode(colorTableNode);
+  parameterNode->SetGenerateSliceIsolines(true);
+
+  std::string isolinesModelNodeName = std::string("Dose_Red") + vtkSlicerIsodoseModuleLogic::ISODOSE_SLICE_ISOLINES_MODEL_NODE_NAME_POSTFIX;
+  vtkMRMLModelNode* isolinesModelNode = vtkMRMLModelNode::SafeDownCast(mrmlScene->GetFirstNodeByName(isolinesModelNodeName.c_str()));
+  if (!CheckIsolines(isolinesModelNode, 0.0))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Modifications not affecting the isolines do not contour again
+  vtkPolyData* isolines = isolinesModelNode->GetPolyData();
+  sliceNode->Modified();
+  parameterNode->SetShowIsodoseLines(false);
+  if (isolinesModelNode->GetPolyData() != isolines)
+  {
+    std::cerr << "Slice isolines were generated again without change of the slice plane or the isodose levels" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (isolinesModelNode->GetDisplayNode()->GetVisibility())
+  {
+    std::cerr << "Slice isolines are visible after hiding isodose lines" << std::endl;
+    return EXIT_FAILURE;
+  }
+  parameterNode->SetShowIsodoseLines(true);
+
+  // Moving the slice contours again on the new plane
+  sliceNode->SetSliceOffset(1.0);
+  if (isolinesModelNode->GetPolyData() == isolines || !CheckIsolines(isolinesModelNode, 1.0))
+  {
+    std::cerr << "Slice isolines were not updated after moving the slice" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Views not shown in the layout are only updated when they are shown again
+  isolines = isolinesModelNode->GetPolyData();
+  sliceNode->SetMappedInLayout(0);
+  sliceNode->SetSliceOffset(-1.0);
+  if (isolinesModelNode->GetPolyData() != isolines)
+  {
+    std::cerr << "Slice isolines were updated in a view not shown in the layout" << std::endl;
+    return EXIT_FAILURE;
+  }
+  sliceNode->SetMappedInLayout(1);
+  if (!CheckIsolines(isolinesModelNode, -1.0))
+  {
+    std::cerr << "Slice isolines were not updated after showing the view" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,306 @@
+// Isodose includes
+#include "vtkSlicerIsodoseModuleLogic.h"
+#include "vtkMRMLIsodoseNode.h"
+
+// MRML includes
+#include <vtkMRMLColorTableNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSubjectHierarchyNode.h>
+
+// VTK includes
+#include <vtkFlyingEdges3D.h>
+#include <vtkImageData.h>
+#include <vtkMassProperties.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
+
+// STD includes
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+/// Dose volume of 100x100x60 voxels, with a spherical dose distribution in one corner and no dose elsewhere
+const int DOSE_DIMENSIONS[3] = { 100, 100, 60 };
+const double DOSE_SPACING[3] = { 1.5, 1.5, 2.0 };
+const double DOSE_ORIGIN[3] = { -75.0, -75.0, -60.0 };
+
+/// Gaussian dose (Gy) around the center, cut to zero below the minimum dose. The center is on a voxel
+const double DOSE_CENTER[3] = { -24.0, -24.0, -16.0 };
+const double DOSE_MAXIMUM = 50.0;
+const double DOSE_SIGMA = 12.0;
+const double DOSE_MINIMUM = 1.0;
+
+/// Isodose levels in Gy. The highest level is above the maximum dose, so it has no isosurface
+const int NUMBER_OF_LEVELS = 4;
+const char* ISODOSE_LEVELS[NUMBER_OF_LEVELS] = { "5", "25", "40", "60" };
+const int NUMBER_OF_ISOSURFACES = 3;
+
+/// Region of interest containing the half of the dose distribution in the right direction, up to the voxel plane of the center
+double HALF_REGION_OF_INTEREST_BOUNDS[6] = { -100.0, DOSE_CENTER[0] - 0.001, -100.0, 100.0, -100.0, 100.0 };
+/// Region of interest containing the whole dose volume
+double FULL_REGION_OF_INTEREST_BOUNDS[6] = { -100.0, 100.0, -100.0, 100.0, -100.0, 100.0 };
+
+/// Decimation and smoothing of the isosurfaces move them slightly compared to the raw contours
+const double VOLUME_TOLERANCE_PERCENT = 3.0;
+const double AREA_TOLERANCE_PERCENT = 10.0;
+const double BOUNDS_TOLERANCE_MM = 1.5;
+
+//-----------------------------------------------------------------------------
+vtkMRMLScalarVolumeNode* CreateDoseVolume(vtkMRMLScene* scene)
+{
+  vtkNew<vtkImageData> doseImageData;
+  doseImageData->SetDimensions(DOSE_DIMENSIONS[0], DOSE_DIMENSIONS[1], DOSE_DIMENSIONS[2]);
+  doseImageData->AllocateScalars(VTK_FLOAT, 1);
+  float* dosePtr = static_cast<float*>(doseImageData->GetScalarPointer());
+  for (int k = 0; k < DOSE_DIMENSIONS[2]; ++k)
+  {
+    for (int j = 0; j < DOSE_DIMENSIONS[1]; ++j)
+    {
+      for (int i = 0; i < DOSE_DIMENSIONS[0]; ++i)
+      {
+        double r = DOSE_ORIGIN[0] + i * DOSE_SPACING[0] - DOSE_CENTER[0];
+        double a = DOSE_ORIGIN[1] + j * DOSE_SPACING[1] - DOSE_CENTER[1];
+        double s = DOSE_ORIGIN[2] + k * DOSE_SPACING[2] - DOSE_CENTER[2];
+        double dose = DOSE_MAXIMUM * exp(-(r*r + a*a + s*s) / (2.0 * DOSE_SIGMA * DOSE_SIGMA));
+        *(dosePtr++) = static_cast<float>(dose >= DOSE_MINIMUM ? dose : 0.0);
+      }
+    }
+  }
+
+  vtkNew<vtkMRMLScalarVolumeNode> doseVolumeNode;
+  doseVolumeNode->SetName("Dose");
+  doseVolumeNode->SetOrigin(DOSE_ORIGIN[0], DOSE_ORIGIN[1], DOSE_ORIGIN[2]);
+  doseVolumeNode->SetSpacing(DOSE_SPACING[0], DOSE_SPACING[1], DOSE_SPACING[2]);
+  doseVolumeNode->SetAndObserveImageData(doseImageData);
+  scene->AddNode(doseVolumeNode);
+  doseVolumeNode->CreateDefaultDisplayNodes();
+
+  // Subject hierarchy items are not created automatically in a VTK-only environment
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene);
+  shNode->CreateItem(shNode->GetSceneItemID(), doseVolumeNode);
+
+  return doseVolumeNode;
+}
+
+//-----------------------------------------------------------------------------
+/// Create isodose surfaces and get their poly data by isodose level
+std::map<std::string, vtkSmartPointer<vtkPolyData> > CreateIsodoseSurfaces(
+  vtkSlicerIsodoseModuleLogic* isodoseLogic, vtkMRMLIsodoseNode* parameterNode)
+{
+  std::map<std::string, vtkSmartPointer<vtkPolyData> > isodosePolyDatas;
+  isodoseLogic->CreateIsodoseSurfaces(parameterNode);
+
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(isodoseLogic->GetMRMLScene());
+  vtkIdType isodoseFolderItemID = isodoseLogic->GetIsodoseFolderItemID(parameterNode);
+  if (!shNode || !isodoseFolderItemID)
+  {
+    std::cerr << "No isodose subject hierarchy folder created" << std::endl;
+    return isodosePolyDatas;
+  }
+  std::vector<vtkIdType> isodoseChildItemIDs;
+  shNode->GetItemChildren(isodoseFolderItemID, isodoseChildItemIDs, false);
+  for (vtkIdType isodoseItemID : isodoseChildItemIDs)
+  {
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(shNode->GetItemDataNode(isodoseItemID));
+    if (modelNode && modelNode->GetPolyData())
+    {
+      std::string isoLevel = std::string(modelNode->GetName()).substr(vtkSlicerIsodoseModuleLogic::ISODOSE_MODEL_NODE_NAME_PREFIX.size());
+      isodosePolyDatas[isoLevel] = modelNode->GetPolyData();
+    }
+  }
+  return isodosePolyDatas;
+}
+
+//-----------------------------------------------------------------------------
+/// Contour the whole dose volume without any restriction, and transform the isosurface to RAS
+vtkSmartPointer<vtkPolyData> ContourWholeDoseVolume(vtkMRMLScalarVolumeNode* doseVolumeNode, double isoLevel)
+{
+  vtkNew<vtkFlyingEdges3D> contour;
+  contour->SetInputData(doseVolumeNode->GetImageData());
+  contour->SetValue(0, isoLevel);
+  contour->ComputeNormalsOff();
+  contour->ComputeScalarsOff();
+  contour->Update();
+
+  vtkNew<vtkMatrix4x4> ijkToRasMatrix;
+  doseVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+  vtkNew<vtkTransform> ijkToRasTransform;
+  ijkToRasTransform->SetMatrix(ijkToRasMatrix);
+  vtkNew<vtkTransformPolyDataFilter> transformPolyData;
+  transformPolyData->SetInputConnection(contour->GetOutputPort());
+  transformPolyData->SetTransform(ijkToRasTransform);
+  transformPolyData->Update();
+  return transformPolyData->GetOutput();
+}
+
+//-----------------------------------------------------------------------------
+bool CheckPercentDifference(const std::string& name, double value, double expected, double tolerancePercent)
+{
+  double differencePercent = fabs(value - expected) / fabs(expected) * 100.0;
+  if (differencePercent > tolerancePercent)
+  {
+    std::cerr << name << " is " << value << " instead of " << expected << " (difference " << differencePercent << "%)" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CheckBounds(const std::string& name, vtkPolyData* polyData, vtkPolyData* expectedPolyData, int axis)
+{
+  double bounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  polyData->GetBounds(bounds);
+  double expectedBounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  expectedPolyData->GetBounds(expectedBounds);
+  for (int side = 2*axis; side <= 2*axis + 1; ++side)
+  {
+    if (fabs(bounds[side] - expectedBounds[side]) > BOUNDS_TOLERANCE_MM)
+    {
+      std::cerr << name << " bound " << side << " is " << bounds[side] << " instead of " << expectedBounds[side] << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+double GetVolume(vtkPolyData* polyData)
+{
+  vtkNew<vtkMassProperties> massProperties;
+  massProperties->SetInputData(polyData);
+  massProperties->Update();
+  return massProperties->GetVolume();
+}
+
+//-----------------------------------------------------------------------------
+double GetSurfaceArea(vtkPolyData* polyData)
+{
+  vtkNew<vtkMassProperties> massProperties;
+  massProperties->SetInputData(polyData);
+  massProperties->Update();
+  return massProperties->GetSurfaceArea();
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerIsodoseSurfaceRegionsTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkSlicerIsodoseModuleLogic> isodoseLogic;
+  isodoseLogic->SetMRMLScene(mrmlScene);
+
+  vtkMRMLScalarVolumeNode* doseVolumeNode = CreateDoseVolume(mrmlScene);
+
+  vtkNew<vtkMRMLColorTableNode> colorTableNode;
+  colorTableNode->SetTypeToUser();
+  colorTableNode->SetNumberOfColors(NUMBER_OF_LEVELS);
+  for (int levelIndex = 0; levelIndex < NUMBER_OF_LEVELS; ++levelIndex)
+  {
+    colorTableNode->SetColor(levelIndex, ISODOSE_LEVELS[levelIndex], 1.0, 0.0, 0.0, 1.0);
+  }
+  mrmlScene->AddNode(colorTableNode);
+
+  vtkNew<vtkMRMLIsodoseNode> parameterNode;
+  mrmlScene->AddNode(parameterNode);
+  parameterNode->SetAndObserveDoseVolumeNode(doseVolumeNode);
+  parameterNode->SetAndObserveColorTableNode(colorTableNode);
+
+  // Dose with empty regions: the bricks that cannot contain a level are skipped, and the highest
+  // level is contoured separately within its own small region. The isosurfaces need to match the
+  // contours of the whole dose volume.
+  std::cout << "Compare isosurfaces of skipped empty regions with contours of the whole dose volume" << std::endl;
+  std::map<std::string, vtkSmartPointer<vtkPolyData> > isodosePolyDatas = CreateIsodoseSurfaces(isodoseLogic, parameterNode);
+  if (isodosePolyDatas.size() != NUMBER_OF_ISOSURFACES || isodosePolyDatas.count(ISODOSE_LEVELS[NUMBER_OF_LEVELS-1]))
+  {
+    std::cerr << "Number of isosurfaces is " << isodosePolyDatas.size() << " instead of " << NUMBER_OF_ISOSURFACES << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int levelIndex = 0; levelIndex < NUMBER_OF_ISOSURFACES; ++levelIndex)
+  {
+    std::string isoLevel(ISODOSE_LEVELS[levelIndex]);
+    vtkPolyData* isodosePolyData = isodosePolyDatas[isoLevel];
+    vtkSmartPointer<vtkPolyData> wholeVolumePolyData = ContourWholeDoseVolume(doseVolumeNode, std::stod(isoLevel));
+    if (!CheckPercentDifference("Volume of isosurface " + isoLevel, GetVolume(isodosePolyData), GetVolume(wholeVolumePolyData), VOLUME_TOLERANCE_PERCENT))
+    {
+      return EXIT_FAILURE;
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      if (!CheckBounds("Isosurface " + isoLevel, isodosePolyData, wholeVolumePolyData, axis))
+      {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // Region of interest containing the whole dose volume gives the same isosurfaces as no region of interest
+  std::cout << "Compare isosurfaces within a region of interest containing the whole dose volume" << std::endl;
+  parameterNode->SetUseRegionOfInterest(true);
+  parameterNode->SetRegionOfInterestBounds(FULL_REGION_OF_INTEREST_BOUNDS);
+  std::map<std::string, vtkSmartPointer<vtkPolyData> > fullRoiPolyDatas = CreateIsodoseSurfaces(isodoseLogic, parameterNode);
+  if (fullRoiPolyDatas.size() != NUMBER_OF_ISOSURFACES)
+  {
+    std::cerr << "Number of isosurfaces in region of interest is " << fullRoiPolyDatas.size() << " instead of " << NUMBER_OF_ISOSURFACES << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int levelIndex = 0; levelIndex < NUMBER_OF_ISOSURFACES; ++levelIndex)
+  {
+    std::string isoLevel(ISODOSE_LEVELS[levelIndex]);
+    if ( fullRoiPolyDatas[isoLevel]->GetNumberOfPoints() != isodosePolyDatas[isoLevel]->GetNumberOfPoints()
+      || !CheckPercentDifference("Volume of isosurface " + isoLevel + " in region of interest",
+        GetVolume(fullRoiPolyDatas[isoLevel]), GetVolume(isodosePolyDatas[isoLevel]), 0.001) )
+    {
+      std::cerr << "Isosurface " << isoLevel << " in region of interest differs from the unrestricted isosurface" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Region of interest containing half of the dose distribution gives the half of each unrestricted isosurface
+  std::cout << "Compare isosurfaces within a region of interest containing half of the dose" << std::endl;
+  parameterNode->SetRegionOfInterestBounds(HALF_REGION_OF_INTEREST_BOUNDS);
+  std::map<std::string, vtkSmartPointer<vtkPolyData> > halfRoiPolyDatas = CreateIsodoseSurfaces(isodoseLogic, parameterNode);
+  if (halfRoiPolyDatas.size() != NUMBER_OF_ISOSURFACES)
+  {
+    std::cerr << "Number of isosurfaces in region of interest is " << halfRoiPolyDatas.size() << " instead of " << NUMBER_OF_ISOSURFACES << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int levelIndex = 0; levelIndex < NUMBER_OF_ISOSURFACES; ++levelIndex)
+  {
+    std::string isoLevel(ISODOSE_LEVELS[levelIndex]);
+    vtkPolyData* roiPolyData = halfRoiPolyDatas[isoLevel];
+    vtkPolyData* isodosePolyData = isodosePolyDatas[isoLevel];
+    double roiBounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    roiPolyData->GetBounds(roiBounds);
+    double isodoseBounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    isodosePolyData->GetBounds(isodoseBounds);
+    if ( roiBounds[1] > DOSE_CENTER[0] + BOUNDS_TOLERANCE_MM
+      || fabs(roiBounds[0] - isodoseBounds[0]) > BOUNDS_TOLERANCE_MM )
+    {
+      std::cerr << "Isosurface " << isoLevel << " in region of interest spans R=" << roiBounds[0] << ".." << roiBounds[1]
+        << " instead of R=" << isodoseBounds[0] << ".." << DOSE_CENTER[0] << std::endl;
+      return EXIT_FAILURE;
+    }
+    if ( !CheckBounds("Isosurface " + isoLevel + " in region of interest", roiPolyData, isodosePolyData, 1)
+      || !CheckBounds("Isosurface " + isoLevel + " in region of interest", roiPolyData, isodosePolyData, 2) )
+    {
+      return EXIT_FAILURE;
+    }
+    if (!CheckPercentDifference("Surface area of isosurface " + isoLevel + " in region of interest",
+      GetSurfaceArea(roiPolyData), 0.5 * GetSurfaceArea(isodosePolyData), AREA_TOLERANCE_PERCENT))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
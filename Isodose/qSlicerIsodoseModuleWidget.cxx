@@ -299,6 +299,7 @@ void qSlicerIsodoseModuleWidget::updateWidgetFromMRML()
     this->updateScalarBarsFromSelectedColorTable();
 
     d->checkBox_Isoline->setChecked(paramNode->GetShowIsodoseLines());
+    d->checkBox_SliceIsolines->setChecked(paramNode->GetGenerateSliceIsolines());
     d->checkBox_Isosurface->setChecked(paramNode->GetShowIsodoseSurfaces());
 
     d->checkBox_ScalarBar->setChecked(paramNode->GetShowScalarBar());
@@ -331,6 +332,7 @@ void qSlicerIsodoseModuleWidget::setup()
 
   connect( d->checkBox_ShowDoseVolumesOnly, SIGNAL( stateChanged(int) ), this, SLOT( showDoseVolumesOnlyCheckboxChanged(int) ) );
   connect( d->checkBox_Isoline, SIGNAL(toggled(bool)), this, SLOT( setIsolineVisibility(bool) ) );
+  connect( d->checkBox_SliceIsolines, SIGNAL(toggled(bool)), this, SLOT( setSliceIsolineGeneration(bool) ) );
   connect( d->checkBox_Isosurface, SIGNAL(toggled(bool)), this, SLOT( setIsosurfaceVisibility(bool) ) );
   connect( d->checkBox_ScalarBar, SIGNAL(toggled(bool)), this, SLOT( setScalarBarVisibility(bool) ) );
   connect( d->checkBox_ScalarBar2D, SIGNAL(toggled(bool)), this, SLOT( setScalarBar2DVisibility(bool) ) );
@@ -560,6 +562,10 @@ void qSlicerIsodoseModuleWidget::setIsolineVisibility(bool visible)
   paramNode->SetShowIsodoseLines(visible);
   paramNode->DisableModifiedEventOff();
 
+  // Isolines generated on the slices replace the cross-sections of the isodose surfaces
+  d->logic()->UpdateSliceIsolines(paramNode);
+  bool surfaceIntersectionVisible = visible && !paramNode->GetGenerateSliceIsolines();
+
   vtkIdType isdoseFolderItemID = d->logic()->GetIsodoseFolderItemID(paramNode);
   if (!isdoseFolderItemID)
   {
@@ -574,10 +580,29 @@ void qSlicerIsodoseModuleWidget::setIsolineVisibility(bool visible)
   {
     vtkIdType childItemID = (*childIt);
     vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(shNode->GetItemDataNode(childItemID));
-    modelNode->GetDisplayNode()->SetVisibility2D(visible);
+    modelNode->GetDisplayNode()->SetVisibility2D(surfaceIntersectionVisible);
   }
 }
 
+//------------------------------------------------------------------------------
+void qSlicerIsodoseModuleWidget::setSliceIsolineGeneration(bool generate)
+{
+  Q_D(qSlicerIsodoseModuleWidget);
+
+  vtkMRMLIsodoseNode* paramNode = vtkMRMLIsodoseNode::SafeDownCast(d->MRMLNodeComboBox_ParameterSet->currentNode());
+  if (!paramNode || !this->mrmlScene())
+  {
+    return;
+  }
+
+  paramNode->DisableModifiedEventOn();
+  paramNode->SetGenerateSliceIsolines(generate);
+  paramNode->DisableModifiedEventOff();
+
+  // Update slice isolines and the slice intersection visibility of the isodose surfaces
+  this->setIsolineVisibility(d->checkBox_Isoline->isChecked());
+}
+
 //------------------------------------------------------------------------------
 void qSlicerIsodoseModuleWidget::setIsosurfaceVisibility(bool visible)
 {
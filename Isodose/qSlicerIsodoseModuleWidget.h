@@ -79,6 +79,9 @@ protected slots:
   /// Slot for changing isoline visibility
   void setIsolineVisibility(bool);
 
+  /// Slot for turning generation of isodose lines directly on the slice planes on or off
+  void setSliceIsolineGeneration(bool);
+
   /// Slot for changing isosurface visibility
   void setIsosurfaceVisibility(bool);
 
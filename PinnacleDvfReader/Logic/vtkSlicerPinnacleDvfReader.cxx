@@ -30,6 +30,7 @@
 #include <vtkImageData.h>
 #include <vtkPointData.h>
 #include <vtkTransform.h>
+#include <vtkSMPTools.h>
 #include <vtkVersion.h>
 
 // STD includes
@@ -37,6 +38,40 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <vector>
+
+//----------------------------------------------------------------------------
+namespace
+{
+  /// Displacement corresponding to one unit of the low byte, in mm
+  const float MIN_RESOLUTION = 0.004;
+
+  //----------------------------------------------------------------------------
+  /// Combine the high and low byte blocks of the displacement components into 3-component
+  /// displacement vectors, converting them from LPS to RAS
+  template <class T>
+  void InterleaveDisplacements(const signed char* const highBytes[3], const unsigned char* const lowBytes[3],
+    vtkIdType numberOfVoxels, T* output)
+  {
+    vtkSMPTools::For(0, numberOfVoxels, [&](vtkIdType begin, vtkIdType end)
+    {
+      const signed char* xHigh = highBytes[0];
+      const signed char* yHigh = highBytes[1];
+      const signed char* zHigh = highBytes[2];
+      const unsigned char* xLow = lowBytes[0];
+      const unsigned char* yLow = lowBytes[1];
+      const unsigned char* zLow = lowBytes[2];
+      T* outputPtr = output + 3 * begin;
+      for (vtkIdType n = begin; n < end; ++n)
+      {
+        outputPtr[0] = static_cast<T>( -1*(xHigh[n] + (MIN_RESOLUTION * xLow[n])) );
+        outputPtr[1] = static_cast<T>( -1*(yHigh[n] + (MIN_RESOLUTION * yLow[n])) );
+        outputPtr[2] = static_cast<T>(  1*(zHigh[n] + (MIN_RESOLUTION * zLow[n])) );
+        outputPtr += 3;
+      }
+    });
+  }
+}
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerPinnacleDvfReader);
@@ -54,6 +89,9 @@ vtkSlicerPinnacleDvfReader::vtkSlicerPinnacleDvfReader()
   this->DeformableRegistrationGridOrientationMatrix = vtkMatrix4x4::New();
 
   this->LoadDeformableSpatialRegistrationSuccessful = false;
+
+  this->OutputScalarType = VTK_FLOAT;
+  this->ChunkSizeMB = 16;
 }
 
 //----------------------------------------------------------------------------
@@ -68,6 +106,9 @@ vtkSlicerPinnacleDvfReader::~vtkSlicerPinnacleDvfReader()
 void vtkSlicerPinnacleDvfReader::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "OutputScalarType: " << this->OutputScalarType << "\n";
+  os << indent << "ChunkSizeMB: " << this->ChunkSizeMB << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -89,8 +130,6 @@ void vtkSlicerPinnacleDvfReader::Update()
 //----------------------------------------------------------------------------
 void vtkSlicerPinnacleDvfReader::LoadDeformableSpatialRegistration(char *fileName)
 {
-  const float MIN_RESOLUTION = 0.004;
-  
   /* start coordinates of the bounding box*/
   int fixedBBStartX;
   int fixedBBStartY;
@@ -195,21 +234,16 @@ void vtkSlicerPinnacleDvfReader::LoadDeformableSpatialRegistration(char *fileNam
   readFileStream.read ((char *) &ySpacing, sizeof(double));
   readFileStream.read ((char *) &zSpacing, sizeof(double));
 
-  long voxelCount = dvfSizeX * dvfSizeY * dvfSizeZ;
-
-  signed char *xBufferHigh = new signed char[voxelCount];
-  signed char *yBufferHigh = new signed char[voxelCount];
-  signed char *zBufferHigh = new signed char[voxelCount];
-  unsigned char *xBufferLow = new unsigned char[voxelCount];
-  unsigned char *yBufferLow = new unsigned char[voxelCount];
-  unsigned char *zBufferLow = new unsigned char[voxelCount];
-
-  readFileStream.read ((char *) xBufferHigh, voxelCount);
-  readFileStream.read ((char *) yBufferHigh, voxelCount);
-  readFileStream.read ((char *) zBufferHigh, voxelCount);
-  readFileStream.read ((char *) xBufferLow, voxelCount);
-  readFileStream.read ((char *) yBufferLow, voxelCount);
-  readFileStream.read ((char *) zBufferLow, voxelCount);
+  if (readFileStream.fail() || dvfSizeX <= 0 || dvfSizeY <= 0 || dvfSizeZ <= 0)
+  {
+    vtkErrorMacro("LoadPinnacleDvf: Invalid header in file " << fileName);
+    return;
+  }
+  if (this->OutputScalarType != VTK_FLOAT && this->OutputScalarType != VTK_DOUBLE)
+  {
+    vtkErrorMacro("LoadPinnacleDvf: Invalid output scalar type " << this->OutputScalarType << ". Only float and double are supported");
+    return;
+  }
 
   this->DeformableRegistrationGridOrientationMatrix->Identity();
   this->DeformableRegistrationGridOrientationMatrix->SetElement(0,0,-1);
@@ -220,54 +254,55 @@ void vtkSlicerPinnacleDvfReader::LoadDeformableSpatialRegistration(char *fileNam
   this->DeformableRegistrationGrid->SetOrigin(this->GridOrigin[0], this->GridOrigin[1], this->GridOrigin[2]);
   this->DeformableRegistrationGrid->SetSpacing(xSpacing, ySpacing, zSpacing);
   this->DeformableRegistrationGrid->SetExtent(0,dvfSizeX-1,0,dvfSizeY-1,0,dvfSizeZ-1);
-  this->DeformableRegistrationGrid->AllocateScalars(VTK_DOUBLE, 3);
-
-  int n = 0;
-  for (unsigned int k=0; k<dvfSizeZ; k++)
+  this->DeformableRegistrationGrid->AllocateScalars(this->OutputScalarType, 3);
+
+  // The file contains the high bytes of the X, Y and Z displacements, followed by the low bytes, each
+  // in a separate block. The blocks are read one chunk of voxels at a time, so that only the output
+  // vector field and a small buffer are in memory, and interleaved directly into the output.
+  vtkIdType voxelCount = (vtkIdType)dvfSizeX * dvfSizeY * dvfSizeZ;
+  vtkIdType voxelsPerChunk = voxelCount;
+  if (this->ChunkSizeMB > 0)
   {
-    for (unsigned int j=0; j<dvfSizeY; j++)
+    voxelsPerChunk = std::min(voxelCount, std::max<vtkIdType>(1, (vtkIdType)this->ChunkSizeMB * 1024 * 1024 / 6));
+  }
+  std::vector<char> chunkBuffer(6 * voxelsPerChunk);
+  std::streamoff dataStart = readFileStream.tellg();
+  void* outputPtr = this->DeformableRegistrationGrid->GetScalarPointer();
+  for (vtkIdType chunkStart = 0; chunkStart < voxelCount; chunkStart += voxelsPerChunk)
+  {
+    vtkIdType chunkVoxelCount = std::min(voxelsPerChunk, voxelCount - chunkStart);
+    const signed char* highBytes[3] = { nullptr, nullptr, nullptr };
+    const unsigned char* lowBytes[3] = { nullptr, nullptr, nullptr };
+    for (int block = 0; block < 6; ++block)
     {
-      for (unsigned int i=0; i<dvfSizeX; i++)
+      char* blockBuffer = chunkBuffer.data() + block * voxelsPerChunk;
+      readFileStream.seekg(dataStart + block * voxelCount + chunkStart, std::ios::beg);
+      readFileStream.read(blockBuffer, chunkVoxelCount);
+      if (readFileStream.gcount() != chunkVoxelCount)
+      {
+        vtkErrorMacro("LoadPinnacleDvf: The end of the file was reached earlier than specified.");
+        return;
+      }
+      if (block < 3)
+      {
+        highBytes[block] = reinterpret_cast<const signed char*>(blockBuffer);
+      }
+      else
       {
-        n = i + j*dvfSizeX + k*dvfSizeX*dvfSizeY ;
-        this->DeformableRegistrationGrid->SetScalarComponentFromDouble(i,j,k,0, -1*(xBufferHigh[n] + (MIN_RESOLUTION * xBufferLow[n])) );
-        this->DeformableRegistrationGrid->SetScalarComponentFromDouble(i,j,k,1, -1*(yBufferHigh[n] + (MIN_RESOLUTION * yBufferLow[n])) );
-        this->DeformableRegistrationGrid->SetScalarComponentFromDouble(i,j,k,2,  1*(zBufferHigh[n] + (MIN_RESOLUTION * zBufferLow[n])) );
+        lowBytes[block - 3] = reinterpret_cast<const unsigned char*>(blockBuffer);
       }
     }
+
+    if (this->OutputScalarType == VTK_DOUBLE)
+    {
+      InterleaveDisplacements(highBytes, lowBytes, chunkVoxelCount, static_cast<double*>(outputPtr) + 3 * chunkStart);
+    }
+    else
+    {
+      InterleaveDisplacements(highBytes, lowBytes, chunkVoxelCount, static_cast<float*>(outputPtr) + 3 * chunkStart);
+    }
   }
   readFileStream.close();
-  
-  if(xBufferHigh)
-  {
-      delete [] xBufferHigh;
-      xBufferHigh = nullptr;
-  }
-  if(yBufferHigh)
-  {
-      delete [] yBufferHigh;
-      yBufferHigh = nullptr;
-  }
-  if(zBufferHigh)
-  {
-      delete [] zBufferHigh;
-      zBufferHigh = nullptr;
-  }
-  if(xBufferLow)
-  {
-      delete [] xBufferLow;
-      xBufferLow = nullptr;
-  }
-  if(yBufferLow)
-  {
-      delete [] yBufferLow;
-      yBufferLow = nullptr;
-  }
-  if(zBufferLow)
-  {
-      delete [] zBufferLow;
-      zBufferLow = nullptr;
-  }
 
   this->LoadDeformableSpatialRegistrationSuccessful = true; 
 }
@@ -68,6 +68,16 @@ public:
   /// Get load deformable spatial registration successful flag
   vtkGetMacro(LoadDeformableSpatialRegistrationSuccessful, bool);
 
+  /// Set/Get scalar type of the deformable registration grid. VTK_FLOAT (default) or VTK_DOUBLE
+  vtkSetMacro(OutputScalarType, int);
+  vtkGetMacro(OutputScalarType, int);
+
+  /// Set/Get size of the chunks in which the displacements are read from the file, in megabytes.
+  /// The buffer used for reading is of this size, so that the peak memory use is about the size
+  /// of the deformable registration grid. 0 reads the whole file at once. 16 MB by default
+  vtkSetMacro(ChunkSizeMB, int);
+  vtkGetMacro(ChunkSizeMB, int);
+
 protected:
   void LoadDeformableSpatialRegistration(char*);
 
@@ -90,6 +100,12 @@ protected:
   /// Flag indicating if deformable spatial registration object has been successfully read from the input dataset
   bool LoadDeformableSpatialRegistrationSuccessful;
 
+  /// Scalar type of the deformable registration grid
+  int OutputScalarType;
+
+  /// Size of the chunks in which the displacements are read, in megabytes. Whole file if 0
+  int ChunkSizeMB;
+
 protected:
   vtkSlicerPinnacleDvfReader();
   ~vtkSlicerPinnacleDvfReader() override;
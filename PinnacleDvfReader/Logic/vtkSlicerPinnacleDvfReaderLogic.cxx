@@ -63,11 +63,18 @@ void vtkSlicerPinnacleDvfReaderLogic::LoadPinnacleDvf(char *filename, double gri
   if (readFileStream.fail())
   {
     vtkErrorMacro("LoadPinnacleDvf: The specified file could not be opened.");
+    return;
   }
+  readFileStream.close();
   vtkSmartPointer<vtkSlicerPinnacleDvfReader> pinnacleDvfReader = vtkSmartPointer<vtkSlicerPinnacleDvfReader>::New();
   pinnacleDvfReader->SetFileName(filename);
   pinnacleDvfReader->SetGridOrigin(gridOriginX, gridOriginY, gridOriginZ);
   pinnacleDvfReader->Update();
+  if (!pinnacleDvfReader->GetLoadDeformableSpatialRegistrationSuccessful())
+  {
+    vtkErrorMacro("LoadPinnacleDvf: Failed to read deformable registration from file " << filename);
+    return;
+  }
 
   // Post deformation node
   vtkMatrix4x4* postDeformationMatrix = nullptr;
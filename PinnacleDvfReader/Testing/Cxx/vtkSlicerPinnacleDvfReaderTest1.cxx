@@ -0,0 +1,340 @@
+// PinnacleDvfReader includes
+#include "vtkSlicerPinnacleDvfReader.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemInformation.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+//-----------------------------------------------------------------------------
+signed char GetHighByte(vtkIdType voxelIndex, int component)
+{
+  return static_cast<signed char>((voxelIndex * 7 + component * 13) % 256 - 128);
+}
+
+//-----------------------------------------------------------------------------
+unsigned char GetLowByte(vtkIdType voxelIndex, int component)
+{
+  return static_cast<unsigned char>((voxelIndex * 5 + component * 31) % 256);
+}
+
+//-----------------------------------------------------------------------------
+/// Expected displacement in RAS, computed the same way as by the reader
+float GetExpectedDisplacement(vtkIdType voxelIndex, int component)
+{
+  const float MIN_RESOLUTION = 0.004;
+  float displacement = GetHighByte(voxelIndex, component) + MIN_RESOLUTION * GetLowByte(voxelIndex, component);
+  return (component < 2 ? -displacement : displacement);
+}
+
+//-----------------------------------------------------------------------------
+bool WriteSyntheticDvfFile(const std::string& filename, const int size[3], const double spacing[3])
+{
+  std::ofstream file(filename.c_str(), std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  int header[] = { 1, 0, 0, 0, 0, 0, size[0] - 1, size[1] - 1, size[2] - 1, size[0], size[1], size[2] };
+  file.write(reinterpret_cast<const char*>(header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(spacing), 3 * sizeof(double));
+
+  vtkIdType voxelCount = (vtkIdType)size[0] * size[1] * size[2];
+  std::vector<char> block(voxelCount);
+  for (int blockIndex = 0; blockIndex < 6; ++blockIndex)
+  {
+    int component = blockIndex % 3;
+    for (vtkIdType voxelIndex = 0; voxelIndex < voxelCount; ++voxelIndex)
+    {
+      block[voxelIndex] = (blockIndex < 3 ? static_cast<char>(GetHighByte(voxelIndex, component))
+        : static_cast<char>(GetLowByte(voxelIndex, component)));
+    }
+    file.write(block.data(), voxelCount);
+  }
+  return file.good();
+}
+
+//-----------------------------------------------------------------------------
+bool ReadAndCheckDvf(const std::string& filename, const int size[3], const double spacing[3], int scalarType, int chunkSizeMB)
+{
+  double memoryBeforeMB = vtksys::SystemInformation().GetProcMemoryUsed() / 1024.0;
+  double startTime = vtkTimerLog::GetUniversalTime();
+
+  vtkNew<vtkSlicerPinnacleDvfReader> reader;
+  reader->SetFileName(filename.c_str());
+  reader->SetOutputScalarType(scalarType);
+  reader->SetChunkSizeMB(chunkSizeMB);
+  reader->Update();
+
+  double elapsedTimeSec = vtkTimerLog::GetUniversalTime() - startTime;
+  double memoryAfterMB = vtksys::SystemInformation().GetProcMemoryUsed() / 1024.0;
+  std::cout << "Read " << size[0] << "x" << size[1] << "x" << size[2] << " DVF as " << (scalarType == VTK_FLOAT ? "float" : "double")
+    << " with chunk size " << chunkSizeMB << " MB in " << elapsedTimeSec << " s, memory increase " << memoryAfterMB - memoryBeforeMB << " MB" << std::endl;
+
+  if (!reader->GetLoadDeformableSpatialRegistrationSuccessful())
+  {
+    std::cerr << "Failed to read DVF file " << filename << std::endl;
+    return false;
+  }
+  vtkImageData* grid = reader->GetDeformableRegistrationGrid();
+  int* dimensions = grid->GetDimensions();
+  if ( dimensions[0] != size[0] || dimensions[1] != size[1] || dimensions[2] != size[2]
+    || grid->GetNumberOfScalarComponents() != 3 || grid->GetScalarType() != scalarType )
+  {
+    std::cerr << "Invalid deformable registration grid dimensions or scalar type" << std::endl;
+    return false;
+  }
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (grid->GetSpacing()[axis] != spacing[axis])
+    {
+      std::cerr << "Invalid deformable registration grid spacing" << std::endl;
+      return false;
+    }
+  }
+
+  vtkIdType voxelCount = (vtkIdType)size[0] * size[1] * size[2];
+  void* scalarPointer = grid->GetScalarPointer();
+  for (vtkIdType voxelIndex = 0; voxelIndex < voxelCount; ++voxelIndex)
+  {
+    for (int component = 0; component < 3; ++component)
+    {
+      double value = (scalarType == VTK_FLOAT ? static_cast<float*>(scalarPointer)[3 * voxelIndex + component]
+        : static_cast<double*>(scalarPointer)[3 * voxelIndex + component]);
+      if (value != static_cast<double>(GetExpectedDisplacement(voxelIndex, component)))
+      {
+        std::cerr << "Displacement mismatch at voxel " << voxelIndex << " component " << component << ": "
+          << value << " != " << GetExpectedDisplacement(voxelIndex, component) << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+/// Peak resident set size of the process in MB, negative if not available
+double GetPeakMemoryUsedMB()
+{
+#ifdef _WIN32
+  return -1.0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+  {
+    return -1.0;
+  }
+#ifdef __APPLE__
+  return usage.ru_maxrss / (1024.0 * 1024.0); // bytes
+#else
+  return usage.ru_maxrss / 1024.0; // kilobytes
+#endif
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Read DVF file the way the reader did before the chunked reading, as reference for the benchmark:
+/// six voxel-sized byte buffers, and a double grid filled one component at a time
+vtkSmartPointer<vtkImageData> ReadDvfLegacy(const std::string& filename)
+{
+  const float MIN_RESOLUTION = 0.004;
+  std::ifstream readFileStream(filename.c_str(), std::ios::binary);
+  int header[12] = { 0 };
+  readFileStream.read((char*)header, sizeof(header));
+  double spacing[3] = { 0.0, 0.0, 0.0 };
+  readFileStream.read((char*)spacing, sizeof(spacing));
+  int dvfSizeX = header[9];
+  int dvfSizeY = header[10];
+  int dvfSizeZ = header[11];
+
+  long voxelCount = (long)dvfSizeX * dvfSizeY * dvfSizeZ;
+  signed char* xBufferHigh = new signed char[voxelCount];
+  signed char* yBufferHigh = new signed char[voxelCount];
+  signed char* zBufferHigh = new signed char[voxelCount];
+  unsigned char* xBufferLow = new unsigned char[voxelCount];
+  unsigned char* yBufferLow = new unsigned char[voxelCount];
+  unsigned char* zBufferLow = new unsigned char[voxelCount];
+  readFileStream.read((char*)xBufferHigh, voxelCount);
+  readFileStream.read((char*)yBufferHigh, voxelCount);
+  readFileStream.read((char*)zBufferHigh, voxelCount);
+  readFileStream.read((char*)xBufferLow, voxelCount);
+  readFileStream.read((char*)yBufferLow, voxelCount);
+  readFileStream.read((char*)zBufferLow, voxelCount);
+
+  vtkSmartPointer<vtkImageData> grid = vtkSmartPointer<vtkImageData>::New();
+  grid->SetSpacing(spacing);
+  grid->SetExtent(0, dvfSizeX-1, 0, dvfSizeY-1, 0, dvfSizeZ-1);
+  grid->AllocateScalars(VTK_DOUBLE, 3);
+  for (int k = 0; k < dvfSizeZ; k++)
+  {
+    for (int j = 0; j < dvfSizeY; j++)
+    {
+      for (int i = 0; i < dvfSizeX; i++)
+      {
+        long n = i + j*dvfSizeX + (long)k*dvfSizeX*dvfSizeY;
+        grid->SetScalarComponentFromDouble(i, j, k, 0, -1*(xBufferHigh[n] + (MIN_RESOLUTION * xBufferLow[n])));
+        grid->SetScalarComponentFromDouble(i, j, k, 1, -1*(yBufferHigh[n] + (MIN_RESOLUTION * yBufferLow[n])));
+        grid->SetScalarComponentFromDouble(i, j, k, 2, 1*(zBufferHigh[n] + (MIN_RESOLUTION * zBufferLow[n])));
+      }
+    }
+  }
+
+  delete [] xBufferHigh;
+  delete [] yBufferHigh;
+  delete [] zBufferHigh;
+  delete [] xBufferLow;
+  delete [] yBufferLow;
+  delete [] zBufferLow;
+  return grid;
+}
+
+//-----------------------------------------------------------------------------
+/// Report the read time and the peak memory of the reader and of the reference implementation it replaced.
+/// The peak resident set size only grows, so the reader that needs less memory is run first
+bool RunBenchmark(const std::string& filename, const int size[3], const double spacing[3])
+{
+  double startPeakMemoryMB = GetPeakMemoryUsedMB();
+  if (!ReadAndCheckDvf(filename, size, spacing, VTK_FLOAT, 16))
+  {
+    return false;
+  }
+  double readerPeakMemoryMB = GetPeakMemoryUsedMB();
+
+  double startTime = vtkTimerLog::GetUniversalTime();
+  vtkSmartPointer<vtkImageData> legacyGrid = ReadDvfLegacy(filename);
+  double legacyElapsedTimeSec = vtkTimerLog::GetUniversalTime() - startTime;
+  double legacyPeakMemoryMB = GetPeakMemoryUsedMB();
+  std::cout << "Read " << size[0] << "x" << size[1] << "x" << size[2] << " DVF with the reference implementation in "
+    << legacyElapsedTimeSec << " s" << std::endl;
+  if (startPeakMemoryMB >= 0.0)
+  {
+    std::cout << "Peak memory (max RSS) increase: reader " << readerPeakMemoryMB - startPeakMemoryMB
+      << " MB, reference implementation " << legacyPeakMemoryMB - startPeakMemoryMB << " MB" << std::endl;
+  }
+
+  vtkIdType voxelCount = (vtkIdType)size[0] * size[1] * size[2];
+  double* legacyValues = static_cast<double*>(legacyGrid->GetScalarPointer());
+  for (vtkIdType voxelIndex = 0; voxelIndex < voxelCount; ++voxelIndex)
+  {
+    for (int component = 0; component < 3; ++component)
+    {
+      if (legacyValues[3 * voxelIndex + component] != static_cast<double>(GetExpectedDisplacement(voxelIndex, component)))
+      {
+        std::cerr << "Reference implementation displacement mismatch at voxel " << voxelIndex << " component " << component << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPinnacleDvfReaderTest1( int argc, char * argv[] )
+{
+  int argIndex = 1;
+
+  // TemporaryDirectory
+  std::string temporaryDirectory;
+  if (argc > argIndex + 1 && STRCASECMP(argv[argIndex], "-TemporaryDirectory") == 0)
+  {
+    temporaryDirectory = argv[argIndex + 1];
+    std::cout << "Temporary directory: " << temporaryDirectory << std::endl;
+    argIndex += 2;
+  }
+  else
+  {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Size (optional), e.g. -Size 512 512 200
+  int size[3] = { 128, 112, 60 };
+  bool sizeSpecified = false;
+  if (argc > argIndex + 3 && STRCASECMP(argv[argIndex], "-Size") == 0)
+  {
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      size[axis] = atoi(argv[argIndex + 1 + axis]);
+    }
+    sizeSpecified = true;
+    argIndex += 4;
+  }
+
+  // Benchmark (optional). Compares the reader to the reference implementation it replaced,
+  // on a clinical size 512x512x200 grid unless the size is specified
+  bool benchmark = false;
+  if (argc > argIndex && STRCASECMP(argv[argIndex], "-Benchmark") == 0)
+  {
+    benchmark = true;
+    if (!sizeSpecified)
+    {
+      size[0] = 512;
+      size[1] = 512;
+      size[2] = 200;
+    }
+    argIndex += 1;
+  }
+  const double spacing[3] = { 2.5, 2.0, 3.0 };
+
+  vtksys::SystemTools::MakeDirectory(temporaryDirectory);
+  std::string filename = temporaryDirectory + "/SyntheticDeformation.dvf";
+  if (!WriteSyntheticDvfFile(filename, size, spacing))
+  {
+    std::cerr << "Failed to write synthetic DVF file " << filename << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (benchmark)
+  {
+    return (RunBenchmark(filename, size, spacing) ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  // Whole file at once and in chunks smaller than the blocks, in both output types
+  if ( !ReadAndCheckDvf(filename, size, spacing, VTK_FLOAT, 0)
+    || !ReadAndCheckDvf(filename, size, spacing, VTK_FLOAT, 1)
+    || !ReadAndCheckDvf(filename, size, spacing, VTK_DOUBLE, 1) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Truncated file
+  std::string truncatedFilename = temporaryDirectory + "/SyntheticDeformationTruncated.dvf";
+  {
+    std::ifstream inputFile(filename.c_str(), std::ios::binary);
+    std::vector<char> contents((std::istreambuf_iterator<char>(inputFile)), std::istreambuf_iterator<char>());
+    std::ofstream truncatedFile(truncatedFilename.c_str(), std::ios::binary);
+    truncatedFile.write(contents.data(), contents.size() - 1);
+  }
+  vtkNew<vtkSlicerPinnacleDvfReader> reader;
+  reader->SetFileName(truncatedFilename.c_str());
+  reader->Update();
+  if (reader->GetLoadDeformableSpatialRegistrationSuccessful())
+  {
+    std::cerr << "Truncated DVF file is read successfully" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -41,22 +41,120 @@
 
 // Segmentations includes
 #include "vtkOrientedImageData.h"
+#include "vtkMRMLSegmentationNode.h"
+#include "vtkSegmentation.h"
 
 // SlicerRT includes
 #include "vtkSlicerRtCommon.h"
 #include "PlmCommon.h"
 
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLTransformNode.h>
+
 // VTK includes
 #include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
 #include <vtkImageData.h>
+#include <vtkAbstractTransform.h>
 
 // Qt includes
 #include <QDebug>
 #include <QStringList>
 
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+/// Plastimatch images converted from the plan inputs. Shared by all beams of the plan
+/// so that the conversions are done once per plan and not for every beam. The images
+/// are reconverted only if the reference volume or the target segment is modified.
+class qSlicerPlmProtonDoseEngineInputCache
+{
+public:
+  /// Plan the cached images belong to
+  vtkWeakPointer<vtkMRMLRTPlanNode> PlanNode;
+
+  /// Reference volume, its modified time at conversion, and the converted images
+  vtkWeakPointer<vtkMRMLScalarVolumeNode> ReferenceVolumeNode;
+  vtkMTimeType ReferenceVolumeTime{0};
+  Plm_image::Pointer ReferenceVolumePlm;
+  itk::Image<short, 3>::Pointer ReferenceVolumeItk;
+
+  /// Target segmentation and segment, their modified time at conversion, and the converted images
+  vtkWeakPointer<vtkMRMLSegmentationNode> TargetSegmentationNode;
+  std::string TargetSegmentID;
+  vtkMTimeType TargetTime{0};
+  Plm_image::Pointer TargetPlm;
+  itk::Image<unsigned char, 3>::Pointer TargetItk;
+};
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// Get latest modified time of a transformable node including its parent transforms
+vtkMTimeType GetTransformableNodeMTime(vtkMRMLTransformableNode* node)
+{
+  vtkMTimeType mtime = node->GetMTime();
+  for (vtkMRMLTransformNode* transformNode = node->GetParentTransformNode();
+    transformNode; transformNode = transformNode->GetParentTransformNode())
+  {
+    mtime = std::max(mtime, transformNode->GetMTime());
+    if (transformNode->GetTransformToParent())
+    {
+      mtime = std::max(mtime, transformNode->GetTransformToParent()->GetMTime());
+    }
+  }
+  return mtime;
+}
+
+//----------------------------------------------------------------------------
+/// Get latest modified time of the reference volume node and its image data
+vtkMTimeType GetReferenceVolumeMTime(vtkMRMLScalarVolumeNode* referenceVolumeNode)
+{
+  vtkMTimeType mtime = GetTransformableNodeMTime(referenceVolumeNode);
+  if (referenceVolumeNode->GetImageData())
+  {
+    mtime = std::max(mtime, referenceVolumeNode->GetImageData()->GetMTime());
+  }
+  return mtime;
+}
+
+//----------------------------------------------------------------------------
+/// Get latest modified time of the target segment including all its representations
+vtkMTimeType GetTargetSegmentMTime(vtkMRMLSegmentationNode* segmentationNode, const char* segmentID)
+{
+  vtkMTimeType mtime = GetTransformableNodeMTime(segmentationNode);
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+  if (!segmentation)
+  {
+    return mtime;
+  }
+  mtime = std::max(mtime, segmentation->GetMTime());
+  vtkSegment* segment = (segmentID ? segmentation->GetSegment(segmentID) : nullptr);
+  if (!segment)
+  {
+    return mtime;
+  }
+  mtime = std::max(mtime, segment->GetMTime());
+  std::vector<std::string> representationNames;
+  segment->GetContainedRepresentationNames(representationNames);
+  for (const std::string& representationName : representationNames)
+  {
+    vtkDataObject* representation = segment->GetRepresentation(representationName);
+    if (representation)
+    {
+      mtime = std::max(mtime, representation->GetMTime());
+    }
+  }
+  return mtime;
+}
+}
+
 //----------------------------------------------------------------------------
 qSlicerPlmProtonDoseEngine::qSlicerPlmProtonDoseEngine(QObject* parent)
   : qSlicerAbstractDoseEngine(parent)
+  , m_InputCache(new qSlicerPlmProtonDoseEngineInputCache())
 {
   this->m_Name = QString("Plastimatch proton");
 }
@@ -64,6 +162,12 @@ qSlicerPlmProtonDoseEngine::qSlicerPlmProtonDoseEngine(QObject* parent)
 //----------------------------------------------------------------------------
 qSlicerPlmProtonDoseEngine::~qSlicerPlmProtonDoseEngine() = default;
 
+//----------------------------------------------------------------------------
+void qSlicerPlmProtonDoseEngine::clearInputCache()
+{
+  this->m_InputCache.reset(new qSlicerPlmProtonDoseEngineInputCache());
+}
+
 //---------------------------------------------------------------------------
 void qSlicerPlmProtonDoseEngine::defineBeamParameters()
 {
@@ -162,23 +266,48 @@ QString qSlicerPlmProtonDoseEngine::calculateDoseUsingEngine(vtkMRMLRTBeamNode*
 
   vtkMRMLScene* scene = beamNode->GetScene();
 
-  // Get target as ITK image
-  vtkSmartPointer<vtkOrientedImageData> targetLabelmap = parentPlanNode->GetTargetOrientedImageData();
-  if (targetLabelmap.GetPointer() == nullptr)
+  // Converted inputs are shared by the beams of the same plan
+  qSlicerPlmProtonDoseEngineInputCache* cache = this->m_InputCache.data();
+  if (cache->PlanNode != parentPlanNode)
   {
-    QString errorMessage("Failed to access target labelmap");
-    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
-    return errorMessage;
+    this->clearInputCache();
+    cache = this->m_InputCache.data();
+    cache->PlanNode = parentPlanNode;
   }
-  Plm_image::Pointer targetPlmVolume = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(targetLabelmap);
-  if (!targetPlmVolume)
+
+  // Get target as ITK image
+  vtkMRMLSegmentationNode* targetSegmentationNode = parentPlanNode->GetSegmentationNode();
+  const char* targetSegmentID = parentPlanNode->GetTargetSegmentID();
+  vtkMTimeType targetTime = (targetSegmentationNode ? GetTargetSegmentMTime(targetSegmentationNode, targetSegmentID) : 0);
+  if ( !cache->TargetItk || cache->TargetSegmentationNode != targetSegmentationNode
+    || cache->TargetSegmentID != (targetSegmentID ? targetSegmentID : "") || cache->TargetTime != targetTime )
   {
-    QString errorMessage("Failed to convert segment labelmap");
-    qCritical() << Q_FUNC_INFO << ": " << errorMessage;
-    return errorMessage;
+    cache->TargetPlm = nullptr;
+    cache->TargetItk = nullptr;
+
+    vtkSmartPointer<vtkOrientedImageData> targetLabelmap = parentPlanNode->GetTargetOrientedImageData();
+    if (targetLabelmap.GetPointer() == nullptr)
+    {
+      QString errorMessage("Failed to access target labelmap");
+      qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+      return errorMessage;
+    }
+    Plm_image::Pointer targetPlmVolume = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(targetLabelmap);
+    if (!targetPlmVolume)
+    {
+      QString errorMessage("Failed to convert segment labelmap");
+      qCritical() << Q_FUNC_INFO << ": " << errorMessage;
+      return errorMessage;
+    }
+    targetPlmVolume->print();
+
+    cache->TargetSegmentationNode = targetSegmentationNode;
+    cache->TargetSegmentID = (targetSegmentID ? targetSegmentID : "");
+    cache->TargetTime = targetTime;
+    cache->TargetPlm = targetPlmVolume;
+    cache->TargetItk = targetPlmVolume->itk_uchar();
   }
-  targetPlmVolume->print();
-  itk::Image<unsigned char, 3>::Pointer targetVolumeItk = targetPlmVolume->itk_uchar();
+  itk::Image<unsigned char, 3>::Pointer targetVolumeItk = cache->TargetItk;
 
   // Reference code for setting the geometry of the segmentation rasterization
   // in case the default one (from DICOM) is not desired
@@ -211,12 +340,21 @@ QString qSlicerPlmProtonDoseEngine::calculateDoseUsingEngine(vtkMRMLRTBeamNode*
     return errorMessage;
   }
 
-  // Convert reference volume to Plastimatch image
-  //TODO: Cache it so that it does not need to be reconverted every time
-  Plm_image::Pointer referenceVolumePlm = PlmCommon::ConvertVolumeNodeToPlmImage(referenceVolumeNode);
-  referenceVolumePlm->print();
-  // Create ITK output dose volume based on the reference volume
-  itk::Image<short, 3>::Pointer referenceVolumeItk = referenceVolumePlm->itk_short();
+  // Convert reference volume to Plastimatch image (only if not converted yet for the plan or modified since)
+  vtkMTimeType referenceVolumeTime = GetReferenceVolumeMTime(referenceVolumeNode);
+  if ( !cache->ReferenceVolumeItk || cache->ReferenceVolumeNode != referenceVolumeNode
+    || cache->ReferenceVolumeTime != referenceVolumeTime )
+  {
+    Plm_image::Pointer referenceVolumePlm = PlmCommon::ConvertVolumeNodeToPlmImage(referenceVolumeNode);
+    referenceVolumePlm->print();
+
+    cache->ReferenceVolumeNode = referenceVolumeNode;
+    cache->ReferenceVolumeTime = referenceVolumeTime;
+    cache->ReferenceVolumePlm = referenceVolumePlm;
+    // Create ITK output dose volume based on the reference volume
+    cache->ReferenceVolumeItk = referenceVolumePlm->itk_short();
+  }
+  itk::Image<short, 3>::Pointer referenceVolumeItk = cache->ReferenceVolumeItk;
 
   // Plastimatch RT plan and beam
   Plan_calc rt_plan;
@@ -27,6 +27,8 @@
 // ExternalBeamPlanning includes
 #include "qSlicerAbstractDoseEngine.h"
 
+class qSlicerPlmProtonDoseEngineInputCache;
+
 /// \ingroup SlicerRt_PlmProtonDoseEngine
 /// \brief Plastimatch proton dose calculation algorithm
 class Q_SLICER_PLMPROTONDOSEENGINE_DOSE_ENGINES_EXPORT qSlicerPlmProtonDoseEngine : public qSlicerAbstractDoseEngine
@@ -40,6 +42,10 @@ public:
   /// Destructor
   ~qSlicerPlmProtonDoseEngine() override;
 
+  /// Release the reference volume and target images converted for the last calculated plan.
+  /// They are reconverted automatically when the inputs change, so this is only needed to free memory.
+  Q_INVOKABLE void clearInputCache();
+
 protected:
   /// Calculate dose for a single beam. Called by \sa CalculateDose that performs actions generic
   /// to any dose engine before and after calculation.
@@ -51,6 +57,10 @@ protected:
   /// Define engine-specific beam parameters
   void defineBeamParameters();
 
+protected:
+  /// Plastimatch images converted from the inputs of the last calculated plan
+  QScopedPointer<qSlicerPlmProtonDoseEngineInputCache> m_InputCache;
+
 private:
   Q_DISABLE_COPY(qSlicerPlmProtonDoseEngine);
 };
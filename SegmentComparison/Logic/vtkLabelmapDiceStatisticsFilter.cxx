@@ -0,0 +1,533 @@
+#include "vtkLabelmapDiceStatisticsFilter.h"
+
+// SlicerRtCommon includes
+#include "vtkSlicerRtCommon.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// vtk includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+//----------------------------------------------------------------------------
+typedef uint64_t BitWord;
+const int BITS_PER_WORD = 64;
+
+/// Masks selecting the bits of a word whose position has the given bit set.
+/// Used for computing the sum of the positions of the set bits with population counts.
+const BitWord POSITION_BIT_MASKS[6] = {
+  0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+  0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull };
+
+//----------------------------------------------------------------------------
+inline vtkIdType PopCount(BitWord word)
+{
+  return static_cast<vtkIdType>(std::bitset<BITS_PER_WORD>(word).count());
+}
+
+//----------------------------------------------------------------------------
+/// Sum of the positions of the set bits in the word
+inline vtkIdType SumOfSetBitPositions(BitWord word)
+{
+  vtkIdType sum = 0;
+  for (int bit = 0; bit < 6; ++bit)
+  {
+    sum += PopCount(word & POSITION_BIT_MASKS[bit]) << bit;
+  }
+  return sum;
+}
+
+//----------------------------------------------------------------------------
+typedef vtkLabelmapDiceStatisticsFilter::PackedLabelmap PackedLabelmap;
+
+//----------------------------------------------------------------------------
+/// Index of the word holding the voxel with index I, rounded down also for negative indices
+inline int GetWordIndex(int i)
+{
+  return (i >= 0 ? i / BITS_PER_WORD : -((BITS_PER_WORD - 1 - i) / BITS_PER_WORD));
+}
+
+//----------------------------------------------------------------------------
+/// Set the bits of the nonzero voxels (first component) of the labelmap within the extent of the packed labelmap.
+/// The rows are packed in parallel
+template <class T>
+void PackLabelmapRows(vtkImageData* labelmap, T*, PackedLabelmap& packedLabelmap)
+{
+  const int* extent = packedLabelmap.Extent;
+  vtkIdType increments[3] = { 0, 0, 0 };
+  labelmap->GetIncrements(increments);
+  const T* extentStartPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], extent[2], extent[4]));
+  int numberOfRowsPerSlice = extent[3] - extent[2] + 1;
+  vtkIdType numberOfRows = static_cast<vtkIdType>(numberOfRowsPerSlice) * (extent[5] - extent[4] + 1);
+  int firstBitIndex = extent[0] - packedLabelmap.FirstWordIndex * BITS_PER_WORD;
+  int rowLength = extent[1] - extent[0] + 1;
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType beginRow, vtkIdType endRow)
+  {
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+    {
+      const T* imagePtr = extentStartPtr + (row % numberOfRowsPerSlice) * increments[1] + (row / numberOfRowsPerSlice) * increments[2];
+      BitWord* words = packedLabelmap.Words.data() + row * packedLabelmap.NumberOfWordsPerRow;
+      for (int bitIndex = firstBitIndex; bitIndex < firstBitIndex + rowLength; ++bitIndex)
+      {
+        if (*imagePtr != 0)
+        {
+          words[bitIndex / BITS_PER_WORD] |= (BitWord(1) << (bitIndex % BITS_PER_WORD));
+        }
+        imagePtr += increments[0];
+      }
+    }
+  });
+}
+
+//----------------------------------------------------------------------------
+/// Get the words of a row of a packed labelmap
+/// \return Pointer to the first word of the row, nullptr if the row is outside the extent
+inline const BitWord* GetPackedRow(const PackedLabelmap& packedLabelmap, int j, int k)
+{
+  const int* extent = packedLabelmap.Extent;
+  if (j < extent[2] || j > extent[3] || k < extent[4] || k > extent[5])
+  {
+    return nullptr;
+  }
+  vtkIdType row = static_cast<vtkIdType>(k - extent[4]) * (extent[3] - extent[2] + 1) + (j - extent[2]);
+  return packedLabelmap.Words.data() + row * packedLabelmap.NumberOfWordsPerRow;
+}
+
+//----------------------------------------------------------------------------
+/// Get a word of a packed row, zero if the word is outside the row
+inline BitWord GetPackedWord(const PackedLabelmap& packedLabelmap, const BitWord* rowWords, int wordIndex)
+{
+  int offset = wordIndex - packedLabelmap.FirstWordIndex;
+  return (rowWords && offset >= 0 && offset < packedLabelmap.NumberOfWordsPerRow ? rowWords[offset] : 0);
+}
+
+//----------------------------------------------------------------------------
+/// Check whether a packed labelmap has no nonzero voxels
+inline bool IsPackedLabelmapEmpty(const PackedLabelmap& packedLabelmap)
+{
+  return packedLabelmap.Words.empty();
+}
+
+//----------------------------------------------------------------------------
+/// Voxel counts and sums of voxel positions (IJK) of the reference and compare structures
+struct OverlapAccumulator
+{
+  vtkIdType NumberOfTruePositives{0};
+  vtkIdType NumberOfFalsePositives{0};
+  vtkIdType NumberOfFalseNegatives{0};
+  double ReferencePositionSum[3]{0.0, 0.0, 0.0};
+  double ComparePositionSum[3]{0.0, 0.0, 0.0};
+};
+
+//----------------------------------------------------------------------------
+/// Mask selecting the bits of the voxels with index I in [firstI, lastI] of the word with the given index
+inline BitWord GetWordMask(int wordIndex, int firstI, int lastI)
+{
+  int firstBit = std::max(firstI - wordIndex * BITS_PER_WORD, 0);
+  int lastBit = std::min(lastI - wordIndex * BITS_PER_WORD, BITS_PER_WORD - 1);
+  BitWord mask = ~BitWord(0) << firstBit;
+  if (lastBit < BITS_PER_WORD - 1)
+  {
+    mask &= (BitWord(1) << (lastBit + 1)) - 1;
+  }
+  return mask;
+}
+
+//----------------------------------------------------------------------------
+/// Accumulates the overlap statistics of the packed rows of the box of both labelmaps in parallel.
+/// Bits of the first and last words of the rows outside the box are ignored
+class DiceStatisticsFunctor
+{
+public:
+  DiceStatisticsFunctor(const PackedLabelmap& referencePackedLabelmap, const PackedLabelmap& comparePackedLabelmap, const int boxExtent[6])
+    : ReferencePackedLabelmap(referencePackedLabelmap)
+    , ComparePackedLabelmap(comparePackedLabelmap)
+  {
+    std::copy(boxExtent, boxExtent + 6, this->BoxExtent);
+    this->FirstWordIndex = GetWordIndex(boxExtent[0]);
+    this->LastWordIndex = GetWordIndex(boxExtent[1]);
+    this->FirstWordMask = GetWordMask(this->FirstWordIndex, boxExtent[0], boxExtent[1]);
+    this->LastWordMask = GetWordMask(this->LastWordIndex, boxExtent[0], boxExtent[1]);
+  }
+
+  void Initialize()
+  {
+    this->LocalAccumulator.Local() = OverlapAccumulator();
+  }
+
+  void operator()(vtkIdType beginRow, vtkIdType endRow)
+  {
+    OverlapAccumulator& accumulator = this->LocalAccumulator.Local();
+    int numberOfRowsPerSlice = this->BoxExtent[3] - this->BoxExtent[2] + 1;
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+    {
+      int j = this->BoxExtent[2] + static_cast<int>(row % numberOfRowsPerSlice);
+      int k = this->BoxExtent[4] + static_cast<int>(row / numberOfRowsPerSlice);
+      const BitWord* referenceWords = GetPackedRow(this->ReferencePackedLabelmap, j, k);
+      const BitWord* compareWords = GetPackedRow(this->ComparePackedLabelmap, j, k);
+      if (!referenceWords && !compareWords)
+      {
+        continue;
+      }
+
+      for (int wordIndex = this->FirstWordIndex; wordIndex <= this->LastWordIndex; ++wordIndex)
+      {
+        BitWord referenceWord = GetPackedWord(this->ReferencePackedLabelmap, referenceWords, wordIndex);
+        BitWord compareWord = GetPackedWord(this->ComparePackedLabelmap, compareWords, wordIndex);
+        if (wordIndex == this->FirstWordIndex)
+        {
+          referenceWord &= this->FirstWordMask;
+          compareWord &= this->FirstWordMask;
+        }
+        if (wordIndex == this->LastWordIndex)
+        {
+          referenceWord &= this->LastWordMask;
+          compareWord &= this->LastWordMask;
+        }
+        if (!(referenceWord | compareWord))
+        {
+          continue;
+        }
+        accumulator.NumberOfTruePositives += PopCount(referenceWord & compareWord);
+        accumulator.NumberOfFalsePositives += PopCount(~referenceWord & compareWord);
+        accumulator.NumberOfFalseNegatives += PopCount(referenceWord & ~compareWord);
+
+        double wordStartI = static_cast<double>(wordIndex) * BITS_PER_WORD;
+        vtkIdType numberOfReferenceVoxels = PopCount(referenceWord);
+        accumulator.ReferencePositionSum[0] += numberOfReferenceVoxels * wordStartI + SumOfSetBitPositions(referenceWord);
+        accumulator.ReferencePositionSum[1] += numberOfReferenceVoxels * static_cast<double>(j);
+        accumulator.ReferencePositionSum[2] += numberOfReferenceVoxels * static_cast<double>(k);
+        vtkIdType numberOfCompareVoxels = PopCount(compareWord);
+        accumulator.ComparePositionSum[0] += numberOfCompareVoxels * wordStartI + SumOfSetBitPositions(compareWord);
+        accumulator.ComparePositionSum[1] += numberOfCompareVoxels * static_cast<double>(j);
+        accumulator.ComparePositionSum[2] += numberOfCompareVoxels * static_cast<double>(k);
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    this->Result = OverlapAccumulator();
+    for (vtkSMPThreadLocal<OverlapAccumulator>::iterator localIt = this->LocalAccumulator.begin();
+      localIt != this->LocalAccumulator.end(); ++localIt)
+    {
+      this->Result.NumberOfTruePositives += (*localIt).NumberOfTruePositives;
+      this->Result.NumberOfFalsePositives += (*localIt).NumberOfFalsePositives;
+      this->Result.NumberOfFalseNegatives += (*localIt).NumberOfFalseNegatives;
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        this->Result.ReferencePositionSum[axis] += (*localIt).ReferencePositionSum[axis];
+        this->Result.ComparePositionSum[axis] += (*localIt).ComparePositionSum[axis];
+      }
+    }
+  }
+
+  OverlapAccumulator Result;
+
+private:
+  const PackedLabelmap& ReferencePackedLabelmap;
+  const PackedLabelmap& ComparePackedLabelmap;
+  int BoxExtent[6];
+  int FirstWordIndex;
+  int LastWordIndex;
+  BitWord FirstWordMask;
+  BitWord LastWordMask;
+  vtkSMPThreadLocal<OverlapAccumulator> LocalAccumulator;
+};
+
+//----------------------------------------------------------------------------
+/// Convert IJK position to world (RAS) position
+void ConvertIjkToWorld(vtkMatrix4x4* imageToWorldMatrix, const double ijk[3], double world[3])
+{
+  double ijkHomogeneous[4] = { ijk[0], ijk[1], ijk[2], 1.0 };
+  double worldHomogeneous[4] = { 0.0, 0.0, 0.0, 1.0 };
+  imageToWorldMatrix->MultiplyPoint(ijkHomogeneous, worldHomogeneous);
+  world[0] = worldHomogeneous[0];
+  world[1] = worldHomogeneous[1];
+  world[2] = worldHomogeneous[2];
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLabelmapDiceStatisticsFilter);
+
+//----------------------------------------------------------------------------
+vtkLabelmapDiceStatisticsFilter::vtkLabelmapDiceStatisticsFilter()
+  : InputReferencePackedLabelmap(nullptr)
+  , InputComparePackedLabelmap(nullptr)
+  , CountWithinReferenceExtent(false)
+  , DiceCoefficient(-1.0)
+  , NumberOfTruePositives(0)
+  , NumberOfTrueNegatives(0)
+  , NumberOfFalsePositives(0)
+  , NumberOfFalseNegatives(0)
+  , NumberOfVoxels(0)
+  , ReferenceVolumeCc(-1.0)
+  , CompareVolumeCc(-1.0)
+{
+  this->ReferenceCenter[0] = this->ReferenceCenter[1] = this->ReferenceCenter[2] = 0.0;
+  this->CompareCenter[0] = this->CompareCenter[1] = this->CompareCenter[2] = 0.0;
+}
+
+//----------------------------------------------------------------------------
+vtkLabelmapDiceStatisticsFilter::~vtkLabelmapDiceStatisticsFilter() = default;
+
+//----------------------------------------------------------------------------
+void vtkLabelmapDiceStatisticsFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "CountWithinReferenceExtent: " << (this->CountWithinReferenceExtent ? "true" : "false") << "\n";
+  os << indent << "DiceCoefficient: " << this->DiceCoefficient << "\n";
+  os << indent << "NumberOfTruePositives: " << this->NumberOfTruePositives << "\n";
+  os << indent << "NumberOfTrueNegatives: " << this->NumberOfTrueNegatives << "\n";
+  os << indent << "NumberOfFalsePositives: " << this->NumberOfFalsePositives << "\n";
+  os << indent << "NumberOfFalseNegatives: " << this->NumberOfFalseNegatives << "\n";
+  os << indent << "NumberOfVoxels: " << this->NumberOfVoxels << "\n";
+  os << indent << "ReferenceCenter: (" << this->ReferenceCenter[0] << ", " << this->ReferenceCenter[1] << ", " << this->ReferenceCenter[2] << ")\n";
+  os << indent << "CompareCenter: (" << this->CompareCenter[0] << ", " << this->CompareCenter[1] << ", " << this->CompareCenter[2] << ")\n";
+  os << indent << "ReferenceVolumeCc: " << this->ReferenceVolumeCc << "\n";
+  os << indent << "CompareVolumeCc: " << this->CompareVolumeCc << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapDiceStatisticsFilter::SetInputReferenceLabelmap(vtkOrientedImageData* labelmap)
+{
+  this->SetInputReferenceLabelmap(labelmap, nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapDiceStatisticsFilter::SetInputReferenceLabelmap(vtkOrientedImageData* labelmap, const PackedLabelmap* packedLabelmap)
+{
+  this->InputReferenceLabelmap = labelmap;
+  this->InputReferencePackedLabelmap = packedLabelmap;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkLabelmapDiceStatisticsFilter::GetInputReferenceLabelmap()
+{
+  return this->InputReferenceLabelmap;
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapDiceStatisticsFilter::SetInputCompareLabelmap(vtkOrientedImageData* labelmap)
+{
+  this->SetInputCompareLabelmap(labelmap, nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapDiceStatisticsFilter::SetInputCompareLabelmap(vtkOrientedImageData* labelmap, const PackedLabelmap* packedLabelmap)
+{
+  this->InputCompareLabelmap = labelmap;
+  this->InputComparePackedLabelmap = packedLabelmap;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapDiceStatisticsFilter::PackLabelmap(vtkOrientedImageData* labelmap, PackedLabelmap& packedLabelmap)
+{
+  packedLabelmap = PackedLabelmap();
+  if (!labelmap || !labelmap->GetPointData()->GetScalars())
+  {
+    vtkGenericWarningMacro("vtkLabelmapDiceStatisticsFilter::PackLabelmap: Invalid input labelmap");
+    return false;
+  }
+
+  int* extent = packedLabelmap.Extent;
+  if ( !vtkOrientedImageDataResample::CalculateEffectiveExtent(labelmap, extent)
+    || extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5] )
+  {
+    // Empty labelmap
+    int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    std::copy(emptyExtent, emptyExtent + 6, extent);
+    return true;
+  }
+  packedLabelmap.FirstWordIndex = GetWordIndex(extent[0]);
+  packedLabelmap.NumberOfWordsPerRow = GetWordIndex(extent[1]) - packedLabelmap.FirstWordIndex + 1;
+  packedLabelmap.Words.assign(static_cast<size_t>(packedLabelmap.NumberOfWordsPerRow)
+    * (extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1), 0);
+
+  switch (labelmap->GetScalarType())
+  {
+    vtkTemplateMacro(PackLabelmapRows<VTK_TT>(labelmap, static_cast<VTK_TT*>(nullptr), packedLabelmap));
+    default:
+      vtkGenericWarningMacro("vtkLabelmapDiceStatisticsFilter::PackLabelmap: Unsupported scalar type " << labelmap->GetScalarType());
+      packedLabelmap = PackedLabelmap();
+      return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkLabelmapDiceStatisticsFilter::GetInputCompareLabelmap()
+{
+  return this->InputCompareLabelmap;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapDiceStatisticsFilter::Update()
+{
+  this->DiceCoefficient = -1.0;
+  this->NumberOfTruePositives = this->NumberOfTrueNegatives = 0;
+  this->NumberOfFalsePositives = this->NumberOfFalseNegatives = 0;
+  this->NumberOfVoxels = 0;
+  this->ReferenceCenter[0] = this->ReferenceCenter[1] = this->ReferenceCenter[2] = 0.0;
+  this->CompareCenter[0] = this->CompareCenter[1] = this->CompareCenter[2] = 0.0;
+  this->ReferenceVolumeCc = -1.0;
+  this->CompareVolumeCc = -1.0;
+
+  vtkOrientedImageData* referenceLabelmap = this->InputReferenceLabelmap;
+  if (!referenceLabelmap || !referenceLabelmap->GetPointData()->GetScalars()
+    || !this->InputCompareLabelmap || !this->InputCompareLabelmap->GetPointData()->GetScalars())
+  {
+    vtkErrorMacro("Update: Invalid input labelmaps");
+    return false;
+  }
+
+  // Bring compare labelmap to the grid of the reference. Labelmaps with different extents on the same grid are used as they are
+  vtkSmartPointer<vtkOrientedImageData> compareLabelmap = this->InputCompareLabelmap;
+  const PackedLabelmap* comparePackedLabelmap = this->InputComparePackedLabelmap;
+  if (!vtkSlicerRtCommon::DoImageGridsMatch(referenceLabelmap, compareLabelmap))
+  {
+    compareLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+      this->InputCompareLabelmap, referenceLabelmap, compareLabelmap, false, true))
+    {
+      vtkErrorMacro("Update: Failed to resample compare labelmap to the grid of the reference labelmap");
+      return false;
+    }
+    comparePackedLabelmap = nullptr;
+  }
+
+  // Pack the voxels of the labelmaps that have not been packed by the caller
+  const PackedLabelmap* referencePackedLabelmap = this->InputReferencePackedLabelmap;
+  PackedLabelmap referencePackedLabelmapStorage;
+  PackedLabelmap comparePackedLabelmapStorage;
+  if (!referencePackedLabelmap)
+  {
+    if (!PackLabelmap(referenceLabelmap, referencePackedLabelmapStorage))
+    {
+      vtkErrorMacro("Update: Failed to pack reference labelmap");
+      return false;
+    }
+    referencePackedLabelmap = &referencePackedLabelmapStorage;
+  }
+  if (!comparePackedLabelmap)
+  {
+    if (!PackLabelmap(compareLabelmap, comparePackedLabelmapStorage))
+    {
+      vtkErrorMacro("Update: Failed to pack compare labelmap");
+      return false;
+    }
+    comparePackedLabelmap = &comparePackedLabelmapStorage;
+  }
+
+  // Number of counted voxels, for the true negatives. These are the voxels of the reference extent
+  // or of the smallest box containing the extents of the inputs
+  int referenceExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  referenceLabelmap->GetExtent(referenceExtent);
+  int compareExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  compareLabelmap->GetExtent(compareExtent);
+  this->NumberOfVoxels = 1;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (this->CountWithinReferenceExtent)
+    {
+      this->NumberOfVoxels *= std::max(referenceExtent[2*axis+1] - referenceExtent[2*axis] + 1, 0);
+    }
+    else
+    {
+      this->NumberOfVoxels *= std::max(referenceExtent[2*axis+1], compareExtent[2*axis+1])
+        - std::min(referenceExtent[2*axis], compareExtent[2*axis]) + 1;
+    }
+  }
+
+  // Bounding box of the nonzero voxels of both labelmaps
+  const int* referenceEffectiveExtent = referencePackedLabelmap->Extent;
+  bool referenceEmpty = IsPackedLabelmapEmpty(*referencePackedLabelmap);
+  const int* compareEffectiveExtent = comparePackedLabelmap->Extent;
+  bool compareEmpty = IsPackedLabelmapEmpty(*comparePackedLabelmap);
+  int boxExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  bool boxEmpty = (referenceEmpty && compareEmpty);
+  for (int axis = 0; axis < 3 && !boxEmpty; ++axis)
+  {
+    boxExtent[2*axis] = ( referenceEmpty ? compareEffectiveExtent[2*axis] : compareEmpty ? referenceEffectiveExtent[2*axis]
+      : std::min(referenceEffectiveExtent[2*axis], compareEffectiveExtent[2*axis]) );
+    boxExtent[2*axis+1] = ( referenceEmpty ? compareEffectiveExtent[2*axis+1] : compareEmpty ? referenceEffectiveExtent[2*axis+1]
+      : std::max(referenceEffectiveExtent[2*axis+1], compareEffectiveExtent[2*axis+1]) );
+    if (this->CountWithinReferenceExtent)
+    {
+      // Compare voxels outside the reference extent are not counted
+      boxExtent[2*axis] = std::max(boxExtent[2*axis], referenceExtent[2*axis]);
+      boxExtent[2*axis+1] = std::min(boxExtent[2*axis+1], referenceExtent[2*axis+1]);
+    }
+    boxEmpty = (boxExtent[2*axis] > boxExtent[2*axis+1]);
+  }
+  if (boxEmpty)
+  {
+    this->DiceCoefficient = 0.0;
+    this->NumberOfTrueNegatives = this->NumberOfVoxels;
+    this->ReferenceVolumeCc = 0.0;
+    this->CompareVolumeCc = 0.0;
+    return true;
+  }
+
+  // Count in one parallel pass over the rows of the box
+  vtkIdType numberOfRows = static_cast<vtkIdType>(boxExtent[3] - boxExtent[2] + 1) * (boxExtent[5] - boxExtent[4] + 1);
+  DiceStatisticsFunctor diceStatisticsFunctor(*referencePackedLabelmap, *comparePackedLabelmap, boxExtent);
+  vtkSMPTools::For(0, numberOfRows, diceStatisticsFunctor);
+  const OverlapAccumulator& result = diceStatisticsFunctor.Result;
+
+  this->NumberOfTruePositives = result.NumberOfTruePositives;
+  this->NumberOfFalsePositives = result.NumberOfFalsePositives;
+  this->NumberOfFalseNegatives = result.NumberOfFalseNegatives;
+  this->NumberOfTrueNegatives = this->NumberOfVoxels
+    - result.NumberOfTruePositives - result.NumberOfFalsePositives - result.NumberOfFalseNegatives;
+
+  vtkIdType numberOfReferenceVoxels = result.NumberOfTruePositives + result.NumberOfFalseNegatives;
+  vtkIdType numberOfCompareVoxels = result.NumberOfTruePositives + result.NumberOfFalsePositives;
+  this->DiceCoefficient = ( numberOfReferenceVoxels + numberOfCompareVoxels > 0
+    ? 2.0 * result.NumberOfTruePositives / (double)(numberOfReferenceVoxels + numberOfCompareVoxels) : 0.0 );
+
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  referenceLabelmap->GetSpacing(spacing);
+  double voxelVolumeCc = spacing[0] * spacing[1] * spacing[2] / 1000.0;
+  this->ReferenceVolumeCc = numberOfReferenceVoxels * voxelVolumeCc;
+  this->CompareVolumeCc = numberOfCompareVoxels * voxelVolumeCc;
+
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  referenceLabelmap->GetImageToWorldMatrix(imageToWorldMatrix);
+  if (numberOfReferenceVoxels > 0)
+  {
+    double referenceCenterIjk[3] = { 0.0, 0.0, 0.0 };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      referenceCenterIjk[axis] = result.ReferencePositionSum[axis] / numberOfReferenceVoxels;
+    }
+    ConvertIjkToWorld(imageToWorldMatrix, referenceCenterIjk, this->ReferenceCenter);
+  }
+  if (numberOfCompareVoxels > 0)
+  {
+    double compareCenterIjk[3] = { 0.0, 0.0, 0.0 };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      compareCenterIjk[axis] = result.ComparePositionSum[axis] / numberOfCompareVoxels;
+    }
+    ConvertIjkToWorld(imageToWorldMatrix, compareCenterIjk, this->CompareCenter);
+  }
+
+  return true;
+}
@@ -0,0 +1,163 @@
+#ifndef __vtkLabelmapDiceStatisticsFilter_h
+#define __vtkLabelmapDiceStatisticsFilter_h
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "vtkSlicerSegmentComparisonModuleLogicExport.h"
+
+// STD includes
+#include <cstdint>
+#include <vector>
+
+class vtkOrientedImageData;
+
+/// \class vtkLabelmapDiceStatisticsFilter
+/// \brief Compute Dice coefficient and overlap statistics of two binary labelmaps.
+///
+/// Only the bounding box of the nonzero voxels of the two labelmaps is processed, so the cost
+/// depends on the extent of the structures, not the size of the grid they are defined on.
+/// Each image row of the bounding box is packed into 64-bit words, and the true positive,
+/// false positive and false negative voxels, as well as the sums of the voxel positions for
+/// the centers of mass are counted with population count on the words. The rows are processed
+/// in parallel, and all results are computed in one pass. A labelmap compared to several others
+/// can be packed once by \sa PackLabelmap and set as input together with its packed voxels.
+///
+/// The labelmaps may have different extents on the same grid. Only if the compare labelmap has
+/// different spacing, origin or directions than the reference, it is resampled to the grid of the
+/// reference using nearest neighbor interpolation.
+///
+/// True negatives are the voxels outside both structures within the smallest box containing the
+/// extents of both inputs, so unlike the other results they depend on the extents of the inputs.
+/// If \sa CountWithinReferenceExtent is on, only the voxels within the extent of the reference
+/// labelmap are counted, the same way as the plastimatch Dice statistics that resample the compare
+/// image to the reference geometry.
+///
+/// Similarly to \sa vtkLabelmapSurfaceDistanceFilter, this class is not a VTK pipeline filter.
+class VTK_SLICER_SEGMENTCOMPARISON_MODULE_LOGIC_EXPORT vtkLabelmapDiceStatisticsFilter : public vtkObject
+{
+public:
+  static vtkLabelmapDiceStatisticsFilter *New();
+  vtkTypeMacro(vtkLabelmapDiceStatisticsFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set the reference labelmap. Voxels with nonzero value are inside the structure
+  void SetInputReferenceLabelmap(vtkOrientedImageData* labelmap);
+  /// Get the reference labelmap
+  vtkOrientedImageData* GetInputReferenceLabelmap();
+
+  /// Set the compare labelmap. Voxels with nonzero value are inside the structure
+  void SetInputCompareLabelmap(vtkOrientedImageData* labelmap);
+  /// Get the compare labelmap
+  vtkOrientedImageData* GetInputCompareLabelmap();
+
+#ifndef __VTK_WRAP__
+  /// Nonzero voxels of a labelmap packed into 64-bit words row by row within its effective extent.
+  /// Word W of a row holds the voxels with index I from 64*W to 64*W+63, so the words of labelmaps
+  /// on the same grid can be combined directly
+  struct PackedLabelmap
+  {
+    /// Effective extent of the labelmap. Empty if the labelmap has no nonzero voxels
+    int Extent[6]{0, -1, 0, -1, 0, -1};
+    /// Index of the first word of the rows
+    int FirstWordIndex{0};
+    /// Number of words per row
+    int NumberOfWordsPerRow{0};
+    /// Words of the rows within the extent, the rows of a slice following each other
+    std::vector<uint64_t> Words;
+  };
+
+  /// Pack the nonzero voxels (first component) of a labelmap into bits
+  /// \return Success flag
+  static bool PackLabelmap(vtkOrientedImageData* labelmap, PackedLabelmap& packedLabelmap);
+
+  /// Set the reference labelmap with its voxels already packed by \sa PackLabelmap.
+  /// The packed labelmap is not copied, it has to be kept until the update
+  void SetInputReferenceLabelmap(vtkOrientedImageData* labelmap, const PackedLabelmap* packedLabelmap);
+  /// Set the compare labelmap with its voxels already packed by \sa PackLabelmap.
+  /// The packed labelmap is not copied, it has to be kept until the update
+  void SetInputCompareLabelmap(vtkOrientedImageData* labelmap, const PackedLabelmap* packedLabelmap);
+#endif
+
+  /// Set/get whether only the voxels within the extent of the reference labelmap are counted,
+  /// including the true negatives. Off by default, when the smallest box containing the extents
+  /// of both inputs is used
+  vtkGetMacro(CountWithinReferenceExtent, bool);
+  vtkSetMacro(CountWithinReferenceExtent, bool);
+  vtkBooleanMacro(CountWithinReferenceExtent, bool);
+
+  /// Compute statistics
+  /// \return Success flag
+  bool Update();
+
+  /// Get Dice coefficient. 0 if both structures are empty
+  double GetDiceCoefficient() { return this->DiceCoefficient; };
+
+  /// Get number of voxels inside both structures
+  vtkIdType GetNumberOfTruePositives() { return this->NumberOfTruePositives; };
+  /// Get number of voxels outside both structures, within the counted voxels \sa GetNumberOfVoxels
+  vtkIdType GetNumberOfTrueNegatives() { return this->NumberOfTrueNegatives; };
+  /// Get number of voxels inside the compare but outside the reference structure
+  vtkIdType GetNumberOfFalsePositives() { return this->NumberOfFalsePositives; };
+  /// Get number of voxels inside the reference but outside the compare structure
+  vtkIdType GetNumberOfFalseNegatives() { return this->NumberOfFalseNegatives; };
+  /// Get number of counted voxels. These are the voxels in the extent of the reference labelmap if
+  /// \sa CountWithinReferenceExtent is on, otherwise in the smallest box containing the extents of the inputs
+  vtkIdType GetNumberOfVoxels() { return this->NumberOfVoxels; };
+
+  /// Get center of mass of the reference structure in world (RAS) coordinates
+  vtkGetVector3Macro(ReferenceCenter, double);
+  /// Get center of mass of the compare structure in world (RAS) coordinates
+  vtkGetVector3Macro(CompareCenter, double);
+
+  /// Get volume of the reference structure in cc
+  double GetReferenceVolumeCc() { return this->ReferenceVolumeCc; };
+  /// Get volume of the compare structure in cc
+  double GetCompareVolumeCc() { return this->CompareVolumeCc; };
+
+protected:
+  vtkLabelmapDiceStatisticsFilter();
+  ~vtkLabelmapDiceStatisticsFilter() override;
+
+protected:
+  /// Reference labelmap
+  vtkSmartPointer<vtkOrientedImageData> InputReferenceLabelmap;
+  /// Compare labelmap
+  vtkSmartPointer<vtkOrientedImageData> InputCompareLabelmap;
+#ifndef __VTK_WRAP__
+  /// Packed voxels of the reference labelmap, packed in the update if not set
+  const PackedLabelmap* InputReferencePackedLabelmap;
+  /// Packed voxels of the compare labelmap, packed in the update if not set
+  const PackedLabelmap* InputComparePackedLabelmap;
+#endif
+
+  /// Flag whether only the voxels within the extent of the reference labelmap are counted
+  bool CountWithinReferenceExtent;
+
+  /// Dice coefficient
+  double DiceCoefficient;
+  /// Number of true positive voxels
+  vtkIdType NumberOfTruePositives;
+  /// Number of true negative voxels
+  vtkIdType NumberOfTrueNegatives;
+  /// Number of false positive voxels
+  vtkIdType NumberOfFalsePositives;
+  /// Number of false negative voxels
+  vtkIdType NumberOfFalseNegatives;
+  /// Number of counted voxels
+  vtkIdType NumberOfVoxels;
+  /// Center of mass of the reference structure
+  double ReferenceCenter[3];
+  /// Center of mass of the compare structure
+  double CompareCenter[3];
+  /// Volume of the reference structure
+  double ReferenceVolumeCc;
+  /// Volume of the compare structure
+  double CompareVolumeCc;
+
+private:
+  vtkLabelmapDiceStatisticsFilter(const vtkLabelmapDiceStatisticsFilter&) = delete;
+  void operator=(const vtkLabelmapDiceStatisticsFilter&) = delete;
+};
+
+#endif
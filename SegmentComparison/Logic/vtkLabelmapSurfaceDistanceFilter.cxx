@@ -0,0 +1,341 @@
+#include "vtkLabelmapSurfaceDistanceFilter.h"
+
+// SlicerRtCommon includes
+#include "vtkLabelmapDistanceTransform.h"
+#include "vtkSlicerRtCommon.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// vtk includes
+#include <vtkFloatArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// Get indices of boundary voxels of a mask: foreground voxels with a 6-neighbor that is
+/// background or outside the box
+void GetBoundaryVoxels(const std::vector<unsigned char>& mask, const int dimensions[3], std::vector<vtkIdType>& boundaryVoxels)
+{
+  vtkIdType increments[3] = { 1, dimensions[0], static_cast<vtkIdType>(dimensions[0]) * dimensions[1] };
+  boundaryVoxels.clear();
+  vtkIdType voxelIndex = 0;
+  for (int k = 0; k < dimensions[2]; ++k)
+  {
+    for (int j = 0; j < dimensions[1]; ++j)
+    {
+      for (int i = 0; i < dimensions[0]; ++i, ++voxelIndex)
+      {
+        if (!mask[voxelIndex])
+        {
+          continue;
+        }
+        int ijk[3] = { i, j, k };
+        bool boundary = false;
+        for (int axis = 0; axis < 3 && !boundary; ++axis)
+        {
+          boundary = ( ijk[axis] == 0 || ijk[axis] == dimensions[axis] - 1
+            || !mask[voxelIndex - increments[axis]] || !mask[voxelIndex + increments[axis]] );
+        }
+        if (boundary)
+        {
+          boundaryVoxels.push_back(voxelIndex);
+        }
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+/// Get the value at the given percentile of the values (the values are reordered)
+double GetPercentile(std::vector<double>& values, double percent)
+{
+  if (values.empty())
+  {
+    return 0.0;
+  }
+  vtkIdType percentileIndex = vtkMath::Round( (percent / 100.0) * (values.size() - 1) );
+  std::nth_element(values.begin(), values.begin() + percentileIndex, values.end());
+  return values[percentileIndex];
+}
+
+//----------------------------------------------------------------------------
+/// Create distance map image on the box from squared distances
+vtkSmartPointer<vtkOrientedImageData> CreateDistanceMap(const std::vector<double>& squaredDistances,
+  vtkOrientedImageData* geometryImage, const int boxExtent[6])
+{
+  vtkSmartPointer<vtkOrientedImageData> distanceMap = vtkSmartPointer<vtkOrientedImageData>::New();
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  geometryImage->GetImageToWorldMatrix(imageToWorldMatrix);
+  distanceMap->SetImageToWorldMatrix(imageToWorldMatrix);
+  distanceMap->SetExtent(const_cast<int*>(boxExtent));
+  distanceMap->AllocateScalars(VTK_FLOAT, 1);
+  float* distanceMapPtr = static_cast<float*>(distanceMap->GetScalarPointer());
+  vtkSMPTools::For(0, static_cast<vtkIdType>(squaredDistances.size()), [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType voxelIndex = begin; voxelIndex < end; ++voxelIndex)
+    {
+      distanceMapPtr[voxelIndex] = static_cast<float>(sqrt(squaredDistances[voxelIndex]));
+    }
+  });
+  return distanceMap;
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLabelmapSurfaceDistanceFilter);
+
+//----------------------------------------------------------------------------
+vtkLabelmapSurfaceDistanceFilter::vtkLabelmapSurfaceDistanceFilter()
+  : ComputeDistanceMaps(false)
+  , MaximumHausdorffDistanceMm(-1.0)
+  , AverageHausdorffDistanceMm(-1.0)
+  , Percent95HausdorffDistanceMm(-1.0)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkLabelmapSurfaceDistanceFilter::~vtkLabelmapSurfaceDistanceFilter() = default;
+
+//----------------------------------------------------------------------------
+void vtkLabelmapSurfaceDistanceFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "ComputeDistanceMaps: " << (this->ComputeDistanceMaps ? "true" : "false") << "\n";
+  os << indent << "MaximumHausdorffDistanceMm: " << this->MaximumHausdorffDistanceMm << "\n";
+  os << indent << "AverageHausdorffDistanceMm: " << this->AverageHausdorffDistanceMm << "\n";
+  os << indent << "Percent95HausdorffDistanceMm: " << this->Percent95HausdorffDistanceMm << "\n";
+  for (unsigned int toleranceIndex = 0; toleranceIndex < this->SurfaceDiceTolerancesMm.size(); ++toleranceIndex)
+  {
+    os << indent << "SurfaceDice (" << this->SurfaceDiceTolerancesMm[toleranceIndex] << " mm): "
+      << (toleranceIndex < this->SurfaceDice.size() ? this->SurfaceDice[toleranceIndex] : -1.0) << "\n";
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapSurfaceDistanceFilter::SetInputReferenceLabelmap(vtkOrientedImageData* labelmap)
+{
+  this->InputReferenceLabelmap = labelmap;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkLabelmapSurfaceDistanceFilter::GetInputReferenceLabelmap()
+{
+  return this->InputReferenceLabelmap;
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapSurfaceDistanceFilter::SetInputCompareLabelmap(vtkOrientedImageData* labelmap)
+{
+  this->InputCompareLabelmap = labelmap;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkLabelmapSurfaceDistanceFilter::GetInputCompareLabelmap()
+{
+  return this->InputCompareLabelmap;
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapSurfaceDistanceFilter::AddSurfaceDiceToleranceMm(double toleranceMm)
+{
+  this->SurfaceDiceTolerancesMm.push_back(toleranceMm);
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapSurfaceDistanceFilter::RemoveAllSurfaceDiceTolerances()
+{
+  this->SurfaceDiceTolerancesMm.clear();
+}
+
+//----------------------------------------------------------------------------
+int vtkLabelmapSurfaceDistanceFilter::GetNumberOfSurfaceDiceTolerances()
+{
+  return static_cast<int>(this->SurfaceDiceTolerancesMm.size());
+}
+
+//----------------------------------------------------------------------------
+double vtkLabelmapSurfaceDistanceFilter::GetSurfaceDiceToleranceMm(int toleranceIndex)
+{
+  if (toleranceIndex < 0 || toleranceIndex >= static_cast<int>(this->SurfaceDiceTolerancesMm.size()))
+  {
+    vtkErrorMacro("GetSurfaceDiceToleranceMm: Invalid tolerance index " << toleranceIndex);
+    return 0.0;
+  }
+  return this->SurfaceDiceTolerancesMm[toleranceIndex];
+}
+
+//----------------------------------------------------------------------------
+double vtkLabelmapSurfaceDistanceFilter::GetSurfaceDice(int toleranceIndex)
+{
+  if (toleranceIndex < 0 || toleranceIndex >= static_cast<int>(this->SurfaceDice.size()))
+  {
+    vtkErrorMacro("GetSurfaceDice: Invalid tolerance index " << toleranceIndex << ". Need to call Update after setting the tolerances.");
+    return -1.0;
+  }
+  return this->SurfaceDice[toleranceIndex];
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkLabelmapSurfaceDistanceFilter::GetOutputReferenceDistanceMap()
+{
+  return this->OutputReferenceDistanceMap;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkLabelmapSurfaceDistanceFilter::GetOutputCompareDistanceMap()
+{
+  return this->OutputCompareDistanceMap;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapSurfaceDistanceFilter::Update()
+{
+  this->MaximumHausdorffDistanceMm = -1.0;
+  this->AverageHausdorffDistanceMm = -1.0;
+  this->Percent95HausdorffDistanceMm = -1.0;
+  this->SurfaceDice.clear();
+  this->OutputReferenceDistanceMap = nullptr;
+  this->OutputCompareDistanceMap = nullptr;
+
+  vtkOrientedImageData* referenceLabelmap = this->InputReferenceLabelmap;
+  if (!referenceLabelmap || !referenceLabelmap->GetPointData()->GetScalars()
+    || !this->InputCompareLabelmap || !this->InputCompareLabelmap->GetPointData()->GetScalars())
+  {
+    vtkErrorMacro("Update: Invalid input labelmaps");
+    return false;
+  }
+
+  // Bring compare labelmap to the grid of the reference. Labelmaps with different extents on the same grid are used as they are
+  vtkSmartPointer<vtkOrientedImageData> compareLabelmap = this->InputCompareLabelmap;
+  if (!vtkSlicerRtCommon::DoImageGridsMatch(referenceLabelmap, compareLabelmap))
+  {
+    compareLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+      this->InputCompareLabelmap, referenceLabelmap, compareLabelmap, false, true))
+    {
+      vtkErrorMacro("Update: Failed to resample compare labelmap to the grid of the reference labelmap");
+      return false;
+    }
+  }
+
+  // Determine union bounding box of the structures, with a margin of one voxel so that the
+  // structures do not touch the edge of the box
+  int referenceEffectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  int compareEffectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if ( !vtkOrientedImageDataResample::CalculateEffectiveExtent(referenceLabelmap, referenceEffectiveExtent)
+    || !vtkOrientedImageDataResample::CalculateEffectiveExtent(compareLabelmap, compareEffectiveExtent)
+    || referenceEffectiveExtent[0] > referenceEffectiveExtent[1] || compareEffectiveExtent[0] > compareEffectiveExtent[1] )
+  {
+    vtkErrorMacro("Update: Reference or compare labelmap is empty");
+    return false;
+  }
+  int boxExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  int boxDimensions[3] = { 0, 0, 0 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    boxExtent[2*axis] = std::min(referenceEffectiveExtent[2*axis], compareEffectiveExtent[2*axis]) - 1;
+    boxExtent[2*axis+1] = std::max(referenceEffectiveExtent[2*axis+1], compareEffectiveExtent[2*axis+1]) + 1;
+    boxDimensions[axis] = boxExtent[2*axis+1] - boxExtent[2*axis] + 1;
+  }
+  vtkIdType numberOfBoxVoxels = static_cast<vtkIdType>(boxDimensions[0]) * boxDimensions[1] * boxDimensions[2];
+
+  // Get masks and boundaries of the structures in the box
+  std::vector<unsigned char> referenceMask(numberOfBoxVoxels, 0);
+  if (!vtkLabelmapDistanceTransform::FillMaskFromImage(referenceLabelmap, boxExtent, referenceMask))
+  {
+    vtkErrorMacro("Update: Unsupported reference labelmap scalar type");
+    return false;
+  }
+  std::vector<unsigned char> compareMask(numberOfBoxVoxels, 0);
+  if (!vtkLabelmapDistanceTransform::FillMaskFromImage(compareLabelmap, boxExtent, compareMask))
+  {
+    vtkErrorMacro("Update: Unsupported compare labelmap scalar type");
+    return false;
+  }
+
+  std::vector<vtkIdType> referenceBoundaryVoxels;
+  GetBoundaryVoxels(referenceMask, boxDimensions, referenceBoundaryVoxels);
+  std::vector<vtkIdType> compareBoundaryVoxels;
+  GetBoundaryVoxels(compareMask, boxDimensions, compareBoundaryVoxels);
+  referenceMask.clear();
+  compareMask.clear();
+  if (referenceBoundaryVoxels.empty() || compareBoundaryVoxels.empty())
+  {
+    vtkErrorMacro("Update: Reference or compare labelmap is empty");
+    return false;
+  }
+
+  // Compute distance transforms of the boundaries
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  referenceLabelmap->GetSpacing(spacing);
+  std::vector<double> referenceSquaredDistances;
+  vtkLabelmapDistanceTransform::ComputeSquaredDistanceTransform(referenceBoundaryVoxels, boxDimensions, spacing, referenceSquaredDistances);
+  std::vector<double> compareSquaredDistances;
+  vtkLabelmapDistanceTransform::ComputeSquaredDistanceTransform(compareBoundaryVoxels, boxDimensions, spacing, compareSquaredDistances);
+
+  // Directed boundary distances
+  std::vector<double> referenceToCompareDistances(referenceBoundaryVoxels.size());
+  for (size_t index = 0; index < referenceBoundaryVoxels.size(); ++index)
+  {
+    referenceToCompareDistances[index] = sqrt(compareSquaredDistances[referenceBoundaryVoxels[index]]);
+  }
+  std::vector<double> compareToReferenceDistances(compareBoundaryVoxels.size());
+  for (size_t index = 0; index < compareBoundaryVoxels.size(); ++index)
+  {
+    compareToReferenceDistances[index] = sqrt(referenceSquaredDistances[compareBoundaryVoxels[index]]);
+  }
+
+  // Metrics
+  double referenceToCompareSum = 0.0;
+  double compareToReferenceSum = 0.0;
+  double maximumDistance = 0.0;
+  std::vector<vtkIdType> numberOfDistancesWithinTolerance(this->SurfaceDiceTolerancesMm.size(), 0);
+  for (const std::vector<double>* distances : { &referenceToCompareDistances, &compareToReferenceDistances })
+  {
+    double sum = 0.0;
+    for (double distance : *distances)
+    {
+      sum += distance;
+      maximumDistance = std::max(maximumDistance, distance);
+      for (size_t toleranceIndex = 0; toleranceIndex < this->SurfaceDiceTolerancesMm.size(); ++toleranceIndex)
+      {
+        if (distance <= this->SurfaceDiceTolerancesMm[toleranceIndex])
+        {
+          ++numberOfDistancesWithinTolerance[toleranceIndex];
+        }
+      }
+    }
+    (distances == &referenceToCompareDistances ? referenceToCompareSum : compareToReferenceSum) = sum;
+  }
+  this->MaximumHausdorffDistanceMm = maximumDistance;
+  this->AverageHausdorffDistanceMm = 0.5 * ( referenceToCompareSum / referenceToCompareDistances.size()
+    + compareToReferenceSum / compareToReferenceDistances.size() );
+  this->Percent95HausdorffDistanceMm = std::max(
+    GetPercentile(referenceToCompareDistances, 95.0), GetPercentile(compareToReferenceDistances, 95.0) );
+  vtkIdType numberOfBoundaryVoxels = referenceBoundaryVoxels.size() + compareBoundaryVoxels.size();
+  for (size_t toleranceIndex = 0; toleranceIndex < this->SurfaceDiceTolerancesMm.size(); ++toleranceIndex)
+  {
+    this->SurfaceDice.push_back( numberOfDistancesWithinTolerance[toleranceIndex] / (double)numberOfBoundaryVoxels );
+  }
+
+  // Distance maps
+  if (this->ComputeDistanceMaps)
+  {
+    this->OutputReferenceDistanceMap = CreateDistanceMap(referenceSquaredDistances, referenceLabelmap, boxExtent);
+    this->OutputCompareDistanceMap = CreateDistanceMap(compareSquaredDistances, referenceLabelmap, boxExtent);
+  }
+
+  return true;
+}
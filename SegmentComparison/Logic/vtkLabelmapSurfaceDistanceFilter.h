@@ -0,0 +1,122 @@
+#ifndef __vtkLabelmapSurfaceDistanceFilter_h
+#define __vtkLabelmapSurfaceDistanceFilter_h
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "vtkSlicerSegmentComparisonModuleLogicExport.h"
+
+// STD includes
+#include <vector>
+
+class vtkOrientedImageData;
+
+/// \class vtkLabelmapSurfaceDistanceFilter
+/// \brief Compute Hausdorff distances and surface Dice between two binary labelmaps.
+///
+/// The boundary (surface) voxels of each labelmap are the foreground voxels that have a
+/// background voxel among their 6 neighbors. A linear-time exact Euclidean distance transform
+/// of each boundary is computed, taking the anisotropic spacing into account. The distance
+/// transform is only computed on the union bounding box of the two labelmaps, so the cost
+/// depends on the extent of the structures, not the size of the grid they are defined on.
+/// The directed boundary distances of both labelmaps are read from these distance maps,
+/// and all metrics are computed from them in one pass.
+///
+/// The labelmaps may have different extents on the same grid. Only if the compare labelmap has
+/// different spacing, origin or directions than the reference, it is resampled to the grid of the
+/// reference using nearest neighbor interpolation.
+///
+/// Similarly to \sa vtkPolyDataDistanceHistogramFilter, this class is not a VTK pipeline filter.
+class VTK_SLICER_SEGMENTCOMPARISON_MODULE_LOGIC_EXPORT vtkLabelmapSurfaceDistanceFilter : public vtkObject
+{
+public:
+  static vtkLabelmapSurfaceDistanceFilter *New();
+  vtkTypeMacro(vtkLabelmapSurfaceDistanceFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set the reference labelmap. Voxels with nonzero value are inside the structure
+  void SetInputReferenceLabelmap(vtkOrientedImageData* labelmap);
+  /// Get the reference labelmap
+  vtkOrientedImageData* GetInputReferenceLabelmap();
+
+  /// Set the compare labelmap. Voxels with nonzero value are inside the structure
+  void SetInputCompareLabelmap(vtkOrientedImageData* labelmap);
+  /// Get the compare labelmap
+  vtkOrientedImageData* GetInputCompareLabelmap();
+
+  /// Add tolerance (in mm) at which surface Dice is computed
+  void AddSurfaceDiceToleranceMm(double toleranceMm);
+  /// Remove all surface Dice tolerances
+  void RemoveAllSurfaceDiceTolerances();
+  /// Get number of surface Dice tolerances
+  int GetNumberOfSurfaceDiceTolerances();
+  /// Get surface Dice tolerance (in mm) with given index
+  double GetSurfaceDiceToleranceMm(int toleranceIndex);
+
+  /// Set whether the distance maps are stored in \sa GetOutputReferenceDistanceMap and
+  /// \sa GetOutputCompareDistanceMap. Off by default to save memory
+  vtkSetMacro(ComputeDistanceMaps, bool);
+  /// Get whether the distance maps are stored
+  vtkGetMacro(ComputeDistanceMaps, bool);
+  /// Set whether the distance maps are stored
+  vtkBooleanMacro(ComputeDistanceMaps, bool);
+
+  /// Compute distance transforms and metrics
+  /// \return Success flag
+  bool Update();
+
+  /// Get maximum of the boundary distances in both directions (traditional Hausdorff distance)
+  double GetMaximumHausdorffDistanceMm() { return this->MaximumHausdorffDistanceMm; };
+  /// Get average Hausdorff distance: average of the mean directed boundary distances
+  /// (corresponds to the 'average boundary Hausdorff distance' in plastimatch)
+  double GetAverageHausdorffDistanceMm() { return this->AverageHausdorffDistanceMm; };
+  /// Get 95% Hausdorff distance: maximum of the 95th percentile of the directed boundary distances
+  /// (corresponds to the 'percent boundary Hausdorff distance' in plastimatch)
+  double GetPercent95HausdorffDistanceMm() { return this->Percent95HausdorffDistanceMm; };
+
+  /// Get surface Dice at the tolerance with the given index: ratio of boundary voxels of both
+  /// labelmaps that are within the tolerance from the boundary of the other labelmap
+  double GetSurfaceDice(int toleranceIndex);
+
+  /// Get distance (in mm) of each voxel from the boundary of the reference labelmap.
+  /// Defined on the union bounding box of the inputs. Only computed if \sa ComputeDistanceMaps is on
+  vtkOrientedImageData* GetOutputReferenceDistanceMap();
+  /// Get distance (in mm) of each voxel from the boundary of the compare labelmap.
+  /// Defined on the union bounding box of the inputs. Only computed if \sa ComputeDistanceMaps is on
+  vtkOrientedImageData* GetOutputCompareDistanceMap();
+
+protected:
+  vtkLabelmapSurfaceDistanceFilter();
+  ~vtkLabelmapSurfaceDistanceFilter() override;
+
+protected:
+  /// Reference labelmap
+  vtkSmartPointer<vtkOrientedImageData> InputReferenceLabelmap;
+  /// Compare labelmap
+  vtkSmartPointer<vtkOrientedImageData> InputCompareLabelmap;
+
+  /// Tolerances (in mm) at which surface Dice is computed
+  std::vector<double> SurfaceDiceTolerancesMm;
+  /// Flag determining whether the distance maps are stored. Default is false
+  bool ComputeDistanceMaps;
+
+  /// Maximum Hausdorff distance
+  double MaximumHausdorffDistanceMm;
+  /// Average Hausdorff distance
+  double AverageHausdorffDistanceMm;
+  /// 95% Hausdorff distance
+  double Percent95HausdorffDistanceMm;
+  /// Surface Dice for each tolerance
+  std::vector<double> SurfaceDice;
+
+  /// Distance map of the reference boundary
+  vtkSmartPointer<vtkOrientedImageData> OutputReferenceDistanceMap;
+  /// Distance map of the compare boundary
+  vtkSmartPointer<vtkOrientedImageData> OutputCompareDistanceMap;
+
+private:
+  vtkLabelmapSurfaceDistanceFilter(const vtkLabelmapSurfaceDistanceFilter&) = delete;
+  void operator=(const vtkLabelmapSurfaceDistanceFilter&) = delete;
+};
+
+#endif
@@ -71,6 +71,11 @@ vtkMRMLSegmentComparisonNode::vtkMRMLSegmentComparisonNode()
   this->Percent95HausdorffDistanceForBoundaryMm = -1.0;
   this->HausdorffResultsValidOff();
 
+  this->UseBitPackedOverlap = false;
+  this->UseDistanceTransform = false;
+  this->SurfaceDiceToleranceMm = 1.0;
+  this->SurfaceDice = -1.0;
+
   this->HideFromEditors = false;
 }
 
@@ -130,6 +135,11 @@ void vtkMRMLSegmentComparisonNode::WriteXML(ostream& of, int nIndent)
   of << " Percent95HausdorffDistanceForBoundaryMm=\"" << this->Percent95HausdorffDistanceForBoundaryMm << "\"";
 
   of << " HausdorffResultsValid=\"" << (this->HausdorffResultsValid ? "true" : "false") << "\"";
+
+  of << " UseBitPackedOverlap=\"" << (this->UseBitPackedOverlap ? "true" : "false") << "\"";
+  of << " UseDistanceTransform=\"" << (this->UseDistanceTransform ? "true" : "false") << "\"";
+  of << " SurfaceDiceToleranceMm=\"" << this->SurfaceDiceToleranceMm << "\"";
+  of << " SurfaceDice=\"" << this->SurfaceDice << "\"";
 }
 
 //----------------------------------------------------------------------------
@@ -246,6 +256,22 @@ void vtkMRMLSegmentComparisonNode::ReadXMLAttributes(const char** atts)
       {
       this->HausdorffResultsValid = (strcmp(attValue,"true") ? false : true);
       }
+    else if (!strcmp(attName, "UseBitPackedOverlap")) 
+      {
+      this->UseBitPackedOverlap = (strcmp(attValue,"true") ? false : true);
+      }
+    else if (!strcmp(attName, "UseDistanceTransform")) 
+      {
+      this->UseDistanceTransform = (strcmp(attValue,"true") ? false : true);
+      }
+    else if (!strcmp(attName, "SurfaceDiceToleranceMm")) 
+      {
+      this->SurfaceDiceToleranceMm = vtkVariant(attValue).ToDouble();
+      }
+    else if (!strcmp(attName, "SurfaceDice")) 
+      {
+      this->SurfaceDice = vtkVariant(attValue).ToDouble();
+      }
     }
 }
 
@@ -278,6 +304,10 @@ void vtkMRMLSegmentComparisonNode::Copy(vtkMRMLNode *anode)
   this->Percent95HausdorffDistanceForVolumeMm = node->Percent95HausdorffDistanceForVolumeMm;
   this->Percent95HausdorffDistanceForBoundaryMm = node->Percent95HausdorffDistanceForBoundaryMm;
   this->HausdorffResultsValid = node->HausdorffResultsValid;
+  this->UseBitPackedOverlap = node->UseBitPackedOverlap;
+  this->UseDistanceTransform = node->UseDistanceTransform;
+  this->SurfaceDiceToleranceMm = node->SurfaceDiceToleranceMm;
+  this->SurfaceDice = node->SurfaceDice;
 
   this->DisableModifiedEventOff();
   this->InvokePendingModifiedEvent();
@@ -331,6 +361,11 @@ void vtkMRMLSegmentComparisonNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << " Percent95HausdorffDistanceForBoundaryMm:   " << this->Percent95HausdorffDistanceForBoundaryMm << "\n";
 
   os << indent << " HausdorffResultsValid:   " << (this->HausdorffResultsValid ? "true" : "false") << "\n";
+
+  os << indent << " UseBitPackedOverlap:   " << (this->UseBitPackedOverlap ? "true" : "false") << "\n";
+  os << indent << " UseDistanceTransform:   " << (this->UseDistanceTransform ? "true" : "false") << "\n";
+  os << indent << " SurfaceDiceToleranceMm:   " << this->SurfaceDiceToleranceMm << "\n";
+  os << indent << " SurfaceDice:   " << this->SurfaceDice << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -175,6 +175,28 @@ public:
   vtkSetMacro(HausdorffResultsValid, bool);
   vtkBooleanMacro(HausdorffResultsValid, bool);
 
+  /// Get/Set flag determining whether the Dice statistics are computed on the bit-packed bounding box
+  /// of the segment labelmaps instead of using plastimatch on the whole grid
+  vtkGetMacro(UseBitPackedOverlap, bool);
+  vtkSetMacro(UseBitPackedOverlap, bool);
+  vtkBooleanMacro(UseBitPackedOverlap, bool);
+
+  /// Get/Set flag determining whether the boundary Hausdorff distances and the surface Dice are
+  /// computed using distance transforms of the segment labelmaps instead of plastimatch
+  vtkGetMacro(UseDistanceTransform, bool);
+  vtkSetMacro(UseDistanceTransform, bool);
+  vtkBooleanMacro(UseDistanceTransform, bool);
+
+  /// Get tolerance (in mm) for the surface Dice
+  vtkGetMacro(SurfaceDiceToleranceMm, double);
+  /// Set tolerance (in mm) for the surface Dice
+  vtkSetMacro(SurfaceDiceToleranceMm, double);
+
+  /// Get surface Dice at \sa SurfaceDiceToleranceMm
+  vtkGetMacro(SurfaceDice, double);
+  /// Set surface Dice at \sa SurfaceDiceToleranceMm
+  vtkSetMacro(SurfaceDice, double);
+
 protected:
   vtkMRMLSegmentComparisonNode();
   ~vtkMRMLSegmentComparisonNode();
@@ -238,6 +260,21 @@ protected:
 
   /// Flag telling whether the Hausdorff results are valid
   bool HausdorffResultsValid;
+
+  /// Flag determining whether bit-packed overlap counting is used instead of plastimatch
+  /// for the Dice statistics. Off by default
+  bool UseBitPackedOverlap;
+
+  /// Flag determining whether distance transforms are used instead of plastimatch
+  /// for the boundary Hausdorff distances. Off by default
+  bool UseDistanceTransform;
+
+  /// Tolerance (in mm) for the surface Dice
+  double SurfaceDiceToleranceMm;
+
+  /// Surface Dice, i.e. ratio of the boundary voxels of both segments that are within
+  /// the tolerance from the boundary of the other segment. Only computed with distance transform
+  double SurfaceDice;
 };
 
 #endif
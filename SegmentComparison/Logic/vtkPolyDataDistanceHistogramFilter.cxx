@@ -1,19 +1,210 @@
 #include "vtkPolyDataDistanceHistogramFilter.h"
 
 // vtk includes
+#include <vtkCellData.h>
 #include <vtkDataObject.h>
-#include <vtkImageAccumulate.h>
-#include <vtkImageData.h>
-#include <vtkImplicitPolyDataDistance.h>
+#include <vtkGenericCell.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
 #include <vtkIntArray.h>
 #include <vtkMath.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPolyDataNormals.h>
 #include <vtkPolyDataPointSampler.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPThreadLocalObject.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
-#include <vtkSortDataArray.h>
+#include <vtkStaticCellLocator.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkTriangleFilter.h>
+
+// STD includes
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+/// Weight under which the closest point is considered to be on an edge or vertex of its triangle
+const double ON_EDGE_TOLERANCE = 1e-12;
+
+//----------------------------------------------------------------------------
+/// Evaluates the signed distance from sample points to a surface in parallel, the same way as
+/// vtkImplicitPolyDataDistance. The surface is triangulated and its normals and cell locator are
+/// built once before the loop, then shared read-only by the threads. Each thread only keeps its
+/// own cell for the closest point queries of the locator.
+class PointToSurfaceDistanceFunctor
+{
+public:
+  PointToSurfaceDistanceFunctor(vtkPolyData* surface, vtkPoints* samplePoints, double* distances)
+    : SamplePoints(samplePoints)
+    , Distances(distances)
+  {
+    vtkSmartPointer<vtkTriangleFilter> triangleFilter = vtkSmartPointer<vtkTriangleFilter>::New();
+    triangleFilter->PassVertsOff();
+    triangleFilter->PassLinesOff();
+    triangleFilter->SetInputData(surface);
+
+    // Point normals give the direction on edges and vertices, cell normals inside the triangles
+    vtkSmartPointer<vtkPolyDataNormals> normalFilter = vtkSmartPointer<vtkPolyDataNormals>::New();
+    normalFilter->SetInputConnection(triangleFilter->GetOutputPort());
+    normalFilter->ComputePointNormalsOn();
+    normalFilter->ComputeCellNormalsOn();
+    normalFilter->SplittingOff();
+    normalFilter->ConsistencyOn();
+    normalFilter->AutoOrientNormalsOff();
+    normalFilter->Update();
+    this->Surface = normalFilter->GetOutput();
+    this->PointNormals = this->Surface->GetPointData()->GetNormals();
+    this->CellNormals = this->Surface->GetCellData()->GetNormals();
+
+    this->Locator = vtkSmartPointer<vtkStaticCellLocator>::New();
+    this->Locator->SetDataSet(this->Surface);
+    if (this->Surface->GetNumberOfCells() > 0)
+    {
+      this->Locator->BuildLocator();
+    }
+  }
+
+  void Initialize()
+  {
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    vtkGenericCell* cell = this->Cell.Local();
+    double samplePoint[3] = { 0.0, 0.0, 0.0 };
+    for (vtkIdType pointId = begin; pointId < end; ++pointId)
+    {
+      this->SamplePoints->GetPoint(pointId, samplePoint);
+      this->Distances[pointId] = this->EvaluateDistance(samplePoint, cell);
+    }
+  }
+
+  void Reduce()
+  {
+  }
+
+private:
+  /// Signed distance of a point from the surface, negative if the point is on the side opposite to the normals
+  double EvaluateDistance(double point[3], vtkGenericCell* cell)
+  {
+    if (this->Surface->GetNumberOfCells() == 0)
+    {
+      return 0.0;
+    }
+    double closestPoint[3] = { 0.0, 0.0, 0.0 };
+    vtkIdType cellId = -1;
+    int subId = 0;
+    double distance2 = 0.0;
+    this->Locator->FindClosestPoint(point, closestPoint, cell, cellId, subId, distance2);
+    if (cellId < 0)
+    {
+      return 0.0;
+    }
+    double distance = sqrt(distance2);
+
+    double cellClosestPoint[3] = { 0.0, 0.0, 0.0 };
+    double parametricCoordinates[3] = { 0.0, 0.0, 0.0 };
+    double weights[3] = { 0.0, 0.0, 0.0 };
+    double cellDistance2 = 0.0;
+    cell->EvaluatePosition(closestPoint, cellClosestPoint, subId, parametricCoordinates, cellDistance2, weights);
+
+    double normal[3] = { 0.0, 0.0, 0.0 };
+    bool onEdgeOrVertex = false;
+    for (int i = 0; i < 3; ++i)
+    {
+      if (fabs(weights[i]) < ON_EDGE_TOLERANCE)
+      {
+        onEdgeOrVertex = true;
+      }
+    }
+    if (onEdgeOrVertex)
+    {
+      for (int i = 0; i < 3; ++i)
+      {
+        double pointNormal[3] = { 0.0, 0.0, 0.0 };
+        this->PointNormals->GetTuple(cell->GetPointId(i), pointNormal);
+        normal[0] += weights[i] * pointNormal[0];
+        normal[1] += weights[i] * pointNormal[1];
+        normal[2] += weights[i] * pointNormal[2];
+      }
+    }
+    else
+    {
+      this->CellNormals->GetTuple(cellId, normal);
+    }
+
+    double closestPointToPoint[3] = { point[0] - closestPoint[0], point[1] - closestPoint[1], point[2] - closestPoint[2] };
+    return (vtkMath::Dot(closestPointToPoint, normal) < 0.0 ? -distance : distance);
+  }
+
+  vtkSmartPointer<vtkPolyData> Surface;
+  vtkDataArray* PointNormals;
+  vtkDataArray* CellNormals;
+  vtkSmartPointer<vtkStaticCellLocator> Locator;
+  vtkPoints* SamplePoints;
+  double* Distances;
+  vtkSMPThreadLocalObject<vtkGenericCell> Cell;
+};
+
+//----------------------------------------------------------------------------
+/// Counts values into equally spaced bins in parallel. Bin i contains the values
+/// in [minimum + i*spacing, minimum + (i+1)*spacing), values outside the bins are ignored.
+class HistogramFunctor
+{
+public:
+  HistogramFunctor(const double* values, double minimum, double spacing, int numberOfBins)
+    : Values(values)
+    , Minimum(minimum)
+    , Spacing(spacing)
+    , NumberOfBins(numberOfBins)
+  {
+  }
+
+  void Initialize()
+  {
+    this->LocalFrequencies.Local().assign(this->NumberOfBins, 0);
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    std::vector<int>& frequencies = this->LocalFrequencies.Local();
+    for (vtkIdType valueIndex = begin; valueIndex < end; ++valueIndex)
+    {
+      int binIndex = vtkMath::Floor((this->Values[valueIndex] - this->Minimum) / this->Spacing);
+      if (binIndex >= 0 && binIndex < this->NumberOfBins)
+      {
+        ++frequencies[binIndex];
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    this->Frequencies.assign(this->NumberOfBins, 0);
+    for (vtkSMPThreadLocal<std::vector<int> >::iterator localIt = this->LocalFrequencies.begin();
+      localIt != this->LocalFrequencies.end(); ++localIt)
+    {
+      for (int binIndex = 0; binIndex < this->NumberOfBins; ++binIndex)
+      {
+        this->Frequencies[binIndex] += (*localIt)[binIndex];
+      }
+    }
+  }
+
+  /// Frequencies of the bins, available after executing the functor
+  std::vector<int> Frequencies;
+
+private:
+  const double* Values;
+  double Minimum;
+  double Spacing;
+  int NumberOfBins;
+  vtkSMPThreadLocal<std::vector<int> > LocalFrequencies;
+};
+}
 
 vtkStandardNewMacro(vtkPolyDataDistanceHistogramFilter);
 
@@ -198,15 +389,21 @@ double vtkPolyDataDistanceHistogramFilter::GetNthPercentileHausdorffDistance(dou
     return 0.0;
   }
 
-  vtkSmartPointer<vtkDoubleArray> sortedDistances = vtkSmartPointer<vtkDoubleArray>::New();
-  sortedDistances->DeepCopy(this->OutputDistances);
-
-  vtkSmartPointer<vtkSortDataArray> sortDataArray = vtkSmartPointer<vtkSortDataArray>::New();
-  sortDataArray->Sort(sortedDistances);
+  vtkIdType numberOfDistances = this->OutputDistances->GetNumberOfValues();
+  if (numberOfDistances == 0)
+  {
+    vtkErrorMacro("GetPercentNthHausdorffDistance: There are no output distances. Returning 0.0.");
+    return 0.0;
+  }
 
-  int nthPercentileIndex = vtkMath::Round( (n/ 100) * (sortedDistances->GetNumberOfValues() - 1) );
-  double percentileNthDistance = sortedDistances->GetValue( nthPercentileIndex );
-  return percentileNthDistance;
+  // Only the element at the percentile position needs to be in its sorted place, which
+  // is linear time instead of sorting all the distances
+  const double* distances = this->OutputDistances->GetPointer(0);
+  std::vector<double> partiallySortedDistances(distances, distances + numberOfDistances);
+  vtkIdType nthPercentileIndex = vtkMath::Round( (n/ 100) * (numberOfDistances - 1) );
+  std::nth_element(partiallySortedDistances.begin(), partiallySortedDistances.begin() + nthPercentileIndex,
+    partiallySortedDistances.end());
+  return partiallySortedDistances[nthPercentileIndex];
 }
 
 //----------------------------------------------------------------------------
@@ -253,18 +450,16 @@ void vtkPolyDataDistanceHistogramFilter::ComputeDistances(vtkPolyData* reference
   pointSampler->Update();  
   vtkPoints* samplingPoints = pointSampler->GetOutput()->GetPoints();
   
-  // generate the distance field
-  vtkSmartPointer<vtkImplicitPolyDataDistance> distanceField = vtkSmartPointer<vtkImplicitPolyDataDistance>::New();
-  distanceField->SetInput(referencePolyData);
-  
-  int numPoints = samplingPoints->GetNumberOfPoints();
-  for (int i = 0; i < numPoints; i++)
+  vtkIdType numPoints = (samplingPoints ? samplingPoints->GetNumberOfPoints() : 0);
+  distanceArray->SetNumberOfValues(numPoints);
+  if (numPoints == 0)
   {
-    double samplePoint[3];
-    samplingPoints->GetPoint(i,samplePoint);
-    double newDistance = distanceField->EvaluateFunction(samplePoint);
-    distanceArray->InsertNextTuple1(newDistance);
+    return;
   }
+
+  // evaluate the distance field at the sample points in parallel, directly into the output array
+  PointToSurfaceDistanceFunctor distanceFunctor(referencePolyData, samplingPoints, distanceArray->GetPointer(0));
+  vtkSMPTools::For(0, numPoints, distanceFunctor);
 }
 
 
@@ -279,35 +474,17 @@ void vtkPolyDataDistanceHistogramFilter::Update()
   vtkPolyData* inputPolyDataReference = this->GetInputReferencePolyData();
   vtkPolyData* inputPolyDataCompare = this->GetInputComparePolyData();
 
-  vtkSmartPointer<vtkDoubleArray> distances = vtkSmartPointer<vtkDoubleArray>::New(); // hold the distances in this array until we copy to the output
-  distances->SetName("Distances");
-  this->ComputeDistances(inputPolyDataReference, inputPolyDataCompare, distances);
-  
-  // copy the distances into a dummy image
-  vtkSmartPointer<vtkImageData> dummyImage = vtkSmartPointer<vtkImageData>::New();
-  int numberOfDoubleValues = distances->GetNumberOfTuples();
-  dummyImage->SetDimensions(numberOfDoubleValues,1,1);
-  dummyImage->AllocateScalars(VTK_DOUBLE,1);
-  double* distancesPointer = static_cast<double*>(distances->GetVoidPointer(0));
-  double* dummyImagePtr = static_cast<double*>(dummyImage->GetScalarPointer());
-  for (long i=0; i < numberOfDoubleValues; ++i)
-  {
-    (*dummyImagePtr) = (*distancesPointer);
-    ++distancesPointer;
-    ++dummyImagePtr;
-  }
+  // compute the distances directly into the output array
+  this->OutputDistances->Initialize();
+  this->OutputDistances->SetName("Distances");
+  this->ComputeDistances(inputPolyDataReference, inputPolyDataCompare, this->OutputDistances);
+  vtkIdType numberOfDistances = this->OutputDistances->GetNumberOfValues();
 
-  // set up the image accumulator for building the histogram
-  vtkSmartPointer<vtkImageAccumulate> imageAccumulator = vtkSmartPointer<vtkImageAccumulate>::New();
-  imageAccumulator->SetInputData(dummyImage);
-  double histogramBinMinimumArray[3] = {this->HistogramMinimum, 0.0, 0.0}; // the first component contains the minimum, other values are unused
-  imageAccumulator->SetComponentOrigin(histogramBinMinimumArray);
-  double histogramBinSpacingArray[3] = {this->HistogramSpacing, 1.0, 1.0}; // the first component contains the spacing, other values are unused
-  imageAccumulator->SetComponentSpacing(histogramBinSpacingArray);
+  // count the distances in the histogram bins
   int histogramBinExtent = vtkMath::Ceil((this->HistogramMaximum - this->HistogramMinimum) / this->HistogramSpacing);
-  int histogramBinExtentArray[6] = {0, histogramBinExtent, 0, 0, 0, 0}; // the first and second values contain the extent, others are unused
-  imageAccumulator->SetComponentExtent(histogramBinExtentArray);
-  imageAccumulator->Update();
+  HistogramFunctor histogramFunctor( (numberOfDistances > 0 ? this->OutputDistances->GetPointer(0) : nullptr),
+    this->HistogramMinimum, this->HistogramSpacing, histogramBinExtent + 1 );
+  vtkSMPTools::For(0, numberOfDistances, histogramFunctor);
 
   // create the bin array
   vtkSmartPointer<vtkDoubleArray> bins = vtkSmartPointer<vtkDoubleArray>::New();
@@ -319,12 +496,11 @@ void vtkPolyDataDistanceHistogramFilter::Update()
   }
 
   // create the frequencies array
-  vtkImageData* frequencyImage = imageAccumulator->GetOutput();
   vtkSmartPointer<vtkIntArray> frequencies = vtkSmartPointer<vtkIntArray>::New();
   frequencies->SetName("Frequencies");
   for (int i = 0; i <= histogramBinExtent; i++)
   {
-    int newFrequencyValue = (int)(frequencyImage->GetScalarComponentAsDouble(i,0,0,0));
+    int newFrequencyValue = (histogramFunctor.Frequencies.empty() ? 0 : histogramFunctor.Frequencies[i]);
     frequencies->InsertNextTuple1(newFrequencyValue);
   }
 
@@ -333,12 +509,6 @@ void vtkPolyDataDistanceHistogramFilter::Update()
   histogram->AddColumn(bins);
   histogram->AddColumn(frequencies);
 
-  // output the distances
-  //vtkInformation* outputInfoDistances = outputVector->GetInformationObject(OUTPUT_PORT_DISTANCES);
-  //vtkDoubleArray* outputDistances = vtkDoubleArray::SafeDownCast(outputInfoHistogram->Get(vtkDataObject::DATA_OBJECT()));
-  //outputDistances->DeepCopy(distances);
-  this->OutputDistances->DeepCopy(distances);
-
   // output the histogram
   this->OutputHistogram->DeepCopy(histogram);
 }
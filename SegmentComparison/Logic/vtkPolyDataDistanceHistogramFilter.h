@@ -134,6 +134,7 @@ protected:
 
 private:
   /// This method measures the raw distances from points on comparePolyData to referencePolyData, and stores them in distanceArray.
+  /// The sample points are evaluated in parallel, each thread using its own distance function.
   /// \param referencePolyData The reference vtkPolyData on which to compute the distances. Distances are measured from points on the comparePolyData to the referencePolyData.
   /// \param comparePolyData The compare vtkPolyData on which to compute the distances. Distances are measured from points on the comparePolyData to the referencePolyData.
   /// \param distanceArray The array in which to store the raw distances.
@@ -21,11 +21,16 @@
 // SegmentComparison includes
 #include "vtkSlicerSegmentComparisonModuleLogic.h"
 #include "vtkMRMLSegmentComparisonNode.h"
+#include "vtkLabelmapDiceStatisticsFilter.h"
+#include "vtkLabelmapSurfaceDistanceFilter.h"
 
 // Segmentations includes
 #include "vtkMRMLSegmentationNode.h"
 #include "vtkSlicerSegmentationsModuleLogic.h"
 
+// SlicerRT includes
+#include "vtkSlicerRtCommon.h"
+
 // SegmentationCore includes
 #include "vtkOrientedImageData.h"
 #include "vtkOrientedImageDataResample.h"
@@ -46,12 +51,48 @@
 #include <vtkMRMLScene.h>
 
 // VTK includes
+#include <vtkCollection.h>
+#include <vtkDoubleArray.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
 #include <vtkTimerLog.h>
 #include <vtkObjectFactory.h>
 #include <vtkStringArray.h>
 
+// STD includes
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+/// Copy the nonzero voxels of the first component of an image in the given extent into a binary mask
+/// \return Number of nonzero voxels
+template <class T>
+vtkIdType CopyToBinaryMask(vtkImageData* image, T*, const int extent[6], unsigned char* maskPtr)
+{
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+  vtkIdType numberOfNonzeroVoxels = 0;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+  {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+    {
+      T* imagePtr = static_cast<T*>(image->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; ++i)
+      {
+        *maskPtr = (*imagePtr != 0 ? 1 : 0);
+        numberOfNonzeroVoxels += *(maskPtr++);
+        imagePtr += numberOfComponents;
+      }
+    }
+  }
+  return numberOfNonzeroVoxels;
+}
+}
+
 //-----------------------------------------------------------------------------
 /// \ingroup SlicerRt_QtModules_SegmentComparison
 class vtkSlicerSegmentComparisonModuleLogicPrivate : public vtkObject
@@ -68,6 +109,34 @@ public:
     Plm_image::Pointer& plmCmpSegmentLabelmap,
     double &checkpointItkConvertStart);
 
+  /// Get input segments as binary labelmaps, with the parent transforms of the segmentations applied
+  /// \return Error message, empty string if no error
+  std::string GetInputSegmentLabelmaps(
+    vtkMRMLSegmentComparisonNode* parameterNode,
+    vtkOrientedImageData* referenceSegmentLabelmap,
+    vtkOrientedImageData* compareSegmentLabelmap);
+
+  /// Segment rasterized on the shared grid of a segment comparison matrix
+  struct RasterizedSegment
+  {
+    vtkMRMLSegmentationNode* SegmentationNode{nullptr};
+    std::string SegmentID;
+    /// Binary mask of the segment on the shared grid, cropped to the extent of the segment
+    vtkSmartPointer<vtkOrientedImageData> Mask;
+    /// Number of voxels in the segment
+    vtkIdType NumberOfVoxels{0};
+    /// Voxels of the mask packed into bits, for computing the Dice statistics of all pairs of the segment
+    vtkLabelmapDiceStatisticsFilter::PackedLabelmap PackedMask;
+  };
+
+  /// Rasterize all segments of the given segmentation on the shared grid, and append them to the list
+  /// \param sharedGeometryImage Image defining the shared grid. If empty, then it is set to the first segment
+  /// \return Error message, empty string if no error
+  std::string RasterizeSegmentsOnSharedGrid(
+    vtkMRMLSegmentationNode* segmentationNode,
+    vtkSmartPointer<vtkOrientedImageData>& sharedGeometryImage,
+    std::vector<RasterizedSegment>& rasterizedSegments);
+
   void SetLogic(vtkSlicerSegmentComparisonModuleLogic* logic) { this->Logic = logic; };
 
 protected:
@@ -167,6 +236,132 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
   return "";
 }
 
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentLabelmaps(
+  vtkMRMLSegmentComparisonNode* parameterNode,
+  vtkOrientedImageData* referenceSegmentLabelmap,
+  vtkOrientedImageData* compareSegmentLabelmap )
+{
+  if (!parameterNode || !this->Logic->GetMRMLScene() || !referenceSegmentLabelmap || !compareSegmentLabelmap)
+  {
+    std::string errorMessage("Invalid MRML scene, parameter set node, or output labelmaps");
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Get selection
+  vtkMRMLSegmentationNode* referenceSegmentationNode = parameterNode->GetReferenceSegmentationNode();
+  const char* referenceSegmentID = parameterNode->GetReferenceSegmentID();
+  vtkMRMLSegmentationNode* compareSegmentationNode = parameterNode->GetCompareSegmentationNode();
+  const char* compareSegmentID = parameterNode->GetCompareSegmentID();
+  if (!referenceSegmentationNode || !referenceSegmentID)
+  {
+    std::string errorMessage("Invalid reference segment selection");
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
+    return errorMessage;
+  }
+  if (!compareSegmentationNode || !compareSegmentID)
+  {
+    std::string errorMessage("Invalid compare segment selection");
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Get segment binary labelmaps in world coordinate system
+  if ( !referenceSegmentationNode->GetBinaryLabelmapRepresentation(referenceSegmentID, referenceSegmentLabelmap)
+    || !vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(referenceSegmentationNode, referenceSegmentLabelmap) )
+  {
+    std::string errorMessage("Failed to get binary labelmap from reference segment: " + std::string(referenceSegmentID));
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
+    return errorMessage;
+  }
+  if ( !compareSegmentationNode->GetBinaryLabelmapRepresentation(compareSegmentID, compareSegmentLabelmap)
+    || !vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(compareSegmentationNode, compareSegmentLabelmap) )
+  {
+    std::string errorMessage("Failed to get binary labelmap from compare segment: " + std::string(compareSegmentID));
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
+    return errorMessage;
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::RasterizeSegmentsOnSharedGrid(
+  vtkMRMLSegmentationNode* segmentationNode,
+  vtkSmartPointer<vtkOrientedImageData>& sharedGeometryImage,
+  std::vector<RasterizedSegment>& rasterizedSegments )
+{
+  std::vector<std::string> segmentIDs;
+  segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+  for (const std::string& segmentID : segmentIDs)
+  {
+    vtkSmartPointer<vtkOrientedImageData> segmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if ( !segmentationNode->GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap)
+      || !vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(segmentationNode, segmentLabelmap) )
+    {
+      std::string errorMessage("Failed to get binary labelmap from segment " + segmentID + " of segmentation " + std::string(segmentationNode->GetName()));
+      vtkErrorMacro("RasterizeSegmentsOnSharedGrid: " << errorMessage);
+      return errorMessage;
+    }
+
+    // Resample to the shared grid. Segments already on the grid are only cropped, whatever their extent
+    if (!sharedGeometryImage)
+    {
+      sharedGeometryImage = segmentLabelmap;
+    }
+    else if (!vtkSlicerRtCommon::DoImageGridsMatch(sharedGeometryImage, segmentLabelmap))
+    {
+      vtkSmartPointer<vtkOrientedImageData> resampledLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(segmentLabelmap, sharedGeometryImage, resampledLabelmap, false, true))
+      {
+        std::string errorMessage("Failed to resample segment " + segmentID + " of segmentation " + std::string(segmentationNode->GetName()));
+        vtkErrorMacro("RasterizeSegmentsOnSharedGrid: " << errorMessage);
+        return errorMessage;
+      }
+      segmentLabelmap = resampledLabelmap;
+    }
+
+    // Crop to the extent of the segment and convert to binary mask
+    RasterizedSegment rasterizedSegment;
+    rasterizedSegment.SegmentationNode = segmentationNode;
+    rasterizedSegment.SegmentID = segmentID;
+    rasterizedSegment.Mask = vtkSmartPointer<vtkOrientedImageData>::New();
+    vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+    segmentLabelmap->GetImageToWorldMatrix(imageToWorldMatrix);
+    rasterizedSegment.Mask->SetImageToWorldMatrix(imageToWorldMatrix);
+    int effectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    if ( segmentLabelmap->GetPointData()->GetScalars()
+      && vtkOrientedImageDataResample::CalculateEffectiveExtent(segmentLabelmap, effectiveExtent)
+      && effectiveExtent[0] <= effectiveExtent[1] && effectiveExtent[2] <= effectiveExtent[3] && effectiveExtent[4] <= effectiveExtent[5] )
+    {
+      rasterizedSegment.Mask->SetExtent(effectiveExtent);
+      rasterizedSegment.Mask->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+      unsigned char* maskPtr = static_cast<unsigned char*>(rasterizedSegment.Mask->GetScalarPointer());
+      switch (segmentLabelmap->GetScalarType())
+      {
+        vtkTemplateMacro(rasterizedSegment.NumberOfVoxels = CopyToBinaryMask<VTK_TT>(
+          segmentLabelmap, static_cast<VTK_TT*>(nullptr), effectiveExtent, maskPtr));
+        default:
+        {
+          std::string errorMessage("Unsupported scalar type in segment " + segmentID);
+          vtkErrorMacro("RasterizeSegmentsOnSharedGrid: " << errorMessage);
+          return errorMessage;
+        }
+      }
+      if (!vtkLabelmapDiceStatisticsFilter::PackLabelmap(rasterizedSegment.Mask, rasterizedSegment.PackedMask))
+      {
+        std::string errorMessage("Failed to pack voxels of segment " + segmentID);
+        vtkErrorMacro("RasterizeSegmentsOnSharedGrid: " << errorMessage);
+        return errorMessage;
+      }
+    }
+    rasterizedSegments.push_back(std::move(rasterizedSegment));
+  }
+
+  return "";
+}
+
 //-----------------------------------------------------------------------------
 // vtkSlicerSegmentComparisonModuleLogic methods
 
@@ -301,54 +496,106 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeDiceStatistics(vtkMRML
   UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
   double checkpointItkConvertStart = 0.0;
 
-  // Convert input images to the format Plastimatch can use
-  Plm_image::Pointer plmRefSegmentLabelmap;
-  Plm_image::Pointer plmCmpSegmentLabelmap;
-  std::string inputToPlmResult = this->LogicPrivate->GetInputSegmentsAsPlmVolumes(parameterNode, plmRefSegmentLabelmap, plmCmpSegmentLabelmap, checkpointItkConvertStart);
-  if (!inputToPlmResult.empty())
+  double checkpointDiceStart = 0.0;
+  UNUSED_VARIABLE(checkpointDiceStart); // Although it is used later, a warning is logged so needs to be suppressed
+  double diceCoefficient = -1.0;
+  double truePositivesPercent = -1.0;
+  double trueNegativesPercent = -1.0;
+  double falsePositivesPercent = -1.0;
+  double falseNegativesPercent = -1.0;
+  double referenceCenterArray[3] = { 0.0, 0.0, 0.0 };
+  double compareCenterArray[3] = { 0.0, 0.0, 0.0 };
+  double referenceVolumeCc = -1.0;
+  double compareVolumeCc = -1.0;
+  if (parameterNode->GetUseBitPackedOverlap())
   {
-    std::string errorMessage("Error occurred during ITK conversion");
-    vtkErrorMacro("ComputeDiceStatistics: " << errorMessage);
-    return errorMessage;
+    // Count overlap on the bit-packed bounding box of the segment labelmaps.
+    // Only the reference extent is counted, so that the percentages are normalized the same way as by plastimatch
+    checkpointItkConvertStart = timer->GetUniversalTime();
+    vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    std::string inputResult = this->LogicPrivate->GetInputSegmentLabelmaps(parameterNode, referenceSegmentLabelmap, compareSegmentLabelmap);
+    if (!inputResult.empty())
+    {
+      return inputResult;
+    }
+
+    checkpointDiceStart = timer->GetUniversalTime();
+    vtkNew<vtkLabelmapDiceStatisticsFilter> diceStatisticsFilter;
+    diceStatisticsFilter->SetInputReferenceLabelmap(referenceSegmentLabelmap);
+    diceStatisticsFilter->SetInputCompareLabelmap(compareSegmentLabelmap);
+    diceStatisticsFilter->CountWithinReferenceExtentOn();
+    if (!diceStatisticsFilter->Update())
+    {
+      std::string errorMessage("Failed to compute Dice statistics of the segments");
+      vtkErrorMacro("ComputeDiceStatistics: " << errorMessage);
+      return errorMessage;
+    }
+
+    double numberOfVoxels = diceStatisticsFilter->GetNumberOfVoxels();
+    diceCoefficient = diceStatisticsFilter->GetDiceCoefficient();
+    truePositivesPercent = diceStatisticsFilter->GetNumberOfTruePositives() * 100.0 / numberOfVoxels;
+    trueNegativesPercent = diceStatisticsFilter->GetNumberOfTrueNegatives() * 100.0 / numberOfVoxels;
+    falsePositivesPercent = diceStatisticsFilter->GetNumberOfFalsePositives() * 100.0 / numberOfVoxels;
+    falseNegativesPercent = diceStatisticsFilter->GetNumberOfFalseNegatives() * 100.0 / numberOfVoxels;
+    diceStatisticsFilter->GetReferenceCenter(referenceCenterArray);
+    diceStatisticsFilter->GetCompareCenter(compareCenterArray);
+    referenceVolumeCc = diceStatisticsFilter->GetReferenceVolumeCc();
+    compareVolumeCc = diceStatisticsFilter->GetCompareVolumeCc();
+  }
+  else
+  {
+    // Convert input images to the format Plastimatch can use
+    Plm_image::Pointer plmRefSegmentLabelmap;
+    Plm_image::Pointer plmCmpSegmentLabelmap;
+    std::string inputToPlmResult = this->LogicPrivate->GetInputSegmentsAsPlmVolumes(parameterNode, plmRefSegmentLabelmap, plmCmpSegmentLabelmap, checkpointItkConvertStart);
+    if (!inputToPlmResult.empty())
+    {
+      std::string errorMessage("Error occurred during ITK conversion");
+      vtkErrorMacro("ComputeDiceStatistics: " << errorMessage);
+      return errorMessage;
+    }
+
+    // Compute Dice similarity metrics
+    checkpointDiceStart = timer->GetUniversalTime();
+    Dice_statistics dice;
+    dice.set_reference_image(plmRefSegmentLabelmap->itk_uchar());
+    dice.set_compare_image(plmCmpSegmentLabelmap->itk_uchar());
+
+    dice.run();
+
+    unsigned long numberOfVoxels = dice.get_true_positives() 
+      + dice.get_true_negatives() + dice.get_false_positives()
+      + dice.get_false_negatives();
+
+    diceCoefficient = dice.get_dice();
+    truePositivesPercent = dice.get_true_positives() * 100.0 / (double)numberOfVoxels;
+    trueNegativesPercent = dice.get_true_negatives() * 100.0 / (double)numberOfVoxels;
+    falsePositivesPercent = dice.get_false_positives() * 100.0 / (double)numberOfVoxels;
+    falseNegativesPercent = dice.get_false_negatives() * 100.0 / (double)numberOfVoxels;
+
+    // Convert centers from LPS to RAS
+    itk::Vector<double, 3> referenceCenterItk = dice.get_reference_center();
+    referenceCenterArray[0] = - referenceCenterItk[0];
+    referenceCenterArray[1] = - referenceCenterItk[1];
+    referenceCenterArray[2] = referenceCenterItk[2];
+    itk::Vector<double, 3> compareCenterItk = dice.get_compare_center();
+    compareCenterArray[0] = - compareCenterItk[0];
+    compareCenterArray[1] = - compareCenterItk[1];
+    compareCenterArray[2] = compareCenterItk[2];
+
+    referenceVolumeCc = dice.get_reference_volume() / 1000.0;
+    compareVolumeCc = dice.get_compare_volume() / 1000.0;
   }
-
-  // Compute Dice similarity metrics
-  double checkpointDiceStart = timer->GetUniversalTime();
-  UNUSED_VARIABLE(checkpointDiceStart); // Although it is used later, a warning is logged so needs to be suppressed
-  Dice_statistics dice;
-  dice.set_reference_image(plmRefSegmentLabelmap->itk_uchar());
-  dice.set_compare_image(plmCmpSegmentLabelmap->itk_uchar());
-
-  dice.run();
-
-  unsigned long numberOfVoxels = dice.get_true_positives() 
-    + dice.get_true_negatives() + dice.get_false_positives()
-    + dice.get_false_negatives();
 
   // Set results to parameter set node
-  double diceCoefficient = dice.get_dice();
-  double truePositivesPercent = dice.get_true_positives() * 100.0 / (double)numberOfVoxels;
-  double trueNegativesPercent = dice.get_true_negatives() * 100.0 / (double)numberOfVoxels;
-  double falsePositivesPercent = dice.get_false_positives() * 100.0 / (double)numberOfVoxels;
-  double falseNegativesPercent = dice.get_false_negatives() * 100.0 / (double)numberOfVoxels;
   parameterNode->SetDiceCoefficient(diceCoefficient);
   parameterNode->SetTruePositivesPercent(truePositivesPercent);
   parameterNode->SetTrueNegativesPercent(trueNegativesPercent);
   parameterNode->SetFalsePositivesPercent(falsePositivesPercent);
   parameterNode->SetFalseNegativesPercent(falseNegativesPercent);
-
-  itk::Vector<double, 3> referenceCenterItk = dice.get_reference_center();
-  double referenceCenterArray[3] =
-    { - referenceCenterItk[0], - referenceCenterItk[1], referenceCenterItk[2] };
   parameterNode->SetReferenceCenter(referenceCenterArray);
-
-  itk::Vector<double, 3> compareCenterItk = dice.get_compare_center();
-  double compareCenterArray[3] =
-    { - compareCenterItk[0], - compareCenterItk[1], compareCenterItk[2] };
   parameterNode->SetCompareCenter(compareCenterArray);
-
-  double referenceVolumeCc = dice.get_reference_volume() / 1000.0;
-  double compareVolumeCc = dice.get_compare_volume() / 1000.0;
   parameterNode->SetReferenceVolumeCc(referenceVolumeCc);
   parameterNode->SetCompareVolumeCc(compareVolumeCc);
 
@@ -444,35 +691,76 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances(vtk
   double checkpointStart = timer->GetUniversalTime();
   UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
   double checkpointItkConvertStart = 0.0;
+  double checkpointHausdorffStart = 0.0;
+  UNUSED_VARIABLE(checkpointHausdorffStart); // Although it is used later, a warning is logged so needs to be suppressed
 
-  // Convert input images to the format Plastimatch can use
-  Plm_image::Pointer plmRefSegmentLabelmap;
-  Plm_image::Pointer plmCmpSegmentLabelmap;
-  std::string inputToPlmResult = this->LogicPrivate->GetInputSegmentsAsPlmVolumes(parameterNode, plmRefSegmentLabelmap, plmCmpSegmentLabelmap, checkpointItkConvertStart);
-  if (!inputToPlmResult.empty())
+  double maximumHausdorffDistanceForBoundaryMm = -1.0;
+  double averageHausdorffDistanceForBoundaryMm = -1.0;
+  double percent95HausdorffDistanceForBoundaryMm = -1.0;
+  if (parameterNode->GetUseDistanceTransform())
   {
-    std::string errorMessage("Error occurred during ITK conversion");
-    vtkErrorMacro("ComputeHausdorffDistances: " << errorMessage);
-    return errorMessage;
+    // Compute boundary distances from distance transforms of the labelmaps.
+    // The whole volume distances are not computed in this mode
+    checkpointItkConvertStart = timer->GetUniversalTime();
+    vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    std::string inputResult = this->LogicPrivate->GetInputSegmentLabelmaps(parameterNode, referenceSegmentLabelmap, compareSegmentLabelmap);
+    if (!inputResult.empty())
+    {
+      return inputResult;
+    }
+
+    checkpointHausdorffStart = timer->GetUniversalTime();
+    vtkNew<vtkLabelmapSurfaceDistanceFilter> surfaceDistanceFilter;
+    surfaceDistanceFilter->SetInputReferenceLabelmap(referenceSegmentLabelmap);
+    surfaceDistanceFilter->SetInputCompareLabelmap(compareSegmentLabelmap);
+    surfaceDistanceFilter->AddSurfaceDiceToleranceMm(parameterNode->GetSurfaceDiceToleranceMm());
+    if (!surfaceDistanceFilter->Update())
+    {
+      std::string errorMessage("Failed to compute surface distances of the segments");
+      vtkErrorMacro("ComputeHausdorffDistances: " << errorMessage);
+      return errorMessage;
+    }
+
+    maximumHausdorffDistanceForBoundaryMm = surfaceDistanceFilter->GetMaximumHausdorffDistanceMm();
+    averageHausdorffDistanceForBoundaryMm = surfaceDistanceFilter->GetAverageHausdorffDistanceMm();
+    percent95HausdorffDistanceForBoundaryMm = surfaceDistanceFilter->GetPercent95HausdorffDistanceMm();
+    parameterNode->SetMaximumHausdorffDistanceForVolumeMm(-1.0);
+    parameterNode->SetAverageHausdorffDistanceForVolumeMm(-1.0);
+    parameterNode->SetPercent95HausdorffDistanceForVolumeMm(-1.0);
+    parameterNode->SetSurfaceDice(surfaceDistanceFilter->GetSurfaceDice(0));
+  }
+  else
+  {
+    // Convert input images to the format Plastimatch can use
+    Plm_image::Pointer plmRefSegmentLabelmap;
+    Plm_image::Pointer plmCmpSegmentLabelmap;
+    std::string inputToPlmResult = this->LogicPrivate->GetInputSegmentsAsPlmVolumes(parameterNode, plmRefSegmentLabelmap, plmCmpSegmentLabelmap, checkpointItkConvertStart);
+    if (!inputToPlmResult.empty())
+    {
+      std::string errorMessage("Error occurred during ITK conversion");
+      vtkErrorMacro("ComputeHausdorffDistances: " << errorMessage);
+      return errorMessage;
+    }
+
+    // Compute Hausdorff distances
+    checkpointHausdorffStart = timer->GetUniversalTime();
+    Hausdorff_distance hausdorff;
+    hausdorff.set_reference_image(plmRefSegmentLabelmap->itk_uchar());
+    hausdorff.set_compare_image(plmCmpSegmentLabelmap->itk_uchar());
+    hausdorff.set_volume_boundary_behavior(ZERO_PADDING);
+    hausdorff.run();
+
+    maximumHausdorffDistanceForBoundaryMm = hausdorff.get_boundary_hausdorff();
+    averageHausdorffDistanceForBoundaryMm = hausdorff.get_avg_average_boundary_hausdorff();
+    percent95HausdorffDistanceForBoundaryMm = hausdorff.get_percent_boundary_hausdorff();
+    parameterNode->SetMaximumHausdorffDistanceForVolumeMm(hausdorff.get_hausdorff());
+    parameterNode->SetAverageHausdorffDistanceForVolumeMm(hausdorff.get_avg_average_hausdorff());
+    parameterNode->SetPercent95HausdorffDistanceForVolumeMm(hausdorff.get_percent_hausdorff());
+    parameterNode->SetSurfaceDice(-1.0);
   }
-
-  // Compute Hausdorff distances
-  double checkpointHausdorffStart = timer->GetUniversalTime();
-  UNUSED_VARIABLE(checkpointHausdorffStart); // Although it is used later, a warning is logged so needs to be suppressed
-  Hausdorff_distance hausdorff;
-  hausdorff.set_reference_image(plmRefSegmentLabelmap->itk_uchar());
-  hausdorff.set_compare_image(plmCmpSegmentLabelmap->itk_uchar());
-  hausdorff.set_volume_boundary_behavior(ZERO_PADDING);
-  hausdorff.run();
-
-  double maximumHausdorffDistanceForBoundaryMm = hausdorff.get_boundary_hausdorff();
-  double averageHausdorffDistanceForBoundaryMm = hausdorff.get_avg_average_boundary_hausdorff();
-  double percent95HausdorffDistanceForBoundaryMm = hausdorff.get_percent_boundary_hausdorff();
-  parameterNode->SetMaximumHausdorffDistanceForVolumeMm(hausdorff.get_hausdorff());
   parameterNode->SetMaximumHausdorffDistanceForBoundaryMm(maximumHausdorffDistanceForBoundaryMm);
-  parameterNode->SetAverageHausdorffDistanceForVolumeMm(hausdorff.get_avg_average_hausdorff());
   parameterNode->SetAverageHausdorffDistanceForBoundaryMm(averageHausdorffDistanceForBoundaryMm);
-  parameterNode->SetPercent95HausdorffDistanceForVolumeMm(hausdorff.get_percent_hausdorff());
   parameterNode->SetPercent95HausdorffDistanceForBoundaryMm(percent95HausdorffDistanceForBoundaryMm);
   parameterNode->HausdorffResultsValidOn();
 
@@ -493,6 +781,12 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances(vtk
     header->InsertNextValue("Maximum (mm)");
     header->InsertNextValue("Average (mm)");
     header->InsertNextValue("95% (mm)");
+    if (parameterNode->GetUseDistanceTransform())
+    {
+      std::stringstream surfaceDiceSs;
+      surfaceDiceSs << "Surface Dice (" << parameterNode->GetSurfaceDiceToleranceMm() << " mm)";
+      header->InsertNextValue(surfaceDiceSs.str());
+    }
 
     vtkStringArray* column = vtkStringArray::SafeDownCast(tableNode->AddColumn());
     column->SetName("Metric value");
@@ -510,6 +804,10 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances(vtk
     column->SetVariantValue(row++, vtkVariant(maximumHausdorffDistanceForBoundaryMm));
     column->SetVariantValue(row++, vtkVariant(averageHausdorffDistanceForBoundaryMm));
     column->SetVariantValue(row++, vtkVariant(percent95HausdorffDistanceForBoundaryMm));
+    if (parameterNode->GetUseDistanceTransform())
+    {
+      column->SetVariantValue(row++, vtkVariant(parameterNode->GetSurfaceDice()));
+    }
 
     // Trigger UI update
     tableNode->Modified();
@@ -527,3 +825,179 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances(vtk
 
   return "";
 }
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogic::ComputeSegmentComparisonMatrix(vtkCollection* segmentationNodes,
+  vtkMRMLTableNode* outputTableNode, vtkMRMLScalarVolumeNode* rasterizationReferenceVolumeNode/*=nullptr*/,
+  bool computeHausdorff/*=true*/, double surfaceDiceToleranceMm/*=1.0*/)
+{
+  if (!segmentationNodes || !outputTableNode || !this->GetMRMLScene())
+  {
+    std::string errorMessage("Invalid MRML scene, input segmentations, or output table node");
+    vtkErrorMacro("ComputeSegmentComparisonMatrix: " << errorMessage);
+    return errorMessage;
+  }
+
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  double checkpointStart = timer->GetUniversalTime();
+  UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
+
+  // Rasterize each segment once on the shared grid
+  vtkSmartPointer<vtkOrientedImageData> sharedGeometryImage;
+  if (rasterizationReferenceVolumeNode)
+  {
+    sharedGeometryImage = vtkSmartPointer<vtkOrientedImageData>::Take(
+      vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(rasterizationReferenceVolumeNode) );
+    if (!sharedGeometryImage.GetPointer())
+    {
+      std::string errorMessage("Failed to get geometry from rasterization reference volume");
+      vtkErrorMacro("ComputeSegmentComparisonMatrix: " << errorMessage);
+      return errorMessage;
+    }
+  }
+  std::vector<vtkSlicerSegmentComparisonModuleLogicPrivate::RasterizedSegment> rasterizedSegments;
+  int numberOfSegmentationNodes = 0;
+  for (int nodeIndex = 0; nodeIndex < segmentationNodes->GetNumberOfItems(); ++nodeIndex)
+  {
+    vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(segmentationNodes->GetItemAsObject(nodeIndex));
+    if (!segmentationNode)
+    {
+      continue;
+    }
+    std::string rasterizeResult = this->LogicPrivate->RasterizeSegmentsOnSharedGrid(segmentationNode, sharedGeometryImage, rasterizedSegments);
+    if (!rasterizeResult.empty())
+    {
+      return rasterizeResult;
+    }
+    ++numberOfSegmentationNodes;
+  }
+
+  // Collect segment pairs: segments of different segmentations, or all pairs if there is only one segmentation
+  std::vector<std::pair<size_t, size_t> > segmentPairs;
+  for (size_t referenceIndex = 0; referenceIndex < rasterizedSegments.size(); ++referenceIndex)
+  {
+    for (size_t compareIndex = referenceIndex + 1; compareIndex < rasterizedSegments.size(); ++compareIndex)
+    {
+      if ( numberOfSegmentationNodes == 1
+        || rasterizedSegments[referenceIndex].SegmentationNode != rasterizedSegments[compareIndex].SegmentationNode )
+      {
+        segmentPairs.push_back(std::make_pair(referenceIndex, compareIndex));
+      }
+    }
+  }
+  if (segmentPairs.empty())
+  {
+    std::string errorMessage("No segment pairs to compare");
+    vtkErrorMacro("ComputeSegmentComparisonMatrix: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Compute metrics of the segment pairs in parallel. The masks are all on the shared grid, so no resampling is done here.
+  // Nested parallelism is turned off, so the filters of each pair run single-threaded within the thread of the pair.
+  // The metrics of pairs with an empty segment are invalid (-1)
+  double checkpointComparisonStart = timer->GetUniversalTime();
+  UNUSED_VARIABLE(checkpointComparisonStart); // Although it is used later, a warning is logged so needs to be suppressed
+  vtkIdType numberOfPairs = static_cast<vtkIdType>(segmentPairs.size());
+  std::vector<double> diceCoefficients(numberOfPairs, -1.0);
+  std::vector<double> maximumHausdorffDistances(numberOfPairs, -1.0);
+  std::vector<double> averageHausdorffDistances(numberOfPairs, -1.0);
+  std::vector<double> percent95HausdorffDistances(numberOfPairs, -1.0);
+  std::vector<double> surfaceDices(numberOfPairs, -1.0);
+  vtkSMPTools::Config pairLoopConfig;
+  pairLoopConfig.NestedParallelism = false;
+  vtkSMPTools::LocalScope(pairLoopConfig, [&]()
+  {
+    vtkSMPTools::For(0, numberOfPairs, [&](vtkIdType beginPair, vtkIdType endPair)
+    {
+      for (vtkIdType pairIndex = beginPair; pairIndex < endPair; ++pairIndex)
+      {
+        const vtkSlicerSegmentComparisonModuleLogicPrivate::RasterizedSegment& referenceSegment = rasterizedSegments[segmentPairs[pairIndex].first];
+        const vtkSlicerSegmentComparisonModuleLogicPrivate::RasterizedSegment& compareSegment = rasterizedSegments[segmentPairs[pairIndex].second];
+        if (referenceSegment.NumberOfVoxels == 0 || compareSegment.NumberOfVoxels == 0)
+        {
+          continue;
+        }
+
+        vtkNew<vtkLabelmapDiceStatisticsFilter> diceStatisticsFilter;
+        diceStatisticsFilter->SetInputReferenceLabelmap(referenceSegment.Mask, &referenceSegment.PackedMask);
+        diceStatisticsFilter->SetInputCompareLabelmap(compareSegment.Mask, &compareSegment.PackedMask);
+        if (diceStatisticsFilter->Update())
+        {
+          diceCoefficients[pairIndex] = diceStatisticsFilter->GetDiceCoefficient();
+        }
+
+        if (computeHausdorff)
+        {
+          vtkNew<vtkLabelmapSurfaceDistanceFilter> surfaceDistanceFilter;
+          surfaceDistanceFilter->SetInputReferenceLabelmap(referenceSegment.Mask);
+          surfaceDistanceFilter->SetInputCompareLabelmap(compareSegment.Mask);
+          surfaceDistanceFilter->AddSurfaceDiceToleranceMm(surfaceDiceToleranceMm);
+          if (surfaceDistanceFilter->Update())
+          {
+            maximumHausdorffDistances[pairIndex] = surfaceDistanceFilter->GetMaximumHausdorffDistanceMm();
+            averageHausdorffDistances[pairIndex] = surfaceDistanceFilter->GetAverageHausdorffDistanceMm();
+            percent95HausdorffDistances[pairIndex] = surfaceDistanceFilter->GetPercent95HausdorffDistanceMm();
+            surfaceDices[pairIndex] = surfaceDistanceFilter->GetSurfaceDice(0);
+          }
+        }
+      }
+    });
+  });
+
+  // Set results to table node
+  outputTableNode->SetUseColumnNameAsColumnHeader(true);
+  outputTableNode->RemoveAllColumns();
+  const char* nameColumnNames[4] = { "Reference segmentation", "Reference segment", "Compare segmentation", "Compare segment" };
+  vtkStringArray* nameColumns[4] = { nullptr, nullptr, nullptr, nullptr };
+  for (int columnIndex = 0; columnIndex < 4; ++columnIndex)
+  {
+    vtkNew<vtkStringArray> column;
+    column->SetName(nameColumnNames[columnIndex]);
+    column->SetNumberOfValues(numberOfPairs);
+    outputTableNode->AddColumn(column);
+    nameColumns[columnIndex] = column;
+  }
+  for (vtkIdType pairIndex = 0; pairIndex < numberOfPairs; ++pairIndex)
+  {
+    const vtkSlicerSegmentComparisonModuleLogicPrivate::RasterizedSegment& referenceSegment = rasterizedSegments[segmentPairs[pairIndex].first];
+    const vtkSlicerSegmentComparisonModuleLogicPrivate::RasterizedSegment& compareSegment = rasterizedSegments[segmentPairs[pairIndex].second];
+    nameColumns[0]->SetValue(pairIndex, referenceSegment.SegmentationNode->GetName());
+    nameColumns[1]->SetValue(pairIndex, referenceSegment.SegmentID);
+    nameColumns[2]->SetValue(pairIndex, compareSegment.SegmentationNode->GetName());
+    nameColumns[3]->SetValue(pairIndex, compareSegment.SegmentID);
+  }
+
+  std::vector<std::pair<std::string, std::vector<double>*> > metricColumns;
+  metricColumns.push_back(std::make_pair(std::string("Dice coefficient"), &diceCoefficients));
+  if (computeHausdorff)
+  {
+    metricColumns.push_back(std::make_pair(std::string("Maximum Hausdorff (mm)"), &maximumHausdorffDistances));
+    metricColumns.push_back(std::make_pair(std::string("Average Hausdorff (mm)"), &averageHausdorffDistances));
+    metricColumns.push_back(std::make_pair(std::string("95% Hausdorff (mm)"), &percent95HausdorffDistances));
+    std::stringstream surfaceDiceSs;
+    surfaceDiceSs << "Surface Dice (" << surfaceDiceToleranceMm << " mm)";
+    metricColumns.push_back(std::make_pair(surfaceDiceSs.str(), &surfaceDices));
+  }
+  for (const std::pair<std::string, std::vector<double>*>& metricColumn : metricColumns)
+  {
+    vtkNew<vtkDoubleArray> column;
+    column->SetName(metricColumn.first.c_str());
+    column->SetNumberOfValues(numberOfPairs);
+    std::copy(metricColumn.second->begin(), metricColumn.second->end(), column->GetPointer(0));
+    outputTableNode->AddColumn(column);
+  }
+
+  // Trigger UI update
+  outputTableNode->Modified();
+
+  if (this->LogSpeedMeasurements)
+  {
+    double checkpointEnd = timer->GetUniversalTime();
+    UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
+    vtkDebugMacro("ComputeSegmentComparisonMatrix: Total computation time for " << numberOfPairs << " segment pairs: " << checkpointEnd-checkpointStart << " s\n"
+      << "\tRasterizing " << rasterizedSegments.size() << " segments: " << checkpointComparisonStart-checkpointStart << " s\n"
+      << "\tComparing segment pairs: " << checkpointEnd-checkpointComparisonStart << " s");
+  }
+
+  return "";
+}
@@ -32,7 +32,10 @@
 
 #include "vtkSlicerSegmentComparisonModuleLogicExport.h"
 
+class vtkCollection;
+class vtkMRMLScalarVolumeNode;
 class vtkMRMLSegmentComparisonNode;
+class vtkMRMLTableNode;
 class vtkSlicerSegmentComparisonModuleLogicPrivate;
 
 /// \ingroup SlicerRt_QtModules_SegmentComparison
@@ -53,6 +56,24 @@ public:
   /// \return Error message, empty string if no error
   std::string ComputeHausdorffDistances(vtkMRMLSegmentComparisonNode* parameterNode);
 
+  /// Compare the segments of multiple segmentations with each other (e.g. for inter-observer studies).
+  /// If more segmentations are given, then each segment is compared with every segment of the other
+  /// segmentations, otherwise all segments of the single segmentation are compared with each other.
+  /// Each segment is rasterized only once on a shared grid (the geometry of the rasterization reference
+  /// volume if given, otherwise the geometry of the first segment), and cropped to its extent. Segments
+  /// already on the shared grid are not resampled. Then the metrics of the segment pairs are computed on
+  /// the cropped masks without resampling. The pairs are processed in parallel, each by single-threaded
+  /// comparison filters.
+  /// \param segmentationNodes Collection of segmentation nodes containing the segments to compare
+  /// \param outputTableNode Table node into which one row is written for each segment pair
+  /// \param rasterizationReferenceVolumeNode Optional volume node defining the shared grid
+  /// \param computeHausdorff Flag determining whether boundary Hausdorff distances and surface Dice
+  ///   are computed in addition to the Dice coefficient
+  /// \param surfaceDiceToleranceMm Tolerance (in mm) for the surface Dice
+  /// \return Error message, empty string if no error
+  std::string ComputeSegmentComparisonMatrix(vtkCollection* segmentationNodes, vtkMRMLTableNode* outputTableNode,
+    vtkMRMLScalarVolumeNode* rasterizationReferenceVolumeNode=nullptr, bool computeHausdorff=true, double surfaceDiceToleranceMm=1.0);
+
 public:
   vtkGetMacro(LogSpeedMeasurements, bool);
   vtkSetMacro(LogSpeedMeasurements, bool);
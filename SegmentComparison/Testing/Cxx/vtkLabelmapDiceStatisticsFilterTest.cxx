@@ -0,0 +1,162 @@
+// Module includes
+#include "vtkLabelmapDiceStatisticsFilter.h"
+
+// Testing includes
+#include "LabelmapTestingUtilities.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+
+using namespace LabelmapTestingUtilities;
+
+//-----------------------------------------------------------------------------
+int vtkLabelmapDiceStatisticsFilterTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  // Labelmaps on the same grid with different extents. Rows are longer than 64 voxels
+  // so that the structures span multiple words
+  int referenceExtent[6] = { -20, 139, 0, 39, 0, 19 };
+  int compareExtent[6] = { 10, 169, -5, 34, 2, 21 };
+  vtkSmartPointer<vtkOrientedImageData> referenceLabelmap = CreateLabelmap(referenceExtent, [](int i, int j, int k)
+  {
+    double x = (i - 60.0) / 55.0;
+    double y = (j - 18.0) / 15.0;
+    double z = (k - 9.0) / 7.0;
+    return x*x + y*y + z*z < 1.0;
+  }, VTK_SHORT, 3.0);
+  vtkSmartPointer<vtkOrientedImageData> compareLabelmap = CreateLabelmap(compareExtent, [](int i, int j, int k)
+  {
+    return i >= 40 && i <= 150 && j >= 10 && j <= 30 && k >= 5 && k <= 15 && (i + j) % 7 != 0;
+  }, VTK_SHORT);
+
+  vtkSmartPointer<vtkLabelmapDiceStatisticsFilter> diceStatisticsFilter = vtkSmartPointer<vtkLabelmapDiceStatisticsFilter>::New();
+  diceStatisticsFilter->SetInputReferenceLabelmap(referenceLabelmap);
+  diceStatisticsFilter->SetInputCompareLabelmap(compareLabelmap);
+  if (!diceStatisticsFilter->Update())
+  {
+    std::cerr << "Failed to compute Dice statistics" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Compute expected values by brute force over the union of the extents
+  double truePositives = 0.0;
+  double falsePositives = 0.0;
+  double falseNegatives = 0.0;
+  double numberOfVoxels = 0.0;
+  double referenceSum[3] = { 0.0, 0.0, 0.0 };
+  double compareSum[3] = { 0.0, 0.0, 0.0 };
+  for (int k = std::min(referenceExtent[4], compareExtent[4]); k <= std::max(referenceExtent[5], compareExtent[5]); ++k)
+  {
+    for (int j = std::min(referenceExtent[2], compareExtent[2]); j <= std::max(referenceExtent[3], compareExtent[3]); ++j)
+    {
+      for (int i = std::min(referenceExtent[0], compareExtent[0]); i <= std::max(referenceExtent[1], compareExtent[1]); ++i)
+      {
+        bool inReference = IsInside(referenceLabelmap, i, j, k);
+        bool inCompare = IsInside(compareLabelmap, i, j, k);
+        truePositives += (inReference && inCompare ? 1 : 0);
+        falsePositives += (!inReference && inCompare ? 1 : 0);
+        falseNegatives += (inReference && !inCompare ? 1 : 0);
+        numberOfVoxels += 1;
+        int ijk[3] = { i, j, k };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          referenceSum[axis] += (inReference ? ORIGIN[axis] + ijk[axis] * SPACING[axis] : 0.0);
+          compareSum[axis] += (inCompare ? ORIGIN[axis] + ijk[axis] * SPACING[axis] : 0.0);
+        }
+      }
+    }
+  }
+  double numberOfReferenceVoxels = truePositives + falseNegatives;
+  double numberOfCompareVoxels = truePositives + falsePositives;
+  double voxelVolumeCc = SPACING[0] * SPACING[1] * SPACING[2] / 1000.0;
+
+  bool success = true;
+  success &= CheckValue("Dice coefficient", diceStatisticsFilter->GetDiceCoefficient(),
+    2.0 * truePositives / (numberOfReferenceVoxels + numberOfCompareVoxels));
+  success &= CheckValue("True positives", diceStatisticsFilter->GetNumberOfTruePositives(), truePositives);
+  success &= CheckValue("False positives", diceStatisticsFilter->GetNumberOfFalsePositives(), falsePositives);
+  success &= CheckValue("False negatives", diceStatisticsFilter->GetNumberOfFalseNegatives(), falseNegatives);
+  success &= CheckValue("True negatives", diceStatisticsFilter->GetNumberOfTrueNegatives(),
+    numberOfVoxels - truePositives - falsePositives - falseNegatives);
+  success &= CheckValue("Reference volume", diceStatisticsFilter->GetReferenceVolumeCc(), numberOfReferenceVoxels * voxelVolumeCc);
+  success &= CheckValue("Compare volume", diceStatisticsFilter->GetCompareVolumeCc(), numberOfCompareVoxels * voxelVolumeCc);
+  double* referenceCenter = diceStatisticsFilter->GetReferenceCenter();
+  double* compareCenter = diceStatisticsFilter->GetCompareCenter();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    success &= CheckValue("Reference center", referenceCenter[axis], referenceSum[axis] / numberOfReferenceVoxels);
+    success &= CheckValue("Compare center", compareCenter[axis], compareSum[axis] / numberOfCompareVoxels);
+  }
+
+  // Inputs packed once and reused give the same results
+  vtkLabelmapDiceStatisticsFilter::PackedLabelmap referencePackedLabelmap;
+  vtkLabelmapDiceStatisticsFilter::PackedLabelmap comparePackedLabelmap;
+  if ( !vtkLabelmapDiceStatisticsFilter::PackLabelmap(referenceLabelmap, referencePackedLabelmap)
+    || !vtkLabelmapDiceStatisticsFilter::PackLabelmap(compareLabelmap, comparePackedLabelmap) )
+  {
+    std::cerr << "Failed to pack labelmaps" << std::endl;
+    return EXIT_FAILURE;
+  }
+  double diceCoefficient = diceStatisticsFilter->GetDiceCoefficient();
+  vtkIdType numberOfTrueNegatives = diceStatisticsFilter->GetNumberOfTrueNegatives();
+  diceStatisticsFilter->SetInputReferenceLabelmap(referenceLabelmap, &referencePackedLabelmap);
+  diceStatisticsFilter->SetInputCompareLabelmap(compareLabelmap, &comparePackedLabelmap);
+  if (!diceStatisticsFilter->Update())
+  {
+    std::cerr << "Failed to compute Dice statistics of packed inputs" << std::endl;
+    return EXIT_FAILURE;
+  }
+  success &= CheckValue("Dice coefficient of packed inputs", diceStatisticsFilter->GetDiceCoefficient(), diceCoefficient);
+  success &= CheckValue("True negatives of packed inputs", diceStatisticsFilter->GetNumberOfTrueNegatives(), numberOfTrueNegatives);
+
+  // Counting only within the reference extent, as the plastimatch Dice statistics do.
+  // The compare structure extends beyond the reference extent along I
+  double truePositivesInReference = 0.0;
+  double falsePositivesInReference = 0.0;
+  double falseNegativesInReference = 0.0;
+  double numberOfVoxelsInReference = 0.0;
+  for (int k = referenceExtent[4]; k <= referenceExtent[5]; ++k)
+  {
+    for (int j = referenceExtent[2]; j <= referenceExtent[3]; ++j)
+    {
+      for (int i = referenceExtent[0]; i <= referenceExtent[1]; ++i)
+      {
+        bool inReference = IsInside(referenceLabelmap, i, j, k);
+        bool inCompare = IsInside(compareLabelmap, i, j, k);
+        truePositivesInReference += (inReference && inCompare ? 1 : 0);
+        falsePositivesInReference += (!inReference && inCompare ? 1 : 0);
+        falseNegativesInReference += (inReference && !inCompare ? 1 : 0);
+        numberOfVoxelsInReference += 1;
+      }
+    }
+  }
+  diceStatisticsFilter->CountWithinReferenceExtentOn();
+  if (!diceStatisticsFilter->Update())
+  {
+    std::cerr << "Failed to compute Dice statistics within the reference extent" << std::endl;
+    return EXIT_FAILURE;
+  }
+  success &= CheckValue("Number of voxels within reference extent", diceStatisticsFilter->GetNumberOfVoxels(), numberOfVoxelsInReference);
+  success &= CheckValue("True positives within reference extent", diceStatisticsFilter->GetNumberOfTruePositives(), truePositivesInReference);
+  success &= CheckValue("False positives within reference extent", diceStatisticsFilter->GetNumberOfFalsePositives(), falsePositivesInReference);
+  success &= CheckValue("False negatives within reference extent", diceStatisticsFilter->GetNumberOfFalseNegatives(), falseNegativesInReference);
+  success &= CheckValue("True negatives within reference extent", diceStatisticsFilter->GetNumberOfTrueNegatives(),
+    numberOfVoxelsInReference - truePositivesInReference - falsePositivesInReference - falseNegativesInReference);
+  success &= CheckValue("Dice coefficient within reference extent", diceStatisticsFilter->GetDiceCoefficient(),
+    2.0 * truePositivesInReference / (2.0 * truePositivesInReference + falsePositivesInReference + falseNegativesInReference));
+  diceStatisticsFilter->CountWithinReferenceExtentOff();
+
+  // Identical inputs
+  diceStatisticsFilter->SetInputCompareLabelmap(referenceLabelmap);
+  if (!diceStatisticsFilter->Update())
+  {
+    std::cerr << "Failed to compute Dice statistics of identical inputs" << std::endl;
+    return EXIT_FAILURE;
+  }
+  success &= CheckValue("Dice coefficient of identical inputs", diceStatisticsFilter->GetDiceCoefficient(), 1.0);
+  success &= CheckValue("False positives of identical inputs", diceStatisticsFilter->GetNumberOfFalsePositives(), 0.0);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
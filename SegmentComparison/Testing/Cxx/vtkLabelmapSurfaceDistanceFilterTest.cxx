@@ -0,0 +1,200 @@
+// Module includes
+#include "vtkLabelmapSurfaceDistanceFilter.h"
+
+// Testing includes
+#include "LabelmapTestingUtilities.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <vector>
+
+using namespace LabelmapTestingUtilities;
+
+namespace
+{
+const int DIMENSION = 24;
+const int EXTENT[6] = { 0, DIMENSION-1, 0, DIMENSION-1, 0, DIMENSION-1 };
+/// Tolerance of the distance maps, that are stored as float
+const double DISTANCE_MAP_TOLERANCE = 1e-4;
+
+//-----------------------------------------------------------------------------
+/// Boundary voxels (foreground voxels with a background 6-neighbor) computed the simple way
+std::vector<std::vector<int> > GetBoundaryVoxels(vtkOrientedImageData* labelmap)
+{
+  std::vector<std::vector<int> > boundaryVoxels;
+  for (int k = 0; k < DIMENSION; ++k)
+  {
+    for (int j = 0; j < DIMENSION; ++j)
+    {
+      for (int i = 0; i < DIMENSION; ++i)
+      {
+        if ( IsInside(labelmap, i, j, k)
+          && ( !IsInside(labelmap, i-1, j, k) || !IsInside(labelmap, i+1, j, k)
+            || !IsInside(labelmap, i, j-1, k) || !IsInside(labelmap, i, j+1, k)
+            || !IsInside(labelmap, i, j, k-1) || !IsInside(labelmap, i, j, k+1) ) )
+        {
+          boundaryVoxels.push_back({ i, j, k });
+        }
+      }
+    }
+  }
+  return boundaryVoxels;
+}
+
+//-----------------------------------------------------------------------------
+/// Brute force distance of a voxel from the closest boundary voxel
+double GetDistanceFromBoundary(const std::vector<int>& voxel, const std::vector<std::vector<int> >& boundaryVoxels)
+{
+  double minimumSquaredDistance = VTK_DOUBLE_MAX;
+  for (const std::vector<int>& boundaryVoxel : boundaryVoxels)
+  {
+    double squaredDistance = 0.0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      double difference = (voxel[axis] - boundaryVoxel[axis]) * SPACING[axis];
+      squaredDistance += difference * difference;
+    }
+    minimumSquaredDistance = std::min(minimumSquaredDistance, squaredDistance);
+  }
+  return sqrt(minimumSquaredDistance);
+}
+
+//-----------------------------------------------------------------------------
+double GetPercentile(std::vector<double> values, double percent)
+{
+  std::sort(values.begin(), values.end());
+  return values[vtkMath::Round((percent / 100.0) * (values.size() - 1))];
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkLabelmapSurfaceDistanceFilterTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  // Reference is an ellipsoid, compare is an off-center box overlapping with it
+  vtkSmartPointer<vtkOrientedImageData> referenceLabelmap = CreateLabelmap(EXTENT, [](int i, int j, int k)
+  {
+    double x = (i - 11.0) * SPACING[0];
+    double y = (j - 12.0) * SPACING[1];
+    double z = (k - 10.0) * SPACING[2];
+    return x*x + y*y + z*z < 64.0;
+  });
+  vtkSmartPointer<vtkOrientedImageData> compareLabelmap = CreateLabelmap(EXTENT, [](int i, int j, int k)
+  {
+    return i >= 9 && i <= 20 && j >= 4 && j <= 15 && k >= 8 && k <= 13;
+  });
+
+  vtkSmartPointer<vtkLabelmapSurfaceDistanceFilter> surfaceDistanceFilter = vtkSmartPointer<vtkLabelmapSurfaceDistanceFilter>::New();
+  surfaceDistanceFilter->SetInputReferenceLabelmap(referenceLabelmap);
+  surfaceDistanceFilter->SetInputCompareLabelmap(compareLabelmap);
+  surfaceDistanceFilter->AddSurfaceDiceToleranceMm(1.0);
+  surfaceDistanceFilter->AddSurfaceDiceToleranceMm(3.0);
+  surfaceDistanceFilter->ComputeDistanceMapsOn();
+  if (!surfaceDistanceFilter->Update())
+  {
+    std::cerr << "Failed to compute surface distances" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Compute expected values by brute force
+  std::vector<std::vector<int> > referenceBoundaryVoxels = GetBoundaryVoxels(referenceLabelmap);
+  std::vector<std::vector<int> > compareBoundaryVoxels = GetBoundaryVoxels(compareLabelmap);
+  std::vector<double> referenceToCompareDistances;
+  for (const std::vector<int>& voxel : referenceBoundaryVoxels)
+  {
+    referenceToCompareDistances.push_back(GetDistanceFromBoundary(voxel, compareBoundaryVoxels));
+  }
+  std::vector<double> compareToReferenceDistances;
+  for (const std::vector<int>& voxel : compareBoundaryVoxels)
+  {
+    compareToReferenceDistances.push_back(GetDistanceFromBoundary(voxel, referenceBoundaryVoxels));
+  }
+
+  double expectedMaximum = std::max(
+    *std::max_element(referenceToCompareDistances.begin(), referenceToCompareDistances.end()),
+    *std::max_element(compareToReferenceDistances.begin(), compareToReferenceDistances.end()) );
+  double referenceToCompareSum = 0.0;
+  for (double distance : referenceToCompareDistances)
+  {
+    referenceToCompareSum += distance;
+  }
+  double compareToReferenceSum = 0.0;
+  for (double distance : compareToReferenceDistances)
+  {
+    compareToReferenceSum += distance;
+  }
+  double expectedAverage = 0.5 * ( referenceToCompareSum / referenceToCompareDistances.size()
+    + compareToReferenceSum / compareToReferenceDistances.size() );
+  double expectedPercent95 = std::max(
+    GetPercentile(referenceToCompareDistances, 95.0), GetPercentile(compareToReferenceDistances, 95.0) );
+
+  bool success = true;
+  success &= CheckValue("Maximum Hausdorff distance", surfaceDistanceFilter->GetMaximumHausdorffDistanceMm(), expectedMaximum);
+  success &= CheckValue("Average Hausdorff distance", surfaceDistanceFilter->GetAverageHausdorffDistanceMm(), expectedAverage);
+  success &= CheckValue("95% Hausdorff distance", surfaceDistanceFilter->GetPercent95HausdorffDistanceMm(), expectedPercent95);
+
+  for (int toleranceIndex = 0; toleranceIndex < surfaceDistanceFilter->GetNumberOfSurfaceDiceTolerances(); ++toleranceIndex)
+  {
+    double toleranceMm = surfaceDistanceFilter->GetSurfaceDiceToleranceMm(toleranceIndex);
+    double numberOfDistancesWithinTolerance = 0;
+    for (double distance : referenceToCompareDistances)
+    {
+      numberOfDistancesWithinTolerance += (distance <= toleranceMm ? 1 : 0);
+    }
+    for (double distance : compareToReferenceDistances)
+    {
+      numberOfDistancesWithinTolerance += (distance <= toleranceMm ? 1 : 0);
+    }
+    success &= CheckValue("Surface Dice", surfaceDistanceFilter->GetSurfaceDice(toleranceIndex),
+      numberOfDistancesWithinTolerance / (referenceBoundaryVoxels.size() + compareBoundaryVoxels.size()) );
+  }
+
+  // Check distance map of the reference boundary at every voxel of the map
+  vtkOrientedImageData* referenceDistanceMap = surfaceDistanceFilter->GetOutputReferenceDistanceMap();
+  if (!referenceDistanceMap)
+  {
+    std::cerr << "Missing reference distance map" << std::endl;
+    return EXIT_FAILURE;
+  }
+  int mapExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  referenceDistanceMap->GetExtent(mapExtent);
+  for (int k = mapExtent[4]; k <= mapExtent[5]; ++k)
+  {
+    for (int j = mapExtent[2]; j <= mapExtent[3]; ++j)
+    {
+      for (int i = mapExtent[0]; i <= mapExtent[1]; ++i)
+      {
+        double distance = *static_cast<float*>(referenceDistanceMap->GetScalarPointer(i, j, k));
+        double expectedDistance = GetDistanceFromBoundary({ i, j, k }, referenceBoundaryVoxels);
+        if (fabs(distance - expectedDistance) > DISTANCE_MAP_TOLERANCE)
+        {
+          std::cerr << "Reference distance map mismatch at (" << i << ", " << j << ", " << k << "): "
+            << distance << " (expected: " << expectedDistance << ")" << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+
+  // Identical inputs
+  surfaceDistanceFilter->SetInputCompareLabelmap(referenceLabelmap);
+  surfaceDistanceFilter->ComputeDistanceMapsOff();
+  if (!surfaceDistanceFilter->Update())
+  {
+    std::cerr << "Failed to compute surface distances of identical inputs" << std::endl;
+    return EXIT_FAILURE;
+  }
+  success &= CheckValue("Maximum Hausdorff distance of identical inputs", surfaceDistanceFilter->GetMaximumHausdorffDistanceMm(), 0.0);
+  success &= CheckValue("Average Hausdorff distance of identical inputs", surfaceDistanceFilter->GetAverageHausdorffDistanceMm(), 0.0);
+  success &= CheckValue("Surface Dice of identical inputs", surfaceDistanceFilter->GetSurfaceDice(0), 1.0);
+  if (surfaceDistanceFilter->GetOutputReferenceDistanceMap())
+  {
+    std::cerr << "Distance map computed even though it was not requested" << std::endl;
+    success = false;
+  }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -11,10 +11,17 @@
 // VTK includes
 #include <vtkDelimitedTextWriter.h>
 #include <vtkDoubleArray.h>
+#include <vtkImplicitPolyDataDistance.h>
+#include <vtkIntArray.h>
+#include <vtkMath.h>
+#include <vtkPolyDataPointSampler.h>
 #include <vtkSphereSource.h>
 #include <vtkTable.h>
 #include <vtkVariantArray.h>
 
+// STD includes
+#include <vector>
+
 //-----------------------------------------------------------------------------
 int vtkPolyDataDistanceHistogramFilterTest( int argc, char* argv[] )
 {
@@ -117,5 +124,62 @@ int vtkPolyDataDistanceHistogramFilterTest( int argc, char* argv[] )
   histogramWriter->SetFileName( histogramFilename );
   histogramWriter->Write();
 
+  // Compare the distances computed in parallel against the implicit distance function evaluated
+  // one point after the other, at the same sample points of the compare surface
+  vtkSmartPointer< vtkPolyDataPointSampler > pointSampler = vtkSmartPointer< vtkPolyDataPointSampler >::New();
+  pointSampler->SetGenerateVertexPoints( 1 );
+  pointSampler->SetGenerateEdgePoints( 1 );
+  pointSampler->SetGenerateInteriorPoints( 1 );
+  pointSampler->SetDistance( 0.025 );
+  pointSampler->SetInputData( sphereSource2->GetOutput() );
+  pointSampler->Update();
+  vtkPoints* samplePoints = pointSampler->GetOutput()->GetPoints();
+  if ( rawDistancesDoubleArray->GetNumberOfValues() != samplePoints->GetNumberOfPoints() )
+  {
+    errorStream << "Number of distances is " << rawDistancesDoubleArray->GetNumberOfValues()
+      << " instead of " << samplePoints->GetNumberOfPoints() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer< vtkImplicitPolyDataDistance > distanceFunction = vtkSmartPointer< vtkImplicitPolyDataDistance >::New();
+  distanceFunction->SetInput( sphereSource1->GetOutput() );
+  double histogramSpacing = polyDataDistanceHistogramFilter->GetHistogramSpacing();
+  double histogramMinimum = polyDataDistanceHistogramFilter->GetHistogramMinimum();
+  std::vector<int> expectedFrequencies( histogramInTable->GetNumberOfRows(), 0 );
+  for ( vtkIdType pointId = 0; pointId < samplePoints->GetNumberOfPoints(); ++pointId )
+  {
+    double samplePoint[ 3 ] = { 0.0, 0.0, 0.0 };
+    samplePoints->GetPoint( pointId, samplePoint );
+    double expectedDistance = distanceFunction->EvaluateFunction( samplePoint );
+    double distance = rawDistancesDoubleArray->GetValue( pointId );
+    if ( fabs( distance - expectedDistance ) > 1e-9 )
+    {
+      errorStream << "Distance of sample point " << pointId << " is " << distance << " instead of " << expectedDistance << std::endl;
+      return EXIT_FAILURE;
+    }
+    int binIndex = vtkMath::Floor( (expectedDistance - histogramMinimum) / histogramSpacing );
+    if ( binIndex >= 0 && binIndex < static_cast<int>(expectedFrequencies.size()) )
+    {
+      ++expectedFrequencies[ binIndex ];
+    }
+  }
+
+  // Compare the histogram counted in parallel against the distances counted one after the other
+  vtkIntArray* frequencies = vtkIntArray::SafeDownCast( histogramInTable->GetColumnByName( "Frequencies" ) );
+  if ( frequencies == nullptr || frequencies->GetNumberOfValues() != static_cast<vtkIdType>(expectedFrequencies.size()) )
+  {
+    errorStream << "Invalid histogram frequencies" << std::endl;
+    return EXIT_FAILURE;
+  }
+  for ( int binIndex = 0; binIndex < static_cast<int>(expectedFrequencies.size()); ++binIndex )
+  {
+    if ( frequencies->GetValue( binIndex ) != expectedFrequencies[ binIndex ] )
+    {
+      errorStream << "Frequency of histogram bin " << binIndex << " is " << frequencies->GetValue( binIndex )
+        << " instead of " << expectedFrequencies[ binIndex ] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   return EXIT_SUCCESS;
 }
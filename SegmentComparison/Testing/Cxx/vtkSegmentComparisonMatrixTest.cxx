@@ -0,0 +1,175 @@
+// SegmentComparison includes
+#include "vtkSlicerSegmentComparisonModuleLogic.h"
+#include "vtkLabelmapDiceStatisticsFilter.h"
+#include "vtkLabelmapSurfaceDistanceFilter.h"
+
+// Segmentations includes
+#include "vtkMRMLSegmentationNode.h"
+
+// SegmentationCore includes
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// Testing includes
+#include "LabelmapTestingUtilities.h"
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLTableNode.h>
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <sstream>
+#include <string>
+
+using namespace LabelmapTestingUtilities;
+
+namespace
+{
+const double SURFACE_DICE_TOLERANCE_MM = 2.0;
+
+//-----------------------------------------------------------------------------
+/// Add segment with binary labelmap representation to a segmentation
+void AddSegment(vtkMRMLSegmentationNode* segmentationNode, const std::string& segmentId, vtkOrientedImageData* labelmap)
+{
+  vtkNew<vtkSegment> segment;
+  segment->SetName(segmentId.c_str());
+  segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap);
+  segmentationNode->GetSegmentation()->AddSegment(segment, segmentId);
+}
+
+//-----------------------------------------------------------------------------
+/// Check the metrics in a row of the matrix against the metrics computed by the filters for the segment pair of the row
+bool CheckPair(vtkMRMLScene* scene, vtkTable* table, vtkIdType row, const std::string& surfaceDiceColumnName)
+{
+  vtkSmartPointer<vtkOrientedImageData> labelmaps[2];
+  const char* segmentationColumnNames[2] = { "Reference segmentation", "Compare segmentation" };
+  const char* segmentColumnNames[2] = { "Reference segment", "Compare segment" };
+  for (int index = 0; index < 2; ++index)
+  {
+    std::string segmentationName = table->GetValueByName(row, segmentationColumnNames[index]).ToString();
+    std::string segmentId = table->GetValueByName(row, segmentColumnNames[index]).ToString();
+    vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(scene->GetFirstNodeByName(segmentationName.c_str()));
+    labelmaps[index] = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!segmentationNode || !segmentationNode->GetBinaryLabelmapRepresentation(segmentId, labelmaps[index]))
+    {
+      std::cerr << "Failed to get segment " << segmentId << " of segmentation " << segmentationName << std::endl;
+      return false;
+    }
+  }
+  std::string pairName = table->GetValueByName(row, "Reference segment").ToString() + "-"
+    + table->GetValueByName(row, "Compare segment").ToString();
+
+  vtkNew<vtkLabelmapDiceStatisticsFilter> diceStatisticsFilter;
+  diceStatisticsFilter->SetInputReferenceLabelmap(labelmaps[0]);
+  diceStatisticsFilter->SetInputCompareLabelmap(labelmaps[1]);
+  vtkNew<vtkLabelmapSurfaceDistanceFilter> surfaceDistanceFilter;
+  surfaceDistanceFilter->SetInputReferenceLabelmap(labelmaps[0]);
+  surfaceDistanceFilter->SetInputCompareLabelmap(labelmaps[1]);
+  surfaceDistanceFilter->AddSurfaceDiceToleranceMm(SURFACE_DICE_TOLERANCE_MM);
+  if (!diceStatisticsFilter->Update() || !surfaceDistanceFilter->Update())
+  {
+    std::cerr << "Failed to compare segment pair " << pairName << std::endl;
+    return false;
+  }
+
+  bool success = true;
+  success &= CheckValue(pairName + " Dice coefficient", table->GetValueByName(row, "Dice coefficient").ToDouble(),
+    diceStatisticsFilter->GetDiceCoefficient());
+  success &= CheckValue(pairName + " maximum Hausdorff", table->GetValueByName(row, "Maximum Hausdorff (mm)").ToDouble(),
+    surfaceDistanceFilter->GetMaximumHausdorffDistanceMm());
+  success &= CheckValue(pairName + " average Hausdorff", table->GetValueByName(row, "Average Hausdorff (mm)").ToDouble(),
+    surfaceDistanceFilter->GetAverageHausdorffDistanceMm());
+  success &= CheckValue(pairName + " 95% Hausdorff", table->GetValueByName(row, "95% Hausdorff (mm)").ToDouble(),
+    surfaceDistanceFilter->GetPercent95HausdorffDistanceMm());
+  success &= CheckValue(pairName + " surface Dice", table->GetValueByName(row, surfaceDiceColumnName.c_str()).ToDouble(),
+    surfaceDistanceFilter->GetSurfaceDice(0));
+  return success;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSegmentComparisonMatrixTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkSlicerSegmentComparisonModuleLogic> segmentComparisonLogic;
+  segmentComparisonLogic->SetMRMLScene(mrmlScene);
+
+  // Two segmentations with two segments each, all on the same grid but with different extents
+  int sphereExtent[6] = { -10, 70, 0, 40, 0, 12 };
+  vtkSmartPointer<vtkOrientedImageData> sphereLabelmap = CreateLabelmap(sphereExtent, [](int i, int j, int k)
+  {
+    double x = (i - 30) * SPACING[0], y = (j - 20) * SPACING[1], z = (k - 6) * SPACING[2];
+    return x*x + y*y + z*z < 14.0 * 14.0;
+  });
+  int boxExtent[6] = { 40, 120, -15, 30, 2, 16 };
+  vtkSmartPointer<vtkOrientedImageData> boxLabelmap = CreateLabelmap(boxExtent, [](int i, int j, int k)
+  {
+    return i >= 50 && i <= 100 && j >= -5 && j <= 20 && k >= 4 && k <= 12;
+  });
+  int shiftedSphereExtent[6] = { 0, 80, 5, 45, -3, 12 };
+  vtkSmartPointer<vtkOrientedImageData> shiftedSphereLabelmap = CreateLabelmap(shiftedSphereExtent, [](int i, int j, int k)
+  {
+    double x = (i - 33) * SPACING[0], y = (j - 24) * SPACING[1], z = (k - 5) * SPACING[2];
+    return x*x + y*y + z*z < 12.0 * 12.0;
+  });
+  int slabExtent[6] = { 20, 110, -10, 40, 3, 10 };
+  vtkSmartPointer<vtkOrientedImageData> slabLabelmap = CreateLabelmap(slabExtent, [](int i, int j, int k)
+  {
+    return i >= 25 && i <= 105 && j >= 0 && j <= 35 && k >= 5 && k <= 8;
+  });
+
+  vtkNew<vtkMRMLSegmentationNode> referenceSegmentationNode;
+  referenceSegmentationNode->SetName("Reference");
+  mrmlScene->AddNode(referenceSegmentationNode);
+  referenceSegmentationNode->GetSegmentation()->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() );
+  AddSegment(referenceSegmentationNode, "Sphere", sphereLabelmap);
+  AddSegment(referenceSegmentationNode, "Box", boxLabelmap);
+
+  vtkNew<vtkMRMLSegmentationNode> compareSegmentationNode;
+  compareSegmentationNode->SetName("Compare");
+  mrmlScene->AddNode(compareSegmentationNode);
+  compareSegmentationNode->GetSegmentation()->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() );
+  AddSegment(compareSegmentationNode, "ShiftedSphere", shiftedSphereLabelmap);
+  AddSegment(compareSegmentationNode, "Slab", slabLabelmap);
+
+  vtkNew<vtkCollection> segmentationNodes;
+  segmentationNodes->AddItem(referenceSegmentationNode);
+  segmentationNodes->AddItem(compareSegmentationNode);
+  vtkNew<vtkMRMLTableNode> tableNode;
+  mrmlScene->AddNode(tableNode);
+  std::string errorMessage = segmentComparisonLogic->ComputeSegmentComparisonMatrix(
+    segmentationNodes, tableNode, nullptr, true, SURFACE_DICE_TOLERANCE_MM);
+  if (!errorMessage.empty())
+  {
+    std::cerr << "Failed to compute segment comparison matrix: " << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Only the segments of different segmentations are compared
+  vtkTable* table = tableNode->GetTable();
+  if (table->GetNumberOfRows() != 4)
+  {
+    std::cerr << "Segment comparison matrix has " << table->GetNumberOfRows() << " rows instead of 4" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The metrics of the matrix are the same as computed for each pair separately
+  std::stringstream surfaceDiceSs;
+  surfaceDiceSs << "Surface Dice (" << SURFACE_DICE_TOLERANCE_MM << " mm)";
+  bool success = true;
+  for (vtkIdType row = 0; row < table->GetNumberOfRows(); ++row)
+  {
+    success &= CheckPair(mrmlScene, table, row, surfaceDiceSs.str());
+  }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
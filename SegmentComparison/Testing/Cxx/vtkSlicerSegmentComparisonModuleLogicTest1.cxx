@@ -31,6 +31,7 @@
 #include "vtkPlanarContourToClosedSurfaceConversionRule.h"
 
 // SegmentationCore includes
+#include "vtkOrientedImageData.h"
 #include "vtkSegmentationConverterFactory.h"
 
 // MRML includes
@@ -42,6 +43,9 @@
 #include <vtkNew.h>
 #include <vtkImageData.h>
 
+// STD includes
+#include <algorithm>
+
 // ITK includes
 #include "itkFactoryRegistration.h"
 
@@ -49,12 +53,22 @@
 #include <vtksys/SystemTools.hxx>
 
 bool CheckIfResultIsWithinOneTenthPercentFromBaseline(double result, double baseline);
+bool CheckIfResultIsWithinToleranceFromBaseline(double result, double baseline, double tolerance);
 
 //-----------------------------------------------------------------------------
 int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
 {
   int argIndex = 1;
 
+  // Optional flag for also computing the metrics with the fast methods and comparing them to the baseline
+  bool compareFastMethods = false;
+  if (argc > argIndex+1 && STRCASECMP(argv[argIndex], "-CompareFastMethods") == 0)
+  {
+    compareFastMethods = (vtkVariant(argv[argIndex+1]).ToInt() == 1 ? true : false);
+    std::cout << "Compare fast methods: " << (compareFastMethods ? "true" : "false") << std::endl;
+    argIndex += 2;
+  }
+
   const char *dataDirectoryPath = nullptr;
   if (argc > argIndex+1)
   {
@@ -449,6 +463,71 @@ int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
     result = EXIT_FAILURE;
   }
 
+  if (!compareFastMethods)
+  {
+    return result;
+  }
+
+  // Bit-packed overlap counts on the reference extent, so all Dice results are expected to agree with plastimatch
+  paramNode->UseBitPackedOverlapOn();
+  errorMessageDice = segmentComparisonLogic->ComputeDiceStatistics(paramNode);
+  paramNode->UseBitPackedOverlapOff();
+  if (!errorMessageDice.empty() || !paramNode->GetDiceResultsValid())
+  {
+    std::cerr << "Failed to compute Dice statistics using bit-packed overlap!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char* bitPackedResultNames[5] = { "Dice coefficient", "True positives (%)", "True negatives (%)", "False positives (%)", "False negatives (%)" };
+  double bitPackedResults[5] = { paramNode->GetDiceCoefficient(), paramNode->GetTruePositivesPercent(),
+    paramNode->GetTrueNegativesPercent(), paramNode->GetFalsePositivesPercent(), paramNode->GetFalseNegativesPercent() };
+  double baselineResults[5] = { diceCoefficient, truePositivesPercent, trueNegativesPercent, falsePositivesPercent, falseNegativesPercent };
+  for (int resultIndex = 0; resultIndex < 5; ++resultIndex)
+  {
+    if (!CheckIfResultIsWithinOneTenthPercentFromBaseline(bitPackedResults[resultIndex], baselineResults[resultIndex]))
+    {
+      std::cerr << bitPackedResultNames[resultIndex] << " from bit-packed overlap mismatch: " << bitPackedResults[resultIndex]
+        << " instead of " << baselineResults[resultIndex] << std::endl;
+      result = EXIT_FAILURE;
+    }
+  }
+
+  // Boundary distances from distance transforms are expected within a voxel from the plastimatch values
+  vtkSmartPointer<vtkOrientedImageData> referenceLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  if (!referenceSegmentationNode->GetBinaryLabelmapRepresentation(referenceSegmentID, referenceLabelmap))
+  {
+    std::cerr << "Failed to get reference segment labelmap!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  double* referenceSpacing = referenceLabelmap->GetSpacing();
+  double voxelSizeMm = std::max(referenceSpacing[0], std::max(referenceSpacing[1], referenceSpacing[2]));
+
+  paramNode->UseDistanceTransformOn();
+  errorMessageHausdorff = segmentComparisonLogic->ComputeHausdorffDistances(paramNode);
+  paramNode->UseDistanceTransformOff();
+  if (!errorMessageHausdorff.empty() || !paramNode->GetHausdorffResultsValid())
+  {
+    std::cerr << "Failed to compute Hausdorff distances using distance transforms!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  resultHausdorffMaximumMm = paramNode->GetMaximumHausdorffDistanceForBoundaryMm();
+  if (!CheckIfResultIsWithinToleranceFromBaseline(resultHausdorffMaximumMm, hausdorffMaximumMm, voxelSizeMm))
+  {
+    std::cerr << "Hausdorff maximum (mm) from distance transforms mismatch: " << resultHausdorffMaximumMm << " instead of " << hausdorffMaximumMm << std::endl;
+    result = EXIT_FAILURE;
+  }
+  resultHausdorffAverageMm = paramNode->GetAverageHausdorffDistanceForBoundaryMm();
+  if (!CheckIfResultIsWithinToleranceFromBaseline(resultHausdorffAverageMm, hausdorffAverageMm, voxelSizeMm))
+  {
+    std::cerr << "Hausdorff average (mm) from distance transforms mismatch: " << resultHausdorffAverageMm << " instead of " << hausdorffAverageMm << std::endl;
+    result = EXIT_FAILURE;
+  }
+  resultHausdorff95PercentMm = paramNode->GetPercent95HausdorffDistanceForBoundaryMm();
+  if (!CheckIfResultIsWithinToleranceFromBaseline(resultHausdorff95PercentMm, hausdorff95PercentMm, voxelSizeMm))
+  {
+    std::cerr << "Hausdorff 95% from distance transforms mismatch: " << resultHausdorff95PercentMm << " instead of " << hausdorff95PercentMm << std::endl;
+    result = EXIT_FAILURE;
+  }
+
   return result;
 }
 
@@ -465,3 +544,9 @@ bool CheckIfResultIsWithinOneTenthPercentFromBaseline(double result, double base
 
   return absoluteDifferencePercent < 0.1;
 }
+
+//-----------------------------------------------------------------------------
+bool CheckIfResultIsWithinToleranceFromBaseline(double result, double baseline, double tolerance)
+{
+  return (fabs(result - baseline) <= tolerance);
+}
@@ -0,0 +1,723 @@
+#include "vtkLabelmapExpressionFilter.h"
+#include "vtkLabelmapMarginFilter.h"
+
+// SlicerRtCommon includes
+#include "vtkSlicerRtCommon.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// vtk includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+//----------------------------------------------------------------------------
+enum OperationType
+{
+  Operand,
+  Union,
+  Intersect,
+  Subtract,
+  Grow,
+  Shrink
+};
+
+//----------------------------------------------------------------------------
+/// Node of the expression tree
+struct ExpressionNode
+{
+  OperationType Operation{Operand};
+  /// Labelmap name for operands
+  std::string OperandName;
+  /// Margin for grow and shrink
+  double MarginMm[3]{0.0, 0.0, 0.0};
+  /// Operands of the operation
+  std::unique_ptr<ExpressionNode> Left;
+  std::unique_ptr<ExpressionNode> Right;
+  /// Labelmap of operands, and of margins after they are evaluated
+  vtkSmartPointer<vtkOrientedImageData> Labelmap;
+  /// Bounding box of the structure that is the result of the node
+  int Box[6]{0, -1, 0, -1, 0, -1};
+};
+
+//----------------------------------------------------------------------------
+bool IsExtentEmpty(const int extent[6])
+{
+  return (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5]);
+}
+
+//----------------------------------------------------------------------------
+/// Recursive descent parser of the expression
+class ExpressionParser
+{
+public:
+  ExpressionParser(const std::string& expression)
+    : Expression(expression)
+    , Position(0)
+  {
+  }
+
+  /// Parse the expression
+  /// \return Root of the expression tree, nullptr on error
+  std::unique_ptr<ExpressionNode> Parse()
+  {
+    std::unique_ptr<ExpressionNode> root = this->ParseUnion();
+    this->SkipWhitespace();
+    if (root && this->Position < this->Expression.size())
+    {
+      this->SetError("Unexpected character");
+      return nullptr;
+    }
+    return root;
+  }
+
+  const std::string& GetErrorMessage() { return this->ErrorMessage; }
+
+private:
+  /// Union and subtraction of intersections
+  std::unique_ptr<ExpressionNode> ParseUnion()
+  {
+    std::unique_ptr<ExpressionNode> left = this->ParseIntersection();
+    while (left)
+    {
+      OperationType operation = Operand;
+      if (this->Accept('|'))
+      {
+        operation = Union;
+      }
+      else if (this->Accept('-'))
+      {
+        operation = Subtract;
+      }
+      else
+      {
+        break;
+      }
+      std::unique_ptr<ExpressionNode> right = this->ParseIntersection();
+      if (!right)
+      {
+        return nullptr;
+      }
+      left = this->CreateOperation(operation, std::move(left), std::move(right));
+    }
+    return left;
+  }
+
+  /// Intersection of primary expressions
+  std::unique_ptr<ExpressionNode> ParseIntersection()
+  {
+    std::unique_ptr<ExpressionNode> left = this->ParsePrimary();
+    while (left && this->Accept('&'))
+    {
+      std::unique_ptr<ExpressionNode> right = this->ParsePrimary();
+      if (!right)
+      {
+        return nullptr;
+      }
+      left = this->CreateOperation(Intersect, std::move(left), std::move(right));
+    }
+    return left;
+  }
+
+  /// Labelmap name, margin, or expression in parentheses
+  std::unique_ptr<ExpressionNode> ParsePrimary()
+  {
+    if (this->Accept('('))
+    {
+      std::unique_ptr<ExpressionNode> node = this->ParseUnion();
+      if (node && !this->Accept(')'))
+      {
+        this->SetError("Missing closing parenthesis");
+        return nullptr;
+      }
+      return node;
+    }
+
+    std::string name;
+    if (this->Accept('"'))
+    {
+      size_t closingQuotePosition = this->Expression.find('"', this->Position);
+      if (closingQuotePosition == std::string::npos)
+      {
+        this->SetError("Missing closing quote");
+        return nullptr;
+      }
+      name = this->Expression.substr(this->Position, closingQuotePosition - this->Position);
+      this->Position = closingQuotePosition + 1;
+    }
+    else
+    {
+      size_t nameStart = this->Position;
+      while ( this->Position < this->Expression.size()
+        && (isalnum(static_cast<unsigned char>(this->Expression[this->Position])) || this->Expression[this->Position] == '_' || this->Expression[this->Position] == '.') )
+      {
+        ++this->Position;
+      }
+      name = this->Expression.substr(nameStart, this->Position - nameStart);
+      if (name.empty())
+      {
+        this->SetError("Expected labelmap name");
+        return nullptr;
+      }
+      if ((name == "grow" || name == "shrink") && this->Accept('('))
+      {
+        return this->ParseMargin(name == "grow" ? Grow : Shrink);
+      }
+    }
+    if (name.empty())
+    {
+      this->SetError("Empty labelmap name");
+      return nullptr;
+    }
+
+    std::unique_ptr<ExpressionNode> node(new ExpressionNode);
+    node->OperandName = name;
+    return node;
+  }
+
+  /// Arguments of grow or shrink after the opening parenthesis
+  std::unique_ptr<ExpressionNode> ParseMargin(OperationType operation)
+  {
+    std::unique_ptr<ExpressionNode> node(new ExpressionNode);
+    node->Operation = operation;
+    node->Left = this->ParseUnion();
+    if (!node->Left)
+    {
+      return nullptr;
+    }
+    int numberOfMargins = 0;
+    while (this->Accept(','))
+    {
+      if (numberOfMargins == 3 || !this->ParseNumber(node->MarginMm[numberOfMargins]))
+      {
+        this->SetError("Invalid margin");
+        return nullptr;
+      }
+      ++numberOfMargins;
+    }
+    if (numberOfMargins != 1 && numberOfMargins != 3)
+    {
+      this->SetError("Margin must be specified by one or three values");
+      return nullptr;
+    }
+    if (!this->Accept(')'))
+    {
+      this->SetError("Missing closing parenthesis");
+      return nullptr;
+    }
+    if (numberOfMargins == 1)
+    {
+      node->MarginMm[1] = node->MarginMm[2] = node->MarginMm[0];
+    }
+    return node;
+  }
+
+  bool ParseNumber(double& number)
+  {
+    this->SkipWhitespace();
+    const char* numberStart = this->Expression.c_str() + this->Position;
+    char* numberEnd = nullptr;
+    number = strtod(numberStart, &numberEnd);
+    if (numberEnd == numberStart)
+    {
+      return false;
+    }
+    this->Position += numberEnd - numberStart;
+    return true;
+  }
+
+  /// Consume the character if it is the next one after whitespaces
+  bool Accept(char character)
+  {
+    this->SkipWhitespace();
+    if (this->Position < this->Expression.size() && this->Expression[this->Position] == character)
+    {
+      ++this->Position;
+      return true;
+    }
+    return false;
+  }
+
+  void SkipWhitespace()
+  {
+    while (this->Position < this->Expression.size() && isspace(static_cast<unsigned char>(this->Expression[this->Position])))
+    {
+      ++this->Position;
+    }
+  }
+
+  void SetError(const std::string& message)
+  {
+    if (this->ErrorMessage.empty())
+    {
+      this->ErrorMessage = message + " at position " + std::to_string(this->Position);
+    }
+  }
+
+  std::unique_ptr<ExpressionNode> CreateOperation(OperationType operation,
+    std::unique_ptr<ExpressionNode> left, std::unique_ptr<ExpressionNode> right)
+  {
+    std::unique_ptr<ExpressionNode> node(new ExpressionNode);
+    node->Operation = operation;
+    node->Left = std::move(left);
+    node->Right = std::move(right);
+    return node;
+  }
+
+private:
+  std::string Expression;
+  size_t Position;
+  std::string ErrorMessage;
+};
+
+//----------------------------------------------------------------------------
+/// Collect operand names of the expression tree in order of first appearance
+void CollectOperandNames(ExpressionNode* node, std::vector<std::string>& names)
+{
+  if (!node)
+  {
+    return;
+  }
+  if (node->Operation == Operand)
+  {
+    if (std::find(names.begin(), names.end(), node->OperandName) == names.end())
+    {
+      names.push_back(node->OperandName);
+    }
+    return;
+  }
+  CollectOperandNames(node->Left.get(), names);
+  CollectOperandNames(node->Right.get(), names);
+}
+
+//----------------------------------------------------------------------------
+/// Labelmap data accessed during the evaluation
+struct LeafLabelmap
+{
+  void* Scalars;
+  int ScalarType;
+  int Extent[6];
+  vtkIdType Increments[3];
+  int Box[6];
+};
+
+//----------------------------------------------------------------------------
+/// Instruction of the postfix program evaluating the boolean operations row by row
+struct Instruction
+{
+  OperationType Operation;
+  int LeafIndex;
+};
+
+//----------------------------------------------------------------------------
+/// Convert the expression tree to a postfix program. The nodes that have a labelmap are the leaves.
+void CompileExpression(ExpressionNode* node, std::vector<LeafLabelmap>& leaves, std::vector<Instruction>& program,
+  int depth, int& maximumDepth)
+{
+  if (node->Labelmap)
+  {
+    LeafLabelmap leaf;
+    leaf.Scalars = node->Labelmap->GetScalarPointer();
+    leaf.ScalarType = node->Labelmap->GetScalarType();
+    node->Labelmap->GetExtent(leaf.Extent);
+    node->Labelmap->GetIncrements(leaf.Increments);
+    std::copy(node->Box, node->Box + 6, leaf.Box);
+    leaves.push_back(leaf);
+    program.push_back({ Operand, static_cast<int>(leaves.size()) - 1 });
+    maximumDepth = std::max(maximumDepth, depth + 1);
+    return;
+  }
+  CompileExpression(node->Left.get(), leaves, program, depth, maximumDepth);
+  CompileExpression(node->Right.get(), leaves, program, depth + 1, maximumDepth);
+  program.push_back({ node->Operation, -1 });
+}
+
+//----------------------------------------------------------------------------
+/// Set row values to 1 where the labelmap is nonzero between the given I indices
+template <class T>
+void ReadRow(const LeafLabelmap& leaf, T*, int beginI, int endI, int j, int k, unsigned char* row)
+{
+  const T* scalarsPtr = static_cast<const T*>(leaf.Scalars) + (beginI - leaf.Extent[0]) * leaf.Increments[0]
+    + (j - leaf.Extent[2]) * leaf.Increments[1] + (k - leaf.Extent[4]) * leaf.Increments[2];
+  for (int i = beginI; i <= endI; ++i)
+  {
+    *(row++) = (*scalarsPtr != 0 ? 1 : 0);
+    scalarsPtr += leaf.Increments[0];
+  }
+}
+
+//----------------------------------------------------------------------------
+/// Write label value to the image row where the row values are nonzero
+template <class T>
+void WriteRow(T* imageRowPtr, const unsigned char* row, int rowLength, double labelValue)
+{
+  T value = static_cast<T>(labelValue);
+  for (int i = 0; i < rowLength; ++i)
+  {
+    imageRowPtr[i] = (row[i] ? value : 0);
+  }
+}
+
+//----------------------------------------------------------------------------
+/// Evaluate the boolean operations of the expression tree over the extent in one pass.
+/// Margin operations must have been evaluated before.
+/// \return Output labelmap, nullptr if the output scalar type is not supported
+vtkSmartPointer<vtkOrientedImageData> EvaluateExpression(ExpressionNode* root, vtkMatrix4x4* imageToWorldMatrix,
+  const int extent[6], int scalarType, double labelValue)
+{
+  bool scalarTypeSupported = false;
+  switch (scalarType)
+  {
+    vtkTemplateMacro(scalarTypeSupported = true);
+  }
+  if (!scalarTypeSupported)
+  {
+    return nullptr;
+  }
+
+  vtkSmartPointer<vtkOrientedImageData> outputLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  outputLabelmap->SetImageToWorldMatrix(imageToWorldMatrix);
+  outputLabelmap->SetExtent(const_cast<int*>(extent));
+  outputLabelmap->AllocateScalars(scalarType, 1);
+  if (IsExtentEmpty(extent))
+  {
+    return outputLabelmap;
+  }
+
+  std::vector<LeafLabelmap> leaves;
+  std::vector<Instruction> program;
+  int maximumDepth = 0;
+  CompileExpression(root, leaves, program, 0, maximumDepth);
+
+  int rowLength = extent[1] - extent[0] + 1;
+  int numberOfRowsPerSlice = extent[3] - extent[2] + 1;
+  vtkIdType numberOfRows = static_cast<vtkIdType>(numberOfRowsPerSlice) * (extent[5] - extent[4] + 1);
+  vtkIdType outputIncrements[3] = { 0, 0, 0 };
+  outputLabelmap->GetIncrements(outputIncrements);
+  void* outputScalars = outputLabelmap->GetScalarPointer();
+
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType beginRow, vtkIdType endRow)
+  {
+    // Stack of row values of the postfix program
+    std::vector<std::vector<unsigned char> > stack(maximumDepth, std::vector<unsigned char>(rowLength));
+    for (vtkIdType rowIndex = beginRow; rowIndex < endRow; ++rowIndex)
+    {
+      int j = extent[2] + static_cast<int>(rowIndex % numberOfRowsPerSlice);
+      int k = extent[4] + static_cast<int>(rowIndex / numberOfRowsPerSlice);
+      int stackSize = 0;
+      for (const Instruction& instruction : program)
+      {
+        if (instruction.Operation == Operand)
+        {
+          const LeafLabelmap& leaf = leaves[instruction.LeafIndex];
+          unsigned char* row = stack[stackSize++].data();
+          std::fill(row, row + rowLength, 0);
+          int beginI = std::max(extent[0], leaf.Box[0]);
+          int endI = std::min(extent[1], leaf.Box[1]);
+          if (j < leaf.Box[2] || j > leaf.Box[3] || k < leaf.Box[4] || k > leaf.Box[5] || beginI > endI)
+          {
+            continue;
+          }
+          switch (leaf.ScalarType)
+          {
+            vtkTemplateMacro(ReadRow<VTK_TT>(leaf, static_cast<VTK_TT*>(nullptr), beginI, endI, j, k, row + (beginI - extent[0])));
+          }
+          continue;
+        }
+
+        unsigned char* left = stack[stackSize-2].data();
+        const unsigned char* right = stack[stackSize-1].data();
+        --stackSize;
+        switch (instruction.Operation)
+        {
+        case Union:
+          for (int i = 0; i < rowLength; ++i)
+          {
+            left[i] |= right[i];
+          }
+          break;
+        case Intersect:
+          for (int i = 0; i < rowLength; ++i)
+          {
+            left[i] &= right[i];
+          }
+          break;
+        case Subtract:
+          for (int i = 0; i < rowLength; ++i)
+          {
+            left[i] &= (right[i] ^ 1);
+          }
+          break;
+        default:
+          break;
+        }
+      }
+
+      vtkIdType rowOffset = (j - extent[2]) * outputIncrements[1] + (k - extent[4]) * outputIncrements[2];
+      switch (scalarType)
+      {
+        vtkTemplateMacro(WriteRow<VTK_TT>(static_cast<VTK_TT*>(outputScalars) + rowOffset, stack[0].data(), rowLength, labelValue));
+      }
+    }
+  });
+
+  return outputLabelmap;
+}
+
+//----------------------------------------------------------------------------
+/// Assign labelmaps to the operands, evaluate the margin operations, and compute the bounding
+/// boxes of the nodes of the expression tree
+bool PrepareExpression(ExpressionNode* node, std::map<std::string, vtkSmartPointer<vtkOrientedImageData> >& operandLabelmaps,
+  vtkMatrix4x4* imageToWorldMatrix)
+{
+  switch (node->Operation)
+  {
+  case Operand:
+    {
+    node->Labelmap = operandLabelmaps[node->OperandName];
+    int extent[6] = { 0, -1, 0, -1, 0, -1 };
+    node->Labelmap->GetExtent(extent);
+    if (IsExtentEmpty(extent))
+    {
+      // Box is already empty
+      return true;
+    }
+    return vtkOrientedImageDataResample::CalculateEffectiveExtent(node->Labelmap, node->Box);
+    }
+
+  case Union:
+  case Intersect:
+  case Subtract:
+    {
+    if ( !PrepareExpression(node->Left.get(), operandLabelmaps, imageToWorldMatrix)
+      || !PrepareExpression(node->Right.get(), operandLabelmaps, imageToWorldMatrix) )
+    {
+      return false;
+    }
+    // Result of subtraction is within the left operand, union is within the union of the boxes,
+    // intersection is within the intersection of the boxes (empty if any of them is empty)
+    const int* leftBox = node->Left->Box;
+    const int* rightBox = node->Right->Box;
+    if (node->Operation == Subtract || (node->Operation == Union && IsExtentEmpty(rightBox)))
+    {
+      std::copy(leftBox, leftBox + 6, node->Box);
+    }
+    else if (node->Operation == Union && IsExtentEmpty(leftBox))
+    {
+      std::copy(rightBox, rightBox + 6, node->Box);
+    }
+    else
+    {
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        node->Box[2*axis] = ( node->Operation == Union ? std::min(leftBox[2*axis], rightBox[2*axis])
+          : std::max(leftBox[2*axis], rightBox[2*axis]) );
+        node->Box[2*axis+1] = ( node->Operation == Union ? std::max(leftBox[2*axis+1], rightBox[2*axis+1])
+          : std::min(leftBox[2*axis+1], rightBox[2*axis+1]) );
+      }
+    }
+    return true;
+    }
+
+  case Grow:
+  case Shrink:
+    {
+    ExpressionNode* operandNode = node->Left.get();
+    if (!PrepareExpression(operandNode, operandLabelmaps, imageToWorldMatrix))
+    {
+      return false;
+    }
+    // Boolean operations in the operand are evaluated within their bounding box
+    vtkSmartPointer<vtkOrientedImageData> operandLabelmap = operandNode->Labelmap;
+    if (!operandLabelmap)
+    {
+      operandLabelmap = EvaluateExpression(operandNode, imageToWorldMatrix, operandNode->Box, VTK_UNSIGNED_CHAR, 1.0);
+    }
+    if (IsExtentEmpty(operandNode->Box))
+    {
+      // Margin of empty structure is empty
+      node->Labelmap = operandLabelmap;
+      node->Left.reset();
+      return true;
+    }
+
+    vtkSmartPointer<vtkLabelmapMarginFilter> marginFilter = vtkSmartPointer<vtkLabelmapMarginFilter>::New();
+    marginFilter->SetInputLabelmap(operandLabelmap);
+    marginFilter->SetMarginMm(node->MarginMm);
+    marginFilter->SetShrink(node->Operation == Shrink);
+    if (!marginFilter->Update())
+    {
+      return false;
+    }
+    node->Labelmap = marginFilter->GetOutputLabelmap();
+    node->Left.reset();
+    return vtkOrientedImageDataResample::CalculateEffectiveExtent(node->Labelmap, node->Box);
+    }
+
+  default:
+    return false;
+  }
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLabelmapExpressionFilter);
+
+//----------------------------------------------------------------------------
+vtkLabelmapExpressionFilter::vtkLabelmapExpressionFilter()
+  : OutputLabelValue(1.0)
+  , OutputScalarType(VTK_UNSIGNED_CHAR)
+{
+  int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  std::copy(emptyExtent, emptyExtent + 6, this->OutputExtent);
+}
+
+//----------------------------------------------------------------------------
+vtkLabelmapExpressionFilter::~vtkLabelmapExpressionFilter() = default;
+
+//----------------------------------------------------------------------------
+void vtkLabelmapExpressionFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Expression: " << this->Expression << "\n";
+  os << indent << "InputLabelmaps:";
+  for (std::map<std::string, vtkSmartPointer<vtkOrientedImageData> >::iterator labelmapIt = this->InputLabelmaps.begin();
+    labelmapIt != this->InputLabelmaps.end(); ++labelmapIt)
+  {
+    os << " " << labelmapIt->first;
+  }
+  os << "\n";
+  os << indent << "OutputLabelValue: " << this->OutputLabelValue << "\n";
+  os << indent << "OutputScalarType: " << vtkImageScalarTypeNameMacro(this->OutputScalarType) << "\n";
+  os << indent << "OutputExtent: " << this->OutputExtent[0] << ", " << this->OutputExtent[1] << ", " << this->OutputExtent[2]
+    << ", " << this->OutputExtent[3] << ", " << this->OutputExtent[4] << ", " << this->OutputExtent[5] << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapExpressionFilter::SetInputLabelmap(const std::string& name, vtkOrientedImageData* labelmap)
+{
+  if (!labelmap)
+  {
+    this->InputLabelmaps.erase(name);
+    return;
+  }
+  this->InputLabelmaps[name] = labelmap;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkLabelmapExpressionFilter::GetInputLabelmap(const std::string& name)
+{
+  std::map<std::string, vtkSmartPointer<vtkOrientedImageData> >::iterator labelmapIt = this->InputLabelmaps.find(name);
+  return (labelmapIt != this->InputLabelmaps.end() ? labelmapIt->second.GetPointer() : nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapExpressionFilter::RemoveAllInputLabelmaps()
+{
+  this->InputLabelmaps.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapExpressionFilter::SetExpression(const std::string& expression)
+{
+  this->Expression = expression;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapExpressionFilter::GetOperandNames(std::vector<std::string>& names)
+{
+  names.clear();
+  ExpressionParser parser(this->Expression);
+  std::unique_ptr<ExpressionNode> root = parser.Parse();
+  if (!root)
+  {
+    vtkErrorMacro("GetOperandNames: Invalid expression '" << this->Expression << "': " << parser.GetErrorMessage());
+    return false;
+  }
+  CollectOperandNames(root.get(), names);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkLabelmapExpressionFilter::GetOutputLabelmap()
+{
+  return this->OutputLabelmap;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapExpressionFilter::Update()
+{
+  this->OutputLabelmap = nullptr;
+
+  ExpressionParser parser(this->Expression);
+  std::unique_ptr<ExpressionNode> root = parser.Parse();
+  if (!root)
+  {
+    vtkErrorMacro("Update: Invalid expression '" << this->Expression << "': " << parser.GetErrorMessage());
+    return false;
+  }
+  std::vector<std::string> operandNames;
+  CollectOperandNames(root.get(), operandNames);
+  for (const std::string& name : operandNames)
+  {
+    vtkOrientedImageData* labelmap = this->GetInputLabelmap(name);
+    if (!labelmap || !labelmap->GetPointData()->GetScalars())
+    {
+      vtkErrorMacro("Update: Invalid input labelmap for name '" << name << "'");
+      return false;
+    }
+  }
+
+  // Bring all labelmaps to the grid of the first one. Labelmaps already on that grid are used with their own extent,
+  // as each operand is read only within its effective extent
+  vtkOrientedImageData* referenceLabelmap = this->GetInputLabelmap(operandNames[0]);
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  referenceLabelmap->GetImageToWorldMatrix(imageToWorldMatrix);
+  std::map<std::string, vtkSmartPointer<vtkOrientedImageData> > operandLabelmaps;
+  for (const std::string& name : operandNames)
+  {
+    vtkOrientedImageData* labelmap = this->GetInputLabelmap(name);
+    if (vtkSlicerRtCommon::DoImageGridsMatch(referenceLabelmap, labelmap))
+    {
+      operandLabelmaps[name] = labelmap;
+      continue;
+    }
+    vtkSmartPointer<vtkOrientedImageData> resampledLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+      labelmap, referenceLabelmap, resampledLabelmap, false, true))
+    {
+      vtkErrorMacro("Update: Failed to resample labelmap '" << name << "' to the grid of '" << operandNames[0] << "'");
+      return false;
+    }
+    operandLabelmaps[name] = resampledLabelmap;
+  }
+
+  if (!PrepareExpression(root.get(), operandLabelmaps, imageToWorldMatrix))
+  {
+    vtkErrorMacro("Update: Failed to evaluate margins of expression '" << this->Expression << "'");
+    return false;
+  }
+
+  const int* outputExtent = (IsExtentEmpty(this->OutputExtent) ? root->Box : this->OutputExtent);
+  this->OutputLabelmap = EvaluateExpression(root.get(), imageToWorldMatrix, outputExtent, this->OutputScalarType, this->OutputLabelValue);
+  if (!this->OutputLabelmap)
+  {
+    vtkErrorMacro("Update: Unsupported output scalar type " << this->OutputScalarType);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,108 @@
+#ifndef __vtkLabelmapExpressionFilter_h
+#define __vtkLabelmapExpressionFilter_h
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "vtkSlicerSegmentMorphologyModuleLogicExport.h"
+
+// STD includes
+#include <map>
+#include <string>
+#include <vector>
+
+class vtkOrientedImageData;
+
+/// \class vtkLabelmapExpressionFilter
+/// \brief Evaluate a boolean expression of binary labelmaps, with optional margins.
+///
+/// The expression refers to the input labelmaps by name, and supports the following operations
+/// in order of increasing precedence:
+///   - Union and subtraction: A | B, A - B
+///   - Intersection: A & B
+///   - Margins: grow(expression, margin) and shrink(expression, margin) with margin in mm, or with
+///     separate margins along the I, J and K axes as grow(expression, marginI, marginJ, marginK)
+///   - Parentheses
+/// Names of labelmaps that are not simple identifiers (letters, digits, '_' and '.') can be quoted
+/// with double quotes. For example a ring around a target avoiding organs at risk:
+///   (grow(PTV, 10) - grow(PTV, 3)) - (Bladder | Rectum)
+///
+/// The boolean operations are evaluated in one pass, row by row in parallel, within the bounding
+/// box of the result, without creating intermediate volumes. Only the operands of margins, that
+/// need the neighborhood of the voxels, are evaluated into temporary labelmaps covering their
+/// bounding box, and the margins are computed by \sa vtkLabelmapMarginFilter.
+///
+/// The output is on the voxel grid of the first labelmap in the expression. Labelmaps on the same grid
+/// are read within their own extent, that may differ from the others. Only labelmaps with different
+/// spacing, origin or directions are resampled to the grid using nearest neighbor interpolation.
+///
+/// Similarly to \sa vtkLabelmapMarginFilter, this class is not a VTK pipeline filter.
+class VTK_SLICER_SEGMENTMORPHOLOGY_MODULE_LOGIC_EXPORT vtkLabelmapExpressionFilter : public vtkObject
+{
+public:
+  static vtkLabelmapExpressionFilter *New();
+  vtkTypeMacro(vtkLabelmapExpressionFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set labelmap referred to by the given name in the expression.
+  /// Voxels with nonzero value are inside the structure
+  void SetInputLabelmap(const std::string& name, vtkOrientedImageData* labelmap);
+  /// Get labelmap with the given name, nullptr if there is none
+  vtkOrientedImageData* GetInputLabelmap(const std::string& name);
+  /// Remove all input labelmaps
+  void RemoveAllInputLabelmaps();
+
+  /// Set expression to evaluate
+  void SetExpression(const std::string& expression);
+  /// Get expression to evaluate
+  std::string GetExpression() { return this->Expression; };
+
+  /// Get names of the labelmaps referred to in the expression, in order of first appearance
+  /// \return Success flag, false if the expression is invalid
+  bool GetOperandNames(std::vector<std::string>& names);
+
+  /// Get/Set value of the structure voxels in the output labelmap. 1 by default
+  vtkGetMacro(OutputLabelValue, double);
+  vtkSetMacro(OutputLabelValue, double);
+
+  /// Get/Set scalar type of the output labelmap. Unsigned char by default
+  vtkGetMacro(OutputScalarType, int);
+  vtkSetMacro(OutputScalarType, int);
+
+  /// Get/Set extent of the output labelmap. If the extent is empty (default) then the output
+  /// extent is the bounding box of the result.
+  vtkGetVector6Macro(OutputExtent, int);
+  vtkSetVector6Macro(OutputExtent, int);
+
+  /// Evaluate the expression
+  /// \return Success flag
+  bool Update();
+
+  /// Get output labelmap
+  vtkOrientedImageData* GetOutputLabelmap();
+
+protected:
+  vtkLabelmapExpressionFilter();
+  ~vtkLabelmapExpressionFilter() override;
+
+protected:
+  /// Input labelmaps by name
+  std::map<std::string, vtkSmartPointer<vtkOrientedImageData> > InputLabelmaps;
+  /// Expression to evaluate
+  std::string Expression;
+  /// Output labelmap
+  vtkSmartPointer<vtkOrientedImageData> OutputLabelmap;
+
+  /// Value of the structure voxels in the output
+  double OutputLabelValue;
+  /// Scalar type of the output
+  int OutputScalarType;
+  /// Extent of the output. Bounding box of the result if empty
+  int OutputExtent[6];
+
+private:
+  vtkLabelmapExpressionFilter(const vtkLabelmapExpressionFilter&) = delete;
+  void operator=(const vtkLabelmapExpressionFilter&) = delete;
+};
+
+#endif
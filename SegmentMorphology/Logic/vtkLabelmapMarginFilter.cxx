@@ -0,0 +1,244 @@
+#include "vtkLabelmapMarginFilter.h"
+
+// SlicerRtCommon includes
+#include "vtkLabelmapDistanceTransform.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// vtk includes
+#include <vtkDataArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// Tolerance of the normalized squared distance, so that voxels exactly at the margin
+/// are not lost due to rounding errors
+const double MARGIN_TOLERANCE = 1e-6;
+
+//----------------------------------------------------------------------------
+/// Write label value to the image voxels where the mask defined on the box is nonzero, and zero
+/// elsewhere. The image extent must be within the box.
+template <class T>
+void FillImageFromMask(vtkImageData* image, T*, const int boxExtent[6], const std::vector<unsigned char>& mask, double labelValue)
+{
+  int imageExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  image->GetExtent(imageExtent);
+  if (imageExtent[0] > imageExtent[1] || imageExtent[2] > imageExtent[3] || imageExtent[4] > imageExtent[5])
+  {
+    return;
+  }
+
+  T value = static_cast<T>(labelValue);
+  vtkIdType boxDimensions[2] = { boxExtent[1] - boxExtent[0] + 1, boxExtent[3] - boxExtent[2] + 1 };
+  vtkSMPTools::For(imageExtent[4], imageExtent[5] + 1, [&](vtkIdType beginK, vtkIdType endK)
+  {
+    for (int k = static_cast<int>(beginK); k < static_cast<int>(endK); ++k)
+    {
+      for (int j = imageExtent[2]; j <= imageExtent[3]; ++j)
+      {
+        T* imagePtr = static_cast<T*>(image->GetScalarPointer(imageExtent[0], j, k));
+        const unsigned char* maskPtr = &mask[ ((k - boxExtent[4]) * boxDimensions[1] + (j - boxExtent[2])) * boxDimensions[0]
+          + (imageExtent[0] - boxExtent[0]) ];
+        for (int i = imageExtent[0]; i <= imageExtent[1]; ++i)
+        {
+          *(imagePtr++) = (*(maskPtr++) ? value : 0);
+        }
+      }
+    }
+  });
+}
+
+//----------------------------------------------------------------------------
+/// Set the mask voxels of the box outside the image extent to nonzero
+void FillMaskOutsideImage(vtkImageData* image, const int boxExtent[6], std::vector<unsigned char>& mask)
+{
+  int imageExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  image->GetExtent(imageExtent);
+  vtkIdType boxDimensions[2] = { boxExtent[1] - boxExtent[0] + 1, boxExtent[3] - boxExtent[2] + 1 };
+  vtkSMPTools::For(boxExtent[4], boxExtent[5] + 1, [&](vtkIdType beginK, vtkIdType endK)
+  {
+    for (int k = static_cast<int>(beginK); k < static_cast<int>(endK); ++k)
+    {
+      for (int j = boxExtent[2]; j <= boxExtent[3]; ++j)
+      {
+        bool rowOutside = (k < imageExtent[4] || k > imageExtent[5] || j < imageExtent[2] || j > imageExtent[3]);
+        unsigned char* maskPtr = &mask[ ((k - boxExtent[4]) * boxDimensions[1] + (j - boxExtent[2])) * boxDimensions[0] ];
+        for (int i = boxExtent[0]; i <= boxExtent[1]; ++i, ++maskPtr)
+        {
+          if (rowOutside || i < imageExtent[0] || i > imageExtent[1])
+          {
+            *maskPtr = 1;
+          }
+        }
+      }
+    }
+  });
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLabelmapMarginFilter);
+
+//----------------------------------------------------------------------------
+vtkLabelmapMarginFilter::vtkLabelmapMarginFilter()
+  : Shrink(false)
+  , OutputLabelValue(1.0)
+{
+  this->MarginMm[0] = this->MarginMm[1] = this->MarginMm[2] = 0.0;
+}
+
+//----------------------------------------------------------------------------
+vtkLabelmapMarginFilter::~vtkLabelmapMarginFilter() = default;
+
+//----------------------------------------------------------------------------
+void vtkLabelmapMarginFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "MarginMm: " << this->MarginMm[0] << ", " << this->MarginMm[1] << ", " << this->MarginMm[2] << "\n";
+  os << indent << "Shrink: " << (this->Shrink ? "true" : "false") << "\n";
+  os << indent << "OutputLabelValue: " << this->OutputLabelValue << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapMarginFilter::SetInputLabelmap(vtkOrientedImageData* labelmap)
+{
+  this->InputLabelmap = labelmap;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkLabelmapMarginFilter::GetInputLabelmap()
+{
+  return this->InputLabelmap;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkLabelmapMarginFilter::GetOutputLabelmap()
+{
+  return this->OutputLabelmap;
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapMarginFilter::Update()
+{
+  this->OutputLabelmap = nullptr;
+
+  vtkOrientedImageData* inputLabelmap = this->InputLabelmap;
+  if (!inputLabelmap || !inputLabelmap->GetPointData()->GetScalars())
+  {
+    vtkErrorMacro("Update: Invalid input labelmap");
+    return false;
+  }
+  if (this->MarginMm[0] < 0.0 || this->MarginMm[1] < 0.0 || this->MarginMm[2] < 0.0)
+  {
+    vtkErrorMacro("Update: Margins must not be negative");
+    return false;
+  }
+
+  vtkSmartPointer<vtkOrientedImageData> outputLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  inputLabelmap->GetImageToWorldMatrix(imageToWorldMatrix);
+  outputLabelmap->SetImageToWorldMatrix(imageToWorldMatrix);
+
+  int effectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (!vtkOrientedImageDataResample::CalculateEffectiveExtent(inputLabelmap, effectiveExtent))
+  {
+    vtkErrorMacro("Update: Failed to determine extent of the structure");
+    return false;
+  }
+  if ( effectiveExtent[0] > effectiveExtent[1] || effectiveExtent[2] > effectiveExtent[3]
+    || effectiveExtent[4] > effectiveExtent[5] )
+  {
+    // Empty structure remains empty
+    outputLabelmap->SetExtent(inputLabelmap->GetExtent());
+    outputLabelmap->AllocateScalars(inputLabelmap->GetScalarType(), 1);
+    outputLabelmap->GetPointData()->GetScalars()->Fill(0);
+    this->OutputLabelmap = outputLabelmap;
+    return true;
+  }
+
+  // Scale the axes so that the margin ellipsoid becomes a unit sphere. Zero margin along an axis
+  // is represented by zero spacing, which disables the distance transform along that axis.
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  inputLabelmap->GetSpacing(spacing);
+  double normalizedSpacing[3] = { 0.0, 0.0, 0.0 };
+  int marginVoxels[3] = { 0, 0, 0 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (this->MarginMm[axis] > 0.0)
+    {
+      normalizedSpacing[axis] = spacing[axis] / this->MarginMm[axis];
+      marginVoxels[axis] = static_cast<int>(this->MarginMm[axis] / spacing[axis] + MARGIN_TOLERANCE);
+    }
+  }
+
+  // Expansion: the structure can grow by the margin, so the box is the bounding box of the
+  // structure padded by the margin, and the output is the whole box.
+  // Shrinking: one layer of background voxels around the bounding box of the structure stands for
+  // the background outside, as it is at least as close to any voxel inside as the voxels beyond.
+  // Where the layer is outside the image, it is not background.
+  int boxExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  int outputExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  int boxDimensions[3] = { 0, 0, 0 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    int padding = (this->Shrink ? 1 : marginVoxels[axis]);
+    boxExtent[2*axis] = effectiveExtent[2*axis] - padding;
+    boxExtent[2*axis+1] = effectiveExtent[2*axis+1] + padding;
+    boxDimensions[axis] = boxExtent[2*axis+1] - boxExtent[2*axis] + 1;
+    outputExtent[2*axis] = (this->Shrink ? effectiveExtent[2*axis] : boxExtent[2*axis]);
+    outputExtent[2*axis+1] = (this->Shrink ? effectiveExtent[2*axis+1] : boxExtent[2*axis+1]);
+  }
+  vtkIdType numberOfBoxVoxels = static_cast<vtkIdType>(boxDimensions[0]) * boxDimensions[1] * boxDimensions[2];
+
+  std::vector<unsigned char> mask(numberOfBoxVoxels, 0);
+  if (!vtkLabelmapDistanceTransform::FillMaskFromImage(inputLabelmap, boxExtent, mask))
+  {
+    vtkErrorMacro("Update: Unsupported input labelmap scalar type");
+    return false;
+  }
+  if (this->Shrink)
+  {
+    FillMaskOutsideImage(inputLabelmap, boxExtent, mask);
+  }
+
+  // Distance from the structure for expansion, from the background for shrinking
+  std::vector<double> squaredDistances;
+  vtkLabelmapDistanceTransform::ComputeSquaredDistanceTransform(mask, (this->Shrink ? 0 : 1), boxDimensions, normalizedSpacing, squaredDistances);
+
+  // Voxels within the margin from the structure are added, voxels within the margin from the
+  // background are removed
+  bool shrink = this->Shrink;
+  vtkSMPTools::For(0, numberOfBoxVoxels, [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType voxelIndex = begin; voxelIndex < end; ++voxelIndex)
+    {
+      bool withinMargin = (squaredDistances[voxelIndex] <= 1.0 + MARGIN_TOLERANCE);
+      mask[voxelIndex] = (shrink ? (mask[voxelIndex] && !withinMargin) : withinMargin);
+    }
+  });
+
+  outputLabelmap->SetExtent(outputExtent);
+  outputLabelmap->AllocateScalars(inputLabelmap->GetScalarType(), 1);
+  switch (outputLabelmap->GetScalarType())
+  {
+    vtkTemplateMacro(FillImageFromMask<VTK_TT>(outputLabelmap, static_cast<VTK_TT*>(nullptr), boxExtent, mask, this->OutputLabelValue));
+    default:
+      vtkErrorMacro("Update: Unsupported output labelmap scalar type");
+      return false;
+  }
+
+  this->OutputLabelmap = outputLabelmap;
+  return true;
+}
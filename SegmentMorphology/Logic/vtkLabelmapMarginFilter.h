@@ -0,0 +1,86 @@
+#ifndef __vtkLabelmapMarginFilter_h
+#define __vtkLabelmapMarginFilter_h
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "vtkSlicerSegmentMorphologyModuleLogicExport.h"
+
+class vtkOrientedImageData;
+
+/// \class vtkLabelmapMarginFilter
+/// \brief Grow or shrink a binary labelmap by an anisotropic (ellipsoidal) margin.
+///
+/// A voxel is part of the expanded structure if there is a structure voxel within the ellipsoid
+/// defined by the margins along the image axes around it. Shrinking is the complement: a voxel
+/// remains in the structure if there is no background voxel within the ellipsoid around it.
+/// Voxels outside the input image are not background, so the structure is not shrunk from the
+/// boundary of the image, the same way as by vtkImageContinuousErode3D.
+/// The margins are exact, unlike the box kernels of vtkImageContinuousDilate3D and
+/// vtkImageContinuousErode3D.
+///
+/// The voxel coordinates are scaled with the margins so that the ellipsoid becomes a unit
+/// sphere, and the squared Euclidean distance transform of the structure (or the background)
+/// is computed with a separable linear time algorithm. The runtime therefore does not depend
+/// on the size of the margin, only on the number of voxels processed, which are restricted to
+/// the bounding box of the structure padded by the margin. The lines of the distance transform
+/// are processed in parallel.
+///
+/// Similarly to the SegmentComparison labelmap filters, this class is not a VTK pipeline filter.
+class VTK_SLICER_SEGMENTMORPHOLOGY_MODULE_LOGIC_EXPORT vtkLabelmapMarginFilter : public vtkObject
+{
+public:
+  static vtkLabelmapMarginFilter *New();
+  vtkTypeMacro(vtkLabelmapMarginFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set input labelmap. Voxels with nonzero value are inside the structure
+  void SetInputLabelmap(vtkOrientedImageData* labelmap);
+  /// Get input labelmap
+  vtkOrientedImageData* GetInputLabelmap();
+
+  /// Get/Set margin along the I, J and K axes of the labelmap in mm. Zero margin along an axis
+  /// leaves the structure unchanged along that axis.
+  vtkGetVector3Macro(MarginMm, double);
+  vtkSetVector3Macro(MarginMm, double);
+
+  /// Get/Set flag determining whether the structure is shrunk instead of expanded. Off by default
+  vtkGetMacro(Shrink, bool);
+  vtkSetMacro(Shrink, bool);
+  vtkBooleanMacro(Shrink, bool);
+
+  /// Get/Set value of the structure voxels in the output labelmap. 1 by default
+  vtkGetMacro(OutputLabelValue, double);
+  vtkSetMacro(OutputLabelValue, double);
+
+  /// Compute the output labelmap
+  /// \return Success flag
+  bool Update();
+
+  /// Get output labelmap. It has the same geometry and scalar type as the input.
+  /// Its extent is the bounding box of the input structure, padded by the margin for expansion.
+  vtkOrientedImageData* GetOutputLabelmap();
+
+protected:
+  vtkLabelmapMarginFilter();
+  ~vtkLabelmapMarginFilter() override;
+
+protected:
+  /// Input labelmap
+  vtkSmartPointer<vtkOrientedImageData> InputLabelmap;
+  /// Output labelmap
+  vtkSmartPointer<vtkOrientedImageData> OutputLabelmap;
+
+  /// Margin along the image axes in mm
+  double MarginMm[3];
+  /// Flag determining whether the structure is shrunk instead of expanded
+  bool Shrink;
+  /// Value of the structure voxels in the output
+  double OutputLabelValue;
+
+private:
+  vtkLabelmapMarginFilter(const vtkLabelmapMarginFilter&) = delete;
+  void operator=(const vtkLabelmapMarginFilter&) = delete;
+};
+
+#endif
@@ -52,6 +52,7 @@ vtkMRMLSegmentMorphologyNode::vtkMRMLSegmentMorphologyNode()
   this->XSize = 1;
   this->YSize = 1;
   this->ZSize = 1;
+  this->UseDistanceTransformMargin = false;
 
   this->HideFromEditors = false;
 }
@@ -76,6 +77,7 @@ void vtkMRMLSegmentMorphologyNode::WriteXML(ostream& of, int nIndent)
   of << " XSize=\"" << (this->XSize) << "\"";
   of << " YSize=\"" << (this->YSize) << "\"";
   of << " ZSize=\"" << (this->ZSize) << "\"";
+  of << " UseDistanceTransformMargin=\"" << (this->UseDistanceTransformMargin ? "true" : "false") << "\"";
 }
 
 //----------------------------------------------------------------------------
@@ -116,6 +118,10 @@ void vtkMRMLSegmentMorphologyNode::ReadXMLAttributes(const char** atts)
       {
       this->ZSize = vtkVariant(attValue).ToDouble();
       }
+    else if (!strcmp(attName, "UseDistanceTransformMargin")) 
+      {
+      this->UseDistanceTransformMargin = (strcmp(attValue,"true") ? false : true);
+      }
     }
 }
 
@@ -135,6 +141,7 @@ void vtkMRMLSegmentMorphologyNode::Copy(vtkMRMLNode *anode)
   this->XSize = node->XSize;
   this->YSize = node->YSize;
   this->ZSize = node->ZSize;
+  this->UseDistanceTransformMargin = node->UseDistanceTransformMargin;
 
   this->DisableModifiedEventOff();
   this->InvokePendingModifiedEvent();
@@ -152,6 +159,7 @@ void vtkMRMLSegmentMorphologyNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << " XSize:   " << (this->XSize) << "\n";
   os << indent << " YSize:   " << (this->YSize) << "\n";
   os << indent << " ZSize:   " << (this->ZSize) << "\n";
+  os << indent << " UseDistanceTransformMargin:   " << (this->UseDistanceTransformMargin ? "true" : "false") << "\n";
 }
 
 //----------------------------------------------------------------------------
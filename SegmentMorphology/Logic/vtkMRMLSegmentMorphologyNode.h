@@ -106,6 +106,12 @@ public:
   vtkGetMacro(ZSize, double);
   vtkSetMacro(ZSize, double);
 
+  /// Get/Set flag determining whether Expand and Shrink use exact ellipsoidal margins computed
+  /// with a distance transform instead of dilation/erosion with a box kernel
+  vtkGetMacro(UseDistanceTransformMargin, bool);
+  vtkSetMacro(UseDistanceTransformMargin, bool);
+  vtkBooleanMacro(UseDistanceTransformMargin, bool);
+
 protected:
   vtkMRMLSegmentMorphologyNode();
   ~vtkMRMLSegmentMorphologyNode();
@@ -130,6 +136,10 @@ protected:
 
   /// Dimension parameter for the Z axis (for Expand or Shrink)
   double ZSize;
+
+  /// Flag determining whether the margins of Expand and Shrink are computed with a distance
+  /// transform. Off by default
+  bool UseDistanceTransformMargin;
 };
 
 #endif
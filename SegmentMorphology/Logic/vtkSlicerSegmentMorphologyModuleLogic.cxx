@@ -22,6 +22,8 @@
 // SegmentMorphology Logic includes
 #include "vtkSlicerSegmentMorphologyModuleLogic.h"
 #include "vtkMRMLSegmentMorphologyNode.h"
+#include "vtkLabelmapExpressionFilter.h"
+#include "vtkLabelmapMarginFilter.h"
 
 // SlicerRT includes
 #include "vtkSlicerRtCommon.h"
@@ -40,12 +42,32 @@
 #include <vtkImageAccumulate.h>
 #include <vtkImageContinuousDilate3D.h>
 #include <vtkImageContinuousErode3D.h>
-#include <vtkImageLogic.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 #include <vtkImageConstantPad.h>
 
+//----------------------------------------------------------------------------
+namespace
+{
+/// Grow or shrink labelmap by exact ellipsoidal margin using a distance transform
+/// \return Output labelmap, nullptr on failure
+vtkSmartPointer<vtkImageData> ApplyDistanceTransformMargin(vtkOrientedImageData* image,
+  double xSize, double ySize, double zSize, bool shrink, double labelValue)
+{
+  vtkSmartPointer<vtkLabelmapMarginFilter> marginFilter = vtkSmartPointer<vtkLabelmapMarginFilter>::New();
+  marginFilter->SetInputLabelmap(image);
+  marginFilter->SetMarginMm(xSize, ySize, zSize);
+  marginFilter->SetShrink(shrink);
+  marginFilter->SetOutputLabelValue(labelValue);
+  if (!marginFilter->Update())
+  {
+    return nullptr;
+  }
+  return marginFilter->GetOutputLabelmap();
+}
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerSegmentMorphologyModuleLogic);
 
@@ -202,6 +224,7 @@ std::string vtkSlicerSegmentMorphologyModuleLogic::ApplyMorphologyOperation(vtkM
 
   // If binary operation is selected, prepare segment B for processing
   vtkSmartPointer<vtkOrientedImageData> imageB = vtkSmartPointer<vtkOrientedImageData>::New();
+  int unionExtent[6] = {0,-1,0,-1,0,-1};
   vtkMRMLSegmentationNode* inputSegmentationBNode = parameterNode->GetSegmentationBNode();
   const char* segmentBID = parameterNode->GetSegmentBID();
   if ( operation == vtkMRMLSegmentMorphologyNode::Union
@@ -228,21 +251,16 @@ std::string vtkSlicerSegmentMorphologyModuleLogic::ApplyMorphologyOperation(vtkM
       vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(imageB, imageA, imageB, true);
     }
 
-    // Make sure the two volumes have the same extent (otherwise logic filter crashes)
+    // Output covers both volumes. The expression filter handles the different extents without padding the inputs
     int aExtent[6] = {0,-1,0,-1,0,-1};
     imageA->GetExtent(aExtent);
     int bExtent[6] = {0,-1,0,-1,0,-1};
     imageB->GetExtent(bExtent);
-    int unionExtent[6] = { std::min(aExtent[0],bExtent[0]), std::max(aExtent[1],bExtent[1]), std::min(aExtent[2],bExtent[2]), std::max(aExtent[3],bExtent[3]), std::min(aExtent[4],bExtent[4]), std::max(aExtent[5],bExtent[5]) };
-
-    vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
-    padder->SetInputData(imageA);
-    padder->SetOutputWholeExtent(unionExtent);
-    padder->Update();
-    imageA->vtkImageData::DeepCopy(padder->GetOutput());
-    padder->SetInputData(imageB);
-    padder->Update();
-    imageB->vtkImageData::DeepCopy(padder->GetOutput());
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      unionExtent[2*axis] = std::min(aExtent[2*axis], bExtent[2*axis]);
+      unionExtent[2*axis+1] = std::max(aExtent[2*axis+1], bExtent[2*axis+1]);
+    }
   }
 
   // Get kernel size
@@ -264,12 +282,22 @@ std::string vtkSlicerSegmentMorphologyModuleLogic::ApplyMorphologyOperation(vtkM
   histogram->Update();
   double valueMax = histogram->GetMax()[0];
 
+  // Exact ellipsoidal margins are computed only within the bounding box of the segment, so the
+  // runtime does not depend on the margin size. Box kernels are used by default.
+  bool useDistanceTransformMargin = parameterNode->GetUseDistanceTransformMargin();
+
   vtkSmartPointer<vtkImageData> tempOutputImageData = nullptr;
   switch (operation) 
   {
   // Expand
   case vtkMRMLSegmentMorphologyNode::Expand:
     {
+    if (useDistanceTransformMargin)
+    {
+      tempOutputImageData = ApplyDistanceTransformMargin(imageA, xSize, ySize, zSize, false, valueMax);
+      break;
+    }
+
     // Pad image by expansion extent (extents are fitted to the structure, dilate will reach the edge of the image)
     vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
     padder->SetInputData(imageA);
@@ -292,6 +320,12 @@ std::string vtkSlicerSegmentMorphologyModuleLogic::ApplyMorphologyOperation(vtkM
   // Shrink
   case vtkMRMLSegmentMorphologyNode::Shrink:
     {
+    if (useDistanceTransformMargin)
+    {
+      tempOutputImageData = ApplyDistanceTransformMargin(imageA, xSize, ySize, zSize, true, valueMax);
+      break;
+    }
+
     vtkSmartPointer<vtkImageContinuousErode3D> erodeFilter = vtkSmartPointer<vtkImageContinuousErode3D>::New();
     erodeFilter->SetInputData(imageA);
     erodeFilter->SetKernelSize(kernelSize[0], kernelSize[1], kernelSize[2]);
@@ -300,54 +334,45 @@ std::string vtkSlicerSegmentMorphologyModuleLogic::ApplyMorphologyOperation(vtkM
     break;
     }
 
-  // Union
+  // Union, intersect, subtract: single operation case of the segment expressions
   case vtkMRMLSegmentMorphologyNode::Union:
+  case vtkMRMLSegmentMorphologyNode::Intersect:
+  case vtkMRMLSegmentMorphologyNode::Subtract:
     {
-    vtkSmartPointer<vtkImageLogic> logicFilter = vtkSmartPointer<vtkImageLogic>::New();
-    logicFilter->SetInput1Data(imageA);
-    logicFilter->SetInput2Data(imageB);
-    logicFilter->SetOperationToOr();
-    logicFilter->SetOutputTrueValue(valueMax);
-    logicFilter->Update();
-    tempOutputImageData = logicFilter->GetOutput();
-    break;
+    vtkSmartPointer<vtkLabelmapExpressionFilter> expressionFilter = vtkSmartPointer<vtkLabelmapExpressionFilter>::New();
+    expressionFilter->SetInputLabelmap("A", imageA);
+    expressionFilter->SetInputLabelmap("B", imageB);
+    if (operation == vtkMRMLSegmentMorphologyNode::Union)
+    {
+      expressionFilter->SetExpression("A | B");
     }
-
-  // Intersect
-  case vtkMRMLSegmentMorphologyNode::Intersect:
+    else if (operation == vtkMRMLSegmentMorphologyNode::Intersect)
     {
-    vtkSmartPointer<vtkImageLogic> logicFilter = vtkSmartPointer<vtkImageLogic>::New();
-    logicFilter->SetInput1Data(imageA);
-    logicFilter->SetInput2Data(imageB);
-    logicFilter->SetOperationToAnd();
-    logicFilter->SetOutputTrueValue(valueMax);
-    logicFilter->Update();
-    tempOutputImageData = logicFilter->GetOutput();
-    break;
+      expressionFilter->SetExpression("A & B");
     }
-
-  // Subtract
-  case vtkMRMLSegmentMorphologyNode::Subtract:
+    else
     {
-    vtkSmartPointer<vtkImageLogic> logicFilter = vtkSmartPointer<vtkImageLogic>::New();
-    logicFilter->SetInput1Data(imageB);
-    logicFilter->SetOperationToNot();
-    logicFilter->SetOutputTrueValue(valueMax);
-    logicFilter->Update();
-
-    vtkSmartPointer<vtkImageLogic> logicFilter2 = vtkSmartPointer<vtkImageLogic>::New();
-    logicFilter2->SetInput1Data(imageA);
-    logicFilter2->SetInput2Data(logicFilter->GetOutput());
-    logicFilter2->SetOperationToAnd();
-    logicFilter2->SetOutputTrueValue(valueMax);
-    logicFilter2->Update();
-    tempOutputImageData = logicFilter2->GetOutput();
+      expressionFilter->SetExpression("A - B");
+    }
+    expressionFilter->SetOutputExtent(unionExtent);
+    expressionFilter->SetOutputScalarType(imageA->GetScalarType());
+    expressionFilter->SetOutputLabelValue(valueMax);
+    if (expressionFilter->Update())
+    {
+      tempOutputImageData = expressionFilter->GetOutputLabelmap();
+    }
     break;
     }
   default:
     vtkErrorMacro("ApplyMorphologyOperation: Invalid operation!")
     break;
   }
+  if (!tempOutputImageData)
+  {
+    std::string errorMessage("Failed to apply morphological operation on segment A: " + std::string(segmentAID));
+    vtkErrorMacro("ApplyMorphologyOperation: " << errorMessage);
+    return errorMessage;
+  }
 
   // Clear output segmentation and make sure master is binary labelmap
   std::vector<std::string> segmentIds;
@@ -383,6 +408,104 @@ std::string vtkSlicerSegmentMorphologyModuleLogic::ApplyMorphologyOperation(vtkM
   return "";
 }
 
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentMorphologyModuleLogic::ApplySegmentExpression(vtkMRMLSegmentationNode* inputSegmentationNode,
+  const std::string& expression, vtkMRMLSegmentationNode* outputSegmentationNode, const std::string& outputSegmentName/*=""*/)
+{
+  if (!inputSegmentationNode || !outputSegmentationNode)
+  {
+    std::string errorMessage("Input or output segmentation is not selected");
+    vtkErrorMacro("ApplySegmentExpression: " << errorMessage);
+    return errorMessage;
+  }
+  vtkSegmentation* inputSegmentation = inputSegmentationNode->GetSegmentation();
+  vtkSegmentation* outputSegmentation = outputSegmentationNode->GetSegmentation();
+  std::string inputTransformNodeID(
+    inputSegmentationNode->GetTransformNodeID() ? inputSegmentationNode->GetTransformNodeID() : "" );
+  std::string outputTransformNodeID(
+    outputSegmentationNode->GetTransformNodeID() ? outputSegmentationNode->GetTransformNodeID() : "" );
+  if (outputSegmentation->GetNumberOfSegments() > 0 && inputTransformNodeID != outputTransformNodeID)
+  {
+    std::string errorMessage("Output segmentation must be in the same coordinate frame as the input segmentation");
+    vtkErrorMacro("ApplySegmentExpression: " << errorMessage);
+    return errorMessage;
+  }
+
+  vtkSmartPointer<vtkLabelmapExpressionFilter> expressionFilter = vtkSmartPointer<vtkLabelmapExpressionFilter>::New();
+  expressionFilter->SetExpression(expression);
+  std::vector<std::string> operandNames;
+  if (!expressionFilter->GetOperandNames(operandNames))
+  {
+    std::string errorMessage("Invalid segment expression: " + expression);
+    vtkErrorMacro("ApplySegmentExpression: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Operands are segment IDs or segment names
+  std::vector<std::string> segmentIDs;
+  inputSegmentation->GetSegmentIDs(segmentIDs);
+  for (const std::string& operandName : operandNames)
+  {
+    std::string segmentID;
+    if (inputSegmentation->GetSegment(operandName))
+    {
+      segmentID = operandName;
+    }
+    else
+    {
+      for (std::vector<std::string>::iterator segmentIt = segmentIDs.begin(); segmentIt != segmentIDs.end(); ++segmentIt)
+      {
+        const char* segmentName = inputSegmentation->GetSegment(*segmentIt)->GetName();
+        if (segmentName && operandName == segmentName)
+        {
+          segmentID = *segmentIt;
+          break;
+        }
+      }
+    }
+
+    vtkSmartPointer<vtkOrientedImageData> segmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (segmentID.empty() || !inputSegmentationNode->GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap))
+    {
+      std::string errorMessage("Failed to get binary labelmap of segment: " + operandName);
+      vtkErrorMacro("ApplySegmentExpression: " << errorMessage);
+      return errorMessage;
+    }
+    expressionFilter->SetInputLabelmap(operandName, segmentLabelmap);
+  }
+
+  if (!expressionFilter->Update())
+  {
+    std::string errorMessage("Failed to evaluate segment expression: " + expression);
+    vtkErrorMacro("ApplySegmentExpression: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Add result as new segment. It is in the coordinate frame of the input segmentation
+  if (outputSegmentation->GetNumberOfSegments() == 0)
+  {
+    outputSegmentation->SetMasterRepresentationName(
+      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() );
+    if (outputSegmentationNode != inputSegmentationNode)
+    {
+      outputSegmentationNode->SetAndObserveTransformNodeID(inputSegmentationNode->GetTransformNodeID());
+    }
+  }
+
+  vtkSmartPointer<vtkSegment> newSegment = vtkSmartPointer<vtkSegment>::New();
+  newSegment->SetName(outputSegmentName.empty() ? expression.c_str() : outputSegmentName.c_str());
+  newSegment->AddRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), expressionFilter->GetOutputLabelmap() );
+  if (!outputSegmentation->AddSegment(newSegment))
+  {
+    std::string errorMessage("Failed to add segment to output segmentation");
+    vtkErrorMacro("ApplySegmentExpression: " << errorMessage);
+    return errorMessage;
+  }
+
+  return "";
+}
+
 //---------------------------------------------------------------------------
 std::string vtkSlicerSegmentMorphologyModuleLogic::GenerateOutputSegmentName(vtkMRMLSegmentMorphologyNode* parameterNode)
 {
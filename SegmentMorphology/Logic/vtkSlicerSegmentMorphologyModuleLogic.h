@@ -34,6 +34,7 @@
 #include "vtkSlicerSegmentMorphologyModuleLogicExport.h"
 
 class vtkMRMLSegmentMorphologyNode;
+class vtkMRMLSegmentationNode;
 
 /// \ingroup SlicerRt_QtModules_SegmentMorphology
 class VTK_SLICER_SEGMENTMORPHOLOGY_MODULE_LOGIC_EXPORT vtkSlicerSegmentMorphologyModuleLogic :
@@ -48,6 +49,16 @@ public:
   /// \return Error message, empty string if no error
   std::string ApplyMorphologyOperation(vtkMRMLSegmentMorphologyNode* parameterNode);
 
+  /// Evaluate boolean expression of segments with optional margins, and add the result as a new segment.
+  /// For example a ring around the target avoiding organs at risk:
+  ///   (grow(PTV, 10) - grow(PTV, 3)) - (Bladder | Rectum)
+  /// The operations are evaluated in one pass without intermediate volumes, see \sa vtkLabelmapExpressionFilter
+  /// for the syntax. Operands are segment IDs or names in the input segmentation.
+  /// \param outputSegmentName Name of the new segment. The expression is used if empty
+  /// \return Error message, empty string if no error
+  std::string ApplySegmentExpression(vtkMRMLSegmentationNode* inputSegmentationNode, const std::string& expression,
+    vtkMRMLSegmentationNode* outputSegmentationNode, const std::string& outputSegmentName="");
+
 protected:
   /// Generate output segment name from input segment names
   std::string GenerateOutputSegmentName(vtkMRMLSegmentMorphologyNode* parameterNode);
@@ -0,0 +1,167 @@
+// Module includes
+#include "vtkLabelmapExpressionFilter.h"
+
+// Testing includes
+#include "LabelmapTestingUtilities.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace LabelmapTestingUtilities;
+
+namespace
+{
+const int CHECKED_EXTENT[6] = { -12, 40, -12, 40, -8, 24 };
+const short LABEL_VALUE = 5;
+
+//-----------------------------------------------------------------------------
+bool CheckExpression(vtkLabelmapExpressionFilter* expressionFilter, const std::string& expression,
+  std::function<bool(int, int, int)> isExpectedInside)
+{
+  expressionFilter->SetExpression(expression);
+  if (!expressionFilter->Update() || !expressionFilter->GetOutputLabelmap())
+  {
+    std::cerr << "Failed to evaluate expression " << expression << std::endl;
+    return false;
+  }
+  vtkOrientedImageData* outputLabelmap = expressionFilter->GetOutputLabelmap();
+  for (int k = CHECKED_EXTENT[4]; k <= CHECKED_EXTENT[5]; ++k)
+  {
+    for (int j = CHECKED_EXTENT[2]; j <= CHECKED_EXTENT[3]; ++j)
+    {
+      for (int i = CHECKED_EXTENT[0]; i <= CHECKED_EXTENT[1]; ++i)
+      {
+        bool expected = isExpectedInside(i, j, k);
+        if (IsInside(outputLabelmap, i, j, k) != expected)
+        {
+          std::cerr << "Expression " << expression << " mismatch at (" << i << ", " << j << ", " << k << "): expected "
+            << (expected ? "inside" : "outside") << std::endl;
+          return false;
+        }
+        if (expected && outputLabelmap->GetScalarComponentAsDouble(i, j, k, 0) != LABEL_VALUE)
+        {
+          std::cerr << "Expression " << expression << " has invalid label value at (" << i << ", " << j << ", " << k << ")" << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkLabelmapExpressionFilterTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  // Labelmaps on the same grid with different extents
+  std::function<bool(int, int, int)> isInsideA = [](int i, int j, int k)
+  {
+    double x = (i - 10.0) * SPACING[0];
+    double y = (j - 12.0) * SPACING[1];
+    double z = (k - 7.0) * SPACING[2];
+    return (x*x/64.0 + y*y/49.0 + z*z/81.0 < 1.0);
+  };
+  std::function<bool(int, int, int)> isInsideB = [](int i, int j, int k)
+  {
+    return (i >= 12 && i <= 25 && j >= 2 && j <= 14 && k >= 5 && k <= 12);
+  };
+  std::function<bool(int, int, int)> isInsideC = [](int i, int j, int k)
+  {
+    double x = (i - 4.0) * SPACING[0];
+    double y = (j - 20.0) * SPACING[1];
+    double z = (k - 9.0) * SPACING[2];
+    return (x*x + y*y + z*z < 36.0);
+  };
+  int extentA[6] = { 0, 20, 0, 24, 0, 15 };
+  int extentB[6] = { 10, 30, 0, 20, 3, 14 };
+  int extentC[6] = { -5, 14, 10, 30, 4, 16 };
+  vtkSmartPointer<vtkOrientedImageData> labelmapA = CreateLabelmap(extentA, isInsideA);
+  vtkSmartPointer<vtkOrientedImageData> labelmapB = CreateLabelmap(extentB, isInsideB);
+  vtkSmartPointer<vtkOrientedImageData> labelmapC = CreateLabelmap(extentC, isInsideC);
+  std::function<bool(int, int, int)> inA = [&](int i, int j, int k) { return IsInside(labelmapA, i, j, k); };
+  std::function<bool(int, int, int)> inB = [&](int i, int j, int k) { return IsInside(labelmapB, i, j, k); };
+  std::function<bool(int, int, int)> inC = [&](int i, int j, int k) { return IsInside(labelmapC, i, j, k); };
+
+  vtkSmartPointer<vtkLabelmapExpressionFilter> expressionFilter = vtkSmartPointer<vtkLabelmapExpressionFilter>::New();
+  expressionFilter->SetInputLabelmap("A", labelmapA);
+  expressionFilter->SetInputLabelmap("B", labelmapB);
+  expressionFilter->SetInputLabelmap("Structure C", labelmapC);
+  expressionFilter->SetOutputScalarType(VTK_SHORT);
+  expressionFilter->SetOutputLabelValue(LABEL_VALUE);
+
+  // Intersection has higher precedence than union and subtraction
+  if (!CheckExpression(expressionFilter, "(A | B) - \"Structure C\" & A", [&](int i, int j, int k)
+    { return (inA(i, j, k) || inB(i, j, k)) && !(inC(i, j, k) && inA(i, j, k)); }))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Ring around a structure avoiding other structures
+  const double ringMarginMm[3] = { 3.0, 2.0, 4.0 };
+  if (!CheckExpression(expressionFilter, "grow(A, 3, 2, 4) - A - (B | \"Structure C\")", [&](int i, int j, int k)
+    { return IsWithinMargin(inA, ringMarginMm, i, j, k, true) && !inA(i, j, k) && !inB(i, j, k) && !inC(i, j, k); }))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Margin of boolean expression
+  const double shrinkMarginMm[3] = { 2.0, 2.0, 2.0 };
+  std::function<bool(int, int, int)> inAOrB = [&](int i, int j, int k) { return inA(i, j, k) || inB(i, j, k); };
+  if (!CheckExpression(expressionFilter, "shrink(A | B, 2) & grow(\"Structure C\", 5)", [&](int i, int j, int k)
+    {
+      const double growMarginMm[3] = { 5.0, 5.0, 5.0 };
+      return inAOrB(i, j, k) && !IsWithinMargin(inAOrB, shrinkMarginMm, i, j, k, false)
+        && IsWithinMargin(inC, growMarginMm, i, j, k, true);
+    }))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Output extent is the bounding box of the result by default, or the requested extent
+  expressionFilter->SetExpression("A & B");
+  expressionFilter->Update();
+  int outputExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  expressionFilter->GetOutputLabelmap()->GetExtent(outputExtent);
+  if (outputExtent[0] < 12 || outputExtent[1] > 20 || outputExtent[2] < 2 || outputExtent[3] > 14)
+  {
+    std::cerr << "Output extent of intersection is not within the bounding box of the operands" << std::endl;
+    return EXIT_FAILURE;
+  }
+  int requestedExtent[6] = { -3, 33, -1, 31, 0, 17 };
+  expressionFilter->SetOutputExtent(requestedExtent);
+  expressionFilter->Update();
+  expressionFilter->GetOutputLabelmap()->GetExtent(outputExtent);
+  for (int index = 0; index < 6; ++index)
+  {
+    if (outputExtent[index] != requestedExtent[index])
+    {
+      std::cerr << "Output extent does not match the requested extent" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Invalid expressions
+  std::vector<std::string> operandNames;
+  expressionFilter->SetExpression("grow(A | B, 5) - \"Structure C\" & A");
+  if (!expressionFilter->GetOperandNames(operandNames) || operandNames.size() != 3 || operandNames[2] != "Structure C")
+  {
+    std::cerr << "Failed to get operand names" << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (const char* invalidExpression : { "A |", "(A & B", "grow(A, 1, 2)", "A B", "D" })
+  {
+    expressionFilter->SetExpression(invalidExpression);
+    if (expressionFilter->Update())
+    {
+      std::cerr << "Invalid expression " << invalidExpression << " is evaluated" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
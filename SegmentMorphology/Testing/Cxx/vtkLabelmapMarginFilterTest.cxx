@@ -0,0 +1,127 @@
+// Module includes
+#include "vtkLabelmapMarginFilter.h"
+
+// Testing includes
+#include "LabelmapTestingUtilities.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <vector>
+
+using namespace LabelmapTestingUtilities;
+
+namespace
+{
+const int DIMENSION = 20;
+const int EXTENT[6] = { 0, DIMENSION-1, 0, DIMENSION-1, 0, DIMENSION-1 };
+const unsigned char LABEL_VALUE = 7;
+
+//-----------------------------------------------------------------------------
+bool CheckMargin(vtkOrientedImageData* inputLabelmap, const double marginMm[3], bool shrink)
+{
+  vtkSmartPointer<vtkLabelmapMarginFilter> marginFilter = vtkSmartPointer<vtkLabelmapMarginFilter>::New();
+  marginFilter->SetInputLabelmap(inputLabelmap);
+  marginFilter->SetMarginMm(marginMm[0], marginMm[1], marginMm[2]);
+  marginFilter->SetShrink(shrink);
+  marginFilter->SetOutputLabelValue(LABEL_VALUE);
+  if (!marginFilter->Update() || !marginFilter->GetOutputLabelmap())
+  {
+    std::cerr << "Failed to apply margin" << std::endl;
+    return false;
+  }
+  vtkOrientedImageData* outputLabelmap = marginFilter->GetOutputLabelmap();
+  // Voxels outside the input image are not background when shrinking
+  int inputExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  inputLabelmap->GetExtent(inputExtent);
+  auto isInputInside = [inputLabelmap, inputExtent, shrink](int i, int j, int k)
+  {
+    bool outsideImage = ( i < inputExtent[0] || i > inputExtent[1] || j < inputExtent[2] || j > inputExtent[3]
+      || k < inputExtent[4] || k > inputExtent[5] );
+    return (outsideImage ? shrink : IsInside(inputLabelmap, i, j, k));
+  };
+
+  // Check every voxel that can be in the structure, and a layer around. The margins are at most
+  // a few voxels long
+  int padding = (shrink ? 2 : 8);
+  for (int k = -padding; k < DIMENSION + padding; ++k)
+  {
+    for (int j = -padding; j < DIMENSION + padding; ++j)
+    {
+      for (int i = -padding; i < DIMENSION + padding; ++i)
+      {
+        bool expected = ( shrink
+          ? IsInside(inputLabelmap, i, j, k) && !IsWithinMargin(isInputInside, marginMm, i, j, k, false)
+          : IsWithinMargin(isInputInside, marginMm, i, j, k, true) );
+        if (IsInside(outputLabelmap, i, j, k) != expected)
+        {
+          std::cerr << (shrink ? "Shrink" : "Expand") << " by (" << marginMm[0] << ", " << marginMm[1] << ", " << marginMm[2]
+            << ") mm mismatch at (" << i << ", " << j << ", " << k << "): expected " << (expected ? "inside" : "outside") << std::endl;
+          return false;
+        }
+        if (expected && *static_cast<unsigned char*>(outputLabelmap->GetScalarPointer(i, j, k)) != LABEL_VALUE)
+        {
+          std::cerr << "Invalid label value in output at (" << i << ", " << j << ", " << k << ")" << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkLabelmapMarginFilterTest( int vtkNotUsed(argc), char* vtkNotUsed(argv)[] )
+{
+  // Structure is the union of an ellipsoid and a thin bar, so that it has concave parts
+  auto isStructureInside = [](int i, int j, int k)
+  {
+    double x = (i - 9.0) * SPACING[0];
+    double y = (j - 10.0) * SPACING[1];
+    double z = (k - 8.0) * SPACING[2];
+    return x*x/36.0 + y*y/64.0 + z*z/196.0 < 1.0
+      || (i >= 3 && i <= 18 && j >= 15 && j <= 16 && k >= 4 && k <= 15);
+  };
+  vtkSmartPointer<vtkOrientedImageData> labelmap = CreateLabelmap(EXTENT, isStructureInside);
+
+  const double margins[][3] = {
+    { 3.0, 3.0, 3.0 },
+    { 4.5, 1.0, 5.0 },
+    { 2.0, 0.0, 7.5 },
+    { 0.5, 0.5, 0.5 } };
+  for (const double* marginMm : margins)
+  {
+    if (!CheckMargin(labelmap, marginMm, false) || !CheckMargin(labelmap, marginMm, true))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Structure cut by the boundary of the image is not shrunk from the boundary
+  const int croppedExtent[6] = { 6, DIMENSION-1, 0, DIMENSION-1, 6, DIMENSION-1 };
+  vtkSmartPointer<vtkOrientedImageData> croppedLabelmap = CreateLabelmap(croppedExtent, isStructureInside);
+  for (const double* marginMm : margins)
+  {
+    if (!CheckMargin(croppedLabelmap, marginMm, true))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Shrinking by a margin larger than the structure results in empty structure
+  vtkSmartPointer<vtkLabelmapMarginFilter> marginFilter = vtkSmartPointer<vtkLabelmapMarginFilter>::New();
+  marginFilter->SetInputLabelmap(labelmap);
+  marginFilter->SetMarginMm(20.0, 20.0, 20.0);
+  marginFilter->ShrinkOn();
+  if (!marginFilter->Update() || marginFilter->GetOutputLabelmap()->GetPointData()->GetScalars()->GetRange()[1] != 0.0)
+  {
+    std::cerr << "Shrinking by large margin does not result in empty structure" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
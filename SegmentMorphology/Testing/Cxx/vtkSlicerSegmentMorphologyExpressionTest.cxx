@@ -0,0 +1,231 @@
+// SegmentMorphology includes
+#include "vtkSlicerSegmentMorphologyModuleLogic.h"
+#include "vtkMRMLSegmentMorphologyNode.h"
+
+// SlicerRT includes
+#include "vtkPlanarContourToClosedSurfaceConversionRule.h"
+
+// Segmentations includes
+#include "vtkMRMLSegmentationNode.h"
+#include "vtkSlicerSegmentationsModuleLogic.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegmentationConverterFactory.h"
+
+// Testing includes
+#include "LabelmapTestingUtilities.h"
+
+// MRML includes
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// ITK includes
+#include "itkFactoryRegistration.h"
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace LabelmapTestingUtilities;
+
+namespace
+{
+/// Number of voxels the results may differ in. The sequential operations resample segment B to the grid
+/// of segment A using linear interpolation, while the expression uses nearest neighbor interpolation
+const int VOLUME_DIFFERENCE_TOLERANCE_VOXEL = 100;
+
+//-----------------------------------------------------------------------------
+/// Load segmentation with a single segment and make sure it has binary labelmap representation
+vtkMRMLSegmentationNode* LoadSegmentation(vtkSlicerSegmentationsModuleLogic* segmentationsLogic, const std::string& fileName)
+{
+  if (!vtksys::SystemTools::FileExists(fileName.c_str()))
+  {
+    std::cerr << "Loading segmentation from file '" << fileName << "' failed - the file does not exist!" << std::endl;
+    return nullptr;
+  }
+  vtkMRMLSegmentationNode* segmentationNode = segmentationsLogic->LoadSegmentationFromFile(fileName.c_str());
+  if ( !segmentationNode || segmentationNode->GetSegmentation()->GetNumberOfSegments() != 1
+    || !segmentationNode->GetSegmentation()->CreateRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) )
+  {
+    std::cerr << "Failed to load segmentation with one segment from file '" << fileName << "'!" << std::endl;
+    return nullptr;
+  }
+  return segmentationNode;
+}
+
+//-----------------------------------------------------------------------------
+/// Get labelmap of the only or the last segment of a segmentation
+vtkSmartPointer<vtkOrientedImageData> GetLastSegmentLabelmap(vtkMRMLSegmentationNode* segmentationNode)
+{
+  std::vector<std::string> segmentIDs;
+  segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+  vtkSmartPointer<vtkOrientedImageData> labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  if (segmentIDs.empty() || !segmentationNode->GetBinaryLabelmapRepresentation(segmentIDs.back(), labelmap))
+  {
+    return nullptr;
+  }
+  return labelmap;
+}
+
+//-----------------------------------------------------------------------------
+/// Apply binary morphological operation on the only segments of two segmentations
+/// \return Output segmentation node, nullptr on failure
+vtkMRMLSegmentationNode* ApplyBinaryOperation(vtkSlicerSegmentMorphologyModuleLogic* segmentMorphologyLogic,
+  vtkMRMLSegmentationNode* segmentationANode, vtkMRMLSegmentationNode* segmentationBNode, int operation)
+{
+  vtkMRMLScene* scene = segmentMorphologyLogic->GetMRMLScene();
+  vtkSmartPointer<vtkMRMLSegmentationNode> outputSegmentationNode = vtkSmartPointer<vtkMRMLSegmentationNode>::New();
+  scene->AddNode(outputSegmentationNode);
+
+  std::vector<std::string> segmentAIDs;
+  segmentationANode->GetSegmentation()->GetSegmentIDs(segmentAIDs);
+  std::vector<std::string> segmentBIDs;
+  segmentationBNode->GetSegmentation()->GetSegmentIDs(segmentBIDs);
+
+  vtkSmartPointer<vtkMRMLSegmentMorphologyNode> paramNode = vtkSmartPointer<vtkMRMLSegmentMorphologyNode>::New();
+  scene->AddNode(paramNode);
+  paramNode->SetAndObserveSegmentationANode(segmentationANode);
+  paramNode->SetSegmentAID(segmentAIDs[0].c_str());
+  paramNode->SetAndObserveSegmentationBNode(segmentationBNode);
+  paramNode->SetSegmentBID(segmentBIDs[0].c_str());
+  paramNode->SetAndObserveOutputSegmentationNode(outputSegmentationNode);
+  paramNode->SetOperation(operation);
+  if (!segmentMorphologyLogic->ApplyMorphologyOperation(paramNode).empty())
+  {
+    return nullptr;
+  }
+  return outputSegmentationNode;
+}
+
+//-----------------------------------------------------------------------------
+/// Count voxels that are inside the structure of only one of the labelmaps on the same grid
+int CountMismatchingVoxels(vtkOrientedImageData* labelmap1, vtkOrientedImageData* labelmap2)
+{
+  int extent1[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap1->GetExtent(extent1);
+  int extent2[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap2->GetExtent(extent2);
+  int mismatches = 0;
+  for (int k = std::min(extent1[4], extent2[4]); k <= std::max(extent1[5], extent2[5]); ++k)
+  {
+    for (int j = std::min(extent1[2], extent2[2]); j <= std::max(extent1[3], extent2[3]); ++j)
+    {
+      for (int i = std::min(extent1[0], extent2[0]); i <= std::max(extent1[1], extent2[1]); ++i)
+      {
+        if (IsInside(labelmap1, i, j, k) != IsInside(labelmap2, i, j, k))
+        {
+          mismatches++;
+        }
+      }
+    }
+  }
+  return mismatches;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerSegmentMorphologyExpressionTest( int argc, char * argv[] )
+{
+  const char *dataDirectoryPath = nullptr;
+  if (argc > 2 && STRCASECMP(argv[1], "-DataDirectoryPath") == 0)
+  {
+    dataDirectoryPath = argv[2];
+    std::cout << "Data directory path: " << dataDirectoryPath << std::endl;
+  }
+  else
+  {
+    std::cerr << "No arguments!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Make sure NRRD reading works
+  itk::itkFactoryRegistration();
+
+  // Register planar contour to closed surface conversion rule
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkPlanarContourToClosedSurfaceConversionRule>::New() );
+
+  vtkSmartPointer<vtkMRMLScene> mrmlScene = vtkSmartPointer<vtkMRMLScene>::New();
+  vtkSmartPointer<vtkSlicerSegmentationsModuleLogic> segmentationsLogic = vtkSmartPointer<vtkSlicerSegmentationsModuleLogic>::New();
+  segmentationsLogic->SetMRMLScene(mrmlScene);
+  vtkSmartPointer<vtkSlicerSegmentMorphologyModuleLogic> segmentMorphologyLogic = vtkSmartPointer<vtkSlicerSegmentMorphologyModuleLogic>::New();
+  segmentMorphologyLogic->SetMRMLScene(mrmlScene);
+
+  // Load the structures, and collect them in one segmentation for the expressions
+  const char* segmentNames[3] = { "Bladder", "PTV", "Rectum" };
+  vtkMRMLSegmentationNode* segmentationNodes[3] = { nullptr, nullptr, nullptr };
+  vtkSmartPointer<vtkMRMLSegmentationNode> structuresSegmentationNode = vtkSmartPointer<vtkMRMLSegmentationNode>::New();
+  mrmlScene->AddNode(structuresSegmentationNode);
+  structuresSegmentationNode->GetSegmentation()->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() );
+  for (int index = 0; index < 3; ++index)
+  {
+    segmentationNodes[index] = LoadSegmentation(segmentationsLogic,
+      std::string(dataDirectoryPath) + "EclipseProstate_" + segmentNames[index] + ".seg.vtm");
+    vtkSmartPointer<vtkOrientedImageData> labelmap = (segmentationNodes[index] ? GetLastSegmentLabelmap(segmentationNodes[index]) : nullptr);
+    if (!labelmap)
+    {
+      return EXIT_FAILURE;
+    }
+    vtkNew<vtkSegment> segment;
+    segment->SetName(segmentNames[index]);
+    segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap);
+    structuresSegmentationNode->GetSegmentation()->AddSegment(segment, segmentNames[index]);
+  }
+  vtkMRMLSegmentationNode* bladderNode = segmentationNodes[0];
+  vtkMRMLSegmentationNode* ptvNode = segmentationNodes[1];
+  vtkMRMLSegmentationNode* rectumNode = segmentationNodes[2];
+
+  // Sequential operations: organs at risk, and the target with and without them
+  vtkMRMLSegmentationNode* organsAtRiskNode = ApplyBinaryOperation(segmentMorphologyLogic, bladderNode, rectumNode, vtkMRMLSegmentMorphologyNode::Union);
+  vtkMRMLSegmentationNode* targetWithoutOrgansNode = ( organsAtRiskNode
+    ? ApplyBinaryOperation(segmentMorphologyLogic, ptvNode, organsAtRiskNode, vtkMRMLSegmentMorphologyNode::Subtract) : nullptr );
+  vtkMRMLSegmentationNode* targetInOrgansNode = ( organsAtRiskNode
+    ? ApplyBinaryOperation(segmentMorphologyLogic, ptvNode, organsAtRiskNode, vtkMRMLSegmentMorphologyNode::Intersect) : nullptr );
+  if (!organsAtRiskNode || !targetWithoutOrgansNode || !targetInOrgansNode)
+  {
+    std::cerr << "Failed to apply sequential morphological operations!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The same operations in one expression each
+  const char* expressions[3] = { "Bladder | Rectum", "PTV - (Bladder | Rectum)", "PTV & (Bladder | Rectum)" };
+  vtkMRMLSegmentationNode* sequentialResultNodes[3] = { organsAtRiskNode, targetWithoutOrgansNode, targetInOrgansNode };
+  vtkSmartPointer<vtkMRMLSegmentationNode> expressionSegmentationNode = vtkSmartPointer<vtkMRMLSegmentationNode>::New();
+  mrmlScene->AddNode(expressionSegmentationNode);
+  for (int index = 0; index < 3; ++index)
+  {
+    if (!segmentMorphologyLogic->ApplySegmentExpression(structuresSegmentationNode, expressions[index], expressionSegmentationNode).empty())
+    {
+      std::cerr << "Failed to apply segment expression '" << expressions[index] << "'!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    vtkSmartPointer<vtkOrientedImageData> expressionLabelmap = GetLastSegmentLabelmap(expressionSegmentationNode);
+    vtkSmartPointer<vtkOrientedImageData> sequentialLabelmap = GetLastSegmentLabelmap(sequentialResultNodes[index]);
+    if (!expressionLabelmap || !sequentialLabelmap)
+    {
+      std::cerr << "Failed to get result labelmaps of '" << expressions[index] << "'!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    int mismatches = CountMismatchingVoxels(expressionLabelmap, sequentialLabelmap);
+    if (mismatches > VOLUME_DIFFERENCE_TOLERANCE_VOXEL)
+    {
+      std::cerr << "Segment expression '" << expressions[index] << "' differs from the sequential operations in "
+        << mismatches << " voxels!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -44,19 +44,83 @@
 #include <vtkImageData.h>
 #include <vtkTransform.h>
 
+// Testing includes
+#include "LabelmapTestingUtilities.h"
+
 // ITK includes
 #include "itkFactoryRegistration.h"
 
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <algorithm>
+
 #define MIN_VOLUME_DIFFERENCE_TOLERANCE_VOXEL 100
 
+namespace
+{
+//-----------------------------------------------------------------------------
+/// Apply the morphological operation of the parameter node
+/// \return Labelmap of the only output segment, nullptr on failure
+vtkSmartPointer<vtkOrientedImageData> ApplyMorphologyOperationToLabelmap(
+  vtkSlicerSegmentMorphologyModuleLogic* segmentMorphologyLogic, vtkMRMLSegmentMorphologyNode* paramNode)
+{
+  if (!segmentMorphologyLogic->ApplyMorphologyOperation(paramNode).empty())
+  {
+    return nullptr;
+  }
+  vtkMRMLSegmentationNode* outputSegmentationNode = paramNode->GetOutputSegmentationNode();
+  std::vector<std::string> outputSegmentIDs;
+  outputSegmentationNode->GetSegmentation()->GetSegmentIDs(outputSegmentIDs);
+  vtkSmartPointer<vtkOrientedImageData> outputLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  if (outputSegmentIDs.size() != 1 || !outputSegmentationNode->GetBinaryLabelmapRepresentation(outputSegmentIDs[0], outputLabelmap))
+  {
+    return nullptr;
+  }
+  return outputLabelmap;
+}
+
+//-----------------------------------------------------------------------------
+/// Count voxels that are inside the structure of only one of the labelmaps on the same grid
+int CountMismatchingVoxels(vtkOrientedImageData* labelmap1, vtkOrientedImageData* labelmap2)
+{
+  int extent1[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap1->GetExtent(extent1);
+  int extent2[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap2->GetExtent(extent2);
+  int mismatches = 0;
+  for (int k = std::min(extent1[4], extent2[4]); k <= std::max(extent1[5], extent2[5]); ++k)
+  {
+    for (int j = std::min(extent1[2], extent2[2]); j <= std::max(extent1[3], extent2[3]); ++j)
+    {
+      for (int i = std::min(extent1[0], extent2[0]); i <= std::max(extent1[1], extent2[1]); ++i)
+      {
+        if (LabelmapTestingUtilities::IsInside(labelmap1, i, j, k) != LabelmapTestingUtilities::IsInside(labelmap2, i, j, k))
+        {
+          mismatches++;
+        }
+      }
+    }
+  }
+  return mismatches;
+}
+}
+
 //-----------------------------------------------------------------------------
 int vtkSlicerSegmentMorphologyModuleLogicTest1( int argc, char * argv[] )
 {
   int argIndex = 1;
 
+  // Optional flag for also comparing the distance transform margins to the margins by box kernels
+  bool compareDistanceTransformMargin = false;
+  if (argc > argIndex+1 && STRCASECMP(argv[argIndex], "-CompareDistanceTransformMargin") == 0)
+  {
+    compareDistanceTransformMargin = (vtkVariant(argv[argIndex+1]).ToInt() == 1 ? true : false);
+    std::cout << "Compare distance transform margin: " << (compareDistanceTransformMargin ? "true" : "false") << std::endl;
+    argIndex += 2;
+  }
+
   const char *dataDirectoryPath = nullptr;
   if (argc > argIndex+1)
   {
@@ -477,6 +541,50 @@ int vtkSlicerSegmentMorphologyModuleLogicTest1( int argc, char * argv[] )
     return EXIT_FAILURE;
   }
 
+  if (!compareDistanceTransformMargin)
+  {
+    return EXIT_SUCCESS;
+  }
+
+  // The kernels of the existing margin are ellipsoids fitted in the kernel box, so they differ from the exact
+  // ellipsoid of the distance transform margin. Along a single axis by a multiple of the spacing they are the same,
+  // so the outputs are expected to match voxel by voxel, also at the boundary of the image
+  vtkSmartPointer<vtkOrientedImageData> inputLabelmapA = vtkSmartPointer<vtkOrientedImageData>::New();
+  if (!inputSegmentationANode->GetBinaryLabelmapRepresentation(inputSegmentAID, inputLabelmapA))
+  {
+    std::cerr << "Failed to get binary labelmap from input segment A!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  double spacingA[3] = { 1.0, 1.0, 1.0 };
+  inputLabelmapA->GetSpacing(spacingA);
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    double marginMm[3] = { 0.0, 0.0, 0.0 };
+    marginMm[axis] = 2.0 * spacingA[axis];
+    paramNode->SetXSize(marginMm[0]);
+    paramNode->SetYSize(marginMm[1]);
+    paramNode->SetZSize(marginMm[2]);
+
+    paramNode->UseDistanceTransformMarginOff();
+    vtkSmartPointer<vtkOrientedImageData> kernelMarginLabelmap = ApplyMorphologyOperationToLabelmap(segmentMorphologyLogic, paramNode);
+    paramNode->UseDistanceTransformMarginOn();
+    vtkSmartPointer<vtkOrientedImageData> distanceTransformMarginLabelmap = ApplyMorphologyOperationToLabelmap(segmentMorphologyLogic, paramNode);
+    paramNode->UseDistanceTransformMarginOff();
+    if (!kernelMarginLabelmap || !distanceTransformMarginLabelmap)
+    {
+      std::cerr << "Failed to apply margin along axis " << axis << "!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    int marginMismatches = CountMismatchingVoxels(kernelMarginLabelmap, distanceTransformMarginLabelmap);
+    if (marginMismatches > 0)
+    {
+      std::cerr << "Segment Morphology Test: Distance transform margin along axis " << axis << " differs from the existing margin in "
+        << marginMismatches << " voxels!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   return EXIT_SUCCESS;
 }
 
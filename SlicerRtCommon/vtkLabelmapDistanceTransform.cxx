@@ -0,0 +1,211 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkLabelmapDistanceTransform.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+const double vtkLabelmapDistanceTransform::DISTANCE_INFINITY = VTK_DOUBLE_MAX;
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// Set mask to 1 for the voxels of the box that are nonzero in the image (first component)
+template <class T>
+void FillMaskFromImageTemplate(vtkImageData* image, T*, const int boxExtent[6], std::vector<unsigned char>& mask)
+{
+  int imageExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  image->GetExtent(imageExtent);
+  int readExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    readExtent[2*axis] = std::max(imageExtent[2*axis], boxExtent[2*axis]);
+    readExtent[2*axis+1] = std::min(imageExtent[2*axis+1], boxExtent[2*axis+1]);
+    if (readExtent[2*axis] > readExtent[2*axis+1])
+    {
+      return;
+    }
+  }
+
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+  vtkIdType boxDimensions[2] = { boxExtent[1] - boxExtent[0] + 1, boxExtent[3] - boxExtent[2] + 1 };
+  for (int k = readExtent[4]; k <= readExtent[5]; ++k)
+  {
+    for (int j = readExtent[2]; j <= readExtent[3]; ++j)
+    {
+      T* imagePtr = static_cast<T*>(image->GetScalarPointer(readExtent[0], j, k));
+      unsigned char* maskPtr = &mask[ ((k - boxExtent[4]) * boxDimensions[1] + (j - boxExtent[2])) * boxDimensions[0]
+        + (readExtent[0] - boxExtent[0]) ];
+      for (int i = readExtent[0]; i <= readExtent[1]; ++i)
+      {
+        *(maskPtr++) = (*imagePtr != 0 ? 1 : 0);
+        imagePtr += numberOfComponents;
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+/// One dimensional squared Euclidean distance transform of sampled function. Computes in linear time
+///   d(q) = min_p ( (q-p)^2 * spacing^2 + f(p) )
+/// in place on a line of values with given stride.
+void DistanceTransform1D(double* values, vtkIdType stride, int numberOfSamples, double spacing,
+  std::vector<double>& f, std::vector<int>& v, std::vector<double>& z)
+{
+  const double infinity = vtkLabelmapDistanceTransform::DISTANCE_INFINITY;
+  f.resize(numberOfSamples);
+  v.resize(numberOfSamples);
+  z.resize(numberOfSamples + 1);
+  for (int q = 0; q < numberOfSamples; ++q)
+  {
+    f[q] = values[q * stride];
+  }
+
+  // Compute lower envelope of the parabolas rooted at the samples with finite value
+  int k = -1;
+  for (int q = 0; q < numberOfSamples; ++q)
+  {
+    if (f[q] >= infinity)
+    {
+      continue;
+    }
+    double positionQ = q * spacing;
+    if (k < 0)
+    {
+      k = 0;
+      v[0] = q;
+      z[0] = -infinity;
+      z[1] = infinity;
+      continue;
+    }
+    // Intersection of the parabola at q with the rightmost one in the envelope.
+    // As z[0] is -infinity, the loop stops at the latest when the envelope has one parabola left
+    double positionV = v[k] * spacing;
+    double s = ( (f[q] + positionQ * positionQ) - (f[v[k]] + positionV * positionV) ) / (2.0 * (positionQ - positionV));
+    while (s <= z[k])
+    {
+      --k;
+      positionV = v[k] * spacing;
+      s = ( (f[q] + positionQ * positionQ) - (f[v[k]] + positionV * positionV) ) / (2.0 * (positionQ - positionV));
+    }
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k+1] = infinity;
+  }
+  if (k < 0)
+  {
+    // No finite value on this line
+    return;
+  }
+
+  // Sample the lower envelope
+  k = 0;
+  for (int q = 0; q < numberOfSamples; ++q)
+  {
+    double positionQ = q * spacing;
+    while (z[k+1] < positionQ)
+    {
+      ++k;
+    }
+    double difference = positionQ - v[k] * spacing;
+    values[q * stride] = difference * difference + f[v[k]];
+  }
+}
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapDistanceTransform::FillMaskFromImage(vtkImageData* image, const int boxExtent[6], std::vector<unsigned char>& mask)
+{
+  if (!image)
+  {
+    return false;
+  }
+  switch (image->GetScalarType())
+  {
+    vtkTemplateMacro(FillMaskFromImageTemplate<VTK_TT>(image, static_cast<VTK_TT*>(nullptr), boxExtent, mask));
+    default:
+      return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapDistanceTransform::ComputeSquaredDistanceTransform(std::vector<double>& squaredDistances,
+  const int dimensions[3], const double spacing[3])
+{
+  vtkIdType increments[3] = { 1, dimensions[0], static_cast<vtkIdType>(dimensions[0]) * dimensions[1] };
+  double* distancesPtr = squaredDistances.data();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (spacing[axis] <= 0.0 || dimensions[axis] < 2)
+    {
+      continue;
+    }
+    // Lines along the axis are identified by their position along the other two axes
+    int otherAxis1 = (axis == 0 ? 1 : 0);
+    int otherAxis2 = (axis == 2 ? 1 : 2);
+    vtkIdType numberOfLines = static_cast<vtkIdType>(dimensions[otherAxis1]) * dimensions[otherAxis2];
+    vtkSMPTools::For(0, numberOfLines, [&](vtkIdType beginLine, vtkIdType endLine)
+    {
+      std::vector<double> f;
+      std::vector<int> v;
+      std::vector<double> z;
+      for (vtkIdType line = beginLine; line < endLine; ++line)
+      {
+        vtkIdType lineStart = (line % dimensions[otherAxis1]) * increments[otherAxis1]
+          + (line / dimensions[otherAxis1]) * increments[otherAxis2];
+        DistanceTransform1D(distancesPtr + lineStart, increments[axis], dimensions[axis], spacing[axis], f, v, z);
+      }
+    });
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapDistanceTransform::ComputeSquaredDistanceTransform(const std::vector<unsigned char>& mask, unsigned char featureValue,
+  const int dimensions[3], const double spacing[3], std::vector<double>& squaredDistances)
+{
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(mask.size());
+  squaredDistances.resize(numberOfVoxels);
+  double* distancesPtr = squaredDistances.data();
+  vtkSMPTools::For(0, numberOfVoxels, [&](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType voxelIndex = begin; voxelIndex < end; ++voxelIndex)
+    {
+      distancesPtr[voxelIndex] = (mask[voxelIndex] == featureValue ? 0.0 : DISTANCE_INFINITY);
+    }
+  });
+  vtkLabelmapDistanceTransform::ComputeSquaredDistanceTransform(squaredDistances, dimensions, spacing);
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapDistanceTransform::ComputeSquaredDistanceTransform(const std::vector<vtkIdType>& featureVoxels,
+  const int dimensions[3], const double spacing[3], std::vector<double>& squaredDistances)
+{
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  squaredDistances.assign(numberOfVoxels, DISTANCE_INFINITY);
+  for (vtkIdType voxelIndex : featureVoxels)
+  {
+    squaredDistances[voxelIndex] = 0.0;
+  }
+  vtkLabelmapDistanceTransform::ComputeSquaredDistanceTransform(squaredDistances, dimensions, spacing);
+}
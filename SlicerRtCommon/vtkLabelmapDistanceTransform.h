@@ -0,0 +1,67 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkLabelmapDistanceTransform_h
+#define __vtkLabelmapDistanceTransform_h
+
+#include "vtkSlicerRtCommonWin32Header.h"
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <vector>
+
+class vtkImageData;
+
+/// \ingroup SlicerRt_SlicerRtCommon
+/// \brief Binary masks and exact Euclidean distance transforms of labelmaps, shared by the labelmap
+///   filters of the SegmentMorphology and SegmentComparison modules.
+///
+/// The distance transform is the separable linear time algorithm of Felzenszwalb and Huttenlocher
+/// (Distance Transforms of Sampled Functions, 2012), applied along each axis with anisotropic spacing.
+/// The lines along each axis are processed in parallel.
+/// Note: The vtk prefix ensures python wrapping of the class that broke in VTK8.
+class VTK_SLICERRTCOMMON_EXPORT vtkLabelmapDistanceTransform
+{
+public:
+  /// Squared distance of the voxels that are not features, and of the voxels that have no feature
+  /// voxel on any of their lines after the transform
+  static const double DISTANCE_INFINITY;
+
+public:
+  /// Set mask to 1 for the voxels of the box that are nonzero in the image (first component).
+  /// The mask is indexed on the box extent with i fastest and must have the size of the box.
+  /// Voxels of the box outside of the image are not changed
+  /// \return False if the image is invalid or its scalar type is not supported
+  static bool FillMaskFromImage(vtkImageData* image, const int boxExtent[6], std::vector<unsigned char>& mask);
+
+  /// Compute exact squared Euclidean distance transform in place. On input, the feature voxels have zero
+  /// value and the others \sa DISTANCE_INFINITY. On output, each value is the squared distance to the
+  /// nearest feature voxel. Axes with non-positive spacing are skipped, i.e. only features on the same
+  /// line along that axis count.
+  static void ComputeSquaredDistanceTransform(std::vector<double>& squaredDistances, const int dimensions[3], const double spacing[3]);
+
+  /// Compute exact squared Euclidean distance transform of the voxels where the mask equals the feature value
+  static void ComputeSquaredDistanceTransform(const std::vector<unsigned char>& mask, unsigned char featureValue,
+    const int dimensions[3], const double spacing[3], std::vector<double>& squaredDistances);
+
+  /// Compute exact squared Euclidean distance transform of a set of voxels given by their indices
+  static void ComputeSquaredDistanceTransform(const std::vector<vtkIdType>& featureVoxels,
+    const int dimensions[3], const double spacing[3], std::vector<double>& squaredDistances);
+};
+
+#endif
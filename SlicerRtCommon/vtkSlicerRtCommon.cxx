@@ -257,6 +257,34 @@ bool vtkSlicerRtCommon::DoVolumeLatticesMatch(vtkMRMLScalarVolumeNode* volume1,
   return true;
 }
 
+//---------------------------------------------------------------------------
+bool vtkSlicerRtCommon::DoImageGridsMatch(vtkOrientedImageData* image1, vtkOrientedImageData* image2)
+{
+  if (!image1 || !image2)
+  {
+    vtkGenericWarningMacro("vtkSlicerRtCommon::DoImageGridsMatch: Invalid (nullptr) argument");
+    return false;
+  }
+
+  // Compare image to world matrices (involves checking the spacing and origin too)
+  vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix1 = vtkSmartPointer<vtkMatrix4x4>::New();
+  vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix2 = vtkSmartPointer<vtkMatrix4x4>::New();
+  image1->GetImageToWorldMatrix(imageToWorldMatrix1);
+  image2->GetImageToWorldMatrix(imageToWorldMatrix2);
+  for (int row=0; row<3; ++row)
+  {
+    for (int col=0; col<4; ++col)
+    {
+      if ( fabs(imageToWorldMatrix1->GetElement(row, col) - imageToWorldMatrix2->GetElement(row, col)) > EPSILON )
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 //---------------------------------------------------------------------------
 bool vtkSlicerRtCommon::AreEqualWithTolerance(double a, double b)
 {
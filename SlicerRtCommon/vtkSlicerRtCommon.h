@@ -139,6 +139,11 @@ public:
   /// Check if the lattice (grid, geometry) of two volumes are the same
   static bool DoVolumeLatticesMatch(vtkMRMLScalarVolumeNode* volume1, vtkMRMLScalarVolumeNode* volume2);
 
+  /// Check if two oriented images have the same voxel grid (spacing, origin and directions).
+  /// Unlike \sa vtkOrientedImageDataResample::DoGeometriesMatch the extents are not compared, so the images
+  /// can be accessed voxel by voxel in the overlap of their extents without resampling
+  static bool DoImageGridsMatch(vtkOrientedImageData* image1, vtkOrientedImageData* image2);
+
   /// Determine if two numbers are equal within a small tolerance (0.0001)
   static bool AreEqualWithTolerance(double a, double b);
 
@@ -0,0 +1,139 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __LabelmapTestingUtilities_h
+#define __LabelmapTestingUtilities_h
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+
+/// Helper functions shared by the tests of the labelmap filters, that compare the results of the filters
+/// with values computed the simple way voxel by voxel. The labelmaps of the tests are all on the same
+/// anisotropic grid, and may have different extents on it.
+namespace LabelmapTestingUtilities
+{
+/// Spacing of the test grid
+const double SPACING[3] = { 0.8, 1.1, 2.5 };
+/// Origin of the test grid
+const double ORIGIN[3] = { -40.0, -20.0, 10.0 };
+/// Default tolerance of the compared values
+const double TOLERANCE = 1e-6;
+
+//-----------------------------------------------------------------------------
+/// Create labelmap on the test grid with the given extent. Voxels for which the function returns true are set to the label value
+inline vtkSmartPointer<vtkOrientedImageData> CreateLabelmap(const int extent[6], std::function<bool(int, int, int)> isInside,
+  int scalarType=VTK_UNSIGNED_CHAR, double labelValue=1.0)
+{
+  vtkSmartPointer<vtkOrientedImageData> labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  labelmap->SetExtent(const_cast<int*>(extent));
+  labelmap->SetSpacing(SPACING[0], SPACING[1], SPACING[2]);
+  labelmap->SetOrigin(ORIGIN[0], ORIGIN[1], ORIGIN[2]);
+  labelmap->AllocateScalars(scalarType, 1);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+  {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+    {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+      {
+        if (isInside(i, j, k))
+        {
+          labelmap->SetScalarComponentFromDouble(i, j, k, 0, labelValue);
+        }
+      }
+    }
+  }
+  return labelmap;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if a voxel is inside the structure of the labelmap. Voxels outside the extent are outside the structure
+inline bool IsInside(vtkOrientedImageData* labelmap, int i, int j, int k)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  if (i < extent[0] || i > extent[1] || j < extent[2] || j > extent[3] || k < extent[4] || k > extent[5])
+  {
+    return false;
+  }
+  return labelmap->GetScalarComponentAsDouble(i, j, k, 0) != 0.0;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if there is a voxel with the given state within the margin ellipsoid around a voxel.
+/// Axes with zero margin are not searched
+inline bool IsWithinMargin(std::function<bool(int, int, int)> isInside, const double marginMm[3], int i, int j, int k, bool inside)
+{
+  int radius[3] = { 0, 0, 0 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    radius[axis] = static_cast<int>(marginMm[axis] / SPACING[axis]) + 1;
+  }
+  for (int kk = k - radius[2]; kk <= k + radius[2]; ++kk)
+  {
+    for (int jj = j - radius[1]; jj <= j + radius[1]; ++jj)
+    {
+      for (int ii = i - radius[0]; ii <= i + radius[0]; ++ii)
+      {
+        int offset[3] = { ii - i, jj - j, kk - k };
+        double normalizedSquaredDistance = 0.0;
+        bool withinMargin = true;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          if (marginMm[axis] <= 0.0)
+          {
+            withinMargin &= (offset[axis] == 0);
+            continue;
+          }
+          double normalizedOffset = offset[axis] * SPACING[axis] / marginMm[axis];
+          normalizedSquaredDistance += normalizedOffset * normalizedOffset;
+        }
+        if (withinMargin && normalizedSquaredDistance <= 1.0 + 1e-6 && isInside(ii, jj, kk) == inside)
+        {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+/// Check a computed value against the expected value
+/// \return False and error message if the difference is above the tolerance
+inline bool CheckValue(const std::string& name, double value, double expectedValue, double tolerance=TOLERANCE)
+{
+  if (fabs(value - expectedValue) > tolerance)
+  {
+    std::cerr << name << " mismatch: " << value << " (expected: " << expectedValue << ")" << std::endl;
+    return false;
+  }
+  return true;
+}
+}
+
+#endif
@@ -23,10 +23,11 @@
 #include "vtkSlicerVffFileReaderLogic.h"
 
 // VTK includes
+#include <vtkByteSwap.h>
 #include <vtkImageData.h>
 #include <vtkMatrix4x4.h>
-#include <vtkImageShiftScale.h>
 #include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
 
 // MRML includes
 #include <vtkMRMLScalarVolumeNode.h>
@@ -44,12 +45,68 @@
 #include <algorithm>
 #include <cctype>
 #include <functional>
+#include <type_traits>
+
+//----------------------------------------------------------------------------
+namespace
+{
+  /// Read big endian voxel values of the given type from the stream into a float array,
+  /// optionally applying the intensity shift and scale as (value + shift) * scale.
+  /// The values are read in bulk, one slab at a time. Float values are read directly into
+  /// the output, other types through a buffer of the size of one slab.
+  /// \return Success flag, false if the end of the file is reached before reading all values
+  template <class T>
+  bool ReadVoxelValues(std::istream& stream, float* output, vtkIdType numberOfValues, vtkIdType numberOfValuesPerSlab,
+    bool applyShiftScale, double shift, double scale)
+  {
+    std::vector<T> slabBuffer;
+    if (!std::is_same<T, float>::value)
+    {
+      slabBuffer.resize(numberOfValuesPerSlab);
+    }
+
+    for (vtkIdType slabStart = 0; slabStart < numberOfValues; slabStart += numberOfValuesPerSlab)
+    {
+      vtkIdType numberOfSlabValues = std::min(numberOfValuesPerSlab, numberOfValues - slabStart);
+      T* slabValues = (slabBuffer.empty() ? reinterpret_cast<T*>(output + slabStart) : slabBuffer.data());
+      std::streamsize numberOfBytes = static_cast<std::streamsize>(numberOfSlabValues * sizeof(T));
+      stream.read(reinterpret_cast<char*>(slabValues), numberOfBytes);
+      if (stream.gcount() != numberOfBytes)
+      {
+        return false;
+      }
+
+      // Swap bytes (no-op on big endian platforms), convert and rescale in parallel
+      float* slabOutput = output + slabStart;
+      vtkSMPTools::For(0, numberOfSlabValues, [&](vtkIdType begin, vtkIdType end)
+      {
+        if (sizeof(T) == 2)
+        {
+          vtkByteSwap::Swap2BERange(slabValues + begin, end - begin);
+        }
+        else if (sizeof(T) == 4)
+        {
+          vtkByteSwap::Swap4BERange(slabValues + begin, end - begin);
+        }
+        for (vtkIdType index = begin; index < end; ++index)
+        {
+          double value = static_cast<double>(slabValues[index]);
+          slabOutput[index] = static_cast<float>(applyShiftScale ? (value + shift) * scale : value);
+        }
+      });
+    }
+    return true;
+  }
+}
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerVffFileReaderLogic);
 
 //----------------------------------------------------------------------------
-vtkSlicerVffFileReaderLogic::vtkSlicerVffFileReaderLogic() = default;
+vtkSlicerVffFileReaderLogic::vtkSlicerVffFileReaderLogic()
+{
+  this->SlabSizeMB = 0;
+}
 
 //----------------------------------------------------------------------------
 vtkSlicerVffFileReaderLogic::~vtkSlicerVffFileReaderLogic() = default;
@@ -189,6 +246,8 @@ std::vector<Num> vtkSlicerVffFileReaderLogic::ParseNumberOfNumbersFromString(std
 void vtkSlicerVffFileReaderLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "SlabSizeMB: " << this->SlabSizeMB << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -210,7 +269,7 @@ vtkMRMLScalarVolumeNode* vtkSlicerVffFileReaderLogic::LoadVffFile(char* filename
   int size[3] = {0, 0, 0};
   double spacing[3] = {0, 0 ,0};
   double origin[3] = {0, 0, 0};
-  int rawsize = 0;
+  long long rawsize = 0;
   double data_scale = 0;
   double data_offset = 0;
   std::string handleScatter;
@@ -363,7 +422,7 @@ vtkMRMLScalarVolumeNode* vtkSlicerVffFileReaderLogic::LoadVffFile(char* filename
     }
   }          
 
-  std::vector<int> numberFromParsedStringRawsize = this->ParseNumberOfNumbersFromString<int>(parameterList["rawsize"], 1);
+  std::vector<long long> numberFromParsedStringRawsize = this->ParseNumberOfNumbersFromString<long long>(parameterList["rawsize"], 1);
   if (numberFromParsedStringRawsize.empty()) 
   {
     vtkErrorMacro("LoadVffFile: An integer was not entered for the rawsize.");
@@ -504,15 +563,65 @@ vtkMRMLScalarVolumeNode* vtkSlicerVffFileReaderLogic::LoadVffFile(char* filename
   }
 
   // Calculates the number of bytes to read based on some of the specified parameters
-  long bytesToRead = 1;
-  bytesToRead = bands*bits/8;
-  int sizeOfImageData = (int)size[0]*size[1]*size[2]*(bits/8);
-
+  long long sizeOfImageData = (long long)size[0]*size[1]*size[2]*(bits/8);
   if (rawsize != sizeOfImageData)
   {
     vtkWarningMacro("LoadVffFile: The specified size from the parameters does not match the specified raw size.");
   }
 
+  vtkSmartPointer<vtkImageData> floatVffVolumeData = vtkSmartPointer<vtkImageData>::New();
+  floatVffVolumeData->SetExtent(0, size[0]-1, 0, size[1]-1, 0, size[2]-1);
+  floatVffVolumeData->SetSpacing(1, 1, 1);
+  floatVffVolumeData->SetOrigin(0, 0, 0);
+  floatVffVolumeData->AllocateScalars(VTK_FLOAT, bands);
+
+  // Reads the line feed that comes directly before the image data from the file
+  readFileStream.get();
+
+  // The voxel values are stored in the file in the same order as in the image data, big endian.
+  // They are read in bulk, slab by slab if requested, and converted in place in the output
+  vtkIdType numberOfValues = floatVffVolumeData->GetNumberOfPoints() * bands;
+  vtkIdType numberOfValuesPerSlice = (vtkIdType)size[0] * size[1] * bands;
+  vtkIdType numberOfValuesPerSlab = numberOfValues;
+  if (this->SlabSizeMB > 0)
+  {
+    vtkIdType numberOfSlicesPerSlab = std::max<vtkIdType>(1,
+      (vtkIdType)this->SlabSizeMB * 1024 * 1024 / (numberOfValuesPerSlice * (bits/8)) );
+    numberOfValuesPerSlab = std::min(numberOfValues, numberOfSlicesPerSlab * numberOfValuesPerSlice);
+  }
+  float* floatPtr = static_cast<float*>(floatVffVolumeData->GetScalarPointer());
+  double shift = (useImageIntensityScaleAndOffsetFromFile ? data_offset : 0.0);
+  double scale = (useImageIntensityScaleAndOffsetFromFile ? data_scale : 1.0);
+  bool readSuccess = false;
+  switch (bits)
+  {
+  case 8:
+    readSuccess = ReadVoxelValues<unsigned char>(readFileStream, floatPtr, numberOfValues, numberOfValuesPerSlab,
+      useImageIntensityScaleAndOffsetFromFile, shift, scale);
+    break;
+  case 16:
+    readSuccess = ReadVoxelValues<short>(readFileStream, floatPtr, numberOfValues, numberOfValuesPerSlab,
+      useImageIntensityScaleAndOffsetFromFile, shift, scale);
+    break;
+  case 32:
+    readSuccess = ReadVoxelValues<float>(readFileStream, floatPtr, numberOfValues, numberOfValuesPerSlab,
+      useImageIntensityScaleAndOffsetFromFile, shift, scale);
+    break;
+  default:
+    vtkErrorMacro("LoadVffFile: Unsupported number of bits " << bits << ". Supported values are 8, 16 and 32.");
+    return nullptr;
+  }
+  if (!readSuccess)
+  {
+    vtkErrorMacro("LoadVffFile: The end of the file was reached earlier than specified.");
+    return nullptr;
+  }
+
+  if (readFileStream.get() && !readFileStream.eof())
+  {
+    vtkWarningMacro("LoadVffFile: The end of the file was not reached.");
+  }
+
   vtkSmartPointer<vtkMRMLScalarVolumeNode> vffVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
   vffVolumeNode->SetScene(this->GetMRMLScene());
   vffVolumeNode->SetName(name.c_str());
@@ -535,74 +644,6 @@ vtkMRMLScalarVolumeNode* vtkSlicerVffFileReaderLogic::LoadVffFile(char* filename
     vffVolumeNode->SetAttribute("Date", date.c_str());
   }
 
-  vtkSmartPointer<vtkImageData> floatVffVolumeData = vtkSmartPointer<vtkImageData>::New();
-  floatVffVolumeData->SetExtent(0, size[0]-1, 0, size[1]-1, 0, size[2]-1);
-  floatVffVolumeData->SetSpacing(1, 1, 1);
-  floatVffVolumeData->SetOrigin(0, 0, 0);
-  floatVffVolumeData->AllocateScalars(VTK_FLOAT, bands);
-
-  // Reads the line feed that comes directly before the image data from the file
-  readFileStream.get();
-
-  float* floatPtr = (float*)floatVffVolumeData->GetScalarPointer();
-  std::stringstream ss;
-
-  // The size of the image data read is specified in the header by the parameter size
-  for (long x = 0; x < size[0]; x++)
-  {
-    for (long y = 0; y < size[1]; y++)
-    {
-      for (long z = 0; z < size[2]; z++)
-      {
-        if (!readFileStream.eof())
-        {
-          // Reads in the specified number of bytes at a time from the file
-          char *buffer = new char[bytesToRead];
-          char *newBuffer = new char[bytesToRead];
-          readFileStream.read(buffer, bytesToRead);
-
-          // Checks that the correct number of bytes were read from the file
-          if (readFileStream.gcount() == bytesToRead) 
-          { 
-            float *valueFromFile = (float *) newBuffer;
-
-            // Reverses the byte order
-            for (int byte=0; byte<bytesToRead; ++byte)
-            {
-              newBuffer[byte] = buffer[bytesToRead-byte-1];
-            }
-            (*floatPtr) = (*valueFromFile);
-            ++floatPtr;
-          }
-          else
-          {
-            vtkErrorMacro("LoadVffFile: The end of the file was reached earlier than specified.");
-          }
-        }
-        else
-        {
-          vtkErrorMacro("LoadVffFile: The end of the file was reached earlier than specified.");
-        }
-      }
-    }
-  }
-      
-  if (readFileStream.get() && !readFileStream.eof())
-  {
-    vtkWarningMacro("LoadVffFile: The end of the file was not reached.");
-  }
-      
-      
-  if (useImageIntensityScaleAndOffsetFromFile == true)
-  {
-    vtkSmartPointer<vtkImageShiftScale> imageIntensityShiftScale = vtkSmartPointer<vtkImageShiftScale>::New();
-    imageIntensityShiftScale->SetScale(data_scale);
-    imageIntensityShiftScale->SetShift(data_offset);
-    imageIntensityShiftScale->SetInputData(floatVffVolumeData);
-    imageIntensityShiftScale->Update();
-    floatVffVolumeData = imageIntensityShiftScale->GetOutput();
-  }
-
   vffVolumeNode->SetAndObserveImageData(floatVffVolumeData);
 
   vtkSmartPointer<vtkMRMLScalarVolumeDisplayNode> vffVolumeDisplayNode = vtkSmartPointer<vtkMRMLScalarVolumeDisplayNode>::New();
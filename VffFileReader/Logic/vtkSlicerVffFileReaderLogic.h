@@ -50,6 +50,12 @@ public:
   /// \param useImageIntensityScaleAndOffsetFromFile Boolean flag which is set to false by default, but is set to true to use the intensity scale and offset provided in the file to load the image
   vtkMRMLScalarVolumeNode* LoadVffFile(char* filename, bool useImageIntensityScaleAndOffsetFromFile = false); //, bool useDataOffset);
 
+  /// Get/Set size of the slabs of slices in which the voxel data is read from the file, in megabytes.
+  /// Reading in slabs keeps the size of the temporary buffers small for large volumes.
+  /// 0 (default) reads the whole voxel data at once.
+  vtkGetMacro(SlabSizeMB, int);
+  vtkSetMacro(SlabSizeMB, int);
+
 protected:
   /// A helper function which removes all spaces from the beginning and end of a string, and returns the modified string.
   /// \param stringToTrim String which is to be modified
@@ -68,6 +74,10 @@ protected:
   vtkSlicerVffFileReaderLogic();
   ~vtkSlicerVffFileReaderLogic() override;
 
+protected:
+  /// Size of the slabs in which the voxel data is read, in megabytes. Whole volume if 0
+  int SlabSizeMB;
+
 private:
   vtkSlicerVffFileReaderLogic(const vtkSlicerVffFileReaderLogic&) = delete;
   void operator=(const vtkSlicerVffFileReaderLogic&) = delete;
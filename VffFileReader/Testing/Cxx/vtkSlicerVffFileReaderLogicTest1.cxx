@@ -0,0 +1,225 @@
+// VffFileReader includes
+#include "vtkSlicerVffFileReaderLogic.h"
+
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+const int SIZE[3] = { 160, 128, 40 };
+const double DATA_SCALE = 0.5;
+const double DATA_OFFSET = -1000.0;
+
+//-----------------------------------------------------------------------------
+/// Voxel value stored in the file, within the range of the type of the given number of bits
+double GetVoxelValue(vtkIdType voxelIndex, int bits)
+{
+  switch (bits)
+  {
+    case 8:
+      return static_cast<double>((voxelIndex * 7) % 256);
+    case 16:
+      return static_cast<double>((voxelIndex * 37) % 65536 - 32768);
+    default:
+      return (voxelIndex % 1000) * 0.25 - 100.0;
+  }
+}
+
+//-----------------------------------------------------------------------------
+/// Expected voxel value in the loaded volume, computed the same way as by the reader
+float GetExpectedValue(vtkIdType voxelIndex, int bits, bool applyShiftScale)
+{
+  double value = GetVoxelValue(voxelIndex, bits);
+  return static_cast<float>(applyShiftScale ? (value + DATA_OFFSET) * DATA_SCALE : value);
+}
+
+//-----------------------------------------------------------------------------
+/// Append value to the buffer in big endian byte order
+template <class T>
+void AppendBigEndian(std::vector<char>& buffer, T value)
+{
+  char bytes[sizeof(T)];
+  memcpy(bytes, &value, sizeof(T));
+  const unsigned short endiannessTest = 1;
+  bool littleEndian = (*reinterpret_cast<const unsigned char*>(&endiannessTest) == 1);
+  for (size_t byteIndex = 0; byteIndex < sizeof(T); ++byteIndex)
+  {
+    buffer.push_back(bytes[littleEndian ? sizeof(T) - 1 - byteIndex : byteIndex]);
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool WriteSyntheticVffFile(const std::string& filename, int bits)
+{
+  std::ofstream file(filename.c_str(), std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  vtkIdType voxelCount = (vtkIdType)SIZE[0] * SIZE[1] * SIZE[2];
+  std::stringstream header;
+  header << "ncaa;\n"
+    << "rank=3;\n"
+    << "type=raster;\n"
+    << "format=slice;\n"
+    << "bits=" << bits << ";\n"
+    << "bands=1;\n"
+    << "size=" << SIZE[0] << " " << SIZE[1] << " " << SIZE[2] << ";\n"
+    << "spacing=0.5 0.5 1.0;\n"
+    << "origin=10 20 30;\n"
+    << "rawsize=" << voxelCount * (bits / 8) << ";\n"
+    << "data_scale=" << DATA_SCALE << ";\n"
+    << "data_offset=" << DATA_OFFSET << ";\n"
+    << "handleScatter=factor;\n"
+    << "referenceScatterFactor=1;\n"
+    << "dataScatterFactor=1;\n"
+    << "filter=Ramp;\n"
+    << "title=SyntheticVolume.vff;\n"
+    << "date=2020-01-01;\n"
+    << "\f\n";
+  std::string headerString = header.str();
+  file.write(headerString.c_str(), headerString.size());
+
+  std::vector<char> voxelData;
+  voxelData.reserve(voxelCount * (bits / 8));
+  for (vtkIdType voxelIndex = 0; voxelIndex < voxelCount; ++voxelIndex)
+  {
+    double value = GetVoxelValue(voxelIndex, bits);
+    switch (bits)
+    {
+      case 8:
+        voxelData.push_back(static_cast<char>(static_cast<unsigned char>(value)));
+        break;
+      case 16:
+        AppendBigEndian(voxelData, static_cast<short>(value));
+        break;
+      default:
+        AppendBigEndian(voxelData, static_cast<float>(value));
+        break;
+    }
+  }
+  file.write(voxelData.data(), voxelData.size());
+  return file.good();
+}
+
+//-----------------------------------------------------------------------------
+bool ReadAndCheckVff(const std::string& filename, int bits, int slabSizeMB, bool applyShiftScale)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerVffFileReaderLogic> vffFileReaderLogic;
+  vffFileReaderLogic->SetMRMLScene(scene);
+  vffFileReaderLogic->SetSlabSizeMB(slabSizeMB);
+  std::vector<char> filenameBuffer(filename.begin(), filename.end());
+  filenameBuffer.push_back('\0');
+  vtkMRMLScalarVolumeNode* volumeNode = vffFileReaderLogic->LoadVffFile(filenameBuffer.data(), applyShiftScale);
+  if (!volumeNode || !volumeNode->GetImageData())
+  {
+    std::cerr << "Failed to read " << bits << " bit VFF file with slab size " << slabSizeMB << " MB" << std::endl;
+    return false;
+  }
+
+  vtkImageData* imageData = volumeNode->GetImageData();
+  int* dimensions = imageData->GetDimensions();
+  if ( dimensions[0] != SIZE[0] || dimensions[1] != SIZE[1] || dimensions[2] != SIZE[2]
+    || imageData->GetNumberOfScalarComponents() != 1 || imageData->GetScalarType() != VTK_FLOAT )
+  {
+    std::cerr << "Invalid volume dimensions or scalar type" << std::endl;
+    return false;
+  }
+
+  vtkIdType voxelCount = (vtkIdType)SIZE[0] * SIZE[1] * SIZE[2];
+  float* values = static_cast<float*>(imageData->GetScalarPointer());
+  for (vtkIdType voxelIndex = 0; voxelIndex < voxelCount; ++voxelIndex)
+  {
+    if (values[voxelIndex] != GetExpectedValue(voxelIndex, bits, applyShiftScale))
+    {
+      std::cerr << bits << " bit VFF value mismatch at voxel " << voxelIndex << " with slab size " << slabSizeMB << " MB"
+        << (applyShiftScale ? " and rescaling" : "") << ": " << values[voxelIndex]
+        << " != " << GetExpectedValue(voxelIndex, bits, applyShiftScale) << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerVffFileReaderLogicTest1( int argc, char * argv[] )
+{
+  int argIndex = 1;
+
+  // TemporaryDirectory
+  std::string temporaryDirectory;
+  if (argc > argIndex + 1 && STRCASECMP(argv[argIndex], "-TemporaryDirectory") == 0)
+  {
+    temporaryDirectory = argv[argIndex + 1];
+    std::cout << "Temporary directory: " << temporaryDirectory << std::endl;
+    argIndex += 2;
+  }
+  else
+  {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtksys::SystemTools::MakeDirectory(temporaryDirectory);
+
+  // All supported bit depths, whole volume at once and in slabs of 1 MB (smaller than the 16 and 32 bit volumes),
+  // with and without the intensity shift and scale of the file
+  const int bitDepths[3] = { 8, 16, 32 };
+  std::string filename;
+  for (int bits : bitDepths)
+  {
+    filename = temporaryDirectory + "/SyntheticVolume" + std::to_string(bits) + ".vff";
+    if (!WriteSyntheticVffFile(filename, bits))
+    {
+      std::cerr << "Failed to write synthetic VFF file " << filename << std::endl;
+      return EXIT_FAILURE;
+    }
+    if ( !ReadAndCheckVff(filename, bits, 0, false)
+      || !ReadAndCheckVff(filename, bits, 1, false)
+      || !ReadAndCheckVff(filename, bits, 0, true)
+      || !ReadAndCheckVff(filename, bits, 1, true) )
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Truncated file
+  std::string truncatedFilename = temporaryDirectory + "/SyntheticVolumeTruncated.vff";
+  {
+    std::ifstream inputFile(filename.c_str(), std::ios::binary);
+    std::vector<char> contents((std::istreambuf_iterator<char>(inputFile)), std::istreambuf_iterator<char>());
+    std::ofstream truncatedFile(truncatedFilename.c_str(), std::ios::binary);
+    truncatedFile.write(contents.data(), contents.size() - 1);
+  }
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerVffFileReaderLogic> vffFileReaderLogic;
+  vffFileReaderLogic->SetMRMLScene(scene);
+  std::vector<char> truncatedFilenameBuffer(truncatedFilename.begin(), truncatedFilename.end());
+  truncatedFilenameBuffer.push_back('\0');
+  if (vffFileReaderLogic->LoadVffFile(truncatedFilenameBuffer.data()))
+  {
+    std::cerr << "Truncated VFF file is read successfully" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}